@@ -17,6 +17,8 @@
 #include <vector>
 
 // This enum lists all versions of the uploading and decompression pipelines implemented in this subsystem.
+// When the contents of the input stream are available in memory (e.g. a MappedFile), the "read into a CPU buffer"
+// steps are skipped and the data is used in place, except for DirectStorage requests.
 enum class BufferLoadingPipeline
 {
     None,
@@ -54,6 +56,8 @@ enum class BufferLoadingPipeline
     // - CPU+GPU: Use writeBuffer to upload compressed data (no headers) into compressedBuffer
     // - GPU: Decompress into decompressedBuffer
     // - GPU: Copy into the final texture
+    // The GPU decompression of all tasks in one Execute... call is recorded together, after all uploads,
+    // with one set of barriers around it.
     DecompressWithVk,
 
     // For both buffers and textures:
@@ -65,17 +69,72 @@ enum class BufferLoadingPipeline
 
 struct GDeflateFeatures;
 
+// Collects the DirectStorage requests from multiple calls to ExecuteBufferLoadingTasks and ExecuteTextureLoadingTasks,
+// normally one group of calls per material, and submits them to the queue together in Finish.
+// This keeps the DirectStorage queue filled when many materials are loaded, instead of waiting for it after
+// every call. The buffers and textures written by the requests must not be used on the GPU until Finish returns.
+class DStorageLoadingBatch
+{
+public:
+    DStorageLoadingBatch(nvrhi::IDevice* device, GDeflateFeatures* gdeflateFeatures);
+
+    // Starts a new group of requests and returns its index for IsGroupSuccessful.
+    // Group indices are unique for the lifetime of the batch, across calls to Finish.
+    size_t BeginGroup();
+
+    // Returns true if there are no requests or textures waiting for Finish.
+    bool IsEmpty() const { return m_requests.empty() && m_textures.empty(); }
+
+    // Adds requests to decompress GDeflate data into a buffer range or a texture subresource.
+    // The batch takes ownership of the compressed data, which has to stay alive until the requests complete.
+    void AddBufferRequest(std::vector<uint8_t>&& compressedData, nvrhi::IBuffer* buffer, nvrhi::BufferRange range);
+    void AddTextureRequest(std::vector<uint8_t>&& compressedData, nvrhi::ITexture* texture, int mipLevel,
+        int layerIndex, size_t uncompressedSize);
+
+    // Adds a latent texture that is transitioned to the ShaderResource state permanently in Finish,
+    // see ExecuteTextureLoadingTasks.
+    void AddTextureForTransition(nvrhi::ITexture* texture);
+
+    // Submits all requests with one status entry per group, waits for them to complete, and transitions
+    // the textures. Returns false if any group failed. The batch is empty after that.
+    bool Finish(nvrhi::ICommandList* commandList);
+
+    // Returns true if the group has been completed by Finish, and all of its requests were successful.
+    bool IsGroupSuccessful(size_t group) const;
+
+private:
+    struct Request
+    {
+        size_t group = 0;
+        std::vector<uint8_t> compressedData;
+        nvrhi::BufferHandle buffer;
+        nvrhi::BufferRange bufferRange;
+        nvrhi::TextureHandle texture;
+        int mipLevel = 0;
+        int layerIndex = 0;
+        size_t uncompressedSize = 0;
+    };
+
+    nvrhi::DeviceHandle m_device;
+    GDeflateFeatures* m_gdeflateFeatures = nullptr;
+    std::vector<Request> m_requests;
+    std::vector<nvrhi::TextureHandle> m_textures;
+    size_t m_groupCount = 0;
+    std::vector<bool> m_groupResults; // Indexed by group, for the groups completed by Finish
+};
+
 struct BufferLoadingTask
 {
     BufferLoadingPipeline pipeline = BufferLoadingPipeline::None;
     void const* directCopySource = nullptr;
     size_t directCopySize = 0;
     ntc::BufferFootprint footprint;
+    uint8_t const* mappedData = nullptr; // Start of footprint.rangeInStream in the input memory, if provided
+    size_t gdeflateHeaderSize = 0;
     nvrhi::BufferRange stagingBufferRange;
     nvrhi::BufferRange tempBufferRange;
     nvrhi::BufferRange finalBufferRange;
     std::vector<uint8_t> compressedData;
-    std::vector<uint8_t> uncompressedData;
     bool readIntoCpuBuffer = false;
     bool readIntoStagingBuffer = false;
 };
@@ -84,8 +143,9 @@ struct TextureSubresourceLoadingTask
 {
     BufferLoadingPipeline pipeline = BufferLoadingPipeline::None;
     ntc::LatentTextureFootprint footprint;
+    uint8_t const* mappedData = nullptr; // Start of footprint.buffer.rangeInStream in the input memory, if provided
     nvrhi::TextureHandle destinationTexture;
-    int mipLevel = 0;
+    int mipLevel = 0; // In the destination texture
     int layerIndex = 0;
     size_t gdeflateHeaderSize = 0;
     nvrhi::BufferRange compressedBufferRange;
@@ -96,7 +156,9 @@ struct TextureSubresourceLoadingTask
     bool readUncompressedIntoCpuBuffer = false;
 };
 
-void FillBufferLoadingTasksForBC(
+// inputData is the in-memory contents of the stream of size inputDataSize, or nullptr.
+// Returns false if the footprints of the texture are outside of inputData.
+bool FillBufferLoadingTasksForBC(
     ntc::TextureSetDesc const& textureSetDesc,
     ntc::ITextureMetadata* textureMetadata,
     std::vector<BufferLoadingTask>& tasks,
@@ -104,7 +166,9 @@ void FillBufferLoadingTasksForBC(
     nvrhi::GraphicsAPI graphicsAPI,
     size_t& stagingBufferSize,
     size_t& tempBufferSize,
-    size_t& finalBufferSize);
+    size_t& finalBufferSize,
+    uint8_t const* inputData = nullptr,
+    size_t inputDataSize = 0);
 
 bool ExecuteBufferLoadingTasks(
     nvrhi::IDevice* device,
@@ -116,9 +180,12 @@ bool ExecuteBufferLoadingTasks(
     nvrhi::BufferHandle& finalBuffer,
     size_t stagingBufferSize,
     size_t tempBufferSize,
-    size_t finalBufferSize);
+    size_t finalBufferSize,
+    DStorageLoadingBatch* dstorageBatch = nullptr);
 
-void FillTextureLoadingTasksForLatents(
+// inputData is the in-memory contents of the stream of size inputDataSize, or nullptr.
+// Returns false if the footprints of the latents are outside of inputData.
+bool FillTextureLoadingTasksForLatents(
     ntc::ITextureSetMetadata* textureSetMetadata,
     nvrhi::ITexture* destinationTexture,
     int firstLatentMipLevel,
@@ -126,7 +193,9 @@ void FillTextureLoadingTasksForLatents(
     bool gpuDecompressionSupported,
     nvrhi::GraphicsAPI graphicsAPI,
     size_t& compressedBufferSize,
-    size_t& decompressedBufferSize);
+    size_t& decompressedBufferSize,
+    uint8_t const* inputData = nullptr,
+    size_t inputDataSize = 0);
 
 bool ExecuteTextureLoadingTasks(
     nvrhi::IDevice* device,
@@ -136,7 +205,8 @@ bool ExecuteTextureLoadingTasks(
     GDeflateFeatures* gdeflateFeatures,
     std::vector<TextureSubresourceLoadingTask>& tasks,
     size_t compressedBufferSize,
-    size_t decompressedBufferSize);
+    size_t decompressedBufferSize,
+    DStorageLoadingBatch* dstorageBatch = nullptr);
 
 template<typename T>
 class MappedBuffer
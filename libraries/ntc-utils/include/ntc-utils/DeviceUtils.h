@@ -43,4 +43,31 @@ void SetNtcGraphicsDeviceParameters(
 
 bool IsDX12DeveloperModeEnabled();
 
+#if NTC_WITH_DX12
+struct IDXGIAdapter3;
+#endif
+
+// Queries the OS video memory budget and the current usage by this process in the local (device) memory segment.
+// The DXGI adapter is found once in Init, so that the queries can run on every frame.
+// Only implemented on DX12, the queries return false if the information is not available.
+class LocalVideoMemoryInfo
+{
+public:
+    LocalVideoMemoryInfo() = default;
+    ~LocalVideoMemoryInfo();
+
+    LocalVideoMemoryInfo(LocalVideoMemoryInfo const&) = delete;
+    LocalVideoMemoryInfo& operator=(LocalVideoMemoryInfo const&) = delete;
+
+    // Finds the DXGI adapter used by the device. Returns false if it's not a DX12 device or the adapter is not found.
+    bool Init(nvrhi::IDevice* device);
+
+    bool Query(uint64_t& outBudget, uint64_t& outCurrentUsage) const;
+
+private:
+#if NTC_WITH_DX12
+    IDXGIAdapter3* m_adapter = nullptr;
+#endif
+};
+
 std::unique_ptr<GDeflateFeatures> InitGDeflate(nvrhi::IDevice* device, bool debugMode);
\ No newline at end of file
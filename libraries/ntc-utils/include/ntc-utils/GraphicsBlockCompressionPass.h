@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -15,6 +15,7 @@
 #include <nvrhi/nvrhi.h>
 #include <libntc/ntc.h>
 #include <unordered_map>
+#include <vector>
 #include <donut/engine/BindingCache.h>
 
 class GraphicsBlockCompressionPass
@@ -35,13 +36,56 @@ public:
         nvrhi::IBuffer* modeBuffer,
         nvrhi::ITexture* outputTexture, int outputMipLevel);
 
+    // Batched version of ExecuteComputePass, for compressing many textures or mip levels at once.
+    // AddBatchedComputePass copies the pass constants, so the next pass can be obtained from LibNTC right away.
+    // ExecuteBatchedComputePasses uploads the constants for all added passes with one write, records the dispatches
+    // grouped by shader, and doesn't place UAV barriers between them. That means the passes in one batch must write
+    // different output textures or mip levels, and must not read the outputs of each other.
+    // Note: ExecuteBatchedComputePasses expects that the commandList is open, and leaves it open.
+    void AddBatchedComputePass(ntc::ComputePassDesc const& computePass,
+        nvrhi::ITexture* inputTexture, nvrhi::Format inputFormat, int inputMipLevel,
+        nvrhi::IBuffer* modeBuffer,
+        nvrhi::ITexture* outputTexture, int outputMipLevel);
+
+    bool ExecuteBatchedComputePasses(nvrhi::ICommandList* commandList);
+
+    size_t GetNumBatchedComputePasses() const { return m_batchedPasses.size(); }
+
+    void DiscardBatchedComputePasses() { m_batchedPasses.clear(); m_batchedConstants.clear(); }
+
     void ClearBindingSetCache() { m_bindingCache.Clear(); }
 
 private:
+    struct BatchedPass
+    {
+        const void* computeShader;
+        size_t computeShaderSize;
+        uint32_t constantBufferOffset;
+        uint32_t constantBufferSize;
+        uint32_t dispatchWidth;
+        uint32_t dispatchHeight;
+        nvrhi::ITexture* inputTexture;
+        nvrhi::Format inputFormat;
+        int inputMipLevel;
+        nvrhi::IBuffer* modeBuffer;
+        nvrhi::ITexture* outputTexture;
+        int outputMipLevel;
+    };
+
+    nvrhi::ComputePipelineHandle GetOrCreatePipeline(
+        std::unordered_map<const void*, nvrhi::ComputePipelineHandle>& pipelines,
+        const void* computeShader, size_t computeShaderSize, nvrhi::IBindingLayout* bindingLayout);
+
     nvrhi::DeviceHandle m_device;
     std::unordered_map<const void*, nvrhi::ComputePipelineHandle> m_pipelines; // shader bytecode -> pipeline
+    std::unordered_map<const void*, nvrhi::ComputePipelineHandle> m_batchedPipelines; // same, with batched layouts
     nvrhi::BindingLayoutHandle m_bindingLayout;
     nvrhi::BindingLayoutHandle m_bindingLayoutWithModeBuffer;
+    nvrhi::BindingLayoutHandle m_batchedBindingLayout;
+    nvrhi::BindingLayoutHandle m_batchedBindingLayoutWithModeBuffer;
+    std::vector<BatchedPass> m_batchedPasses;
+    std::vector<uint8_t> m_batchedConstants;
+    nvrhi::BufferHandle m_batchedConstantBuffer;
     donut::engine::BindingCache m_bindingCache;
     nvrhi::BufferHandle m_constantBuffer;
     int m_maxConstantBufferVersions;
@@ -41,7 +41,8 @@ public:
     bool SetWeightsFromTextureSet(nvrhi::ICommandList* commandList, ntc::ITextureSetMetadata* textureSetMetadata,
         ntc::InferenceWeightType weightType);
 
-    void SetWeightBuffer(nvrhi::IBuffer* buffer);
+    // Uses an external weight buffer, or a range of it when the weights of multiple texture sets share one buffer.
+    void SetWeightBuffer(nvrhi::IBuffer* buffer, nvrhi::BufferRange range = nvrhi::EntireBuffer);
 
     bool ExecuteComputePass(nvrhi::ICommandList* commandList, ntc::ComputePassDesc& computePass);
 
@@ -58,6 +59,7 @@ private:
     nvrhi::TextureHandle m_latentTexture;
     nvrhi::BufferHandle m_weightUploadBuffer;
     nvrhi::BufferHandle m_weightBuffer;
+    nvrhi::BufferRange m_weightBufferRange = nvrhi::EntireBuffer;
     nvrhi::BufferHandle m_constantBuffer;
     nvrhi::SamplerHandle m_latentSampler;
     bool m_latentTextureIsExternal = false;
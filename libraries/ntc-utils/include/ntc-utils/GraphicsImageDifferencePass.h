@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -14,15 +14,23 @@
 
 #include <nvrhi/nvrhi.h>
 #include <libntc/ntc.h>
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
 
+// Runs the image difference compute passes provided by LibNTC and reads back their results, which are
+// per-channel MSE values for every query. The metrics are limited to MSE and PSNR: the kernels come from
+// ntc::IContext::MakeImageDifferenceComputePass, and other metrics such as SSIM, FLIP or per-tile error maps
+// would need new shaders in LibNTC, which this class only dispatches.
 class GraphicsImageDifferencePass
 {
 public:
-    GraphicsImageDifferencePass(nvrhi::IDevice* device, uint32_t maxQueries = 1)
+    // numReadbackSlots is the number of query batches that can be in flight at the same time, see EndBatch.
+    GraphicsImageDifferencePass(nvrhi::IDevice* device, uint32_t maxQueries = 1, uint32_t numReadbackSlots = 1)
         : m_device(device)
         , m_maxQueries(maxQueries)
         , m_mseValues(maxQueries * ChannelsPerQuery)
+        , m_readbackSlots(std::max(numReadbackSlots, 1u))
     { }
 
     bool Init();
@@ -38,22 +46,49 @@ public:
         nvrhi::ITexture* texture1, int mipLevel1, nvrhi::ITexture* texture2, int mipLevel2, uint32_t queryIndex);
 
     // Reads the query results from the GPU and stores them internally. This involves a WFI and a buffer mapping.
+    // Use it when the next GPU work depends on the results, like the compression parameter searches in ntc-cli:
+    // there is nothing else to submit while waiting, so a non-blocking readback would not save any time.
     bool ReadResults();
 
+    // Non-blocking alternative to ReadResults, for callers that compare many independent image pairs and can
+    // record and submit the next batch while the previous one is still running, such as imagediff. Call EndBatch after executing the command list with all queries
+    // of a batch, it returns a batch index and makes the next passes write into another readback slot.
+    // Then call PollResults with the batch index until outReady is true, after which GetQueryResult returns
+    // the results of that batch. If all readback slots are in flight, EndBatch waits for the oldest one.
+    uint32_t EndBatch();
+
+    // Returns false if the batch results are no longer available (more than numReadbackSlots batches
+    // have ended since) or the readback failed.
+    bool PollResults(uint32_t batchIndex, bool& outReady);
+
     // Returns the image comparison results for a given query.
     // Call ReadResults() once before this function.
     bool GetQueryResult(uint32_t queryIndex, float outPerChannelMSE[4], float* outOverallMSE, float* outOverallPSNR,
         int channels = 4, float maxSignalValue = 1.0f);
 
 private:
+    static constexpr uint32_t InvalidBatchIndex = ~0u;
+
+    struct ReadbackSlot
+    {
+        nvrhi::BufferHandle stagingBuffer;
+        nvrhi::EventQueryHandle eventQuery;
+        uint32_t batchIndex = InvalidBatchIndex;
+        bool inFlight = false;
+    };
+
+    bool ReadSlot(ReadbackSlot& slot);
+
     nvrhi::DeviceHandle m_device;
     std::unordered_map<const void*, nvrhi::ComputePipelineHandle> m_pipelines; // shader bytecode -> pipeline
     nvrhi::BindingLayoutHandle m_bindingLayout;
     nvrhi::BufferHandle m_outputBuffer;
-    nvrhi::BufferHandle m_stagingBuffer;
     nvrhi::BufferHandle m_constantBuffer;
     uint32_t m_maxQueries = 0;
     std::vector<float> m_mseValues;
+    std::vector<ReadbackSlot> m_readbackSlots;
+    uint32_t m_currentSlot = 0;
+    uint32_t m_nextBatchIndex = 0;
     bool m_resultsRead = false;
 
     static constexpr uint32_t ChannelsPerQuery = 4;
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <optional>
+#include <string>
+
+// Image properties that can be read from the file header without decoding the pixels.
+// The channel count and format match what the tools get when decoding the same file into RGBA:
+// EXR images are always reported as 4-channel FLOAT32, and BC6 images in DDS files as 3-channel FLOAT32.
+struct ImageFileInfo
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    ntc::ChannelFormat format = ntc::ChannelFormat::UNORM8;
+
+    // The fields below are only set for DDS files, which store BCn blocks that cannot be decoded with stb_image.
+    ntc::BlockCompressedFormat bcFormat = ntc::BlockCompressedFormat::None;
+    int mips = 1;
+    size_t dataOffset = 0; // Offset of the MIP 0 blocks from the start of the file, the other MIPs follow
+    // Color space from the DXGI format (*_UNORM_SRGB or *_UNORM), only known for DDS files with a DX10 header.
+    // The legacy FourCC formats don't say, so their color space is guessed like for other images.
+    std::optional<bool> isSRGB;
+
+    // Returns the size of the pixel data after the image is decoded into RGBA with its channel format.
+    size_t GetDecodedSize() const;
+};
+
+// Reads the header of a PNG, JPG, TGA, EXR or DDS image. Returns false if the file cannot be opened or parsed.
+// Only DDS files with a single 2D texture in the BC1-BC7 formats are accepted, see ImageFileInfo::bcFormat.
+bool ProbeImageFile(std::string const& fileName, ImageFileInfo& outInfo);
+
+// Returns the size of the blocks for one MIP level of a BCn texture.
+size_t GetBlockCompressedMipSize(ntc::BlockCompressedFormat format, int width, int height);
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <optional>
 #include <libntc/ntc.h>
+#include <ntc-utils/ImageProbe.h>
 
 enum class SemanticLabel
 {
@@ -89,9 +91,29 @@ char const* SemanticLabelToString(SemanticLabel label);
 
 int GetSemanticChannelCount(SemanticLabel label);
 
-void GenerateManifestFromDirectory(const char* path, bool loadMips, bool keepFileNames, Manifest& outManifest);
+// When 'includeDDS' is true, BCn DDS files are also added, except those that have the same name as another image
+// in the folder: these are usually BCn versions of the other images, written by ntc-cli or other tools.
+void GenerateManifestFromDirectory(const char* path, bool loadMips, bool keepFileNames, bool includeDDS,
+    Manifest& outManifest);
 
 void GenerateManifestFromFileList(std::vector<const char*> const& files, bool keepFileNames, Manifest& outManifest);
+
+// Manifest for one folder found by GenerateManifestsFromDirectoryTree
+struct DirectoryManifest
+{
+    std::string relativePath; // Path of the folder relative to the root, "." for the root itself
+    Manifest manifest;
+};
+
+// Reads the dimensions, channel count and format of an image file without decoding the pixels, see ProbeImageFile
+using ImageHeaderReader = std::function<bool(std::string const& fileName, ImageFileInfo& outInfo)>;
+
+// Recursively finds all folders under 'rootPath' that contain images and generates a manifest for each of them,
+// like GenerateManifestFromDirectory does for one folder. The folders are scanned on 'numThreads' threads.
+// When 'readHeader' is provided, it's used to fill the manifest dimensions and to guess the semantics and sRGB flags
+// of the images. The manifests are sorted by path.
+bool GenerateManifestsFromDirectoryTree(const char* rootPath, bool loadMips, bool keepFileNames, bool includeDDS,
+    int numThreads, ImageHeaderReader const& readHeader, std::vector<DirectoryManifest>& outManifests, std::string& outError);
     
 bool ReadManifestFromFile(const char* fileName, Manifest& outManifest,
     std::string& outError);
@@ -100,6 +122,22 @@ bool ReadManifestFromStdin(Manifest& outManifest, std::string& outError);
 
 bool WriteManifestToFile(const char* fileName, const Manifest& manifest, std::string& outError);
 
+// One job of an ntc-cli batch file: command line arguments that are added to the arguments of the batch run
+struct BatchJob
+{
+    std::vector<std::string> args;
+};
+
+bool ReadBatchFile(const char* fileName, std::vector<BatchJob>& outJobs, std::string& outError);
+
+bool WriteBatchFile(const char* fileName, std::vector<BatchJob> const& jobs, std::string& outError);
+
+// Parses one job in the same format as the elements of the 'jobs' array of a batch file, used by ntc-cli --server
+bool ParseBatchJob(std::string const& json, BatchJob& outJob, std::string& outError);
+
 bool IsSupportedImageFileExtension(std::string const& extension);
 
+// DDS files are only supported as inputs by ntc-cli, which decodes their BCn blocks on the GPU
+bool IsDDSFileExtension(std::string const& extension);
+
 void UpdateToolInputType(ToolInputType& current, ToolInputType newInput);
@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file.
+// Open an ntc::IStream over the mapped pages with IContext::OpenReadOnlyMemory, and pass GetData() to the
+// buffer and texture loading functions (see BufferLoading.h) so that they use the file contents in place.
+// The mapping must outlive the stream and any loading tasks that refer to it.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    // Maps the file, closing the previously mapped one. Returns false if the file cannot be opened or mapped,
+    // or if it is empty: the caller should fall back to regular file reads in that case.
+    bool Open(char const* fileName);
+
+    void Close();
+
+    bool IsOpen() const { return m_data != nullptr; }
+    uint8_t const* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    uint8_t const* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+    void* m_mappingHandle = nullptr;
+#endif
+};
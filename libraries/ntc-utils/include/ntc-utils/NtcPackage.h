@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ntc
+{
+    class IContext;
+}
+
+// Package files (.ntcpak) contain multiple NTC texture sets and a table of contents at the start,
+// so that a reader can locate any texture set without opening other files, and load it with one contiguous read.
+// Each texture set is stored unmodified, so the offsets in its metadata are relative to the start of its entry.
+// File layout:
+//   NtcPackageHeader
+//   NtcPackageEntry[entryCount]
+//   Entry names, UTF-8 without terminators, see NtcPackageEntry::nameOffset
+//   Texture set data, every entry starts at a multiple of c_ntcPackageAlignment
+
+static const char c_ntcPackageMagic[8] = { 'N', 'T', 'C', 'P', 'A', 'K', '\0', '\0' };
+static const uint32_t c_ntcPackageVersion = 1;
+
+// Alignment of the entry data in the file, suitable for unbuffered reads and DirectStorage requests
+static const uint64_t c_ntcPackageAlignment = 4096;
+
+struct NtcPackageHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+};
+
+// Byte range in the data of one entry
+struct NtcPackageRange
+{
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct NtcPackageEntry
+{
+    uint64_t dataOffset; // From the start of the package file
+    uint64_t dataSize;
+    uint64_t nameOffset; // From NtcPackageHeader::namesOffset
+    uint64_t nameSize;
+    NtcPackageRange latentsRange; // Covers all latent mips and layers
+    NtcPackageRange bc7ModeRange; // Covers the BC7 mode buffers of all textures, empty if there are none
+};
+
+static_assert(sizeof(NtcPackageHeader) == 32);
+static_assert(sizeof(NtcPackageEntry) == 64);
+
+struct NtcPackageInput
+{
+    std::string name;     // Name of the entry, normally the path relative to the package
+    std::string fileName; // NTC file to add
+};
+
+// Writes a package with the texture sets from the input files. The context is used to parse the texture set
+// metadata for the ranges in the table of contents.
+bool WriteNtcPackage(ntc::IContext* context, const char* fileName, std::vector<NtcPackageInput> const& inputs,
+    std::string& outError);
+
+// The NtcPackage class reads the table of contents of a package file and the entries from it.
+// ReadEntry may be called from multiple threads at the same time.
+class NtcPackage
+{
+public:
+    bool Open(const char* fileName, std::string& outError);
+
+    // Returns the entry with the specified name, or nullptr if there is none
+    NtcPackageEntry const* FindEntry(std::string const& name) const;
+
+    // Reads the data of the entry into outData, with one read operation
+    bool ReadEntry(NtcPackageEntry const& entry, std::vector<uint8_t>& outData, std::string& outError) const;
+
+    std::string const& GetFileName() const { return m_fileName; }
+    std::vector<NtcPackageEntry> const& GetEntries() const { return m_entries; }
+
+private:
+    std::string m_fileName;
+    std::vector<NtcPackageEntry> m_entries;
+    std::unordered_map<std::string, size_t> m_entryIndices;
+};
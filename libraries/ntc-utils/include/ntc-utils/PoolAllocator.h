@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Allocation statistics for one named phase, accumulated over all scopes with that name
+struct AllocatorPhaseStats
+{
+    std::string name;
+    uint64_t allocationCount = 0;
+    uint64_t deallocationCount = 0;
+    uint64_t bytesAllocated = 0;  // Total size of all allocations made in the phase
+    int64_t peakBytesInUse = 0;   // Highest number of bytes in use by the library during the phase
+    uint64_t bytesReleased = 0;   // Size of the empty chunks released to the system at the end of the phase
+};
+
+// Implementation of ntc::IAllocator that serves small allocations from size-class pools, and large ones
+// from the system heap. The pools are carved out of large chunks, so that the many small, short-lived
+// allocations made by the library don't fragment the system heap in long-running processes.
+// Allocations are attributed to the current phase, see PoolAllocatorPhase. Phases can be nested, and the innermost
+// one receives the allocations. When a phase ends, the chunks that have no live allocations left are released in bulk.
+// All methods are thread-safe.
+class PoolAllocator : public ntc::IAllocator
+{
+public:
+    PoolAllocator() = default;
+    ~PoolAllocator();
+
+    PoolAllocator(PoolAllocator const&) = delete;
+    PoolAllocator& operator=(PoolAllocator const&) = delete;
+
+    void* Allocate(size_t size) override;
+    void Deallocate(void* ptr, size_t size) override;
+
+    // BeginPhase starts a nested phase, EndPhase ends the innermost one.
+    // Prefer PoolAllocatorPhase over calling these directly.
+    void BeginPhase(char const* name);
+    void EndPhase();
+
+    // Releases the chunks that have no live allocations. Returns the number of bytes released.
+    size_t Trim();
+
+    // Number of bytes currently allocated by the library, for leak checks
+    int64_t GetBytesAllocated() const;
+
+    // Number of bytes held in chunks and large allocations, including the free space in the chunks
+    size_t GetBytesReserved() const;
+
+    // Returns the statistics of all phases in the order in which they were first started.
+    // Allocations made outside of any phase are reported under "Other".
+    std::vector<AllocatorPhaseStats> GetPhaseStats() const;
+
+    // Prints the phase statistics as a table to stdout
+    void PrintPhaseStats() const;
+
+private:
+    struct Chunk
+    {
+        uint8_t* data = nullptr;
+        uint32_t sizeClass = 0;
+        uint32_t blockSize = 0;
+        uint32_t blockCount = 0;
+        uint32_t liveBlocks = 0;
+        uint32_t bumpIndex = 0;     // Blocks at and after this index have never been allocated
+        void* freeList = nullptr;   // Intrusive list of deallocated blocks
+        bool inPartialList = false; // True if the chunk is in m_partialChunks of its size class
+    };
+
+    mutable std::mutex m_mutex;
+    std::map<uintptr_t, Chunk*> m_chunks; // Chunk start address -> chunk
+    std::vector<std::vector<Chunk*>> m_partialChunks; // Per size class, chunks with free blocks
+    int64_t m_bytesInUse = 0;
+    size_t m_bytesReserved = 0;
+
+    std::vector<AllocatorPhaseStats> m_phases;
+    std::vector<size_t> m_phaseStack; // Indices into m_phases of the active phases, innermost last
+
+    AllocatorPhaseStats& CurrentPhase();
+    void UpdatePeaks();
+    Chunk* CreateChunk(uint32_t sizeClass);
+    void ReleaseChunk(Chunk* chunk);
+    size_t TrimLocked();
+};
+
+// Attributes the allocations made during the lifetime of this object to a named phase of the allocator.
+// The allocator may be null, then the scope does nothing.
+class PoolAllocatorPhase
+{
+public:
+    PoolAllocatorPhase(PoolAllocator* allocator, char const* name)
+        : m_allocator(allocator)
+    {
+        if (m_allocator)
+            m_allocator->BeginPhase(name);
+    }
+
+    ~PoolAllocatorPhase()
+    {
+        if (m_allocator)
+            m_allocator->EndPhase();
+    }
+
+    PoolAllocatorPhase(PoolAllocatorPhase const&) = delete;
+    PoolAllocatorPhase& operator=(PoolAllocatorPhase const&) = delete;
+
+private:
+    PoolAllocator* m_allocator;
+};
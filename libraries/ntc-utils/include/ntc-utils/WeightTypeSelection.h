@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <nvrhi/nvrhi.h>
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class GraphicsDecompressionPass;
+
+// Identifies the graphics API, adapter and driver that the weight type timings were measured with.
+struct AdapterIdentity
+{
+    std::string graphicsApi;
+    std::string adapterName;
+    std::string driverVersion;
+
+    bool operator==(AdapterIdentity const& other) const
+    {
+        return graphicsApi == other.graphicsApi && adapterName == other.adapterName
+            && driverVersion == other.driverVersion;
+    }
+};
+
+// Queries the adapter name and driver version of a DX12 or Vulkan device.
+bool GetAdapterIdentity(nvrhi::IDevice* device, AdapterIdentity& outIdentity);
+
+// Median GPU times in seconds of the decompression benchmark, indexed by InferenceWeightType.
+// Zero means that the weight type has not been measured.
+typedef std::array<float, size_t(ntc::InferenceWeightType::Count)> WeightTypeTimings;
+
+// Stores the weight type timings per adapter and driver in a JSON file, so that the benchmark only runs
+// on the first launch with a new GPU or driver.
+class WeightTypeCache
+{
+public:
+    // Reads the cache file. A missing file is not an error and leaves the cache empty.
+    bool Load(std::filesystem::path const& fileName, std::string& outError);
+
+    bool Save(std::filesystem::path const& fileName, std::string& outError) const;
+
+    // Returns false if there are no timings for this adapter and driver.
+    bool Find(AdapterIdentity const& identity, WeightTypeTimings& outTimings) const;
+
+    // Replaces the timings for this adapter and driver.
+    void Store(AdapterIdentity const& identity, WeightTypeTimings const& timings);
+
+private:
+    struct Entry
+    {
+        AdapterIdentity identity;
+        WeightTypeTimings timings{};
+    };
+
+    std::vector<Entry> m_entries;
+};
+
+// Returns the path of the cache file shared by the SDK tools, in the directory with the executable.
+std::filesystem::path GetDefaultWeightTypeCachePath();
+
+// Returns true if all candidate weight types that the texture set supports have timings.
+bool HasTimingsForWeightTypes(WeightTypeTimings const& timings, ntc::ITextureSetMetadata* textureSetMetadata,
+    std::vector<ntc::InferenceWeightType> const& candidates);
+
+// Returns the fastest measured candidate weight type that the texture set supports, or Unknown if none.
+ntc::InferenceWeightType SelectFastestWeightType(WeightTypeTimings const& timings,
+    ntc::ITextureSetMetadata* textureSetMetadata, std::vector<ntc::InferenceWeightType> const& candidates);
+
+// Decompresses one mip level of the texture set into a scratch texture with each candidate weight type that
+// the texture set supports, and stores the median GPU times over numIterations runs into outTimings.
+// The latent texture of the pass must be set, its weights and descriptor 0 are overwritten.
+// The decompression passes have the same network and weight layout as inference on sample, which makes them
+// a good proxy for the cost of each weight type in shading as well.
+bool BenchmarkWeightTypes(nvrhi::IDevice* device, ntc::IContext* context, GraphicsDecompressionPass& pass,
+    ntc::ITextureSetMetadata* textureSetMetadata, int mipLevel, int firstLatentMipInTexture,
+    std::vector<ntc::InferenceWeightType> const& candidates, int numIterations, WeightTypeTimings& outTimings);
+
+char const* GetWeightTypeCacheName(ntc::InferenceWeightType weightType);
@@ -13,6 +13,12 @@
 #include <ntc-utils/BufferLoading.h>
 #include <ntc-utils/DeviceUtils.h>
 #include <donut/core/log.h>
+#include <donut/engine/ThreadPool.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #if NTC_WITH_VULKAN
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
 #include <vulkan/vulkan.hpp>
@@ -32,7 +38,75 @@ static void AppendBufferRange(nvrhi::BufferRange& inoutRange, size_t& totalSize,
     totalSize += RoundUp4(appendSize);
 }
 
-void FillBufferLoadingTasksForBC(
+// Validates that a footprint from the file metadata lies within the input data before pointing into it,
+// a truncated or corrupted file would otherwise make the loading tasks read past the end of the mapping.
+static bool IsRangeInInputData(size_t offset, size_t size, size_t inputDataSize)
+{
+    return offset <= inputDataSize && size <= inputDataSize - offset;
+}
+
+struct CpuDecompressionJob
+{
+    ntc::CompressionType compressionType = ntc::CompressionType::None;
+    uint8_t const* compressedData = nullptr;
+    size_t compressedSize = 0;
+    void* uncompressedData = nullptr;
+    size_t uncompressedSize = 0;
+    uint32_t uncompressedCrc32 = 0;
+    ntc::Status status = ntc::Status::Ok;
+};
+
+// Shared by all loading calls, so that concurrent loads don't oversubscribe the CPU with their own threads
+static engine::ThreadPool& GetDecompressionThreadPool()
+{
+    static engine::ThreadPool threadPool;
+    return threadPool;
+}
+
+// Runs the CPU decompression jobs on the worker threads. Every mip level or latent layer is stored as a separate
+// compressed stream, so the jobs are independent and write into non-overlapping destinations.
+static void RunCpuDecompressionJobs(ntc::IContext* context, std::vector<CpuDecompressionJob>& jobs)
+{
+    // The pool tasks may start after the calling thread has finished all jobs and returned,
+    // so they only reference the shared state and touch the jobs that they have claimed.
+    struct SharedState
+    {
+        std::atomic<size_t> nextJob = 0;
+        size_t jobsDone = 0;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+    auto state = std::make_shared<SharedState>();
+    size_t const jobCount = jobs.size();
+    CpuDecompressionJob* const jobData = jobs.data();
+
+    auto worker = [context, state, jobCount, jobData]()
+    {
+        for (size_t index = state->nextJob++; index < jobCount; index = state->nextJob++)
+        {
+            CpuDecompressionJob& job = jobData[index];
+            job.status = context->DecompressBuffer(job.compressionType, job.compressedData, job.compressedSize,
+                job.uncompressedData, job.uncompressedSize, job.uncompressedCrc32);
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (++state->jobsDone == jobCount)
+                state->condition.notify_all();
+        }
+    };
+
+    size_t const threadCount = std::min(jobCount, size_t(std::max(std::thread::hardware_concurrency(), 1u)));
+    for (size_t thread = 1; thread < threadCount; ++thread)
+        GetDecompressionThreadPool().AddTask(worker);
+    
+    // The calling thread works on the jobs too
+    worker();
+
+    // Wait for the jobs claimed by the pool, not for the whole pool
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state, jobCount]() { return state->jobsDone == jobCount; });
+}
+
+bool FillBufferLoadingTasksForBC(
     ntc::TextureSetDesc const& textureSetDesc,
     ntc::ITextureMetadata* textureMetadata,
     std::vector<BufferLoadingTask>& tasks,
@@ -40,7 +114,9 @@ void FillBufferLoadingTasksForBC(
     nvrhi::GraphicsAPI graphicsAPI,
     size_t& stagingBufferSize,
     size_t& tempBufferSize,
-    size_t& finalBufferSize)
+    size_t& finalBufferSize,
+    uint8_t const* inputData,
+    size_t inputDataSize)
 {
     tasks.clear();
     tasks.resize(textureSetDesc.mips);
@@ -68,6 +144,18 @@ void FillBufferLoadingTasksForBC(
         task.footprint = textureMetadata->GetBC7ModeBufferFootprint(mipLevel);
         if (task.footprint.uncompressedSize == 0)
             continue;
+
+        if (inputData)
+        {
+            if (!IsRangeInInputData(task.footprint.rangeInStream.offset, task.footprint.rangeInStream.size,
+                inputDataSize))
+            {
+                log::warning("BC7 data for mip %d is outside of the file (%zu bytes at offset %zu, file size %zu)",
+                    mipLevel, task.footprint.rangeInStream.size, task.footprint.rangeInStream.offset, inputDataSize);
+                return false;
+            }
+            task.mappedData = inputData + task.footprint.rangeInStream.offset;
+        }
         
         if (task.footprint.compressionType == ntc::CompressionType::None)
         {
@@ -81,10 +169,14 @@ void FillBufferLoadingTasksForBC(
             {
                 task.pipeline = BufferLoadingPipeline::DecompressWithVk;
                 
-                // GDeflate header is read into a CPU buffer
+                // GDeflate header is read into a CPU buffer, unless it's available in memory already
                 size_t const headerSize = ntc::GetGDeflateHeaderSize(task.footprint.uncompressedSize);
-                task.compressedData.resize(headerSize);
-                task.readIntoCpuBuffer = true;
+                task.gdeflateHeaderSize = headerSize;
+                if (!task.mappedData)
+                {
+                    task.compressedData.resize(headerSize);
+                    task.readIntoCpuBuffer = true;
+                }
 
                 // Actual compressed data is read directly into the staging buffer
                 assert(task.footprint.rangeInStream.size > headerSize);
@@ -102,10 +194,12 @@ void FillBufferLoadingTasksForBC(
             else
             {
                 task.pipeline = BufferLoadingPipeline::DecompressOnCPU;
-                task.compressedData.resize(task.footprint.rangeInStream.size);
-                task.uncompressedData.resize(task.footprint.uncompressedSize);
                 AppendBufferRange(task.stagingBufferRange, stagingBufferSize, task.footprint.uncompressedSize);
-                task.readIntoCpuBuffer = true;
+                if (!task.mappedData)
+                {
+                    task.compressedData.resize(task.footprint.rangeInStream.size);
+                    task.readIntoCpuBuffer = true;
+                }
             }
         }
         else
@@ -115,6 +209,8 @@ void FillBufferLoadingTasksForBC(
 
         AppendBufferRange(task.finalBufferRange, finalBufferSize, task.footprint.uncompressedSize);
     }
+
+    return true;
 }
 
 #if NTC_WITH_DX12
@@ -169,41 +265,62 @@ void UploadAndDecompressTextureWithDStorage(IDStorageQueue* dstorageQueue,
 }
 #endif
 
-bool DecompressWithVulkanExtension(nvrhi::IDevice* device, nvrhi::ICommandList* commandList,
+// One GDeflate stream for RunVulkanDecompressionJobs. The headers must stay alive until the jobs are recorded.
+struct VulkanDecompressionJob
+{
+    void const* compressedHeader = nullptr;
+    size_t compressedHeaderSize = 0;
+    size_t compressedOffset = 0;
+    size_t decompressedOffset = 0;
+};
+
+// Records the decompression of all streams from compressedBuffer into decompressedBuffer.
+// The jobs share one set of barriers before the decompression, and their commands are recorded back to back,
+// instead of transitioning the buffers around every stream. The caller must have written the compressed data
+// for all jobs before, and transitions decompressedBuffer for its consumers after.
+// Returns the success of every job, 'false' for the jobs that failed to record.
+static std::vector<bool> RunVulkanDecompressionJobs(nvrhi::ICommandList* commandList,
     ntc::IContext* context,
-    void const* compressedHeader,
-    size_t const compressedHeaderSize,
-    size_t const uncompressedSize,
+    std::vector<VulkanDecompressionJob> const& jobs,
     nvrhi::IBuffer* compressedBuffer,
-    size_t const compressedOffset,
-    nvrhi::IBuffer* decompressedBuffer,
-    size_t const decompressedOffset)
+    nvrhi::IBuffer* decompressedBuffer)
 {
+    std::vector<bool> results(jobs.size(), false);
+    if (jobs.empty())
+        return results;
+
 #if NTC_WITH_VULKAN
     void* vkCommandList = commandList->getNativeObject(nvrhi::ObjectTypes::VK_CommandBuffer);
     if (!vkCommandList)
-        return false;
+        return results;
     
     commandList->setBufferState(compressedBuffer, nvrhi::ResourceStates::ShaderResource);
     commandList->setBufferState(decompressedBuffer, nvrhi::ResourceStates::UnorderedAccess);
     commandList->commitBarriers();
 
-    ntc::Status ntcStatus = context->DecompressGDeflateOnVulkanGPU(vkCommandList,
-        compressedHeader, compressedHeaderSize,
-        compressedBuffer->getGpuVirtualAddress() + compressedOffset,
-        decompressedBuffer->getGpuVirtualAddress() + decompressedOffset);
+    uint64_t const compressedAddress = compressedBuffer->getGpuVirtualAddress();
+    uint64_t const decompressedAddress = decompressedBuffer->getGpuVirtualAddress();
 
-    if (ntcStatus != ntc::Status::Ok)
+    for (size_t index = 0; index < jobs.size(); ++index)
     {
-        fprintf(stderr, "Call to DecompressGDeflateOnVulkanGPU failed, error code = %s: %s\n",
-            ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-        return false;
+        VulkanDecompressionJob const& job = jobs[index];
+        ntc::Status ntcStatus = context->DecompressGDeflateOnVulkanGPU(vkCommandList,
+            job.compressedHeader, job.compressedHeaderSize,
+            compressedAddress + job.compressedOffset,
+            decompressedAddress + job.decompressedOffset);
+
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Call to DecompressGDeflateOnVulkanGPU failed, error code = %s: %s\n",
+                ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            continue;
+        }
+
+        results[index] = true;
     }
-    
-    return true;
-#else
-    return false;
 #endif
+
+    return results;
 }
 
 bool CopyBufferToTextureVulkan(nvrhi::ICommandList* commandList,
@@ -259,7 +376,8 @@ bool ExecuteBufferLoadingTasks(
     nvrhi::BufferHandle& finalBuffer,
     size_t stagingBufferSize,
     size_t tempBufferSize,
-    size_t finalBufferSize)
+    size_t finalBufferSize,
+    DStorageLoadingBatch* dstorageBatch)
 {
     nvrhi::BufferHandle stagingBuffer;
     MappedBuffer<uint8_t> mappedStagingBuffer(device);
@@ -306,6 +424,10 @@ bool ExecuteBufferLoadingTasks(
     }
 
     bool anyDStorageTasks = false;
+    std::vector<CpuDecompressionJob> cpuJobs;
+    std::vector<BufferLoadingTask*> cpuJobTasks;
+    std::vector<VulkanDecompressionJob> vkJobs;
+    std::vector<BufferLoadingTask*> vkJobTasks;
     commandList->open();
     for (BufferLoadingTask& task : tasks)
     {
@@ -322,26 +444,47 @@ bool ExecuteBufferLoadingTasks(
             continue; // Task completed
         }
         
-        assert(inputFile);
-        bool readSuccessful = inputFile->Seek(task.footprint.rangeInStream.offset);
-        
-        // Read the data into the CPU buffer (task.compressedData), the staging buffer,
-        // or both in a split mode: headers go into the CPU buffer, payload goes into the staging buffer.
-        uint64_t totalBytesRead = 0;
-        if (readSuccessful && task.readIntoCpuBuffer)
+        // Compressed data or GDeflate headers for the CPU side of the pipeline
+        uint8_t const* cpuData = task.compressedData.data();
+        bool readSuccessful = true;
+
+        if (task.mappedData)
         {
-            assert(task.compressedData.size() != 0);
-            readSuccessful = inputFile->Read(task.compressedData.data(), task.compressedData.size());
-            totalBytesRead += task.compressedData.size();
+            // The input is in memory: use it in place, only copy what goes into the GPU staging buffer.
+            // The staging part is always at the end of the range, after the headers (if any).
+            cpuData = task.mappedData;
+            if (task.readIntoCpuBuffer)
+                memcpy(task.compressedData.data(), task.mappedData, task.compressedData.size());
+            if (task.readIntoStagingBuffer)
+            {
+                memcpy(mappedStagingBuffer.Get() + task.stagingBufferRange.byteOffset,
+                    task.mappedData + task.footprint.rangeInStream.size - task.stagingBufferRange.byteSize,
+                    task.stagingBufferRange.byteSize);
+            }
         }
-        if (readSuccessful && task.readIntoStagingBuffer)
+        else
         {
-            assert(task.stagingBufferRange.byteSize != 0);
-            readSuccessful = inputFile->Read(mappedStagingBuffer.Get() + task.stagingBufferRange.byteOffset,
-                task.stagingBufferRange.byteSize);
-            totalBytesRead += task.stagingBufferRange.byteSize;
+            assert(inputFile);
+            readSuccessful = inputFile->Seek(task.footprint.rangeInStream.offset);
+            
+            // Read the data into the CPU buffer (task.compressedData), the staging buffer,
+            // or both in a split mode: headers go into the CPU buffer, payload goes into the staging buffer.
+            uint64_t totalBytesRead = 0;
+            if (readSuccessful && task.readIntoCpuBuffer)
+            {
+                assert(task.compressedData.size() != 0);
+                readSuccessful = inputFile->Read(task.compressedData.data(), task.compressedData.size());
+                totalBytesRead += task.compressedData.size();
+            }
+            if (readSuccessful && task.readIntoStagingBuffer)
+            {
+                assert(task.stagingBufferRange.byteSize != 0);
+                readSuccessful = inputFile->Read(mappedStagingBuffer.Get() + task.stagingBufferRange.byteOffset,
+                    task.stagingBufferRange.byteSize);
+                totalBytesRead += task.stagingBufferRange.byteSize;
+            }
+            assert(totalBytesRead == task.footprint.rangeInStream.size);
         }
-        assert(totalBytesRead == task.footprint.rangeInStream.size);
 
         if (!readSuccessful)
         {
@@ -359,46 +502,32 @@ bool ExecuteBufferLoadingTasks(
                 break;
 
             case BufferLoadingPipeline::DecompressOnCPU: {
-                ntc::Status ntcStatus = context->DecompressBuffer(
-                    ntc::CompressionType::GDeflate,
-                    task.compressedData.data(),
-                    task.footprint.rangeInStream.size,
-                    task.uncompressedData.data(),
-                    task.stagingBufferRange.byteSize,
-                    task.footprint.uncompressedCrc32);
-
-                if (ntcStatus != ntc::Status::Ok)
-                {
-                    fprintf(stderr, "Failed to decompress BC7 data, error code = %s: %s\n",
-                        ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-                    task.pipeline = BufferLoadingPipeline::None;
-                    break; // Task failed
-                }
-
-                assert(task.uncompressedData.size() == task.stagingBufferRange.byteSize);
-                memcpy(mappedStagingBuffer.Get() + task.stagingBufferRange.byteOffset,
-                    task.uncompressedData.data(), task.uncompressedData.size());
-
-                commandList->copyBuffer(finalBuffer, task.finalBufferRange.byteOffset,
-                    stagingBuffer, task.stagingBufferRange.byteOffset, task.footprint.uncompressedSize);
+                // Decompression is done later on worker threads, directly into the staging buffer
+                CpuDecompressionJob& job = cpuJobs.emplace_back();
+                job.compressionType = ntc::CompressionType::GDeflate;
+                job.compressedData = cpuData;
+                job.compressedSize = task.footprint.rangeInStream.size;
+                job.uncompressedData = mappedStagingBuffer.Get() + task.stagingBufferRange.byteOffset;
+                job.uncompressedSize = task.stagingBufferRange.byteSize;
+                job.uncompressedCrc32 = task.footprint.uncompressedCrc32;
+                cpuJobTasks.push_back(&task);
                 break;
             }
 
-            case BufferLoadingPipeline::DecompressWithVk:
+            case BufferLoadingPipeline::DecompressWithVk: {
                 assert(task.tempBufferRange.byteSize == task.stagingBufferRange.byteSize);
                 commandList->copyBuffer(tempBuffer, task.tempBufferRange.byteOffset, stagingBuffer,
                     task.stagingBufferRange.byteOffset, task.stagingBufferRange.byteSize);
 
-                DecompressWithVulkanExtension(device, commandList,
-                    context,
-                    task.compressedData.data(),
-                    task.compressedData.size(),
-                    task.footprint.uncompressedSize,
-                    tempBuffer,
-                    task.tempBufferRange.byteOffset,
-                    finalBuffer,
-                    task.finalBufferRange.byteOffset);
+                // Decompression is recorded later for all tasks together, after all copies into tempBuffer
+                VulkanDecompressionJob& job = vkJobs.emplace_back();
+                job.compressedHeader = cpuData;
+                job.compressedHeaderSize = task.gdeflateHeaderSize;
+                job.compressedOffset = task.tempBufferRange.byteOffset;
+                job.decompressedOffset = task.finalBufferRange.byteOffset;
+                vkJobTasks.push_back(&task);
                 break;
+            }
 
             case BufferLoadingPipeline::DecompressWithDStorage: {
                 // DStorage decompression is done later, after this cmdlist is executed
@@ -409,9 +538,46 @@ bool ExecuteBufferLoadingTasks(
                 assert(!"Unknown BufferLoadingPipeline value!");
         }
     }
+
+    std::vector<bool> const vkJobResults = RunVulkanDecompressionJobs(commandList, context, vkJobs,
+        tempBuffer, finalBuffer);
+    for (size_t index = 0; index < vkJobs.size(); ++index)
+    {
+        if (!vkJobResults[index])
+            vkJobTasks[index]->pipeline = BufferLoadingPipeline::None; // Task failed
+    }
+
+    RunCpuDecompressionJobs(context, cpuJobs);
+
+    for (size_t index = 0; index < cpuJobs.size(); ++index)
+    {
+        BufferLoadingTask& task = *cpuJobTasks[index];
+        if (cpuJobs[index].status != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to decompress BC7 data, error code = %s\n",
+                ntc::StatusToString(cpuJobs[index].status));
+            task.pipeline = BufferLoadingPipeline::None;
+            continue; // Task failed
+        }
+
+        commandList->copyBuffer(finalBuffer, task.finalBufferRange.byteOffset,
+            stagingBuffer, task.stagingBufferRange.byteOffset, task.footprint.uncompressedSize);
+    }
+
     commandList->close();
     device->executeCommandList(commandList);
 
+    if (anyDStorageTasks && dstorageBatch)
+    {
+        // The requests are submitted later, together with the requests for other materials
+        for (BufferLoadingTask& task : tasks)
+        {
+            if (task.pipeline == BufferLoadingPipeline::DecompressWithDStorage)
+                dstorageBatch->AddBufferRequest(std::move(task.compressedData), finalBuffer, task.finalBufferRange);
+        }
+        return true;
+    }
+
 #if NTC_WITH_DX12
     if (anyDStorageTasks)
     {
@@ -442,7 +608,7 @@ bool ExecuteBufferLoadingTasks(
     return true;
 }
 
-void FillTextureLoadingTasksForLatents(
+bool FillTextureLoadingTasksForLatents(
     ntc::ITextureSetMetadata* textureSetMetadata,
     nvrhi::ITexture* destinationTexture,
     int firstLatentMipLevel,
@@ -450,7 +616,9 @@ void FillTextureLoadingTasksForLatents(
     bool gpuDecompressionSupported,
     nvrhi::GraphicsAPI graphicsAPI,
     size_t& compressedBufferSize,
-    size_t& decompressedBufferSize)
+    size_t& decompressedBufferSize,
+    uint8_t const* inputData,
+    size_t inputDataSize)
 {
     ntc::LatentTextureDesc const latentTextureDesc = textureSetMetadata->GetLatentTextureDesc();
 
@@ -474,8 +642,9 @@ void FillTextureLoadingTasksForLatents(
     {
         for (int layerIndex = 0; layerIndex < latentTextureDesc.arraySize; ++layerIndex)
         {
+            // The destination texture starts at firstLatentMipLevel, so its mips are offset from the latent mips
             TextureSubresourceLoadingTask& task = tasks.emplace_back();
-            task.mipLevel = mipLevel;
+            task.mipLevel = mipLevel - firstLatentMipLevel;
             task.layerIndex = layerIndex;
             task.destinationTexture = destinationTexture;
 
@@ -483,11 +652,28 @@ void FillTextureLoadingTasksForLatents(
             if (ntcStatus != ntc::Status::Ok)
                 continue;
 
+            if (inputData)
+            {
+                if (!IsRangeInInputData(task.footprint.buffer.rangeInStream.offset,
+                    task.footprint.buffer.rangeInStream.size, inputDataSize))
+                {
+                    log::warning("Latent data for mip %d layer %d is outside of the file "
+                        "(%zu bytes at offset %zu, file size %zu)", mipLevel, layerIndex,
+                        task.footprint.buffer.rangeInStream.size, task.footprint.buffer.rangeInStream.offset,
+                        inputDataSize);
+                    return false;
+                }
+                task.mappedData = inputData + task.footprint.buffer.rangeInStream.offset;
+            }
+
             if (task.footprint.buffer.compressionType == ntc::CompressionType::None)
             {
                 task.pipeline = BufferLoadingPipeline::ReadUncompressed;
-                task.uncompressedData.resize(task.footprint.buffer.rangeInStream.size);
-                task.readUncompressedIntoCpuBuffer = true;
+                if (!task.mappedData)
+                {
+                    task.uncompressedData.resize(task.footprint.buffer.rangeInStream.size);
+                    task.readUncompressedIntoCpuBuffer = true;
+                }
             }
             else if (task.footprint.buffer.compressionType == ntc::CompressionType::GDeflate)
             {
@@ -495,12 +681,15 @@ void FillTextureLoadingTasksForLatents(
                 {
                     task.pipeline = BufferLoadingPipeline::DecompressWithVk;
                     task.gdeflateHeaderSize = ntc::GetGDeflateHeaderSize(task.footprint.buffer.uncompressedSize);
-                    task.compressedData.resize(task.footprint.buffer.rangeInStream.size);
                     AppendBufferRange(task.compressedBufferRange, compressedBufferSize,
                         task.footprint.buffer.rangeInStream.size - task.gdeflateHeaderSize);
                     AppendBufferRange(task.decompressedBufferRange, decompressedBufferSize,
                         task.footprint.buffer.uncompressedSize);
-                    task.readCompressedIntoCpuBuffer = true;
+                    if (!task.mappedData)
+                    {
+                        task.compressedData.resize(task.footprint.buffer.rangeInStream.size);
+                        task.readCompressedIntoCpuBuffer = true;
+                    }
                 }
                 else if (enableDStorage)
                 {
@@ -511,13 +700,18 @@ void FillTextureLoadingTasksForLatents(
                 else
                 {
                     task.pipeline = BufferLoadingPipeline::DecompressOnCPU;
-                    task.compressedData.resize(task.footprint.buffer.rangeInStream.size);
                     task.uncompressedData.resize(task.footprint.buffer.uncompressedSize);
-                    task.readCompressedIntoCpuBuffer = true;
+                    if (!task.mappedData)
+                    {
+                        task.compressedData.resize(task.footprint.buffer.rangeInStream.size);
+                        task.readCompressedIntoCpuBuffer = true;
+                    }
                 }
             }
         }
     }
+
+    return true;
 }
 
 bool ExecuteTextureLoadingTasks(
@@ -528,7 +722,8 @@ bool ExecuteTextureLoadingTasks(
     GDeflateFeatures* gdeflateFeatures,
     std::vector<TextureSubresourceLoadingTask>& tasks,
     size_t compressedBufferSize,
-    size_t decompressedBufferSize)
+    size_t decompressedBufferSize,
+    DStorageLoadingBatch* dstorageBatch)
 {
     nvrhi::BufferHandle compressedBuffer;
     nvrhi::BufferHandle decompressedBuffer;
@@ -559,6 +754,10 @@ bool ExecuteTextureLoadingTasks(
 
     bool anyDStorageTasks = false;
     nvrhi::ITexture* lastTexture = nullptr;
+    std::vector<CpuDecompressionJob> cpuJobs;
+    std::vector<TextureSubresourceLoadingTask*> cpuJobTasks;
+    std::vector<VulkanDecompressionJob> vkJobs;
+    std::vector<TextureSubresourceLoadingTask*> vkJobTasks;
 
     commandList->open();
     for (TextureSubresourceLoadingTask& task : tasks)
@@ -566,24 +765,40 @@ bool ExecuteTextureLoadingTasks(
         if (task.pipeline == BufferLoadingPipeline::None)
             continue; // Nothing to do
             
-        assert(inputFile);
-        bool readSuccessful = inputFile->Seek(task.footprint.buffer.rangeInStream.offset);
-        
-        // Read the data into one of the CPU buffers (task.compressedData or task.uncompressedBuffer)
-        uint64_t totalBytesRead = 0;
-        if (readSuccessful && task.readCompressedIntoCpuBuffer)
+        // Data as stored in the file: compressed, or uncompressed for the ReadUncompressed pipeline
+        uint8_t const* cpuData = nullptr;
+        bool readSuccessful = true;
+
+        if (task.mappedData)
         {
-            assert(!task.compressedData.empty());
-            readSuccessful = inputFile->Read(task.compressedData.data(), task.compressedData.size());
-            totalBytesRead += task.compressedData.size();
+            // The input is in memory: use it in place, DirectStorage requests need their own copy
+            cpuData = task.mappedData;
+            if (task.readCompressedIntoCpuBuffer)
+                memcpy(task.compressedData.data(), task.mappedData, task.compressedData.size());
         }
-        if (readSuccessful && task.readUncompressedIntoCpuBuffer)
+        else
         {
-            assert(!task.uncompressedData.empty());
-            readSuccessful = inputFile->Read(task.uncompressedData.data(), task.uncompressedData.size());
-            totalBytesRead += task.uncompressedData.size();
+            assert(inputFile);
+            readSuccessful = inputFile->Seek(task.footprint.buffer.rangeInStream.offset);
+            
+            // Read the data into one of the CPU buffers (task.compressedData or task.uncompressedBuffer)
+            uint64_t totalBytesRead = 0;
+            if (readSuccessful && task.readCompressedIntoCpuBuffer)
+            {
+                assert(!task.compressedData.empty());
+                readSuccessful = inputFile->Read(task.compressedData.data(), task.compressedData.size());
+                totalBytesRead += task.compressedData.size();
+                cpuData = task.compressedData.data();
+            }
+            if (readSuccessful && task.readUncompressedIntoCpuBuffer)
+            {
+                assert(!task.uncompressedData.empty());
+                readSuccessful = inputFile->Read(task.uncompressedData.data(), task.uncompressedData.size());
+                totalBytesRead += task.uncompressedData.size();
+                cpuData = task.uncompressedData.data();
+            }
+            assert(totalBytesRead == task.footprint.buffer.rangeInStream.size);
         }
-        assert(totalBytesRead == task.footprint.buffer.rangeInStream.size);
         
         if (!readSuccessful)
         {
@@ -607,52 +822,39 @@ bool ExecuteTextureLoadingTasks(
         {
             case BufferLoadingPipeline::ReadUncompressed:
                 commandList->writeTexture(task.destinationTexture, task.layerIndex, task.mipLevel,
-                    task.uncompressedData.data(), task.footprint.rowPitch);
+                    cpuData, task.footprint.rowPitch);
                 break;
 
             case BufferLoadingPipeline::DecompressOnCPU: {
-                ntc::Status ntcStatus = context->DecompressBuffer(
-                    task.footprint.buffer.compressionType,
-                    task.compressedData.data(),
-                    task.compressedData.size(),
-                    task.uncompressedData.data(),
-                    task.uncompressedData.size(),
-                    task.footprint.buffer.uncompressedCrc32);
-
-                if (ntcStatus != ntc::Status::Ok)
-                {
-                    fprintf(stderr, "Failed to decompress latent data, error code = %s: %s\n",
-                        ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-                    task.pipeline = BufferLoadingPipeline::None;
-                    break; // Task failed
-                }
-
-                commandList->writeTexture(task.destinationTexture, task.layerIndex, task.mipLevel,
-                    task.uncompressedData.data(), task.footprint.rowPitch);
+                // Decompression is done later on worker threads, the texture is already in the CopyDest state
+                CpuDecompressionJob& job = cpuJobs.emplace_back();
+                job.compressionType = task.footprint.buffer.compressionType;
+                job.compressedData = cpuData;
+                job.compressedSize = task.footprint.buffer.rangeInStream.size;
+                job.uncompressedData = task.uncompressedData.data();
+                job.uncompressedSize = task.uncompressedData.size();
+                job.uncompressedCrc32 = task.footprint.buffer.uncompressedCrc32;
+                cpuJobTasks.push_back(&task);
                 break;
             }
 
-            case BufferLoadingPipeline::DecompressWithVk:
-                assert(task.compressedData.size() == task.gdeflateHeaderSize + task.compressedBufferRange.byteSize);
+            case BufferLoadingPipeline::DecompressWithVk: {
+                assert(task.footprint.buffer.rangeInStream.size == task.gdeflateHeaderSize + task.compressedBufferRange.byteSize);
                 commandList->writeBuffer(compressedBuffer,
-                    task.compressedData.data() + task.gdeflateHeaderSize,
+                    cpuData + task.gdeflateHeaderSize,
                     task.compressedBufferRange.byteSize,
                     task.compressedBufferRange.byteOffset);
                 
-                DecompressWithVulkanExtension(device, commandList,
-                    context,
-                    task.compressedData.data(),
-                    task.gdeflateHeaderSize,
-                    task.footprint.buffer.uncompressedSize,
-                    compressedBuffer,
-                    task.compressedBufferRange.byteOffset,
-                    decompressedBuffer,
-                    task.decompressedBufferRange.byteOffset);
-
-                CopyBufferToTextureVulkan(commandList,
-                    decompressedBuffer, task.decompressedBufferRange.byteOffset,
-                    task.footprint, task.destinationTexture, task.mipLevel, task.layerIndex);
+                // Decompression and the copy into the texture are recorded later for all tasks together,
+                // so that the buffers don't go through a state transition for every subresource
+                VulkanDecompressionJob& job = vkJobs.emplace_back();
+                job.compressedHeader = cpuData;
+                job.compressedHeaderSize = task.gdeflateHeaderSize;
+                job.compressedOffset = task.compressedBufferRange.byteOffset;
+                job.decompressedOffset = task.decompressedBufferRange.byteOffset;
+                vkJobTasks.push_back(&task);
                 break;
+            }
 
             case BufferLoadingPipeline::DecompressWithDStorage: {
                 // DStorage decompression is done later, after this cmdlist is executed
@@ -664,10 +866,71 @@ bool ExecuteTextureLoadingTasks(
         }
         
     }
+
+    if (!vkJobs.empty())
+    {
+        std::vector<bool> const vkJobResults = RunVulkanDecompressionJobs(commandList, context, vkJobs,
+            compressedBuffer, decompressedBuffer);
+
+        commandList->setBufferState(decompressedBuffer, nvrhi::ResourceStates::CopySource);
+        commandList->commitBarriers();
+
+        for (size_t index = 0; index < vkJobs.size(); ++index)
+        {
+            TextureSubresourceLoadingTask& task = *vkJobTasks[index];
+            if (!vkJobResults[index])
+            {
+                task.pipeline = BufferLoadingPipeline::None;
+                continue; // Task failed
+            }
+
+            CopyBufferToTextureVulkan(commandList,
+                decompressedBuffer, task.decompressedBufferRange.byteOffset,
+                task.footprint, task.destinationTexture, task.mipLevel, task.layerIndex);
+        }
+    }
+
+    RunCpuDecompressionJobs(context, cpuJobs);
+
+    for (size_t index = 0; index < cpuJobs.size(); ++index)
+    {
+        TextureSubresourceLoadingTask& task = *cpuJobTasks[index];
+        if (cpuJobs[index].status != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to decompress latent data, error code = %s\n",
+                ntc::StatusToString(cpuJobs[index].status));
+            task.pipeline = BufferLoadingPipeline::None;
+            continue; // Task failed
+        }
+
+        commandList->writeTexture(task.destinationTexture, task.layerIndex, task.mipLevel,
+            task.uncompressedData.data(), task.footprint.rowPitch);
+    }
     
     commandList->close();
     device->executeCommandList(commandList);
 
+    if (anyDStorageTasks && dstorageBatch)
+    {
+        // The requests are submitted later, together with the requests for other materials,
+        // and the textures can only be transitioned to the ShaderResource state after that.
+        lastTexture = nullptr;
+        for (TextureSubresourceLoadingTask& task : tasks)
+        {
+            if (task.pipeline == BufferLoadingPipeline::DecompressWithDStorage)
+            {
+                dstorageBatch->AddTextureRequest(std::move(task.compressedData), task.destinationTexture,
+                    task.mipLevel, task.layerIndex, task.footprint.buffer.uncompressedSize);
+            }
+            if (lastTexture != task.destinationTexture)
+            {
+                dstorageBatch->AddTextureForTransition(task.destinationTexture);
+                lastTexture = task.destinationTexture;
+            }
+        }
+        return true;
+    }
+
 #if NTC_WITH_DX12
     if (anyDStorageTasks)
     {
@@ -712,3 +975,141 @@ bool ExecuteTextureLoadingTasks(
 
     return true;
 }
+
+DStorageLoadingBatch::DStorageLoadingBatch(nvrhi::IDevice* device, GDeflateFeatures* gdeflateFeatures)
+    : m_device(device)
+    , m_gdeflateFeatures(gdeflateFeatures)
+{ }
+
+size_t DStorageLoadingBatch::BeginGroup()
+{
+    return m_groupCount++;
+}
+
+void DStorageLoadingBatch::AddBufferRequest(std::vector<uint8_t>&& compressedData, nvrhi::IBuffer* buffer,
+    nvrhi::BufferRange range)
+{
+    assert(m_groupCount > 0); // BeginGroup must be called first
+    Request& request = m_requests.emplace_back();
+    request.group = m_groupCount - 1;
+    request.compressedData = std::move(compressedData);
+    request.buffer = buffer;
+    request.bufferRange = range;
+}
+
+void DStorageLoadingBatch::AddTextureRequest(std::vector<uint8_t>&& compressedData, nvrhi::ITexture* texture,
+    int mipLevel, int layerIndex, size_t uncompressedSize)
+{
+    assert(m_groupCount > 0); // BeginGroup must be called first
+    Request& request = m_requests.emplace_back();
+    request.group = m_groupCount - 1;
+    request.compressedData = std::move(compressedData);
+    request.texture = texture;
+    request.mipLevel = mipLevel;
+    request.layerIndex = layerIndex;
+    request.uncompressedSize = uncompressedSize;
+}
+
+void DStorageLoadingBatch::AddTextureForTransition(nvrhi::ITexture* texture)
+{
+    m_textures.push_back(texture);
+}
+
+bool DStorageLoadingBatch::Finish(nvrhi::ICommandList* commandList)
+{
+    size_t const firstGroup = m_groupResults.size();
+    m_groupResults.resize(m_groupCount, true);
+
+    if (IsEmpty())
+        return true;
+
+    bool success = true;
+
+#if NTC_WITH_DX12
+    if (!m_requests.empty())
+    {
+        assert(m_gdeflateFeatures && m_gdeflateFeatures->dstorageQueue);
+        IDStorageQueue2* queue = m_gdeflateFeatures->dstorageQueue;
+
+        // One status entry per group since the last Finish, enqueued after the last request of the group
+        nvrhi::RefCountPtr<IDStorageFactory> factory;
+        nvrhi::RefCountPtr<IDStorageStatusArray> statusArray;
+        uint32_t const statusCount = uint32_t(m_groupCount - firstGroup);
+        if (FAILED(DStorageGetFactory(IID_PPV_ARGS(&factory))) ||
+            FAILED(factory->CreateStatusArray(statusCount, "NTC Loading Batch", IID_PPV_ARGS(&statusArray))))
+        {
+            log::warning("Failed to create a DirectStorage status array.");
+            statusArray = nullptr;
+        }
+
+        // The copy and decompression command lists executed for the requests, including the transitions
+        // of the textures to the CopyDest state, have to complete before DirectStorage writes the resources.
+        m_device->waitForIdle();
+
+        for (size_t index = 0; index < m_requests.size(); ++index)
+        {
+            Request& request = m_requests[index];
+            if (request.buffer)
+            {
+                UploadAndDecompressBufferWithDStorage(queue, request.compressedData, request.buffer,
+                    request.bufferRange);
+            }
+            else
+            {
+                UploadAndDecompressTextureWithDStorage(queue, request.compressedData, request.texture,
+                    request.mipLevel, request.layerIndex, request.uncompressedSize);
+            }
+
+            bool const lastInGroup = index + 1 == m_requests.size() || m_requests[index + 1].group != request.group;
+            if (lastInGroup && statusArray)
+                queue->EnqueueStatus(statusArray, uint32_t(request.group - firstGroup));
+        }
+
+        // The compressed data must stay alive until the requests complete, so sync on the CPU like
+        // ExecuteBufferLoadingTasks does, but only once for the whole batch.
+        assert(m_gdeflateFeatures->dstorageEvent);
+        queue->EnqueueSetEvent(m_gdeflateFeatures->dstorageEvent);
+        queue->Submit();
+
+        WaitForSingleObject(m_gdeflateFeatures->dstorageEvent, INFINITE);
+
+        if (statusArray)
+        {
+            for (Request const& request : m_requests)
+            {
+                size_t const group = request.group;
+                if (m_groupResults[group] && FAILED(statusArray->GetHResult(uint32_t(group - firstGroup))))
+                {
+                    m_groupResults[group] = false;
+                    success = false;
+                }
+            }
+        }
+    }
+#else
+    assert(m_requests.empty()); // DirectStorage tasks are only created on DX12
+    (void)firstGroup;
+#endif
+
+    m_requests.clear();
+
+    // Transition all latent textures to the ShaderResource state, permanently, see ExecuteTextureLoadingTasks
+    commandList->open();
+    for (nvrhi::ITexture* texture : m_textures)
+    {
+        commandList->beginTrackingTextureState(texture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
+        commandList->setPermanentTextureState(texture, nvrhi::ResourceStates::ShaderResource);
+    }
+    commandList->commitBarriers();
+    commandList->close();
+    m_device->executeCommandList(commandList);
+
+    m_textures.clear();
+
+    return success;
+}
+
+bool DStorageLoadingBatch::IsGroupSuccessful(size_t group) const
+{
+    return group < m_groupResults.size() && m_groupResults[group];
+}
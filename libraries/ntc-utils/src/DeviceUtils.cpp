@@ -12,6 +12,7 @@
 
 #if NTC_WITH_DX12
 #include <directx/d3d12.h>
+#include <dxgi1_4.h>
 extern "C"
 {
     _declspec(dllexport) extern const unsigned int D3D12SDKVersion = D3D12_PREVIEW_SDK_VERSION;
@@ -43,6 +44,64 @@ bool IsDX12DeveloperModeEnabled()
 #endif
 }
 
+LocalVideoMemoryInfo::~LocalVideoMemoryInfo()
+{
+#if NTC_WITH_DX12
+    if (m_adapter)
+        m_adapter->Release();
+#endif
+}
+
+bool LocalVideoMemoryInfo::Init(nvrhi::IDevice* device)
+{
+#if NTC_WITH_DX12
+    if (m_adapter)
+    {
+        m_adapter->Release();
+        m_adapter = nullptr;
+    }
+
+    if (device->getGraphicsAPI() != nvrhi::GraphicsAPI::D3D12)
+        return false;
+
+    ID3D12Device* d3dDevice = device->getNativeObject(nvrhi::ObjectTypes::D3D12_Device);
+    if (!d3dDevice)
+        return false;
+
+    nvrhi::RefCountPtr<IDXGIFactory4> factory;
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))))
+        return false;
+
+    if (FAILED(factory->EnumAdapterByLuid(d3dDevice->GetAdapterLuid(), IID_PPV_ARGS(&m_adapter))))
+    {
+        m_adapter = nullptr;
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LocalVideoMemoryInfo::Query(uint64_t& outBudget, uint64_t& outCurrentUsage) const
+{
+#if NTC_WITH_DX12
+    if (!m_adapter)
+        return false;
+
+    DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo{};
+    if (FAILED(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo)))
+        return false;
+
+    outBudget = memoryInfo.Budget;
+    outCurrentUsage = memoryInfo.CurrentUsage;
+    return true;
+#else
+    return false;
+#endif
+}
+
 void SetNtcGraphicsDeviceParameters(
     donut::app::DeviceCreationParameters& deviceParams,
     nvrhi::GraphicsAPI graphicsApi,
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -12,6 +12,12 @@
 
 #include <ntc-utils/GraphicsBlockCompressionPass.h>
 #include <libntc/shaders/Bindings.h>
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+// Placement alignment for constant buffer views, 256 bytes is the strictest requirement in DX12 and Vulkan
+static const uint32_t g_constantBufferAlignment = 256;
 
 bool GraphicsBlockCompressionPass::Init()
 {
@@ -38,34 +44,59 @@ bool GraphicsBlockCompressionPass::Init()
     m_bindingLayoutWithModeBuffer = m_device->createBindingLayout(bindingLayoutDesc);
     if (!m_bindingLayoutWithModeBuffer)
         return false;
+
+    // The batched passes use ranges of one regular constant buffer instead of versions of a volatile one
+    auto batchedBindingLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .setBindingOffsets(vulkanBindingOffsets)
+        .addItem(nvrhi::BindingLayoutItem::ConstantBuffer(NTC_BINDING_BC_CONSTANT_BUFFER))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(NTC_BINDING_BC_INPUT_TEXTURE))
+        .addItem(nvrhi::BindingLayoutItem::Texture_UAV(NTC_BINDING_BC_OUTPUT_TEXTURE));
+
+    m_batchedBindingLayout = m_device->createBindingLayout(batchedBindingLayoutDesc);
+    if (!m_batchedBindingLayout)
+        return false;
+
+    batchedBindingLayoutDesc.addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(NTC_BINDING_BC_MODE_BUFFER));
+    m_batchedBindingLayoutWithModeBuffer = m_device->createBindingLayout(batchedBindingLayoutDesc);
+    if (!m_batchedBindingLayoutWithModeBuffer)
+        return false;
     
     return true;
 }
 
-bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* commandList, ntc::ComputePassDesc& computePass,
-    nvrhi::ITexture* inputTexture, nvrhi::Format inputFormat, int inputMipLevel,
-    nvrhi::IBuffer* modeBuffer,
-    nvrhi::ITexture* outputTexture, int outputMipLevel)
+nvrhi::ComputePipelineHandle GraphicsBlockCompressionPass::GetOrCreatePipeline(
+    std::unordered_map<const void*, nvrhi::ComputePipelineHandle>& pipelines,
+    const void* computeShader, size_t computeShaderSize, nvrhi::IBindingLayout* bindingLayout)
 {
-    auto bindingLayoutToUse = modeBuffer ? m_bindingLayoutWithModeBuffer : m_bindingLayout;
-
-    // Create the pipeline for this shader if it doesn't exist yet
-    auto& pipeline = m_pipelines[computePass.computeShader];
+    auto& pipeline = pipelines[computeShader];
     if (!pipeline)
     {
-        nvrhi::ShaderHandle computeShader = m_device->createShader(nvrhi::ShaderDesc().setShaderType(nvrhi::ShaderType::Compute),
-            computePass.computeShader, computePass.computeShaderSize);
+        nvrhi::ShaderHandle shader = m_device->createShader(nvrhi::ShaderDesc().setShaderType(nvrhi::ShaderType::Compute),
+            computeShader, computeShaderSize);
 
         nvrhi::ComputePipelineDesc pipelineDesc;
         pipelineDesc
-            .setComputeShader(computeShader)
-            .addBindingLayout(bindingLayoutToUse);
+            .setComputeShader(shader)
+            .addBindingLayout(bindingLayout);
 
         pipeline = m_device->createComputePipeline(pipelineDesc);
-
-        if (!pipeline)
-            return false;
     }
+    return pipeline;
+}
+
+bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* commandList, ntc::ComputePassDesc& computePass,
+    nvrhi::ITexture* inputTexture, nvrhi::Format inputFormat, int inputMipLevel,
+    nvrhi::IBuffer* modeBuffer,
+    nvrhi::ITexture* outputTexture, int outputMipLevel)
+{
+    auto bindingLayoutToUse = modeBuffer ? m_bindingLayoutWithModeBuffer : m_bindingLayout;
+
+    // Create the pipeline for this shader if it doesn't exist yet
+    nvrhi::ComputePipelineHandle pipeline = GetOrCreatePipeline(m_pipelines,
+        computePass.computeShader, computePass.computeShaderSize, bindingLayoutToUse);
+    if (!pipeline)
+        return false;
 
     // Create the constant buffer if it doesn't exist yet or if it is too small (which shouldn't happen currently)
     if (!m_constantBuffer || m_constantBuffer->getDesc().byteSize < computePass.constantBufferSize)
@@ -110,4 +141,124 @@ bool GraphicsBlockCompressionPass::ExecuteComputePass(nvrhi::ICommandList* comma
     commandList->dispatch(computePass.dispatchWidth, computePass.dispatchHeight);
 
     return true;
-}
\ No newline at end of file
+}
+
+void GraphicsBlockCompressionPass::AddBatchedComputePass(ntc::ComputePassDesc const& computePass,
+    nvrhi::ITexture* inputTexture, nvrhi::Format inputFormat, int inputMipLevel,
+    nvrhi::IBuffer* modeBuffer,
+    nvrhi::ITexture* outputTexture, int outputMipLevel)
+{
+    // Copy the constants now because LibNTC reuses the memory for the next pass
+    uint32_t const constantBufferOffset = uint32_t(m_batchedConstants.size());
+    uint32_t const alignedSize = (uint32_t(computePass.constantBufferSize) + g_constantBufferAlignment - 1)
+        & ~(g_constantBufferAlignment - 1);
+    m_batchedConstants.resize(constantBufferOffset + alignedSize);
+    memcpy(m_batchedConstants.data() + constantBufferOffset, computePass.constantBufferData, computePass.constantBufferSize);
+
+    BatchedPass& pass = m_batchedPasses.emplace_back();
+    pass.computeShader = computePass.computeShader;
+    pass.computeShaderSize = computePass.computeShaderSize;
+    pass.constantBufferOffset = constantBufferOffset;
+    pass.constantBufferSize = alignedSize;
+    pass.dispatchWidth = computePass.dispatchWidth;
+    pass.dispatchHeight = computePass.dispatchHeight;
+    pass.inputTexture = inputTexture;
+    pass.inputFormat = inputFormat;
+    pass.inputMipLevel = inputMipLevel;
+    pass.modeBuffer = modeBuffer;
+    pass.outputTexture = outputTexture;
+    pass.outputMipLevel = outputMipLevel;
+}
+
+bool GraphicsBlockCompressionPass::ExecuteBatchedComputePasses(nvrhi::ICommandList* commandList)
+{
+    if (m_batchedPasses.empty())
+        return true;
+
+    bool success = true;
+
+    // Create or grow the constant buffer that holds the constants for all passes in the batch
+    size_t const constantsSize = m_batchedConstants.size();
+    if (!m_batchedConstantBuffer || m_batchedConstantBuffer->getDesc().byteSize < constantsSize)
+    {
+        nvrhi::BufferDesc constantBufferDesc;
+        constantBufferDesc
+            .setByteSize(std::max(constantsSize, m_batchedConstantBuffer
+                ? size_t(m_batchedConstantBuffer->getDesc().byteSize) * 2 : size_t(0)))
+            .setDebugName("BatchedBlockCompressionConstants")
+            .setIsConstantBuffer(true)
+            .setInitialState(nvrhi::ResourceStates::ConstantBuffer)
+            .setKeepInitialState(true);
+
+        m_batchedConstantBuffer = m_device->createBuffer(constantBufferDesc);
+        success = m_batchedConstantBuffer != nullptr;
+    }
+
+    if (success)
+        commandList->writeBuffer(m_batchedConstantBuffer, m_batchedConstants.data(), constantsSize);
+
+    // Group the passes by shader to minimize the pipeline changes, keeping the order within each group
+    std::stable_sort(m_batchedPasses.begin(), m_batchedPasses.end(), [](BatchedPass const& a, BatchedPass const& b)
+    {
+        return a.computeShader < b.computeShader;
+    });
+
+    // The passes write different subresources, so they can overlap on the GPU
+    std::unordered_set<nvrhi::ITexture*> outputTextures;
+    for (BatchedPass const& pass : m_batchedPasses)
+    {
+        if (outputTextures.insert(pass.outputTexture).second)
+            commandList->setEnableUavBarriersForTexture(pass.outputTexture, false);
+    }
+
+    for (BatchedPass const& pass : m_batchedPasses)
+    {
+        if (!success)
+            break;
+
+        auto bindingLayoutToUse = pass.modeBuffer ? m_batchedBindingLayoutWithModeBuffer : m_batchedBindingLayout;
+
+        nvrhi::ComputePipelineHandle pipeline = GetOrCreatePipeline(m_batchedPipelines,
+            pass.computeShader, pass.computeShaderSize, bindingLayoutToUse);
+        if (!pipeline)
+        {
+            success = false;
+            break;
+        }
+
+        nvrhi::BindingSetDesc bindingSetDesc;
+        bindingSetDesc
+            .addItem(nvrhi::BindingSetItem::ConstantBuffer(NTC_BINDING_BC_CONSTANT_BUFFER, m_batchedConstantBuffer,
+                nvrhi::BufferRange(pass.constantBufferOffset, pass.constantBufferSize)))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(NTC_BINDING_BC_INPUT_TEXTURE, pass.inputTexture, pass.inputFormat)
+                .setSubresources(nvrhi::TextureSubresourceSet().setBaseMipLevel(pass.inputMipLevel)))
+            .addItem(nvrhi::BindingSetItem::Texture_UAV(NTC_BINDING_BC_OUTPUT_TEXTURE, pass.outputTexture)
+                .setSubresources(nvrhi::TextureSubresourceSet().setBaseMipLevel(pass.outputMipLevel)));
+
+        if (pass.modeBuffer)
+        {
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_SRV(NTC_BINDING_BC_MODE_BUFFER, pass.modeBuffer));
+        }
+
+        nvrhi::BindingSetHandle bindingSet = m_bindingCache.GetOrCreateBindingSet(bindingSetDesc, bindingLayoutToUse);
+        if (!bindingSet)
+        {
+            success = false;
+            break;
+        }
+
+        auto state = nvrhi::ComputeState()
+            .setPipeline(pipeline)
+            .addBindingSet(bindingSet);
+        commandList->setComputeState(state);
+        commandList->dispatch(pass.dispatchWidth, pass.dispatchHeight);
+    }
+
+    for (nvrhi::ITexture* texture : outputTextures)
+        commandList->setEnableUavBarriersForTexture(texture, true);
+
+    m_batchedPasses.clear();
+    m_batchedConstants.clear();
+
+    return success;
+}
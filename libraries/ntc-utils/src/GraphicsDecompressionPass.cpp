@@ -116,9 +116,10 @@ bool GraphicsDecompressionPass::SetLatentDataFromTextureSet(nvrhi::ICommandList*
     std::vector<TextureSubresourceLoadingTask> tasks;
     size_t compressedBufferSize = 0;
     size_t decompressedBufferSize = 0;
-    FillTextureLoadingTasksForLatents(textureSetMetadata, m_latentTexture, 0, tasks,
+    if (!FillTextureLoadingTasksForLatents(textureSetMetadata, m_latentTexture, 0, tasks,
         gdeflateFeatures && gdeflateFeatures->gpuDecompressionSupported, m_device->getGraphicsAPI(),
-        compressedBufferSize, decompressedBufferSize);
+        compressedBufferSize, decompressedBufferSize))
+        return false;
     
     if (!ExecuteTextureLoadingTasks(m_device, commandList, context, inputStream, gdeflateFeatures, tasks,
         compressedBufferSize, decompressedBufferSize))
@@ -179,6 +180,7 @@ bool GraphicsDecompressionPass::SetWeightsFromTextureSet(nvrhi::ICommandList* co
 
         m_weightBuffer = m_device->createBuffer(weightBufferDesc);
         m_weightBufferIsExternal = false;
+        m_weightBufferRange = nvrhi::EntireBuffer;
 
         if (!m_weightBuffer)
             return false;
@@ -220,12 +222,13 @@ bool GraphicsDecompressionPass::SetWeightsFromTextureSet(nvrhi::ICommandList* co
     return true;
 }
 
-void GraphicsDecompressionPass::SetWeightBuffer(nvrhi::IBuffer* buffer)
+void GraphicsDecompressionPass::SetWeightBuffer(nvrhi::IBuffer* buffer, nvrhi::BufferRange range)
 {
-    if (buffer == m_weightBuffer)
+    if (buffer == m_weightBuffer && range == m_weightBufferRange)
         return;
         
     m_weightBuffer = buffer;
+    m_weightBufferRange = range;
     m_weightBufferIsExternal = true; // Prevent the buffer from being overwritten by a subsequent call to SetWeightsFromTextureSet
 }
 
@@ -272,7 +275,7 @@ bool GraphicsDecompressionPass::ExecuteComputePass(nvrhi::ICommandList* commandL
     bindingSetDesc
         .addItem(nvrhi::BindingSetItem::ConstantBuffer(NTC_BINDING_DECOMPRESSION_CONSTANT_BUFFER, m_constantBuffer))
         .addItem(nvrhi::BindingSetItem::Texture_SRV(NTC_BINDING_DECOMPRESSION_LATENT_TEXTURE, m_latentTexture))
-        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(NTC_BINDING_DECOMPRESSION_WEIGHT_BUFFER, m_weightBuffer))
+        .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(NTC_BINDING_DECOMPRESSION_WEIGHT_BUFFER, m_weightBuffer, m_weightBufferRange))
         .addItem(nvrhi::BindingSetItem::Sampler(NTC_BINDING_DECOMPRESSION_LATENT_SAMPLER, m_latentSampler));
     nvrhi::BindingSetHandle bindingSet = m_bindingCache.GetOrCreateBindingSet(bindingSetDesc, m_bindingLayout);
     if (!bindingSet)
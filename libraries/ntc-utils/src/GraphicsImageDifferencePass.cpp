@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -48,7 +48,7 @@ bool GraphicsImageDifferencePass::Init()
     if (!m_outputBuffer)
         return false;
 
-    // Create the staging/readback buffer
+    // Create the staging/readback buffers and the event queries to track their use
     auto stagingBufferDesc = nvrhi::BufferDesc()
         .setByteSize(resultBufferDesc.byteSize)
         .setDebugName("Compare Staging")
@@ -56,9 +56,16 @@ bool GraphicsImageDifferencePass::Init()
         .setInitialState(nvrhi::ResourceStates::CopyDest)
         .setKeepInitialState(true);
 
-    m_stagingBuffer = m_device->createBuffer(stagingBufferDesc);
-    if (!m_stagingBuffer)
-        return false;
+    for (ReadbackSlot& slot : m_readbackSlots)
+    {
+        slot.stagingBuffer = m_device->createBuffer(stagingBufferDesc);
+        if (!slot.stagingBuffer)
+            return false;
+
+        slot.eventQuery = m_device->createEventQuery();
+        if (!slot.eventQuery)
+            return false;
+    }
 
     return true;
 }
@@ -98,7 +105,7 @@ bool GraphicsImageDifferencePass::ExecuteComputePass(nvrhi::ICommandList* comman
             .setDebugName("CompareImagesConstants")
             .setIsConstantBuffer(true)
             .setIsVolatile(true)
-            .setMaxVersions(m_maxQueries);
+            .setMaxVersions(m_maxQueries * uint32_t(m_readbackSlots.size()));
 
         m_constantBuffer = m_device->createBuffer(constantBufferDesc);
         
@@ -133,17 +140,20 @@ bool GraphicsImageDifferencePass::ExecuteComputePass(nvrhi::ICommandList* comman
     commandList->setComputeState(state);
     commandList->dispatch(computePass.dispatchWidth, computePass.dispatchHeight);
 
-    commandList->copyBuffer(m_stagingBuffer, bufferOffset, m_outputBuffer, bufferOffset, BytesPerQuery);
+    // The current slot is being overwritten, it no longer holds the results of an ended batch
+    ReadbackSlot& slot = m_readbackSlots[m_currentSlot];
+    slot.batchIndex = InvalidBatchIndex;
+    commandList->copyBuffer(slot.stagingBuffer, bufferOffset, m_outputBuffer, bufferOffset, BytesPerQuery);
 
     m_resultsRead = false;
 
     return true;
 }
 
-bool GraphicsImageDifferencePass::ReadResults()
+bool GraphicsImageDifferencePass::ReadSlot(ReadbackSlot& slot)
 {
     uint64_t const* results = static_cast<uint64_t const*>(
-        m_device->mapBuffer(m_stagingBuffer, nvrhi::CpuAccessMode::Read));
+        m_device->mapBuffer(slot.stagingBuffer, nvrhi::CpuAccessMode::Read));
 
     if (!results)
         return false;
@@ -153,13 +163,65 @@ bool GraphicsImageDifferencePass::ReadResults()
         m_mseValues[ch] = float(ntc::DecodeImageDifferenceResult(results[ch]));
     }
 
-    m_device->unmapBuffer(m_stagingBuffer);
+    m_device->unmapBuffer(slot.stagingBuffer);
 
     m_resultsRead = true;
 
     return true;
 }
 
+bool GraphicsImageDifferencePass::ReadResults()
+{
+    // Mapping the staging buffer waits for the command list that wrote it
+    return ReadSlot(m_readbackSlots[m_currentSlot]);
+}
+
+uint32_t GraphicsImageDifferencePass::EndBatch()
+{
+    ReadbackSlot& slot = m_readbackSlots[m_currentSlot];
+    m_device->resetEventQuery(slot.eventQuery);
+    m_device->setEventQuery(slot.eventQuery, nvrhi::CommandQueue::Graphics);
+    slot.batchIndex = m_nextBatchIndex++;
+    slot.inFlight = true;
+
+    // Move to the next slot, waiting for its previous batch if necessary, so that new passes can overwrite it
+    m_currentSlot = (m_currentSlot + 1) % uint32_t(m_readbackSlots.size());
+    ReadbackSlot& nextSlot = m_readbackSlots[m_currentSlot];
+    if (nextSlot.inFlight)
+    {
+        m_device->waitEventQuery(nextSlot.eventQuery);
+        nextSlot.inFlight = false;
+    }
+
+    m_resultsRead = false;
+
+    return slot.batchIndex;
+}
+
+bool GraphicsImageDifferencePass::PollResults(uint32_t batchIndex, bool& outReady)
+{
+    outReady = false;
+
+    // Find the slot that holds this batch
+    for (ReadbackSlot& slot : m_readbackSlots)
+    {
+        if (batchIndex == InvalidBatchIndex || slot.batchIndex != batchIndex)
+            continue;
+
+        if (slot.inFlight && !m_device->pollEventQuery(slot.eventQuery))
+            return true;
+
+        slot.inFlight = false;
+        if (!ReadSlot(slot))
+            return false;
+
+        outReady = true;
+        return true;
+    }
+
+    return false;
+}
+
 bool GraphicsImageDifferencePass::GetQueryResult(uint32_t queryIndex, float outPerChannelMSE[4],
     float* outOverallMSE, float* outOverallPSNR, int channels, float maxSignalValue)
 {
@@ -0,0 +1,228 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/ImageProbe.h>
+#include <ntc-utils/DDSHeader.h>
+#include <ntc-utils/Manifest.h>
+#include <stb_image.h>
+#include <tinyexr.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+using namespace donut::engine::dds;
+
+size_t ImageFileInfo::GetDecodedSize() const
+{
+    size_t bytesPerComponent;
+    switch (format)
+    {
+        case ntc::ChannelFormat::UNORM16:
+        case ntc::ChannelFormat::FLOAT16:
+            bytesPerComponent = 2;
+            break;
+        case ntc::ChannelFormat::FLOAT32:
+        case ntc::ChannelFormat::UINT32:
+            bytesPerComponent = 4;
+            break;
+        default:
+            bytesPerComponent = 1;
+            break;
+    }
+
+    // All images are decoded with 4 components, see ReadImageFile(...) in the CLI tool
+    return size_t(width) * size_t(height) * 4 * bytesPerComponent;
+}
+
+size_t GetBlockCompressedMipSize(ntc::BlockCompressedFormat format, int width, int height)
+{
+    size_t const bytesPerBlock = (format == ntc::BlockCompressedFormat::BC1 ||
+        format == ntc::BlockCompressedFormat::BC4) ? 8 : 16;
+    size_t const widthBlocks = (size_t(std::max(width, 1)) + 3) / 4;
+    size_t const heightBlocks = (size_t(std::max(height, 1)) + 3) / 4;
+    return widthBlocks * heightBlocks * bytesPerBlock;
+}
+
+static ntc::BlockCompressedFormat GetFormatFromDxgi(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return ntc::BlockCompressedFormat::BC1;
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+            return ntc::BlockCompressedFormat::BC2;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return ntc::BlockCompressedFormat::BC3;
+        case DXGI_FORMAT_BC4_UNORM:
+            return ntc::BlockCompressedFormat::BC4;
+        case DXGI_FORMAT_BC5_UNORM:
+            return ntc::BlockCompressedFormat::BC5;
+        case DXGI_FORMAT_BC6H_UF16:
+            return ntc::BlockCompressedFormat::BC6;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return ntc::BlockCompressedFormat::BC7;
+        default:
+            // Signed and typeless formats are not supported
+            return ntc::BlockCompressedFormat::None;
+    }
+}
+
+static bool IsSrgbDxgiFormat(DXGI_FORMAT format)
+{
+    return format == DXGI_FORMAT_BC1_UNORM_SRGB || format == DXGI_FORMAT_BC2_UNORM_SRGB ||
+        format == DXGI_FORMAT_BC3_UNORM_SRGB || format == DXGI_FORMAT_BC7_UNORM_SRGB;
+}
+
+static ntc::BlockCompressedFormat GetFormatFromFourCC(uint32_t fourCC)
+{
+    if (fourCC == MAKEFOURCC('D', 'X', 'T', '1'))
+        return ntc::BlockCompressedFormat::BC1;
+    if (fourCC == MAKEFOURCC('D', 'X', 'T', '2') || fourCC == MAKEFOURCC('D', 'X', 'T', '3'))
+        return ntc::BlockCompressedFormat::BC2;
+    if (fourCC == MAKEFOURCC('D', 'X', 'T', '4') || fourCC == MAKEFOURCC('D', 'X', 'T', '5'))
+        return ntc::BlockCompressedFormat::BC3;
+    if (fourCC == MAKEFOURCC('A', 'T', 'I', '1') || fourCC == MAKEFOURCC('B', 'C', '4', 'U'))
+        return ntc::BlockCompressedFormat::BC4;
+    if (fourCC == MAKEFOURCC('A', 'T', 'I', '2') || fourCC == MAKEFOURCC('B', 'C', '5', 'U'))
+        return ntc::BlockCompressedFormat::BC5;
+    return ntc::BlockCompressedFormat::None;
+}
+
+static bool ProbeDDSFile(std::string const& fileName, ImageFileInfo& outInfo)
+{
+    FILE* ddsFile = fopen(fileName.c_str(), "rb");
+    if (!ddsFile)
+        return false;
+
+    uint32_t magic = 0;
+    DDS_HEADER header{};
+    DDS_HEADER_DXT10 dx10Header{};
+    bool success = fread(&magic, sizeof(magic), 1, ddsFile) == 1 &&
+        fread(&header, sizeof(header), 1, ddsFile) == 1 &&
+        magic == DDS_MAGIC && header.size == sizeof(DDS_HEADER) &&
+        (header.ddspf.flags & DDS_FOURCC) != 0;
+
+    bool const hasDx10Header = success && header.ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0');
+    if (hasDx10Header)
+        success = fread(&dx10Header, sizeof(dx10Header), 1, ddsFile) == 1;
+
+    fseek(ddsFile, 0, SEEK_END);
+    size_t const fileSize = size_t(ftell(ddsFile));
+    fclose(ddsFile);
+
+    if (!success)
+        return false;
+
+    // Cube maps, arrays and volume textures are not material textures
+    if ((header.caps2 & (DDS_CUBEMAP | DDS_FLAGS_VOLUME)) != 0)
+        return false;
+
+    if (hasDx10Header)
+    {
+        if (dx10Header.resourceDimension != DDS_DIMENSION_TEXTURE2D || dx10Header.arraySize != 1 ||
+            (dx10Header.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0)
+            return false;
+
+        outInfo.bcFormat = GetFormatFromDxgi(dx10Header.dxgiFormat);
+        outInfo.isSRGB = IsSrgbDxgiFormat(dx10Header.dxgiFormat);
+    }
+    else
+        outInfo.bcFormat = GetFormatFromFourCC(header.ddspf.fourCC);
+
+    if (outInfo.bcFormat == ntc::BlockCompressedFormat::None || header.width == 0 || header.height == 0)
+        return false;
+
+    outInfo.width = int(header.width);
+    outInfo.height = int(header.height);
+    outInfo.mips = (header.flags & DDS_HEADER_FLAGS_MIPMAP) != 0 ? std::max(int(header.mipMapCount), 1) : 1;
+    outInfo.dataOffset = sizeof(magic) + sizeof(header) + (hasDx10Header ? sizeof(dx10Header) : 0);
+
+    switch (outInfo.bcFormat)
+    {
+        case ntc::BlockCompressedFormat::BC1:
+            // BC1 always decodes with alpha, but most BC1 textures are opaque: only use the alpha channel
+            // when the legacy header says so, to avoid compressing a constant channel
+            outInfo.channels = (header.ddspf.flags & DDS_ALPHAPIXELS) != 0 ? 4 : 3;
+            break;
+        case ntc::BlockCompressedFormat::BC4:
+            outInfo.channels = 1;
+            break;
+        case ntc::BlockCompressedFormat::BC5:
+            outInfo.channels = 2;
+            break;
+        case ntc::BlockCompressedFormat::BC6:
+            outInfo.channels = 3;
+            break;
+        default:
+            outInfo.channels = 4;
+            break;
+    }
+    outInfo.format = outInfo.bcFormat == ntc::BlockCompressedFormat::BC6
+        ? ntc::ChannelFormat::FLOAT32
+        : ntc::ChannelFormat::UNORM8;
+
+    // Verify that the file contains all the MIP levels that the header promises
+    size_t dataSize = 0;
+    for (int mipLevel = 0; mipLevel < outInfo.mips; ++mipLevel)
+    {
+        dataSize += GetBlockCompressedMipSize(outInfo.bcFormat,
+            std::max(1, outInfo.width >> mipLevel), std::max(1, outInfo.height >> mipLevel));
+    }
+
+    return outInfo.dataOffset + dataSize <= fileSize;
+}
+
+bool ProbeImageFile(std::string const& fileName, ImageFileInfo& outInfo)
+{
+    std::string extension = fs::path(fileName).extension().generic_string();
+    LowercaseString(extension);
+
+    if (extension == ".dds")
+        return ProbeDDSFile(fileName, outInfo);
+
+    if (extension == ".exr")
+    {
+        // Only parse the header attributes, tinyexr doesn't touch the pixel data in this case
+        EXRVersion version;
+        EXRHeader header;
+        InitEXRHeader(&header);
+        bool const success = ParseEXRVersionFromFile(&version, fileName.c_str()) == TINYEXR_SUCCESS &&
+            ParseEXRHeaderFromFile(&header, &version, fileName.c_str(), nullptr) == TINYEXR_SUCCESS;
+        if (success)
+        {
+            outInfo.width = header.data_window.max_x - header.data_window.min_x + 1;
+            outInfo.height = header.data_window.max_y - header.data_window.min_y + 1;
+            outInfo.channels = 4;
+            outInfo.format = ntc::ChannelFormat::FLOAT32;
+        }
+        FreeEXRHeader(&header);
+        return success;
+    }
+
+    FILE* imageFile = fopen(fileName.c_str(), "rb");
+    if (!imageFile)
+        return false;
+
+    // stb_image reads just enough of the file to identify the format and decode the header
+    bool const is16bit = stbi_is_16_bit_from_file(imageFile);
+    fseek(imageFile, 0, SEEK_SET);
+    bool const success = stbi_info_from_file(imageFile, &outInfo.width, &outInfo.height, &outInfo.channels) != 0;
+    fclose(imageFile);
+
+    outInfo.format = is16bit ? ntc::ChannelFormat::UNORM16 : ntc::ChannelFormat::UNORM8;
+    return success;
+}
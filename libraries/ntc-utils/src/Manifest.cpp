@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -11,11 +11,17 @@
  */
 
 #include <ntc-utils/Manifest.h>
+#include <ntc-utils/Semantics.h>
 #include <filesystem>
 #include <json/json.h>
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -38,6 +44,11 @@ bool IsSupportedImageFileExtension(std::string const& extension)
            extension == ".exr";
 }
 
+bool IsDDSFileExtension(std::string const& extension)
+{
+    return extension == ".dds";
+}
+
 static void ComputeDistinctImageNames(Manifest& manifest)
 {
     std::string commonName;
@@ -77,19 +88,73 @@ static void ComputeDistinctImageNames(Manifest& manifest)
     }
 }
 
-void GenerateManifestFromDirectory(const char* path, bool loadMips, bool keepFileNames, Manifest& outManifest)
+// Lists the image files in a directory and, if 'loadMips' is true, in its 'mips' subdirectory.
+// When 'outSubdirectories' is not null, the other subdirectories are appended to it.
+static void ListDirectoryImages(fs::path const& path, bool loadMips, bool includeDDS, std::vector<fs::path>& outImages,
+    std::vector<fs::path>& outMipImages, std::vector<fs::path>* outSubdirectories)
 {
-    for (const fs::directory_entry& directoryEntry : fs::directory_iterator(path))
+    std::vector<fs::path> ddsImages;
+    std::error_code ec;
+    for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
     {
+        const fs::directory_entry& directoryEntry = *it;
         const fs::path& fileName = directoryEntry.path();
 
+        if (outSubdirectories)
+        {
+            // Don't follow symlinks to avoid loops in the directory tree
+            std::error_code typeEc;
+            if (directoryEntry.is_directory(typeEc) && !directoryEntry.is_symlink(typeEc))
+            {
+                if (!loadMips || fileName.filename() != "mips")
+                    outSubdirectories->push_back(fileName);
+                continue;
+            }
+        }
+
         // Get a lowercase file extension for case-insensitive comparison
         std::string extension = fileName.extension().generic_string();
         LowercaseString(extension);
 
-        if (!IsSupportedImageFileExtension(extension))
+        if (IsSupportedImageFileExtension(extension))
+            outImages.push_back(fileName);
+        else if (includeDDS && IsDDSFileExtension(extension))
+            ddsImages.push_back(fileName);
+    }
+
+    // Skip the DDS files that have the same name as another image, which is likely their source
+    for (fs::path const& ddsFileName : ddsImages)
+    {
+        fs::path const stem = ddsFileName.stem();
+        bool const hasSource = std::any_of(outImages.begin(), outImages.end(),
+            [&stem](fs::path const& fileName) { return fileName.stem() == stem; });
+        if (!hasSource)
+            outImages.push_back(ddsFileName);
+    }
+
+    if (!loadMips)
+        return;
+
+    for (fs::directory_iterator it(path / "mips", ec), end; !ec && it != end; it.increment(ec))
+    {
+        const fs::path& fileName = it->path();
+
+        // Get a lowercase file extension for case-insensitive comparison
+        std::string extension = fileName.extension().generic_string();
+        LowercaseString(extension);
+
+        if (extension != ".png" && extension != ".jpg" && extension != ".tga" && extension != ".exr")
             continue;
 
+        outMipImages.push_back(fileName);
+    }
+}
+
+static void AddDirectoryImagesToManifest(std::vector<fs::path> const& images, std::vector<fs::path> const& mipImages,
+    bool keepFileNames, Manifest& outManifest)
+{
+    for (const fs::path& fileName : images)
+    {
         ManifestEntry& entry = outManifest.textures.emplace_back();
         entry.fileName = fileName.generic_string();
         if (keepFileNames)
@@ -99,48 +164,161 @@ void GenerateManifestFromDirectory(const char* path, bool loadMips, bool keepFil
         entry.mipLevel = 0;
     }
 
-    if (loadMips)
+    for (const fs::path& fileName : mipImages)
     {
-        for (const fs::directory_entry& directoryEntry : fs::directory_iterator(fs::path(path) / "mips"))
-        {
-            const fs::path& fileName = directoryEntry.path();
+        // Parse the file name, assuming it follows this pattern: <name>.<mip>.<type>
+        fs::path mip = fileName.stem().extension();
+        fs::path name = fileName.stem().stem();
 
-            // Get a lowercase file extension for case-insensitive comparison
-            std::string extension = fileName.extension().generic_string();
-            LowercaseString(extension);
+        if (mip.empty() || name.empty())
+            continue;
 
-            if (extension != ".png" && extension != ".jpg" && extension != ".tga" && extension != ".exr")
-                continue;
+        auto found = std::find_if(outManifest.textures.begin(), outManifest.textures.end(),
+            [&name](const ManifestEntry& entry) { return entry.entryName == name; });
 
-            // Parse the file name, assuming it follows this pattern: <name>.<mip>.<type>
-            fs::path mip = fileName.stem().extension();
-            fs::path name = fileName.stem().stem();
+        if (found == outManifest.textures.end())
+            continue;
+        
+        int mipLevel = 0;
+        if (sscanf(mip.generic_string().c_str(), ".%d", &mipLevel) != 1)
+            continue;
 
-            if (mip.empty() || name.empty())
-                continue;
+        if (mipLevel >= NTC_MAX_MIPS)
+            continue;
+        
+        ManifestEntry& entry = outManifest.textures.emplace_back();
+        entry.fileName = fileName.generic_string();
+        entry.entryName = name.generic_string();
+        entry.mipLevel = mipLevel;
+    }
 
-            auto found = std::find_if(outManifest.textures.begin(), outManifest.textures.end(),
-                [&name](const ManifestEntry& entry) { return entry.entryName == name; });
+    if (!keepFileNames)
+        ComputeDistinctImageNames(outManifest);
+}
 
-            if (found == outManifest.textures.end())
-                continue;
-            
-            int mipLevel = 0;
-            if (sscanf(mip.generic_string().c_str(), ".%d", &mipLevel) != 1)
-                continue;
+void GenerateManifestFromDirectory(const char* path, bool loadMips, bool keepFileNames, bool includeDDS,
+    Manifest& outManifest)
+{
+    std::vector<fs::path> images;
+    std::vector<fs::path> mipImages;
+    ListDirectoryImages(path, loadMips, includeDDS, images, mipImages, nullptr);
+    AddDirectoryImagesToManifest(images, mipImages, keepFileNames, outManifest);
+}
 
-            if (mipLevel >= NTC_MAX_MIPS)
-                continue;
-            
-            ManifestEntry& entry = outManifest.textures.emplace_back();
-            entry.fileName = fileName.generic_string();
-            entry.entryName = name.generic_string();
-            entry.mipLevel = mipLevel;
+// Fills the dimensions, semantics and sRGB flags of a generated manifest from the mip 0 image headers
+static void FillManifestFromImageHeaders(ImageHeaderReader const& readHeader, Manifest& manifest)
+{
+    int width = 0;
+    int height = 0;
+    std::vector<SemanticBinding> semantics;
+    for (size_t index = 0; index < manifest.textures.size(); ++index)
+    {
+        ManifestEntry& entry = manifest.textures[index];
+        if (entry.mipLevel != 0)
+            continue;
+
+        ImageFileInfo info;
+        if (!readHeader(entry.fileName, info))
+            continue;
+
+        width = std::max(width, info.width);
+        height = std::max(height, info.height);
+
+        semantics.clear();
+        GuessImageSemantics(entry.entryName, info.channels, info.format, int(index), entry.isSRGB, semantics);
+
+        // The DDS format is more reliable than the guess
+        if (info.isSRGB.has_value())
+            entry.isSRGB = *info.isSRGB;
+        for (SemanticBinding const& binding : semantics)
+        {
+            ImageSemanticBinding& manifestBinding = entry.semantics.emplace_back();
+            manifestBinding.label = binding.label;
+            manifestBinding.firstChannel = binding.firstChannel;
         }
     }
 
-    if (!keepFileNames)
-        ComputeDistinctImageNames(outManifest);
+    if (width > 0 && height > 0)
+    {
+        manifest.width = width;
+        manifest.height = height;
+    }
+}
+
+bool GenerateManifestsFromDirectoryTree(const char* rootPath, bool loadMips, bool keepFileNames, bool includeDDS,
+    int numThreads, ImageHeaderReader const& readHeader, std::vector<DirectoryManifest>& outManifests, std::string& outError)
+{
+    fs::path const root = rootPath;
+    std::error_code ec;
+    if (!fs::is_directory(root, ec))
+    {
+        outError = "Directory '" + root.generic_string() + "' does not exist.";
+        return false;
+    }
+
+    if (numThreads <= 0)
+        numThreads = int(std::max(std::thread::hardware_concurrency(), 1u));
+
+    // The directories waiting to be scanned. Each thread takes one, appends its subdirectories to the queue,
+    // and generates the manifest for it. The scan is done when the queue is empty and no thread is busy.
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<fs::path> pendingDirectories = { root };
+    int busyThreads = 0;
+    std::vector<DirectoryManifest> manifests;
+
+    auto worker = [&]()
+    {
+        std::unique_lock lock(mutex);
+        while (true)
+        {
+            condition.wait(lock, [&]() { return !pendingDirectories.empty() || busyThreads == 0; });
+            if (pendingDirectories.empty())
+                return;
+
+            fs::path const directory = std::move(pendingDirectories.front());
+            pendingDirectories.pop_front();
+            ++busyThreads;
+            lock.unlock();
+
+            std::vector<fs::path> images;
+            std::vector<fs::path> mipImages;
+            std::vector<fs::path> subdirectories;
+            ListDirectoryImages(directory, loadMips, includeDDS, images, mipImages, &subdirectories);
+
+            DirectoryManifest result;
+            if (!images.empty())
+            {
+                result.relativePath = directory.lexically_relative(root).generic_string();
+                AddDirectoryImagesToManifest(images, mipImages, keepFileNames, result.manifest);
+                if (readHeader)
+                    FillManifestFromImageHeaders(readHeader, result.manifest);
+            }
+
+            lock.lock();
+            for (fs::path& subdirectory : subdirectories)
+                pendingDirectories.push_back(std::move(subdirectory));
+            if (!images.empty())
+                manifests.push_back(std::move(result));
+            --busyThreads;
+            condition.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < numThreads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads)
+        thread.join();
+
+    std::sort(manifests.begin(), manifests.end(), [](DirectoryManifest const& a, DirectoryManifest const& b)
+    {
+        return a.relativePath < b.relativePath;
+    });
+
+    outManifests = std::move(manifests);
+    return true;
 }
 
 void GenerateManifestFromFileList(std::vector<const char *> const &files, bool keepFileNames, Manifest &outManifest)
@@ -512,6 +690,145 @@ bool ReadManifestFromFile(const char* fileName, Manifest& outManifest, std::stri
     return ParseManifest(fileContents.data(), fileContents.size(), fileName, outManifest, outError);
 }
 
+static bool ParseBatchJobNode(Json::Value const& job, BatchJob& outJob)
+{
+    if (!job.isObject() || !job["args"].isArray() || job["args"].empty())
+        return false;
+
+    for (Json::Value const& arg : job["args"])
+    {
+        if (!arg.isString())
+            return false;
+        outJob.args.push_back(arg.asString());
+    }
+
+    return true;
+}
+
+bool ReadBatchFile(const char* fileName, std::vector<BatchJob>& outJobs, std::string& outError)
+{
+    FILE* inputFile = fopen(fileName, "rb");
+    if (!inputFile)
+    {
+        std::ostringstream oss;
+        oss << "Cannot open batch file '" << fileName << "': " << strerror(errno);
+        outError = oss.str();
+        return false;
+    }
+
+    std::vector<char> fileContents;
+    bool success = ReadFileIntoVector(inputFile, fileContents);
+    fclose(inputFile);
+    
+    if (!success)
+    {
+        std::ostringstream oss;
+        oss << "Error while reading batch file '" << fileName << "': " << strerror(errno);
+        outError = oss.str();
+        return false;
+    }
+
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+    Json::Value root;
+    Json::String errorMessages;
+    if (!reader->parse(fileContents.data(), fileContents.data() + fileContents.size(), &root, &errorMessages))
+    {
+        std::ostringstream oss;
+        oss << "Cannot parse batch file '" << fileName << "': " << errorMessages;
+        outError = oss.str();
+        return false;
+    }
+
+    Json::Value const& jobs = root.isObject() ? root["jobs"] : Json::Value();
+    if (!jobs.isArray() || jobs.empty())
+    {
+        outError = "Malformed batch file: must contain a non-empty 'jobs' array.";
+        return false;
+    }
+
+    outJobs.clear();
+    for (Json::Value const& job : jobs)
+    {
+        BatchJob& outJob = outJobs.emplace_back();
+        if (!ParseBatchJobNode(job, outJob))
+        {
+            std::ostringstream oss;
+            oss << "Malformed batch file: job " << outJobs.size() << " must be an object with a "
+                "non-empty 'args' array of strings.";
+            outError = oss.str();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ParseBatchJob(std::string const& json, BatchJob& outJob, std::string& outError)
+{
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+    Json::Value root;
+    Json::String errorMessages;
+    if (!reader->parse(json.data(), json.data() + json.size(), &root, &errorMessages))
+    {
+        outError = "Cannot parse job: " + errorMessages;
+        return false;
+    }
+
+    outJob = BatchJob();
+    if (!ParseBatchJobNode(root, outJob))
+    {
+        outError = "Malformed job: must be an object with a non-empty 'args' array of strings.";
+        return false;
+    }
+
+    return true;
+}
+
+bool WriteBatchFile(const char* fileName, std::vector<BatchJob> const& jobs, std::string& outError)
+{
+    Json::Value jobsNode(Json::arrayValue);
+    for (BatchJob const& job : jobs)
+    {
+        Json::Value args(Json::arrayValue);
+        for (std::string const& arg : job.args)
+            args.append(arg);
+
+        Json::Value jobNode;
+        jobNode["args"] = args;
+        jobsNode.append(jobNode);
+    }
+
+    Json::Value root;
+    root["jobs"] = jobsNode;
+
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "  ";
+    std::unique_ptr<Json::StreamWriter> writer(writerBuilder.newStreamWriter());
+
+    std::ofstream ofs(fileName, std::ios::out | std::ios::trunc);
+    if (!ofs)
+    {
+        std::ostringstream oss;
+        oss << "Cannot open batch file '" << fileName << "' for writing: " << strerror(errno);
+        outError = oss.str();
+        return false;
+    }
+
+    if (writer->write(root, &ofs) != 0)
+    {
+        outError = "Failed to write batch JSON to file.";
+        return false;
+    }
+
+    return true;
+}
+
 bool ReadManifestFromStdin(Manifest& outManifest, std::string& outError)
 {
     std::stringstream ss;
@@ -0,0 +1,291 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/NtcPackage.h>
+#include <libntc/ntc.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+    return (offset + c_ntcPackageAlignment - 1) & ~(c_ntcPackageAlignment - 1);
+}
+
+// Extends the range to include [offset, offset + size)
+static void ExtendRange(NtcPackageRange& range, uint64_t offset, uint64_t size)
+{
+    if (size == 0)
+        return;
+
+    if (range.size == 0)
+    {
+        range.offset = offset;
+        range.size = size;
+        return;
+    }
+
+    uint64_t const begin = std::min(range.offset, offset);
+    uint64_t const end = std::max(range.offset + range.size, offset + size);
+    range.offset = begin;
+    range.size = end - begin;
+}
+
+// Parses the texture set metadata to find the ranges of its latents and BC7 mode buffers
+static bool FillEntryRanges(ntc::IContext* context, std::vector<uint8_t> const& data, NtcPackageEntry& entry,
+    std::string& outError)
+{
+    ntc::MemoryStreamWrapper stream(context);
+    ntc::Status ntcStatus = context->OpenReadOnlyMemory(data.data(), data.size(), stream.ptr());
+    if (ntcStatus == ntc::Status::Ok)
+    {
+        ntc::TextureSetMetadataWrapper textureSetMetadata(context);
+        ntcStatus = context->CreateTextureSetMetadataFromStream(stream, textureSetMetadata.ptr());
+        if (ntcStatus == ntc::Status::Ok)
+        {
+            ntc::ITextureSetMetadata* metadata = textureSetMetadata;
+
+            ntc::LatentTextureDesc const latentTextureDesc = metadata->GetLatentTextureDesc();
+            for (int mipLevel = 0; mipLevel < latentTextureDesc.mipLevels; ++mipLevel)
+            {
+                for (int layerIndex = 0; layerIndex < latentTextureDesc.arraySize; ++layerIndex)
+                {
+                    ntc::LatentTextureFootprint footprint;
+                    if (metadata->GetLatentTextureFootprint(mipLevel, layerIndex, footprint) == ntc::Status::Ok)
+                    {
+                        ExtendRange(entry.latentsRange, uint64_t(footprint.buffer.rangeInStream.offset),
+                            uint64_t(footprint.buffer.rangeInStream.size));
+                    }
+                }
+            }
+
+            int const mips = metadata->GetDesc().mips;
+            for (int textureIndex = 0; textureIndex < metadata->GetTextureCount(); ++textureIndex)
+            {
+                ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(textureIndex);
+                for (int mipLevel = 0; mipLevel < mips; ++mipLevel)
+                {
+                    ntc::BufferFootprint const footprint = textureMetadata->GetBC7ModeBufferFootprint(mipLevel);
+                    if (footprint.uncompressedSize != 0)
+                    {
+                        ExtendRange(entry.bc7ModeRange, uint64_t(footprint.rangeInStream.offset),
+                            uint64_t(footprint.rangeInStream.size));
+                    }
+                }
+            }
+
+            return true;
+        }
+    }
+
+    std::stringstream ss;
+    ss << "cannot parse the texture set, error code = " << ntc::StatusToString(ntcStatus) << ": "
+        << ntc::GetLastErrorMessage();
+    outError = ss.str();
+    return false;
+}
+
+bool WriteNtcPackage(ntc::IContext* context, const char* fileName, std::vector<NtcPackageInput> const& inputs,
+    std::string& outError)
+{
+    std::vector<NtcPackageEntry> entries(inputs.size());
+    std::string names;
+    std::unordered_map<std::string, size_t> entryIndices;
+
+    NtcPackageHeader header{};
+    memcpy(header.magic, c_ntcPackageMagic, sizeof(header.magic));
+    header.version = c_ntcPackageVersion;
+    header.entryCount = uint32_t(inputs.size());
+    header.namesOffset = sizeof(NtcPackageHeader) + sizeof(NtcPackageEntry) * inputs.size();
+
+    // Lay out the entries before writing anything, the table of contents precedes the data
+    for (size_t index = 0; index < inputs.size(); ++index)
+    {
+        NtcPackageInput const& input = inputs[index];
+        if (!entryIndices.try_emplace(input.name, index).second)
+        {
+            outError = "Duplicate package entry name '" + input.name + "'.";
+            return false;
+        }
+
+        std::error_code ec;
+        uintmax_t const fileSize = fs::file_size(input.fileName, ec);
+        if (ec)
+        {
+            outError = "Cannot access '" + input.fileName + "': " + ec.message();
+            return false;
+        }
+
+        NtcPackageEntry& entry = entries[index];
+        entry.dataSize = uint64_t(fileSize);
+        entry.nameOffset = uint64_t(names.size());
+        entry.nameSize = uint64_t(input.name.size());
+        names += input.name;
+    }
+
+    header.namesSize = uint64_t(names.size());
+
+    uint64_t dataEnd = header.namesOffset + header.namesSize;
+    uint64_t dataOffset = AlignOffset(dataEnd);
+    for (NtcPackageEntry& entry : entries)
+    {
+        entry.dataOffset = dataOffset;
+        dataEnd = dataOffset + entry.dataSize;
+        dataOffset = AlignOffset(dataEnd);
+    }
+
+    std::ofstream outputFile(fileName, std::ios::binary);
+    if (!outputFile.is_open())
+    {
+        outError = std::string("Cannot open '") + fileName + "' for writing.";
+        return false;
+    }
+
+    // Write the entries one at a time, so that only one texture set is in memory
+    std::vector<uint8_t> data;
+    for (size_t index = 0; index < inputs.size(); ++index)
+    {
+        NtcPackageInput const& input = inputs[index];
+        NtcPackageEntry& entry = entries[index];
+
+        data.resize(size_t(entry.dataSize));
+        std::ifstream inputFile(input.fileName, std::ios::binary);
+        if (!inputFile.is_open() || !inputFile.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size())))
+        {
+            outError = "Cannot read '" + input.fileName + "'.";
+            return false;
+        }
+
+        std::string rangeError;
+        if (!FillEntryRanges(context, data, entry, rangeError))
+        {
+            outError = "Cannot add '" + input.fileName + "' to the package, " + rangeError;
+            return false;
+        }
+
+        outputFile.seekp(std::streamoff(entry.dataOffset));
+        outputFile.write(reinterpret_cast<char const*>(data.data()), std::streamsize(data.size()));
+    }
+
+    // Pad the last entry, so that aligned reads of it don't go past the end of the file.
+    // If the data already ends on an alignment boundary, the last byte written is entry data.
+    if (dataOffset > dataEnd)
+    {
+        outputFile.seekp(std::streamoff(dataOffset - 1));
+        outputFile.put(0);
+    }
+
+    outputFile.seekp(0);
+    outputFile.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    outputFile.write(reinterpret_cast<char const*>(entries.data()), std::streamsize(sizeof(NtcPackageEntry) * entries.size()));
+    outputFile.write(names.data(), std::streamsize(names.size()));
+
+    if (!outputFile.good())
+    {
+        outError = std::string("Failed to write '") + fileName + "'.";
+        return false;
+    }
+
+    return true;
+}
+
+bool NtcPackage::Open(const char* fileName, std::string& outError)
+{
+    m_fileName.clear();
+    m_entries.clear();
+    m_entryIndices.clear();
+
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        outError = std::string("Cannot open '") + fileName + "'.";
+        return false;
+    }
+
+    uint64_t const fileSize = uint64_t(file.tellg());
+    file.seekg(0);
+
+    NtcPackageHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        memcmp(header.magic, c_ntcPackageMagic, sizeof(header.magic)) != 0)
+    {
+        outError = std::string("'") + fileName + "' is not an NTC package file.";
+        return false;
+    }
+
+    if (header.version != c_ntcPackageVersion)
+    {
+        outError = std::string("'") + fileName + "' has unsupported package version " + std::to_string(header.version) + ".";
+        return false;
+    }
+
+    uint64_t const tocSize = sizeof(NtcPackageEntry) * uint64_t(header.entryCount);
+    if (header.namesOffset < sizeof(header) + tocSize || header.namesOffset + header.namesSize > fileSize)
+    {
+        outError = std::string("'") + fileName + "' has an invalid table of contents.";
+        return false;
+    }
+
+    std::vector<NtcPackageEntry> entries(header.entryCount);
+    std::string names(size_t(header.namesSize), '\0');
+    file.read(reinterpret_cast<char*>(entries.data()), std::streamsize(tocSize));
+    file.seekg(std::streamoff(header.namesOffset));
+    file.read(names.data(), std::streamsize(names.size()));
+    if (!file.good())
+    {
+        outError = std::string("Cannot read the table of contents of '") + fileName + "'.";
+        return false;
+    }
+
+    for (size_t index = 0; index < entries.size(); ++index)
+    {
+        NtcPackageEntry const& entry = entries[index];
+        if (entry.dataOffset + entry.dataSize > fileSize || entry.nameOffset + entry.nameSize > header.namesSize ||
+            entry.latentsRange.offset + entry.latentsRange.size > entry.dataSize ||
+            entry.bc7ModeRange.offset + entry.bc7ModeRange.size > entry.dataSize)
+        {
+            outError = std::string("'") + fileName + "' has an invalid entry " + std::to_string(index) + ".";
+            return false;
+        }
+
+        m_entryIndices[names.substr(size_t(entry.nameOffset), size_t(entry.nameSize))] = index;
+    }
+
+    m_fileName = fileName;
+    m_entries = std::move(entries);
+    return true;
+}
+
+NtcPackageEntry const* NtcPackage::FindEntry(std::string const& name) const
+{
+    auto it = m_entryIndices.find(name);
+    return (it != m_entryIndices.end()) ? &m_entries[it->second] : nullptr;
+}
+
+bool NtcPackage::ReadEntry(NtcPackageEntry const& entry, std::vector<uint8_t>& outData, std::string& outError) const
+{
+    // Use a separate file object for every read, so that multiple threads can read entries at the same time
+    std::ifstream file(m_fileName, std::ios::binary);
+    outData.resize(size_t(entry.dataSize));
+    if (!file.is_open() || !file.seekg(std::streamoff(entry.dataOffset)) ||
+        !file.read(reinterpret_cast<char*>(outData.data()), std::streamsize(outData.size())))
+    {
+        outError = "Cannot read an entry from '" + m_fileName + "'.";
+        return false;
+    }
+
+    return true;
+}
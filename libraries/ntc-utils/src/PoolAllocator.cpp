@@ -0,0 +1,275 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include <ntc-utils/PoolAllocator.h>
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+// Size classes are powers of 2 from c_minBlockSize to c_maxBlockSize, larger allocations use the system heap.
+// The minimum size matches the alignment guaranteed by malloc on 64-bit platforms.
+static const size_t c_minBlockSize = 16;
+static const size_t c_maxBlockSize = 16384;
+static const uint32_t c_sizeClassCount = 11;
+static_assert((c_minBlockSize << (c_sizeClassCount - 1)) == c_maxBlockSize);
+
+// Size of the chunks that blocks are carved from, holds 16 of the largest blocks
+static const size_t c_chunkSize = 256 * 1024;
+
+static uint32_t GetSizeClass(size_t size)
+{
+    uint32_t sizeClass = 0;
+    while ((c_minBlockSize << sizeClass) < size)
+        ++sizeClass;
+    return sizeClass;
+}
+
+PoolAllocator::~PoolAllocator()
+{
+    // Live allocations are leaks by the library, they are reported by the caller through GetBytesAllocated
+    for (auto const& [address, chunk] : m_chunks)
+    {
+        free(chunk->data);
+        delete chunk;
+    }
+}
+
+AllocatorPhaseStats& PoolAllocator::CurrentPhase()
+{
+    if (m_phases.empty())
+        m_phases.emplace_back().name = "Other";
+
+    return m_phases[m_phaseStack.empty() ? 0 : m_phaseStack.back()];
+}
+
+void PoolAllocator::UpdatePeaks()
+{
+    CurrentPhase().peakBytesInUse = std::max(CurrentPhase().peakBytesInUse, m_bytesInUse);
+    for (size_t phaseIndex : m_phaseStack)
+        m_phases[phaseIndex].peakBytesInUse = std::max(m_phases[phaseIndex].peakBytesInUse, m_bytesInUse);
+}
+
+PoolAllocator::Chunk* PoolAllocator::CreateChunk(uint32_t sizeClass)
+{
+    uint8_t* data = static_cast<uint8_t*>(malloc(c_chunkSize));
+    if (!data)
+        return nullptr;
+
+    Chunk* chunk = new Chunk();
+    chunk->data = data;
+    chunk->sizeClass = sizeClass;
+    chunk->blockSize = uint32_t(c_minBlockSize << sizeClass);
+    chunk->blockCount = uint32_t(c_chunkSize / chunk->blockSize);
+    m_chunks[uintptr_t(data)] = chunk;
+    m_bytesReserved += c_chunkSize;
+    return chunk;
+}
+
+void PoolAllocator::ReleaseChunk(Chunk* chunk)
+{
+    assert(chunk->liveBlocks == 0);
+    m_chunks.erase(uintptr_t(chunk->data));
+    m_bytesReserved -= c_chunkSize;
+    free(chunk->data);
+    delete chunk;
+}
+
+void* PoolAllocator::Allocate(size_t size)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    AllocatorPhaseStats& phase = CurrentPhase();
+    void* ptr = nullptr;
+
+    if (size > c_maxBlockSize)
+    {
+        ptr = malloc(size);
+        if (ptr)
+            m_bytesReserved += size;
+    }
+    else
+    {
+        uint32_t const sizeClass = GetSizeClass(size);
+        if (m_partialChunks.empty())
+            m_partialChunks.resize(c_sizeClassCount);
+        std::vector<Chunk*>& partialChunks = m_partialChunks[sizeClass];
+
+        if (partialChunks.empty())
+        {
+            Chunk* chunk = CreateChunk(sizeClass);
+            if (!chunk)
+                return nullptr;
+            chunk->inPartialList = true;
+            partialChunks.push_back(chunk);
+        }
+
+        Chunk* chunk = partialChunks.back();
+        if (chunk->freeList)
+        {
+            ptr = chunk->freeList;
+            chunk->freeList = *static_cast<void**>(ptr);
+        }
+        else
+        {
+            assert(chunk->bumpIndex < chunk->blockCount);
+            ptr = chunk->data + size_t(chunk->bumpIndex) * chunk->blockSize;
+            ++chunk->bumpIndex;
+        }
+
+        ++chunk->liveBlocks;
+        if (chunk->liveBlocks == chunk->blockCount)
+        {
+            partialChunks.pop_back();
+            chunk->inPartialList = false;
+        }
+    }
+
+    if (!ptr)
+        return nullptr;
+
+    m_bytesInUse += int64_t(size);
+    ++phase.allocationCount;
+    phase.bytesAllocated += size;
+    UpdatePeaks();
+
+    return ptr;
+}
+
+void PoolAllocator::Deallocate(void* ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    std::lock_guard lockGuard(m_mutex);
+
+    ++CurrentPhase().deallocationCount;
+    m_bytesInUse -= int64_t(size);
+
+    if (size > c_maxBlockSize)
+    {
+        m_bytesReserved -= size;
+        free(ptr);
+        return;
+    }
+
+    // Find the chunk that contains the block: the last one starting at or before it
+    auto it = m_chunks.upper_bound(uintptr_t(ptr));
+    assert(it != m_chunks.begin());
+    --it;
+    Chunk* chunk = it->second;
+    assert(uintptr_t(ptr) < uintptr_t(chunk->data) + c_chunkSize);
+    assert(chunk->sizeClass == GetSizeClass(size));
+
+    *static_cast<void**>(ptr) = chunk->freeList;
+    chunk->freeList = ptr;
+    --chunk->liveBlocks;
+
+    if (!chunk->inPartialList)
+    {
+        m_partialChunks[chunk->sizeClass].push_back(chunk);
+        chunk->inPartialList = true;
+    }
+}
+
+size_t PoolAllocator::TrimLocked()
+{
+    size_t bytesReleased = 0;
+    for (std::vector<Chunk*>& partialChunks : m_partialChunks)
+    {
+        auto newEnd = std::remove_if(partialChunks.begin(), partialChunks.end(), [this, &bytesReleased](Chunk* chunk)
+        {
+            if (chunk->liveBlocks != 0)
+                return false;
+
+            ReleaseChunk(chunk);
+            bytesReleased += c_chunkSize;
+            return true;
+        });
+        partialChunks.erase(newEnd, partialChunks.end());
+    }
+    return bytesReleased;
+}
+
+size_t PoolAllocator::Trim()
+{
+    std::lock_guard lockGuard(m_mutex);
+    return TrimLocked();
+}
+
+void PoolAllocator::BeginPhase(char const* name)
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    CurrentPhase(); // Make sure that "Other" is the first phase
+
+    auto it = std::find_if(m_phases.begin(), m_phases.end(),
+        [name](AllocatorPhaseStats const& phase) { return phase.name == name; });
+    if (it == m_phases.end())
+    {
+        it = m_phases.emplace(m_phases.end());
+        it->name = name;
+    }
+
+    m_phaseStack.push_back(size_t(it - m_phases.begin()));
+    UpdatePeaks();
+}
+
+void PoolAllocator::EndPhase()
+{
+    std::lock_guard lockGuard(m_mutex);
+
+    assert(!m_phaseStack.empty());
+    if (m_phaseStack.empty())
+        return;
+
+    // The memory freed by the phase goes back to the system, except for the chunks that are still partially used
+    CurrentPhase().bytesReleased += TrimLocked();
+    m_phaseStack.pop_back();
+}
+
+int64_t PoolAllocator::GetBytesAllocated() const
+{
+    std::lock_guard lockGuard(m_mutex);
+    return m_bytesInUse;
+}
+
+size_t PoolAllocator::GetBytesReserved() const
+{
+    std::lock_guard lockGuard(m_mutex);
+    return m_bytesReserved;
+}
+
+std::vector<AllocatorPhaseStats> PoolAllocator::GetPhaseStats() const
+{
+    std::lock_guard lockGuard(m_mutex);
+    return m_phases;
+}
+
+void PoolAllocator::PrintPhaseStats() const
+{
+    std::vector<AllocatorPhaseStats> const phases = GetPhaseStats();
+
+    printf("Library memory usage by phase:\n");
+    printf("  %-16s %12s %12s %12s %12s %12s\n", "Phase", "Allocations", "Frees", "Allocated MB", "Peak MB",
+        "Released MB");
+    for (AllocatorPhaseStats const& phase : phases)
+    {
+        if (phase.allocationCount == 0 && phase.deallocationCount == 0)
+            continue;
+
+        printf("  %-16s %12" PRIu64 " %12" PRIu64 " %12.2f %12.2f %12.2f\n", phase.name.c_str(),
+            phase.allocationCount, phase.deallocationCount, double(phase.bytesAllocated) * 0x1p-20,
+            double(phase.peakBytesInUse) * 0x1p-20, double(phase.bytesReleased) * 0x1p-20);
+    }
+}
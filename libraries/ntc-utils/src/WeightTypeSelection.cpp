@@ -0,0 +1,356 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#if NTC_WITH_DX12
+#include <directx/d3d12.h>
+#include <dxgi1_4.h>
+#endif
+
+#include <ntc-utils/WeightTypeSelection.h>
+#include <ntc-utils/GraphicsDecompressionPass.h>
+#include <donut/app/ApplicationBase.h>
+#include <json/json.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#if NTC_WITH_VULKAN
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+#include <vulkan/vulkan.hpp>
+#endif
+
+bool GetAdapterIdentity(nvrhi::IDevice* device, AdapterIdentity& outIdentity)
+{
+    char driverVersion[32];
+
+#if NTC_WITH_DX12
+    if (device->getGraphicsAPI() == nvrhi::GraphicsAPI::D3D12)
+    {
+        ID3D12Device* d3dDevice = device->getNativeObject(nvrhi::ObjectTypes::D3D12_Device);
+        if (!d3dDevice)
+            return false;
+
+        nvrhi::RefCountPtr<IDXGIFactory4> factory;
+        if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory))))
+            return false;
+
+        nvrhi::RefCountPtr<IDXGIAdapter3> adapter;
+        if (FAILED(factory->EnumAdapterByLuid(d3dDevice->GetAdapterLuid(), IID_PPV_ARGS(&adapter))))
+            return false;
+
+        DXGI_ADAPTER_DESC adapterDesc{};
+        LARGE_INTEGER umdVersion{};
+        if (FAILED(adapter->GetDesc(&adapterDesc)) ||
+            FAILED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umdVersion)))
+            return false;
+
+        char adapterName[256];
+        WideCharToMultiByte(CP_UTF8, 0, adapterDesc.Description, -1, adapterName, sizeof(adapterName),
+            nullptr, nullptr);
+
+        snprintf(driverVersion, sizeof(driverVersion), "%u.%u.%u.%u",
+            HIWORD(umdVersion.HighPart), LOWORD(umdVersion.HighPart),
+            HIWORD(umdVersion.LowPart), LOWORD(umdVersion.LowPart));
+
+        outIdentity.graphicsApi = "D3D12";
+        outIdentity.adapterName = adapterName;
+        outIdentity.driverVersion = driverVersion;
+        return true;
+    }
+#endif
+#if NTC_WITH_VULKAN
+    if (device->getGraphicsAPI() == nvrhi::GraphicsAPI::VULKAN)
+    {
+        VkPhysicalDevice vkPhysicalDevice = device->getNativeObject(nvrhi::ObjectTypes::VK_PhysicalDevice);
+        if (!vkPhysicalDevice)
+            return false;
+
+        vk::PhysicalDeviceProperties const properties = vk::PhysicalDevice(vkPhysicalDevice).getProperties();
+
+        // NVIDIA drivers use their own version encoding, the others follow the Vulkan API version format
+        uint32_t const version = properties.driverVersion;
+        if (properties.vendorID == 0x10de)
+            snprintf(driverVersion, sizeof(driverVersion), "%u.%u", (version >> 22) & 0x3ff, (version >> 14) & 0xff);
+        else
+            snprintf(driverVersion, sizeof(driverVersion), "%u.%u.%u", VK_API_VERSION_MAJOR(version),
+                VK_API_VERSION_MINOR(version), VK_API_VERSION_PATCH(version));
+
+        outIdentity.graphicsApi = "Vulkan";
+        outIdentity.adapterName = properties.deviceName.data();
+        outIdentity.driverVersion = driverVersion;
+        return true;
+    }
+#endif
+
+    return false;
+}
+
+char const* GetWeightTypeCacheName(ntc::InferenceWeightType weightType)
+{
+    switch (weightType)
+    {
+    case ntc::InferenceWeightType::GenericInt8:
+        return "GenericInt8";
+    case ntc::InferenceWeightType::GenericFP8:
+        return "GenericFP8";
+    case ntc::InferenceWeightType::CoopVecFP8:
+        return "CoopVecFP8";
+    default:
+        return nullptr;
+    }
+}
+
+bool WeightTypeCache::Load(std::filesystem::path const& fileName, std::string& outError)
+{
+    m_entries.clear();
+
+    std::ifstream ifs(fileName, std::ios::in | std::ios::binary);
+    if (!ifs)
+        return true;
+
+    Json::CharReaderBuilder builder;
+    builder["collectComments"] = false;
+
+    Json::Value root;
+    Json::String errorMessages;
+    if (!Json::parseFromStream(builder, ifs, &root, &errorMessages))
+    {
+        outError = "Cannot parse weight type cache '" + fileName.generic_string() + "': " + errorMessages;
+        return false;
+    }
+
+    Json::Value const& adapters = root.isObject() ? root["adapters"] : Json::Value();
+    for (Json::Value const& adapterNode : adapters)
+    {
+        if (!adapterNode.isObject())
+            continue;
+
+        Entry entry;
+        entry.identity.graphicsApi = adapterNode["graphicsApi"].asString();
+        entry.identity.adapterName = adapterNode["adapter"].asString();
+        entry.identity.driverVersion = adapterNode["driver"].asString();
+
+        Json::Value const& timingsNode = adapterNode["timings"];
+        for (size_t type = 0; type < entry.timings.size(); ++type)
+        {
+            char const* name = GetWeightTypeCacheName(ntc::InferenceWeightType(type));
+            if (name && timingsNode.isObject() && timingsNode[name].isNumeric())
+                entry.timings[type] = timingsNode[name].asFloat();
+        }
+
+        m_entries.push_back(entry);
+    }
+
+    return true;
+}
+
+bool WeightTypeCache::Save(std::filesystem::path const& fileName, std::string& outError) const
+{
+    Json::Value adapters(Json::arrayValue);
+    for (Entry const& entry : m_entries)
+    {
+        Json::Value adapterNode;
+        adapterNode["graphicsApi"] = entry.identity.graphicsApi;
+        adapterNode["adapter"] = entry.identity.adapterName;
+        adapterNode["driver"] = entry.identity.driverVersion;
+
+        Json::Value timingsNode(Json::objectValue);
+        for (size_t type = 0; type < entry.timings.size(); ++type)
+        {
+            char const* name = GetWeightTypeCacheName(ntc::InferenceWeightType(type));
+            if (name && entry.timings[type] > 0.f)
+                timingsNode[name] = entry.timings[type];
+        }
+        adapterNode["timings"] = timingsNode;
+
+        adapters.append(adapterNode);
+    }
+
+    Json::Value root;
+    root["adapters"] = adapters;
+
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "  ";
+    std::unique_ptr<Json::StreamWriter> writer(writerBuilder.newStreamWriter());
+
+    std::ofstream ofs(fileName, std::ios::out | std::ios::trunc);
+    if (!ofs)
+    {
+        std::ostringstream oss;
+        oss << "Cannot open weight type cache '" << fileName.generic_string() << "' for writing: " << strerror(errno);
+        outError = oss.str();
+        return false;
+    }
+
+    if (writer->write(root, &ofs) != 0)
+    {
+        outError = "Failed to write weight type cache JSON to file.";
+        return false;
+    }
+
+    return true;
+}
+
+bool WeightTypeCache::Find(AdapterIdentity const& identity, WeightTypeTimings& outTimings) const
+{
+    for (Entry const& entry : m_entries)
+    {
+        if (entry.identity == identity)
+        {
+            outTimings = entry.timings;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WeightTypeCache::Store(AdapterIdentity const& identity, WeightTypeTimings const& timings)
+{
+    for (Entry& entry : m_entries)
+    {
+        if (entry.identity == identity)
+        {
+            entry.timings = timings;
+            return;
+        }
+    }
+
+    Entry& entry = m_entries.emplace_back();
+    entry.identity = identity;
+    entry.timings = timings;
+}
+
+std::filesystem::path GetDefaultWeightTypeCachePath()
+{
+    return donut::app::GetDirectoryWithExecutable() / "ntc-weight-types.json";
+}
+
+bool HasTimingsForWeightTypes(WeightTypeTimings const& timings, ntc::ITextureSetMetadata* textureSetMetadata,
+    std::vector<ntc::InferenceWeightType> const& candidates)
+{
+    for (ntc::InferenceWeightType weightType : candidates)
+    {
+        if (textureSetMetadata->IsInferenceWeightTypeSupported(weightType) && timings[size_t(weightType)] <= 0.f)
+            return false;
+    }
+    return true;
+}
+
+ntc::InferenceWeightType SelectFastestWeightType(WeightTypeTimings const& timings,
+    ntc::ITextureSetMetadata* textureSetMetadata, std::vector<ntc::InferenceWeightType> const& candidates)
+{
+    ntc::InferenceWeightType bestWeightType = ntc::InferenceWeightType::Unknown;
+    float bestTime = 0.f;
+    for (ntc::InferenceWeightType weightType : candidates)
+    {
+        float const time = timings[size_t(weightType)];
+        if (time <= 0.f || !textureSetMetadata->IsInferenceWeightTypeSupported(weightType))
+            continue;
+
+        if (bestWeightType == ntc::InferenceWeightType::Unknown || time < bestTime)
+        {
+            bestWeightType = weightType;
+            bestTime = time;
+        }
+    }
+    return bestWeightType;
+}
+
+bool BenchmarkWeightTypes(nvrhi::IDevice* device, ntc::IContext* context, GraphicsDecompressionPass& pass,
+    ntc::ITextureSetMetadata* textureSetMetadata, int mipLevel, int firstLatentMipInTexture,
+    std::vector<ntc::InferenceWeightType> const& candidates, int numIterations, WeightTypeTimings& outTimings)
+{
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+
+    // All textures are written into the same scratch texture, the output is discarded
+    nvrhi::TextureDesc scratchTextureDesc = nvrhi::TextureDesc()
+        .setDimension(nvrhi::TextureDimension::Texture2D)
+        .setWidth(std::max(textureSetDesc.width >> mipLevel, 1))
+        .setHeight(std::max(textureSetDesc.height >> mipLevel, 1))
+        .setFormat(nvrhi::Format::RGBA8_UNORM)
+        .setDebugName("Weight type benchmark output")
+        .setIsUAV(true)
+        .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+        .setKeepInitialState(true);
+    nvrhi::TextureHandle scratchTexture = device->createTexture(scratchTextureDesc);
+    nvrhi::CommandListHandle commandList = device->createCommandList();
+    nvrhi::TimerQueryHandle timerQuery = device->createTimerQuery();
+    if (!scratchTexture || !commandList || !timerQuery)
+        return false;
+
+    pass.WriteDescriptor(nvrhi::BindingSetItem::Texture_UAV(0, scratchTexture));
+
+    std::vector<ntc::OutputTextureDesc> outputs;
+    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    {
+        ntc::OutputTextureDesc& outputDesc = outputs.emplace_back();
+        textureSetMetadata->GetTexture(textureIndex)->GetChannels(outputDesc.firstChannel, outputDesc.numChannels);
+        outputDesc.descriptorIndex = 0;
+    }
+
+    bool anyMeasured = false;
+    for (ntc::InferenceWeightType weightType : candidates)
+    {
+        if (!textureSetMetadata->IsInferenceWeightTypeSupported(weightType))
+            continue;
+
+        commandList->open();
+        bool const weightsSet = pass.SetWeightsFromTextureSet(commandList, textureSetMetadata, weightType);
+        commandList->close();
+        if (!weightsSet)
+            continue;
+        device->executeCommandList(commandList);
+
+        ntc::MakeDecompressionComputePassParameters params;
+        params.textureSetMetadata = textureSetMetadata;
+        params.mipLevel = mipLevel;
+        params.firstLatentMipInTexture = firstLatentMipInTexture;
+        params.weightType = weightType;
+        params.numOutputTextures = int(outputs.size());
+        params.pOutputTextures = outputs.data();
+        ntc::ComputePassDesc computePass{};
+        if (context->MakeDecompressionComputePass(params, &computePass) != ntc::Status::Ok)
+            continue;
+
+        // The first run is not timed because it includes the pipeline creation
+        std::vector<float> times;
+        for (int iteration = 0; iteration <= numIterations; ++iteration)
+        {
+            commandList->open();
+            commandList->beginTimerQuery(timerQuery);
+            bool const executed = pass.ExecuteComputePass(commandList, computePass);
+            commandList->endTimerQuery(timerQuery);
+            commandList->close();
+            if (!executed)
+                break;
+
+            device->executeCommandList(commandList);
+            device->waitForIdle();
+
+            if (iteration > 0)
+                times.push_back(device->getTimerQueryTime(timerQuery));
+        }
+
+        if (times.empty())
+            continue;
+
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        outTimings[size_t(weightType)] = std::max(times[times.size() / 2], 1e-9f);
+        anyMeasured = true;
+    }
+
+    device->runGarbageCollection();
+    return anyMeasured;
+}
@@ -22,13 +22,24 @@ Use like this:
   print(f'Compression successful, PSNR = {result.overallPsnr})
 
 When an error happens in ntc-cli, the run(...) function will raise a RuntimeError.
+
+To process many tasks without starting ntc-cli for each of them, use a Server, which keeps one ntc-cli process
+with its CUDA context and graphics device running and receives the results as JSON instead of parsing the output:
+
+  with ntc.Server(task) as server:
+    result = server.run(task)
+
+The process_concurrent_tasks(...) function uses one server per device when possible.
 """
 
-from dataclasses import dataclass
+from collections import deque
+from dataclasses import dataclass, fields, replace
 from typing import Optional, List, Tuple, Dict, Any, Callable
 from argparse import Namespace
 import subprocess
+import json
 import re
+import struct
 import os
 import signal
 import sys
@@ -88,6 +99,8 @@ class Arguments:
     bcPsnrOffset: Optional[float] = None
     benchmark: Optional[int] = None
     bitsPerPixel: Optional[float] = None
+    cacheDir: str = ''
+    cacheMaxSize: Optional[int] = None # in megabytes
     compress: bool = False
     cudaDevice: Optional[int] = None
     debug: bool = False
@@ -128,6 +141,7 @@ class Arguments:
     stepsPerIteration: Optional[int] = None
     targetPsnr: Optional[float] = None
     trainingSteps: Optional[int] = None
+    weightType: str = '' # Auto, Int8, FP8, CoopVec
 
     def get_command_line(self) -> List[str]:
         "Returns the command line with the provided arguments, as a list passable to subprocess.call."
@@ -188,11 +202,16 @@ class Result:
     combinedBcBitsPerPixel: Optional[float] = None
     compressionRuns: Optional[List[CompressionRun]] = None
     decompressionTime: Optional[float] = None
+    decompressionWeightType: str = ''
+    decompressionThroughput: Optional[float] = None # in Mpix/s, graphics decompression with benchmark > 1
+    decompressionBytesRead: Optional[int] = None
+    decompressionBytesWritten: Optional[int] = None
     savedFileSize: Optional[int] = None
     savedFileBpp: Optional[float] = None
     gpuName: str = ''
     graphicsApi: str = ''
     gpuFeatures: Optional[List[str]] = None # may contain 'CoopVec', 'GDeflate'
+    cacheHit: Optional[bool] = None # set when using cacheDir: True if compression was skipped
 
     # describe command output:
     dimensions: Optional[Tuple[int, int]] = None # (width, height)
@@ -233,18 +252,23 @@ class Regex:
 
 _baseCompRateRegex = Regex(r'Base compression rate: --bitsPerPixel (?P<bpp>[0-9\.]+)')
 _bppRegex = Regex(r'Selected compression rate: (?P<bpp>[0-9\.]+) bpp, (?P<psnr>[0-9\.]+|inf) dB PSNR')
+_cacheRegex = Regex(r'Compression cache (?P<status>hit|miss): (?P<key>[0-9a-f]+)')
 _bcQualityRegex = Regex(r'Combined BCn PSNR: (?P<psnr>[0-9\.]+|inf) dB, bit rate: (?P<bpp>[0-9\.]+) bpp')
 _cudaDecompressionTimeRegex = Regex(r'CUDA decompression time: (?P<milliseconds>[0-9\.]+) ms')
 _dimensionsRegex = Regex(r'Dimensions: (?P<width>\d+)x(?P<height>\d+), (?P<channels>\d+) channels, (?P<mipLevels>\d+) mip level\(s\)')
 _experimentRegex = Regex(r'Experiment (?P<index>\d+): (?P<bpp>[0-9\.]+) bpp')
 _fileSizeRegex = Regex(r'(Estimated file|File) size: (?P<bytes>\d+) bytes, (?P<bpp>[0-9\.]+) bits per pixel')
+_graphicsDecompressionThroughputRegex = Regex(r'Decompression throughput: (?P<mpix>[0-9\.]+) Mpix/s, memory traffic: '
+                                              r'(?P<read>[0-9\.]+) MB read, (?P<written>[0-9\.]+) MB written')
 _graphicsDecompressionTimeRegex = Regex(r'Median decompression time over \d+ iterations: (?P<milliseconds>[0-9\.]+) ms')
 _latentShapeRegex = Regex(r'Latent shape: --gridSizeScale (?P<gss>\d+) --numFeatures (?P<nf>\d+)')
 _mipRegex = Regex(r'MIP\s+(?P<mipLevel>\d+)\s+PSNR: (?P<psnr>[0-9\.]+|inf) dB')
 _overallPsnrRegex = Regex(r'Overall PSNR \((?P<type>\w+) weights\): (?P<psnr>[0-9\.]+|inf) dB')
 _perTexturePsnrRegex = Regex(r'  (?P<name>[A-Za-z0-9\.\-_]+)\s+: (?P<psnr>[0-9\.]+|inf) dB \[.+\]')
+_weightTypeRegex = Regex(r'Decompression weight type: (?P<type>\w+)')
 _stepRegex = Regex(r'Training: (?P<steps>\d+) steps, (?P<milliseconds>[0-9\.]+) ms/step, intermediate PSNR: (?P<psnr>[0-9\.]+|inf) dB')
 _systemRegex = Regex(r'Using (?P<gpu>.+) with (?P<api>.+) API\. CoopVec \[(?P<coopVec>[YN])\], GDeflate \[(?P<gdeflate>[YN])\]')
+_cudaDeviceRegex = Regex(r'Device (?P<index>\d+): (?P<name>.+) \(compute capability [0-9\.]+, (?P<megabytes>\d+) MB VRAM\)')
 _imageDiffRegex = Regex(r'PAIR (?P<pair>\d+) MIP\s+(?P<mipLevel>\d+): MSE = (?P<mse>[0-9\.]+|inf), PSNR = (?P<psnr>[0-9\.]+|inf) dB')
 
 
@@ -279,6 +303,9 @@ def run(args: Arguments) -> Result:
             result.combinedBcPsnr = float(m.psnr)
             result.combinedBcBitsPerPixel = float(m.bpp)
 
+        elif m := _cacheRegex.parse(line):
+            result.cacheHit = m.status == 'hit'
+
         elif m := _cudaDecompressionTimeRegex.parse(line):
             result.decompressionTime = float(m.milliseconds)
 
@@ -299,6 +326,11 @@ def run(args: Arguments) -> Result:
         elif m := _graphicsDecompressionTimeRegex.parse(line):
             result.decompressionTime = float(m.milliseconds)
 
+        elif m := _graphicsDecompressionThroughputRegex.parse(line):
+            result.decompressionThroughput = float(m.mpix)
+            result.decompressionBytesRead = int(float(m.read) * 1e6)
+            result.decompressionBytesWritten = int(float(m.written) * 1e6)
+
         elif m := _latentShapeRegex.parse(line):
             result.latentShape = LatentShape(gridSizeScale=int(m.gss), numFeatures=int(m.nf))
 
@@ -320,6 +352,9 @@ def run(args: Arguments) -> Result:
             tuple = int(m.steps), float(m.milliseconds), float(m.psnr)
             compressionRun.learningCurve = _create_or_append_list(compressionRun.learningCurve, tuple)
 
+        elif m := _weightTypeRegex.parse(line):
+            result.decompressionWeightType = m.type
+
         elif m := _systemRegex.parse(line):
             result.gpuName = m.gpu
             result.graphicsApi = m.api
@@ -333,7 +368,340 @@ def run(args: Arguments) -> Result:
     return result
 
 
-def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callable) -> bool:
+def get_cuda_devices(tool: str) -> Dict[int, Tuple[str, int]]:
+    "Returns the CUDA devices reported by 'ntc-cli --listCudaDevices' as a dictionary {index: (name, memory in bytes)}."
+
+    command = [tool, '--listCudaDevices']
+    output = subprocess.run(command, capture_output=True, text=True)
+    if output.returncode != 0:
+        raise RuntimeError(command, output.returncode, output.stdout, output.stderr)
+
+    devices = {}
+    for line in output.stdout.splitlines():
+        if m := _cudaDeviceRegex.parse(line):
+            devices[int(m.index)] = (m.name, int(m.megabytes) << 20)
+    return devices
+
+def _read_image_header(fileName: str) -> Optional[Tuple[int, int, int]]:
+    """
+    Reads the dimensions and channel count of an image from its header as (width, height, channels),
+    or returns None if the format is not recognized. Supports the formats accepted by ntc-cli.
+    """
+    try:
+        with open(fileName, 'rb') as f:
+            header = f.read(64 * 1024)
+    except OSError:
+        return None
+
+    if header[:8] == b'\x89PNG\r\n\x1a\n' and len(header) >= 26:
+        width, height = struct.unpack('>II', header[16:24])
+        channels = { 0: 1, 2: 3, 3: 3, 4: 2, 6: 4 }.get(header[25], 4)
+        return width, height, channels
+
+    if header[:2] == b'\xff\xd8':
+        # Walk the JPEG segments until the start of frame
+        pos = 2
+        while pos + 9 < len(header):
+            if header[pos] != 0xff:
+                return None
+            marker = header[pos + 1]
+            length, = struct.unpack('>H', header[pos + 2:pos + 4])
+            if 0xc0 <= marker <= 0xcf and marker not in (0xc4, 0xc8, 0xcc):
+                height, width = struct.unpack('>HH', header[pos + 5:pos + 9])
+                return width, height, header[pos + 9]
+            pos += 2 + length
+        return None
+
+    if header[:4] == b'DDS ' and len(header) >= 20:
+        height, width = struct.unpack('<II', header[12:20])
+        return width, height, 4
+
+    if header[:4] == b'\x76\x2f\x31\x01':
+        # Scan the EXR header attributes for the data window and channel list
+        pos = 8
+        width = height = channels = None
+        while pos < len(header) and header[pos] != 0:
+            nameEnd = header.index(b'\0', pos)
+            typeEnd = header.index(b'\0', nameEnd + 1)
+            name = header[pos:nameEnd]
+            size, = struct.unpack('<i', header[typeEnd + 1:typeEnd + 5])
+            value = header[typeEnd + 5:typeEnd + 5 + size]
+            if name == b'dataWindow':
+                xMin, yMin, xMax, yMax = struct.unpack('<iiii', value[:16])
+                width, height = xMax - xMin + 1, yMax - yMin + 1
+            elif name == b'channels':
+                # Each channel is a null-terminated name followed by 16 bytes, the list ends with a null
+                channels = 0
+                channelPos = 0
+                while channelPos < len(value) and value[channelPos] != 0:
+                    channelPos = value.index(b'\0', channelPos) + 17
+                    channels += 1
+            pos = typeEnd + 5 + size
+        if width is None or channels is None:
+            return None
+        return width, height, channels
+
+    # TGA has no signature, validate the image type instead
+    if len(header) >= 18 and header[2] in (1, 2, 3, 9, 10, 11):
+        width, height = struct.unpack('<HH', header[12:16])
+        return width, height, max(1, header[16] // 8)
+
+    return None
+
+def _get_input_images(args: Arguments) -> Optional[Tuple[List[Tuple[str, int]], Optional[int], Optional[int]]]:
+    """
+    Returns the MIP 0 images of the task's input as a list of (fileName, storedChannels),
+    and the custom width and height from the manifest if any, or None if the input is not a set of images.
+    Channel counts of 0 mean that all channels of the image are used.
+    """
+    if args.loadImages:
+        if not os.path.isdir(args.loadImages):
+            return None
+        extensions = ('.png', '.jpg', '.jpeg', '.tga', '.exr', '.dds')
+        images = [(os.path.join(args.loadImages, name), 0) for name in sorted(os.listdir(args.loadImages))
+                  if os.path.splitext(name)[1].lower() in extensions]
+        return images, None, None
+
+    if args.loadManifest:
+        try:
+            with open(args.loadManifest, 'r') as f:
+                manifest = json.load(f)
+        except (OSError, ValueError):
+            return None
+        baseDir = os.path.dirname(os.path.abspath(args.loadManifest))
+        images = [(os.path.join(baseDir, entry['fileName']), len(entry.get('channelSwizzle', '')))
+                  for entry in manifest.get('textures', []) if entry.get('mipLevel', 0) == 0 and 'fileName' in entry]
+        return images, manifest.get('width'), manifest.get('height')
+
+    return None
+
+def _read_ntc_descriptor(fileName: str) -> Optional[Dict[str, Any]]:
+    "Reads the JSON descriptor of an NTC file, see docs/TextureSetFile.md, or returns None if it cannot be read."
+    try:
+        with open(fileName, 'rb') as f:
+            header = f.read(24)
+            if len(header) < 24 or header[:4] != b'NTEX':
+                return None
+            jsonOffset, jsonSize = struct.unpack('<QQ', header[8:24])
+            f.seek(jsonOffset)
+            return json.loads(f.read(jsonSize).rstrip(b'\0'))
+    except (OSError, ValueError):
+        return None
+
+def get_task_dimensions(args: Arguments) -> Optional[Tuple[int, int, int, int]]:
+    """
+    Returns the dimensions of the texture set that the task will process as (width, height, channels, mipLevels),
+    using only the image headers or the NTC file descriptor. Returns None if the dimensions cannot be determined.
+    """
+    if args.loadCompressed:
+        descriptor = _read_ntc_descriptor(args.loadCompressed)
+        if descriptor is None:
+            return None
+        return descriptor['width'], descriptor['height'], descriptor['numChannels'], descriptor.get('numColorMips', 1)
+
+    inputs = _get_input_images(args)
+    if inputs is None:
+        return None
+    images, width, height = inputs
+    if not images:
+        return None
+
+    # The texture set is as large as the largest image, and has all of their channels
+    maxWidth = maxHeight = totalChannels = 0
+    for fileName, storedChannels in images:
+        header = _read_image_header(fileName)
+        if header is None:
+            return None
+        maxWidth = max(maxWidth, header[0])
+        maxHeight = max(maxHeight, header[1])
+        totalChannels += storedChannels or header[2]
+
+    if args.dimensions:
+        width, height = (int(x) for x in args.dimensions.lower().split('x'))
+    width = width or maxWidth
+    height = height or maxHeight
+
+    fullMipChain = args.generateMips or args.loadMips
+    mipLevels = max(width, height).bit_length() if fullMipChain else 1
+
+    return width, height, min(totalChannels, 16), mipLevels
+
+# Approximate GPU memory model for ntc-cli, used by estimate_task_memory(...) and process_concurrent_tasks(...).
+# The constants are deliberately conservative, the actual usage depends on the library version and the GPU.
+_processMemory = 768 << 20          # CUDA context, graphics device and fixed allocations of one ntc-cli process
+_colorBytesPerValue = 8             # Reference and decompressed color data, plus the training loss buffers
+_latentBytesPerBit = 6              # Latents in training precision with their optimizer state, per stored bit
+_graphicsBytesPerValue = 4          # Graphics textures and staging buffers used for BCn encoding
+_defaultBitsPerPixel = 8            # Used when the task doesn't specify the compression rate
+
+def estimate_task_memory(args: Arguments) -> Optional[int]:
+    """
+    Estimates the GPU memory used by a task in bytes, excluding the memory of the ntc-cli process itself
+    (see _processMemory), from the dimensions of its texture set and its compression rate.
+    Returns None if the dimensions cannot be determined.
+    """
+    dimensions = get_task_dimensions(args)
+    if dimensions is None:
+        return None
+    width, height, channels, mipLevels = dimensions
+
+    pixels = sum(max(1, width >> mip) * max(1, height >> mip) for mip in range(mipLevels))
+    memory = pixels * channels * _colorBytesPerValue
+
+    if args.compress:
+        if args.latentShape is not None:
+            # Each feature of the high-resolution grid stores up to 2 bits per grid cell, plus a lower resolution grid
+            cells = (width // args.latentShape.gridSizeScale) * (height // args.latentShape.gridSizeScale)
+            latentBits = cells * args.latentShape.numFeatures * 2 * 5 // 4
+        else:
+            if args.targetPsnr is not None:
+                bitsPerPixel = args.maxBitsPerPixel or 20.0 # The search may try up to this rate
+            else:
+                bitsPerPixel = args.bitsPerPixel or _defaultBitsPerPixel
+            latentBits = int(width * height * bitsPerPixel)
+        memory += latentBits * _latentBytesPerBit
+    
+    if args.bcFormat.lower() not in ('', 'none') or args.optimizeBC or args.matchBcPsnr:
+        memory += pixels * channels * _graphicsBytesPerValue
+
+    return memory
+
+# Fields of Arguments that select the ntc-cli process and its devices: they are passed to the server when it starts,
+# and the tasks processed by one server must have the same values.
+_serverFields = ('tool', 'graphicsApi', 'adapter', 'cudaDevice', 'debug', 'noCoopVec', 'gpuGDeflate')
+
+def _get_server_key(args: Arguments) -> Tuple:
+    return tuple(getattr(args, name) for name in _serverFields)
+
+def supports_server(args: Arguments) -> bool:
+    "Returns True if the task can be executed by a Server, or False if it needs its own ntc-cli process."
+
+    # Jobs cannot read manifests from stdin, which is used for the jobs themselves
+    if args.stdin is not None or args.readManifestFromStdin:
+        return False
+    
+    if args.listAdapters or args.listCudaDevices:
+        return False
+    
+    # Jobs must have an input
+    if not args.loadImages and not args.loadManifest and not args.loadCompressed:
+        return False
+    
+    # Decompression of a compressed file with the graphics API is not done in jobs, they use CUDA instead
+    if args.loadCompressed and args.graphicsApi and args.decompress and not args.optimizeBC:
+        return False
+    
+    return True
+
+def _result_from_response(response: Dict[str, Any], args: Arguments, elapsedTime: float) -> Result:
+    result = Result(elapsedTime=elapsedTime, bitsPerPixel=args.bitsPerPixel)
+    resultFields = set(field.name for field in fields(Result))
+
+    for name, value in response.items():
+        if name not in resultFields or name == 'elapsedTime':
+            pass
+        elif name == 'dimensions':
+            result.dimensions = tuple(value)
+        elif name == 'latentShape':
+            result.latentShape = LatentShape(**value)
+        elif name == 'compressionRuns':
+            result.compressionRuns = [CompressionRun(
+                bitsPerPixel=run.get('bitsPerPixel'),
+                learningCurve=[tuple(step) for step in run['learningCurve']]) for run in value]
+        else:
+            setattr(result, name, value)
+
+    return result
+
+class Server:
+    """
+    An ntc-cli process running in --server mode, which executes tasks one at a time without restarting,
+    keeping its CUDA context and graphics device between the tasks.
+
+    The server is created with the device fields of the provided Arguments (see _serverFields),
+    and can only run the tasks that have the same values in these fields, and for which supports_server(...) is True.
+    The results of run(...) are the same as the results of ntc.run(...) for the same task,
+    except for 'elapsedTime', which doesn't include the process startup time.
+    """
+
+    def __init__(self, args: Arguments):
+        self.key = _get_server_key(args)
+
+        serverArgs = Arguments(**{name: getattr(args, name) for name in _serverFields})
+        self.command = [arg for arg in serverArgs.get_command_line() if arg != ''] + ['--server']
+
+        # All regular output of the tool goes to stderr in server mode.
+        # Keep the last lines to report them when a task fails.
+        self.process = subprocess.Popen(self.command, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                        stderr=subprocess.PIPE, text=True, bufsize=1)
+        self.messages = deque(maxlen=100)
+        self.messagesLock = threading.Lock()
+        self.messagesThread = threading.Thread(target=self._read_messages, daemon=True)
+        self.messagesThread.start()
+
+        # The first response contains the device information
+        self.deviceInfo = self._read_response(self.command)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def _read_messages(self):
+        for line in self.process.stderr:
+            with self.messagesLock:
+                self.messages.append(line)
+
+    def _get_messages(self) -> str:
+        with self.messagesLock:
+            return ''.join(self.messages)
+
+    def _read_response(self, command: List[str]) -> Dict[str, Any]:
+        line = self.process.stdout.readline()
+        if not line:
+            returncode = self.process.wait()
+            self.messagesThread.join()
+            raise RuntimeError(command, returncode, '', self._get_messages())
+        return json.loads(line)
+
+    def run(self, args: Arguments) -> Result:
+        "Executes the task and returns its results, or raises a RuntimeError if the task fails."
+
+        if _get_server_key(args) != self.key:
+            raise ValueError('The task uses different devices than the server.')
+        if not supports_server(args):
+            raise ValueError('The task cannot be executed by a server, use ntc.run(...) instead.')
+
+        # The device fields are already on the server command line, which is prepended to the job arguments
+        jobArgs = replace(args, **{name: getattr(Arguments, name) for name in _serverFields if name != 'tool'})
+        jobCommand = [arg for arg in jobArgs.get_command_line()[1:] if arg != '']
+
+        with self.messagesLock:
+            self.messages.clear()
+
+        taskStartTime = time.time()
+        self.process.stdin.write(json.dumps({'args': jobCommand}) + '\n')
+        self.process.stdin.flush()
+        response = self._read_response(self.command + jobCommand)
+        taskEndTime = time.time()
+
+        if not response['success']:
+            raise RuntimeError(self.command + jobCommand, 1, '', self._get_messages())
+
+        result = _result_from_response({**self.deviceInfo, **response}, args, taskEndTime - taskStartTime)
+        return result
+
+    def close(self):
+        "Stops the server after it finishes the current task."
+        if self.process.poll() is None:
+            self.process.stdin.close()
+            self.process.wait()
+        self.messagesThread.join()
+
+
+def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callable, useServers: bool = True,
+                             memoryFraction: Optional[float] = None, maxTasksPerDevice: int = 4) -> bool:
     """
     Executes the tasks from the list on one or more GPUs concurrently.
     The 0-based indices of CUDA devices are provided in the 'devices' argument.
@@ -349,6 +717,15 @@ def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callab
     The 'task' argument to 'ready' is the original task from the input list,
     which may be Arguments or tuple. The 'ready' function is called from the worker threads,
     but under a mutex, so only one call at a time.
+
+    With 'useServers', each worker thread keeps ntc-cli servers running for its device and sends the tasks to them,
+    see Server. Tasks that cannot be executed by a server start their own ntc-cli process.
+
+    By default, each entry in 'devices' runs one task at a time, in the order of the list.
+    When 'memoryFraction' is provided, the tasks are scheduled by their estimated GPU memory usage instead,
+    see estimate_task_memory(...): each device runs up to 'maxTasksPerDevice' tasks at once, as long as their
+    estimates fit into that fraction of the device memory, and the largest tasks are started first.
+    Tasks whose usage cannot be estimated, or that don't fit into any device, run alone on the largest device.
     """
 
     mutex = threading.Lock()
@@ -361,16 +738,28 @@ def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callab
         terminate = True
         print('\nSIGINT received, stopping.', file=sys.stderr)
 
-    def _thread_function(device):
+    def _take_next_task(device):
+        with mutex:
+            if len(tasks) > 0:
+                task = tasks[0]
+                del tasks[0]
+                return task
+        return None
+
+    def _thread_function(device, take_task, task_done):
+        servers: Dict[Tuple, Server] = {}
+        try:
+            _process_tasks(device, servers, take_task, task_done)
+        finally:
+            for server in servers.values():
+                server.close()
+
+    def _process_tasks(device, servers, take_task, task_done):
         nonlocal terminate
 
         while not terminate:
             # Take the next task from the list
-            task = None
-            with mutex:
-                if len(tasks) > 0:
-                    task = tasks[0]
-                    del tasks[0]
+            task = take_task(device)
             if task is None:
                 break
 
@@ -383,7 +772,13 @@ def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callab
 
             # Run the task
             try:
-                result = run(args)
+                if useServers and supports_server(args):
+                    key = _get_server_key(args)
+                    if key not in servers:
+                        servers[key] = Server(args)
+                    result = servers[key].run(args)
+                else:
+                    result = run(args)
             except Exception as e:
                 if isinstance(e, RuntimeError):
                     if not terminate:
@@ -392,6 +787,9 @@ def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callab
                     traceback.print_exception(e, file=sys.stderr)
                 terminate = True
                 return
+            finally:
+                if task_done is not None:
+                    task_done(device, task)
             
             # Call the ready function
             with mutex:
@@ -415,15 +813,77 @@ def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callab
         elif not isinstance(task, Arguments):
             raise ValueError(f'Task {task} is neither a tuple nor Arguments.')
 
+    # Worker threads as (device, take_task, task_done)
+    workers = []
+    if memoryFraction is None:
+        # One thread per device entry, taking the tasks in order
+        workers = [(device, _take_next_task, None) for device in devices]
+    elif len(tasks) > 0:
+        firstArgs = tasks[0][0] if isinstance(tasks[0], Tuple) else tasks[0]
+        deviceInfo = get_cuda_devices(firstArgs.tool)
+        uniqueDevices = list(dict.fromkeys(devices))
+        for device in uniqueDevices:
+            if device not in deviceInfo:
+                raise ValueError(f'CUDA device {device} is not available.')
+        budgets = { device: int(deviceInfo[device][1] * memoryFraction) for device in uniqueDevices }
+        largestBudget = max(budgets.values())
+
+        # Estimate all tasks and start with the largest ones, unknown sizes count as the whole device
+        estimates = {}
+        for task in tasks:
+            estimates[id(task)] = estimate_task_memory(task[0] if isinstance(task, Tuple) else task)
+        tasks.sort(key=lambda task: (estimates[id(task)] is None, estimates[id(task)] or 0), reverse=True)
+
+        # Per device: memory of the running tasks and started processes, and the number of running tasks
+        condition = threading.Condition(mutex)
+        memoryInUse = { device: 0 for device in uniqueDevices }
+        runningTasks = { device: 0 for device in uniqueDevices }
+        startedWorkers = set()
+
+        def _take_fitting_task(device, worker):
+            with condition:
+                while not terminate and len(tasks) > 0:
+                    # The first task of a worker also starts its ntc-cli process, which stays alive with a server
+                    processMemory = 0 if worker in startedWorkers else _processMemory
+                    available = budgets[device] - memoryInUse[device] - processMemory
+                    for index, task in enumerate(tasks):
+                        estimate = estimates[id(task)]
+                        fits = estimate is not None and estimate <= available
+                        # Tasks that don't fit run alone on the largest device
+                        runsAlone = runningTasks[device] == 0 and budgets[device] == largestBudget and \
+                            (estimate is None or estimate > available)
+                        if fits or runsAlone:
+                            del tasks[index]
+                            cost = budgets[device] if estimate is None else estimate
+                            estimates[id(task)] = cost
+                            memoryInUse[device] += cost + processMemory
+                            runningTasks[device] += 1
+                            startedWorkers.add(worker)
+                            return task
+                    condition.wait(timeout=0.5)
+                return None
+
+        def _fitting_task_done(device, task):
+            with condition:
+                memoryInUse[device] -= estimates[id(task)]
+                runningTasks[device] -= 1
+                condition.notify_all()
+
+        for device in uniqueDevices:
+            for slot in range(maxTasksPerDevice):
+                worker = (device, slot)
+                take_task = lambda device, worker=worker: _take_fitting_task(device, worker)
+                workers.append((device, take_task, _fitting_task_done))
+
     # Install and then remove a SIGINT handler with a try-finally block
     try:
         old_handler = signal.getsignal(signal.SIGINT)
         signal.signal(signal.SIGINT, _sigint_handler)
 
-        # Launch worker threads, one per device
+        # Launch worker threads
         threads = []
-        for device in devices:
-            thread = threading.Thread(target = _thread_function, args = [device])
+        for worker in workers:
+            thread = threading.Thread(target = _thread_function, args = worker)
             thread.start()
             threads.append(thread)
             
@@ -435,13 +895,15 @@ def process_concurrent_tasks(tasks: List[Any], devices: List[int], ready: Callab
 
     return terminate
 
-def run_imagediff(tool: str, files: List[str], extraArgs: List[str] = []):
+def run_imagediff(tool: str, files: List[str], extraArgs: List[str] = [], outWarnings: Optional[List[str]] = None):
     """
     Runs the ImageDiff tool on the two specified image files and returns the parsed result
     as a list of (PAIR, MIP, MSE, PSNR) tuples, one tuple per MIP level.
     
     In this list, PAIR is a 0-based index of the image pair.
     Files 0 and 1 are pair 0, files 2 and 3 are pair 1, and so on.
+
+    If outWarnings is provided, the lines that the tool printed to stderr are appended to it.
     """
 
     command = [tool] + files + extraArgs
@@ -451,6 +913,9 @@ def run_imagediff(tool: str, files: List[str], extraArgs: List[str] = []):
     if output.returncode != 0:
         raise RuntimeError(command, output.returncode, output.stdout, output.stderr)
     
+    if outWarnings is not None:
+        outWarnings.extend(output.stderr.splitlines())
+
     results = []
     for line in output.stdout.splitlines():
         if m := _imageDiffRegex.parse(line):
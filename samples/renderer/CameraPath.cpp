@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "CameraPath.h"
+#include <donut/core/log.h>
+#include <json/json.h>
+#include <fstream>
+
+namespace fs = std::filesystem;
+using namespace donut;
+using namespace donut::math;
+
+static bool ReadVector(Json::Value const& node, float3& outVector)
+{
+    if (!node.isArray() || node.size() != 3)
+        return false;
+
+    for (Json::ArrayIndex index = 0; index < 3; ++index)
+    {
+        if (!node[index].isNumeric())
+            return false;
+        outVector[index] = node[index].asFloat();
+    }
+    return true;
+}
+
+bool CameraPath::Load(fs::path const& fileName)
+{
+    m_keyframes.clear();
+
+    std::ifstream file(fileName);
+    if (!file.is_open())
+    {
+        log::error("Cannot open camera path file '%s'.", fileName.generic_string().c_str());
+        return false;
+    }
+
+    Json::CharReaderBuilder builder;
+    Json::Value root;
+    Json::String errorMessages;
+    if (!Json::parseFromStream(builder, file, &root, &errorMessages))
+    {
+        log::error("Cannot parse camera path file '%s': %s", fileName.generic_string().c_str(), errorMessages.c_str());
+        return false;
+    }
+
+    if (!root.isArray() || root.empty())
+    {
+        log::error("Camera path file '%s' must contain a non-empty array of keyframes.", fileName.generic_string().c_str());
+        return false;
+    }
+
+    for (Json::Value const& node : root)
+    {
+        Keyframe keyframe;
+        if (!node.isObject() || !node["time"].isNumeric() ||
+            !ReadVector(node["position"], keyframe.position) ||
+            !ReadVector(node["target"], keyframe.target))
+        {
+            log::error("Camera path file '%s' has an invalid keyframe #%d, expected "
+                "{ \"time\": t, \"position\": [x, y, z], \"target\": [x, y, z] }.",
+                fileName.generic_string().c_str(), int(m_keyframes.size()));
+            m_keyframes.clear();
+            return false;
+        }
+        keyframe.time = node["time"].asFloat();
+
+        if (!m_keyframes.empty() && keyframe.time < m_keyframes.back().time)
+        {
+            log::error("Keyframes in camera path file '%s' are not sorted by time.", fileName.generic_string().c_str());
+            m_keyframes.clear();
+            return false;
+        }
+
+        m_keyframes.push_back(keyframe);
+    }
+
+    return true;
+}
+
+void CameraPath::Evaluate(float time, float3& outPosition, float3& outTarget) const
+{
+    if (m_keyframes.empty())
+        return;
+
+    // Find the first keyframe after the given time
+    size_t next = 0;
+    while (next < m_keyframes.size() && m_keyframes[next].time <= time)
+        ++next;
+
+    if (next == 0 || next == m_keyframes.size())
+    {
+        Keyframe const& keyframe = m_keyframes[next == 0 ? 0 : next - 1];
+        outPosition = keyframe.position;
+        outTarget = keyframe.target;
+        return;
+    }
+
+    Keyframe const& a = m_keyframes[next - 1];
+    Keyframe const& b = m_keyframes[next];
+    float const t = (time - a.time) / (b.time - a.time);
+    outPosition = lerp(a.position, b.position, t);
+    outTarget = lerp(a.target, b.target, t);
+}
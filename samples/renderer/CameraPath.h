@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <donut/core/math/math.h>
+#include <filesystem>
+#include <vector>
+
+// The CameraPath class is a scripted camera animation for benchmark runs, loaded from a JSON file:
+//   [ { "time": 0.0, "position": [x, y, z], "target": [x, y, z] }, ... ]
+// The camera moves linearly between the keyframes, which must be sorted by time.
+class CameraPath
+{
+public:
+    bool Load(std::filesystem::path const& fileName);
+
+    bool IsEmpty() const { return m_keyframes.empty(); }
+
+    float GetDuration() const { return m_keyframes.empty() ? 0.f : m_keyframes.back().time; }
+
+    // Returns the camera position and look-at target at the given time, clamped to the path duration.
+    void Evaluate(float time, donut::math::float3& outPosition, donut::math::float3& outTarget) const;
+
+private:
+    struct Keyframe
+    {
+        float time = 0.f;
+        donut::math::float3 position;
+        donut::math::float3 target;
+    };
+
+    std::vector<Keyframe> m_keyframes;
+};
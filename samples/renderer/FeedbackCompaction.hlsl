@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Compute shader that compares the resolved feedback of one texture with the values previously sent to the CPU
+// and appends the regions that changed into the request buffer, see FeedbackManagerDesc::feedbackCompactionShader.
+// A region's previous value is only updated when its request fits into the buffer, so that the dropped requests
+// are reported again on the next readback of the texture.
+
+#include "donut/shaders/binding_helpers.hlsli"
+#include "feedbackmanager/include/FeedbackCompactionConstants.h"
+
+VK_PUSH_CONSTANT ConstantBuffer<FeedbackCompactionConstants> g_Const : register(b0);
+ByteAddressBuffer t_Feedback : register(t0);
+RWByteAddressBuffer u_PreviousMinMip : register(u0);
+RWByteAddressBuffer u_Requests : register(u1);
+
+[numthreads(FEEDBACK_COMPACTION_GROUP_SIZE, 1, 1)]
+void main(uint regionIndex : SV_DispatchThreadID)
+{
+    if (regionIndex >= g_Const.numRegions)
+        return;
+
+    uint minMip;
+    if (g_Const.sourceFormat == FEEDBACK_COMPACTION_SOURCE_8BIT)
+    {
+        uint const packedValues = t_Feedback.Load(g_Const.sourceOffset + (regionIndex & ~3u));
+        minMip = (packedValues >> ((regionIndex & 3u) * 8u)) & 0xffu;
+    }
+    else
+    {
+        // Unsampled regions hold 0xffffffff, which becomes 0xff like in resolved sampler feedback
+        minMip = min(t_Feedback.Load(g_Const.sourceOffset + regionIndex * 4u), 0xffu);
+    }
+
+    if (minMip == u_PreviousMinMip.Load(regionIndex * 4u))
+        return;
+
+    uint requestIndex;
+    u_Requests.InterlockedAdd(0, 1u, requestIndex);
+    if (requestIndex >= g_Const.maxRequests)
+        return;
+
+    u_Requests.Store2(FEEDBACK_COMPACTION_HEADER_SIZE + requestIndex * FEEDBACK_COMPACTION_REQUEST_SIZE,
+        uint2(g_Const.textureSlot, (regionIndex << 8u) | minMip));
+    u_PreviousMinMip.Store(regionIndex * 4u, minMip);
+}
@@ -26,6 +26,38 @@ float3 GetIncidentVector(float4 directionOrPosition, float3 surfacePos)
         return directionOrPosition.xyz;
 }
 
+// Accumulates the light contributions and the ambient term for a surface.
+// Shared by the forward shading and the deferred resolve passes.
+void EvaluateSurfaceLighting(
+    MaterialSample surfaceMaterial,
+    float3 surfaceWorldPos,
+    float3 viewIncident,
+    ForwardShadingLightConstants forwardLight,
+    out float3 diffuseTerm,
+    out float3 specularTerm)
+{
+    diffuseTerm = 0;
+    specularTerm = 0;
+
+    [loop]
+    for(uint nLight = 0; nLight < forwardLight.numLights; nLight++)
+    {
+        LightConstants light = forwardLight.lights[nLight];
+
+        float3 diffuseRadiance, specularRadiance;
+        ShadeSurface(light, surfaceMaterial, surfaceWorldPos, viewIncident, diffuseRadiance, specularRadiance);
+
+        diffuseTerm += diffuseRadiance * light.color;
+        specularTerm += specularRadiance * light.color;
+    }
+
+    float3 ambientColor = lerp(forwardLight.ambientColorBottom.rgb, forwardLight.ambientColorTop.rgb,
+        surfaceMaterial.shadingNormal.y * 0.5 + 0.5);
+
+    diffuseTerm += ambientColor * surfaceMaterial.diffuseAlbedo * surfaceMaterial.occlusion;
+    specularTerm += ambientColor * surfaceMaterial.specularF0 * surfaceMaterial.occlusion;
+}
+
 void EvaluateForwardShading(
     MaterialConstants materialConstants,
     MaterialSample surfaceMaterial,
@@ -49,30 +81,10 @@ void EvaluateForwardShading(
 
     float3 viewIncident = GetIncidentVector(view.cameraDirectionOrPosition, surfaceWorldPos);
 
-    float3 diffuseTerm = 0;
-    float3 specularTerm = 0;
-
-    [loop]
-    for(uint nLight = 0; nLight < forwardLight.numLights; nLight++)
-    {
-        LightConstants light = forwardLight.lights[nLight];
-
-        float3 diffuseRadiance, specularRadiance;
-        ShadeSurface(light, surfaceMaterial, surfaceWorldPos, viewIncident, diffuseRadiance, specularRadiance);
-
-        diffuseTerm += diffuseRadiance * light.color;
-        specularTerm += specularRadiance * light.color;
-    }
+    float3 diffuseTerm, specularTerm;
+    EvaluateSurfaceLighting(surfaceMaterial, surfaceWorldPos, viewIncident, forwardLight, diffuseTerm, specularTerm);
 
     float NdotV = saturate(-dot(surfaceMaterial.shadingNormal, viewIncident));
-
-    {
-        float3 ambientColor = lerp(forwardLight.ambientColorBottom.rgb, forwardLight.ambientColorTop.rgb,
-            surfaceMaterial.shadingNormal.y * 0.5 + 0.5);
-
-        diffuseTerm += ambientColor * surfaceMaterial.diffuseAlbedo * surfaceMaterial.occlusion;
-        specularTerm += ambientColor * surfaceMaterial.specularF0 * surfaceMaterial.occlusion;
-    }
     
 #if TRANSMISSIVE_MATERIAL
     
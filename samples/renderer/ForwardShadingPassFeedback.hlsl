@@ -35,13 +35,49 @@ DECLARE_CBUFFER(ForwardShadingLightConstants, g_ForwardLight, FORWARD_BINDING_LI
 DECLARE_CBUFFER(NtcForwardShadingPassConstants, g_Pass, FORWARD_BINDING_NTC_PASS_CONSTANTS, FORWARD_SPACE_SHADING);
 SamplerState s_StfSampler : REGISTER_SAMPLER(FORWARD_BINDING_STF_SAMPLER,   FORWARD_SPACE_SHADING);
 
-FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> t_BaseOrDiffuseFeedback         : REGISTER_UAV(FORWARD_BINDING_MATERIAL_DIFFUSE_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
-FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> t_MetalRoughOrSpecularFeedback  : REGISTER_UAV(FORWARD_BINDING_MATERIAL_SPECULAR_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
-FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> t_NormalFeedback                : REGISTER_UAV(FORWARD_BINDING_MATERIAL_NORMAL_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
-FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> t_EmissiveFeedback              : REGISTER_UAV(FORWARD_BINDING_MATERIAL_EMISSIVE_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
-FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> t_OcclusionFeedback             : REGISTER_UAV(FORWARD_BINDING_MATERIAL_OCCLUSION_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
-FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> t_TransmissionFeedback          : REGISTER_UAV(FORWARD_BINDING_MATERIAL_TRANSMISSION_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
-FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> t_OpacityFeedback               : REGISTER_UAV(FORWARD_BINDING_MATERIAL_OPACITY_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
+#if USE_FEEDBACK_BUFFER
+// Software feedback for devices without sampler feedback support, such as Vulkan.
+// See nvfeedback::FeedbackBufferHeader for the buffer layout.
+#define FEEDBACK_RESOURCE RWByteAddressBuffer
+#else
+#define FEEDBACK_RESOURCE FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP>
+#endif
+
+FEEDBACK_RESOURCE t_BaseOrDiffuseFeedback         : REGISTER_UAV(FORWARD_BINDING_MATERIAL_DIFFUSE_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
+FEEDBACK_RESOURCE t_MetalRoughOrSpecularFeedback  : REGISTER_UAV(FORWARD_BINDING_MATERIAL_SPECULAR_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
+FEEDBACK_RESOURCE t_NormalFeedback                : REGISTER_UAV(FORWARD_BINDING_MATERIAL_NORMAL_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
+FEEDBACK_RESOURCE t_EmissiveFeedback              : REGISTER_UAV(FORWARD_BINDING_MATERIAL_EMISSIVE_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
+FEEDBACK_RESOURCE t_OcclusionFeedback             : REGISTER_UAV(FORWARD_BINDING_MATERIAL_OCCLUSION_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
+FEEDBACK_RESOURCE t_TransmissionFeedback          : REGISTER_UAV(FORWARD_BINDING_MATERIAL_TRANSMISSION_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
+FEEDBACK_RESOURCE t_OpacityFeedback               : REGISTER_UAV(FORWARD_BINDING_MATERIAL_OPACITY_FEEDBACK_UAV, FORWARD_SPACE_MATERIAL);
+
+// Records that 'tex' was sampled at 'texCoord' with the default material sampler and the pass mip bias
+void WriteFeedback(FEEDBACK_RESOURCE texFeedback, Texture2D tex, float2 texCoord)
+{
+#if USE_FEEDBACK_BUFFER
+    // Header: regionWidth, regionHeight, widthInRegions, heightInRegions
+    uint4 header = texFeedback.Load4(0);
+    if (header.z == 0)
+        return;
+
+    uint2 textureSize;
+    tex.GetDimensions(textureSize.x, textureSize.y);
+
+    // Trilinear filtering touches the finer of the two mips, same as hardware sampler feedback records
+    uint mipLevel = uint(max(floor(tex.CalculateLevelOfDetail(s_MaterialSampler, texCoord) + g_Pass.mipBias), 0.0));
+
+    // The material sampler wraps, so wrap the coordinates into the texture before finding the region
+    uint2 texelPos = uint2(frac(texCoord) * float2(textureSize));
+    uint2 region = min(texelPos / header.xy, header.zw - 1);
+    uint address = 16 + (region.y * header.z + region.x) * 4;
+
+    // Many pixels map to the same region, avoid the atomic when it would not change anything
+    if (texFeedback.Load(address) > mipLevel)
+        texFeedback.InterlockedMin(address, mipLevel);
+#else
+    texFeedback.WriteSamplerFeedbackBias(tex, s_MaterialSampler, texCoord, g_Pass.mipBias);
+#endif
+}
 
 #if USE_STF
 
@@ -67,14 +103,16 @@ float4 SampleTextureWithSTF(Texture2D texture, float4 random, float2 uv, uint mi
 }
 
 // A version of SampleWithFeedback that uses STF to sample the texture
-float4 SampleWithFeedbackSTF(float2 texCoord, Texture2D tex, FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> texFeedback,
+float4 SampleWithFeedbackSTF(float2 texCoord, Texture2D tex, FEEDBACK_RESOURCE texFeedback,
     bool enableFeedback, float4 random)
 {
+    // STF selects the mip from the texture coordinate derivatives without a bias, so it may sample a coarser mip
+    // than the feedback requests when upscaling. That only costs residency, the requested tiles are never missing.
     uint status;
     float4 col = SampleTextureWithSTF(tex, random, texCoord, 0, status); // Opportunistic sample
     if (!CheckAccessFullyMapped(status))
     {
-        uint level = tex.CalculateLevelOfDetail(s_MaterialSampler, texCoord);
+        uint level = uint(max(tex.CalculateLevelOfDetail(s_MaterialSampler, texCoord) + g_Pass.mipBias, 0.0));
         for (uint i = level + 1; i < 16; ++i)
         {
             // When going to coarser MIPs, we need to recalculate the STF sample position because
@@ -86,7 +124,7 @@ float4 SampleWithFeedbackSTF(float2 texCoord, Texture2D tex, FeedbackTexture2D<S
     }
 
     if (enableFeedback)
-        texFeedback.WriteSamplerFeedback(tex, s_MaterialSampler, texCoord);
+        WriteFeedback(texFeedback, tex, texCoord);
 
     return col;
 }
@@ -137,24 +175,24 @@ MaterialTextureSample SampleMaterialTexturesFeedbackSTF(uint2 pixelPosition, flo
 }
 #endif
 
-float4 SampleWithFeedback(float2 texCoord, Texture2D tex, FeedbackTexture2D<SAMPLER_FEEDBACK_MIN_MIP> texFeedback, bool enableFeedback)
+float4 SampleWithFeedback(float2 texCoord, Texture2D tex, FEEDBACK_RESOURCE texFeedback, bool enableFeedback)
 {
     int2 offsetZero = int2(0, 0);
     uint status;
-    float4 col = tex.Sample(s_MaterialSampler, texCoord, offsetZero, 0, status); // Opportunistic sample
+    float4 col = tex.SampleBias(s_MaterialSampler, texCoord, g_Pass.mipBias, offsetZero, 0, status); // Opportunistic sample
     if (!CheckAccessFullyMapped(status))
     {
-        uint level = tex.CalculateLevelOfDetail(s_MaterialSampler, texCoord);
+        uint level = uint(max(tex.CalculateLevelOfDetail(s_MaterialSampler, texCoord) + g_Pass.mipBias, 0.0));
         for (uint i = level + 1; i < 16; ++i)
         {
-            col = tex.Sample(s_MaterialSampler, texCoord, offsetZero, i, status);
+            col = tex.SampleBias(s_MaterialSampler, texCoord, g_Pass.mipBias, offsetZero, i, status);
             if (CheckAccessFullyMapped(status))
                 break;
         }
     }
 
     if (enableFeedback)
-        texFeedback.WriteSamplerFeedback(tex, s_MaterialSampler, texCoord);
+        WriteFeedback(texFeedback, tex, texCoord);
 
     return col;
 }
@@ -0,0 +1,249 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "MaterialModePolicy.h"
+#include "NtcMaterial.h"
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/View.h>
+#include <algorithm>
+#include <cfloat>
+
+// Smoothing factors for the per-material coverage and for the inference on sample pixel limit
+static const float c_CoverageSmoothing = 0.1f;
+static const float c_BudgetSmoothing = 0.1f;
+
+// Returns the area of the screen-space rectangle covering the box, in pixels. Occlusion is not considered.
+static float EstimateProjectedArea(dm::box3 const& bounds, dm::float4x4 const& viewProjection,
+    float width, float height)
+{
+    dm::float2 minNdc = dm::float2(FLT_MAX);
+    dm::float2 maxNdc = dm::float2(-FLT_MAX);
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        dm::float4 const clip = dm::float4(bounds.getCorner(corner), 1.f) * viewProjection;
+
+        // The box crosses the camera plane, assume that it covers the whole screen
+        if (clip.w <= 1e-4f)
+            return width * height;
+
+        dm::float2 const ndc = clip.xy() / clip.w;
+        minNdc = dm::min(minNdc, ndc);
+        maxNdc = dm::max(maxNdc, ndc);
+    }
+
+    float const sizeX = std::clamp(maxNdc.x, -1.f, 1.f) - std::clamp(minNdc.x, -1.f, 1.f);
+    float const sizeY = std::clamp(maxNdc.y, -1.f, 1.f) - std::clamp(minNdc.y, -1.f, 1.f);
+    return std::max(sizeX, 0.f) * 0.5f * width * std::max(sizeY, 0.f) * 0.5f * height;
+}
+
+void MaterialModePolicy::AddMaterials(std::vector<std::shared_ptr<NtcMaterial>> const& materials)
+{
+    for (std::shared_ptr<NtcMaterial> const& material : materials)
+    {
+        if (!material->ntcConstantBuffer || material->transcodedMemorySize == 0)
+            continue;
+
+        if (!m_materialIndices.try_emplace(material.get(), m_materials.size()).second)
+            continue;
+
+        MaterialState& state = m_materials.emplace_back();
+        state.material = material.get();
+        state.framePixels = 0.f;
+        state.smoothedPixels = 0.f;
+        state.score = 0.f;
+    }
+}
+
+void MaterialModePolicy::UpdateCoverage(donut::engine::SceneGraph const& sceneGraph, donut::engine::IView const& view)
+{
+    for (MaterialState& state : m_materials)
+        state.framePixels = 0.f;
+
+    nvrhi::Rect const extent = view.GetViewExtent();
+    float const width = float(extent.width());
+    float const height = float(extent.height());
+    m_screenPixels = width * height;
+
+    dm::float4x4 const viewProjection = view.GetViewProjectionMatrix();
+    dm::frustum const viewFrustum = view.GetViewFrustum();
+
+    for (std::shared_ptr<donut::engine::MeshInstance> const& instance : sceneGraph.GetMeshInstances())
+    {
+        donut::engine::SceneGraphNode const* node = instance->GetNode();
+        std::shared_ptr<donut::engine::MeshInfo> const& mesh = instance->GetMesh();
+        if (!node || !mesh)
+            continue;
+
+        dm::affine3 const localToWorld = node->GetLocalToWorldTransformFloat();
+
+        for (std::shared_ptr<donut::engine::MeshGeometry> const& geometry : mesh->geometries)
+        {
+            auto it = m_materialIndices.find(static_cast<NtcMaterial const*>(geometry->material.get()));
+            if (it == m_materialIndices.end())
+                continue;
+
+            dm::box3 const worldBounds = geometry->objectSpaceBounds * localToWorld;
+            if (!viewFrustum.intersectsWith(worldBounds))
+                continue;
+
+            m_materials[it->second].framePixels += EstimateProjectedArea(worldBounds, viewProjection, width, height);
+        }
+    }
+
+    // Overlapping instances of the same material can't cover more than the whole screen
+    for (MaterialState& state : m_materials)
+    {
+        state.framePixels = std::min(state.framePixels, m_screenPixels);
+        state.smoothedPixels += (state.framePixels - state.smoothedPixels) * c_CoverageSmoothing;
+    }
+}
+
+void MaterialModePolicy::UpdateFrameTime(std::optional<float> renderTimeSeconds)
+{
+    if (!renderTimeSeconds.has_value() || renderTimeSeconds.value() <= 0.f)
+        return;
+
+    float const renderTimeMs = renderTimeSeconds.value() * 1e3f;
+
+    // Nothing uses inference on sample: the limit can only be established by the next results over the budget
+    if (m_samplePixels < 1.f)
+    {
+        if (renderTimeMs <= m_desc.frameTimeBudgetMs)
+            m_maxSamplePixels = -1.f;
+        return;
+    }
+
+    // Assume that the forward pass time is proportional to the number of pixels using inference on sample.
+    // That overestimates the effect of each switch because transcoded pixels aren't free, but the smoothing
+    // and repeated updates converge to the budget anyway.
+    float const target = m_samplePixels * m_desc.frameTimeBudgetMs / renderTimeMs;
+    if (m_maxSamplePixels < 0.f)
+    {
+        if (renderTimeMs > m_desc.frameTimeBudgetMs)
+            m_maxSamplePixels = target;
+    }
+    else
+    {
+        m_maxSamplePixels += (target - m_maxSamplePixels) * c_BudgetSmoothing;
+    }
+}
+
+void MaterialModePolicy::SelectModes()
+{
+    m_totalPixels = 0.f;
+    for (MaterialState& state : m_materials)
+    {
+        // Pixels covered per megabyte of transcoded textures
+        float const megabytes = std::max(float(state.material->transcodedMemorySize) / 1048576.f, 1e-3f);
+        state.score = state.smoothedPixels / megabytes;
+        if (state.material->useTranscodedTextures)
+            state.score *= 1.f + m_desc.hysteresis;
+        m_totalPixels += state.smoothedPixels;
+    }
+
+    m_sortedIndices.resize(m_materials.size());
+    for (size_t index = 0; index < m_sortedIndices.size(); ++index)
+        m_sortedIndices[index] = index;
+    std::sort(m_sortedIndices.begin(), m_sortedIndices.end(), [this](size_t a, size_t b)
+    {
+        return m_materials[a].score > m_materials[b].score;
+    });
+
+    // Walk the materials from the most to the least pixels per byte, and give them transcoded textures
+    // while there are too many pixels using inference on sample, or when they cover a large part of the screen.
+    size_t const memoryBudget = size_t(std::max(m_desc.transcodedMemoryBudgetMB, 0.f) * 1048576.f);
+    float const heroPixels = m_desc.heroCoverage * m_screenPixels;
+    size_t desiredMemorySize = 0;
+    float remainingSamplePixels = m_totalPixels;
+    std::vector<bool> desiredTranscoded(m_materials.size(), false);
+    for (size_t index : m_sortedIndices)
+    {
+        MaterialState const& state = m_materials[index];
+        if (state.smoothedPixels < 1.f)
+            continue;
+
+        float const hysteresis = state.material->useTranscodedTextures ? 1.f + m_desc.hysteresis : 1.f;
+        bool const overTimeBudget = m_maxSamplePixels >= 0.f && remainingSamplePixels > m_maxSamplePixels;
+        bool const hero = state.smoothedPixels * hysteresis >= heroPixels;
+        size_t const memorySize = state.material->transcodedMemorySize;
+
+        if ((overTimeBudget || hero) && desiredMemorySize + memorySize <= memoryBudget)
+        {
+            desiredTranscoded[index] = true;
+            desiredMemorySize += memorySize;
+            remainingSamplePixels -= state.smoothedPixels;
+        }
+    }
+
+    // Apply the changes gradually. Switch materials to inference on sample first, starting with the lowest scores,
+    // so that the memory used by transcoded textures doesn't exceed the budget in between.
+    uint32_t switches = 0;
+    for (auto it = m_sortedIndices.rbegin(); it != m_sortedIndices.rend() && switches < m_desc.maxSwitchesPerFrame; ++it)
+    {
+        NtcMaterial* material = m_materials[*it].material;
+        if (material->useTranscodedTextures && !desiredTranscoded[*it])
+        {
+            material->useTranscodedTextures = false;
+            ++switches;
+        }
+    }
+    for (auto it = m_sortedIndices.begin(); it != m_sortedIndices.end() && switches < m_desc.maxSwitchesPerFrame; ++it)
+    {
+        NtcMaterial* material = m_materials[*it].material;
+        if (!material->useTranscodedTextures && desiredTranscoded[*it])
+        {
+            material->useTranscodedTextures = true;
+            ++switches;
+        }
+    }
+
+    m_numTranscoded = 0;
+    m_transcodedMemorySize = 0;
+    m_samplePixels = 0.f;
+    for (MaterialState const& state : m_materials)
+    {
+        if (state.material->useTranscodedTextures)
+        {
+            ++m_numTranscoded;
+            m_transcodedMemorySize += state.material->transcodedMemorySize;
+        }
+        else
+        {
+            m_samplePixels += state.smoothedPixels;
+        }
+    }
+}
+
+void MaterialModePolicy::Reset()
+{
+    for (MaterialState& state : m_materials)
+        state.material->useTranscodedTextures = false;
+
+    m_maxSamplePixels = -1.f;
+    m_samplePixels = 0.f;
+    m_numTranscoded = 0;
+    m_transcodedMemorySize = 0;
+}
+
+void MaterialModePolicy::Clear()
+{
+    Reset();
+    m_materials.clear();
+    m_materialIndices.clear();
+    m_sortedIndices.clear();
+    m_totalPixels = 0.f;
+}
+
+float MaterialModePolicy::GetSamplePixelFraction() const
+{
+    return m_totalPixels > 0.f ? m_samplePixels / m_totalPixels : 1.f;
+}
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+struct NtcMaterial;
+
+namespace donut::engine
+{
+    class SceneGraph;
+    class IView;
+}
+
+struct MaterialModePolicyDesc
+{
+    // Maximum total size of the transcoded textures of the materials that use them, in megabytes
+    float transcodedMemoryBudgetMB = 256.f;
+
+    // GPU time that the forward pass is allowed to take, in milliseconds.
+    // When it is exceeded, more materials are switched from inference on sample to transcoded textures.
+    float frameTimeBudgetMs = 4.0f;
+
+    // Materials covering at least this fraction of the screen use transcoded textures if the memory budget allows
+    float heroCoverage = 0.05f;
+
+    // Score bonus for materials that already use transcoded textures, prevents switching back and forth
+    float hysteresis = 0.25f;
+
+    // Maximum number of materials that change their mode on one frame
+    uint32_t maxSwitchesPerFrame = 4;
+};
+
+// The MaterialModePolicy class selects, for every NTC material, whether it is rendered with inference on sample
+// or with the textures transcoded on load. Materials that cover many pixels are cheaper to render with
+// transcoded textures, and the other materials save memory by using inference on sample.
+// Screen coverage is estimated on the CPU from the projected bounding boxes of the mesh geometries,
+// and the number of pixels that can use inference on sample is adjusted to keep the measured
+// forward pass time within a budget.
+class MaterialModePolicy
+{
+public:
+    MaterialModePolicy() = default;
+
+    void SetDesc(MaterialModePolicyDesc const& desc) { m_desc = desc; }
+    MaterialModePolicyDesc const& GetDesc() const { return m_desc; }
+
+    // Registers the materials that can be rendered in both modes. Other materials are ignored.
+    void AddMaterials(std::vector<std::shared_ptr<NtcMaterial>> const& materials);
+
+    // Estimates the number of pixels covered by each material in the view.
+    void UpdateCoverage(donut::engine::SceneGraph const& sceneGraph, donut::engine::IView const& view);
+
+    // Updates the limit for pixels using inference on sample from a newly measured forward pass time, if one was
+    // resolved this frame. Repeating an old result would apply the same correction several times.
+    void UpdateFrameTime(std::optional<float> renderTimeSeconds);
+
+    // Selects the mode for every registered material and applies up to maxSwitchesPerFrame changes
+    // to NtcMaterial::useTranscodedTextures.
+    void SelectModes();
+
+    // Switches all registered materials back to inference on sample.
+    void Reset();
+
+    void Clear();
+
+    size_t GetNumMaterials() const { return m_materials.size(); }
+    size_t GetNumTranscodedMaterials() const { return m_numTranscoded; }
+    size_t GetTranscodedMemorySize() const { return m_transcodedMemorySize; }
+    float GetSamplePixelFraction() const;
+
+private:
+    struct MaterialState
+    {
+        NtcMaterial* material;
+        float framePixels;
+        float smoothedPixels;
+        float score;
+    };
+
+    MaterialModePolicyDesc m_desc;
+    std::vector<MaterialState> m_materials;
+    std::unordered_map<NtcMaterial const*, size_t> m_materialIndices;
+    std::vector<size_t> m_sortedIndices;
+
+    float m_screenPixels = 0.f;
+    float m_maxSamplePixels = -1.f; // Negative until the first timer results arrive
+    float m_samplePixels = 0.f;
+    float m_totalPixels = 0.f;
+    size_t m_numTranscoded = 0;
+    size_t m_transcodedMemorySize = 0;
+};
@@ -0,0 +1,176 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "MaterialStreamer.h"
+#include "NtcMaterial.h"
+#include "NtcMaterialLoader.h"
+#include <donut/engine/SceneGraph.h>
+#include <donut/engine/View.h>
+#include <algorithm>
+#include <cfloat>
+
+// Returns the distance from the point to the closest point of the box, 0 if the point is inside.
+static float DistanceToBox(dm::box3 const& bounds, dm::float3 const& point)
+{
+    dm::float3 const closest = dm::clamp(point, bounds.m_mins, bounds.m_maxs);
+    return dm::length(point - closest);
+}
+
+void MaterialStreamer::AddMaterials(std::vector<std::shared_ptr<NtcMaterial>> const& materials)
+{
+    for (std::shared_ptr<NtcMaterial> const& material : materials)
+    {
+        if (!material->ntcConstantBuffer || !material->ntcSource || material->transcodeMapping.empty())
+            continue;
+
+        if (m_groupIndices.find(material.get()) != m_groupIndices.end())
+            continue;
+
+        // Duplicate materials share the metadata object with the material that was loaded from the file
+        auto [it, inserted] = m_groupsBySource.try_emplace(material->textureSetMetadata.get(), m_groups.size());
+        if (inserted)
+        {
+            ntc::ITextureSetMetadata* textureSetMetadata = *material->textureSetMetadata;
+            ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+
+            MaterialGroup& group = m_groups.emplace_back();
+            group.texels = (uint64_t(textureSetDesc.width) * uint64_t(textureSetDesc.height) * 4) / 3;
+            group.distance = FLT_MAX;
+        }
+
+        MaterialGroup& group = m_groups[it->second];
+        group.materials.push_back(material.get());
+        m_groupIndices[material.get()] = it->second;
+    }
+}
+
+void MaterialStreamer::UpdateDistances(donut::engine::SceneGraph const& sceneGraph, donut::engine::IView const& view)
+{
+    for (MaterialGroup& group : m_groups)
+        group.distance = FLT_MAX;
+
+    dm::float3 const viewOrigin = view.GetViewOrigin();
+
+    // The frustum is not considered: the camera can turn around faster than the materials can be transcoded
+    for (std::shared_ptr<donut::engine::MeshInstance> const& instance : sceneGraph.GetMeshInstances())
+    {
+        donut::engine::SceneGraphNode const* node = instance->GetNode();
+        std::shared_ptr<donut::engine::MeshInfo> const& mesh = instance->GetMesh();
+        if (!node || !mesh)
+            continue;
+
+        dm::affine3 const localToWorld = node->GetLocalToWorldTransformFloat();
+
+        for (std::shared_ptr<donut::engine::MeshGeometry> const& geometry : mesh->geometries)
+        {
+            auto it = m_groupIndices.find(static_cast<NtcMaterial const*>(geometry->material.get()));
+            if (it == m_groupIndices.end())
+                continue;
+
+            dm::box3 const worldBounds = geometry->objectSpaceBounds * localToWorld;
+            MaterialGroup& group = m_groups[it->second];
+            group.distance = std::min(group.distance, DistanceToBox(worldBounds, viewOrigin));
+        }
+    }
+}
+
+void MaterialStreamer::StreamMaterials(NtcMaterialLoader& loader, std::vector<NtcMaterial*>& changedMaterials)
+{
+    float const evictDistance = std::max(m_desc.evictDistance, m_desc.loadDistance);
+
+    // Switch the materials whose transcoding has completed on the GPU to the transcoded textures
+    for (MaterialGroup& group : m_groups)
+    {
+        if (group.transcodeSlot < 0 || !loader.IsMaterialTranscodeOnDemandComplete(group.transcodeSlot))
+            continue;
+
+        group.transcodeSlot = -1;
+        group.resident = true;
+        for (NtcMaterial* material : group.materials)
+            material->useTranscodedTextures = true;
+        changedMaterials.insert(changedMaterials.end(), group.materials.begin(), group.materials.end());
+    }
+
+    // Evict first, so that the memory is released before more textures are created.
+    // The materials that are still transcoding are evicted after they complete.
+    m_candidates.clear();
+    for (size_t index = 0; index < m_groups.size(); ++index)
+    {
+        MaterialGroup& group = m_groups[index];
+        if (group.transcodeSlot >= 0)
+            continue;
+
+        if (group.resident && group.distance > evictDistance)
+        {
+            loader.EvictTranscodedMaterial(group.materials);
+            changedMaterials.insert(changedMaterials.end(), group.materials.begin(), group.materials.end());
+            group.resident = false;
+        }
+        else if (!group.resident && !group.failed && group.distance <= m_desc.loadDistance)
+        {
+            m_candidates.push_back(index);
+        }
+    }
+
+    std::sort(m_candidates.begin(), m_candidates.end(), [this](size_t a, size_t b)
+    {
+        return m_groups[a].distance < m_groups[b].distance;
+    });
+
+    // Spread the transcoding over multiple frames, the closest materials are submitted first.
+    // The submissions are limited by the texel budget and by the number of transcodes that the loader
+    // can have running on the GPU, and the materials switch to the transcoded textures when they complete.
+    uint64_t const texelBudget = uint64_t(std::max(m_desc.transcodeBudgetMpix, 0.f) * 1e6f);
+    uint64_t transcodedTexels = 0;
+    size_t processed = 0;
+    for (size_t index : m_candidates)
+    {
+        MaterialGroup& group = m_groups[index];
+        if (processed > 0 && transcodedTexels + group.texels > texelBudget)
+            break;
+        if (!loader.CanTranscodeMaterialOnDemand())
+            break;
+
+        ++processed;
+        transcodedTexels += group.texels;
+
+        if (!loader.TranscodeMaterialOnDemand(group.materials, group.transcodeSlot))
+            group.failed = true;
+    }
+
+    m_numPending = m_candidates.size() - processed;
+    m_numResident = 0;
+    m_streamedMemorySize = 0;
+    for (MaterialGroup const& group : m_groups)
+    {
+        if (group.transcodeSlot >= 0)
+        {
+            ++m_numPending;
+        }
+        else if (group.resident)
+        {
+            ++m_numResident;
+            m_streamedMemorySize += group.materials[0]->streamedMemorySize;
+        }
+    }
+}
+
+void MaterialStreamer::Clear()
+{
+    m_groups.clear();
+    m_groupIndices.clear();
+    m_groupsBySource.clear();
+    m_candidates.clear();
+    m_numResident = 0;
+    m_numPending = 0;
+    m_streamedMemorySize = 0;
+}
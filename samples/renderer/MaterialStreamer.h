@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+struct NtcMaterial;
+class NtcMaterialLoader;
+
+namespace donut::engine
+{
+    class SceneGraph;
+    class IView;
+}
+
+struct MaterialStreamerDesc
+{
+    // Materials with geometry closer to the camera than this distance, in scene units, are transcoded
+    float loadDistance = 10.f;
+
+    // Transcoded materials with all geometry farther than this distance are evicted, must be at least loadDistance
+    float evictDistance = 15.f;
+
+    // Number of texels that can be transcoded on one frame, in megapixels, counting all mips of the material.
+    // At least one material is transcoded per frame when any are waiting, even if it exceeds the budget.
+    float transcodeBudgetMpix = 8.f;
+};
+
+// The MaterialStreamer class transcodes NTC materials for inference on load when the camera approaches them,
+// and releases their transcoded textures when the camera moves away, so that the far materials only use
+// inference on sample. The materials must be loaded with NtcMaterialLoader::SetTranscodeOnDemand(true).
+// Materials that share the same NTC data are streamed together. The rendering mode of every material
+// is selected through NtcMaterial::useTranscodedTextures, like in the hybrid mode.
+class MaterialStreamer
+{
+public:
+    MaterialStreamer() = default;
+
+    void SetDesc(MaterialStreamerDesc const& desc) { m_desc = desc; }
+    MaterialStreamerDesc const& GetDesc() const { return m_desc; }
+
+    // Registers the materials that can be transcoded on demand. Other materials are ignored.
+    void AddMaterials(std::vector<std::shared_ptr<NtcMaterial>> const& materials);
+
+    // Finds the distance from the view origin to the closest geometry of every registered material.
+    void UpdateDistances(donut::engine::SceneGraph const& sceneGraph, donut::engine::IView const& view);
+
+    // Evicts the far materials and submits the transcoding of the near ones, closest first, within the per-frame
+    // texel budget. The GPU work is not waited for: the materials start using the transcoded textures on a later
+    // call, after it completes. The materials whose textures have changed are appended to changedMaterials.
+    void StreamMaterials(NtcMaterialLoader& loader, std::vector<NtcMaterial*>& changedMaterials);
+
+    void Clear();
+
+    size_t GetNumMaterials() const { return m_groups.size(); }
+    size_t GetNumResidentMaterials() const { return m_numResident; }
+    size_t GetNumPendingMaterials() const { return m_numPending; }
+    size_t GetStreamedMemorySize() const { return m_streamedMemorySize; }
+
+private:
+    // Materials that use the same NTC data and share the transcoded textures
+    struct MaterialGroup
+    {
+        std::vector<NtcMaterial*> materials;
+        uint64_t texels = 0;
+        float distance = 0.f;
+        bool resident = false;
+        bool failed = false; // Transcoding failed, don't retry it on every frame
+        int transcodeSlot = -1; // Transcoding submitted to the GPU and not completed yet, see NtcMaterialLoader
+    };
+
+    MaterialStreamerDesc m_desc;
+    std::vector<MaterialGroup> m_groups;
+    std::unordered_map<NtcMaterial const*, size_t> m_groupIndices;
+    std::unordered_map<void const*, size_t> m_groupsBySource; // Texture set metadata -> group index
+    std::vector<size_t> m_candidates;
+
+    size_t m_numResident = 0;
+    size_t m_numPending = 0;
+    size_t m_streamedMemorySize = 0;
+};
@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Compute shader that writes the changed texels of one MinMip texture, see FeedbackManagerDesc::minMipUpdateShader.
+
+#include "donut/shaders/binding_helpers.hlsli"
+#include "feedbackmanager/include/MinMipUpdateConstants.h"
+
+VK_PUSH_CONSTANT ConstantBuffer<MinMipUpdateConstants> g_Const : register(b0);
+ByteAddressBuffer t_Updates : register(t0);
+RWTexture2D<float> u_MinMip : register(u0);
+
+[numthreads(MINMIP_UPDATE_GROUP_SIZE, 1, 1)]
+void main(uint updateIndex : SV_DispatchThreadID)
+{
+    if (updateIndex >= g_Const.numUpdates)
+        return;
+
+    uint const update = t_Updates.Load((g_Const.firstUpdate + updateIndex) * 4u);
+    uint const texelIndex = update >> 8u;
+    uint2 const position = uint2(texelIndex % g_Const.textureWidth, texelIndex / g_Const.textureWidth);
+
+    u_MinMip[position] = float(update & 0xffu);
+}
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Compute shader that derives one mip level of a texture from the previous level, see MipGenerationPass.cpp.
+// The source footprint of every destination texel covers 2x2 texels, or 3 texels along a dimension when the
+// source size is odd, with weights that make the filter cover the source texture exactly once.
+
+#include "donut/shaders/binding_helpers.hlsli"
+#include "MipGenerationConstants.h"
+
+VK_PUSH_CONSTANT ConstantBuffer<MipGenerationConstants> g_Const : register(b0);
+Texture2D<float4> t_Source : register(t0);
+RWTexture2D<float4> u_Destination : register(u0);
+
+float3 SrgbToLinear(float3 color)
+{
+    return select(color <= 0.04045, color / 12.92, pow((color + 0.055) / 1.055, 2.4));
+}
+
+float3 LinearToSrgb(float3 color)
+{
+    return select(color <= 0.0031308, color * 12.92, 1.055 * pow(color, 1.0 / 2.4) - 0.055);
+}
+
+float4 LoadSource(int2 position)
+{
+    float4 value = t_Source[min(uint2(position), g_Const.sourceSize - 1)];
+
+    switch (g_Const.filter)
+    {
+        case MIP_FILTER_SRGB:
+            value.rgb = SrgbToLinear(value.rgb);
+            break;
+        case MIP_FILTER_NORMAL:
+            value.xyz = value.xyz * 2.0 - 1.0;
+            break;
+    }
+
+    return value;
+}
+
+// Returns the weights of up to 3 source texels along one dimension for a destination texel
+float3 GetFilterWeights(uint sourceSize, uint destinationPosition, uint destinationSize)
+{
+    if ((sourceSize & 1) == 0 || sourceSize == 1)
+        return float3(0.5, 0.5, 0);
+
+    // Odd sizes: the destination texel covers 2 + 1/destinationSize source texels
+    float const scale = 1.0 / float(sourceSize);
+    float const position = float(destinationPosition);
+    float const size = float(destinationSize);
+    return float3(size - position, size, position + 1) * scale;
+}
+
+[numthreads(MIP_GENERATION_GROUP_SIZE, MIP_GENERATION_GROUP_SIZE, 1)]
+void main(uint2 globalIdx : SV_DispatchThreadID)
+{
+    if (any(globalIdx >= g_Const.destinationSize))
+        return;
+
+    float3 const weightsX = GetFilterWeights(g_Const.sourceSize.x, globalIdx.x, g_Const.destinationSize.x);
+    float3 const weightsY = GetFilterWeights(g_Const.sourceSize.y, globalIdx.y, g_Const.destinationSize.y);
+    int2 const base = int2(globalIdx * 2);
+
+    float4 result = 0;
+    [unroll]
+    for (int y = 0; y < 3; ++y)
+    {
+        [unroll]
+        for (int x = 0; x < 3; ++x)
+        {
+            float const weight = weightsX[x] * weightsY[y];
+            if (weight > 0)
+                result += LoadSource(base + int2(x, y)) * weight;
+        }
+    }
+
+    switch (g_Const.filter)
+    {
+        case MIP_FILTER_SRGB:
+            result.rgb = LinearToSrgb(saturate(result.rgb));
+            break;
+        case MIP_FILTER_NORMAL: {
+            // Renormalize the averaged vector so that the lower mips don't get shorter normals
+            float const length = max(sqrt(dot(result.xyz, result.xyz)), 1e-6);
+            result.xyz = (result.xyz / length) * 0.5 + 0.5;
+            break;
+        }
+    }
+
+    u_Destination[globalIdx] = result;
+}
@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#ifndef MIP_GENERATION_CONSTANTS_H
+#define MIP_GENERATION_CONSTANTS_H
+
+#define MIP_GENERATION_BINDING_CONSTANTS 0
+#define MIP_GENERATION_BINDING_SOURCE 0
+#define MIP_GENERATION_BINDING_DESTINATION 0
+
+#define MIP_GENERATION_GROUP_SIZE 8
+
+#define MIP_FILTER_LINEAR 0
+#define MIP_FILTER_SRGB 1
+#define MIP_FILTER_NORMAL 2
+
+struct MipGenerationConstants
+{
+    uint2 sourceSize;
+    uint2 destinationSize;
+    uint filter;
+    uint padding;
+};
+
+#endif // MIP_GENERATION_CONSTANTS_H
@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "MipGenerationPass.h"
+#include <donut/engine/ShaderFactory.h>
+#include <donut/core/math/math.h>
+#include <algorithm>
+
+#if NTC_WITH_DX12
+    #include "compiled_shaders/MipGeneration.dxil.h"
+#endif
+
+#if NTC_WITH_VULKAN
+    #include "compiled_shaders/MipGeneration.spirv.h"
+#endif
+
+using namespace donut::math;
+#include "MipGenerationConstants.h"
+
+bool MipGenerationPass::Init()
+{
+    nvrhi::ShaderHandle computeShader = m_shaderFactory->CreateStaticPlatformShader(
+        DONUT_MAKE_PLATFORM_SHADER(g_MipGeneration), nullptr, nvrhi::ShaderType::Compute);
+    if (!computeShader)
+        return false;
+
+    auto bindingLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .addItem(nvrhi::BindingLayoutItem::PushConstants(MIP_GENERATION_BINDING_CONSTANTS, sizeof(MipGenerationConstants)))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(MIP_GENERATION_BINDING_SOURCE))
+        .addItem(nvrhi::BindingLayoutItem::Texture_UAV(MIP_GENERATION_BINDING_DESTINATION));
+
+    m_bindingLayout = m_device->createBindingLayout(bindingLayoutDesc);
+    if (!m_bindingLayout)
+        return false;
+
+    auto pipelineDesc = nvrhi::ComputePipelineDesc()
+        .setComputeShader(computeShader)
+        .addBindingLayout(m_bindingLayout);
+
+    m_pipeline = m_device->createComputePipeline(pipelineDesc);
+    if (!m_pipeline)
+        return false;
+
+    return true;
+}
+
+bool MipGenerationPass::GenerateMips(nvrhi::ICommandList* commandList, nvrhi::ITexture* texture,
+    nvrhi::Format viewFormat, int firstMipLevel, int numMipLevels, MipFilter filter)
+{
+    nvrhi::TextureDesc const& textureDesc = texture->getDesc();
+    if (firstMipLevel < 1 || firstMipLevel + numMipLevels > int(textureDesc.mipLevels))
+        return false;
+
+    for (int mipLevel = firstMipLevel; mipLevel < firstMipLevel + numMipLevels; ++mipLevel)
+    {
+        auto bindingSetDesc = nvrhi::BindingSetDesc()
+            .addItem(nvrhi::BindingSetItem::PushConstants(MIP_GENERATION_BINDING_CONSTANTS, sizeof(MipGenerationConstants)))
+            .addItem(nvrhi::BindingSetItem::Texture_SRV(MIP_GENERATION_BINDING_SOURCE, texture, viewFormat,
+                nvrhi::TextureSubresourceSet(mipLevel - 1, 1, 0, 1)))
+            .addItem(nvrhi::BindingSetItem::Texture_UAV(MIP_GENERATION_BINDING_DESTINATION, texture, viewFormat,
+                nvrhi::TextureSubresourceSet(mipLevel, 1, 0, 1)));
+
+        nvrhi::BindingSetHandle bindingSet = m_bindingCache.GetOrCreateBindingSet(bindingSetDesc, m_bindingLayout);
+        if (!bindingSet)
+            return false;
+
+        MipGenerationConstants constants {};
+        constants.sourceSize = uint2(std::max(textureDesc.width >> (mipLevel - 1), 1u),
+            std::max(textureDesc.height >> (mipLevel - 1), 1u));
+        constants.destinationSize = uint2(std::max(textureDesc.width >> mipLevel, 1u),
+            std::max(textureDesc.height >> mipLevel, 1u));
+        constants.filter = (filter == MipFilter::SRGB) ? MIP_FILTER_SRGB
+            : (filter == MipFilter::Normal) ? MIP_FILTER_NORMAL
+            : MIP_FILTER_LINEAR;
+
+        auto state = nvrhi::ComputeState()
+            .setPipeline(m_pipeline)
+            .addBindingSet(bindingSet);
+        commandList->setComputeState(state);
+        commandList->setPushConstants(&constants, sizeof(constants));
+        commandList->dispatch(
+            (constants.destinationSize.x + MIP_GENERATION_GROUP_SIZE - 1) / MIP_GENERATION_GROUP_SIZE,
+            (constants.destinationSize.y + MIP_GENERATION_GROUP_SIZE - 1) / MIP_GENERATION_GROUP_SIZE);
+    }
+
+    return true;
+}
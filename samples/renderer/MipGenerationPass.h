@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <donut/engine/BindingCache.h>
+#include <memory>
+
+namespace donut::engine
+{
+    class ShaderFactory;
+}
+
+enum class MipFilter
+{
+    Linear,
+    SRGB,   // Averages the colors in linear space, alpha is averaged as is
+    Normal  // Decodes the XYZ channels from [0, 1], averages and renormalizes them
+};
+
+// The MipGenerationPass class derives the lower mip levels of a texture from a higher one on the GPU,
+// with one compute dispatch per level. The texture must have the isUAV flag set.
+class MipGenerationPass
+{
+public:
+    MipGenerationPass(nvrhi::IDevice* device, std::shared_ptr<donut::engine::ShaderFactory> shaderFactory)
+        : m_device(device)
+        , m_shaderFactory(shaderFactory)
+        , m_bindingCache(device)
+    { }
+
+    bool Init();
+
+    // Generates the mip levels [firstMipLevel, firstMipLevel + numMipLevels) of the texture, each one
+    // from the previous level. The texture is accessed through views with viewFormat, which must be
+    // UAV compatible and not sRGB - use MipFilter::SRGB for sRGB data.
+    // Note: GenerateMips expects that the commandList is open, and leaves it open.
+    bool GenerateMips(nvrhi::ICommandList* commandList, nvrhi::ITexture* texture, nvrhi::Format viewFormat,
+        int firstMipLevel, int numMipLevels, MipFilter filter);
+
+    void ClearBindingSetCache() { m_bindingCache.Clear(); }
+
+private:
+    nvrhi::DeviceHandle m_device;
+    std::shared_ptr<donut::engine::ShaderFactory> m_shaderFactory;
+    nvrhi::BindingLayoutHandle m_bindingLayout;
+    nvrhi::ComputePipelineHandle m_pipeline;
+    donut::engine::BindingCache m_bindingCache;
+};
@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Pixel shader for the deferred Inference on Sample path. Instead of decoding and shading the material,
+// it writes the surface attributes into the deferred targets, and NtcDeferredResolve.hlsl runs the inference
+// once per visible pixel later. The pass runs after the depth pre-pass with an equal depth test,
+// so the attributes are only written for the visible surfaces.
+
+#include "ForwardShadingCommon.hlsli"
+#include "NtcForwardShadingPassConstants.h"
+#include "NtcDeferredPacking.hlsli"
+
+DECLARE_CBUFFER(MaterialConstants, g_Material, FORWARD_BINDING_MATERIAL_CONSTANTS, FORWARD_SPACE_MATERIAL);
+
+void main(
+    in float4 i_position : SV_Position,
+    in SceneVertex i_vtx,
+    in bool i_isFrontFace : SV_IsFrontFace,
+    VK_LOCATION(1) out uint o_materialId : SV_Target1,
+    VK_LOCATION(2) out float2 o_texCoord : SV_Target2,
+    VK_LOCATION(3) out float4 o_texCoordGradients : SV_Target3,
+    VK_LOCATION(4) out float4 o_normalTangent : SV_Target4
+)
+{
+    uint materialId = uint(g_Material.materialID + 1) & DEFERRED_MATERIAL_ID_MASK;
+    if (i_vtx.tangent.w < 0)
+        materialId |= DEFERRED_TANGENT_SIGN_BIT;
+    if (!i_isFrontFace)
+        materialId |= DEFERRED_BACK_FACE_BIT;
+
+    o_materialId = materialId;
+    o_texCoord = i_vtx.texCoord;
+    o_texCoordGradients = float4(ddx(i_vtx.texCoord), ddy(i_vtx.texCoord));
+    o_normalTangent = float4(NtcEncodeOctahedral(i_vtx.normal), NtcEncodeOctahedral(i_vtx.tangent.xyz));
+}
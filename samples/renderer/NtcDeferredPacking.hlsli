@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#ifndef NTC_DEFERRED_PACKING_HLSLI
+#define NTC_DEFERRED_PACKING_HLSLI
+
+// Octahedral encoding of unit vectors into [-1, 1]^2, used to store the normals and tangents
+// in the deferred attribute targets.
+
+float2 NtcEncodeOctahedral(float3 v)
+{
+    v /= max(abs(v.x) + abs(v.y) + abs(v.z), 1e-7);
+    float2 result = v.xy;
+    if (v.z < 0)
+    {
+        float2 signs = float2(v.x >= 0 ? 1.0 : -1.0, v.y >= 0 ? 1.0 : -1.0);
+        result = (1.0 - abs(v.yx)) * signs;
+    }
+    return result;
+}
+
+float3 NtcDecodeOctahedral(float2 e)
+{
+    float3 v = float3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0)
+    {
+        float2 signs = float2(v.x >= 0 ? 1.0 : -1.0, v.y >= 0 ? 1.0 : -1.0);
+        v.xy = (1.0 - abs(v.yx)) * signs;
+    }
+    return normalize(v);
+}
+
+#endif // NTC_DEFERRED_PACKING_HLSLI
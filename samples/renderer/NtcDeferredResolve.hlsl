@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Compute shader for the deferred Inference on Sample path. It is dispatched once per material that was drawn
+// by NtcDeferredAttributes.hlsl, over the whole view, and decodes and shades the pixels that belong to that material.
+// Unlike the forward pass, every thread corresponds to exactly one visible pixel, with no helper lanes or overdraw.
+
+#include "ForwardShadingCommon.hlsli"
+
+#include "libntc/shaders/Inference.hlsli"
+
+#define STF_SHADER_STAGE STF_SHADER_STAGE_COMPUTE
+#define STF_SHADER_MODEL_MAJOR 6
+#define STF_SHADER_MODEL_MINOR 5
+#include "STFSamplerState.hlsli"
+#include "NtcForwardShadingPassConstants.h"
+#include "NtcDeferredPacking.hlsli"
+
+DECLARE_CBUFFER(MaterialConstants, g_Material, FORWARD_BINDING_MATERIAL_CONSTANTS, FORWARD_SPACE_MATERIAL);
+DECLARE_CBUFFER(ForwardShadingViewConstants, g_ForwardView, FORWARD_BINDING_VIEW_CONSTANTS, FORWARD_SPACE_VIEW);
+DECLARE_CBUFFER(ForwardShadingLightConstants, g_ForwardLight, FORWARD_BINDING_LIGHT_CONSTANTS, FORWARD_SPACE_SHADING);
+DECLARE_CBUFFER(NtcForwardShadingPassConstants, g_Pass, FORWARD_BINDING_NTC_PASS_CONSTANTS, FORWARD_SPACE_SHADING);
+SamplerState s_LatentSampler : REGISTER_SAMPLER(FORWARD_BINDING_LATENTS_SAMPLER, FORWARD_SPACE_SHADING);
+
+Texture2D<float> t_Depth                  : REGISTER_SRV(DEFERRED_BINDING_DEPTH, FORWARD_SPACE_SHADING);
+Texture2D<uint> t_MaterialId              : REGISTER_SRV(DEFERRED_BINDING_MATERIAL_ID, FORWARD_SPACE_SHADING);
+Texture2D<float2> t_TexCoord              : REGISTER_SRV(DEFERRED_BINDING_TEXCOORD, FORWARD_SPACE_SHADING);
+Texture2D<float4> t_TexCoordGradients     : REGISTER_SRV(DEFERRED_BINDING_TEXCOORD_GRADIENTS, FORWARD_SPACE_SHADING);
+Texture2D<float4> t_NormalTangent         : REGISTER_SRV(DEFERRED_BINDING_NORMAL_TANGENT, FORWARD_SPACE_SHADING);
+RWTexture2D<float4> u_Color               : REGISTER_UAV(DEFERRED_BINDING_COLOR_UAV, FORWARD_SPACE_SHADING);
+
+#include "NtcMaterialSampling.hlsli"
+
+// Same as GetSamplePositionWithSTF in NtcForwardShadingPass.hlsl, but with the UV gradients stored by the attribute pass
+void GetSamplePositionWithSTFGrad(inout HashBasedRNG rng, float2 uv, float2 ddxUV, float2 ddyUV,
+    out int2 texel, out int mipLevel)
+{
+    float4 random = rng.NextFloat4();
+    STF_SamplerState sampler = STF_SamplerState::Create(random);
+    sampler.SetAnisoMethod(STF_ANISO_LOD_METHOD_DEFAULT);
+    sampler.SetFilterType(g_Pass.stfFilterMode);
+
+    const int2 textureSize = NtcGetTextureDimensions(g_NtcMaterial, 0);
+    const int mipLevels = NtcGetTextureMipLevels(g_NtcMaterial);
+    float3 samplePos = sampler.Texture2DGetSamplePosGrad(textureSize.x, textureSize.y, mipLevels, uv, ddxUV, ddyUV);
+    mipLevel = int(samplePos.z);
+
+    const int2 mipSize = NtcGetTextureDimensions(g_NtcMaterial, mipLevel);
+
+    bool border;
+    samplePos.xy = STF_ApplyAddressingMode2D(samplePos.xy, mipSize, STF_ADDRESS_MODE_WRAP, border);
+
+    texel = int2(floor(samplePos.xy * mipSize));
+}
+
+[numthreads(DEFERRED_RESOLVE_GROUP_SIZE, DEFERRED_RESOLVE_GROUP_SIZE, 1)]
+void main(uint2 globalIdx : SV_DispatchThreadID)
+{
+    PlanarViewConstants view = g_ForwardView.view;
+
+    if (any(float2(globalIdx) >= view.viewportSize))
+        return;
+
+    int2 pixelPosition = int2(globalIdx) + int2(view.viewportOrigin);
+
+    uint const packedMaterialId = t_MaterialId[pixelPosition];
+    if ((packedMaterialId & DEFERRED_MATERIAL_ID_MASK) != (uint(g_Material.materialID + 1) & DEFERRED_MATERIAL_ID_MASK))
+        return;
+
+    float2 const texCoord = t_TexCoord[pixelPosition];
+    float4 const texCoordGradients = t_TexCoordGradients[pixelPosition];
+    float4 const normalTangent = t_NormalTangent[pixelPosition];
+    float3 const normal = NtcDecodeOctahedral(normalTangent.xy);
+    float4 const tangent = float4(NtcDecodeOctahedral(normalTangent.zw),
+        (packedMaterialId & DEFERRED_TANGENT_SIGN_BIT) != 0 ? -1.0 : 1.0);
+    bool const isFrontFace = (packedMaterialId & DEFERRED_BACK_FACE_BIT) == 0;
+
+    // Reconstruct the world position from depth, the clip-to-world matrix includes the same jitter as the rasterizer
+    float2 const clipXY = (float2(globalIdx) + 0.5) * view.viewportSizeInv * float2(2.0, -2.0) + float2(-1.0, 1.0);
+    float4 worldPos = mul(float4(clipXY, t_Depth[pixelPosition], 1.0), view.matClipToWorld);
+    float3 const surfaceWorldPos = worldPos.xyz / worldPos.w;
+
+    HashBasedRNG rng = HashBasedRNG::Create2D(uint2(pixelPosition), g_Pass.frameIndex);
+    int mipLevel;
+    int2 texel;
+    GetSamplePositionWithSTFGrad(rng, texCoord, texCoordGradients.xy, texCoordGradients.zw, texel, mipLevel);
+
+    MaterialTextureSample textures = SampleNtcMaterialTexel(s_LatentSampler, texel, mipLevel);
+
+    // Same flags as in the forward pass, see NtcForwardShadingPass.hlsl
+    MaterialConstants materialConstants = g_Material;
+    materialConstants.flags |= MaterialFlags_MetalnessInRedChannel;
+    materialConstants.flags |= MaterialFlags_UseOpacityTexture;
+
+    MaterialSample surfaceMaterial = EvaluateSceneMaterial(normal, tangent, materialConstants, textures);
+    if (!isFrontFace)
+        surfaceMaterial.shadingNormal = -surfaceMaterial.shadingNormal;
+
+    float3 const viewIncident = GetIncidentVector(view.cameraDirectionOrPosition, surfaceWorldPos);
+
+    float3 diffuseTerm, specularTerm;
+    EvaluateSurfaceLighting(surfaceMaterial, surfaceWorldPos, viewIncident, g_ForwardLight, diffuseTerm, specularTerm);
+
+    u_Color[pixelPosition] = float4(diffuseTerm + specularTerm + surfaceMaterial.emissiveColor, 1.0);
+}
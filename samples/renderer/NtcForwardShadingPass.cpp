@@ -18,12 +18,17 @@
 #include <donut/engine/SceneTypes.h>
 #include <nvrhi/utils.h>
 #include <libntc/ntc.h>
+#include <set>
+#include <unordered_set>
 
 #if NTC_WITH_DX12
     #include "compiled_shaders/NtcForwardShadingPass_CoopVec.dxil.h"
     #include "compiled_shaders/NtcForwardShadingPass.dxil.h"
     #include "compiled_shaders/LegacyForwardShadingPass.dxil.h"
     #include "compiled_shaders/ForwardShadingPassFeedback.dxil.h"
+    #include "compiled_shaders/NtcDeferredAttributes.dxil.h"
+    #include "compiled_shaders/NtcDeferredResolve.dxil.h"
+    #include "compiled_shaders/NtcDeferredResolve_CoopVec.dxil.h"
     // This shader comes from Donut - see CMakeLists.txt that adds an include path to .../donut/shaders
     #include "compiled_shaders/passes/forward_vs_buffer_loads.dxil.h"
 #endif
@@ -32,6 +37,10 @@
     #include "compiled_shaders/NtcForwardShadingPass_CoopVec.spirv.h"
     #include "compiled_shaders/NtcForwardShadingPass.spirv.h"
     #include "compiled_shaders/LegacyForwardShadingPass.spirv.h"
+    #include "compiled_shaders/ForwardShadingPassFeedback.spirv.h"
+    #include "compiled_shaders/NtcDeferredAttributes.spirv.h"
+    #include "compiled_shaders/NtcDeferredResolve.spirv.h"
+    #include "compiled_shaders/NtcDeferredResolve_CoopVec.spirv.h"
     // Comes from Donut, same as forward_vs_buffer_loads.dxil.h above
     #include "compiled_shaders/passes/forward_vs_buffer_loads.spirv.h"
 #endif
@@ -54,9 +63,12 @@ nvrhi::ShaderHandle NtcForwardShadingPass::GetOrCreatePixelShader(PipelineKey ke
     key.reverseDepth = false;
 
     // See if there already is a pixel shader with that key
-    auto it = m_pixelShaders.find(key);
-    if (it != m_pixelShaders.end())
-        return it->second;
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineMutex);
+        auto it = m_pixelShaders.find(key);
+        if (it != m_pixelShaders.end())
+            return it->second;
+    }
 
     // Create a new shader
     bool const transmissiveMaterial = 
@@ -79,7 +91,17 @@ nvrhi::ShaderHandle NtcForwardShadingPass::GetOrCreatePixelShader(PipelineKey ke
     switch (key.ntcMode)
     {
         case NtcMode::InferenceOnSample:
+            if (key.deferredMaterial)
+            {
+                // The attribute pass doesn't depend on the weight type, see NormalizePipelineKey
+                pixelShader = m_shaderFactory->CreateStaticPlatformShader(
+                    DONUT_MAKE_PLATFORM_SHADER(g_NtcDeferredAttributes),
+                    nullptr, nvrhi::ShaderType::Pixel);
+                break;
+            }
+
             defines.push_back({ "USE_NTC_MATERIAL", key.useNtcMaterial ? "1" : "0" });
+            defines.push_back({ "USE_TEXEL_CACHE", key.useTexelCache ? "1" : "0" });
 
             if (useCoopVec)
             {
@@ -104,10 +126,9 @@ nvrhi::ShaderHandle NtcForwardShadingPass::GetOrCreatePixelShader(PipelineKey ke
 
         case NtcMode::InferenceOnFeedback:
             defines.push_back({ "USE_STF", key.useSTF ? "1" : "0" });
+            defines.push_back({ "USE_FEEDBACK_BUFFER", m_useFeedbackBuffers ? "1" : "0" });
             pixelShader = m_shaderFactory->CreateStaticPlatformShader(
-                donut::engine::StaticShader(), // dxbc - irrelevant
-                DONUT_MAKE_DXIL_SHADER(g_ForwardShadingPassFeedback_dxil),
-                donut::engine::StaticShader(), // spirv - feedback not supported
+                DONUT_MAKE_PLATFORM_SHADER(g_ForwardShadingPassFeedback),
                 &defines, nvrhi::ShaderType::Pixel);
             break;
 
@@ -115,11 +136,12 @@ nvrhi::ShaderHandle NtcForwardShadingPass::GetOrCreatePixelShader(PipelineKey ke
             assert(!"Unknown ntcMode");
     }
 
-    m_pixelShaders[key] = pixelShader;
-    return pixelShader;
+    // The shader may have been created by another thread in the meantime, keep the first one
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
+    return m_pixelShaders.try_emplace(key, pixelShader).first->second;
 }
 
-nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(PipelineKey key, nvrhi::IFramebuffer* framebuffer)
+NtcForwardShadingPass::PipelineKey NtcForwardShadingPass::NormalizePipelineKey(PipelineKey key)
 {
     if (key.ntcMode != NtcMode::InferenceOnSample)
     {
@@ -131,12 +153,38 @@ nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(Pipelin
         key.useSTF = true;
     }
 
+    if (!key.deferredFramebuffer || !key.useNtcMaterial)
+        key.deferredMaterial = false;
+
+    // The deferred attribute pass doesn't decode the material, the resolve pass uses the cache instead
+    if (!key.useNtcMaterial || key.deferredMaterial)
+        key.useTexelCache = false;
+    return key;
+}
+
+nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(PipelineKey key, nvrhi::IFramebuffer* framebuffer)
+{
+    key = NormalizePipelineKey(key);
+
     // See if there already is a pipeline with that key
-    auto it = m_pipelines.find(key);
-    if (it != m_pipelines.end())
-        return it->second;
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineMutex);
+        auto it = m_pipelines.find(key);
+        if (it != m_pipelines.end())
+            return it->second;
+    }
+
+    // The pipeline is not precompiled, or its compilation on the background thread hasn't finished yet.
+    // Compile it here, that may duplicate the background work but doesn't wait for the queue.
+    nvrhi::GraphicsPipelineHandle pipeline = CreatePipeline(key, framebuffer->getFramebufferInfo());
 
-    // Create a new pipeline
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
+    return m_pipelines.try_emplace(key, pipeline).first->second;
+}
+
+nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::CreatePipeline(PipelineKey const& key,
+    nvrhi::FramebufferInfo const& framebufferInfo)
+{
     nvrhi::GraphicsPipelineDesc pipelineDesc;
     pipelineDesc.inputLayout = m_inputLayout;
     pipelineDesc.VS = m_vertexShader;
@@ -146,9 +194,12 @@ nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(Pipelin
     switch(key.ntcMode)
     {
         case NtcMode::InferenceOnSample:
-            materialBindingLayout = key.useNtcMaterial
-                ? (nvrhi::IBindingLayout*)m_materialBindingLayout
-                : (nvrhi::IBindingLayout*)m_emptyMaterialBindingLayout;
+            if (!key.useNtcMaterial)
+                materialBindingLayout = m_emptyMaterialBindingLayout;
+            else if (key.useTexelCache)
+                materialBindingLayout = m_materialBindingLayoutTexelCache;
+            else
+                materialBindingLayout = m_materialBindingLayout;
             break;
 
         case NtcMode::InferenceOnLoad:
@@ -217,16 +268,209 @@ nvrhi::GraphicsPipelineHandle NtcForwardShadingPass::GetOrCreatePipeline(Pipelin
         return nullptr;
     }
 
-    nvrhi::GraphicsPipelineHandle pipeline = m_device->createGraphicsPipeline(pipelineDesc,
-        framebuffer->getFramebufferInfo());
-    m_pipelines[key] = pipeline;
-    return pipeline;
+    if (key.deferredFramebuffer)
+    {
+        // Deferred materials only write the attribute targets, and forward shaded materials only write the color
+        if (key.deferredMaterial)
+        {
+            pipelineDesc.renderState.blendState.targets[0].setColorWriteMask(nvrhi::ColorMask::None);
+        }
+        else
+        {
+            for (uint32_t target = 1; target < framebufferInfo.colorFormats.size(); ++target)
+                pipelineDesc.renderState.blendState.targets[target].setColorWriteMask(nvrhi::ColorMask::None);
+        }
+    }
+
+    return m_device->createGraphicsPipeline(pipelineDesc, framebufferInfo);
+}
+
+void NtcForwardShadingPass::PrecompilePipelines(std::vector<std::shared_ptr<NtcMaterial>> const& materials,
+    std::vector<NtcMode> const& modes, nvrhi::FramebufferInfo const& framebufferInfo,
+    nvrhi::FramebufferInfo const* deferredFramebufferInfo, bool reverseDepth, bool frontCounterClockwise)
+{
+    // Enumerate the keys that SetupMaterial can produce for these materials. The depth pre-pass, STF
+    // and the texel cache can be toggled at runtime, so include both variants of them.
+    std::unordered_set<PipelineKey, PipelineKeyHash> keys;
+    std::unordered_set<PipelineKey, PipelineKeyHash> deferredKeys;
+    std::set<std::pair<int, bool>> resolvePipelines; // (weightType, useTexelCache)
+    for (std::shared_ptr<NtcMaterial> const& material : materials)
+    {
+        for (NtcMode mode : modes)
+        {
+            if (mode == NtcMode::Hybrid)
+                continue;
+            if (mode == NtcMode::InferenceOnFeedback && !m_materialBindingLayoutFeedback)
+                continue;
+
+            PipelineKey key;
+            key.weightType = material->weightType;
+            key.domain = material->domain;
+            key.cullMode = material->doubleSided ? nvrhi::RasterCullMode::None : nvrhi::RasterCullMode::Back;
+            key.frontCounterClockwise = frontCounterClockwise;
+            key.reverseDepth = reverseDepth;
+            key.ntcMode = mode;
+            key.useNtcMaterial = mode == NtcMode::InferenceOnSample && material->ntcConstantBuffer != nullptr;
+
+            for (bool hasDepthPrepass : { false, true })
+            {
+                for (bool useSTF : { false, true })
+                {
+                    for (bool useTexelCache : { false, true })
+                    {
+                        key.hasDepthPrepass = hasDepthPrepass;
+                        key.useSTF = useSTF;
+                        key.useTexelCache = useTexelCache && material->ntcTexelCacheBuffer != nullptr;
+                        keys.insert(NormalizePipelineKey(key));
+                    }
+                }
+            }
+
+            // The deferred framebuffer is only used with the depth pre-pass, in the InferenceOnSample and Hybrid
+            // modes, so it can contain materials using inference on sample or transcoded textures.
+            // Use the same conditions as SetupMaterial and ResolveDeferredMaterials.
+            if (!deferredFramebufferInfo || mode == NtcMode::InferenceOnFeedback)
+                continue;
+
+            key.deferredFramebuffer = true;
+            key.hasDepthPrepass = true;
+            key.deferredMaterial = key.useNtcMaterial && (key.domain == donut::engine::MaterialDomain::Opaque ||
+                key.domain == donut::engine::MaterialDomain::AlphaTested);
+
+            for (bool useSTF : { false, true })
+            {
+                for (bool useTexelCache : { false, true })
+                {
+                    key.useSTF = useSTF;
+                    key.useTexelCache = useTexelCache && material->ntcTexelCacheBuffer != nullptr;
+                    deferredKeys.insert(NormalizePipelineKey(key));
+
+                    if (key.deferredMaterial)
+                        resolvePipelines.insert({ key.weightType, key.useTexelCache });
+                }
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineMutex);
+        for (PipelineKey const& key : keys)
+        {
+            if (m_pipelines.find(key) == m_pipelines.end())
+                m_precompileQueue.push_back({ key, framebufferInfo });
+        }
+
+        for (PipelineKey const& key : deferredKeys)
+        {
+            if (m_pipelines.find(key) == m_pipelines.end())
+                m_precompileQueue.push_back({ key, *deferredFramebufferInfo });
+        }
+
+        for (std::pair<int, bool> const& resolvePipeline : resolvePipelines)
+        {
+            if (m_deferredResolvePipelines.find(resolvePipeline) != m_deferredResolvePipelines.end())
+                continue;
+
+            PrecompileRequest& request = m_precompileQueue.emplace_back();
+            request.key.weightType = resolvePipeline.first;
+            request.key.useTexelCache = resolvePipeline.second;
+            request.deferredResolve = true;
+        }
+
+        if (m_precompileQueue.empty())
+            return;
+    }
+
+    if (!m_precompileThread.joinable())
+        m_precompileThread = std::thread(&NtcForwardShadingPass::PrecompileThreadProc, this);
+
+    m_precompileCondition.notify_one();
+}
+
+void NtcForwardShadingPass::PrecompileThreadProc()
+{
+    std::unique_lock<std::mutex> lock(m_pipelineMutex);
+    while (true)
+    {
+        m_precompileCondition.wait(lock, [this]() { return m_stopPrecompile || !m_precompileQueue.empty(); });
+        if (m_stopPrecompile)
+            return;
+
+        PrecompileRequest const request = m_precompileQueue.front();
+        m_precompileQueue.pop_front();
+
+        if (request.deferredResolve)
+        {
+            std::pair<int, bool> const resolveKey = { request.key.weightType, request.key.useTexelCache };
+            if (m_deferredResolvePipelines.find(resolveKey) != m_deferredResolvePipelines.end())
+                continue;
+
+            lock.unlock();
+            nvrhi::ComputePipelineHandle pipeline = CreateDeferredResolvePipeline(resolveKey.first, resolveKey.second);
+            lock.lock();
+
+            m_deferredResolvePipelines.try_emplace(resolveKey, pipeline);
+            continue;
+        }
+
+        if (m_pipelines.find(request.key) != m_pipelines.end())
+            continue;
+
+        lock.unlock();
+        nvrhi::GraphicsPipelineHandle pipeline = CreatePipeline(request.key, request.framebufferInfo);
+        lock.lock();
+
+        m_pipelines.try_emplace(request.key, pipeline);
+    }
+}
+
+size_t NtcForwardShadingPass::GetNumPendingPipelines() const
+{
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
+    return m_precompileQueue.size();
+}
+
+// The mip tail textures are bound for all NTC materials, materials without a tail get the fallback texture
+static void AddMipTailBindingSetItems(nvrhi::BindingSetDesc& bindingSetDesc, NtcMaterial const* material,
+    nvrhi::ITexture* fallbackTexture)
+{
+    auto textureOrFallback = [fallbackTexture](nvrhi::TextureHandle const& texture)
+    {
+        return texture ? texture.Get() : fallbackTexture;
+    };
+
+    bindingSetDesc
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_BASE_COLOR,
+            textureOrFallback(material->mipTailBaseColorTexture)))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_METAL_ROUGH_OR_SPECULAR,
+            textureOrFallback(material->mipTailMetalRoughOrSpecularTexture)))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_NORMAL,
+            textureOrFallback(material->mipTailNormalTexture)))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_EMISSIVE,
+            textureOrFallback(material->mipTailEmissiveTexture)))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_OCCLUSION,
+            textureOrFallback(material->mipTailOcclusionTexture)))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_TRANSMISSION,
+            textureOrFallback(material->mipTailTransmissionTexture)));
+}
+
+static void AddMipTailBindingLayoutItems(nvrhi::BindingLayoutDesc& layoutDesc)
+{
+    layoutDesc
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_BASE_COLOR))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_METAL_ROUGH_OR_SPECULAR))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_NORMAL))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_EMISSIVE))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_OCCLUSION))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_NTC_MIP_TAIL_TRANSMISSION));
 }
 
-nvrhi::BindingSetHandle NtcForwardShadingPass::GetOrCreateMaterialBindingSet(NtcMaterial const* material)
+nvrhi::BindingSetHandle NtcForwardShadingPass::GetOrCreateMaterialBindingSet(NtcMaterial const* material,
+    bool useTexelCache)
 {
-    auto found = m_materialBindingSets.find(material);
-    if (found != m_materialBindingSets.end())
+    auto& materialBindingSets = useTexelCache ? m_materialBindingSetsTexelCache : m_materialBindingSets;
+    auto found = materialBindingSets.find(material);
+    if (found != materialBindingSets.end())
         return found->second;
 
     nvrhi::BindingSetDesc bindingSetDesc;
@@ -235,19 +479,74 @@ nvrhi::BindingSetHandle NtcForwardShadingPass::GetOrCreateMaterialBindingSet(Ntc
     if (material->ntcConstantBuffer)
     {
         bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_NTC_MATERIAL_CONSTANTS, material->ntcConstantBuffer));
+        bindingSetDesc.addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_NTC_STREAMING_CONSTANTS, material->ntcStreamingConstantBuffer));
         bindingSetDesc.addItem(nvrhi::BindingSetItem::Texture_SRV(FORWARD_BINDING_NTC_LATENTS_TEXTURE, material->ntcLatentsTexture));
-        bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER, material->ntcWeightsBuffer));
-        bindingSet = m_device->createBindingSet(bindingSetDesc, m_materialBindingLayout);
+        bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER, material->ntcWeightsBuffer,
+            material->ntcWeightsRange));
+        AddMipTailBindingSetItems(bindingSetDesc, material, m_commonPasses->m_WhiteTexture);
+        if (useTexelCache)
+        {
+            bindingSetDesc.addItem(nvrhi::BindingSetItem::RawBuffer_UAV(FORWARD_BINDING_NTC_TEXEL_CACHE_UAV, material->ntcTexelCacheBuffer));
+            m_texelCacheBuffers.insert(material->ntcTexelCacheBuffer.Get());
+        }
+        bindingSet = m_device->createBindingSet(bindingSetDesc,
+            useTexelCache ? m_materialBindingLayoutTexelCache : m_materialBindingLayout);
     }
     else
     {
         bindingSet = m_device->createBindingSet(bindingSetDesc, m_emptyMaterialBindingLayout);
     }
 
-    m_materialBindingSets[material] = bindingSet;
+    materialBindingSets[material] = bindingSet;
     return bindingSet;
 }
 
+nvrhi::ComputePipelineHandle NtcForwardShadingPass::GetOrCreateDeferredResolvePipeline(int weightType,
+    bool useTexelCache)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineMutex);
+        auto found = m_deferredResolvePipelines.find({ weightType, useTexelCache });
+        if (found != m_deferredResolvePipelines.end())
+            return found->second;
+    }
+
+    // Same as in GetOrCreatePipeline, don't wait for the background compilation of this pipeline
+    nvrhi::ComputePipelineHandle pipeline = CreateDeferredResolvePipeline(weightType, useTexelCache);
+
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
+    return m_deferredResolvePipelines.try_emplace({ weightType, useTexelCache }, pipeline).first->second;
+}
+
+nvrhi::ComputePipelineHandle NtcForwardShadingPass::CreateDeferredResolvePipeline(int weightType,
+    bool useTexelCache)
+{
+    bool const useCoopVec = ntc::InferenceWeightType(weightType) == ntc::InferenceWeightType::CoopVecFP8;
+
+    std::vector<donut::engine::ShaderMacro> defines;
+    defines.push_back({ "USE_TEXEL_CACHE", useTexelCache ? "1" : "0" });
+
+    nvrhi::ShaderHandle computeShader = useCoopVec
+        ? m_shaderFactory->CreateStaticPlatformShader(DONUT_MAKE_PLATFORM_SHADER(g_NtcDeferredResolve_CoopVec),
+            &defines, nvrhi::ShaderType::Compute)
+        : m_shaderFactory->CreateStaticPlatformShader(DONUT_MAKE_PLATFORM_SHADER(g_NtcDeferredResolve),
+            &defines, nvrhi::ShaderType::Compute);
+
+    nvrhi::ComputePipelineHandle pipeline;
+    if (computeShader)
+    {
+        auto pipelineDesc = nvrhi::ComputePipelineDesc()
+            .setComputeShader(computeShader)
+            .addBindingLayout(useTexelCache ? m_materialBindingLayoutTexelCache : m_materialBindingLayout)
+            .addBindingLayout(m_deferredViewBindingLayout)
+            .addBindingLayout(m_deferredResolveBindingLayout);
+
+        pipeline = m_device->createComputePipeline(pipelineDesc);
+    }
+
+    return pipeline;
+}
+
 static nvrhi::BindingSetItem GetReservedBindingSetItem(uint32_t slot,
     nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> const& texture, nvrhi::ITexture* fallback)
 {
@@ -256,9 +555,15 @@ static nvrhi::BindingSetItem GetReservedBindingSetItem(uint32_t slot,
     return nvrhi::BindingSetItem::Texture_SRV(slot, fallback);
 }
 
-static nvrhi::BindingSetItem GetFeedbackBindingSetItem(uint32_t slot,
+nvrhi::BindingSetItem NtcForwardShadingPass::GetFeedbackBindingSetItem(uint32_t slot,
     nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> const& texture)
 {
+    if (m_useFeedbackBuffers)
+    {
+        return nvrhi::BindingSetItem::RawBuffer_UAV(slot,
+            texture ? texture->GetFeedbackBuffer().Get() : m_dummyFeedbackBuffer.Get());
+    }
+
     if (texture)
         return nvrhi::BindingSetItem::SamplerFeedbackTexture_UAV(slot, texture->GetSamplerFeedbackTexture().Get());
     return nvrhi::BindingSetItem::SamplerFeedbackTexture_UAV(slot, nullptr);
@@ -280,13 +585,13 @@ nvrhi::BindingSetHandle NtcForwardShadingPass::GetOrCreateMaterialBindingSetFeed
         .addItem(GetReservedBindingSetItem(FORWARD_BINDING_MATERIAL_OCCLUSION_TEXTURE,    material->occlusionTextureFeedback,            fallbackTexture))
         .addItem(GetReservedBindingSetItem(FORWARD_BINDING_MATERIAL_TRANSMISSION_TEXTURE, material->transmissionTextureFeedback,         fallbackTexture))
         .addItem(GetReservedBindingSetItem(FORWARD_BINDING_MATERIAL_OPACITY_TEXTURE,      material->opacityTextureFeedback,              fallbackTexture))
-        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_DIFFUSE_TEXTURE,      material->baseOrDiffuseTextureFeedback))
-        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_SPECULAR_TEXTURE,     material->metalRoughOrSpecularTextureFeedback))
-        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_NORMAL_TEXTURE,       material->normalTextureFeedback))
-        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_EMISSIVE_TEXTURE,     material->emissiveTextureFeedback))
-        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_OCCLUSION_TEXTURE,    material->occlusionTextureFeedback))
-        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_TRANSMISSION_TEXTURE, material->transmissionTextureFeedback))
-        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_OPACITY_TEXTURE,      material->opacityTextureFeedback))
+        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_DIFFUSE_FEEDBACK_UAV,      material->baseOrDiffuseTextureFeedback))
+        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_SPECULAR_FEEDBACK_UAV,     material->metalRoughOrSpecularTextureFeedback))
+        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_NORMAL_FEEDBACK_UAV,       material->normalTextureFeedback))
+        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_EMISSIVE_FEEDBACK_UAV,     material->emissiveTextureFeedback))
+        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_OCCLUSION_FEEDBACK_UAV,    material->occlusionTextureFeedback))
+        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_TRANSMISSION_FEEDBACK_UAV, material->transmissionTextureFeedback))
+        .addItem(GetFeedbackBindingSetItem(FORWARD_BINDING_MATERIAL_OPACITY_FEEDBACK_UAV,      material->opacityTextureFeedback))
     ;
 
     nvrhi::BindingSetHandle bindingSet = m_device->createBindingSet(bindingSetDesc, m_materialBindingLayoutFeedback);
@@ -322,6 +627,18 @@ std::shared_ptr<donut::engine::MaterialBindingCache> NtcForwardShadingPass::Crea
         commonPasses.m_BlackTexture);
 }
 
+NtcForwardShadingPass::~NtcForwardShadingPass()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pipelineMutex);
+        m_stopPrecompile = true;
+    }
+    m_precompileCondition.notify_all();
+
+    if (m_precompileThread.joinable())
+        m_precompileThread.join();
+}
+
 bool NtcForwardShadingPass::Init()
 {
     auto vertexShaderDesc = nvrhi::ShaderDesc()
@@ -353,8 +670,10 @@ bool NtcForwardShadingPass::Init()
 
     m_shadingBindingLayout = m_device->createBindingLayout(shadingLayoutDecs);
 
+    // The NTC material binding sets are also used by the deferred resolve pass, which runs in a compute shader
+    // with the same register spaces, so that every material only needs one binding set for both passes.
     auto materialLayoutDesc = nvrhi::BindingLayoutDesc()
-        .setVisibility(nvrhi::ShaderType::Pixel)
+        .setVisibility(nvrhi::ShaderType::Pixel | nvrhi::ShaderType::Compute)
         .setRegisterSpace(FORWARD_SPACE_MATERIAL)
         .setRegisterSpaceIsDescriptorSet(true)
         .addItem(nvrhi::BindingLayoutItem::ConstantBuffer(FORWARD_BINDING_MATERIAL_CONSTANTS));
@@ -363,13 +682,32 @@ bool NtcForwardShadingPass::Init()
 
     materialLayoutDesc
         .addItem(nvrhi::BindingLayoutItem::ConstantBuffer(FORWARD_BINDING_NTC_MATERIAL_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::ConstantBuffer(FORWARD_BINDING_NTC_STREAMING_CONSTANTS))
         .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_NTC_LATENTS_TEXTURE))
         .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER));
+    AddMipTailBindingLayoutItems(materialLayoutDesc);
 
     m_materialBindingLayout = m_device->createBindingLayout(materialLayoutDesc);
 
-    if (m_device->queryFeatureSupport(nvrhi::Feature::SamplerFeedback))
+    materialLayoutDesc
+        .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(FORWARD_BINDING_NTC_TEXEL_CACHE_UAV));
+
+    m_materialBindingLayoutTexelCache = m_device->createBindingLayout(materialLayoutDesc);
+
+    // Devices without sampler feedback, such as all Vulkan devices, can still render with feedback when they support
+    // tiled resources: the shader writes min mip values into raw buffers instead of sampler feedback textures.
+    bool const samplerFeedbackSupported = m_device->queryFeatureSupport(nvrhi::Feature::SamplerFeedback);
+    m_useFeedbackBuffers = !samplerFeedbackSupported && m_device->queryFeatureSupport(nvrhi::Feature::VirtualResources);
+
+    if (samplerFeedbackSupported || m_useFeedbackBuffers)
     {
+        auto makeFeedbackItem = [this](uint32_t slot)
+        {
+            return m_useFeedbackBuffers
+                ? nvrhi::BindingLayoutItem::RawBuffer_UAV(slot)
+                : nvrhi::BindingLayoutItem::SamplerFeedbackTexture_UAV(slot);
+        };
+
         auto materialLayoutFeedbackDesc = nvrhi::BindingLayoutDesc()
             .setVisibility(nvrhi::ShaderType::Pixel)
             .setRegisterSpace(FORWARD_SPACE_MATERIAL)
@@ -382,17 +720,31 @@ bool NtcForwardShadingPass::Init()
             .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_MATERIAL_OCCLUSION_TEXTURE))
             .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_MATERIAL_TRANSMISSION_TEXTURE))
             .addItem(nvrhi::BindingLayoutItem::Texture_SRV(FORWARD_BINDING_MATERIAL_OPACITY_TEXTURE))
-            .addItem(nvrhi::BindingLayoutItem::SamplerFeedbackTexture_UAV(FORWARD_BINDING_MATERIAL_DIFFUSE_FEEDBACK_UAV))
-            .addItem(nvrhi::BindingLayoutItem::SamplerFeedbackTexture_UAV(FORWARD_BINDING_MATERIAL_SPECULAR_FEEDBACK_UAV))
-            .addItem(nvrhi::BindingLayoutItem::SamplerFeedbackTexture_UAV(FORWARD_BINDING_MATERIAL_NORMAL_FEEDBACK_UAV))
-            .addItem(nvrhi::BindingLayoutItem::SamplerFeedbackTexture_UAV(FORWARD_BINDING_MATERIAL_EMISSIVE_FEEDBACK_UAV))
-            .addItem(nvrhi::BindingLayoutItem::SamplerFeedbackTexture_UAV(FORWARD_BINDING_MATERIAL_OCCLUSION_FEEDBACK_UAV))
-            .addItem(nvrhi::BindingLayoutItem::SamplerFeedbackTexture_UAV(FORWARD_BINDING_MATERIAL_TRANSMISSION_FEEDBACK_UAV))
-            .addItem(nvrhi::BindingLayoutItem::SamplerFeedbackTexture_UAV(FORWARD_BINDING_MATERIAL_OPACITY_FEEDBACK_UAV));
+            .addItem(makeFeedbackItem(FORWARD_BINDING_MATERIAL_DIFFUSE_FEEDBACK_UAV))
+            .addItem(makeFeedbackItem(FORWARD_BINDING_MATERIAL_SPECULAR_FEEDBACK_UAV))
+            .addItem(makeFeedbackItem(FORWARD_BINDING_MATERIAL_NORMAL_FEEDBACK_UAV))
+            .addItem(makeFeedbackItem(FORWARD_BINDING_MATERIAL_EMISSIVE_FEEDBACK_UAV))
+            .addItem(makeFeedbackItem(FORWARD_BINDING_MATERIAL_OCCLUSION_FEEDBACK_UAV))
+            .addItem(makeFeedbackItem(FORWARD_BINDING_MATERIAL_TRANSMISSION_FEEDBACK_UAV))
+            .addItem(makeFeedbackItem(FORWARD_BINDING_MATERIAL_OPACITY_FEEDBACK_UAV));
 
         m_materialBindingLayoutFeedback = m_device->createBindingLayout(materialLayoutFeedbackDesc);
     }
 
+    if (m_useFeedbackBuffers)
+    {
+        // Bound in place of the feedback buffers of missing textures. It is cleared to zero on first use,
+        // and the zero region count in its header makes the shader skip the feedback writes.
+        nvrhi::BufferDesc dummyBufferDesc = {};
+        dummyBufferDesc.byteSize = sizeof(nvfeedback::FeedbackBufferHeader);
+        dummyBufferDesc.canHaveUAVs = true;
+        dummyBufferDesc.canHaveRawViews = true;
+        dummyBufferDesc.initialState = nvrhi::ResourceStates::UnorderedAccess;
+        dummyBufferDesc.keepInitialState = true;
+        dummyBufferDesc.debugName = "DummyFeedbackBuffer";
+        m_dummyFeedbackBuffer = m_device->createBuffer(dummyBufferDesc);
+    }
+
     auto inputBindingLayoutDesc = nvrhi::BindingLayoutDesc()
         .setVisibility(nvrhi::ShaderType::Vertex)
         .setRegisterSpace(FORWARD_SPACE_INPUT)
@@ -439,14 +791,46 @@ bool NtcForwardShadingPass::Init()
 
     m_legacyMaterialBindingCache = CreateLegacyMaterialBindingCache(*m_commonPasses);
 
+    auto deferredViewLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .setRegisterSpace(FORWARD_SPACE_VIEW)
+        .setRegisterSpaceIsDescriptorSet(true)
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(FORWARD_BINDING_VIEW_CONSTANTS));
+
+    m_deferredViewBindingLayout = m_device->createBindingLayout(deferredViewLayoutDesc);
+
+    auto deferredViewBindingSetDesc = nvrhi::BindingSetDesc()
+        .addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_VIEW_CONSTANTS, m_viewConstants));
+
+    m_deferredViewBindingSet = m_device->createBindingSet(deferredViewBindingSetDesc, m_deferredViewBindingLayout);
+
+    auto deferredResolveLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .setRegisterSpace(FORWARD_SPACE_SHADING)
+        .setRegisterSpaceIsDescriptorSet(true)
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(FORWARD_BINDING_LIGHT_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::VolatileConstantBuffer(FORWARD_BINDING_NTC_PASS_CONSTANTS))
+        .addItem(nvrhi::BindingLayoutItem::Sampler(FORWARD_BINDING_LATENTS_SAMPLER))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_DEPTH))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_MATERIAL_ID))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_TEXCOORD))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_TEXCOORD_GRADIENTS))
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(DEFERRED_BINDING_NORMAL_TANGENT))
+        .addItem(nvrhi::BindingLayoutItem::Texture_UAV(DEFERRED_BINDING_COLOR_UAV));
+
+    m_deferredResolveBindingLayout = m_device->createBindingLayout(deferredResolveLayoutDesc);
+
     return true;
 }
 
 void NtcForwardShadingPass::ResetBindingCache()
 {
     m_materialBindingSets.clear();
+    m_materialBindingSetsTexelCache.clear();
     m_materialBindingSetsFeedback.clear();
     m_legacyMaterialBindingCache->Clear();
+    m_deferredBindingCache.Clear();
+    m_texelCacheBuffers.clear();
 }
 
 void NtcForwardShadingPass::PrepareLights(
@@ -479,16 +863,92 @@ donut::engine::ViewType::Enum NtcForwardShadingPass::GetSupportedViewTypes() con
 }
 
 void NtcForwardShadingPass::PreparePass(Context& context, nvrhi::ICommandList* commandList, uint32_t frameIndex,
-    bool useSTF, int stfFilterMode, bool hasDepthPrepass, NtcMode ntcMode, float feedbackThreshold)
+    bool useSTF, int stfFilterMode, bool hasDepthPrepass, NtcMode ntcMode, float feedbackThreshold,
+    float mipBias, bool deferredInference, bool useTexelCache, uint32_t texelCacheMaxAge)
 {
     NtcForwardShadingPassConstants passConstants {};
     passConstants.frameIndex = frameIndex;
     passConstants.stfFilterMode = stfFilterMode;
     passConstants.feedbackThreshold = feedbackThreshold;
+    passConstants.mipBias = mipBias;
+    passConstants.texelCacheMaxAge = texelCacheMaxAge;
     commandList->writeBuffer(m_passConstants, &passConstants, sizeof(passConstants));
+
+    if (useTexelCache)
+    {
+        // The cache entries are updated with atomics that tolerate concurrent draws, see NtcTexelCache.hlsli.
+        // Keep only the first barrier in the command list, which orders the accesses against the previous frame.
+        // Caches of the materials whose binding sets are created later in this frame keep the barriers.
+        for (nvrhi::IBuffer* texelCacheBuffer : m_texelCacheBuffers)
+            commandList->setEnableUavBarriersForBuffer(texelCacheBuffer, false);
+    }
+
+    if (m_dummyFeedbackBuffer && !m_dummyFeedbackBufferCleared)
+    {
+        commandList->clearBufferUInt(m_dummyFeedbackBuffer, 0);
+        m_dummyFeedbackBufferCleared = true;
+    }
+
     context.keyTemplate.hasDepthPrepass = hasDepthPrepass;
     context.keyTemplate.ntcMode = ntcMode;
     context.keyTemplate.useSTF = useSTF;
+    context.keyTemplate.useTexelCache = useTexelCache;
+    context.keyTemplate.deferredFramebuffer = deferredInference && hasDepthPrepass &&
+        (ntcMode == NtcMode::InferenceOnSample || ntcMode == NtcMode::Hybrid);
+    context.deferredMaterials.clear();
+}
+
+void NtcForwardShadingPass::ResolveDeferredMaterials(Context& context, nvrhi::ICommandList* commandList,
+    NtcDeferredTargets const& targets)
+{
+    context.keyTemplate.deferredFramebuffer = false;
+
+    if (context.deferredMaterials.empty())
+        return;
+
+    auto resolveBindingSetDesc = nvrhi::BindingSetDesc()
+        .addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_LIGHT_CONSTANTS, m_lightConstants))
+        .addItem(nvrhi::BindingSetItem::ConstantBuffer(FORWARD_BINDING_NTC_PASS_CONSTANTS, m_passConstants))
+        .addItem(nvrhi::BindingSetItem::Sampler(FORWARD_BINDING_LATENTS_SAMPLER, m_latentSampler))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_DEPTH, targets.depth))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_MATERIAL_ID, targets.materialId))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_TEXCOORD, targets.texCoord))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_TEXCOORD_GRADIENTS, targets.texCoordGradients))
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(DEFERRED_BINDING_NORMAL_TANGENT, targets.normalTangent))
+        .addItem(nvrhi::BindingSetItem::Texture_UAV(DEFERRED_BINDING_COLOR_UAV, targets.color));
+
+    nvrhi::BindingSetHandle resolveBindingSet = m_deferredBindingCache.GetOrCreateBindingSet(
+        resolveBindingSetDesc, m_deferredResolveBindingLayout);
+    if (!resolveBindingSet)
+        return;
+
+    nvrhi::TextureDesc const& colorDesc = targets.color->getDesc();
+
+    // Every material writes a disjoint set of pixels, so the dispatches don't need barriers between them
+    commandList->setEnableUavBarriersForTexture(targets.color, false);
+
+    for (NtcMaterial const* material : context.deferredMaterials)
+    {
+        bool const useTexelCache = context.keyTemplate.useTexelCache && material->ntcTexelCacheBuffer != nullptr;
+        nvrhi::IComputePipeline* pipeline = GetOrCreateDeferredResolvePipeline(material->weightType, useTexelCache);
+        if (!pipeline)
+            continue;
+
+        auto state = nvrhi::ComputeState()
+            .setPipeline(pipeline)
+            .addBindingSet(GetOrCreateMaterialBindingSet(material, useTexelCache))
+            .addBindingSet(m_deferredViewBindingSet)
+            .addBindingSet(resolveBindingSet);
+
+        commandList->setComputeState(state);
+        commandList->dispatch(
+            (colorDesc.width + DEFERRED_RESOLVE_GROUP_SIZE - 1) / DEFERRED_RESOLVE_GROUP_SIZE,
+            (colorDesc.height + DEFERRED_RESOLVE_GROUP_SIZE - 1) / DEFERRED_RESOLVE_GROUP_SIZE);
+    }
+
+    commandList->setEnableUavBarriersForTexture(targets.color, true);
+
+    context.deferredMaterials.clear();
 }
 
 void NtcForwardShadingPass::SetupView(
@@ -522,13 +982,25 @@ bool NtcForwardShadingPass::SetupMaterial(
     key.cullMode = cullMode;
     key.domain = material->domain;
     key.weightType = ntcMaterial->weightType;
+    if (key.ntcMode == NtcMode::Hybrid)
+    {
+        key.ntcMode = ntcMaterial->useTranscodedTextures ? NtcMode::InferenceOnLoad : NtcMode::InferenceOnSample;
+    }
     key.useNtcMaterial = key.ntcMode == NtcMode::InferenceOnSample && ntcMaterial->ntcConstantBuffer != nullptr;
 
+    // Opaque materials using inference on sample can defer the inference to ResolveDeferredMaterials
+    key.deferredMaterial = key.deferredFramebuffer && key.useNtcMaterial && key.hasDepthPrepass &&
+        (key.domain == donut::engine::MaterialDomain::Opaque || key.domain == donut::engine::MaterialDomain::AlphaTested);
+
+    // Same condition as in NormalizePipelineKey, the binding set must match the pipeline layout
+    key.useTexelCache = key.useTexelCache && key.useNtcMaterial && !key.deferredMaterial &&
+        ntcMaterial->ntcTexelCacheBuffer != nullptr;
+
     nvrhi::IBindingSet* materialBindingSet = nullptr;
     switch(key.ntcMode)
     {
         case NtcMode::InferenceOnSample:
-            materialBindingSet = GetOrCreateMaterialBindingSet(ntcMaterial);
+            materialBindingSet = GetOrCreateMaterialBindingSet(ntcMaterial, key.useTexelCache);
             break;
 
         case NtcMode::InferenceOnLoad:
@@ -551,6 +1023,9 @@ bool NtcForwardShadingPass::SetupMaterial(
     if (!pipeline)
         return false;
 
+    if (key.deferredMaterial)
+        context.deferredMaterials.insert(ntcMaterial);
+
     state.pipeline = pipeline;
     state.bindings = { materialBindingSet, context.inputBindingSet, m_viewBindingSet, m_shadingBindingSet };
 
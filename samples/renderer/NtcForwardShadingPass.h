@@ -11,14 +11,40 @@
  */
 
 #include <donut/render/ForwardShadingPass.h>
+#include <donut/engine/BindingCache.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
 struct NtcMaterial;
 
+namespace nvfeedback
+{
+    class FeedbackTexture;
+}
+
 enum class NtcMode
 {
     InferenceOnSample,
     InferenceOnLoad,
-    InferenceOnFeedback
+    InferenceOnFeedback,
+    // Each material uses either InferenceOnSample or InferenceOnLoad, see NtcMaterial::useTranscodedTextures
+    Hybrid
+};
+
+// Targets used by the deferred Inference on Sample path, see NtcForwardShadingPass::ResolveDeferredMaterials.
+// The attribute targets follow the color target in the framebuffer used for opaque geometry.
+struct NtcDeferredTargets
+{
+    nvrhi::ITexture* depth = nullptr;
+    nvrhi::ITexture* color = nullptr;             // RGBA16_FLOAT, needs UAV support
+    nvrhi::ITexture* materialId = nullptr;        // R32_UINT, cleared to 0 before the opaque pass
+    nvrhi::ITexture* texCoord = nullptr;          // RG32_FLOAT
+    nvrhi::ITexture* texCoordGradients = nullptr; // RGBA16_FLOAT
+    nvrhi::ITexture* normalTangent = nullptr;     // RGBA16_FLOAT
 };
 
 class NtcForwardShadingPass : public donut::render::IGeometryPass
@@ -35,6 +61,9 @@ protected:
         NtcMode ntcMode = NtcMode::InferenceOnSample;
         bool useSTF = false;
         bool useNtcMaterial = false;
+        bool deferredFramebuffer = false; // Rendering into the color and deferred attribute targets
+        bool deferredMaterial = false;    // Writing only the attributes, inference runs in ResolveDeferredMaterials
+        bool useTexelCache = false;       // Reusing the decoded texels through NtcMaterial::ntcTexelCacheBuffer
 
         bool operator==(PipelineKey const& other) const
         {
@@ -46,7 +75,10 @@ protected:
                    hasDepthPrepass == other.hasDepthPrepass &&
                    ntcMode == other.ntcMode &&
                    useSTF == other.useSTF &&
-                   useNtcMaterial == other.useNtcMaterial;
+                   useNtcMaterial == other.useNtcMaterial &&
+                   deferredFramebuffer == other.deferredFramebuffer &&
+                   deferredMaterial == other.deferredMaterial &&
+                   useTexelCache == other.useTexelCache;
         }
 
         bool operator!=(PipelineKey const& other) const
@@ -68,6 +100,9 @@ protected:
             nvrhi::hash_combine(hash, s.hasDepthPrepass);
             nvrhi::hash_combine(hash, uint32_t(s.ntcMode));
             nvrhi::hash_combine(hash, s.useSTF);
+            nvrhi::hash_combine(hash, s.deferredFramebuffer);
+            nvrhi::hash_combine(hash, s.deferredMaterial);
+            nvrhi::hash_combine(hash, s.useTexelCache);
             return hash;
         }
     };
@@ -88,22 +123,58 @@ protected:
     nvrhi::SamplerHandle m_latentSampler;
     
     nvrhi::BindingLayoutHandle m_materialBindingLayout;
+    nvrhi::BindingLayoutHandle m_materialBindingLayoutTexelCache;
     nvrhi::BindingLayoutHandle m_emptyMaterialBindingLayout;
     nvrhi::BindingLayoutHandle m_materialBindingLayoutFeedback;
+    nvrhi::BufferHandle m_dummyFeedbackBuffer;
+    bool m_useFeedbackBuffers = false;
+    bool m_dummyFeedbackBufferCleared = false;
     nvrhi::BindingLayoutHandle m_inputBindingLayout;
     std::unordered_map<NtcMaterial const*, nvrhi::BindingSetHandle> m_materialBindingSets;
+    std::unordered_map<NtcMaterial const*, nvrhi::BindingSetHandle> m_materialBindingSetsTexelCache;
     std::unordered_map<NtcMaterial const*, nvrhi::BindingSetHandle> m_materialBindingSetsFeedback;
     std::unordered_map<const donut::engine::BufferGroup*, nvrhi::BindingSetHandle> m_inputBindingSets;
 
+    // Texel cache buffers referenced by the binding sets, see PreparePass
+    std::unordered_set<nvrhi::IBuffer*> m_texelCacheBuffers;
+
+    // Deferred resolve pass resources
+    nvrhi::BindingLayoutHandle m_deferredViewBindingLayout;
+    nvrhi::BindingLayoutHandle m_deferredResolveBindingLayout;
+    nvrhi::BindingSetHandle m_deferredViewBindingSet;
+    std::map<std::pair<int, bool>, nvrhi::ComputePipelineHandle> m_deferredResolvePipelines; // (weightType, useTexelCache) -> pipeline
+    donut::engine::BindingCache m_deferredBindingCache;
+
+    struct PrecompileRequest
+    {
+        PipelineKey key;
+        nvrhi::FramebufferInfo framebufferInfo;
+        bool deferredResolve = false; // Compiling the resolve pipeline for key.weightType and key.useTexelCache
+    };
+
     nvrhi::InputLayoutHandle m_inputLayout;
     nvrhi::ShaderHandle m_vertexShader;
     std::unordered_map<PipelineKey, nvrhi::ShaderHandle, PipelineKeyHash> m_pixelShaders;
     std::unordered_map<PipelineKey, nvrhi::GraphicsPipelineHandle, PipelineKeyHash> m_pipelines;
 
+    // Background pipeline compilation, see PrecompilePipelines.
+    // The mutex protects the shader and pipeline maps, including m_deferredResolvePipelines, and the request queue.
+    mutable std::mutex m_pipelineMutex;
+    std::condition_variable m_precompileCondition;
+    std::deque<PrecompileRequest> m_precompileQueue;
+    std::thread m_precompileThread;
+    bool m_stopPrecompile = false;
+
+    static PipelineKey NormalizePipelineKey(PipelineKey key);
     nvrhi::ShaderHandle GetOrCreatePixelShader(PipelineKey key);
+    nvrhi::GraphicsPipelineHandle CreatePipeline(PipelineKey const& key, nvrhi::FramebufferInfo const& framebufferInfo);
     nvrhi::GraphicsPipelineHandle GetOrCreatePipeline(PipelineKey key, nvrhi::IFramebuffer* framebuffer);
-    nvrhi::BindingSetHandle GetOrCreateMaterialBindingSet(NtcMaterial const* material);
+    void PrecompileThreadProc();
+    nvrhi::BindingSetHandle GetOrCreateMaterialBindingSet(NtcMaterial const* material, bool useTexelCache);
     nvrhi::BindingSetHandle GetOrCreateMaterialBindingSetFeedback(NtcMaterial const* material);
+    nvrhi::ComputePipelineHandle CreateDeferredResolvePipeline(int weightType, bool useTexelCache);
+    nvrhi::ComputePipelineHandle GetOrCreateDeferredResolvePipeline(int weightType, bool useTexelCache);
+    nvrhi::BindingSetItem GetFeedbackBindingSetItem(uint32_t slot, nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> const& texture);
     nvrhi::BindingSetHandle CreateInputBindingSet(const donut::engine::BufferGroup* bufferGroup);
     nvrhi::BindingSetHandle GetOrCreateInputBindingSet(const donut::engine::BufferGroup* bufferGroup);
     std::shared_ptr<donut::engine::MaterialBindingCache> CreateLegacyMaterialBindingCache(donut::engine::CommonRenderPasses& commonPasses);
@@ -115,6 +186,7 @@ public:
     public:
         PipelineKey keyTemplate;
         nvrhi::BindingSetHandle inputBindingSet;
+        std::unordered_set<NtcMaterial const*> deferredMaterials; // Drawn into the attribute targets, not resolved yet
         
         uint32_t positionOffset = 0;
         uint32_t texCoordOffset = 0;
@@ -128,19 +200,47 @@ public:
         : m_device(device)
         , m_commonPasses(commonPasses)
         , m_shaderFactory(shaderFactory)
+        , m_deferredBindingCache(device)
     { }
 
+    ~NtcForwardShadingPass();
+
     bool Init();
     void ResetBindingCache();
 
+    // Creates the pipelines for all permutations that the materials can use in the given modes on a background
+    // thread, so that drawing them for the first time doesn't stall on shader compilation.
+    // The Hybrid mode doesn't need to be listed, it uses the InferenceOnSample and InferenceOnLoad pipelines.
+    // When deferredFramebufferInfo is provided, the pipelines for the deferred attribute pass and the deferred
+    // resolve pipelines are also compiled.
+    void PrecompilePipelines(std::vector<std::shared_ptr<NtcMaterial>> const& materials,
+        std::vector<NtcMode> const& modes, nvrhi::FramebufferInfo const& framebufferInfo,
+        nvrhi::FramebufferInfo const* deferredFramebufferInfo, bool reverseDepth, bool frontCounterClockwise);
+
+    // Returns the number of pipelines that are queued for background compilation.
+    size_t GetNumPendingPipelines() const;
+
     void PrepareLights(
         nvrhi::ICommandList* commandList,
         const std::vector<std::shared_ptr<donut::engine::Light>>& lights,
         dm::float3 ambientColorTop,
         dm::float3 ambientColorBottom);
 
+    // When deferredInference is true, the geometry must be rendered into a framebuffer with the color and
+    // the deferred attribute targets (in the NtcDeferredTargets order), after a depth pre-pass. Opaque materials
+    // using Inference on Sample only write the attributes, and ResolveDeferredMaterials shades them afterwards.
+    // The Inference on Feedback shaders apply mipBias to both the material sampling and the sampler feedback.
+    // When useTexelCache is true, materials with a texel cache buffer reuse the texels decoded in previous frames
+    // for Inference on Sample, and replace the cache entries that haven't been used for texelCacheMaxAge frames.
+    // The frameIndex must increase by one every frame for the cache to work.
     void PreparePass(Context& context, nvrhi::ICommandList* commandList, uint32_t frameIndex,
-        bool useSTF, int stfFilterMode, bool hasDepthPrepass, NtcMode ntcMode, float feedbackThreshold);
+        bool useSTF, int stfFilterMode, bool hasDepthPrepass, NtcMode ntcMode, float feedbackThreshold,
+        float mipBias, bool deferredInference, bool useTexelCache, uint32_t texelCacheMaxAge);
+
+    // Runs the inference and shading for the pixels of all deferred materials drawn with this context,
+    // one compute dispatch per material. Subsequent draws with the context use the regular framebuffer.
+    void ResolveDeferredMaterials(Context& context, nvrhi::ICommandList* commandList,
+        NtcDeferredTargets const& targets);
 
     // IGeometryPass implementation
 
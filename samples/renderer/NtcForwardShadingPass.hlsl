@@ -29,9 +29,7 @@ SamplerState s_LatentSampler : REGISTER_SAMPLER(FORWARD_BINDING_LATENTS_SAMPLER,
 
 #if USE_NTC_MATERIAL
 
-DECLARE_CBUFFER(NtcTextureSetConstants, g_NtcMaterial, FORWARD_BINDING_NTC_MATERIAL_CONSTANTS, FORWARD_SPACE_MATERIAL);
-Texture2DArray t_Latents         : REGISTER_SRV(FORWARD_BINDING_NTC_LATENTS_TEXTURE, FORWARD_SPACE_MATERIAL);
-ByteAddressBuffer t_WeightBuffer : REGISTER_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER, FORWARD_SPACE_MATERIAL);
+#include "NtcMaterialSampling.hlsli"
 
 void GetSamplePositionWithSTF(inout HashBasedRNG rng, float2 uv, out int2 texel, out int mipLevel)
 {
@@ -62,79 +60,7 @@ MaterialTextureSample SampleNtcMaterial(uint2 pixelPosition, float2 uv)
     int2 texel;
     GetSamplePositionWithSTF(rng, uv, texel, mipLevel);
 
-    // The NtcSampleTextureSet... functions can convert all channels to linear color based on metadata stored
-    // in the constant buffer. But that can be relatively slow if not optimized away by the driver.
-    // Since we know the color spaces for all channels in advance, linearize explicitly below.
-    const bool linearizeColorsOnSample = false;
-
-    // Decompress the texel and get all the channels.
-    float channels[NTC_MLP_OUTPUT_CHANNELS];
-#ifdef USE_COOPVEC
-    bool sampleSucceeded = NtcSampleTextureSet_CoopVec_FP8(g_NtcMaterial, t_Latents, s_LatentSampler,
-        t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
-#else
-    bool sampleSucceeded = NtcSampleTextureSet(g_NtcMaterial, t_Latents, s_LatentSampler,
-        t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
-#endif
-
-    // Initialize the 'textures' object with default values, just in case we miss something below.
-    MaterialTextureSample textures = DefaultMaterialTextures();
-    
-    if (!sampleSucceeded)
-        return textures;
-
-    // Distribute the NTC channels into the MaterialTextureSample's fields using a fixed mapping.
-    // The mapping is enforced by the loader, see NtcMaterialLoader.cpp
-    // If some texture channels are not present in the NTC material file, they are replaced with constant values
-    // by the loader.
-    
-    textures.baseOrDiffuse.rgb = float3(
-        channels[CHANNEL_BASE_COLOR + 0],
-        channels[CHANNEL_BASE_COLOR + 1],
-        channels[CHANNEL_BASE_COLOR + 2]);
-
-
-    if (!linearizeColorsOnSample)
-        textures.baseOrDiffuse.rgb = NtcSrgbColorSpace::Decode(textures.baseOrDiffuse.rgb);
-
-    textures.opacity.r = channels[CHANNEL_OPACITY];
-
-    if ((g_Material.flags & MaterialFlags_UseSpecularGlossModel) != 0)
-    {
-        textures.metalRoughOrSpecular.rgb = float3(
-            channels[CHANNEL_SPECULAR_COLOR + 0],
-            channels[CHANNEL_SPECULAR_COLOR + 1],
-            channels[CHANNEL_SPECULAR_COLOR + 2]);
-            
-        if (!linearizeColorsOnSample)
-            textures.metalRoughOrSpecular.rgb = NtcSrgbColorSpace::Decode(textures.metalRoughOrSpecular.rgb);
-        
-        textures.metalRoughOrSpecular.a = channels[CHANNEL_GLOSSINESS];
-    }
-    else
-    {
-        textures.metalRoughOrSpecular.g = channels[CHANNEL_ROUGHNESS];
-        textures.metalRoughOrSpecular.r = channels[CHANNEL_METALNESS];
-    }
-
-    textures.normal.rgb = float3(
-        channels[CHANNEL_NORMAL + 0],
-        channels[CHANNEL_NORMAL + 1],
-        channels[CHANNEL_NORMAL + 2]);
-
-    textures.occlusion.r = channels[CHANNEL_OCCLUSION];
-
-    textures.emissive.rgb = float3(
-        channels[CHANNEL_EMISSIVE + 0],
-        channels[CHANNEL_EMISSIVE + 1],
-        channels[CHANNEL_EMISSIVE + 2]);
-
-    if (!linearizeColorsOnSample)
-        textures.emissive.rgb = NtcSrgbColorSpace::Decode(textures.emissive.rgb);
-    
-    textures.transmission.r = channels[CHANNEL_TRANSMISSION];
-    
-    return textures;
+    return SampleNtcMaterialTexel(s_LatentSampler, texel, mipLevel);
 }
 #endif
 
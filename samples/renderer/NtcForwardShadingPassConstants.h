@@ -15,8 +15,15 @@
  
 // in FORWARD_SPACE_MATERIAL
 #define FORWARD_BINDING_NTC_MATERIAL_CONSTANTS 4
+#define FORWARD_BINDING_NTC_STREAMING_CONSTANTS 5
 #define FORWARD_BINDING_NTC_LATENTS_TEXTURE 0
 #define FORWARD_BINDING_NTC_WEIGHTS_BUFFER 1
+#define FORWARD_BINDING_NTC_MIP_TAIL_BASE_COLOR 2
+#define FORWARD_BINDING_NTC_MIP_TAIL_METAL_ROUGH_OR_SPECULAR 3
+#define FORWARD_BINDING_NTC_MIP_TAIL_NORMAL 4
+#define FORWARD_BINDING_NTC_MIP_TAIL_EMISSIVE 5
+#define FORWARD_BINDING_NTC_MIP_TAIL_OCCLUSION 6
+#define FORWARD_BINDING_NTC_MIP_TAIL_TRANSMISSION 7
 #define FORWARD_BINDING_MATERIAL_DIFFUSE_FEEDBACK_UAV 0
 #define FORWARD_BINDING_MATERIAL_SPECULAR_FEEDBACK_UAV 1
 #define FORWARD_BINDING_MATERIAL_NORMAL_FEEDBACK_UAV 2
@@ -24,17 +31,59 @@
 #define FORWARD_BINDING_MATERIAL_OCCLUSION_FEEDBACK_UAV 4
 #define FORWARD_BINDING_MATERIAL_TRANSMISSION_FEEDBACK_UAV 5
 #define FORWARD_BINDING_MATERIAL_OPACITY_FEEDBACK_UAV 6
+#define FORWARD_BINDING_NTC_TEXEL_CACHE_UAV 7
 
 // in FORWARD_SPACE_SHADING
 #define FORWARD_BINDING_NTC_PASS_CONSTANTS 5
 #define FORWARD_BINDING_STF_SAMPLER 1
 #define FORWARD_BINDING_LATENTS_SAMPLER 2
 
+// in FORWARD_SPACE_SHADING, used by the deferred resolve pass only
+#define DEFERRED_BINDING_DEPTH 0
+#define DEFERRED_BINDING_MATERIAL_ID 1
+#define DEFERRED_BINDING_TEXCOORD 2
+#define DEFERRED_BINDING_TEXCOORD_GRADIENTS 3
+#define DEFERRED_BINDING_NORMAL_TANGENT 4
+#define DEFERRED_BINDING_COLOR_UAV 0
+
+// Thread group size of the deferred resolve pass
+#define DEFERRED_RESOLVE_GROUP_SIZE 8
+
+// Layout of the material ID attribute written by the deferred attribute pass.
+// The ID is MaterialConstants::materialID + 1, zero means that the pixel is shaded by the forward pass.
+#define DEFERRED_MATERIAL_ID_MASK 0x3fffffff
+#define DEFERRED_TANGENT_SIGN_BIT 0x40000000
+#define DEFERRED_BACK_FACE_BIT 0x80000000
+
+// Layout of the texel cache entries, see NtcTexelCache.hlsli: stamp, key, and the channels packed as FP16 pairs
+#define NTC_TEXEL_CACHE_CHANNELS 16
+#define NTC_TEXEL_CACHE_ENTRY_SIZE (8 + NTC_TEXEL_CACHE_CHANNELS * 2)
+#define NTC_TEXEL_CACHE_MAX_DIMENSION 16384 // The key has 14 bits per texel coordinate and 4 bits for the mip level
+
+// Number of NTC channels covered by the mip tail textures, see NtcMaterialSampling.hlsli
+#define NTC_MIP_TAIL_CHANNELS 16
+
 struct NtcForwardShadingPassConstants
 {
     uint frameIndex;
     uint stfFilterMode;
     float feedbackThreshold;
+    float mipBias; // Texture LOD bias of the feedback pass, negative when the image is upscaled
+
+    uint texelCacheMaxAge; // Frames after which an unused texel cache entry can be replaced
+    uint padding0;
+    uint padding1;
+    uint padding2;
+};
+
+// Per-material constants for the latents that are loaded progressively, see NtcMaterialLoader::SetProgressiveLatents,
+// and for the mip tail, see NtcMaterialLoader::SetMipTailMemoryRatio
+struct NtcStreamingConstants
+{
+    int minColorMip; // Finest color mip that can be decoded from the resident latent mips, 0 when all are resident
+    int mipTailFirstMip; // First mip level that is sampled from the transcoded mip tail, 0 when there is no tail
+    uint mipTailChannelMask; // NTC channels that are stored in the mip tail textures
+    int padding0;
 };
 
 #endif // NTC_FORWARD_SHADING_PASS_CONSTANTS_H
\ No newline at end of file
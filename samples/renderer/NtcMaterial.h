@@ -31,10 +31,12 @@ struct TextureTranscodeTask
     int firstChannel = 0;
     int numChannels = 0;
     int mipZeroDescriptor = 0;
+    int feedbackMipZeroDescriptor = -1; // Descriptors of the feedback texture mips for direct tile decoding, or -1
     bool sRGB = false;
     char const* name = nullptr;
     std::shared_ptr<donut::engine::LoadedTexture> NtcMaterial::* pMaterialTexture = nullptr;
     nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> NtcMaterial::* pFeedbackTexture = nullptr;
+    nvrhi::TextureHandle NtcMaterial::* pMipTailTexture = nullptr;
     std::vector<nvrhi::BufferRange> bc7ModeBufferMipRanges;
 
     void ReleaseTextures()
@@ -49,10 +51,38 @@ struct NtcMaterial : public donut::engine::Material
 {
     nvrhi::BufferHandle ntcConstantBuffer;
     nvrhi::BufferHandle ntcWeightsBuffer;
+    nvrhi::BufferRange ntcWeightsRange; // Range of ntcWeightsBuffer, which is shared by multiple materials
     nvrhi::TextureHandle ntcLatentsTexture;
+    nvrhi::BufferHandle ntcStreamingConstantBuffer; // NtcStreamingConstants
+    nvrhi::BufferHandle ntcTexelCacheBuffer; // Decoded texels reused across frames, see NtcMaterialLoader::SetTexelCacheSize
     int weightType = 0;
+
+    // First latent mip level in ntcLatentsTexture, nonzero while the finer mips are being loaded,
+    // see NtcMaterialLoader::SetProgressiveLatents
+    int firstLatentMip = 0;
     size_t transcodedMemorySize = 0;
-    size_t ntcMemorySize = 0;
+    size_t ntcMemorySize = 0; // Includes the mip tail textures, 0 for duplicates that share the resources of another material
+
+    // Coarse mips that are transcoded on load and sampled instead of running inference on sample,
+    // see NtcMaterialLoader::SetMipTailMemoryRatio. The textures start at mipTailFirstMip, 0 means no tail.
+    int mipTailFirstMip = 0;
+    uint32_t mipTailChannelMask = 0;
+    nvrhi::TextureHandle mipTailBaseColorTexture;
+    nvrhi::TextureHandle mipTailMetalRoughOrSpecularTexture;
+    nvrhi::TextureHandle mipTailNormalTexture;
+    nvrhi::TextureHandle mipTailEmissiveTexture;
+    nvrhi::TextureHandle mipTailOcclusionTexture;
+    nvrhi::TextureHandle mipTailTransmissionTexture;
+
+    // Selects the transcoded textures instead of inference on sample in the hybrid mode, see MaterialModePolicy
+    bool useTranscodedTextures = false;
+
+    // Size of the textures created by NtcMaterialLoader::TranscodeMaterialOnDemand, not included in transcodedMemorySize
+    size_t streamedMemorySize = 0;
+
+    // Source of the NTC data, kept when the material is transcoded on demand or its latents are loaded progressively,
+    // see NtcMaterialLoader::SetTranscodeOnDemand and SetProgressiveLatents
+    donut::engine::FilePathOrInlineData ntcSource;
 
     nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> baseOrDiffuseTextureFeedback;
     nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> metalRoughOrSpecularTextureFeedback;
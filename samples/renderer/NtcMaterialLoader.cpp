@@ -13,30 +13,127 @@
 #include "NtcMaterialLoader.h"
 #include "NtcMaterial.h"
 #include "NtcChannelMapping.h"
+#include "MipGenerationPass.h"
 #include <ntc-utils/BufferLoading.h>
 #include <ntc-utils/GraphicsDecompressionPass.h>
 #include <ntc-utils/GraphicsBlockCompressionPass.h>
 #include <ntc-utils/DeviceUtils.h>
+#include <ntc-utils/MappedFile.h>
+#include <ntc-utils/NtcPackage.h>
 
 #include <donut/core/log.h>
 #include <donut/core/string_utils.h>
 #include <donut/core/vfs/VFS.h>
 #include <donut/engine/Scene.h>
+#include <donut/engine/ThreadPool.h>
+#include <donut/core/math/math.h>
 
+#include <algorithm>
+#include <iomanip>
 #include <sstream>
 #include <fstream>
+#include <future>
 
 using namespace donut;
 namespace fs = std::filesystem;
 
+using namespace donut::math;
+#include "NtcForwardShadingPassConstants.h"
+
 // Matches the number of textures in donut::engine::Material
 static const uint32_t g_maxTileStagingTextures = 6;
 
+// Maximum number of descriptors for the feedback texture mips that tiles can be decoded into directly,
+// when block compression is disabled. Textures that don't fit use the staging textures instead.
+static const uint32_t g_maxFeedbackTextureDescriptors = 4096;
+
+// Number of materials that TranscodeMaterialOnDemand can have running on the GPU at the same time,
+// and the number of decompression descriptors that each of them can use. The on-demand transcoding is not
+// compatible with inference on feedback, so these descriptors are taken from the feedback texture range.
+static const int g_maxOnDemandTranscodes = 4;
+static const int g_onDemandTranscodeDescriptors = 128;
+static_assert(g_maxOnDemandTranscodes * g_onDemandTranscodeDescriptors <= g_maxFeedbackTextureDescriptors,
+    "On-demand transcoding descriptors don't fit into the feedback texture range");
+
+// Number of decompression descriptors for transcoding materials while they are loaded. Every transcoding gets
+// its own range until the GPU work of the loaded materials is retired, see AllocateLoadingDescriptors.
+static const int g_loadingTranscodeDescriptors = 1024;
+
+// Size of the file data that the loaded materials can have submitted to the GPU before the loader waits for it
+// and releases the upload buffers, see RetireLoadingWork.
+static const uint64_t g_maxPendingLoadingBytes = uint64_t(512) << 20;
+
 // Skip this many largest latent mips when loading texture sets.
 // Set to nonzero for testing purposes.
 static const int g_firstLatentMipInTexture = 0;
 
-bool NtcMaterialLoader::Init(bool enableCoopVec, bool enableGpuDeflate, bool debug, nvrhi::ITexture* dummyTexture)
+// Materials with progressive latents start with the latent mips whose larger dimension is at most this size,
+// and the finer mips are added one level at a time, see SetProgressiveLatents.
+static const int g_progressiveLatentSize = 128;
+
+// Number of timed decompression runs per weight type in the weight type benchmark
+static const int g_weightTypeBenchmarkIterations = 5;
+
+// Smallest texel cache per material, for the materials with small textures, see SetTexelCacheSize
+static const uint64_t g_minTexelCacheEntries = 4096;
+
+// Maximum number of material files that are opened and parsed ahead of the GPU uploads,
+// limits the number of open files and the memory used by metadata that is not consumed yet.
+static const size_t g_maxMaterialFilesInFlight = 64;
+
+// The inference weights of all materials are packed into shared buffers of this size, see AllocateWeights.
+// Weights of one material take up to 64 KB, so each buffer holds many materials.
+static const uint64_t g_weightAtlasBufferSize = 4 * 1024 * 1024;
+
+// Alignment of the weight ranges in the shared buffers, satisfies the buffer view offset requirements
+// of both graphics APIs and the CoopVec layout conversion.
+static const uint64_t g_weightAtlasAlignment = 256;
+
+// A material that is being loaded, see BeginLoadingMaterials.
+// The streams and metadata are filled by a worker thread, everything else is used on the main thread.
+struct MaterialLoadingTask
+{
+    std::shared_ptr<NtcMaterial> material;
+    // Other materials that use the same NTC data, they receive copies of the loaded resources
+    std::vector<std::shared_ptr<NtcMaterial>> duplicates;
+    donut::engine::FilePathOrInlineData ntcData;
+    MaterialChannelMap channelMap;
+
+    // Use differnt wrappers for file and memory streams because they have different deleter functions...
+    // Files are normally mapped and read through the memory stream, the file stream is a fallback.
+    ntc::FileStreamWrapper fileStream;
+    ntc::MemoryStreamWrapper memoryStream;
+    MappedFile mappedFile;
+    std::vector<uint8_t> packageData; // Entry read from the material package, if the material is in one
+    uint8_t const* streamData = nullptr; // Contents of the memory stream
+    size_t dstorageGroup = 0; // Group of the latent uploads in the loader's DirectStorage batch, if there is one
+    std::shared_ptr<ntc::TextureSetMetadataWrapper> textureSetMetadata;
+
+    bool scheduled = false;
+    std::promise<bool> metadataPromise;
+    std::future<bool> metadataFuture;
+
+    MaterialLoadingTask(ntc::IContext* context)
+        : fileStream(context)
+        , memoryStream(context)
+        , textureSetMetadata(std::make_shared<ntc::TextureSetMetadataWrapper>(context))
+        , metadataFuture(metadataPromise.get_future())
+    { }
+};
+
+NtcMaterialLoader::NtcMaterialLoader(nvrhi::IDevice* device)
+    : m_device(device)
+{ }
+
+NtcMaterialLoader::~NtcMaterialLoader()
+{
+    // The worker threads may still be using the loading tasks
+    if (m_threadPool)
+        m_threadPool->WaitForTasks();
+}
+
+bool NtcMaterialLoader::Init(bool enableCoopVec, bool enableGpuDeflate, bool debug, nvrhi::ITexture* dummyTexture,
+    std::shared_ptr<donut::engine::ShaderFactory> shaderFactory)
 {
     ntc::ContextParameters contextParams;
     contextParams.cudaDevice = ntc::DisableCudaDevice;
@@ -53,6 +150,7 @@ bool NtcMaterialLoader::Init(bool enableCoopVec, bool enableGpuDeflate, bool deb
     contextParams.vkPhysicalDevice = m_device->getNativeObject(nvrhi::ObjectTypes::VK_PhysicalDevice);
     contextParams.vkDevice = m_device->getNativeObject(nvrhi::ObjectTypes::VK_Device);
     contextParams.enableCooperativeVector = osSupportsCoopVec && enableCoopVec;
+    contextParams.pAllocator = &m_allocator;
 
     ntc::Status ntcStatus = ntc::CreateContext(m_ntcContext.ptr(), contextParams);
     if (ntcStatus != ntc::Status::Ok && ntcStatus != ntc::Status::CudaUnavailable)
@@ -67,13 +165,22 @@ bool NtcMaterialLoader::Init(bool enableCoopVec, bool enableGpuDeflate, bool deb
     if (enableGpuDeflate)
     {
         m_gdeflateFeatures = InitGDeflate(m_device, debug);
+
+        // Latents of the materials that don't need transcoding are uploaded through DirectStorage in batches
+        // that span multiple materials, see UpdateLoadingMaterials
+        if (m_gdeflateFeatures && m_gdeflateFeatures->gpuDecompressionSupported &&
+            m_device->getGraphicsAPI() == nvrhi::GraphicsAPI::D3D12)
+        {
+            m_dstorageBatch = std::make_unique<DStorageLoadingBatch>(m_device, m_gdeflateFeatures.get());
+        }
     }
 
     m_dummyTexture = std::make_shared<engine::LoadedTexture>();
     m_dummyTexture->texture = dummyTexture;
 
     m_graphicsDecompressionPass = std::make_shared<GraphicsDecompressionPass>(m_device,
-        /* descriptorTableSize = */ g_maxTileStagingTextures * 2 * TRANSCODE_BATCH_SIZE);
+        /* descriptorTableSize = */ g_maxTileStagingTextures * 2 * TRANSCODE_BATCH_SIZE + g_maxFeedbackTextureDescriptors
+        + g_loadingTranscodeDescriptors);
     if (!m_graphicsDecompressionPass->Init())
         return false;
 
@@ -82,6 +189,10 @@ bool NtcMaterialLoader::Init(bool enableCoopVec, bool enableGpuDeflate, bool deb
     if (!m_graphicsBlockCompressionPass->Init())
         return false;
 
+    m_mipGenerationPass = std::make_shared<MipGenerationPass>(m_device, shaderFactory);
+    if (!m_mipGenerationPass->Init())
+        return false;
+
     m_commandList = m_device->createCommandList(nvrhi::CommandListParameters().setEnableImmediateExecution(false));
 
     // Create a buffer for uploading inference weights before their conversion to CoopVec format
@@ -166,6 +277,9 @@ bool NtcMaterialLoader::Init(bool enableCoopVec, bool enableGpuDeflate, bool deb
     m_texTileBlocksRGOffset = 2 * g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE;
     m_texTileBlocksRGBAOffset = 3 * g_maxTileStagingTextures * TRANSCODE_BATCH_SIZE;
 
+    // Descriptors for the feedback textures follow the descriptors for the staging color textures
+    m_nextFeedbackDescriptor = m_texTileBlocksRGOffset;
+
     return true;
 }
 
@@ -175,8 +289,8 @@ static bool TextureSetHasChannels(uint32_t mask, int first, int count)
     return (mask & test) == test;
 }
 
-static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSetMetadata* textureSetMetadata,
-    MaterialChannelMap const& channelMap, bool onlyAlphaMask)
+static void FillMaterialTranscodeMapping(NtcMaterial const& material, ntc::ITextureSetMetadata* textureSetMetadata,
+    MaterialChannelMap const& channelMap, bool onlyAlphaMask, std::vector<TextureTranscodeTask>& transcodeMapping)
 {
     // Derive the valid channel mask from the shuffle map, because textureSetMetadata->GetValidChannelMask()
     // returns "1" bits for constant channels, and we want to know where actual textures exist.
@@ -200,7 +314,7 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
         if (!opacityChannelPresent)
             return;
 
-        TextureTranscodeTask& opacityTexture = material.transcodeMapping.emplace_back();
+        TextureTranscodeTask& opacityTexture = transcodeMapping.emplace_back();
         opacityTexture.bcFormat = ntc::BlockCompressedFormat::BC4;
         opacityTexture.nvrhiBcFormat = nvrhi::Format::BC4_UNORM;
         opacityTexture.firstChannel = CHANNEL_OPACITY;
@@ -213,7 +327,7 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
     {
         if (TextureSetHasChannels(channelMask, CHANNEL_BASE_COLOR, 3))
         {
-            TextureTranscodeTask& baseColorTexture = material.transcodeMapping.emplace_back();
+            TextureTranscodeTask& baseColorTexture = transcodeMapping.emplace_back();
             baseColorTexture.bcFormat = ntc::BlockCompressedFormat::BC7;
             baseColorTexture.nvrhiBcFormat = nvrhi::Format::BC7_UNORM_SRGB;
             baseColorTexture.firstChannel = CHANNEL_BASE_COLOR;
@@ -222,6 +336,7 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
             baseColorTexture.sRGB = true;
             baseColorTexture.pMaterialTexture = &NtcMaterial::baseOrDiffuseTexture;
             baseColorTexture.pFeedbackTexture = &NtcMaterial::baseOrDiffuseTextureFeedback;
+            baseColorTexture.pMipTailTexture = &NtcMaterial::mipTailBaseColorTexture;
             baseColorTexture.name = "BaseColor";
         }
         
@@ -229,7 +344,7 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
         {
             if (TextureSetHasChannels(channelMask, CHANNEL_SPECULAR_COLOR, 3))
             {
-                TextureTranscodeTask& specularTexture = material.transcodeMapping.emplace_back();
+                TextureTranscodeTask& specularTexture = transcodeMapping.emplace_back();
                 specularTexture.bcFormat = ntc::BlockCompressedFormat::BC7;
                 specularTexture.nvrhiBcFormat = nvrhi::Format::BC7_UNORM_SRGB;
                 specularTexture.firstChannel = CHANNEL_SPECULAR_COLOR;
@@ -238,6 +353,7 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
                 specularTexture.sRGB = true;
                 specularTexture.pMaterialTexture = &NtcMaterial::metalRoughOrSpecularTexture;
                 specularTexture.pFeedbackTexture = &NtcMaterial::metalRoughOrSpecularTextureFeedback;
+                specularTexture.pMipTailTexture = &NtcMaterial::mipTailMetalRoughOrSpecularTexture;
                 specularTexture.name = "SpecularColor";
             }
         }
@@ -245,7 +361,7 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
         {
             if (TextureSetHasChannels(channelMask, CHANNEL_METALNESS, 2))
             {
-                TextureTranscodeTask& metalRoughTexture = material.transcodeMapping.emplace_back();
+                TextureTranscodeTask& metalRoughTexture = transcodeMapping.emplace_back();
                 metalRoughTexture.bcFormat = ntc::BlockCompressedFormat::BC5;
                 metalRoughTexture.nvrhiBcFormat = nvrhi::Format::BC5_UNORM;
                 metalRoughTexture.firstChannel = CHANNEL_METALNESS;
@@ -253,37 +369,40 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
                 static_assert(CHANNEL_ROUGHNESS == CHANNEL_METALNESS + 1);
                 metalRoughTexture.pMaterialTexture = &NtcMaterial::metalRoughOrSpecularTexture;
                 metalRoughTexture.pFeedbackTexture = &NtcMaterial::metalRoughOrSpecularTextureFeedback;
+                metalRoughTexture.pMipTailTexture = &NtcMaterial::mipTailMetalRoughOrSpecularTexture;
                 metalRoughTexture.name = "MetallicRoughness";
             }
             
             if (TextureSetHasChannels(channelMask, CHANNEL_OCCLUSION, 1))
             {
-                TextureTranscodeTask& occlusionTexture = material.transcodeMapping.emplace_back();
+                TextureTranscodeTask& occlusionTexture = transcodeMapping.emplace_back();
                 occlusionTexture.bcFormat = ntc::BlockCompressedFormat::BC4;
                 occlusionTexture.nvrhiBcFormat = nvrhi::Format::BC4_UNORM;
                 occlusionTexture.firstChannel = CHANNEL_OCCLUSION;
                 occlusionTexture.numChannels = 1;
                 occlusionTexture.pMaterialTexture = &NtcMaterial::occlusionTexture;
                 occlusionTexture.pFeedbackTexture = &NtcMaterial::occlusionTextureFeedback;
+                occlusionTexture.pMipTailTexture = &NtcMaterial::mipTailOcclusionTexture;
                 occlusionTexture.name = "Occlusion";
             }
         }
         
         if (TextureSetHasChannels(channelMask, CHANNEL_NORMAL, 3))
         {
-            TextureTranscodeTask& normalTexture = material.transcodeMapping.emplace_back();
+            TextureTranscodeTask& normalTexture = transcodeMapping.emplace_back();
             normalTexture.bcFormat = ntc::BlockCompressedFormat::BC7;
             normalTexture.nvrhiBcFormat = nvrhi::Format::BC7_UNORM;
             normalTexture.firstChannel = CHANNEL_NORMAL;
             normalTexture.numChannels = 3;
             normalTexture.pMaterialTexture = &NtcMaterial::normalTexture;
             normalTexture.pFeedbackTexture = &NtcMaterial::normalTextureFeedback;
+            normalTexture.pMipTailTexture = &NtcMaterial::mipTailNormalTexture;
             normalTexture.name = "Normal";
         }
 
         if (TextureSetHasChannels(channelMask, CHANNEL_EMISSIVE, 3))
         {
-            TextureTranscodeTask& emissiveTexture = material.transcodeMapping.emplace_back();
+            TextureTranscodeTask& emissiveTexture = transcodeMapping.emplace_back();
             emissiveTexture.bcFormat = ntc::BlockCompressedFormat::BC7;
             emissiveTexture.nvrhiBcFormat = nvrhi::Format::BC7_UNORM_SRGB;
             emissiveTexture.firstChannel = CHANNEL_EMISSIVE;
@@ -291,26 +410,28 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
             emissiveTexture.sRGB = true;
             emissiveTexture.pMaterialTexture = &NtcMaterial::emissiveTexture;
             emissiveTexture.pFeedbackTexture = &NtcMaterial::emissiveTextureFeedback;
+            emissiveTexture.pMipTailTexture = &NtcMaterial::mipTailEmissiveTexture;
             emissiveTexture.name = "Emissive";
         }
 
         if (TextureSetHasChannels(channelMask, CHANNEL_TRANSMISSION, 1))
         {
-            TextureTranscodeTask& transmissionTexture = material.transcodeMapping.emplace_back();
+            TextureTranscodeTask& transmissionTexture = transcodeMapping.emplace_back();
             transmissionTexture.bcFormat = ntc::BlockCompressedFormat::BC4;
             transmissionTexture.nvrhiBcFormat = nvrhi::Format::BC4_UNORM;
             transmissionTexture.firstChannel = CHANNEL_TRANSMISSION;
             transmissionTexture.numChannels = 1;
             transmissionTexture.pMaterialTexture = &NtcMaterial::transmissionTexture;
             transmissionTexture.pFeedbackTexture = &NtcMaterial::transmissionTextureFeedback;
+            transmissionTexture.pMipTailTexture = &NtcMaterial::mipTailTransmissionTexture;
             transmissionTexture.name = "Transmission";
         }
     }
 
     ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
-    for (int textureIndex = 0; textureIndex < material.transcodeMapping.size(); ++textureIndex)
+    for (int textureIndex = 0; textureIndex < transcodeMapping.size(); ++textureIndex)
     {
-        TextureTranscodeTask& textureVersions = material.transcodeMapping[textureIndex];
+        TextureTranscodeTask& textureVersions = transcodeMapping[textureIndex];
 
         // Figure out which channels in the original NTC texture set correspond to the channels for this texture
         std::array<int, 4> originalChannels;
@@ -342,29 +463,70 @@ static void FillMaterialTranscodeMapping(NtcMaterial& material, ntc::ITextureSet
     }
 }
 
-static bool LoadMaterialFile(donut::engine::FilePathOrInlineData const& source, NtcMaterial& material,
-    ntc::IContext* ntcContext, ntc::FileStreamWrapper& ntcFile, ntc::MemoryStreamWrapper& ntcMemory,
-    ntc::TextureSetMetadataWrapper& textureSetMetadata)
+// Returns the entry of the material package that replaces the NTC file at 'path', or nullptr if there is none.
+// Entries are named by the file paths relative to the package, see WriteNtcPackage.
+static NtcPackageEntry const* FindMaterialPackageEntry(NtcPackage const* package, std::string const& path)
+{
+    if (!package || path.empty())
+        return nullptr;
+
+    fs::path const packageDir = fs::path(package->GetFileName()).parent_path();
+    std::string const name = fs::absolute(path).lexically_relative(fs::absolute(packageDir)).generic_string();
+    return package->FindEntry(name);
+}
+
+// Opens the NTC data of a material as a stream, see LoadMaterialFile.
+static ntc::IStream* OpenMaterialStream(donut::engine::FilePathOrInlineData const& source,
+    ntc::IContext* ntcContext, NtcPackage const* package, ntc::FileStreamWrapper& ntcFile,
+    ntc::MemoryStreamWrapper& ntcMemory, MappedFile& mappedFile, std::vector<uint8_t>& packageData,
+    uint8_t const*& outStreamData)
 {
-    if (material.name.empty())
-        material.name = "Material";
-    
     ntc::Status ntcStatus;
     ntc::IStream* stream = nullptr;
-
+    outStreamData = nullptr;
+
+    // Map the file when possible, so that the latents and BC7 mode data are uploaded straight from
+    // the mapped pages instead of being read into intermediate buffers first.
+    // Materials from a package are read with one contiguous read of their entry, and used in the same way.
+    uint8_t const* memoryData = nullptr;
+    size_t memorySize = 0;
+    NtcPackageEntry const* packageEntry = source.data ? nullptr : FindMaterialPackageEntry(package, source.path);
     if (source.data)
     {
-        ntcStatus = ntcContext->OpenReadOnlyMemory(source.data->buffer->data(), source.data->buffer->size(),
-            ntcMemory.ptr());
+        memoryData = source.data->buffer->data();
+        memorySize = source.data->buffer->size();
+    }
+    else if (packageEntry)
+    {
+        std::string readError;
+        if (!package->ReadEntry(*packageEntry, packageData, readError))
+        {
+            log::warning("%s", readError.c_str());
+            return nullptr;
+        }
+
+        memoryData = packageData.data();
+        memorySize = packageData.size();
+    }
+    else if (mappedFile.Open(source.path.c_str()))
+    {
+        memoryData = mappedFile.GetData();
+        memorySize = mappedFile.GetSize();
+    }
+
+    if (memoryData)
+    {
+        ntcStatus = ntcContext->OpenReadOnlyMemory(memoryData, memorySize, ntcMemory.ptr());
 
         if (ntcStatus != ntc::Status::Ok)
         {
             log::warning("Cannot open '%s', error code = %s: %s", source.ToString().c_str(),
                 ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-            return false;
+            return nullptr;
         }
 
         stream = ntcMemory.Get();
+        outStreamData = memoryData;
     }
     else
     {
@@ -372,19 +534,32 @@ static bool LoadMaterialFile(donut::engine::FilePathOrInlineData const& source,
         if (ntcStatus == ntc::Status::FileUnavailable)
         {
             log::warning("Material file '%s' does not exist.", source.path.c_str());
-            return false;
+            return nullptr;
         }
         else if (ntcStatus != ntc::Status::Ok)
         {
             log::warning("Cannot open '%s', error code = %s: %s", source.path.c_str(),
                 ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-            return false;
+            return nullptr;
         }
 
         stream = ntcFile.Get();
     }
 
-    ntcStatus = ntcContext->CreateTextureSetMetadataFromStream(stream, textureSetMetadata.ptr());
+    return stream;
+}
+
+static bool LoadMaterialFile(donut::engine::FilePathOrInlineData const& source,
+    ntc::IContext* ntcContext, NtcPackage const* package, ntc::FileStreamWrapper& ntcFile,
+    ntc::MemoryStreamWrapper& ntcMemory, MappedFile& mappedFile, std::vector<uint8_t>& packageData,
+    uint8_t const*& outStreamData, ntc::TextureSetMetadataWrapper& textureSetMetadata)
+{
+    ntc::IStream* stream = OpenMaterialStream(source, ntcContext, package, ntcFile, ntcMemory, mappedFile,
+        packageData, outStreamData);
+    if (!stream)
+        return false;
+
+    ntc::Status ntcStatus = ntcContext->CreateTextureSetMetadataFromStream(stream, textureSetMetadata.ptr());
     if (ntcStatus != ntc::Status::Ok)
     {
         log::warning("Cannot load metadata for '%s', error code = %s: %s", source.ToString().c_str(),
@@ -395,35 +570,55 @@ static bool LoadMaterialFile(donut::engine::FilePathOrInlineData const& source,
     return true;
 }
 
+// One texture of one tile in a TranscodeTiles batch, with the staging textures selected for it
+struct TileTextureTranscodeItem
+{
+    uint32_t tileIndex = 0;
+    int textureIndex = 0;
+    uint32_t colorTextureIndex = 0;
+    uint32_t blockTextureIndex = 0;
+    bool compress = false;
+    bool direct = false; // Decoded directly into the feedback texture, no staging or copy
+};
+
+void NtcMaterialLoader::WriteTileDescriptors()
+{
+    // The staging color textures are persistent, so their descriptors only need to be written once,
+    // unless the descriptor table has been overwritten by TranscodeMaterial in the meantime.
+    if (m_tileDescriptorsValid)
+        return;
+
+    for (uint32_t descriptorIndex = 0; descriptorIndex < m_texTileBlocksRGOffset; ++descriptorIndex)
+    {
+        nvrhi::BindingSetItem descriptor = nvrhi::BindingSetItem::Texture_UAV(
+            descriptorIndex,
+            m_texTranscodeTiles[descriptorIndex]);
+        m_graphicsDecompressionPass->WriteDescriptor(descriptor);
+    }
+
+    m_tileDescriptorsValid = true;
+}
+
 bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& tiles, nvrhi::ICommandList* commandList,
-    bool enableBlockCompression)
+    bool enableBlockCompression, bool enableDirectDecode)
 {
     if (tiles.empty())
         return true;
 
     assert(tiles.size() <= TRANSCODE_BATCH_SIZE);
 
+    WriteTileDescriptors();
+
     // Indices for grabbing the next available texture from the staging textures
     uint32_t texTileColorR8Index = m_texTileColorR8Offset;
     uint32_t texTileColorRGBAIndex = m_texTileColorRGBAOffset;
     uint32_t texTileBlocksRGIndex = m_texTileBlocksRGOffset;
     uint32_t texTileBlocksRGBAIndex = m_texTileBlocksRGBAOffset;
 
-    // Write all descriptors for the color textures into the decompression pass descriptor table
-    for (int descriptorIndex = 0; descriptorIndex < m_texTileBlocksRGOffset; ++descriptorIndex)
-    {
-        nvrhi::BindingSetItem descriptor = nvrhi::BindingSetItem::Texture_UAV(
-            descriptorIndex,
-            m_texTranscodeTiles[descriptorIndex]);
-        m_graphicsDecompressionPass->WriteDescriptor(descriptor);
-    }
-
-    // Indices which map every tile/textureIndex into the list of temporary textures
-    std::vector<uint32_t> colorTextureIndices;
-    std::vector<uint32_t> blockTextureIndices;
-
-    std::array<bool, TRANSCODE_BATCH_SIZE> compressThisTexture;
-
+    // Work items for every tile/textureIndex, in tile order
+    std::vector<TileTextureTranscodeItem> items;
+    items.reserve(tiles.size() * g_maxTileStagingTextures);
+    
     commandList->beginMarker("Transcode Tiles: NTC Decompression");
 
     // Phase 1 - Select the temporary tile textures from the pool and make state transitions
@@ -438,47 +633,71 @@ bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& til
         // TODO: Does this this need to be handled without faulting?
         assert(material.transcodeMapping.empty() == false);
 
+        // All outputs of one decompression pass share the destination offset, so a tile can only be decoded
+        // directly into the feedback textures if that is possible for all of its textures.
+        bool directTile = enableDirectDecode;
+        for (const TextureTranscodeTask& transcodeTask : material.transcodeMapping)
+        {
+            bool const compress = transcodeTask.bcFormat != ntc::BlockCompressedFormat::None
+                && enableBlockCompression;
+            if (compress || transcodeTask.feedbackMipZeroDescriptor < 0)
+                directTile = false;
+        }
+
         for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
         {
             const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
 
-            bool const isSingleChannel = transcodeTask.numChannels == 1;
+            TileTextureTranscodeItem& item = items.emplace_back();
+            item.tileIndex = uint32_t(tileIndex);
+            item.textureIndex = textureIndex;
+
+            if (directTile)
+            {
+                item.direct = true;
+                item.colorTextureIndex = transcodeTask.feedbackMipZeroDescriptor + transcodeTile.tileInfo.mip;
+
+                nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
+                commandList->setTextureState(pDestTexture, nvrhi::AllSubresources,
+                    nvrhi::ResourceStates::UnorderedAccess);
+                continue;
+            }
 
             // Select the color texture
-            uint32_t colorTextureIndex = isSingleChannel ? texTileColorR8Index++ : texTileColorRGBAIndex++;
-            colorTextureIndices.push_back(colorTextureIndex);
+            bool const isSingleChannel = transcodeTask.numChannels == 1;
+            item.colorTextureIndex = isSingleChannel ? texTileColorR8Index++ : texTileColorRGBAIndex++;
 
-            compressThisTexture[tileIndex] = transcodeTask.bcFormat != ntc::BlockCompressedFormat::None
-                && enableBlockCompression;
-            if (compressThisTexture[tileIndex])
+            item.compress = transcodeTask.bcFormat != ntc::BlockCompressedFormat::None && enableBlockCompression;
+            if (item.compress)
             {
                 // Select the block texture
                 bool const isSmallBlock =
                     (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC1) ||
                     (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC4);
 
-                uint32_t blockTextureIndex = isSmallBlock ? texTileBlocksRGIndex++ : texTileBlocksRGBAIndex++;
-                blockTextureIndices.push_back(blockTextureIndex);
+                item.blockTextureIndex = isSmallBlock ? texTileBlocksRGIndex++ : texTileBlocksRGBAIndex++;
 
                 // Disable automatic UAV barriers for the block texture
-                commandList->setEnableUavBarriersForTexture(m_texTranscodeTiles[blockTextureIndex], false);
+                commandList->setEnableUavBarriersForTexture(m_texTranscodeTiles[item.blockTextureIndex], false);
             }
 
             // Transition to UAV
-            commandList->setTextureState(m_texTranscodeTiles[colorTextureIndex], nvrhi::AllSubresources,
+            commandList->setTextureState(m_texTranscodeTiles[item.colorTextureIndex], nvrhi::AllSubresources,
                 nvrhi::ResourceStates::UnorderedAccess);
         }
     }
 
     commandList->commitBarriers();
 
-    // Phase 2 - Run NTC decompression
+    // Phase 2 - Run NTC decompression.
+    // LibNTC produces one compute pass per texture set, mip and rectangle, so this is one dispatch per tile.
+    // The items of each tile are contiguous, and the tiles of one material are contiguous in the batch,
+    // so the latent and weight bindings only change between materials.
 
     static_assert(TRANSCODE_BATCH_SIZE <= 32, "successfulTilesMask assumes no more than 32 tiles per batch");
     uint32_t successfulTilesMask = 0;
 
-    uint32_t colorTextureIndex = 0;
-    uint32_t blockTextureIndex = 0;
+    size_t firstItemOfTile = 0;
     for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
     {
         const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
@@ -492,12 +711,15 @@ bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& til
         int textureCount = int(material.transcodeMapping.size());
         assert(textureCount <= g_maxTileStagingTextures); // Maximum number of textures supported
 
+        size_t const tileFirstItem = firstItemOfTile;
+        firstItemOfTile += textureCount;
+
         // Make sure that the latent and weight buffers have already been created
         assert(material.ntcLatentsTexture);
         assert(material.ntcWeightsBuffer);
 
         m_graphicsDecompressionPass->SetLatentTexture(material.ntcLatentsTexture);
-        m_graphicsDecompressionPass->SetWeightBuffer(material.ntcWeightsBuffer);
+        m_graphicsDecompressionPass->SetWeightBuffer(material.ntcWeightsBuffer, material.ntcWeightsRange);
 
         ntc::Rect rectDecompress;
         rectDecompress.left = tileInfo.xInTexels;
@@ -505,9 +727,11 @@ bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& til
         rectDecompress.width = std::min(tileInfo.widthInTexels, mipWidth); // Tiles can be block sizes of 4x4 while the mip could be smaller
         rectDecompress.height = std::min(tileInfo.heightInTexels, mipHeight);
 
+        // Direct tiles are written at their location in the feedback texture mip, staged tiles at the origin
+        bool const directTile = items[tileFirstItem].direct;
         ntc::Point offsetDecompress;
-        offsetDecompress.x = 0;
-        offsetDecompress.y = 0;
+        offsetDecompress.x = directTile ? tileInfo.xInTexels : 0;
+        offsetDecompress.y = directTile ? tileInfo.yInTexels : 0;
         
         std::array<ntc::OutputTextureDesc, g_maxTileStagingTextures> outputTextureDescs;
         for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
@@ -516,7 +740,7 @@ bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& til
             ntc::OutputTextureDesc& outputDesc = outputTextureDescs[textureIndex];
             outputDesc.firstChannel = transcodeTask.firstChannel;
             outputDesc.numChannels = transcodeTask.numChannels;
-            outputDesc.descriptorIndex = colorTextureIndices[colorTextureIndex++];
+            outputDesc.descriptorIndex = items[tileFirstItem + textureIndex].colorTextureIndex;
             outputDesc.rgbColorSpace = transcodeTask.sRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
             outputDesc.ditherScale = 1.f / 255.f;
         }
@@ -540,111 +764,109 @@ bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& til
             continue;
         }
 
-        m_graphicsDecompressionPass->ExecuteComputePass(commandList, decompressionPass);
+        if (!m_graphicsDecompressionPass->ExecuteComputePass(commandList, decompressionPass))
+            continue;
 
         successfulTilesMask |= (1 << tileIndex);
     }
 
     commandList->endMarker();
 
-    // Phase 3 - Compress all mips of the color textures into BCn, where necessary
+    // Drop the items of the tiles that failed to decompress, and the items that are already complete
+    // because they were decoded directly into the feedback textures
+    items.erase(std::remove_if(items.begin(), items.end(), [successfulTilesMask](TileTextureTranscodeItem const& item)
+    {
+        return (successfulTilesMask & (1 << item.tileIndex)) == 0 || item.direct;
+    }), items.end());
+
+    // Phase 3 - Compress the color textures into BCn, where necessary
 
     commandList->beginMarker("Transcode Tiles: BCn Compression");
 
-    // Transition textures for BCn compression
-    colorTextureIndex = 0;
-    blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
+    // Transition textures for BCn compression, all at once
+    std::vector<TileTextureTranscodeItem const*> compressionItems;
+    for (TileTextureTranscodeItem const& item : items)
     {
-        if ((successfulTilesMask & (1 << tileIndex)) == 0)
+        if (!item.compress)
             continue;
-            
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
-        const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
-        const NtcMaterial& material = *transcodeTile.material;
-        int textureCount = int(material.transcodeMapping.size());
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
-        {
-            nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[colorTextureIndices[colorTextureIndex++]];
-            if (compressThisTexture[tileIndex])
-            {
-                nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[blockTextureIndices[blockTextureIndex++]];
-                commandList->setTextureState(colorTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::ShaderResource);
-                commandList->setTextureState(blockTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::UnorderedAccess);
-            }
-        }
+
+        commandList->setTextureState(m_texTranscodeTiles[item.colorTextureIndex], nvrhi::AllSubresources,
+            nvrhi::ResourceStates::ShaderResource);
+        commandList->setTextureState(m_texTranscodeTiles[item.blockTextureIndex], nvrhi::AllSubresources,
+            nvrhi::ResourceStates::UnorderedAccess);
+        compressionItems.push_back(&item);
     }
     commandList->commitBarriers();
 
-    colorTextureIndex = 0;
-    blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
+    // Group the compression passes by format and mode buffer usage, which determine the compression shader,
+    // so that the passes using the same pipeline are issued back to back.
+    auto getCompressionShaderKey = [&tiles](TileTextureTranscodeItem const* item)
     {
-        if ((successfulTilesMask & (1 << tileIndex)) == 0)
-            continue;
-            
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
+        TranscodeTileInfo const& transcodeTile = tiles[item->tileIndex];
+        TextureTranscodeTask const& transcodeTask = transcodeTile.material->transcodeMapping[item->textureIndex];
+        bool const useModeBuffer = transcodeTask.bc7ModeBuffer &&
+            transcodeTask.bc7ModeBufferMipRanges[transcodeTile.tileInfo.mip].byteSize != 0;
+        return int(transcodeTask.bcFormat) * 2 + (useModeBuffer ? 1 : 0);
+    };
+    std::stable_sort(compressionItems.begin(), compressionItems.end(),
+        [&getCompressionShaderKey](TileTextureTranscodeItem const* a, TileTextureTranscodeItem const* b)
+    {
+        return getCompressionShaderKey(a) < getCompressionShaderKey(b);
+    });
+
+    for (TileTextureTranscodeItem const* item : compressionItems)
+    {
+        const TranscodeTileInfo& transcodeTile = tiles[item->tileIndex];
         const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
         const NtcMaterial& material = *transcodeTile.material;
+        const TextureTranscodeTask& transcodeTask = material.transcodeMapping[item->textureIndex];
 
-        ntc::ITextureSetMetadata* textureSetMetadata = material.textureSetMetadata->Get();
-        ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+        ntc::TextureSetDesc const& textureSetDesc = material.textureSetMetadata->Get()->GetDesc();
         const uint32_t mipWidth = std::max(1, textureSetDesc.width >> tileInfo.mip);
         const uint32_t mipHeight = std::max(1, textureSetDesc.height >> tileInfo.mip);
-        int textureCount = int(material.transcodeMapping.size());
-        assert(textureCount <= g_maxTileStagingTextures); // Maximum number of textures supported
-
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
-        {
-            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
 
-            nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[colorTextureIndices[colorTextureIndex++]];
+        nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[item->colorTextureIndex];
+        nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[item->blockTextureIndex];
+        float const alphaThreshold = 1.f / 255.f;
 
-            if (compressThisTexture[tileIndex])
-            {
-                nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[blockTextureIndices[blockTextureIndex++]];
-                float const alphaThreshold = 1.f / 255.f;
-
-                ntc::MakeBlockCompressionComputePassParameters compressionParams;
-                // Tiles can be block sizes of 4x4 while the mip is smaller
-                compressionParams.srcRect.width = std::min(tileInfo.widthInTexels, mipWidth);
-                compressionParams.srcRect.height = std::min(tileInfo.heightInTexels, mipHeight);
-                compressionParams.dstFormat = transcodeTask.bcFormat;
-                compressionParams.alphaThreshold = alphaThreshold;
-                nvrhi::IBuffer* modeBuffer = nullptr;
-                if (transcodeTask.bc7ModeBuffer && transcodeTask.bc7ModeBufferMipRanges[tileInfo.mip].byteSize != 0)
-                {
-                    compressionParams.modeBufferSource = ntc::BlockCompressionModeBufferSource::TextureSet;
-                    compressionParams.modeBufferByteOffset = transcodeTask.bc7ModeBufferMipRanges[tileInfo.mip].byteOffset;
-                    compressionParams.modeBufferInfo.textureSet.texture = transcodeTask.metadata;
-                    compressionParams.modeBufferInfo.textureSet.mipLevel = tileInfo.mip;
-                    compressionParams.modeMapOffsetInBlocks.x = tileInfo.xInTexels >> 2;
-                    compressionParams.modeMapOffsetInBlocks.y = tileInfo.yInTexels >> 2;
-                    modeBuffer = transcodeTask.bc7ModeBuffer;
-                }
-                else
-                {
-                    compressionParams.modeBufferSource = ntc::BlockCompressionModeBufferSource::None;
-                }
-                ntc::ComputePassDesc compressionPass;
-                ntc::Status ntcStatus = m_ntcContext->MakeBlockCompressionComputePass(compressionParams, &compressionPass);
+        ntc::MakeBlockCompressionComputePassParameters compressionParams;
+        // Tiles can be block sizes of 4x4 while the mip is smaller
+        compressionParams.srcRect.width = std::min(tileInfo.widthInTexels, mipWidth);
+        compressionParams.srcRect.height = std::min(tileInfo.heightInTexels, mipHeight);
+        compressionParams.dstFormat = transcodeTask.bcFormat;
+        compressionParams.alphaThreshold = alphaThreshold;
+        nvrhi::IBuffer* modeBuffer = nullptr;
+        if (transcodeTask.bc7ModeBuffer && transcodeTask.bc7ModeBufferMipRanges[tileInfo.mip].byteSize != 0)
+        {
+            compressionParams.modeBufferSource = ntc::BlockCompressionModeBufferSource::TextureSet;
+            compressionParams.modeBufferByteOffset = transcodeTask.bc7ModeBufferMipRanges[tileInfo.mip].byteOffset;
+            compressionParams.modeBufferInfo.textureSet.texture = transcodeTask.metadata;
+            compressionParams.modeBufferInfo.textureSet.mipLevel = tileInfo.mip;
+            compressionParams.modeMapOffsetInBlocks.x = tileInfo.xInTexels >> 2;
+            compressionParams.modeMapOffsetInBlocks.y = tileInfo.yInTexels >> 2;
+            modeBuffer = transcodeTask.bc7ModeBuffer;
+        }
+        else
+        {
+            compressionParams.modeBufferSource = ntc::BlockCompressionModeBufferSource::None;
+        }
+        ntc::ComputePassDesc compressionPass;
+        ntc::Status ntcStatus = m_ntcContext->MakeBlockCompressionComputePass(compressionParams, &compressionPass);
 
-                if (ntcStatus != ntc::Status::Ok)
-                {
-                    log::warning("Failed to make a block compression pass for material '%s', error code = %s: %s",
-                        material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-                    return false;
-                }
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            log::warning("Failed to make a block compression pass for material '%s', error code = %s: %s",
+                material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            return false;
+        }
 
-                nvrhi::Format const inputFormat = (transcodeTask.numChannels == 1)
-                    ? nvrhi::Format::R8_UNORM
-                    : nvrhi::Format::RGBA8_UNORM;
+        nvrhi::Format const inputFormat = (transcodeTask.numChannels == 1)
+            ? nvrhi::Format::R8_UNORM
+            : nvrhi::Format::RGBA8_UNORM;
 
-                if (!m_graphicsBlockCompressionPass->ExecuteComputePass(commandList, compressionPass,
-                    colorTexture, inputFormat, 0, modeBuffer, blockTexture, 0))
-                    return false;
-            }
-        }
+        if (!m_graphicsBlockCompressionPass->ExecuteComputePass(commandList, compressionPass,
+            colorTexture, inputFormat, 0, modeBuffer, blockTexture, 0))
+            return false;
     }
     commandList->endMarker();
 
@@ -653,109 +875,67 @@ bool NtcMaterialLoader::TranscodeTiles(const std::vector<TranscodeTileInfo>& til
     commandList->beginMarker("Transcode Tiles: Copy to Tiled Resources");
 
     // Transition textures for copying
-    colorTextureIndex = 0;
-    blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
+    for (TileTextureTranscodeItem const& item : items)
     {
-        if ((successfulTilesMask & (1 << tileIndex)) == 0)
-            continue;
-            
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
-        const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
-        const NtcMaterial& material = *transcodeTile.material;
-        int textureCount = int(material.transcodeMapping.size());
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
-        {
-            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
-            nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
-            commandList->setTextureState(pDestTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
-            
-            nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[colorTextureIndices[colorTextureIndex++]];
-            if (compressThisTexture[tileIndex])
-            {
-                nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[blockTextureIndices[blockTextureIndex++]];
-                commandList->setTextureState(blockTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopySource);
-            }
-            else
-            {
-                commandList->setTextureState(colorTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopySource);
-            }
-        }
+        const NtcMaterial& material = *tiles[item.tileIndex].material;
+        const TextureTranscodeTask& transcodeTask = material.transcodeMapping[item.textureIndex];
+        nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
+        commandList->setTextureState(pDestTexture, nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
+
+        uint32_t const sourceTextureIndex = item.compress ? item.blockTextureIndex : item.colorTextureIndex;
+        commandList->setTextureState(m_texTranscodeTiles[sourceTextureIndex], nvrhi::AllSubresources,
+            nvrhi::ResourceStates::CopySource);
     }
     commandList->commitBarriers();
 
-    colorTextureIndex = 0;
-    blockTextureIndex = 0;
-    for (size_t tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
+    for (TileTextureTranscodeItem const& item : items)
     {
-        if ((successfulTilesMask & (1 << tileIndex)) == 0)
-            continue;
-            
-        const TranscodeTileInfo& transcodeTile = tiles[tileIndex];
+        const TranscodeTileInfo& transcodeTile = tiles[item.tileIndex];
         const nvfeedback::FeedbackTextureTileInfo tileInfo = transcodeTile.tileInfo;
         const NtcMaterial& material = *transcodeTile.material;
-
-        ntc::ITextureSetMetadata* textureSetMetadata = material.textureSetMetadata->Get();
-        ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
-        const uint32_t mipWidth = std::max(1, textureSetDesc.width >> tileInfo.mip);
-        const uint32_t mipHeight = std::max(1, textureSetDesc.height >> tileInfo.mip);
-        int textureCount = int(material.transcodeMapping.size());
-        assert(textureCount <= g_maxTileStagingTextures); // Maximum number of textures supported
-
-        for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
+        const TextureTranscodeTask& transcodeTask = material.transcodeMapping[item.textureIndex];
+        nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
+
+        nvrhi::TextureSlice textureSliceDst = {};
+        textureSliceDst.x = tileInfo.xInTexels;
+        textureSliceDst.y = tileInfo.yInTexels;
+        textureSliceDst.z = 0;
+        textureSliceDst.mipLevel = tileInfo.mip;
+        textureSliceDst.width = tileInfo.widthInTexels;
+        textureSliceDst.height = tileInfo.heightInTexels;
+        textureSliceDst.depth = 1;
+
+        nvrhi::TextureSlice textureSliceSrc = {};
+        textureSliceSrc.x = 0;
+        textureSliceSrc.y = 0;
+        textureSliceSrc.z = 0;
+        textureSliceSrc.mipLevel = 0;
+        textureSliceSrc.depth = 1;
+
+        if (item.compress)
         {
-            const TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
-            nvrhi::ITexture* pDestTexture = (material.*transcodeTask.pFeedbackTexture)->GetReservedTexture();
-
-            nvrhi::TextureSlice textureSliceDst = {};
-            textureSliceDst.x = tileInfo.xInTexels;
-            textureSliceDst.y = tileInfo.yInTexels;
-            textureSliceDst.z = 0;
-            textureSliceDst.mipLevel = tileInfo.mip;
-            textureSliceDst.width = tileInfo.widthInTexels;
-            textureSliceDst.height = tileInfo.heightInTexels;
-            textureSliceDst.depth = 1;
+            textureSliceSrc.width = (tileInfo.widthInTexels + 3) / 4;
+            textureSliceSrc.height = (tileInfo.heightInTexels + 3) / 4;
 
-            nvrhi::TextureHandle colorTexture = m_texTranscodeTiles[colorTextureIndices[colorTextureIndex++]];
+            commandList->copyTexture(pDestTexture, textureSliceDst, m_texTranscodeTiles[item.blockTextureIndex],
+                textureSliceSrc);
+        }
+        else
+        {
+            textureSliceSrc.width = tileInfo.widthInTexels;
+            textureSliceSrc.height = tileInfo.heightInTexels;
 
-            if (compressThisTexture[tileIndex])
-            {
-                nvrhi::TextureHandle blockTexture = m_texTranscodeTiles[blockTextureIndices[blockTextureIndex++]];
-
-                nvrhi::TextureSlice textureSliceSrc = {};
-                textureSliceSrc.x = 0;
-                textureSliceSrc.y = 0;
-                textureSliceSrc.z = 0;
-                textureSliceSrc.mipLevel = 0;
-                textureSliceSrc.width = (tileInfo.widthInTexels + 3) / 4;
-                textureSliceSrc.height = (tileInfo.heightInTexels + 3) / 4;
-                textureSliceSrc.depth = 1;
-
-                commandList->copyTexture(pDestTexture, textureSliceDst, blockTexture, textureSliceSrc);
-            }
-            else
-            {
-                nvrhi::TextureSlice textureSliceSrc = {};
-                textureSliceSrc.x = 0;
-                textureSliceSrc.y = 0;
-                textureSliceSrc.z = 0;
-                textureSliceSrc.mipLevel = 0;
-                textureSliceSrc.width = tileInfo.widthInTexels;
-                textureSliceSrc.height = tileInfo.heightInTexels;
-                textureSliceSrc.depth = 1;
-
-                commandList->copyTexture(pDestTexture, textureSliceDst, colorTexture, textureSliceSrc);
-            }
+            commandList->copyTexture(pDestTexture, textureSliceDst, m_texTranscodeTiles[item.colorTextureIndex],
+                textureSliceSrc);
         }
     }
     commandList->endMarker();
 
-
     return true;
 }
 
 bool NtcMaterialLoader::CreateAndLoadModeBufferForTexture(ntc::IContext* ntcContext, ntc::IStream* ntcFile,
-    ntc::ITextureSetMetadata* textureSetMetadata, TextureTranscodeTask& transcodeTask,
+    uint8_t const* ntcFileData, ntc::ITextureSetMetadata* textureSetMetadata, TextureTranscodeTask& transcodeTask,
     nvrhi::ICommandList* commandList, std::string const& materialTextureName)
 {
     ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
@@ -766,9 +946,10 @@ bool NtcMaterialLoader::CreateAndLoadModeBufferForTexture(ntc::IContext* ntcCont
     size_t tempBufferSize = 0;
     size_t finalBufferSize = 0;
 
-    FillBufferLoadingTasksForBC(textureSetDesc, transcodeTask.metadata, modeBufferTasks,
+    if (!FillBufferLoadingTasksForBC(textureSetDesc, transcodeTask.metadata, modeBufferTasks,
         m_gdeflateFeatures && m_gdeflateFeatures->gpuDecompressionSupported, m_device->getGraphicsAPI(),
-        stagingBufferSize, tempBufferSize, finalBufferSize);
+        stagingBufferSize, tempBufferSize, finalBufferSize, ntcFileData, ntcFileData ? ntcFile->Size() : 0))
+        return false;
     
     if (!ExecuteBufferLoadingTasks(m_device, commandList, ntcContext, ntcFile, m_gdeflateFeatures.get(),
         modeBufferTasks, transcodeTask.bc7ModeBuffer, stagingBufferSize, tempBufferSize, finalBufferSize))
@@ -785,33 +966,44 @@ bool NtcMaterialLoader::CreateAndLoadModeBufferForTexture(ntc::IContext* ntcCont
     return true;
 }
 
-bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream* ntcFile,
-    ntc::ITextureSetMetadata* textureSetMetadata,
-    NtcMaterial& material, nvrhi::ICommandList* commandList, bool enableBlockCompression)
+bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream* ntcFile, uint8_t const* ntcFileData,
+    ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material,
+    std::vector<TextureTranscodeTask>& transcodeMapping, int firstMip, nvrhi::ICommandList* commandList,
+    bool enableBlockCompression, int firstDescriptor)
 {
-    if (material.transcodeMapping.empty())
+    if (transcodeMapping.empty())
         return true;
 
-    int const textureCount = int(material.transcodeMapping.size());
+    int const textureCount = int(transcodeMapping.size());
+
+    // The textures of a mip tail start at firstMip, so their mip levels are offset from the texture set's mip levels
+    bool const isMipTail = firstMip > 0;
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+    int const width = std::max(textureSetDesc.width >> firstMip, 1);
+    int const height = std::max(textureSetDesc.height >> firstMip, 1);
+    int const mips = textureSetDesc.mips - firstMip;
 
     // Phase 1 - Create textures (color, block, BCn) and write descriptors for NTC decompression
 
-    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
     for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
     {
-        TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+        TextureTranscodeTask& transcodeTask = transcodeMapping[textureIndex];
         std::string const materialTextureName = material.name + ":" + std::string(transcodeTask.name);
 
-        // Create the color texture
+        // Create the color texture.
+        // The mip tail is sampled with loads, which return the sRGB-encoded values that the shaders decode
+        // like the NTC channels, so it uses non-sRGB formats.
+
+        bool const sRGBFormat = transcodeTask.sRGB && !isMipTail;
 
         nvrhi::TextureDesc colorTextureDesc = nvrhi::TextureDesc()
             .setDimension(nvrhi::TextureDimension::Texture2D)
-            .setWidth(textureSetDesc.width)
-            .setHeight(textureSetDesc.height)
-            .setMipLevels(textureSetDesc.mips)
+            .setWidth(width)
+            .setHeight(height)
+            .setMipLevels(mips)
             .setFormat((transcodeTask.numChannels == 1)
                 ? nvrhi::Format::R8_UNORM
-                : transcodeTask.sRGB
+                : sRGBFormat
                     ? nvrhi::Format::SRGBA8_UNORM
                     : nvrhi::Format::RGBA8_UNORM)
             .setDebugName(materialTextureName)
@@ -832,10 +1024,12 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
 
             nvrhi::TextureDesc compressedTextureDesc = nvrhi::TextureDesc()
                 .setDimension(nvrhi::TextureDimension::Texture2D)
-                .setFormat(transcodeTask.nvrhiBcFormat)
-                .setWidth(textureSetDesc.width)
-                .setHeight(textureSetDesc.height)
-                .setMipLevels(textureSetDesc.mips)
+                .setFormat((!sRGBFormat && transcodeTask.nvrhiBcFormat == nvrhi::Format::BC7_UNORM_SRGB)
+                    ? nvrhi::Format::BC7_UNORM
+                    : transcodeTask.nvrhiBcFormat)
+                .setWidth(width)
+                .setHeight(height)
+                .setMipLevels(mips)
                 .setDebugName(materialTextureName)
                 .setInitialState(nvrhi::ResourceStates::ShaderResource)
                 .setKeepInitialState(true);
@@ -850,10 +1044,23 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
                 (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC1) ||
                 (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC4);
 
+            // All mips are compressed in one batch, so every mip gets its own level in the block texture.
+            // Block counts are rounded up on every mip, which can exceed the mip chain of mip 0 block counts.
+            uint32_t blockTextureWidth = 1;
+            uint32_t blockTextureHeight = 1;
+            for (int mipLevel = 0; mipLevel < mips; ++mipLevel)
+            {
+                uint32_t const mipWidth = std::max(width >> mipLevel, 1);
+                uint32_t const mipHeight = std::max(height >> mipLevel, 1);
+                blockTextureWidth = std::max(blockTextureWidth, ((mipWidth + 3) / 4) << mipLevel);
+                blockTextureHeight = std::max(blockTextureHeight, ((mipHeight + 3) / 4) << mipLevel);
+            }
+
             nvrhi::TextureDesc blockTextureDesc = nvrhi::TextureDesc()
                 .setDimension(nvrhi::TextureDimension::Texture2D)
-                .setWidth((textureSetDesc.width + 3) / 4)
-                .setHeight((textureSetDesc.height + 3) / 4)
+                .setWidth(blockTextureWidth)
+                .setHeight(blockTextureHeight)
+                .setMipLevels(mips)
                 .setFormat(isSmallBlock ? nvrhi::Format::RG32_UINT : nvrhi::Format::RGBA32_UINT)
                 .setDebugName(materialTextureName)
                 .setIsUAV(true)
@@ -866,17 +1073,17 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
 
             if (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC7)
             {
-                if (!CreateAndLoadModeBufferForTexture(context, ntcFile, textureSetMetadata, transcodeTask,
+                if (!CreateAndLoadModeBufferForTexture(context, ntcFile, ntcFileData, textureSetMetadata, transcodeTask,
                     commandList, materialTextureName))
                     return false;
             }
         }
         
         // Descriptors for all mip levels of one texture are packed together
-        transcodeTask.mipZeroDescriptor = textureSetDesc.mips * textureIndex;
+        transcodeTask.mipZeroDescriptor = firstDescriptor + mips * textureIndex;
 
         // Write descriptors for all mips of the color texture
-        for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+        for (int mipLevel = 0; mipLevel < mips; ++mipLevel)
         {
             int descriptorIndex = transcodeTask.mipZeroDescriptor + mipLevel;
 
@@ -890,13 +1097,24 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
 
             m_graphicsDecompressionPass->WriteDescriptor(descriptor);
         }
+        m_tileDescriptorsValid = false;
+
+        nvrhi::TextureHandle const finalTexture = compressThisTexture ? transcodeTask.compressed : transcodeTask.color;
+        size_t const textureMemorySize = m_device->getTextureMemoryRequirements(finalTexture).size;
+
+        if (isMipTail)
+        {
+            // The mip tail is used together with the NTC data, so count it in the same metric
+            material.ntcMemorySize += textureMemorySize;
+            material.*transcodeTask.pMipTailTexture = finalTexture;
+            continue;
+        }
 
         // Create a LoadedTexture object to attach the texture to the material
         std::shared_ptr<engine::LoadedTexture> loadedTexture = std::make_shared<engine::LoadedTexture>();
-        loadedTexture->texture = compressThisTexture ? transcodeTask.compressed : transcodeTask.color;
+        loadedTexture->texture = finalTexture;
 
         // Count the final texture size in the material's memory consumption metric
-        size_t const textureMemorySize = m_device->getTextureMemoryRequirements(loadedTexture->texture).size;
         material.transcodedMemorySize += textureMemorySize;
         
         // Bind the created texture object to the material texture slot
@@ -907,7 +1125,7 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
 
     for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
     {
-        TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+        TextureTranscodeTask& transcodeTask = transcodeMapping[textureIndex];
 
         // Transition the texture to the UAV state because NVRHI won't do that when resources are accessed
         // through a descriptor table. Note that there is no need to transition it back to SRV after decompression
@@ -929,14 +1147,14 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
     assert(material.ntcWeightsBuffer);
 
     m_graphicsDecompressionPass->SetLatentTexture(material.ntcLatentsTexture);
-    m_graphicsDecompressionPass->SetWeightBuffer(material.ntcWeightsBuffer);
+    m_graphicsDecompressionPass->SetWeightBuffer(material.ntcWeightsBuffer, material.ntcWeightsRange);
 
     // Pre-fill the OutputTextureDesc array for decoding of all mip levels
     std::vector<ntc::OutputTextureDesc> outputTextureDescs;
     outputTextureDescs.resize(textureCount);
     for (int textureIndex = 0; textureIndex < textureCount; ++textureIndex)
     {
-        TextureTranscodeTask& transcodeTask = material.transcodeMapping[textureIndex];
+        TextureTranscodeTask& transcodeTask = transcodeMapping[textureIndex];
         ntc::OutputTextureDesc& outputDesc = outputTextureDescs[textureIndex];
         outputDesc.firstChannel = transcodeTask.firstChannel;
         outputDesc.numChannels = transcodeTask.numChannels;
@@ -945,14 +1163,19 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
         outputDesc.ditherScale = 1.f / 255.f;
     }
 
+    // Decode the top mips through NTC, and generate the rest from the last decoded one, if requested
+    int const numDecodedMips = (m_numDecodedMips > 0)
+        ? std::clamp(m_numDecodedMips - firstMip, 1, mips)
+        : mips;
+
     uint32_t successfulMipLevelMask = 0;
-    for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+    for (int mipLevel = 0; mipLevel < numDecodedMips; ++mipLevel)
     {
         // Obtain the description of the decompression pass from LibNTC.
         // The description includes the shader code, weights, and constants.
         ntc::MakeDecompressionComputePassParameters decompressionParams;
         decompressionParams.textureSetMetadata = textureSetMetadata;
-        decompressionParams.mipLevel = mipLevel;
+        decompressionParams.mipLevel = firstMip + mipLevel;
         // This index is added to descriptorIndex from the outputTextureDescs array, so the indexing math works out
         decompressionParams.firstOutputDescriptorIndex = mipLevel;
         decompressionParams.firstLatentMipInTexture = g_firstLatentMipInTexture;
@@ -964,7 +1187,8 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
         if (ntcStatus != ntc::Status::Ok)
         {
             log::warning("Failed to make a decompression pass for material '%s' mip %d, error code = %s: %s",
-                material.name.c_str(), mipLevel, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+                material.name.c_str(), firstMip + mipLevel, ntc::StatusToString(ntcStatus),
+                ntc::GetLastErrorMessage());
             continue;
         }
 
@@ -975,22 +1199,50 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
         successfulMipLevelMask |= (1 << mipLevel);
     }
 
-    // Phase 3 - Compress all mips of the color textures into BCn, where necessary
+    int const lastDecodedMip = numDecodedMips - 1;
+    if (numDecodedMips < mips && (successfulMipLevelMask & (1 << lastDecodedMip)) != 0)
+    {
+        int const numGeneratedMips = mips - numDecodedMips;
+        bool generationFailed = false;
+        for (TextureTranscodeTask const& transcodeTask : transcodeMapping)
+        {
+            MipFilter const filter = (transcodeTask.pMaterialTexture == &NtcMaterial::normalTexture)
+                ? MipFilter::Normal
+                : transcodeTask.sRGB ? MipFilter::SRGB : MipFilter::Linear;
+            nvrhi::Format const viewFormat = (transcodeTask.numChannels == 1)
+                ? nvrhi::Format::R8_UNORM
+                : nvrhi::Format::RGBA8_UNORM;
+
+            if (!m_mipGenerationPass->GenerateMips(commandList, transcodeTask.color, viewFormat,
+                numDecodedMips, numGeneratedMips, filter))
+            {
+                log::warning("Failed to generate mip levels for material '%s' texture '%s'",
+                    material.name.c_str(), transcodeTask.name);
+                generationFailed = true;
+            }
+        }
+
+        if (!generationFailed)
+            successfulMipLevelMask |= ((1u << mips) - 1) & ~((1u << numDecodedMips) - 1);
+    }
+
+    // Phase 3 - Compress all mips of the color textures into BCn, where necessary.
+    // The passes for all textures and mips are batched to avoid serializing the small dispatches.
 
-    for (TextureTranscodeTask const& transcodeTask : material.transcodeMapping)
+    for (TextureTranscodeTask const& transcodeTask : transcodeMapping)
     {
         if (!transcodeTask.compressed)
             continue;
 
         float const alphaThreshold = 1.f / 255.f;
         
-        for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+        for (int mipLevel = 0; mipLevel < mips; ++mipLevel)
         {
             if ((successfulMipLevelMask & (1 << mipLevel)) == 0)
                 continue; // This mip level was not decompressed successfully, skip BCn compression
 
-            int const mipWidth = std::max(textureSetDesc.width >> mipLevel, 1);
-            int const mipHeight = std::max(textureSetDesc.height >> mipLevel, 1);
+            int const mipWidth = std::max(width >> mipLevel, 1);
+            int const mipHeight = std::max(height >> mipLevel, 1);
 
             // Obtain the description of the BC compression pass from LibNTC.
             ntc::MakeBlockCompressionComputePassParameters compressionParams;
@@ -999,12 +1251,14 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
             compressionParams.dstFormat = transcodeTask.bcFormat;
             compressionParams.alphaThreshold = alphaThreshold;
             nvrhi::IBuffer* modeBuffer = nullptr;
-            if (transcodeTask.bc7ModeBuffer && transcodeTask.bc7ModeBufferMipRanges[mipLevel].byteSize != 0)
+            // The mode buffers are loaded for all mips of the texture set
+            int const sourceMipLevel = firstMip + mipLevel;
+            if (transcodeTask.bc7ModeBuffer && transcodeTask.bc7ModeBufferMipRanges[sourceMipLevel].byteSize != 0)
             {
                 compressionParams.modeBufferSource = ntc::BlockCompressionModeBufferSource::TextureSet;
-                compressionParams.modeBufferByteOffset = transcodeTask.bc7ModeBufferMipRanges[mipLevel].byteOffset;
+                compressionParams.modeBufferByteOffset = transcodeTask.bc7ModeBufferMipRanges[sourceMipLevel].byteOffset;
                 compressionParams.modeBufferInfo.textureSet.texture = transcodeTask.metadata;
-                compressionParams.modeBufferInfo.textureSet.mipLevel = mipLevel;
+                compressionParams.modeBufferInfo.textureSet.mipLevel = sourceMipLevel;
                 modeBuffer = transcodeTask.bc7ModeBuffer;
             }
             else
@@ -1018,6 +1272,7 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
             {
                 log::warning("Failed to make a block compression pass for material '%s', error code = %s: %s",
                     material.name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+                m_graphicsBlockCompressionPass->DiscardBatchedComputePasses();
                 return false;
             }
 
@@ -1025,17 +1280,32 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
                 ? nvrhi::Format::R8_UNORM
                 : nvrhi::Format::RGBA8_UNORM;
 
-            // Execute the compute pass to compress the texture.
-            // Note: ExecuteComputePass is application code (not LibNTC) and it caches PSOs based on shader code pointers.
-            if (!m_graphicsBlockCompressionPass->ExecuteComputePass(commandList, compressionPass,
-                transcodeTask.color, inputFormat, mipLevel, modeBuffer, transcodeTask.blocks, 0))
-                return false;
-            
-            int const mipWidthBlocks = (mipWidth + 3) / 4;
-            int const mipHeightBlocks = (mipHeight + 3) / 4;
+            // Add the compute pass to the batch, it's executed below.
+            // Note: the batch is application code (not LibNTC) and it caches PSOs based on shader code pointers.
+            m_graphicsBlockCompressionPass->AddBatchedComputePass(compressionPass,
+                transcodeTask.color, inputFormat, mipLevel, modeBuffer, transcodeTask.blocks, mipLevel);
+        }
+    }
+
+    if (!m_graphicsBlockCompressionPass->ExecuteBatchedComputePasses(commandList))
+        return false;
+
+    for (TextureTranscodeTask const& transcodeTask : transcodeMapping)
+    {
+        if (!transcodeTask.compressed)
+            continue;
+
+        for (int mipLevel = 0; mipLevel < mips; ++mipLevel)
+        {
+            if ((successfulMipLevelMask & (1 << mipLevel)) == 0)
+                continue;
+
+            int const mipWidthBlocks = (std::max(width >> mipLevel, 1) + 3) / 4;
+            int const mipHeightBlocks = (std::max(height >> mipLevel, 1) + 3) / 4;
 
             commandList->copyTexture(transcodeTask.compressed, nvrhi::TextureSlice().setMipLevel(mipLevel),
-                transcodeTask.blocks, nvrhi::TextureSlice().setWidth(mipWidthBlocks).setHeight(mipHeightBlocks));
+                transcodeTask.blocks, nvrhi::TextureSlice().setMipLevel(mipLevel)
+                    .setWidth(mipWidthBlocks).setHeight(mipHeightBlocks));
         }
     }
     
@@ -1044,7 +1314,7 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
 
     // Cleanup - release the intermediate textures
 
-    for (TextureTranscodeTask& transcodeTask : material.transcodeMapping)
+    for (TextureTranscodeTask& transcodeTask : transcodeMapping)
     {
         transcodeTask.ReleaseTextures();
     }
@@ -1052,12 +1322,15 @@ bool NtcMaterialLoader::TranscodeMaterial(ntc::IContext* context, ntc::IStream*
     // Clear the binding set caches to avoid storing binding sets for every texture after on-load transcoding
     m_graphicsBlockCompressionPass->ClearBindingSetCache();
     m_graphicsDecompressionPass->ClearBindingSetCache();
+    m_mipGenerationPass->ClearBindingSetCache();
 
     // We use custom texture packing that puts metalness and roughness into one NTC "texture"
     // with Metalness in R channel and Roughness in G channel.
     // Note: Only set this flag when Inference on Load is active, otherwise we get rendering corruption
-    // because reference materials store ORM in that order.
-    material.metalnessInRedChannel = true;
+    // because reference materials store ORM in that order. The mip tail is read by the NTC shaders
+    // with the same channel mapping as inference.
+    if (!isMipTail)
+        material.metalnessInRedChannel = true;
 
     return true;
 }
@@ -1137,18 +1410,82 @@ static void GetNtcDataSourceAndChannelMap(NtcMaterial const& material,
         CHANNEL_TRANSMISSION);
 }
 
-bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFile, 
-    ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, nvrhi::ICommandList* commandList)
+bool NtcMaterialLoader::AllocateWeights(size_t weightSize, NtcMaterial& material)
 {
-    ntc::InferenceWeightType weightType;
-    if (m_coopVec && textureSetMetadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::CoopVecFP8))
-        weightType = ntc::InferenceWeightType::CoopVecFP8;
-    else
-        weightType = ntc::InferenceWeightType::GenericInt8;
+    uint64_t const alignedSize = (uint64_t(weightSize) + g_weightAtlasAlignment - 1) & ~(g_weightAtlasAlignment - 1);
+    assert(alignedSize <= g_weightAtlasBufferSize);
+
+    // The atlas has no way to free ranges, so loading the same material again would leak its previous range
+    assert(!material.ntcWeightsBuffer && "The weights of a material can only be allocated once per scene");
+
+    if (m_weightAtlasBuffers.empty() || m_weightAtlasOffset + alignedSize > g_weightAtlasBufferSize)
+    {
+        nvrhi::BufferDesc weightBufferDesc = nvrhi::BufferDesc()
+            .setByteSize(g_weightAtlasBufferSize)
+            .setCanHaveRawViews(true)
+            .setCanHaveUAVs(true)
+            .setInitialState(nvrhi::ResourceStates::ShaderResource)
+            .setKeepInitialState(true)
+            .setDebugName("Weight atlas " + std::to_string(m_weightAtlasBuffers.size()));
+        nvrhi::BufferHandle buffer = m_device->createBuffer(weightBufferDesc);
+        if (!buffer)
+            return false;
+
+        m_weightAtlasBuffers.push_back(buffer);
+        m_weightAtlasOffset = 0;
+    }
+
+    material.ntcWeightsBuffer = m_weightAtlasBuffers.back();
+    material.ntcWeightsRange = nvrhi::BufferRange(m_weightAtlasOffset, alignedSize);
+    m_weightAtlasOffset += alignedSize;
+    return true;
+}
+
+// Returns the latent mip level that a material with progressive latents is loaded from first
+static int GetCoarseLatentMip(ntc::LatentTextureDesc const& latentTextureDesc)
+{
+    int const largerSize = std::max(latentTextureDesc.width, latentTextureDesc.height);
+    int mipLevel = 0;
+    while (mipLevel < latentTextureDesc.mipLevels - 1 && (largerSize >> mipLevel) > g_progressiveLatentSize)
+        ++mipLevel;
+    return mipLevel;
+}
+
+// Returns the finest color mip level that can be decoded when the latent mips before firstLatentMip are missing.
+// This assumes that no color mip is decoded from latents with a higher resolution than its own.
+static int GetMinColorMip(ntc::ITextureSetMetadata* textureSetMetadata, int firstLatentMip)
+{
+    if (firstLatentMip == 0)
+        return 0;
+
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+    ntc::LatentTextureDesc const latentTextureDesc = textureSetMetadata->GetLatentTextureDesc();
 
+    // Number of mip levels between the color texture and the latents of the same mip level
+    int latentScale = 0;
+    while ((latentTextureDesc.width << latentScale) < textureSetDesc.width)
+        ++latentScale;
+
+    return std::min(firstLatentMip + latentScale, textureSetDesc.mips - 1);
+}
+
+static NtcStreamingConstants MakeStreamingConstants(ntc::ITextureSetMetadata* textureSetMetadata,
+    NtcMaterial const& material, int firstLatentMip)
+{
+    NtcStreamingConstants streamingConstants{};
+    streamingConstants.minColorMip = GetMinColorMip(textureSetMetadata, firstLatentMip);
+    streamingConstants.mipTailFirstMip = material.mipTailFirstMip;
+    streamingConstants.mipTailChannelMask = material.mipTailChannelMask;
+    return streamingConstants;
+}
+
+bool NtcMaterialLoader::LoadLatentMips(ntc::IStream* ntcFile, uint8_t const* ntcFileData,
+    ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, ntc::InferenceWeightType weightType,
+    int firstLatentMip, nvrhi::ICommandList* commandList, DStorageLoadingBatch* dstorageBatch)
+{
     ntc::InferenceData inferenceData;
     ntc::Status ntcStatus = m_ntcContext->MakeInferenceData(textureSetMetadata, weightType,
-        g_firstLatentMipInTexture, &inferenceData);
+        firstLatentMip, &inferenceData);
 
     if (ntcStatus != ntc::Status::Ok)
     {
@@ -1157,10 +1494,228 @@ bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFil
         return false;
     }
 
-    void const* weightData = nullptr;
+    ntc::LatentTextureDesc const latentTextureDescSrc = textureSetMetadata->GetLatentTextureDesc();
+
+    nvrhi::TextureDesc latentTextureDesc = nvrhi::TextureDesc()
+        .setDebugName(material.name + " latents")
+        .setDimension(nvrhi::TextureDimension::Texture2DArray)
+        .setFormat(nvrhi::Format::BGRA4_UNORM)
+        .setWidth(std::max(latentTextureDescSrc.width >> firstLatentMip, 1))
+        .setHeight(std::max(latentTextureDescSrc.height >> firstLatentMip, 1))
+        .setArraySize(latentTextureDescSrc.arraySize)
+        .setMipLevels(std::max(latentTextureDescSrc.mipLevels - firstLatentMip, 1))
+        .setInitialState(nvrhi::ResourceStates::Common);
+        // Note: no keepInitialState! See comments in FillTextureLoadingTasksForLatents(...) for more info.
+    
+    // The material keeps its previous latents until the new ones are loaded, in case they're being refined
+    nvrhi::TextureHandle latentsTexture = m_device->createTexture(latentTextureDesc);
+    if (!latentsTexture)
+        return false;
+
+    std::vector<TextureSubresourceLoadingTask> tasks;
+    size_t compressedBufferSize = 0;
+    size_t decompressedBufferSize = 0;
+    if (!FillTextureLoadingTasksForLatents(textureSetMetadata, latentsTexture, firstLatentMip, tasks,
+        m_gdeflateFeatures && m_gdeflateFeatures->gpuDecompressionSupported, m_device->getGraphicsAPI(),
+        compressedBufferSize, decompressedBufferSize, ntcFileData, ntcFileData ? ntcFile->Size() : 0))
+        return false;
+    
+    if (!ExecuteTextureLoadingTasks(m_device, commandList, m_ntcContext, ntcFile, m_gdeflateFeatures.get(), tasks,
+        compressedBufferSize, decompressedBufferSize, dstorageBatch))
+        return false;
+
+    NtcStreamingConstants const streamingConstants = MakeStreamingConstants(textureSetMetadata, material,
+        firstLatentMip);
+
+    commandList->open();
+    commandList->writeBuffer(material.ntcConstantBuffer, &inferenceData.constants,
+        sizeof(inferenceData.constants));
+    commandList->writeBuffer(material.ntcStreamingConstantBuffer, &streamingConstants, sizeof(streamingConstants));
+    commandList->close();
+    m_device->executeCommandList(commandList);
+
+    material.ntcLatentsTexture = latentsTexture;
+    material.firstLatentMip = firstLatentMip;
+
+    return true;
+}
+
+// Returns the size of the textures in transcodeMapping from firstMip to the last mip, in bytes
+static uint64_t GetMipTailSize(ntc::TextureSetDesc const& textureSetDesc,
+    std::vector<TextureTranscodeTask> const& transcodeMapping, int firstMip, bool enableBlockCompression)
+{
+    uint64_t size = 0;
+    for (TextureTranscodeTask const& transcodeTask : transcodeMapping)
+    {
+        bool const compressed = enableBlockCompression && transcodeTask.bcFormat != ntc::BlockCompressedFormat::None;
+        bool const isSmallBlock =
+            (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC1) ||
+            (transcodeTask.bcFormat == ntc::BlockCompressedFormat::BC4);
+
+        for (int mipLevel = firstMip; mipLevel < textureSetDesc.mips; ++mipLevel)
+        {
+            uint64_t const mipWidth = std::max(textureSetDesc.width >> mipLevel, 1);
+            uint64_t const mipHeight = std::max(textureSetDesc.height >> mipLevel, 1);
+            if (compressed)
+                size += ((mipWidth + 3) / 4) * ((mipHeight + 3) / 4) * (isSmallBlock ? 8 : 16);
+            else
+                size += mipWidth * mipHeight * ((transcodeTask.numChannels == 1) ? 1 : 4);
+        }
+    }
+    return size;
+}
+
+bool NtcMaterialLoader::TranscodeMipTail(ntc::IStream* ntcFile, uint8_t const* ntcFileData,
+    ntc::ITextureSetMetadata* textureSetMetadata, MaterialChannelMap const& channelMap, NtcMaterial& material)
+{
+    std::vector<TextureTranscodeTask> mipTailMapping;
+    FillMaterialTranscodeMapping(material, textureSetMetadata, channelMap, false, mipTailMapping);
+    if (mipTailMapping.empty())
+        return true;
+
+    // Find the finest mip level whose tail fits into the memory budget: the more mips are in the tail,
+    // the fewer samples run inference.
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+    uint64_t const memoryBudget = uint64_t(double(material.ntcMemorySize) * double(m_mipTailMemoryRatio));
+    int firstMip = 1;
+    while (firstMip < textureSetDesc.mips &&
+        GetMipTailSize(textureSetDesc, mipTailMapping, firstMip, m_loadingBlockCompression) > memoryBudget)
+        ++firstMip;
+
+    if (firstMip >= textureSetDesc.mips)
+        return true;
+
+    int const firstDescriptor = AllocateLoadingDescriptors(
+        (textureSetDesc.mips - firstMip) * int(mipTailMapping.size()));
+    if (firstDescriptor < 0)
+        return false;
+
+    if (!TranscodeMaterial(m_ntcContext, ntcFile, ntcFileData, textureSetMetadata, material, mipTailMapping,
+        firstMip, m_commandList, m_loadingBlockCompression, firstDescriptor))
+        return false;
+
+    uint32_t channelMask = 0;
+    for (TextureTranscodeTask const& transcodeTask : mipTailMapping)
+        channelMask |= ((1u << transcodeTask.numChannels) - 1) << transcodeTask.firstChannel;
+
+    material.mipTailFirstMip = firstMip;
+    material.mipTailChannelMask = channelMask;
+
+    NtcStreamingConstants const streamingConstants = MakeStreamingConstants(textureSetMetadata, material,
+        material.firstLatentMip);
+
+    m_commandList->open();
+    m_commandList->writeBuffer(material.ntcStreamingConstantBuffer, &streamingConstants, sizeof(streamingConstants));
+    m_commandList->close();
+    m_device->executeCommandList(m_commandList);
+
+    return true;
+}
+
+void NtcMaterialLoader::EnableWeightTypeBenchmark(std::filesystem::path const& cacheFileName)
+{
+    m_benchmarkWeightTypes = true;
+    m_weightTypeCacheFileName = cacheFileName;
+    m_weightTypeTimings.fill(0.f);
+
+    m_adapterIdentityKnown = GetAdapterIdentity(m_device, m_adapterIdentity);
+    if (!m_adapterIdentityKnown)
+    {
+        log::warning("Cannot query the adapter and driver version, the weight type benchmark will not be cached.");
+        return;
+    }
+
+    WeightTypeCache cache;
+    std::string error;
+    if (!cache.Load(m_weightTypeCacheFileName, error))
+        log::warning("%s", error.c_str());
+    else if (cache.Find(m_adapterIdentity, m_weightTypeTimings))
+        log::info("Using the cached weight type timings for %s, driver %s.", m_adapterIdentity.adapterName.c_str(),
+            m_adapterIdentity.driverVersion.c_str());
+}
+
+ntc::InferenceWeightType NtcMaterialLoader::SelectWeightType(ntc::IStream* ntcFile,
+    ntc::ITextureSetMetadata* textureSetMetadata)
+{
+    // The forward shading pass has inference on sample variants for these weight types only
+    std::vector<ntc::InferenceWeightType> candidates = { ntc::InferenceWeightType::GenericInt8 };
+    if (m_coopVec)
+        candidates.push_back(ntc::InferenceWeightType::CoopVecFP8);
+
+    if (m_benchmarkWeightTypes)
+    {
+        if (!HasTimingsForWeightTypes(m_weightTypeTimings, textureSetMetadata, candidates) &&
+            !RunWeightTypeBenchmark(ntcFile, textureSetMetadata, candidates))
+        {
+            log::warning("The weight type benchmark failed, using the default weight types.");
+            m_benchmarkWeightTypes = false;
+        }
+
+        ntc::InferenceWeightType const fastestWeightType = SelectFastestWeightType(m_weightTypeTimings,
+            textureSetMetadata, candidates);
+        if (fastestWeightType != ntc::InferenceWeightType::Unknown)
+            return fastestWeightType;
+    }
+
+    if (m_coopVec && textureSetMetadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::CoopVecFP8))
+        return ntc::InferenceWeightType::CoopVecFP8;
+    return ntc::InferenceWeightType::GenericInt8;
+}
+
+bool NtcMaterialLoader::RunWeightTypeBenchmark(ntc::IStream* ntcFile, ntc::ITextureSetMetadata* textureSetMetadata,
+    std::vector<ntc::InferenceWeightType> const& candidates)
+{
+    // Use a separate pass with its own latents, weights and descriptor, so that the benchmark doesn't disturb
+    // the resources of the transcoding and feedback passes
+    GraphicsDecompressionPass benchmarkPass(m_device, /* descriptorTableSize = */ 1);
+    if (!benchmarkPass.Init())
+        return false;
+
+    if (!benchmarkPass.SetLatentDataFromTextureSet(m_commandList, m_ntcContext, m_gdeflateFeatures.get(), ntcFile,
+        textureSetMetadata))
+        return false;
+
+    if (!BenchmarkWeightTypes(m_device, m_ntcContext, benchmarkPass, textureSetMetadata, /* mipLevel = */ 0,
+        /* firstLatentMipInTexture = */ 0, candidates, g_weightTypeBenchmarkIterations, m_weightTypeTimings))
+        return false;
+
+    std::stringstream ss;
+    ss << "Weight type timings on " << (m_adapterIdentityKnown ? m_adapterIdentity.adapterName : "this adapter") << ":";
+    for (ntc::InferenceWeightType weightType : candidates)
+    {
+        float const time = m_weightTypeTimings[size_t(weightType)];
+        if (time > 0.f)
+            ss << " " << GetWeightTypeCacheName(weightType) << " " << std::fixed << std::setprecision(3)
+                << time * 1e3f << " ms";
+    }
+    log::info("%s", ss.str().c_str());
+
+    if (m_adapterIdentityKnown)
+    {
+        // Reload the cache to keep the entries of other adapters that may have been added since the start
+        WeightTypeCache cache;
+        std::string error;
+        if (!cache.Load(m_weightTypeCacheFileName, error))
+            log::warning("%s", error.c_str());
+        cache.Store(m_adapterIdentity, m_weightTypeTimings);
+        if (!cache.Save(m_weightTypeCacheFileName, error))
+            log::warning("%s", error.c_str());
+    }
+
+    return true;
+}
+
+bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFile, uint8_t const* ntcFileData,
+    ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, bool progressiveLatents,
+    nvrhi::ICommandList* commandList, DStorageLoadingBatch* dstorageBatch)
+{
+    ntc::InferenceWeightType const weightType = SelectWeightType(ntcFile, textureSetMetadata);
+
+    void const* weightData = nullptr;
     size_t weightSize = 0;
     size_t convertedWeightSize = 0;
-    ntcStatus = textureSetMetadata->GetInferenceWeights(weightType, &weightData, &weightSize, &convertedWeightSize);
+    ntc::Status ntcStatus = textureSetMetadata->GetInferenceWeights(weightType, &weightData, &weightSize,
+        &convertedWeightSize);
 
     if (ntcStatus != ntc::Status::Ok)
     {
@@ -1170,7 +1725,7 @@ bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFil
     }
 
     nvrhi::BufferDesc constantBufferDesc = nvrhi::BufferDesc()
-        .setByteSize(sizeof(inferenceData.constants))
+        .setByteSize(sizeof(ntc::InferenceData::constants))
         .setIsConstantBuffer(true)
         .setInitialState(nvrhi::ResourceStates::ConstantBuffer)
         .setKeepInitialState(true)
@@ -1179,48 +1734,56 @@ bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFil
     if (!material.ntcConstantBuffer)
         return false;
 
-    nvrhi::BufferDesc weightBufferDesc = nvrhi::BufferDesc()
-        .setByteSize(convertedWeightSize ? convertedWeightSize : weightSize)
-        .setCanHaveRawViews(true)
-        .setCanHaveUAVs(true)
-        .setInitialState(nvrhi::ResourceStates::ShaderResource)
-        .setKeepInitialState(true)
-        .setDebugName(material.name + " weights");
-    material.ntcWeightsBuffer = m_device->createBuffer(weightBufferDesc);
-    if (!material.ntcWeightsBuffer)
+    constantBufferDesc
+        .setByteSize(sizeof(NtcStreamingConstants))
+        .setDebugName(material.name + " streaming constants");
+    material.ntcStreamingConstantBuffer = m_device->createBuffer(constantBufferDesc);
+    if (!material.ntcStreamingConstantBuffer)
         return false;
 
-    ntc::LatentTextureDesc const latentTextureDescSrc = textureSetMetadata->GetLatentTextureDesc();
-
-    nvrhi::TextureDesc latentTextureDesc = nvrhi::TextureDesc()
-        .setDebugName(material.name + " latents")
-        .setDimension(nvrhi::TextureDimension::Texture2DArray)
-        .setFormat(nvrhi::Format::BGRA4_UNORM)
-        .setWidth(std::max(latentTextureDescSrc.width >> g_firstLatentMipInTexture, 1))
-        .setHeight(std::max(latentTextureDescSrc.height >> g_firstLatentMipInTexture, 1))
-        .setArraySize(latentTextureDescSrc.arraySize)
-        .setMipLevels(std::max(latentTextureDescSrc.mipLevels - g_firstLatentMipInTexture, 1))
-        .setInitialState(nvrhi::ResourceStates::Common);
-        // Note: no keepInitialState! See comments in FillTextureLoadingTasksForLatents(...) for more info.
-        
-    material.ntcLatentsTexture = m_device->createTexture(latentTextureDesc);
-    if (!material.ntcLatentsTexture)
+    if (!AllocateWeights(convertedWeightSize ? convertedWeightSize : weightSize, material))
         return false;
 
-    std::vector<TextureSubresourceLoadingTask> tasks;
-    size_t compressedBufferSize = 0;
-    size_t decompressedBufferSize = 0;
-    FillTextureLoadingTasksForLatents(textureSetMetadata, material.ntcLatentsTexture, g_firstLatentMipInTexture, tasks,
-        m_gdeflateFeatures && m_gdeflateFeatures->gpuDecompressionSupported, m_device->getGraphicsAPI(),
-        compressedBufferSize, decompressedBufferSize);
-    
-    if (!ExecuteTextureLoadingTasks(m_device, commandList, m_ntcContext, ntcFile, m_gdeflateFeatures.get(), tasks,
-        compressedBufferSize, decompressedBufferSize))
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+    if (m_texelCacheMaxEntries > 0)
+    {
+        if (textureSetDesc.width > NTC_TEXEL_CACHE_MAX_DIMENSION || textureSetDesc.height > NTC_TEXEL_CACHE_MAX_DIMENSION)
+        {
+            log::warning("Material '%s' is too large for the texel cache, it will be decoded on every sample.",
+                material.name.c_str());
+        }
+        else
+        {
+            uint64_t const numTexels = uint64_t(textureSetDesc.width) * uint64_t(textureSetDesc.height);
+            uint64_t const numEntries = std::min(std::max(numTexels / 4, g_minTexelCacheEntries),
+                uint64_t(m_texelCacheMaxEntries));
+
+            nvrhi::BufferDesc texelCacheDesc = nvrhi::BufferDesc()
+                .setByteSize(numEntries * NTC_TEXEL_CACHE_ENTRY_SIZE)
+                .setCanHaveUAVs(true)
+                .setCanHaveRawViews(true)
+                .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+                .setKeepInitialState(true)
+                .setDebugName(material.name + " texel cache");
+            material.ntcTexelCacheBuffer = m_device->createBuffer(texelCacheDesc);
+            if (!material.ntcTexelCacheBuffer)
+                return false;
+        }
+    }
+
+    int const firstLatentMip = progressiveLatents
+        ? GetCoarseLatentMip(textureSetMetadata->GetLatentTextureDesc())
+        : g_firstLatentMipInTexture;
+
+    if (!LoadLatentMips(ntcFile, ntcFileData, textureSetMetadata, material, weightType, firstLatentMip,
+        commandList, dstorageBatch))
         return false;
 
     commandList->open();
-    commandList->writeBuffer(material.ntcConstantBuffer, &inferenceData.constants,
-        sizeof(inferenceData.constants));
+
+    // Zero stamps mark all cache entries as empty
+    if (material.ntcTexelCacheBuffer)
+        commandList->clearBufferUInt(material.ntcTexelCacheBuffer, 0);
 
     if (convertedWeightSize != 0)
     {
@@ -1244,11 +1807,11 @@ bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFil
         void* nativeDstBuffer = material.ntcWeightsBuffer->getNativeObject(bufferType);
 
         textureSetMetadata->ConvertInferenceWeights(weightType, nativeCommandList,
-            nativeSrcBuffer, 0, nativeDstBuffer, 0);
+            nativeSrcBuffer, 0, nativeDstBuffer, material.ntcWeightsRange.byteOffset);
     }
     else
     {
-        commandList->writeBuffer(material.ntcWeightsBuffer, weightData, weightSize);
+        commandList->writeBuffer(material.ntcWeightsBuffer, weightData, weightSize, material.ntcWeightsRange.byteOffset);
     }
     commandList->close();
     m_device->executeCommandList(commandList);
@@ -1267,7 +1830,7 @@ bool NtcMaterialLoader::PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFil
         material.transmissionTexture->texture = m_dummyTexture->texture;
 
     size_t const constantBufferSize = m_device->getBufferMemoryRequirements(material.ntcConstantBuffer).size;
-    size_t const weightsBufferSize = m_device->getBufferMemoryRequirements(material.ntcWeightsBuffer).size;
+    size_t const weightsBufferSize = material.ntcWeightsRange.byteSize;
     size_t const latentsTextureSize = m_device->getTextureMemoryRequirements(material.ntcLatentsTexture).size;
 
     material.ntcMemorySize = constantBufferSize + weightsBufferSize + latentsTextureSize;
@@ -1284,7 +1847,7 @@ bool NtcMaterialLoader::PrepareFeedbackMaterial(std::shared_ptr<nvfeedback::Feed
     ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
     for (TextureTranscodeTask& transcodeTask : material.transcodeMapping)
     {
-         nvrhi::TextureDesc compressedTextureDesc = nvrhi::TextureDesc()
+        nvrhi::TextureDesc compressedTextureDesc = nvrhi::TextureDesc()
             .setDimension(nvrhi::TextureDimension::Texture2D)
             .setWidth(textureSetDesc.width)
             .setHeight(textureSetDesc.height)
@@ -1300,40 +1863,146 @@ bool NtcMaterialLoader::PrepareFeedbackMaterial(std::shared_ptr<nvfeedback::Feed
         else
         {
             compressedTextureDesc.setFormat(transcodeTask.sRGB ? nvrhi::Format::SRGBA8_UNORM : nvrhi::Format::RGBA8_UNORM);
+
+            // Uncompressed tiles can be decoded directly into the texture, which needs UAV access for that.
+            // Typeless so that sRGB textures can be written through a non-sRGB UAV.
+            compressedTextureDesc
+                .setIsUAV(true)
+                .setIsTypeless(true);
         }
 
         nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> feedbackTexture;
         feedbackManager->CreateTexture(compressedTextureDesc, &feedbackTexture);
         material.*transcodeTask.pFeedbackTexture = feedbackTexture;
+
+        transcodeTask.feedbackMipZeroDescriptor = -1;
+        if (!enableBlockCompression && feedbackTexture &&
+            m_nextFeedbackDescriptor + textureSetDesc.mips <= m_texTileBlocksRGOffset + g_maxFeedbackTextureDescriptors)
+        {
+            // Write descriptors for all mips of the feedback texture, they stay valid for the texture's lifetime
+            transcodeTask.feedbackMipZeroDescriptor = int(m_nextFeedbackDescriptor);
+            for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+            {
+                nvrhi::BindingSetItem descriptor = nvrhi::BindingSetItem::Texture_UAV(
+                    m_nextFeedbackDescriptor++,
+                    feedbackTexture->GetReservedTexture(),
+                    nvrhi::Format::RGBA8_UNORM, // Always use non-sRGB formats so that we can create a UAV
+                    nvrhi::TextureSubresourceSet().setBaseMipLevel(mipLevel));
+
+                m_graphicsDecompressionPass->WriteDescriptor(descriptor);
+            }
+        }
     }
 
     return true;
 }
 
+// Copies over all the properties that we touch when decoding NTC materials,
+// but not the entire material: some flags or parameters might be different.
+static void CopyLoadedMaterial(NtcMaterial& dst, NtcMaterial const& src)
+{
+    dst.ntcConstantBuffer = src.ntcConstantBuffer;
+    dst.ntcWeightsBuffer = src.ntcWeightsBuffer;
+    dst.ntcWeightsRange = src.ntcWeightsRange;
+    dst.ntcLatentsTexture = src.ntcLatentsTexture;
+    dst.ntcStreamingConstantBuffer = src.ntcStreamingConstantBuffer;
+    dst.ntcTexelCacheBuffer = src.ntcTexelCacheBuffer;
+    dst.mipTailFirstMip = src.mipTailFirstMip;
+    dst.mipTailChannelMask = src.mipTailChannelMask;
+    dst.mipTailBaseColorTexture = src.mipTailBaseColorTexture;
+    dst.mipTailMetalRoughOrSpecularTexture = src.mipTailMetalRoughOrSpecularTexture;
+    dst.mipTailNormalTexture = src.mipTailNormalTexture;
+    dst.mipTailEmissiveTexture = src.mipTailEmissiveTexture;
+    dst.mipTailOcclusionTexture = src.mipTailOcclusionTexture;
+    dst.mipTailTransmissionTexture = src.mipTailTransmissionTexture;
+    dst.weightType = src.weightType;
+    dst.firstLatentMip = src.firstLatentMip;
+    dst.baseOrDiffuseTexture = src.baseOrDiffuseTexture;
+    dst.metalRoughOrSpecularTexture = src.metalRoughOrSpecularTexture;
+    dst.normalTexture = src.normalTexture;
+    dst.emissiveTexture = src.emissiveTexture;
+    dst.occlusionTexture = src.occlusionTexture;
+    dst.transmissionTexture = src.transmissionTexture;
+    dst.opacityTexture = src.opacityTexture;
+    dst.metalnessInRedChannel = src.metalnessInRedChannel;
+    dst.baseOrDiffuseTextureFeedback = src.baseOrDiffuseTextureFeedback;
+    dst.metalRoughOrSpecularTextureFeedback = src.metalRoughOrSpecularTextureFeedback;
+    dst.normalTextureFeedback = src.normalTextureFeedback;
+    dst.emissiveTextureFeedback = src.emissiveTextureFeedback;
+    dst.occlusionTextureFeedback = src.occlusionTextureFeedback;
+    dst.transmissionTextureFeedback = src.transmissionTextureFeedback;
+    dst.opacityTextureFeedback = src.opacityTextureFeedback;
+    dst.textureSetMetadata = src.textureSetMetadata;
+    dst.transcodeMapping = src.transcodeMapping;
+    dst.ntcSource = src.ntcSource;
+
+    // The GPU resources are shared with src, so their memory is only counted in src.ntcMemorySize.
+    // This keeps the sum over all materials correct when RefineLatents changes the size of src later.
+    dst.ntcMemorySize = 0;
+}
+
+bool NtcMaterialLoader::OpenMaterialPackage(std::filesystem::path const& fileName)
+{
+    auto package = std::make_shared<NtcPackage>();
+    std::string error;
+    if (!package->Open(fileName.generic_string().c_str(), error))
+    {
+        log::error("%s", error.c_str());
+        return false;
+    }
+
+    log::info("Opened material package '%s' with %zu texture sets.", fileName.generic_string().c_str(),
+        package->GetEntries().size());
+    m_materialPackage = package;
+    return true;
+}
+
 bool NtcMaterialLoader::LoadMaterialsForScene(donut::engine::Scene& scene, std::filesystem::path const& materialDir, 
     bool enableInferenceOnLoad, bool enableBlockCompression, bool enableInferenceOnSample,
     bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager)
 {
-    using namespace std::chrono;
-    time_point start = steady_clock::now();
+    BeginLoadingMaterials(scene, materialDir, enableInferenceOnLoad, enableBlockCompression, enableInferenceOnSample,
+        enableInferenceOnFeedback, feedbackManager);
 
-    uint64_t totalFileSize = 0;
-    uint64_t totalPixels = 0;
-    int materialCount = 0;
+    std::vector<std::shared_ptr<NtcMaterial>> loadedMaterials;
+    UpdateLoadingMaterials(0.f, loadedMaterials);
+
+    return true;
+}
+
+void NtcMaterialLoader::BeginLoadingMaterials(donut::engine::Scene& scene, std::filesystem::path const& materialDir, 
+    bool enableInferenceOnLoad, bool enableBlockCompression, bool enableInferenceOnSample,
+    bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager)
+{
+    assert(m_loadingTasks.empty());
+
+    m_loadingStartTime = std::chrono::steady_clock::now();
+    m_loadingInferenceOnLoad = enableInferenceOnLoad;
+    m_loadingBlockCompression = enableBlockCompression;
+    m_loadingInferenceOnFeedback = enableInferenceOnFeedback;
+    m_loadingFeedbackManager = feedbackManager;
+    m_loadedFileSize = 0;
+    m_loadedPixels = 0;
+    m_loadedMaterialCount = 0;
     m_weightTypeHistogram.fill(0);
+    m_progressiveMaterials.clear();
 
-    std::vector<std::shared_ptr<engine::Material>> materials;
-    for (std::shared_ptr<engine::Material> const& material : scene.GetSceneGraph()->GetMaterials())
-        materials.push_back(material);
+    // The metadata of the materials is kept, so the phase mostly releases the temporary allocations made
+    // while parsing the files, see UpdateLoadingMaterials
+    m_allocator.BeginPhase("Load Materials");
 
-    std::unordered_map<std::string, std::shared_ptr<NtcMaterial>> ntcMaterialCache; // ntcData.ToString() -> NtcMaterial
+    // Start a new set of weight buffers, the buffers of the previous scene are released with its materials
+    m_weightAtlasBuffers.clear();
+    m_weightAtlasOffset = 0;
 
-    for (std::shared_ptr<engine::Material> const& material : materials)
+    std::unordered_map<std::string, MaterialLoadingTask*> tasksBySource; // ntcData.ToString() -> task
+
+    for (std::shared_ptr<engine::Material> const& material : scene.GetSceneGraph()->GetMaterials())
     {
         std::shared_ptr<NtcMaterial> ntcMaterial = std::static_pointer_cast<NtcMaterial>(material);
 
-        fs::path modelFileName = material->modelFileName;
-        fs::path currentMaterialDir = materialDir.empty() ? modelFileName.parent_path() : materialDir;
+        if (ntcMaterial->name.empty())
+            ntcMaterial->name = "Material";
 
         // Find a single NTC file that contains channels for all textures for this material.
         // In a general case, there may be multiple different files used in a single material,
@@ -1347,104 +2016,522 @@ bool NtcMaterialLoader::LoadMaterialsForScene(donut::engine::Scene& scene, std::
         if (!ntcData)
             continue;
 
-        auto cacheIterator = ntcMaterialCache.find(ntcData.ToString());
-        if (cacheIterator != ntcMaterialCache.end())
+        std::string const sourceKey = ntcData.ToString();
+        auto found = tasksBySource.find(sourceKey);
+        if (found != tasksBySource.end())
         {
-            auto previouslyLoadedMaterial = cacheIterator->second;
-
-            // Copy over all the properties that we touch when decoding NTC materials,
-            // but not the entire material: some flags or parameters might be different.
-            ntcMaterial->ntcConstantBuffer = previouslyLoadedMaterial->ntcConstantBuffer;
-            ntcMaterial->ntcWeightsBuffer = previouslyLoadedMaterial->ntcWeightsBuffer;
-            ntcMaterial->ntcLatentsTexture = previouslyLoadedMaterial->ntcLatentsTexture;
-            ntcMaterial->weightType = previouslyLoadedMaterial->weightType;
-            ntcMaterial->baseOrDiffuseTexture = previouslyLoadedMaterial->baseOrDiffuseTexture;
-            ntcMaterial->metalRoughOrSpecularTexture = previouslyLoadedMaterial->metalRoughOrSpecularTexture;
-            ntcMaterial->normalTexture = previouslyLoadedMaterial->normalTexture;
-            ntcMaterial->emissiveTexture = previouslyLoadedMaterial->emissiveTexture;
-            ntcMaterial->occlusionTexture = previouslyLoadedMaterial->occlusionTexture;
-            ntcMaterial->transmissionTexture = previouslyLoadedMaterial->transmissionTexture;
-            ntcMaterial->opacityTexture = previouslyLoadedMaterial->opacityTexture;
-            ntcMaterial->metalnessInRedChannel = previouslyLoadedMaterial->metalnessInRedChannel;
-            ntcMaterial->baseOrDiffuseTextureFeedback = previouslyLoadedMaterial->baseOrDiffuseTextureFeedback;
-            ntcMaterial->metalRoughOrSpecularTextureFeedback = previouslyLoadedMaterial->metalRoughOrSpecularTextureFeedback;
-            ntcMaterial->normalTextureFeedback = previouslyLoadedMaterial->normalTextureFeedback;
-            ntcMaterial->emissiveTextureFeedback = previouslyLoadedMaterial->emissiveTextureFeedback;
-            ntcMaterial->occlusionTextureFeedback = previouslyLoadedMaterial->occlusionTextureFeedback;
-            ntcMaterial->transmissionTextureFeedback = previouslyLoadedMaterial->transmissionTextureFeedback;
-            ntcMaterial->opacityTextureFeedback = previouslyLoadedMaterial->opacityTextureFeedback;
-            ntcMaterial->textureSetMetadata = previouslyLoadedMaterial->textureSetMetadata;
-            ntcMaterial->transcodeMapping = previouslyLoadedMaterial->transcodeMapping;
-
+            found->second->duplicates.push_back(ntcMaterial);
             continue;
         }
 
-        ntcMaterialCache[ntcData.ToString()] = ntcMaterial;
+        auto task = std::make_unique<MaterialLoadingTask>(m_ntcContext);
+        task->material = ntcMaterial;
+        task->ntcData = ntcData;
+        task->channelMap = channelMap;
+        tasksBySource[sourceKey] = task.get();
+        m_loadingTasks.push_back(std::move(task));
+    }
+
+    // UpdateLoadingMaterials ends the phase when the last material is loaded
+    if (m_loadingTasks.empty())
+    {
+        m_allocator.EndPhase();
+        return;
+    }
+
+    if (!m_threadPool)
+        m_threadPool = std::make_unique<engine::ThreadPool>();
 
-        // Use differnt wrappers for file and memory streams because they have different deleter functions...
-        ntc::FileStreamWrapper ntcFileStream(m_ntcContext);
-        ntc::MemoryStreamWrapper ntcMemoryStream(m_ntcContext);
+    ScheduleMaterialLoadingTasks();
+}
 
-        ntcMaterial->textureSetMetadata = std::make_shared<ntc::TextureSetMetadataWrapper>(m_ntcContext);
+void NtcMaterialLoader::ScheduleMaterialLoadingTasks()
+{
+    size_t filesInFlight = 0;
+    for (std::unique_ptr<MaterialLoadingTask>& task : m_loadingTasks)
+    {
+        if (!task)
+            continue;
 
-        if (!LoadMaterialFile(ntcData, *ntcMaterial, m_ntcContext, ntcFileStream, ntcMemoryStream,
-            *ntcMaterial->textureSetMetadata))
+        if (task->scheduled)
+        {
+            ++filesInFlight;
             continue;
+        }
 
-        // Upcast the file or memory stream to a basic stream type
-        ntc::IStream* const dataStream = ntcFileStream.Get() ? ntcFileStream.Get() : ntcMemoryStream.Get();
+        if (filesInFlight >= g_maxMaterialFilesInFlight)
+            break;
 
-        ntc::ITextureSetMetadata* textureSetMetadata = *ntcMaterial->textureSetMetadata;
+        task->scheduled = true;
+        ++filesInFlight;
 
-        ntc::Status ntcStatus = textureSetMetadata->ShuffleInferenceOutputs(channelMap.swizzle.data());
-        if (ntcStatus != ntc::Status::Ok)
+        // Only the file access and metadata parsing happen on the worker threads. Everything that creates
+        // GPU resources or compute passes stays on the main thread, because the decompression passes share
+        // a descriptor table, and the pass descriptions returned by the context may point at its internal data.
+        MaterialLoadingTask* pTask = task.get();
+        m_threadPool->AddTask([this, pTask]()
+        {
+            bool success = LoadMaterialFile(pTask->ntcData, m_ntcContext, m_materialPackage.get(), pTask->fileStream,
+                pTask->memoryStream, pTask->mappedFile, pTask->packageData, pTask->streamData,
+                *pTask->textureSetMetadata);
+
+            if (success)
+            {
+                ntc::ITextureSetMetadata* textureSetMetadata = *pTask->textureSetMetadata;
+                ntc::Status ntcStatus = textureSetMetadata->ShuffleInferenceOutputs(pTask->channelMap.swizzle.data());
+                if (ntcStatus != ntc::Status::Ok)
+                {
+                    log::warning("Cannot process material '%s', call to ShuffleInferenceOutputs failed, "
+                        "error code = %s: %s", pTask->material->name.c_str(), ntc::StatusToString(ntcStatus),
+                        ntc::GetLastErrorMessage());
+                }
+            }
+
+            pTask->metadataPromise.set_value(success);
+        });
+    }
+}
+
+bool NtcMaterialLoader::UpdateLoadingMaterials(float timeLimitSeconds,
+    std::vector<std::shared_ptr<NtcMaterial>>& loadedMaterials)
+{
+    using namespace std::chrono;
+
+    if (m_loadingTasks.empty())
+        return true;
+
+    time_point const start = steady_clock::now();
+    bool const waitForAll = timeLimitSeconds <= 0.f;
+    bool gpuIdle = false;
+
+    // Materials whose latent uploads are in the DirectStorage batch, they're complete after the batch is finished
+    struct BatchedMaterial
+    {
+        std::shared_ptr<NtcMaterial> material;
+        std::vector<std::shared_ptr<NtcMaterial>> duplicates;
+        size_t dstorageGroup = 0;
+    };
+    std::vector<BatchedMaterial> batchedMaterials;
+
+    for (std::unique_ptr<MaterialLoadingTask>& task : m_loadingTasks)
+    {
+        if (!task)
+            continue;
+
+        // Tasks are scheduled in order, and the ones after this are not scheduled either
+        if (!task->scheduled)
+            break;
+
+        if (!waitForAll)
         {
-            log::warning("Cannot process material '%s', call to ShuffleInferenceOutputs failed, error code = %s: %s",
-                ntcMaterial->name.c_str(), ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            if (duration<float>(steady_clock::now() - start).count() >= timeLimitSeconds)
+                break;
+
+            // Skip the materials whose files are still being parsed, and come back to them on the next update
+            if (task->metadataFuture.wait_for(seconds(0)) != std::future_status::ready)
+                continue;
         }
 
-        // Derive the transcode mapping using the channel map and texture metadata
-        bool const onlyAlphaMask = !enableInferenceOnLoad && !enableInferenceOnFeedback;
-        FillMaterialTranscodeMapping(*ntcMaterial, textureSetMetadata, channelMap, onlyAlphaMask);
+        bool const metadataLoaded = task->metadataFuture.get();
 
-        // Load the material data for Inference On Sample/Feedback first, so that the latent and weight buffers
-        // can be reused for On Load.
-        bool loadedSuccessfully = PrepareMaterialForInferenceOnSample(dataStream, textureSetMetadata,
-            *ntcMaterial, m_commandList);
+        // Tile transcoding for Inference on Feedback uses the same decompression descriptor table
+        // that material transcoding overwrites, so make sure that the GPU is done with it.
+        if (!gpuIdle)
+        {
+            m_device->waitForIdle();
+            gpuIdle = true;
+        }
 
-        // Transcode the material into raw color data or BCn (Inference On Load).
-        // When Inference on Load is disabled, we still go through the materials and extract alpha mask channels,
-        // encoding them into BC4 when allowed. They are used for the depth pre-pass (or any-hit shaders
-        // in a path tracing renderer).
-        if (loadedSuccessfully)
+        if (metadataLoaded && LoadMaterial(*task))
         {
-            loadedSuccessfully = TranscodeMaterial(m_ntcContext, dataStream,
-                textureSetMetadata, *ntcMaterial, m_commandList, enableBlockCompression);
+            BatchedMaterial& batched = batchedMaterials.emplace_back();
+            batched.material = task->material;
+            batched.duplicates = std::move(task->duplicates);
+            batched.dstorageGroup = task->dstorageGroup;
         }
 
-        if (enableInferenceOnFeedback && loadedSuccessfully)
+        // Release the streams and schedule more files to keep the worker threads busy
+        task.reset();
+        ScheduleMaterialLoadingTasks();
+    }
+
+    // Submit the latent uploads of all materials processed on this update together
+    if (m_dstorageBatch && !m_dstorageBatch->IsEmpty())
+        m_dstorageBatch->Finish(m_commandList);
+
+    // Wait for the GPU work of all materials loaded on this update at once instead of after every material
+    if (gpuIdle)
+        RetireLoadingWork();
+
+    for (BatchedMaterial& batched : batchedMaterials)
+    {
+        if (m_dstorageBatch && !m_dstorageBatch->IsGroupSuccessful(batched.dstorageGroup))
         {
-            loadedSuccessfully = PrepareFeedbackMaterial(feedbackManager, textureSetMetadata, *ntcMaterial,
-                enableBlockCompression);
+            log::warning("Failed to upload the latents for material '%s' with DirectStorage.",
+                batched.material->name.c_str());
+            continue;
         }
-        
-        if (loadedSuccessfully)
+
+        loadedMaterials.push_back(batched.material);
+        for (std::shared_ptr<NtcMaterial> const& duplicate : batched.duplicates)
         {
-            m_device->waitForIdle();
-            m_device->runGarbageCollection();
+            CopyLoadedMaterial(*duplicate, *batched.material);
+            loadedMaterials.push_back(duplicate);
         }
 
-        auto const& textureSetDesc = textureSetMetadata->GetDesc();
-        totalFileSize += dataStream->Size();
-        totalPixels += (textureSetDesc.width * textureSetDesc.height * 4) / 3;
-        ++materialCount;
+        if (batched.material->firstLatentMip > 0)
+            m_progressiveMaterials.push_back({ batched.material, std::move(batched.duplicates) });
     }
 
-    time_point end = steady_clock::now();
-    int64_t durationMs = duration_cast<milliseconds>(end - start).count();
+    m_loadingTasks.erase(std::remove(m_loadingTasks.begin(), m_loadingTasks.end(), nullptr), m_loadingTasks.end());
     
-    log::info("%d materials loaded in %lli ms - that's %.2f Mpix from %.2f MB", materialCount, durationMs,
-        double(totalPixels) * 1e-6, double(totalFileSize) * 0x1p-20);
+    if (!m_loadingTasks.empty())
+        return false;
+
+    m_threadPool.reset();
+    m_loadingFeedbackManager.reset();
+    m_allocator.EndPhase();
+
+    int64_t durationMs = duration_cast<milliseconds>(steady_clock::now() - m_loadingStartTime).count();
+    
+    log::info("%d materials loaded in %lli ms - that's %.2f Mpix from %.2f MB", m_loadedMaterialCount, durationMs,
+        double(m_loadedPixels) * 1e-6, double(m_loadedFileSize) * 0x1p-20);
+
+    for (AllocatorPhaseStats const& phase : m_allocator.GetPhaseStats())
+    {
+        if (phase.name == "Load Materials")
+        {
+            log::info("Library memory while loading materials: %llu allocations, peak %.2f MB, %.2f MB in use, "
+                "%.2f MB reserved", (unsigned long long)phase.allocationCount, double(phase.peakBytesInUse) * 0x1p-20,
+                double(m_allocator.GetBytesAllocated()) * 0x1p-20, double(m_allocator.GetBytesReserved()) * 0x1p-20);
+        }
+    }
 
     return true;
 }
+
+int NtcMaterialLoader::AllocateLoadingDescriptors(int count)
+{
+    if (count > g_loadingTranscodeDescriptors)
+    {
+        log::warning("A material has too many textures and mip levels to be transcoded (%d descriptors).", count);
+        return -1;
+    }
+
+    // The descriptors of the previous materials may still be in use by the GPU until their work is retired
+    if (m_nextLoadingDescriptor + count > g_loadingTranscodeDescriptors)
+        RetireLoadingWork();
+
+    int const firstDescriptor = int(g_maxTileStagingTextures * 2 * TRANSCODE_BATCH_SIZE + g_maxFeedbackTextureDescriptors)
+        + m_nextLoadingDescriptor;
+    m_nextLoadingDescriptor += count;
+    return firstDescriptor;
+}
+
+void NtcMaterialLoader::RetireLoadingWork()
+{
+    m_device->waitForIdle();
+    m_device->runGarbageCollection();
+    m_nextLoadingDescriptor = 0;
+    m_pendingLoadingBytes = 0;
+}
+
+bool NtcMaterialLoader::LoadMaterial(MaterialLoadingTask& task)
+{
+    NtcMaterial& material = *task.material;
+    material.textureSetMetadata = task.textureSetMetadata;
+
+    // Upcast the file or memory stream to a basic stream type
+    ntc::IStream* const dataStream = task.fileStream.Get() ? task.fileStream.Get() : task.memoryStream.Get();
+
+    ntc::ITextureSetMetadata* textureSetMetadata = *material.textureSetMetadata;
+
+    // Derive the transcode mapping using the channel map and texture metadata.
+    // Materials that are transcoded on demand only get the alpha mask now, see TranscodeMaterialOnDemand.
+    bool const onlyAlphaMask = (!m_loadingInferenceOnLoad || m_transcodeOnDemand) && !m_loadingInferenceOnFeedback;
+    FillMaterialTranscodeMapping(material, textureSetMetadata, task.channelMap, onlyAlphaMask,
+        material.transcodeMapping);
+
+    // Transcoding reads all latent mips, so only the materials that are not transcoded can start with the small ones
+    bool const useMipTail = m_mipTailMemoryRatio > 0.f;
+    bool const progressiveLatents = m_progressiveLatents && !m_loadingInferenceOnLoad && !m_loadingInferenceOnFeedback
+        && material.transcodeMapping.empty() && !useMipTail;
+
+    // Load the material data for Inference On Sample/Feedback first, so that the latent and weight buffers
+    // can be reused for On Load.
+    if (m_dstorageBatch)
+        task.dstorageGroup = m_dstorageBatch->BeginGroup();
+    bool loadedSuccessfully = PrepareMaterialForInferenceOnSample(dataStream, task.streamData, textureSetMetadata,
+        material, progressiveLatents, m_commandList, m_dstorageBatch.get());
+
+    // Keep the data source for loading the finer latent mips, see UpdateProgressiveLatents
+    if (loadedSuccessfully && material.firstLatentMip > 0)
+        material.ntcSource = task.ntcData;
+
+    // Transcoding reads the latents, so their DirectStorage requests and those of the previous materials
+    // in the batch have to complete first.
+    if (loadedSuccessfully && m_dstorageBatch && !m_dstorageBatch->IsEmpty()
+        && (!material.transcodeMapping.empty() || useMipTail))
+    {
+        m_dstorageBatch->Finish(m_commandList);
+        loadedSuccessfully = m_dstorageBatch->IsGroupSuccessful(task.dstorageGroup);
+    }
+
+    // Transcode the material into raw color data or BCn (Inference On Load).
+    // When Inference on Load is disabled, we still go through the materials and extract alpha mask channels,
+    // encoding them into BC4 when allowed. They are used for the depth pre-pass (or any-hit shaders
+    // in a path tracing renderer).
+    if (loadedSuccessfully && !material.transcodeMapping.empty())
+    {
+        int const firstDescriptor = AllocateLoadingDescriptors(
+            textureSetMetadata->GetDesc().mips * int(material.transcodeMapping.size()));
+        loadedSuccessfully = firstDescriptor >= 0 && TranscodeMaterial(m_ntcContext, dataStream, task.streamData,
+            textureSetMetadata, material, material.transcodeMapping, 0, m_commandList, m_loadingBlockCompression,
+            firstDescriptor);
+    }
+
+    // Transcode the coarse mips for inference on sample. Without the tail, the material still renders
+    // with inference on all mips, so a failure here is not fatal.
+    if (useMipTail && loadedSuccessfully &&
+        !TranscodeMipTail(dataStream, task.streamData, textureSetMetadata, task.channelMap, material))
+    {
+        log::warning("Failed to transcode the mip tail for material '%s', it will use inference on all mips.",
+            material.name.c_str());
+    }
+
+    if (m_loadingInferenceOnFeedback && loadedSuccessfully)
+    {
+        loadedSuccessfully = PrepareFeedbackMaterial(m_loadingFeedbackManager, textureSetMetadata, material,
+            m_loadingBlockCompression);
+    }
+
+    // Keep the full mapping and the data source for transcoding on demand. The alpha mask texture stays
+    // in the material, so that the depth pre-pass works whether the other textures are resident or not.
+    if (m_transcodeOnDemand && m_loadingInferenceOnLoad && loadedSuccessfully)
+    {
+        material.transcodeMapping.clear();
+        FillMaterialTranscodeMapping(material, textureSetMetadata, task.channelMap, false, material.transcodeMapping);
+        material.ntcSource = task.ntcData;
+    }
+
+    // The GPU work is retired once per update, or earlier when a lot of data is waiting in the upload buffers
+    m_pendingLoadingBytes += dataStream->Size();
+    if (m_pendingLoadingBytes > g_maxPendingLoadingBytes)
+        RetireLoadingWork();
+
+    auto const& textureSetDesc = textureSetMetadata->GetDesc();
+    m_loadedFileSize += dataStream->Size();
+    m_loadedPixels += (textureSetDesc.width * textureSetDesc.height * 4) / 3;
+    ++m_loadedMaterialCount;
+
+    return loadedSuccessfully;
+}
+
+bool NtcMaterialLoader::RefineLatents(ProgressiveMaterial& progressive)
+{
+    NtcMaterial& material = *progressive.material;
+    if (!material.ntcSource || !material.textureSetMetadata || material.firstLatentMip <= 0)
+        return false;
+
+    // The file was closed after loading, open it again for the latents
+    ntc::FileStreamWrapper fileStream(m_ntcContext);
+    ntc::MemoryStreamWrapper memoryStream(m_ntcContext);
+    MappedFile mappedFile;
+    std::vector<uint8_t> packageData;
+    uint8_t const* streamData = nullptr;
+    ntc::IStream* dataStream = OpenMaterialStream(material.ntcSource, m_ntcContext, m_materialPackage.get(),
+        fileStream, memoryStream, mappedFile, packageData, streamData);
+    if (!dataStream)
+        return false;
+
+    // The previous texture is in use by the frames in flight, so the new one is loaded with all the coarser mips
+    // again. They're small compared to the new mip level.
+    size_t const previousLatentsSize = m_device->getTextureMemoryRequirements(material.ntcLatentsTexture).size;
+    if (!LoadLatentMips(dataStream, streamData, *material.textureSetMetadata, material,
+        ntc::InferenceWeightType(material.weightType), material.firstLatentMip - 1, m_commandList))
+        return false;
+
+    size_t const latentsSize = m_device->getTextureMemoryRequirements(material.ntcLatentsTexture).size;
+    material.ntcMemorySize = material.ntcMemorySize - previousLatentsSize + latentsSize;
+
+    // The duplicates share the latents texture, which is counted in the memory size of the original only
+    for (std::shared_ptr<NtcMaterial> const& duplicate : progressive.duplicates)
+    {
+        assert(duplicate->ntcMemorySize == 0);
+        duplicate->ntcLatentsTexture = material.ntcLatentsTexture;
+        duplicate->firstLatentMip = material.firstLatentMip;
+    }
+
+    return true;
+}
+
+bool NtcMaterialLoader::UpdateProgressiveLatents(float timeLimitSeconds, std::vector<NtcMaterial*>& refinedMaterials)
+{
+    using namespace std::chrono;
+
+    time_point const start = steady_clock::now();
+    size_t processedCount = 0;
+
+    for (ProgressiveMaterial& progressive : m_progressiveMaterials)
+    {
+        if (duration<float>(steady_clock::now() - start).count() >= timeLimitSeconds)
+            break;
+
+        ++processedCount;
+
+        bool const refined = RefineLatents(progressive);
+        if (refined)
+        {
+            refinedMaterials.push_back(progressive.material.get());
+            for (std::shared_ptr<NtcMaterial> const& duplicate : progressive.duplicates)
+                refinedMaterials.push_back(duplicate.get());
+        }
+        else
+        {
+            log::warning("Failed to load the finer latent mips for material '%s', it keeps a lower resolution.",
+                progressive.material->name.c_str());
+        }
+
+        if (!refined || progressive.material->firstLatentMip == 0)
+        {
+            // The material is complete or can't be refined, so its data source is not needed anymore
+            progressive.material->ntcSource = donut::engine::FilePathOrInlineData();
+            for (std::shared_ptr<NtcMaterial> const& duplicate : progressive.duplicates)
+                duplicate->ntcSource = donut::engine::FilePathOrInlineData();
+            progressive.material = nullptr;
+        }
+    }
+
+    // Continue with the materials that were not processed on the next update, so that all of them are refined
+    // at the same pace
+    std::rotate(m_progressiveMaterials.begin(), m_progressiveMaterials.begin() + processedCount,
+        m_progressiveMaterials.end());
+
+    m_progressiveMaterials.erase(std::remove_if(m_progressiveMaterials.begin(), m_progressiveMaterials.end(),
+        [](ProgressiveMaterial const& progressive) { return !progressive.material; }), m_progressiveMaterials.end());
+
+    return m_progressiveMaterials.empty();
+}
+
+bool NtcMaterialLoader::IsOnDemandTranscodeSlotFree(int slot)
+{
+    OnDemandTranscodeSlot& transcodeSlot = m_onDemandTranscodeSlots[slot];
+    if (transcodeSlot.submitted && m_device->pollEventQuery(transcodeSlot.query))
+        transcodeSlot.submitted = false;
+    return !transcodeSlot.submitted;
+}
+
+bool NtcMaterialLoader::CanTranscodeMaterialOnDemand()
+{
+    if (m_onDemandTranscodeSlots.empty())
+        m_onDemandTranscodeSlots.resize(g_maxOnDemandTranscodes);
+
+    for (int slot = 0; slot < int(m_onDemandTranscodeSlots.size()); ++slot)
+    {
+        if (IsOnDemandTranscodeSlotFree(slot))
+            return true;
+    }
+    return false;
+}
+
+bool NtcMaterialLoader::TranscodeMaterialOnDemand(std::vector<NtcMaterial*> const& materials, int& outSlot)
+{
+    outSlot = -1;
+    if (materials.empty())
+        return false;
+
+    NtcMaterial& material = *materials[0];
+    if (!material.ntcSource || !material.textureSetMetadata || material.transcodeMapping.empty())
+        return false;
+
+    ntc::TextureSetDesc const& textureSetDesc = (*material.textureSetMetadata)->GetDesc();
+    if (textureSetDesc.mips * int(material.transcodeMapping.size()) > g_onDemandTranscodeDescriptors)
+    {
+        log::warning("Material '%s' has too many textures and mip levels to be transcoded on demand.",
+            material.name.c_str());
+        return false;
+    }
+
+    // Each slot has its own range of the descriptor table, so that the next transcoding doesn't overwrite
+    // the descriptors that the GPU may still be using
+    if (!CanTranscodeMaterialOnDemand())
+        return false;
+    int slot = 0;
+    while (!IsOnDemandTranscodeSlotFree(slot))
+        ++slot;
+
+    // The file was closed after loading, open it again: the BC7 mode buffers are read from it
+    ntc::FileStreamWrapper fileStream(m_ntcContext);
+    ntc::MemoryStreamWrapper memoryStream(m_ntcContext);
+    MappedFile mappedFile;
+    std::vector<uint8_t> packageData;
+    uint8_t const* streamData = nullptr;
+    ntc::IStream* dataStream = OpenMaterialStream(material.ntcSource, m_ntcContext, m_materialPackage.get(),
+        fileStream, memoryStream, mappedFile, packageData, streamData);
+    if (!dataStream)
+        return false;
+
+    // Count the new textures separately from the alpha mask, which stays resident
+    size_t const residentMemorySize = material.transcodedMemorySize;
+    int const firstDescriptor = int(g_maxTileStagingTextures * 2 * TRANSCODE_BATCH_SIZE) +
+        slot * g_onDemandTranscodeDescriptors;
+    bool const transcodedSuccessfully = TranscodeMaterial(m_ntcContext, dataStream, streamData,
+        *material.textureSetMetadata, material, material.transcodeMapping, 0, m_commandList, m_loadingBlockCompression,
+        firstDescriptor);
+    material.streamedMemorySize = material.transcodedMemorySize - residentMemorySize;
+    material.transcodedMemorySize = residentMemorySize;
+
+    // Don't wait for the GPU here: the file data has been copied into the upload buffers, NVRHI keeps the resources
+    // used by the command list alive, and the slot's descriptors are not reused until its query is signaled.
+    OnDemandTranscodeSlot& transcodeSlot = m_onDemandTranscodeSlots[slot];
+    if (!transcodeSlot.query)
+        transcodeSlot.query = m_device->createEventQuery();
+    m_device->resetEventQuery(transcodeSlot.query);
+    m_device->setEventQuery(transcodeSlot.query, nvrhi::CommandQueue::Graphics);
+    transcodeSlot.submitted = true;
+
+    if (!transcodedSuccessfully)
+    {
+        EvictTranscodedMaterial(materials);
+        return false;
+    }
+
+    // The BC7 mode data is only needed for the compression passes that have just been submitted
+    for (TextureTranscodeTask& transcodeTask : material.transcodeMapping)
+    {
+        transcodeTask.bc7ModeBuffer = nullptr;
+        transcodeTask.bc7ModeBufferMipRanges.clear();
+    }
+
+    for (size_t index = 1; index < materials.size(); ++index)
+    {
+        NtcMaterial& duplicate = *materials[index];
+        for (TextureTranscodeTask const& transcodeTask : material.transcodeMapping)
+            duplicate.*transcodeTask.pMaterialTexture = material.*transcodeTask.pMaterialTexture;
+        duplicate.streamedMemorySize = material.streamedMemorySize;
+        duplicate.metalnessInRedChannel = material.metalnessInRedChannel;
+    }
+
+    outSlot = slot;
+    return true;
+}
+
+bool NtcMaterialLoader::IsMaterialTranscodeOnDemandComplete(int slot)
+{
+    return IsOnDemandTranscodeSlotFree(slot);
+}
+
+void NtcMaterialLoader::EvictTranscodedMaterial(std::vector<NtcMaterial*> const& materials)
+{
+    // NVRHI keeps the textures alive until the frames in flight that may use them are finished
+    for (NtcMaterial* material : materials)
+    {
+        for (TextureTranscodeTask& transcodeTask : material->transcodeMapping)
+        {
+            material->*transcodeTask.pMaterialTexture = nullptr;
+            transcodeTask.ReleaseTextures();
+        }
+        material->streamedMemorySize = 0;
+        material->useTranscodedTextures = false;
+    }
+}
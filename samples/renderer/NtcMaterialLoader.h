@@ -15,8 +15,11 @@
 #include <libntc/ntc.h>
 #include <nvrhi/nvrhi.h>
 #include <filesystem>
+#include <chrono>
 #include <unordered_map>
 #include <ntc-utils/DeviceUtils.h>
+#include <ntc-utils/PoolAllocator.h>
+#include <ntc-utils/WeightTypeSelection.h>
 
 #include "feedbackmanager/include/FeedbackManager.h"
 
@@ -24,14 +27,17 @@ struct TextureTranscodeTask;
 struct NtcMaterial;
 class GraphicsDecompressionPass;
 class GraphicsBlockCompressionPass;
+class NtcPackage;
+class DStorageLoadingBatch;
 
-#define MAX_TILES_PER_FRAME 32
 #define TRANSCODE_BATCH_SIZE 8
 
 namespace donut::engine
 {
     struct LoadedTexture;
     class Scene;
+    class ThreadPool;
+    class ShaderFactory;
 }
 
 struct TranscodeTileInfo
@@ -54,23 +60,103 @@ struct MaterialChannelMap
 
 typedef std::array<int, size_t(ntc::InferenceWeightType::Count)> WeightTypeHistogram;
 
+struct MaterialLoadingTask;
+class MipGenerationPass;
+
 class NtcMaterialLoader
 {
 public:
-    NtcMaterialLoader(nvrhi::IDevice* device)
-        : m_device(device)
-    { }
+    NtcMaterialLoader(nvrhi::IDevice* device);
+    ~NtcMaterialLoader();
     
-    bool Init(bool enableCoopVec, bool enableGpuDeflate, bool debug, nvrhi::ITexture* dummyTexture);
+    bool Init(bool enableCoopVec, bool enableGpuDeflate, bool debug, nvrhi::ITexture* dummyTexture,
+        std::shared_ptr<donut::engine::ShaderFactory> shaderFactory);
+
+    // Sets the number of top mip levels that are decoded through NTC when transcoding materials on load.
+    // The lower mip levels are generated from the last decoded level on the GPU, which is faster but
+    // doesn't match the NTC-encoded mips exactly. 0 means that all mip levels are decoded.
+    void SetNumDecodedMips(int numDecodedMips) { m_numDecodedMips = numDecodedMips; }
+
+    // Enables transcoding of the materials for inference on load when they're needed, instead of during loading.
+    // Only the alpha masks are transcoded when the materials are loaded, and the NTC data source and transcode mapping
+    // are kept for TranscodeMaterialOnDemand. Not compatible with inference on feedback.
+    void SetTranscodeOnDemand(bool enable) { m_transcodeOnDemand = enable; }
+
+    // Enables progressive loading of the latents for the materials that are only used with inference on sample:
+    // the weights and the smallest latent mips are loaded first, so that the materials render at a lower resolution
+    // soon, and the finer mips are added later by UpdateProgressiveLatents. Materials that are transcoded on load
+    // or used with inference on feedback always load all latent mips.
+    void SetProgressiveLatents(bool enable) { m_progressiveLatents = enable; }
+
+    // Selects the weight type of the materials by the timings of the decompression benchmark on this adapter and
+    // driver instead of the static preference for CoopVec. The timings are read from the cache file, and if they
+    // are missing, the benchmark runs on the first loaded material and its results are stored in the file.
+    void EnableWeightTypeBenchmark(std::filesystem::path const& cacheFileName);
+
+    // Creates a texel cache buffer for the materials used with inference on sample, with one entry per 4 texels
+    // of mip 0 but no more than maxEntries, see NtcTexelCache.hlsli. 0 means no texel caches.
+    void SetTexelCacheSize(int maxEntries) { m_texelCacheMaxEntries = maxEntries; }
+
+    // Transcodes the coarse mips of the materials for inference on sample into a BCn mip tail when they are loaded,
+    // and the shaders sample the tail instead of running inference on these mips. The tail starts at the finest
+    // mip level whose textures take no more than memoryRatio times the material's NTC data. 0 means no mip tails.
+    // Not compatible with progressive latents.
+    void SetMipTailMemoryRatio(float memoryRatio) { m_mipTailMemoryRatio = memoryRatio; }
 
     bool IsCooperativeVectorSupported() const { return m_coopVec; }
 
+    // Opens a package file created with ntc-cli --savePackage. The materials whose NTC files are found in
+    // the package are loaded from it with one read per material, the others are loaded from their files.
+    bool OpenMaterialPackage(std::filesystem::path const& fileName);
+
+    // Loads all NTC materials for the scene and returns when they are ready.
     bool LoadMaterialsForScene(donut::engine::Scene& scene, std::filesystem::path const& materialDir, 
         bool enableInferenceOnLoad, bool enableBlockCompression, bool enableInferenceOnSample,
         bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager);
 
+    // Starts loading the NTC materials for the scene: the files are opened and their metadata is parsed
+    // on worker threads. The GPU resources are created by subsequent calls to UpdateLoadingMaterials.
+    // Until a material is loaded, it renders without textures, using only its constant parameters.
+    void BeginLoadingMaterials(donut::engine::Scene& scene, std::filesystem::path const& materialDir, 
+        bool enableInferenceOnLoad, bool enableBlockCompression, bool enableInferenceOnSample,
+        bool enableInferenceOnFeedback, std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager);
+
+    // Uploads and transcodes the materials whose metadata is ready, until timeLimitSeconds is exceeded.
+    // If timeLimitSeconds is 0, waits for and processes all remaining materials.
+    // The materials that have been completed are appended to loadedMaterials.
+    // Returns true when there are no more materials to load.
+    bool UpdateLoadingMaterials(float timeLimitSeconds, std::vector<std::shared_ptr<NtcMaterial>>& loadedMaterials);
+
+    bool IsLoadingMaterials() const { return !m_loadingTasks.empty(); }
+
+    // Loads one more latent mip level for the materials with progressive latents, until timeLimitSeconds is exceeded,
+    // opening their NTC files again. The materials that received new latents are appended to refinedMaterials,
+    // their binding sets must be recreated. Returns true when all latent mips of the loaded materials are resident.
+    bool UpdateProgressiveLatents(float timeLimitSeconds, std::vector<NtcMaterial*>& refinedMaterials);
+
+    bool IsLoadingProgressiveLatents() const { return !m_progressiveMaterials.empty(); }
+
+    // Decompresses the tiles into the feedback textures, using BCn compression if enableBlockCompression is true.
+    // When enableDirectDecode is true, uncompressed tiles are decoded straight into the tiled textures
+    // instead of going through the staging textures.
     bool TranscodeTiles(const std::vector<TranscodeTileInfo>& tiles, nvrhi::ICommandList* commandList,
-        bool enableBlockCompression);
+        bool enableBlockCompression, bool enableDirectDecode);
+
+    // Returns true if TranscodeMaterialOnDemand can submit another material: a limited number of them can be
+    // transcoding on the GPU at the same time.
+    bool CanTranscodeMaterialOnDemand();
+
+    // Transcodes the textures of materials that were loaded with SetTranscodeOnDemand(true), opening their NTC file
+    // again for the BC7 mode data. All materials must use the same NTC data: the first one is transcoded,
+    // and the others receive its textures. The work is submitted without waiting for the GPU, use
+    // IsMaterialTranscodeOnDemandComplete with outSlot to find out when the textures are ready.
+    bool TranscodeMaterialOnDemand(std::vector<NtcMaterial*> const& materials, int& outSlot);
+
+    // Returns true when the GPU has completed the transcoding submitted by TranscodeMaterialOnDemand into the slot.
+    bool IsMaterialTranscodeOnDemandComplete(int slot);
+
+    // Releases the textures created by TranscodeMaterialOnDemand, the materials go back to inference on sample.
+    void EvictTranscodedMaterial(std::vector<NtcMaterial*> const& materials);
 
     WeightTypeHistogram const& GetWeightTypeHistogram() const { return m_weightTypeHistogram; }
 
@@ -78,38 +164,145 @@ private:
     nvrhi::DeviceHandle m_device;
     nvrhi::CommandListHandle m_commandList;
 
+    // Declared before the context, which must be destroyed first
+    PoolAllocator m_allocator;
     ntc::ContextWrapper m_ntcContext;
 
     std::unique_ptr<GDeflateFeatures> m_gdeflateFeatures;
+    std::unique_ptr<DStorageLoadingBatch> m_dstorageBatch; // Only on DX12 with GPU decompression
 
     bool m_coopVec = false;
     WeightTypeHistogram m_weightTypeHistogram;
 
+    // Weight type benchmark state, see EnableWeightTypeBenchmark
+    bool m_benchmarkWeightTypes = false;
+    bool m_adapterIdentityKnown = false;
+    AdapterIdentity m_adapterIdentity;
+    std::filesystem::path m_weightTypeCacheFileName;
+    WeightTypeTimings m_weightTypeTimings{};
+
     std::shared_ptr<donut::engine::LoadedTexture> m_dummyTexture;
 
     std::shared_ptr<GraphicsDecompressionPass> m_graphicsDecompressionPass;
     std::shared_ptr<GraphicsBlockCompressionPass> m_graphicsBlockCompressionPass;
+    std::shared_ptr<MipGenerationPass> m_mipGenerationPass;
+    int m_numDecodedMips = 0;
+    bool m_transcodeOnDemand = false;
+    bool m_progressiveLatents = false;
+    int m_texelCacheMaxEntries = 0;
+    float m_mipTailMemoryRatio = 0.f;
+    std::shared_ptr<NtcPackage> m_materialPackage;
 
     nvrhi::BufferHandle m_weightUploadBuffer;
 
+    // Buffers that hold the inference weights of multiple materials, only the last one has free space.
+    // This is a bump allocator that is reset for every scene, see AllocateWeights.
+    std::vector<nvrhi::BufferHandle> m_weightAtlasBuffers;
+    uint64_t m_weightAtlasOffset = 0;
+
     // Textures for tile-based decompression and recompression
     uint32_t m_texTileColorR8Offset = 0;
     uint32_t m_texTileColorRGBAOffset = 0;
     uint32_t m_texTileBlocksRGOffset = 0;
     uint32_t m_texTileBlocksRGBAOffset = 0;
     std::vector<nvrhi::TextureHandle> m_texTranscodeTiles;
+    bool m_tileDescriptorsValid = false; // True if the decompression descriptor table holds the tile textures
+
+    // Transcoding submitted by TranscodeMaterialOnDemand, each slot uses its own range of the descriptor table
+    struct OnDemandTranscodeSlot
+    {
+        nvrhi::EventQueryHandle query;
+        bool submitted = false;
+    };
+    std::vector<OnDemandTranscodeSlot> m_onDemandTranscodeSlots;
+
+    // Loading work that has been submitted to the GPU and not waited for, see RetireLoadingWork
+    int m_nextLoadingDescriptor = 0;
+    uint64_t m_pendingLoadingBytes = 0;
+
+    uint32_t m_nextFeedbackDescriptor = 0; // Next free descriptor for feedback texture mips, see PrepareFeedbackMaterial
+
+    // State of the material loading process, see BeginLoadingMaterials
+    std::vector<std::unique_ptr<MaterialLoadingTask>> m_loadingTasks;
+    std::unique_ptr<donut::engine::ThreadPool> m_threadPool;
+    bool m_loadingInferenceOnLoad = false;
+    bool m_loadingBlockCompression = false;
+    bool m_loadingInferenceOnFeedback = false;
+    std::shared_ptr<nvfeedback::FeedbackManager> m_loadingFeedbackManager;
+    std::chrono::steady_clock::time_point m_loadingStartTime;
+    uint64_t m_loadedFileSize = 0;
+    uint64_t m_loadedPixels = 0;
+    int m_loadedMaterialCount = 0;
+
+    // Loaded materials whose finer latent mips are not resident yet, see SetProgressiveLatents
+    struct ProgressiveMaterial
+    {
+        std::shared_ptr<NtcMaterial> material;
+        // Other materials that use the same NTC data, they receive the new latents too
+        std::vector<std::shared_ptr<NtcMaterial>> duplicates;
+    };
+    std::vector<ProgressiveMaterial> m_progressiveMaterials;
+
+    void WriteTileDescriptors();
+
+    void ScheduleMaterialLoadingTasks();
+    bool LoadMaterial(MaterialLoadingTask& task);
+
+    // Returns the first of 'count' decompression descriptors for transcoding a material during loading,
+    // or -1 if the material needs too many. Retires the loading work first if the range is used up.
+    int AllocateLoadingDescriptors(int count);
+
+    // Waits for the GPU to complete the submitted loading work and releases its upload buffers and descriptors.
+    void RetireLoadingWork();
+
+    // ntcFileData is the in-memory contents of ntcFile when it's available (mapped or inline), or nullptr.
+    // Transcodes the textures in transcodeMapping starting from firstMip. With firstMip > 0, the textures
+    // are stored as the material's mip tail and not in its texture slots. The decompression descriptors
+    // for the textures are written into the table starting at firstDescriptor.
+    bool TranscodeMaterial(ntc::IContext* context, ntc::IStream* ntcFile, uint8_t const* ntcFileData,
+        ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material,
+        std::vector<TextureTranscodeTask>& transcodeMapping, int firstMip, nvrhi::ICommandList* commandList,
+        bool enableBlockCompression, int firstDescriptor);
+
+    bool IsOnDemandTranscodeSlotFree(int slot);
+
+    // Selects the first mip level of the material's mip tail and transcodes it, see SetMipTailMemoryRatio.
+    bool TranscodeMipTail(ntc::IStream* ntcFile, uint8_t const* ntcFileData,
+        ntc::ITextureSetMetadata* textureSetMetadata, MaterialChannelMap const& channelMap, NtcMaterial& material);
+
+    // Sub-allocates a range for the material's inference weights in the shared weight buffers.
+    // The ranges are never freed individually: every material is loaded once per scene and keeps its weights
+    // until the next BeginLoadingMaterials call releases all weight buffers. Evicting transcoded textures
+    // keeps the weights, which are needed to transcode the material again.
+    bool AllocateWeights(size_t weightSize, NtcMaterial& material);
+
+    // When dstorageBatch is provided, the DirectStorage requests for the latents are added to it instead of
+    // being completed before returning. When progressiveLatents is true, only the smallest latent mips are loaded.
+    bool PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFile, uint8_t const* ntcFileData,
+        ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, bool progressiveLatents,
+        nvrhi::ICommandList* commandList, DStorageLoadingBatch* dstorageBatch = nullptr);
+
+    // Returns the weight type for inference on sample and on load. With the weight type benchmark, runs it
+    // on this texture set if some of its weight types have not been measured on this adapter yet.
+    ntc::InferenceWeightType SelectWeightType(ntc::IStream* ntcFile, ntc::ITextureSetMetadata* textureSetMetadata);
+
+    // Measures the weight types on one texture set and stores the timings in the cache file.
+    bool RunWeightTypeBenchmark(ntc::IStream* ntcFile, ntc::ITextureSetMetadata* textureSetMetadata,
+        std::vector<ntc::InferenceWeightType> const& candidates);
 
-    bool TranscodeMaterial(ntc::IContext* context, ntc::IStream* ntcFile,
-        ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, nvrhi::ICommandList* commandList,
-        bool enableBlockCompression);
+    // Creates a latent texture that starts at firstLatentMip, loads the latents into it, and writes the material's
+    // NTC and streaming constants for it. The material's previous latent texture is replaced on success.
+    bool LoadLatentMips(ntc::IStream* ntcFile, uint8_t const* ntcFileData,
+        ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, ntc::InferenceWeightType weightType,
+        int firstLatentMip, nvrhi::ICommandList* commandList, DStorageLoadingBatch* dstorageBatch = nullptr);
 
-    bool PrepareMaterialForInferenceOnSample(ntc::IStream* ntcFile,
-        ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, nvrhi::ICommandList* commandList);
+    // Loads the next finer latent mip level of a material with progressive latents
+    bool RefineLatents(ProgressiveMaterial& progressive);
 
     bool PrepareFeedbackMaterial(std::shared_ptr<nvfeedback::FeedbackManager> feedbackManager,
         ntc::ITextureSetMetadata* textureSetMetadata, NtcMaterial& material, bool enableBlockCompression);
 
     bool CreateAndLoadModeBufferForTexture(ntc::IContext* ntcContext, ntc::IStream* ntcFile,
-        ntc::ITextureSetMetadata* textureSetMetadata, TextureTranscodeTask& transcodeTask,
+        uint8_t const* ntcFileData, ntc::ITextureSetMetadata* textureSetMetadata, TextureTranscodeTask& transcodeTask,
         nvrhi::ICommandList* commandList, std::string const& materialTextureName);
 };
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Decodes all channels of the NTC material at one texel and distributes them into the material texture fields.
+// Shared by the forward and deferred Inference on Sample paths. Expects the MaterialConstants buffer to be declared
+// as g_Material, and the LibNTC inference header (Inference.hlsli or InferenceCoopVec.hlsli) to be included.
+// With USE_TEXEL_CACHE, the pass constants must be declared as g_Pass.
+
+#ifndef NTC_MATERIAL_SAMPLING_HLSLI
+#define NTC_MATERIAL_SAMPLING_HLSLI
+
+#include "NtcForwardShadingPassConstants.h"
+#include "NtcChannelMapping.h"
+
+DECLARE_CBUFFER(NtcTextureSetConstants, g_NtcMaterial, FORWARD_BINDING_NTC_MATERIAL_CONSTANTS, FORWARD_SPACE_MATERIAL);
+Texture2DArray t_Latents         : REGISTER_SRV(FORWARD_BINDING_NTC_LATENTS_TEXTURE, FORWARD_SPACE_MATERIAL);
+DECLARE_CBUFFER(NtcStreamingConstants, g_NtcStreaming, FORWARD_BINDING_NTC_STREAMING_CONSTANTS, FORWARD_SPACE_MATERIAL);
+ByteAddressBuffer t_WeightBuffer : REGISTER_SRV(FORWARD_BINDING_NTC_WEIGHTS_BUFFER, FORWARD_SPACE_MATERIAL);
+
+// Coarse mips transcoded on load, see NtcMaterialLoader::SetMipTailMemoryRatio. Mip 0 of these textures
+// is mip g_NtcStreaming.mipTailFirstMip of the texture set, and the colors are stored sRGB-encoded.
+Texture2D t_MipTailBaseColor             : REGISTER_SRV(FORWARD_BINDING_NTC_MIP_TAIL_BASE_COLOR, FORWARD_SPACE_MATERIAL);
+Texture2D t_MipTailMetalRoughOrSpecular  : REGISTER_SRV(FORWARD_BINDING_NTC_MIP_TAIL_METAL_ROUGH_OR_SPECULAR, FORWARD_SPACE_MATERIAL);
+Texture2D t_MipTailNormal                : REGISTER_SRV(FORWARD_BINDING_NTC_MIP_TAIL_NORMAL, FORWARD_SPACE_MATERIAL);
+Texture2D t_MipTailEmissive              : REGISTER_SRV(FORWARD_BINDING_NTC_MIP_TAIL_EMISSIVE, FORWARD_SPACE_MATERIAL);
+Texture2D t_MipTailOcclusion             : REGISTER_SRV(FORWARD_BINDING_NTC_MIP_TAIL_OCCLUSION, FORWARD_SPACE_MATERIAL);
+Texture2D t_MipTailTransmission          : REGISTER_SRV(FORWARD_BINDING_NTC_MIP_TAIL_TRANSMISSION, FORWARD_SPACE_MATERIAL);
+
+#if USE_TEXEL_CACHE
+#include "NtcTexelCache.hlsli"
+#endif
+
+// Reads the NTC channels of one texel from the mip tail textures, using the same channel mapping as inference.
+// The channels that are not in the tail get the same constants that the loader uses for missing channels.
+void LoadNtcMipTailTexel(int2 texel, int tailMipLevel, out float channels[NTC_MLP_OUTPUT_CHANNELS])
+{
+    int3 const location = int3(texel, tailMipLevel);
+    float4 const baseColor = t_MipTailBaseColor.Load(location);
+    float4 const metalRoughOrSpecular = t_MipTailMetalRoughOrSpecular.Load(location);
+    float3 const normal = t_MipTailNormal.Load(location).rgb;
+    float3 const emissive = t_MipTailEmissive.Load(location).rgb;
+    float const transmission = t_MipTailTransmission.Load(location).r;
+
+    // Occlusion shares its channel with the blue specular color, it's only stored separately for metal-rough
+    bool const specularGloss = (g_Material.flags & MaterialFlags_UseSpecularGlossModel) != 0;
+    float const occlusionOrSpecularBlue = specularGloss
+        ? metalRoughOrSpecular.b
+        : t_MipTailOcclusion.Load(location).r;
+
+    float const tailChannels[NTC_MIP_TAIL_CHANNELS] = {
+        baseColor.r, baseColor.g, baseColor.b, baseColor.a,
+        metalRoughOrSpecular.r, metalRoughOrSpecular.g, occlusionOrSpecularBlue, metalRoughOrSpecular.a,
+        normal.r, normal.g, normal.b, 1.0,
+        emissive.r, emissive.g, emissive.b, transmission };
+
+    [unroll]
+    for (int ch = 0; ch < NTC_MLP_OUTPUT_CHANNELS; ++ch)
+        channels[ch] = 1.0;
+    channels[CHANNEL_NORMAL + 0] = 0.5;
+    channels[CHANNEL_NORMAL + 1] = 0.5;
+
+    [unroll]
+    for (int ch = 0; ch < NTC_MIP_TAIL_CHANNELS; ++ch)
+    {
+        if ((g_NtcStreaming.mipTailChannelMask & (1u << ch)) != 0)
+            channels[ch] = tailChannels[ch];
+    }
+}
+
+MaterialTextureSample SampleNtcMaterialTexel(SamplerState latentSampler, int2 texel, int mipLevel)
+{
+    // The NtcSampleTextureSet... functions can convert all channels to linear color based on metadata stored
+    // in the constant buffer. But that can be relatively slow if not optimized away by the driver.
+    // Since we know the color spaces for all channels in advance, linearize explicitly below.
+    const bool linearizeColorsOnSample = false;
+
+    // The finer latent mips of a progressively loaded material may not be resident yet,
+    // decode the same location from the finest color mip that they support instead.
+    if (mipLevel < g_NtcStreaming.minColorMip)
+    {
+        texel >>= g_NtcStreaming.minColorMip - mipLevel;
+        mipLevel = g_NtcStreaming.minColorMip;
+    }
+
+    // Decompress the texel and get all the channels.
+    float channels[NTC_MLP_OUTPUT_CHANNELS];
+    bool sampleSucceeded = false;
+    if (g_NtcStreaming.mipTailFirstMip > 0 && mipLevel >= g_NtcStreaming.mipTailFirstMip)
+    {
+        // The coarse mips are transcoded, read them instead of running inference
+        LoadNtcMipTailTexel(texel, mipLevel - g_NtcStreaming.mipTailFirstMip, channels);
+        sampleSucceeded = true;
+    }
+#if USE_TEXEL_CACHE
+    // Reuse the channels decoded for this texel in a previous frame, and store them on a miss.
+    NtcTexelCache texelCache = NtcTexelCache::Create(texel, mipLevel, g_Pass.frameIndex, g_Pass.texelCacheMaxAge);
+    if (!sampleSucceeded)
+        sampleSucceeded = texelCache.Load(channels);
+#endif
+    if (!sampleSucceeded)
+    {
+#ifdef USE_COOPVEC
+        sampleSucceeded = NtcSampleTextureSet_CoopVec_FP8(g_NtcMaterial, t_Latents, latentSampler,
+            t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
+#else
+        sampleSucceeded = NtcSampleTextureSet(g_NtcMaterial, t_Latents, latentSampler,
+            t_WeightBuffer, 0, texel, mipLevel, linearizeColorsOnSample, channels);
+#endif
+#if USE_TEXEL_CACHE
+        if (sampleSucceeded)
+            texelCache.Store(channels);
+#endif
+    }
+
+    // Initialize the 'textures' object with default values, just in case we miss something below.
+    MaterialTextureSample textures = DefaultMaterialTextures();
+    
+    if (!sampleSucceeded)
+        return textures;
+
+    // Distribute the NTC channels into the MaterialTextureSample's fields using a fixed mapping.
+    // The mapping is enforced by the loader, see NtcMaterialLoader.cpp
+    // If some texture channels are not present in the NTC material file, they are replaced with constant values
+    // by the loader.
+    
+    textures.baseOrDiffuse.rgb = float3(
+        channels[CHANNEL_BASE_COLOR + 0],
+        channels[CHANNEL_BASE_COLOR + 1],
+        channels[CHANNEL_BASE_COLOR + 2]);
+
+
+    if (!linearizeColorsOnSample)
+        textures.baseOrDiffuse.rgb = NtcSrgbColorSpace::Decode(textures.baseOrDiffuse.rgb);
+
+    textures.opacity.r = channels[CHANNEL_OPACITY];
+
+    if ((g_Material.flags & MaterialFlags_UseSpecularGlossModel) != 0)
+    {
+        textures.metalRoughOrSpecular.rgb = float3(
+            channels[CHANNEL_SPECULAR_COLOR + 0],
+            channels[CHANNEL_SPECULAR_COLOR + 1],
+            channels[CHANNEL_SPECULAR_COLOR + 2]);
+            
+        if (!linearizeColorsOnSample)
+            textures.metalRoughOrSpecular.rgb = NtcSrgbColorSpace::Decode(textures.metalRoughOrSpecular.rgb);
+        
+        textures.metalRoughOrSpecular.a = channels[CHANNEL_GLOSSINESS];
+    }
+    else
+    {
+        textures.metalRoughOrSpecular.g = channels[CHANNEL_ROUGHNESS];
+        textures.metalRoughOrSpecular.r = channels[CHANNEL_METALNESS];
+    }
+
+    textures.normal.rgb = float3(
+        channels[CHANNEL_NORMAL + 0],
+        channels[CHANNEL_NORMAL + 1],
+        channels[CHANNEL_NORMAL + 2]);
+
+    textures.occlusion.r = channels[CHANNEL_OCCLUSION];
+
+    textures.emissive.rgb = float3(
+        channels[CHANNEL_EMISSIVE + 0],
+        channels[CHANNEL_EMISSIVE + 1],
+        channels[CHANNEL_EMISSIVE + 2]);
+
+    if (!linearizeColorsOnSample)
+        textures.emissive.rgb = NtcSrgbColorSpace::Decode(textures.emissive.rgb);
+    
+    textures.transmission.r = channels[CHANNEL_TRANSMISSION];
+    
+    return textures;
+}
+
+#endif // NTC_MATERIAL_SAMPLING_HLSLI
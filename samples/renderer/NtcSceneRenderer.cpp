@@ -32,6 +32,7 @@
 #include <nvrhi/utils.h>
 #include <ntc-utils/DeviceUtils.h>
 #include <ntc-utils/Misc.h>
+#include <ntc-utils/WeightTypeSelection.h>
 #include <argparse.h>
 #include <sstream>
 #include <chrono>
@@ -41,12 +42,31 @@
 #include <sstream>
 #include <chrono>
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <deque>
+#include <unordered_set>
 
+#include "CameraPath.h"
 #include "NtcMaterialLoader.h"
 #include "NtcMaterial.h"
 #include "NtcForwardShadingPass.h"
 #include "Profiler.h"
 #include "RenderTargets.h"
+#include "TileScheduler.h"
+#include "MaterialModePolicy.h"
+#include "MaterialStreamer.h"
+
+#if NTC_WITH_DX12
+    #include "compiled_shaders/FeedbackCompaction.dxil.h"
+    #include "compiled_shaders/MinMipUpdate.dxil.h"
+#endif
+
+#if NTC_WITH_VULKAN
+    #include "compiled_shaders/FeedbackCompaction.spirv.h"
+    #include "compiled_shaders/MinMipUpdate.spirv.h"
+    #include <vulkan/vulkan.hpp>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -58,6 +78,7 @@ struct
 {
     std::string scenePath;
     const char* materialDir = nullptr;
+    const char* materialPackage = nullptr;
     bool debug = false;
     bool useVulkan = false;
     bool useDX12 = false;
@@ -67,11 +88,42 @@ struct
     bool inferenceOnSample = true;
     bool inferenceOnFeedback = true;
     bool enableCoopVec = true;
+    bool benchmarkWeightTypes = false;
+    const char* weightTypeCache = nullptr;
     bool enableGpuDeflate = false;
     bool enableDLSS = true;
+    float dlssRenderScale = 1.f;
+    bool asyncFeedback = false;
+    bool directTileDecode = true;
+    bool feedbackCompaction = true;
+    int feedbackMemoryBudgetMB = 0;
+    bool feedbackDefragment = false;
+    bool streamMaterials = false;
+    bool transcodeOnDemand = false;
+    bool progressiveLatents = false;
+    bool deferredInference = false;
+    bool texelCache = false;
+    int texelCacheEntries = 1 << 18;
+    int texelCacheMaxAge = 8;
+    float mipTailMemoryRatio = 0.f;
+    int decodedMips = 0;
     int adapterIndex = -1;
+    int benchmarkFrames = 0;
+    bool headless = false;
+    const char* cameraPath = nullptr;
+    const char* profileOutput = nullptr;
+    const char* benchmarkMode = nullptr;
 } g_options;
 
+// Benchmark runs advance the camera path by a fixed time step per frame, so that every run renders the same views
+static const float c_benchmarkTimeStep = 1.f / 60.f;
+
+// Lowest supported render resolution scale for DLSS, which matches its Ultra Performance mode
+static const float c_minDlssRenderScale = 0.33f;
+
+// Number of frames that can be in flight in headless mode, where there is no swap chain to limit it
+static const uint32_t c_headlessFramesInFlight = 3;
+
 bool ProcessCommandLine(int argc, const char** argv)
 {
     struct argparse_option options[] = {
@@ -89,10 +141,33 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_BOOLEAN(0, "inferenceOnSample", &g_options.inferenceOnSample, "Enable inference on sample (default on, use --no-inferenceOnSample)"),
         OPT_BOOLEAN(0, "inferenceOnFeedback", &g_options.inferenceOnFeedback, "Enable inference on feedback (default on, use --no-inferenceOnFeedback)"),
         OPT_BOOLEAN(0, "coopVec", &g_options.enableCoopVec, "Enable CoopVec extensions (default on, use --no-coopVec)"),
+        OPT_BOOLEAN(0, "benchmarkWeightTypes", &g_options.benchmarkWeightTypes, "Use the fastest inference weight type measured on this adapter and driver, running a benchmark on the first material when it's not cached yet"),
+        OPT_STRING(0, "weightTypeCache", &g_options.weightTypeCache, "File with the weight type benchmark results per adapter and driver, default is ntc-weight-types.json next to the executable"),
         OPT_BOOLEAN(0, "gpuGDeflate", &g_options.enableGpuDeflate, "Enable GPU-based GDeflate decompression"),
         OPT_BOOLEAN(0, "dlss", &g_options.enableDLSS, "Enable DLSS (default on, use --no-dlss)"),
+        OPT_FLOAT(0, "dlssScale", &g_options.dlssRenderScale, "Render resolution relative to the window when DLSS is active, 0.33 to 1 (default 1 = native)"),
+        OPT_BOOLEAN(0, "asyncFeedback", &g_options.asyncFeedback, "Map and transcode feedback tiles on the copy and compute queues, asynchronously to rendering"),
+        OPT_BOOLEAN(0, "directTileDecode", &g_options.directTileDecode, "Decode uncompressed feedback tiles directly into the tiled textures (default on, use --no-directTileDecode)"),
+        OPT_BOOLEAN(0, "feedbackCompaction", &g_options.feedbackCompaction, "Read back only the changed feedback regions, found by a compute pass (default on, use --no-feedbackCompaction)"),
+        OPT_INTEGER(0, "feedbackMemoryBudget", &g_options.feedbackMemoryBudgetMB, "Memory budget for feedback tiles in MB (default 0 = derive from the OS video memory budget, -1 = unlimited)"),
+        OPT_BOOLEAN(0, "feedbackDefragment", &g_options.feedbackDefragment, "Move feedback tiles out of sparsely used heaps when over a quarter of the allocated tiles are free, so that the heaps can be released"),
+        OPT_BOOLEAN(0, "streamMaterials", &g_options.streamMaterials, "Show the scene while NTC materials are loading, using placeholder materials until they are ready"),
+        OPT_BOOLEAN(0, "transcodeOnDemand", &g_options.transcodeOnDemand, "Transcode the materials for inference on load when the camera approaches them, and evict them when it moves away"),
+        OPT_BOOLEAN(0, "progressiveLatents", &g_options.progressiveLatents, "Load the smallest latent mips of the materials first and the finer mips over the next frames, for inference on sample only"),
+        OPT_INTEGER(0, "decodedMips", &g_options.decodedMips, "Number of mip levels decoded through NTC when transcoding on load, the rest are generated on the GPU (default 0 = all)"),
+        OPT_BOOLEAN(0, "deferredInference", &g_options.deferredInference, "Start with the deferred resolve enabled for Inference on Sample"),
+        OPT_BOOLEAN(0, "texelCache", &g_options.texelCache, "Reuse the texels decoded by Inference on Sample in previous frames through a cache per material"),
+        OPT_INTEGER(0, "texelCacheEntries", &g_options.texelCacheEntries, "Maximum number of texel cache entries per material, 40 bytes each (default 262144)"),
+        OPT_INTEGER(0, "texelCacheMaxAge", &g_options.texelCacheMaxAge, "Number of frames after which unused texel cache entries can be replaced (default 8)"),
+        OPT_FLOAT(0, "mipTailMemoryRatio", &g_options.mipTailMemoryRatio, "Transcode the coarse mips for inference on sample into BCn, using up to this fraction of the NTC data size per material (default 0 = off)"),
         OPT_INTEGER(0, "adapter", &g_options.adapterIndex, "Index of the graphics adapter to use (use ntc-cli.exe --dx12|vk --listAdapters to find out)"),
         OPT_STRING(0, "materialDir", &g_options.materialDir, "Subdirectory near the scene file where NTC materials are located"),
+        OPT_STRING(0, "materialPackage", &g_options.materialPackage, "Load the NTC materials from this .ntcpak file created with ntc-cli --savePackage"),
+        OPT_INTEGER(0, "benchmark", &g_options.benchmarkFrames, "Render this many frames along the camera path, print the profiler percentiles and exit"),
+        OPT_BOOLEAN(0, "headless", &g_options.headless, "Run the benchmark without a window, requires --benchmark"),
+        OPT_STRING(0, "cameraPath", &g_options.cameraPath, "JSON file with the camera keyframes for --benchmark, the default is an orbit around the scene"),
+        OPT_STRING(0, "benchmarkMode", &g_options.benchmarkMode, "NTC mode for --benchmark: load, sample, feedback or hybrid"),
+        OPT_STRING(0, "profileOutput", &g_options.profileOutput, "Stream the per-frame profiler records of --benchmark into this file, .json or .csv"),
         OPT_END()
     };
 
@@ -152,6 +227,12 @@ bool ProcessCommandLine(int argc, const char** argv)
     g_options.useVulkan = true;
 #endif
 
+    if (g_options.dlssRenderScale < c_minDlssRenderScale || g_options.dlssRenderScale > 1.f)
+    {
+        log::error("The --dlssScale value must be between %.2f and 1.", c_minDlssRenderScale);
+        return false;
+    }
+
     if (g_options.scenePath.empty())
     {
         char const* defaultModelRelativePath = "assets/models/FlightHelmet/FlightHelmet.ntc.gltf";
@@ -187,9 +268,82 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false;
     }
 
-    if (!g_options.useDX12)
+    if (g_options.transcodeOnDemand)
     {
-        g_options.inferenceOnFeedback = false;
+        if (!g_options.inferenceOnLoad || !g_options.inferenceOnSample)
+        {
+            log::error("The option --transcodeOnDemand requires both inference on load and inference on sample.");
+            return false;
+        }
+
+        // The feedback textures are created from the transcode mapping that is only filled on demand
+        if (g_options.inferenceOnFeedback)
+        {
+            log::info("Inference on feedback is disabled with --transcodeOnDemand.");
+            g_options.inferenceOnFeedback = false;
+        }
+    }
+
+    if (g_options.progressiveLatents)
+    {
+        if (!g_options.inferenceOnSample || g_options.transcodeOnDemand)
+        {
+            log::error("The option --progressiveLatents requires inference on sample and cannot be used with "
+                "--transcodeOnDemand.");
+            return false;
+        }
+
+        // Transcoding for these modes reads all latent mips when the materials are loaded
+        if (g_options.inferenceOnLoad || g_options.inferenceOnFeedback)
+        {
+            log::info("Inference on load and inference on feedback are disabled with --progressiveLatents.");
+            g_options.inferenceOnLoad = false;
+            g_options.inferenceOnFeedback = false;
+        }
+    }
+
+    if (g_options.texelCache && !g_options.inferenceOnSample)
+    {
+        log::error("The option --texelCache requires inference on sample.");
+        return false;
+    }
+
+    if (g_options.texelCacheEntries <= 0 || g_options.texelCacheMaxAge <= 0)
+    {
+        log::error("The --texelCacheEntries and --texelCacheMaxAge values must be positive.");
+        return false;
+    }
+
+    if (g_options.mipTailMemoryRatio < 0.f)
+    {
+        log::error("The --mipTailMemoryRatio value must not be negative.");
+        return false;
+    }
+
+    if (g_options.mipTailMemoryRatio > 0.f && (!g_options.inferenceOnSample || g_options.progressiveLatents))
+    {
+        log::error("The option --mipTailMemoryRatio requires inference on sample and cannot be used with "
+            "--progressiveLatents.");
+        return false;
+    }
+
+    if (g_options.weightTypeCache && !g_options.benchmarkWeightTypes)
+    {
+        log::error("The option --weightTypeCache requires --benchmarkWeightTypes.");
+        return false;
+    }
+
+    if (g_options.benchmarkFrames < 0)
+    {
+        log::error("The --benchmark frame count must be positive.");
+        return false;
+    }
+
+    if ((g_options.headless || g_options.cameraPath || g_options.profileOutput || g_options.benchmarkMode) &&
+        g_options.benchmarkFrames == 0)
+    {
+        log::error("The options --headless, --cameraPath, --profileOutput and --benchmarkMode require --benchmark.");
+        return false;
     }
 
     return true;
@@ -228,17 +382,29 @@ enum class AntiAliasingMode
 #endif
 };
 
-struct RequestedTile
+const uint32_t g_feedbackCameraCutFramesInit = 10;
+const float g_materialLoadingTimePerFrame = 0.008f; // seconds, with --streamMaterials
+const float g_latentRefinementTimePerFrame = 0.004f; // seconds, with --progressiveLatents
+
+// Number of frames between submitting tile transcoding to the compute queue and exposing the tiles to rendering
+// when async feedback processing is enabled.
+const uint32_t g_asyncTranscodeLatencyFrames = 2;
+
+// A batch of tiles that have been mapped and submitted for transcoding on the compute queue,
+// but are not yet visible to rendering through the MinMip textures.
+struct PendingTileTranscode
 {
-    nvfeedback::FeedbackTexture* texture;
-    uint32_t tileIndex;
+    uint64_t computeInstance = 0;
+    uint32_t submitFrame = 0;
+    nvfeedback::FeedbackTextureCollection tiles;
 };
-const uint32_t g_feedbackCameraCutFramesInit = 10;
 
 class NtcSceneRenderer : public app::ImGui_Renderer
 {
 private:
     nvrhi::CommandListHandle m_commandList;
+    nvrhi::CommandListHandle m_copyCommandList;
+    nvrhi::CommandListHandle m_computeCommandList;
 
     RenderTargets m_renderTargets;
 
@@ -265,15 +431,27 @@ private:
 
     // Feedback mode related members
     std::shared_ptr<nvfeedback::FeedbackManager> m_feedbackManager;
+    LocalVideoMemoryInfo m_videoMemoryInfo;
     std::unordered_map<nvfeedback::FeedbackTexture*, donut::engine::LoadedTexture*> m_loadedTexturesByFeedback;
     std::unordered_map<nvfeedback::FeedbackTexture*, NtcMaterial*> m_materialsByFeedback;
-    std::queue<RequestedTile> m_requestedTiles;
+    TileScheduler m_tileScheduler;
+    std::deque<PendingTileTranscode> m_pendingTileTranscodes;
     uint32_t m_feedbackCameraCutFrames = 0;
+    uint32_t m_feedbackFrameCounter = 0;
+    bool m_asyncFeedbackSupported = false;
+    bool m_asyncFeedback = false;
+
+    // Hybrid mode related members
+    MaterialModePolicy m_materialModePolicy;
+    MaterialStreamer m_materialStreamer; // Replaces the mode policy with --transcodeOnDemand
 
     app::SwitchableCamera m_camera;
     engine::PlanarView m_view;
     engine::PlanarView m_previousView;
     AntiAliasingMode m_aaMode = AntiAliasingMode::TAA;
+    float m_dlssRenderScale = g_options.dlssRenderScale;
+    dm::uint2 m_renderSize = dm::uint2::zero();  // Size of the render targets, except the resolved ones
+    dm::uint2 m_displaySize = dm::uint2::zero(); // Size of the back buffer and the resolved color target
     std::shared_ptr<app::RegisteredFont> m_primaryFont = nullptr;
     std::shared_ptr<app::RegisteredFont> m_largerFont = nullptr;
     bool m_previousFrameValid = false;
@@ -284,15 +462,27 @@ private:
     std::string m_screenshotFileName;
     bool m_screenshotWithUI = true;
     bool m_useDepthPrepass = true;
+    bool m_deferredInference = g_options.deferredInference;
+    bool m_useTexelCache = g_options.texelCache;
+    int m_texelCacheMaxAge = g_options.texelCacheMaxAge;
     bool m_enableStochasticFeedback = true;
     float m_feedbackThreshold = 0.005f;
 
+    // Materials whose pipelines haven't been queued for precompilation yet, see RenderScene
+    std::vector<std::shared_ptr<NtcMaterial>> m_materialsToPrecompile;
+
     size_t m_ntcTextureMemorySize = 0;
     size_t m_transcodedTextureMemorySize = 0;
     size_t m_referenceTextureMemorySize = 0;
 
     Profiler m_profiler;
 
+    // Benchmark mode related members
+    CameraPath m_cameraPath;
+    int m_benchmarkFrame = 0;
+    bool m_benchmarkDone = false;
+    uint32_t m_headlessFrameIndex = 0;
+
 public:
     NtcSceneRenderer(app::DeviceManager *deviceManager)
         : ImGui_Renderer(deviceManager)
@@ -318,24 +508,97 @@ public:
 
         ImGui::GetIO().IniFilename = nullptr;
 
-#if NTC_WITH_DX12
+        // Inference on feedback works on D3D12 and Vulkan, using sampler feedback where it's available and
+        // feedback buffers written by the shader otherwise, but it always needs tiled resources.
+        if (g_options.inferenceOnFeedback && !GetDevice()->queryFeatureSupport(nvrhi::Feature::VirtualResources))
+        {
+            log::warning("The graphics device doesn't support tiled resources, inference on feedback is disabled.");
+            g_options.inferenceOnFeedback = false;
+        }
+
         if (g_options.inferenceOnFeedback)
         {
+            // Only used for the feedback memory budget, see GetFeedbackMemoryBudget
+            m_videoMemoryInfo.Init(GetDevice());
+
             nvfeedback::FeedbackManagerDesc fmDesc = {};
             fmDesc.heapSizeInTiles = 128;
-            fmDesc.numFramesInFlight = GetDeviceManager()->GetBackBufferCount();
+            fmDesc.numFramesInFlight = g_options.headless
+                ? c_headlessFramesInFlight
+                : GetDeviceManager()->GetBackBufferCount();
+            fmDesc.numPooledHeaps = 2;
+            fmDesc.asyncHeapCreation = true;
+            fmDesc.heapReleaseDelayFrames = 120;
+            fmDesc.minMipUpdateShader = m_shaderFactory->CreateStaticPlatformShader(
+                DONUT_MAKE_PLATFORM_SHADER(g_MinMipUpdate), nullptr, nvrhi::ShaderType::Compute);
+            if (g_options.feedbackCompaction)
+            {
+                fmDesc.feedbackCompactionShader = m_shaderFactory->CreateStaticPlatformShader(
+                    DONUT_MAKE_PLATFORM_SHADER(g_FeedbackCompaction), nullptr, nvrhi::ShaderType::Compute);
+            }
             m_feedbackManager = std::shared_ptr<nvfeedback::FeedbackManager>(
                 nvfeedback::CreateFeedbackManager(GetDevice(), fmDesc));
         }
-#endif
     }
 
     ~NtcSceneRenderer()
     {
+        // Finish the capture file if the window was closed before the benchmark ended
+        m_profiler.EndCapture();
         ImPlot::DestroyContext();
         m_scene.reset();
     }
 
+    // Renders the benchmark into an offscreen framebuffer, without a window or swap chain.
+    void RunHeadless(uint32_t width, uint32_t height)
+    {
+        nvrhi::TextureDesc colorDesc = nvrhi::TextureDesc()
+            .setDebugName("HeadlessColor")
+            .setWidth(width)
+            .setHeight(height)
+            .setFormat(nvrhi::Format::SRGBA8_UNORM)
+            .setIsRenderTarget(true)
+            .setInitialState(nvrhi::ResourceStates::RenderTarget)
+            .setKeepInitialState(true);
+        nvrhi::TextureHandle colorTexture = GetDevice()->createTexture(colorDesc);
+        nvrhi::FramebufferHandle framebuffer = GetDevice()->createFramebuffer(nvrhi::FramebufferDesc()
+            .addColorAttachment(colorTexture));
+
+        // Without a swap chain, nothing limits how far the CPU can run ahead of the GPU, so use event queries
+        std::vector<nvrhi::EventQueryHandle> frameQueries;
+        for (uint32_t i = 0; i < c_headlessFramesInFlight; ++i)
+            frameQueries.push_back(GetDevice()->createEventQuery());
+
+        auto previousFrameTime = std::chrono::steady_clock::now();
+        while (!m_benchmarkDone)
+        {
+            nvrhi::IEventQuery* frameQuery = frameQueries[m_headlessFrameIndex % c_headlessFramesInFlight];
+            if (m_headlessFrameIndex >= c_headlessFramesInFlight)
+                GetDevice()->waitEventQuery(frameQuery);
+            GetDevice()->resetEventQuery(frameQuery);
+
+            auto const frameTime = std::chrono::steady_clock::now();
+            Animate(std::chrono::duration<float>(frameTime - previousFrameTime).count());
+            previousFrameTime = frameTime;
+            if (m_benchmarkDone)
+                break;
+
+            Render(framebuffer);
+
+            GetDevice()->setEventQuery(frameQuery, nvrhi::CommandQueue::Graphics);
+            GetDevice()->runGarbageCollection();
+            ++m_headlessFrameIndex;
+        }
+
+        GetDevice()->waitForIdle();
+    }
+
+    // Returns the frame index for scene and pass updates. The device manager doesn't count frames in headless mode.
+    uint32_t GetRenderFrameIndex() const
+    {
+        return g_options.headless ? m_headlessFrameIndex : GetFrameIndex();
+    }
+
     // Returns names representing the math versions in the forward shading pass corresponding to each weight type.
     static char const* WeightTypeToMathString(ntc::InferenceWeightType weightType)
     {
@@ -414,14 +677,19 @@ public:
         {
             fs::path const materialDir = g_options.materialDir ? fs::path(g_options.materialDir) : fs::path();
 
-            if (!m_materialLoader->LoadMaterialsForScene(*m_scene, materialDir,
+            if (g_options.streamMaterials)
+            {
+                // Materials are completed over the next frames, see UpdateMaterialLoading
+                m_materialLoader->BeginLoadingMaterials(*m_scene, materialDir,
+                    g_options.inferenceOnLoad, g_options.blockCompression, g_options.inferenceOnSample,
+                    g_options.inferenceOnFeedback, m_feedbackManager);
+            }
+            else if (!m_materialLoader->LoadMaterialsForScene(*m_scene, materialDir,
                 g_options.inferenceOnLoad, g_options.blockCompression, g_options.inferenceOnSample,
                 g_options.inferenceOnFeedback, m_feedbackManager))
             {
                 return false;
             }
-
-            m_weightTypes = FormatWeightTypesText(m_materialLoader->GetWeightTypeHistogram());
         }
 
         m_scene->FinishedLoading(GetFrameIndex());
@@ -433,6 +701,9 @@ public:
         m_referenceTextureMemorySize = 0;
         m_ntcTextureMemorySize = 0;
         m_transcodedTextureMemorySize = 0;
+        m_materialModePolicy.Clear();
+        m_materialStreamer.Clear();
+        m_materialsToPrecompile.clear();
         if (g_options.referenceMaterials)
         {
             for (auto it = m_textureCache->begin(); it != m_textureCache->end(); ++it)
@@ -441,21 +712,56 @@ public:
                     m_referenceTextureMemorySize += GetDevice()->getTextureMemoryRequirements(it->second->texture).size;
             }
         }
-        else
+        else if (!g_options.streamMaterials)
         {
+            std::vector<std::shared_ptr<NtcMaterial>> materials;
             for (std::shared_ptr<engine::Material> const& material : m_scene->GetSceneGraph()->GetMaterials())
-            {
-                NtcMaterial const& ntcMaterial = static_cast<NtcMaterial const&>(*material);
-                m_ntcTextureMemorySize += ntcMaterial.ntcMemorySize;
-                m_transcodedTextureMemorySize += ntcMaterial.transcodedMemorySize;
-            }
+                materials.push_back(std::static_pointer_cast<NtcMaterial>(material));
+
+            AddLoadedMaterials(materials);
         }
 
+        if (g_options.transcodeOnDemand)
+        {
+            // Scale the streaming distances with the scene, they can be adjusted in the UI
+            auto sceneBoundingBox = m_scene->GetSceneGraph()->GetRootNode()->GetGlobalBoundingBox();
+            float const diagonalLength = length(sceneBoundingBox.diagonal());
+            MaterialStreamerDesc streamerDesc = m_materialStreamer.GetDesc();
+            streamerDesc.loadDistance = diagonalLength * 0.25f;
+            streamerDesc.evictDistance = diagonalLength * 0.35f;
+            m_materialStreamer.SetDesc(streamerDesc);
+        }
+
+        auto const& sceneCameras = m_scene->GetSceneGraph()->GetCameras();
+        if (!sceneCameras.empty())
+            m_camera.SwitchToSceneCamera(sceneCameras[0]);
+
+        return true;
+    }
+
+    // Adds the loaded NTC materials to the memory metrics and registers their feedback textures
+    void AddLoadedMaterials(std::vector<std::shared_ptr<NtcMaterial>> const& materials)
+    {
+        for (std::shared_ptr<NtcMaterial> const& material : materials)
+        {
+            m_ntcTextureMemorySize += material->ntcMemorySize;
+            m_transcodedTextureMemorySize += material->transcodedMemorySize;
+        }
+
+        if (g_options.transcodeOnDemand)
+            m_materialStreamer.AddMaterials(materials);
+        else if (g_options.inferenceOnLoad && g_options.inferenceOnSample)
+            m_materialModePolicy.AddMaterials(materials);
+
+        m_materialsToPrecompile.insert(m_materialsToPrecompile.end(), materials.begin(), materials.end());
+
+        m_weightTypes = FormatWeightTypesText(m_materialLoader->GetWeightTypeHistogram());
+
         if (g_options.inferenceOnFeedback)
         {
-            for (std::shared_ptr<engine::Material> const& material : m_scene->GetSceneGraph()->GetMaterials())
+            for (std::shared_ptr<NtcMaterial> const& material : materials)
             {
-                NtcMaterial const& ntcMaterial = static_cast<NtcMaterial const&>(*material);
+                NtcMaterial const& ntcMaterial = *material;
                 
                 auto add_texture = [this](std::shared_ptr<donut::engine::LoadedTexture> loadedTexture, nvrhi::RefCountPtr<nvfeedback::FeedbackTexture> feedbackTexture)
                     {
@@ -475,7 +781,7 @@ public:
                         m_materialsByFeedback[feedbackTexture.Get()] = material;
                     };
 
-                NtcMaterial* materialPtr = static_cast<NtcMaterial*>(material.get());
+                NtcMaterial* materialPtr = material.get();
                 add_material(materialPtr, ntcMaterial.baseOrDiffuseTextureFeedback);
                 add_material(materialPtr, ntcMaterial.metalRoughOrSpecularTextureFeedback);
                 add_material(materialPtr, ntcMaterial.normalTextureFeedback);
@@ -487,12 +793,80 @@ public:
             // Trigger camera cut
             m_feedbackCameraCutFrames = g_feedbackCameraCutFramesInit;
         }
+    }
 
-        auto const& sceneCameras = m_scene->GetSceneGraph()->GetCameras();
-        if (!sceneCameras.empty())
-            m_camera.SwitchToSceneCamera(sceneCameras[0]);
+    // Completes some of the materials that are loading in the background with --streamMaterials,
+    // and replaces the placeholders with them
+    void UpdateMaterialLoading()
+    {
+        if (!m_materialLoader->IsLoadingMaterials())
+            return;
 
-        return true;
+        std::vector<std::shared_ptr<NtcMaterial>> loadedMaterials;
+        m_materialLoader->UpdateLoadingMaterials(g_materialLoadingTimePerFrame, loadedMaterials);
+        if (loadedMaterials.empty())
+            return;
+
+        AddLoadedMaterials(loadedMaterials);
+
+        // Drop the binding sets that were created for the placeholders
+        for (std::shared_ptr<NtcMaterial> const& material : loadedMaterials)
+            material->dirty = true;
+
+        RefreshDirtyMaterials();
+    }
+
+    // Loads finer latent mips for the materials with --progressiveLatents and rebinds their latent textures
+    void UpdateProgressiveLatents()
+    {
+        if (!m_materialLoader->IsLoadingProgressiveLatents())
+            return;
+
+        std::vector<NtcMaterial*> refinedMaterials;
+        m_materialLoader->UpdateProgressiveLatents(g_latentRefinementTimePerFrame, refinedMaterials);
+        if (refinedMaterials.empty())
+            return;
+
+        // The latent textures of the refined materials have grown
+        m_ntcTextureMemorySize = 0;
+        for (std::shared_ptr<engine::Material> const& material : m_scene->GetSceneGraph()->GetMaterials())
+            m_ntcTextureMemorySize += std::static_pointer_cast<NtcMaterial>(material)->ntcMemorySize;
+
+        for (NtcMaterial* material : refinedMaterials)
+            material->dirty = true;
+
+        RefreshDirtyMaterials();
+    }
+
+    // Transcodes the materials near the camera and evicts the far ones with --transcodeOnDemand
+    void UpdateMaterialStreaming()
+    {
+        m_materialStreamer.UpdateDistances(*m_scene->GetSceneGraph(), m_view);
+
+        std::vector<NtcMaterial*> changedMaterials;
+        m_materialStreamer.StreamMaterials(*m_materialLoader, changedMaterials);
+        if (changedMaterials.empty())
+            return;
+
+        for (NtcMaterial* material : changedMaterials)
+            material->dirty = true;
+
+        RefreshDirtyMaterials();
+    }
+
+    // Updates the constants of the materials marked dirty, which have the texture flags,
+    // and drops the binding sets that refer to their previous textures
+    void RefreshDirtyMaterials()
+    {
+        m_commandList->open();
+        m_scene->Refresh(m_commandList, GetRenderFrameIndex());
+        m_commandList->close();
+        GetDevice()->executeCommandList(m_commandList);
+
+        if (m_ntcForwardShadingPass)
+            m_ntcForwardShadingPass->ResetBindingCache();
+        if (m_depthPass)
+            m_depthPass->ResetBindingCache();
     }
 
     void AddDirectionalLight()
@@ -528,10 +902,29 @@ public:
     bool Init()
     {
         if (!m_materialLoader->Init(g_options.enableCoopVec, g_options.enableGpuDeflate, g_options.debug,
-            m_commonPasses->m_BlackTexture))
+            m_commonPasses->m_BlackTexture, m_shaderFactory))
+            return false;
+        m_materialLoader->SetNumDecodedMips(g_options.decodedMips);
+        m_materialLoader->SetTranscodeOnDemand(g_options.transcodeOnDemand);
+        m_materialLoader->SetProgressiveLatents(g_options.progressiveLatents);
+        if (g_options.texelCache)
+            m_materialLoader->SetTexelCacheSize(g_options.texelCacheEntries);
+        m_materialLoader->SetMipTailMemoryRatio(g_options.mipTailMemoryRatio);
+        if (g_options.benchmarkWeightTypes)
+        {
+            m_materialLoader->EnableWeightTypeBenchmark(g_options.weightTypeCache
+                ? std::filesystem::path(g_options.weightTypeCache)
+                : GetDefaultWeightTypeCachePath());
+        }
+        if (g_options.materialPackage && !m_materialLoader->OpenMaterialPackage(g_options.materialPackage))
             return false;
+        if (g_options.transcodeOnDemand)
+            m_ntcMode = NtcMode::Hybrid;
 
-        if (!ImGui_Renderer::Init(m_shaderFactory))
+        if (!g_options.headless && !ImGui_Renderer::Init(m_shaderFactory))
+            return false;
+
+        if (g_options.cameraPath && !m_cameraPath.Load(g_options.cameraPath))
             return false;
 
         auto nativeFS = std::make_shared<vfs::NativeFileSystem>();
@@ -544,6 +937,27 @@ public:
         m_commandList = GetDevice()->createCommandList(nvrhi::CommandListParameters()
             .setEnableImmediateExecution(false)); // Disable immediate execution in case we abandon command lists
 
+        // Async feedback processing needs both the copy queue (tile mappings) and the compute queue (transcoding)
+        m_asyncFeedbackSupported = g_options.inferenceOnFeedback &&
+            GetDevice()->queryFeatureSupport(nvrhi::Feature::CopyQueue) &&
+            GetDevice()->queryFeatureSupport(nvrhi::Feature::ComputeQueue);
+
+        if (m_asyncFeedbackSupported)
+        {
+            m_copyCommandList = GetDevice()->createCommandList(nvrhi::CommandListParameters()
+                .setEnableImmediateExecution(false)
+                .setQueueType(nvrhi::CommandQueue::Copy));
+            m_computeCommandList = GetDevice()->createCommandList(nvrhi::CommandListParameters()
+                .setEnableImmediateExecution(false)
+                .setQueueType(nvrhi::CommandQueue::Compute));
+        }
+        else if (g_options.asyncFeedback && g_options.inferenceOnFeedback)
+        {
+            log::warning("Async feedback processing requires copy and compute queues, which are not available. "
+                "Falling back to processing on the graphics queue.");
+        }
+        m_asyncFeedback = m_asyncFeedbackSupported && g_options.asyncFeedback;
+
         if (!LoadScene(nativeFS, g_options.scenePath))
             return false;
 
@@ -563,6 +977,13 @@ public:
 
         m_ntcMode = g_options.inferenceOnSample ? NtcMode::InferenceOnSample : NtcMode::InferenceOnLoad;
 
+        if (g_options.benchmarkMode && !SelectBenchmarkMode(g_options.benchmarkMode))
+            return false;
+
+        if (g_options.benchmarkFrames > 0 && !m_profiler.BeginCapture(g_options.profileOutput
+            ? fs::path(g_options.profileOutput) : fs::path()))
+            return false;
+
         void const* pFontData;
         size_t fontSize;
         GetNvidiaSansFont(&pFontData, &fontSize);
@@ -572,12 +993,14 @@ public:
         return true;
     }
     
-    void CreateRenderTargets(int width, int height)
+    // The resolved color and the TAA history targets have the display size, which is larger than the render size
+    // when DLSS upscales the image. The other targets have the render size.
+    void CreateRenderTargets(dm::uint2 renderSize, dm::uint2 displaySize)
     {
         auto textureDesc = nvrhi::TextureDesc()
             .setDimension(nvrhi::TextureDimension::Texture2D)
-            .setWidth(width)
-            .setHeight(height)
+            .setWidth(renderSize.x)
+            .setHeight(renderSize.y)
             .setClearValue(nvrhi::Color(0.f))
             .setIsRenderTarget(true)
             .setKeepInitialState(true);
@@ -587,10 +1010,17 @@ public:
             .setFormat(nvrhi::Format::D32)
             .setInitialState(nvrhi::ResourceStates::DepthWrite));
 
+        // The deferred resolve pass writes the color target in a compute shader
         m_renderTargets.color = GetDevice()->createTexture(textureDesc
             .setDebugName("Color")
             .setFormat(nvrhi::Format::RGBA16_FLOAT)
+            .setIsUAV(g_options.inferenceOnSample)
             .setInitialState(nvrhi::ResourceStates::RenderTarget));
+        textureDesc.setIsUAV(false);
+
+        textureDesc
+            .setWidth(displaySize.x)
+            .setHeight(displaySize.y);
 
         m_renderTargets.resolvedColor = GetDevice()->createTexture(textureDesc
             .setDebugName("ResolvedColor")
@@ -611,6 +1041,10 @@ public:
         m_renderTargets.feedback2 = GetDevice()->createTexture(textureDesc
             .setDebugName("Feedback2"));
 
+        textureDesc
+            .setWidth(renderSize.x)
+            .setHeight(renderSize.y);
+
         m_renderTargets.motionVectors = GetDevice()->createTexture(textureDesc
             .setDebugName("MotionVectors")
             .setFormat(nvrhi::Format::RG16_FLOAT)
@@ -625,6 +1059,41 @@ public:
         m_renderTargets.framebufferFactory = std::make_shared<engine::FramebufferFactory>(GetDevice());
         m_renderTargets.framebufferFactory->RenderTargets.push_back(m_renderTargets.color);
         m_renderTargets.framebufferFactory->DepthTarget = m_renderTargets.depth;
+
+        if (g_options.inferenceOnSample)
+        {
+            textureDesc
+                .setIsRenderTarget(true)
+                .setUseClearValue(true)
+                .setClearValue(nvrhi::Color(0.f))
+                .setInitialState(nvrhi::ResourceStates::RenderTarget);
+
+            m_renderTargets.materialIds = GetDevice()->createTexture(textureDesc
+                .setDebugName("DeferredMaterialIds")
+                .setFormat(nvrhi::Format::R32_UINT));
+
+            m_renderTargets.deferredTexCoords = GetDevice()->createTexture(textureDesc
+                .setDebugName("DeferredTexCoords")
+                .setFormat(nvrhi::Format::RG32_FLOAT));
+
+            m_renderTargets.deferredTexCoordGradients = GetDevice()->createTexture(textureDesc
+                .setDebugName("DeferredTexCoordGradients")
+                .setFormat(nvrhi::Format::RGBA16_FLOAT));
+
+            m_renderTargets.deferredNormalsAndTangents = GetDevice()->createTexture(textureDesc
+                .setDebugName("DeferredNormalsAndTangents")
+                .setFormat(nvrhi::Format::RGBA16_FLOAT));
+
+            // The order of the attribute targets must match the outputs of NtcDeferredAttributes.hlsl
+            m_renderTargets.deferredFramebufferFactory = std::make_shared<engine::FramebufferFactory>(GetDevice());
+            m_renderTargets.deferredFramebufferFactory->RenderTargets = {
+                m_renderTargets.color,
+                m_renderTargets.materialIds,
+                m_renderTargets.deferredTexCoords,
+                m_renderTargets.deferredTexCoordGradients,
+                m_renderTargets.deferredNormalsAndTangents };
+            m_renderTargets.deferredFramebufferFactory->DepthTarget = m_renderTargets.depth;
+        }
     }
         
     void CreateRenderPasses()
@@ -680,9 +1149,80 @@ public:
         return true;
     }
 
+    bool SelectBenchmarkMode(char const* name)
+    {
+        std::string const mode = name;
+        if (mode == "load" && g_options.inferenceOnLoad && !g_options.transcodeOnDemand)
+            m_ntcMode = NtcMode::InferenceOnLoad;
+        else if (mode == "sample" && g_options.inferenceOnSample)
+            m_ntcMode = NtcMode::InferenceOnSample;
+        else if (mode == "feedback" && g_options.inferenceOnFeedback)
+        {
+            m_ntcMode = NtcMode::InferenceOnFeedback;
+            m_feedbackCameraCutFrames = g_feedbackCameraCutFramesInit;
+            m_tileScheduler.Clear();
+        }
+        else if (mode == "hybrid" && g_options.inferenceOnLoad && g_options.inferenceOnSample)
+            m_ntcMode = NtcMode::Hybrid;
+        else
+        {
+            log::error("The benchmark mode '%s' is invalid or not enabled by the other options.", name);
+            return false;
+        }
+        return true;
+    }
+
+    // Moves the camera to the position for the current benchmark frame: along the camera path if one was loaded,
+    // or one full orbit around the scene otherwise.
+    void SetBenchmarkCamera()
+    {
+        float const progress = float(m_benchmarkFrame) / float(g_options.benchmarkFrames);
+
+        if (!m_cameraPath.IsEmpty())
+        {
+            dm::float3 position, target;
+            m_cameraPath.Evaluate(float(m_benchmarkFrame) * c_benchmarkTimeStep, position, target);
+            if (!m_camera.IsFirstPersonActive())
+                m_camera.SwitchToFirstPerson();
+            m_camera.GetFirstPersonCamera().LookAt(position, target);
+        }
+        else
+        {
+            if (!m_camera.IsThirdPersonActive())
+                m_camera.SwitchToThirdPerson();
+            m_camera.GetThirdPersonCamera().SetRotation(dm::radians(-135.f + 360.f * progress), dm::radians(20.f));
+        }
+    }
+
+    void FinishBenchmark()
+    {
+        m_profiler.EndCapture();
+        m_benchmarkDone = true;
+
+        if (!g_options.headless)
+            glfwSetWindowShouldClose(GetDeviceManager()->GetWindow(), 1);
+    }
+
     void Animate(float fElapsedTimeSeconds) override
     {
-        ImGui_Renderer::Animate(fElapsedTimeSeconds);
+        if (m_benchmarkDone)
+            return;
+
+        if (g_options.benchmarkFrames > 0)
+        {
+            // The record for the last frame is complete after that frame has been rendered
+            if (m_benchmarkFrame == g_options.benchmarkFrames)
+            {
+                FinishBenchmark();
+                return;
+            }
+
+            SetBenchmarkCamera();
+            ++m_benchmarkFrame;
+        }
+
+        if (!g_options.headless)
+            ImGui_Renderer::Animate(fElapsedTimeSeconds);
         m_camera.Animate(fElapsedTimeSeconds);
 
         ProfilerRecord& record = m_profiler.AddRecord();
@@ -700,12 +1240,12 @@ public:
         m_renderTargets = RenderTargets();
     }
 
-    void SetupView(nvrhi::FramebufferInfoEx const& fbinfo)
+    void SetupView()
     {
         m_previousView = m_view;
 
         dm::affine3 viewMatrix = m_camera.GetWorldToViewMatrix();
-        float const aspectRatio = float(fbinfo.width) / float(fbinfo.height);
+        float const aspectRatio = float(m_displaySize.x) / float(m_displaySize.y);
         float verticalFov = dm::radians(60.f);
         float zNear = 0.01f;
         m_camera.GetSceneCameraProjectionParams(verticalFov, zNear);
@@ -713,16 +1253,59 @@ public:
         dm::float4x4 const projMatrix = dm::perspProjD3DStyleReverse(verticalFov, aspectRatio, zNear);
 
         m_view.SetMatrices(viewMatrix, projMatrix);
-        m_view.SetViewport(nvrhi::Viewport(fbinfo.width, fbinfo.height));
+        m_view.SetViewport(nvrhi::Viewport(float(m_renderSize.x), float(m_renderSize.y)));
         m_view.UpdateCache();
 
         if (m_camera.IsThirdPersonActive())
             m_camera.GetThirdPersonCamera().SetView(m_view);
 
-        if (GetDeviceManager()->GetFrameIndex() == 0)
+        if (GetRenderFrameIndex() == 0)
             m_previousView = m_view;
     }
 
+    // Returns the resolution at which the scene is rendered for the given display size
+    dm::uint2 GetRenderSize(dm::uint2 displaySize) const
+    {
+#if DONUT_WITH_DLSS
+        if (m_aaMode == AntiAliasingMode::DLSS)
+        {
+            return dm::uint2(
+                uint32_t(std::max(1.f, std::round(float(displaySize.x) * m_dlssRenderScale))),
+                uint32_t(std::max(1.f, std::round(float(displaySize.y) * m_dlssRenderScale))));
+        }
+#endif
+        return displaySize;
+    }
+
+    // Texture LOD bias that makes the materials sampled at the render resolution select the mips
+    // that match the display resolution after upscaling. Zero when rendering at the display resolution.
+    float GetTextureMipBias() const
+    {
+        if (m_renderSize.x == 0 || m_displaySize.x == 0)
+            return 0.f;
+        return std::min(0.f, std::log2(float(m_renderSize.x) / float(m_displaySize.x)));
+    }
+
+    // Fraction of the quads that write sampler feedback. Fewer pixels are rendered when upscaling, and the biased
+    // mips have smaller regions on screen, so the rate is raised by the display to render pixel count ratio
+    // to keep the number of feedback samples per region the same as at the display resolution.
+    float GetFeedbackThreshold() const
+    {
+        if (!m_enableStochasticFeedback)
+            return 1.f;
+        float const renderPixels = float(m_renderSize.x) * float(m_renderSize.y);
+        float const displayPixels = float(m_displaySize.x) * float(m_displaySize.y);
+        if (renderPixels <= 0.f)
+            return m_feedbackThreshold;
+        return std::min(1.f, m_feedbackThreshold * std::max(1.f, displayPixels / renderPixels));
+    }
+
+    bool IsDeferredInferenceActive() const
+    {
+        return m_deferredInference && m_useDepthPrepass && m_renderTargets.deferredFramebufferFactory &&
+            (m_ntcMode == NtcMode::InferenceOnSample || m_ntcMode == NtcMode::Hybrid);
+    }
+
     void RenderScene(nvrhi::ICommandList* commandList)
     {
         render::SkyParameters skyParameters{};
@@ -744,18 +1327,73 @@ public:
             m_prePassTimer.endQuery(m_commandList);
         }
 
+        // Compile the pipelines for newly loaded materials in the background, for all modes that can be selected
+        if (!m_materialsToPrecompile.empty())
+        {
+            std::vector<NtcMode> modes;
+            if (g_options.inferenceOnSample)
+                modes.push_back(NtcMode::InferenceOnSample);
+            if (g_options.inferenceOnLoad)
+                modes.push_back(NtcMode::InferenceOnLoad);
+            if (g_options.inferenceOnFeedback)
+                modes.push_back(NtcMode::InferenceOnFeedback);
+
+            nvrhi::IFramebuffer* framebuffer = m_renderTargets.framebufferFactory->GetFramebuffer(m_view);
+
+            // The deferred inference can be enabled at runtime, so compile its pipelines whenever it is available
+            nvrhi::FramebufferInfo deferredFramebufferInfo;
+            bool const haveDeferredFramebuffer = !!m_renderTargets.deferredFramebufferFactory;
+            if (haveDeferredFramebuffer)
+            {
+                deferredFramebufferInfo = m_renderTargets.deferredFramebufferFactory->GetFramebuffer(m_view)
+                    ->getFramebufferInfo();
+            }
+
+            m_ntcForwardShadingPass->PrecompilePipelines(m_materialsToPrecompile, modes,
+                framebuffer->getFramebufferInfo(), haveDeferredFramebuffer ? &deferredFramebufferInfo : nullptr,
+                m_view.IsReverseDepth(), m_view.IsMirrored());
+            m_materialsToPrecompile.clear();
+        }
+
+        bool const deferredInference = IsDeferredInferenceActive();
+
         NtcForwardShadingPass::Context forwardContext;
         m_ntcForwardShadingPass->PrepareLights(commandList, { m_light },
             skyParameters.skyColor * skyParameters.brightness,
             skyParameters.groundColor * skyParameters.brightness);
-        m_ntcForwardShadingPass->PreparePass(forwardContext, commandList, GetFrameIndex(),
-            m_useSTF, m_stfFilterMode, m_useDepthPrepass, m_ntcMode, m_enableStochasticFeedback ? m_feedbackThreshold : 1.0f);
+        m_ntcForwardShadingPass->PreparePass(forwardContext, commandList, GetRenderFrameIndex(),
+            m_useSTF, m_stfFilterMode, m_useDepthPrepass, m_ntcMode, GetFeedbackThreshold(), GetTextureMipBias(),
+            deferredInference, m_useTexelCache, uint32_t(m_texelCacheMaxAge));
 
         m_renderPassTimer.beginQuery(m_commandList);
 
-        render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.framebufferFactory,
-            m_scene->GetSceneGraph()->GetRootNode(), opaqueDrawStrategy, *m_ntcForwardShadingPass,
-            forwardContext, "Opaque");
+        if (deferredInference)
+        {
+            // Zero material ID marks the pixels that are shaded by the forward pass or not covered at all
+            commandList->clearTextureUInt(m_renderTargets.materialIds, nvrhi::AllSubresources, 0);
+
+            render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.deferredFramebufferFactory,
+                m_scene->GetSceneGraph()->GetRootNode(), opaqueDrawStrategy, *m_ntcForwardShadingPass,
+                forwardContext, "Opaque");
+
+            NtcDeferredTargets deferredTargets;
+            deferredTargets.depth = m_renderTargets.depth;
+            deferredTargets.color = m_renderTargets.color;
+            deferredTargets.materialId = m_renderTargets.materialIds;
+            deferredTargets.texCoord = m_renderTargets.deferredTexCoords;
+            deferredTargets.texCoordGradients = m_renderTargets.deferredTexCoordGradients;
+            deferredTargets.normalTangent = m_renderTargets.deferredNormalsAndTangents;
+
+            commandList->beginMarker("Deferred Resolve");
+            m_ntcForwardShadingPass->ResolveDeferredMaterials(forwardContext, commandList, deferredTargets);
+            commandList->endMarker();
+        }
+        else
+        {
+            render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.framebufferFactory,
+                m_scene->GetSceneGraph()->GetRootNode(), opaqueDrawStrategy, *m_ntcForwardShadingPass,
+                forwardContext, "Opaque");
+        }
 
         render::RenderCompositeView(commandList, &m_view, &m_view, *m_renderTargets.framebufferFactory,
             m_scene->GetSceneGraph()->GetRootNode(), transparentDrawStrategy, *m_ntcForwardShadingPass,
@@ -782,8 +1420,47 @@ public:
         return true;
     }
 
+    // Exposes the tiles from async transcoding batches that were submitted at least latencyFrames ago to rendering.
+    // The graphics queue waits for the corresponding compute submissions before the MinMip textures are updated.
+    void CommitPendingTileTranscodes(uint32_t latencyFrames)
+    {
+        if (m_pendingTileTranscodes.empty())
+            return;
+
+        bool commandListOpen = false;
+        while (!m_pendingTileTranscodes.empty())
+        {
+            PendingTileTranscode& pending = m_pendingTileTranscodes.front();
+            if (m_feedbackFrameCounter - pending.submitFrame < latencyFrames)
+                break;
+
+            if (!commandListOpen)
+            {
+                m_commandList->open();
+                commandListOpen = true;
+            }
+
+            GetDevice()->queueWaitForCommandList(nvrhi::CommandQueue::Graphics, nvrhi::CommandQueue::Compute,
+                pending.computeInstance);
+            m_feedbackManager->CommitTileMappings(m_commandList, &pending.tiles);
+            m_pendingTileTranscodes.pop_front();
+        }
+
+        if (commandListOpen)
+        {
+            m_commandList->close();
+            GetDevice()->executeCommandList(m_commandList);
+        }
+    }
+
     void ProcessInferenceOnFeedback()
     {
+        ++m_feedbackFrameCounter;
+
+        // Expose the async batches that have had enough time to complete.
+        // When async processing has been turned off, flush all of them.
+        CommitPendingTileTranscodes(m_asyncFeedback ? g_asyncTranscodeLatencyFrames : 0);
+
         nvfeedback::FeedbackTextureCollection tilesThisFrame;
         std::unordered_map<NtcMaterial*, std::vector<nvfeedback::FeedbackTextureTileInfo>> materialsAndTiles;
 
@@ -791,6 +1468,8 @@ public:
             
         {
             // Phase 1: Begin frame, readback feedback
+
+            auto const beginFrameStart = std::chrono::steady_clock::now();
             
             m_commandList->open();
 
@@ -803,23 +1482,37 @@ public:
                 profilerRecord->tilesTotal = statsLastFrame.tilesTotal;
                 profilerRecord->tilesAllocated = statsLastFrame.tilesAllocated;
                 profilerRecord->tilesStandby = statsLastFrame.tilesStandby;
+                profilerRecord->heapsAllocated = statsLastFrame.heapsAllocated;
+                profilerRecord->tileLatencyP50Ms = statsLastFrame.tileLatencyP50Ms;
+                profilerRecord->tileLatencyP95Ms = statsLastFrame.tileLatencyP95Ms;
+                profilerRecord->tileLatencyP99Ms = statsLastFrame.tileLatencyP99Ms;
+                profilerRecord->tileLatencyP50Frames = statsLastFrame.tileLatencyP50Frames;
+                profilerRecord->tileLatencyP95Frames = statsLastFrame.tileLatencyP95Frames;
+                profilerRecord->tileLatencyP99Frames = statsLastFrame.tileLatencyP99Frames;
+                profilerRecord->transcodeQueueDepth = uint32_t(m_pendingTileTranscodes.size());
             }
 
-            // Map and transcode only numTilesMax tiles per frame to reduce frametime spikes
-            uint32_t numTilesMax = MAX_TILES_PER_FRAME;
+            if (statsLastFrame.tileLatencySamples != 0)
+                m_profiler.SetTileLatencyHistogram(statsLastFrame.tileLatencyHistogram, nvfeedback::c_tileLatencyHistogramBins);
+
+            bool cameraCut = false;
 
             nvfeedback::FeedbackUpdateConfig fconfig = {};
-            fconfig.frameIndex = GetDeviceManager()->GetCurrentBackBufferIndex();
+            fconfig.frameIndex = g_options.headless
+                ? m_headlessFrameIndex % c_headlessFramesInFlight
+                : GetDeviceManager()->GetCurrentBackBufferIndex();
             fconfig.maxTexturesToUpdate = 10;
             fconfig.tileTimeoutSeconds = 1.0f;
-            fconfig.defragmentHeaps = false;
+            fconfig.defragmentHeaps = g_options.feedbackDefragment;
+            fconfig.defragmentThreshold = 0.25f;
             fconfig.releaseEmptyHeaps = false;
             fconfig.numExtraStandbyTiles = standByTileCount;
+            fconfig.memoryBudgetInBytes = GetFeedbackMemoryBudget(statsLastFrame);
             if (m_feedbackCameraCutFrames > 0)
             {
                 // For a "camera cut" (or first frame or toggling feedback mode) we update and transcode more for a few frames
                 fconfig.maxTexturesToUpdate = 0;
-                numTilesMax = 256;
+                cameraCut = true;
                 m_feedbackCameraCutFrames--;
             }
             nvfeedback::FeedbackTextureCollection updatedTextures = {};
@@ -828,7 +1521,11 @@ public:
             // Requested packed tiles this frame, will always be mapped
             std::vector<RequestedTile> requestedPackedTiles;
 
-            // Collect all tiles and store them in the queue
+            double const timestamp = std::chrono::duration<double>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+
+            // Collect all tiles and pass them to the scheduler
+            std::vector<nvfeedback::FeedbackTextureTileInfo> tileInfos;
             for (nvfeedback::FeedbackTextureUpdate& texUpdate : updatedTextures.textures)
             {
                 RequestedTile reqTile;
@@ -837,74 +1534,91 @@ public:
                 {
                     reqTile.tileIndex = texUpdate.tileIndices[i];
                     if (texUpdate.texture->IsTilePacked(reqTile.tileIndex))
+                    {
                         requestedPackedTiles.push_back(reqTile);
+                    }
                     else
-                        m_requestedTiles.push(reqTile);
+                    {
+                        texUpdate.texture->GetTileInfo(reqTile.tileIndex, tileInfos);
+                        uint32_t const mipLevel = tileInfos.empty() ? 0 : tileInfos[0].mip;
+                        m_tileScheduler.AddRequest(reqTile.texture, reqTile.tileIndex, mipLevel, timestamp);
+                    }
                 }
             }
 
+            // Select the tiles to map and transcode this frame within the GPU time budget
+            std::vector<RequestedTile> scheduledTiles;
+            // Only feed the timer results resolved since the last frame, repeating an old result would
+            // weigh it multiple times in the smoothed per-tile cost
+            m_tileScheduler.UpdateBudget(m_transcodingTimer.getNewTime());
+            m_tileScheduler.SelectTiles(timestamp, cameraCut, m_feedbackManager.get(), scheduledTiles);
+
             m_commandList->close();
             GetDevice()->executeCommandList(m_commandList);
 
+            auto const schedulingStart = std::chrono::steady_clock::now();
+
+            if (profilerRecord)
+            {
+                uint32_t tilesRequested = 0;
+                for (nvfeedback::FeedbackTextureUpdate const& texUpdate : updatedTextures.textures)
+                    tilesRequested += uint32_t(texUpdate.tileIndices.size());
+
+                profilerRecord->tilesPending = uint32_t(m_tileScheduler.GetNumPendingRequests());
+                profilerRecord->tileBudget = m_tileScheduler.GetTileBudget();
+                profilerRecord->tilesRequested = tilesRequested;
+                profilerRecord->tilesMapped = uint32_t(scheduledTiles.size() + requestedPackedTiles.size());
+                profilerRecord->feedbackBeginFrameCpuTime = std::chrono::duration<double>(
+                    schedulingStart - beginFrameStart).count();
+            }
+
             // Check the queue and figure out how many tiles we will mapped this frame
-            if (!requestedPackedTiles.empty() || !m_requestedTiles.empty())
+            if (!requestedPackedTiles.empty() || !scheduledTiles.empty())
             {
+                // Index of each texture's entry in tilesThisFrame.textures
+                std::unordered_map<nvfeedback::FeedbackTexture*, size_t> textureUpdateIndices;
+
                 // This schedules a tile to be mapped this frame
                 auto scheduleTileToMap = [&](const RequestedTile& reqTile)
                     {
-                        // Find if we already have this texture in tilesThisFrame
-                        nvfeedback::FeedbackTextureUpdate* pTexUpdate = nullptr;
-                        for (uint32_t t = 0; t < tilesThisFrame.textures.size(); t++)
-                        {
-                            if (tilesThisFrame.textures[t].texture == reqTile.texture)
-                            {
-                                pTexUpdate = &tilesThisFrame.textures[t];
-                                break;
-                            }
-                        }
+                        auto [it, firstTime] = textureUpdateIndices.try_emplace(reqTile.texture,
+                            tilesThisFrame.textures.size());
 
-                        if (pTexUpdate == nullptr)
+                        if (firstTime)
                         {
                             // First time we see this texture this frame
-                            nvfeedback::FeedbackTextureUpdate texUpdate;
+                            nvfeedback::FeedbackTextureUpdate& texUpdate = tilesThisFrame.textures.emplace_back();
                             texUpdate.texture = reqTile.texture;
-                            tilesThisFrame.textures.push_back(texUpdate);
-                            pTexUpdate = &tilesThisFrame.textures.back();
                         }
 
-                        pTexUpdate->tileIndices.push_back(reqTile.tileIndex);
+                        tilesThisFrame.textures[it->second].tileIndices.push_back(reqTile.tileIndex);
                     };
 
-                uint32_t countThisFrame = std::min((uint32_t)m_requestedTiles.size(), numTilesMax);
-                for (uint32_t i = 0; i < countThisFrame; i++)
-                {
-                    scheduleTileToMap(m_requestedTiles.front());
-                    m_requestedTiles.pop();
-                }
+                for (auto& scheduledTile : scheduledTiles)
+                    scheduleTileToMap(scheduledTile);
 
                 // Map and transcode all packed tiles this frame
                 for (auto& packedTile : requestedPackedTiles)
                     scheduleTileToMap(packedTile);
 
-                // Collect a set of NtcMaterials and tiles as we will transcode all textures in a material simultaneously
+                // Collect a set of NtcMaterials and tiles as we will transcode all textures in a material simultaneously.
+                // Different textures of one material usually request the same tiles, so de-duplicate them.
                 std::vector<nvfeedback::FeedbackTextureTileInfo> tiles;
+                std::unordered_map<NtcMaterial*, std::unordered_set<nvfeedback::FeedbackTextureTileInfo,
+                    nvfeedback::FeedbackTextureTileInfoHash>> uniqueTilesPerMaterial;
                 for (auto& textureUpdate : tilesThisFrame.textures)
                 {
                     NtcMaterial* material = m_materialsByFeedback[textureUpdate.texture];
                     assert(material);
 
-                    if (materialsAndTiles.find(material) == materialsAndTiles.end())
-                    {
-                        materialsAndTiles[material] = std::vector<nvfeedback::FeedbackTextureTileInfo>();
-                    }
-
                     auto& tileset = materialsAndTiles[material];
+                    auto& uniqueTiles = uniqueTilesPerMaterial[material];
                     for (auto& tileIndex : textureUpdate.tileIndices)
                     {
                         textureUpdate.texture->GetTileInfo(tileIndex, tiles);
                         for (auto& tile : tiles)
                         {
-                            if (std::find(tileset.begin(), tileset.end(), tile) == tileset.end())
+                            if (uniqueTiles.insert(tile).second)
                             {
                                 tileset.push_back(tile);
 
@@ -916,82 +1630,174 @@ public:
                     }
                 }
             }
+
+            if (profilerRecord)
+            {
+                profilerRecord->tileSchedulingCpuTime = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - schedulingStart).count();
+            }
+        }
+
+        if (m_asyncFeedback)
+        {
+            if (!tilesThisFrame.textures.empty())
+                SubmitAsyncTileTranscodes(tilesThisFrame, materialsAndTiles, profilerRecord);
+            return;
         }
 
         {
             // Phase 2: Update tile mappings
 
+            auto const mappingStart = std::chrono::steady_clock::now();
+
             m_commandList->open();
             m_feedbackManager->UpdateTileMappings(m_commandList, &tilesThisFrame);
             m_commandList->close();
             GetDevice()->executeCommandList(m_commandList);
+
+            if (profilerRecord)
+            {
+                profilerRecord->tileMappingCpuTime = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - mappingStart).count();
+            }
         }
 
         {
             // Phase 3: Decode NTC texture tiles
 
+            auto const transcodingStart = std::chrono::steady_clock::now();
+
             m_commandList->open();
             m_transcodingTimer.beginQuery(m_commandList);
-            std::vector<TranscodeTileInfo> tiles;
-            for (auto& pair : materialsAndTiles)
-            {
-                NtcMaterial* ntcmaterial = pair.first;
-                std::vector<nvfeedback::FeedbackTextureTileInfo> tileset = pair.second;
-
-                for (auto& tile : tileset)
-                {
-                    tiles.push_back({ ntcmaterial, tile });
-                }
-            }
-
-            for (size_t i = 0; i < tiles.size(); i += TRANSCODE_BATCH_SIZE)
-            {
-                auto batch = std::vector<TranscodeTileInfo>(tiles.begin() + i, tiles.begin() + std::min(i + TRANSCODE_BATCH_SIZE, tiles.size()));
-                m_materialLoader->TranscodeTiles(batch, m_commandList, g_options.blockCompression);
-            }
+            uint32_t const tilesTranscoded = TranscodeFeedbackTiles(materialsAndTiles, m_commandList);
 
             if (profilerRecord)
             {
-                profilerRecord->tilesTranscoded = uint32_t(tiles.size());
+                profilerRecord->tilesTranscoded = tilesTranscoded;
             }
 
             m_transcodingTimer.endQuery(m_commandList);
             m_commandList->close();
             GetDevice()->executeCommandList(m_commandList);
+
+            if (profilerRecord)
+            {
+                profilerRecord->transcodingCpuTime = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - transcodingStart).count();
+            }
         }
     }
 
-    void Render(nvrhi::IFramebuffer* framebuffer) override
+    // Returns the memory budget for feedback tiles, either from the command line or derived from the OS budget.
+    // Returns 0 when the budget is unlimited or cannot be determined.
+    uint64_t GetFeedbackMemoryBudget(nvfeedback::FeedbackManagerStats const& stats)
     {
-        nvrhi::FramebufferInfoEx const& fbinfo = framebuffer->getFramebufferInfo();
+        constexpr uint64_t megabyte = 1ull << 20;
+        if (g_options.feedbackMemoryBudgetMB > 0)
+            return uint64_t(g_options.feedbackMemoryBudgetMB) * megabyte;
+
+        if (g_options.feedbackMemoryBudgetMB < 0)
+            return 0;
+
+        uint64_t osBudget = 0;
+        uint64_t osUsage = 0;
+        if (!m_videoMemoryInfo.Query(osBudget, osUsage))
+            return 0;
+
+        // Let the tiles use the memory they already have plus whatever the process has left in the OS budget,
+        // keeping a margin for other allocations. Allow at least one heap so that streaming can make progress.
+        constexpr uint64_t safetyMargin = 256 * megabyte;
+        constexpr uint64_t minBudget = 8 * megabyte;
+        uint64_t const available = stats.heapAllocationInBytes + osBudget;
+        uint64_t const reserved = osUsage + safetyMargin;
+        return std::max(available > reserved ? available - reserved : 0, minBudget);
+    }
 
-        SetupView(fbinfo);
+    // Records transcoding of all tiles in materialsAndTiles into the command list, in batches of TRANSCODE_BATCH_SIZE.
+    // Returns the number of transcoded tiles.
+    uint32_t TranscodeFeedbackTiles(
+        std::unordered_map<NtcMaterial*, std::vector<nvfeedback::FeedbackTextureTileInfo>> const& materialsAndTiles,
+        nvrhi::ICommandList* commandList)
+    {
+        std::vector<TranscodeTileInfo> tiles;
+        for (auto& pair : materialsAndTiles)
+        {
+            NtcMaterial* ntcmaterial = pair.first;
+            std::vector<nvfeedback::FeedbackTextureTileInfo> const& tileset = pair.second;
 
-        if (!m_renderTargets.color)
+            for (auto& tile : tileset)
+            {
+                tiles.push_back({ ntcmaterial, tile });
+            }
+        }
+
+        for (size_t i = 0; i < tiles.size(); i += TRANSCODE_BATCH_SIZE)
         {
-            CreateRenderTargets(fbinfo.width, fbinfo.height);
-            CreateRenderPasses();
-            m_previousFrameValid = false;
+            auto batch = std::vector<TranscodeTileInfo>(tiles.begin() + i, tiles.begin() + std::min(i + TRANSCODE_BATCH_SIZE, tiles.size()));
+            m_materialLoader->TranscodeTiles(batch, commandList, g_options.blockCompression,
+                g_options.directTileDecode);
         }
 
-        // This sequence depends on CreateRenderPasses above, which in turn depends on SetupView...
-        m_taaPass->AdvanceFrame();
-        m_view.SetPixelOffset(m_aaMode == AntiAliasingMode::Off
-            ? dm::float2::zero()
-            : m_taaPass->GetCurrentPixelOffset());
-        m_view.UpdateCache();
+        return uint32_t(tiles.size());
+    }
+
+    // Async version of phases 2 and 3 of ProcessInferenceOnFeedback:
+    // tiles are mapped on the copy queue, transcoded on the compute queue, and committed to rendering
+    // g_asyncTranscodeLatencyFrames later by CommitPendingTileTranscodes.
+    void SubmitAsyncTileTranscodes(nvfeedback::FeedbackTextureCollection& tilesThisFrame,
+        std::unordered_map<NtcMaterial*, std::vector<nvfeedback::FeedbackTextureTileInfo>> const& materialsAndTiles,
+        ProfilerRecord* profilerRecord)
+    {
+        // Phase 2: Map the tiles on the copy queue.
+        // Tile mappings are queue operations, not commands, so submit an empty command list after them
+        // to obtain a fence value that the compute queue can wait on.
+        auto const mappingStart = std::chrono::steady_clock::now();
+        m_feedbackManager->MapTiles(&tilesThisFrame, nvrhi::CommandQueue::Copy);
+        m_copyCommandList->open();
+        m_copyCommandList->close();
+        uint64_t const copyInstance = GetDevice()->executeCommandList(m_copyCommandList, nvrhi::CommandQueue::Copy);
+
+        // Phase 3: Decode NTC texture tiles on the compute queue
+        auto const transcodingStart = std::chrono::steady_clock::now();
+        m_computeCommandList->open();
+        m_transcodingTimer.beginQuery(m_computeCommandList);
+        uint32_t const tilesTranscoded = TranscodeFeedbackTiles(materialsAndTiles, m_computeCommandList);
+        m_transcodingTimer.endQuery(m_computeCommandList);
+        m_computeCommandList->close();
+
+        GetDevice()->queueWaitForCommandList(nvrhi::CommandQueue::Compute, nvrhi::CommandQueue::Copy, copyInstance);
+        
+        PendingTileTranscode& pending = m_pendingTileTranscodes.emplace_back();
+        pending.computeInstance = GetDevice()->executeCommandList(m_computeCommandList, nvrhi::CommandQueue::Compute);
+        pending.submitFrame = m_feedbackFrameCounter;
+        pending.tiles = std::move(tilesThisFrame);
 
-        // Initialize or resize the DLSS feature
+        if (profilerRecord)
+        {
+            profilerRecord->tilesTranscoded = tilesTranscoded;
+            profilerRecord->tileMappingCpuTime = std::chrono::duration<double>(transcodingStart - mappingStart).count();
+            profilerRecord->transcodingCpuTime = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - transcodingStart).count();
+        }
+    }
+
+    void Render(nvrhi::IFramebuffer* framebuffer) override
+    {
+        nvrhi::FramebufferInfoEx const& fbinfo = framebuffer->getFramebufferInfo();
+        dm::uint2 const displaySize = dm::uint2(fbinfo.width, fbinfo.height);
+
+        // Initialize or resize the DLSS feature before the render size is derived from the AA mode
 #if DONUT_WITH_DLSS
         if (m_aaMode == AntiAliasingMode::DLSS)
         {
             if (m_DLSS)
             {
+                dm::uint2 const dlssRenderSize = GetRenderSize(displaySize);
                 donut::render::DLSS::InitParameters dlssParams;
-                dlssParams.inputWidth = fbinfo.width;
-                dlssParams.inputHeight = fbinfo.height;
-                dlssParams.outputWidth = fbinfo.width;
-                dlssParams.outputHeight = fbinfo.height;
+                dlssParams.inputWidth = dlssRenderSize.x;
+                dlssParams.inputHeight = dlssRenderSize.y;
+                dlssParams.outputWidth = displaySize.x;
+                dlssParams.outputHeight = displaySize.y;
                 m_DLSS->Init(dlssParams);
                 
                 if (!m_DLSS->IsDlssInitialized())
@@ -1002,12 +1808,53 @@ public:
         }
 #endif
 
+        // Switching to or from DLSS or changing its scale changes the render size
+        dm::uint2 const renderSize = GetRenderSize(displaySize);
+        if (m_renderTargets.color && any(renderSize != m_renderSize))
+        {
+            m_bindingCache->Clear();
+            m_renderTargets = RenderTargets();
+        }
+        m_renderSize = renderSize;
+        m_displaySize = displaySize;
+
+        SetupView();
+
+        if (!m_renderTargets.color)
+        {
+            CreateRenderTargets(m_renderSize, m_displaySize);
+            CreateRenderPasses();
+            m_previousFrameValid = false;
+        }
+
+        // This sequence depends on CreateRenderPasses above, which in turn depends on SetupView...
+        m_taaPass->AdvanceFrame();
+        m_view.SetPixelOffset(m_aaMode == AntiAliasingMode::Off
+            ? dm::float2::zero()
+            : m_taaPass->GetCurrentPixelOffset());
+        m_view.UpdateCache();
+
+        UpdateMaterialLoading();
+        UpdateProgressiveLatents();
+
         // Inference on Feedback mode
         if (m_ntcMode == NtcMode::InferenceOnFeedback)
         {
             ProcessInferenceOnFeedback();
         }
 
+        // Hybrid mode: select the materials that use transcoded textures for this frame
+        if (m_ntcMode == NtcMode::Hybrid && g_options.transcodeOnDemand)
+        {
+            UpdateMaterialStreaming();
+        }
+        else if (m_ntcMode == NtcMode::Hybrid)
+        {
+            m_materialModePolicy.UpdateFrameTime(m_renderPassTimer.getNewTime());
+            m_materialModePolicy.UpdateCoverage(*m_scene->GetSceneGraph(), m_view);
+            m_materialModePolicy.SelectModes();
+        }
+
         // Scene rendering
         
         m_commandList->open();
@@ -1069,7 +1916,8 @@ public:
         if (!m_screenshotFileName.empty() && !m_screenshotWithUI)
             SaveScreenshot();
 
-        ImGui_Renderer::Render(framebuffer);
+        if (!g_options.headless)
+            ImGui_Renderer::Render(framebuffer);
 
         if (!m_screenshotFileName.empty() && m_screenshotWithUI)
             SaveScreenshot();
@@ -1116,11 +1964,26 @@ public:
                     textureType = "NTC Inference on Feedback";
                     textureMemorySize = size_t(m_feedbackManager->GetStats().heapAllocationInBytes) + m_ntcTextureMemorySize;
                     break;
+                case NtcMode::Hybrid:
+                    if (g_options.transcodeOnDemand)
+                    {
+                        textureType = "NTC Streaming (Sample + Load on Demand)";
+                        textureMemorySize = m_ntcTextureMemorySize + m_transcodedTextureMemorySize +
+                            m_materialStreamer.GetStreamedMemorySize();
+                    }
+                    else
+                    {
+                        textureType = "NTC Hybrid (Sample + Load)";
+                        textureMemorySize = m_ntcTextureMemorySize + m_materialModePolicy.GetTranscodedMemorySize();
+                    }
+                    break;
                 }
             }
 
             ImGui::TextUnformatted(textureType);
             ImGui::Text("Texture Memory: %.2f MB", float(textureMemorySize) / 1048576.f);
+            if (size_t const pendingPipelines = m_ntcForwardShadingPass->GetNumPendingPipelines())
+                ImGui::Text("Compiling %d pipelines...", int(pendingPipelines));
             
             auto renderTime = m_renderPassTimer.getAverageTime();
             if (renderTime.has_value())
@@ -1177,6 +2040,7 @@ public:
                         m_camera.SwitchToSceneCamera(camera);
                         // Trigger camera cut
                         m_feedbackCameraCutFrames = g_feedbackCameraCutFramesInit;
+                        m_tileScheduler.Clear();
                     }
                 }
                 ImGui::EndCombo();
@@ -1189,7 +2053,9 @@ public:
             if (!g_options.referenceMaterials)
             {
                 ImGui::TextUnformatted("NTC Mode:");
-                ImGui::BeginDisabled(!g_options.inferenceOnLoad);
+                // With --transcodeOnDemand, only the materials near the camera have transcoded textures
+                bool const loadSupported = g_options.inferenceOnLoad && !g_options.transcodeOnDemand;
+                ImGui::BeginDisabled(!loadSupported);
                 if (ImGui::RadioButton("Load", m_ntcMode == NtcMode::InferenceOnLoad))
                 {
                     m_ntcMode = NtcMode::InferenceOnLoad;
@@ -1207,16 +2073,31 @@ public:
                 if (ImGui::RadioButton("Feedback", m_ntcMode == NtcMode::InferenceOnFeedback))
                 {
                     m_ntcMode = NtcMode::InferenceOnFeedback;
-                    // Trigger camera cut
+                    // Trigger camera cut, the requests queued before leaving the feedback mode are outdated
                     m_feedbackCameraCutFrames = g_feedbackCameraCutFramesInit;
+                    m_tileScheduler.Clear();
+                }
+                ImGui::EndDisabled();
+                ImGui::SameLine();
+                bool const hybridSupported = g_options.inferenceOnLoad && g_options.inferenceOnSample;
+                ImGui::BeginDisabled(!hybridSupported);
+                if (ImGui::RadioButton(g_options.transcodeOnDemand ? "Streaming" : "Hybrid", m_ntcMode == NtcMode::Hybrid))
+                {
+                    if (m_ntcMode != NtcMode::Hybrid)
+                        m_materialModePolicy.Reset();
+                    m_ntcMode = NtcMode::Hybrid;
                 }
                 ImGui::EndDisabled();
 
                 // Ensure we have selected an enabled mode
+                if (m_ntcMode == NtcMode::Hybrid && !hybridSupported)
+                    m_ntcMode = NtcMode::InferenceOnSample;
                 if (m_ntcMode == NtcMode::InferenceOnFeedback && !g_options.inferenceOnFeedback)
                     m_ntcMode = NtcMode::InferenceOnSample;
                 if (m_ntcMode == NtcMode::InferenceOnSample && !g_options.inferenceOnSample)
                     m_ntcMode = NtcMode::InferenceOnLoad;
+                if (m_ntcMode == NtcMode::InferenceOnLoad && !loadSupported)
+                    m_ntcMode = NtcMode::Hybrid;
             }
 
             bool effectiveUseSTF = (m_ntcMode == NtcMode::InferenceOnSample) ? true : m_useSTF;
@@ -1245,6 +2126,26 @@ public:
 
             ImGui::Checkbox("Depth Pre-pass", &m_useDepthPrepass);
 
+            if (g_options.inferenceOnSample)
+            {
+                ImGui::BeginDisabled(!m_useDepthPrepass ||
+                    (m_ntcMode != NtcMode::InferenceOnSample && m_ntcMode != NtcMode::Hybrid));
+                ImGui::Checkbox("Deferred Inference", &m_deferredInference);
+                ImGui::EndDisabled();
+            }
+
+            if (g_options.texelCache)
+            {
+                ImGui::BeginDisabled(m_ntcMode != NtcMode::InferenceOnSample && m_ntcMode != NtcMode::Hybrid);
+                ImGui::Checkbox("Texel Cache", &m_useTexelCache);
+                ImGui::BeginDisabled(!m_useTexelCache);
+                ImGui::PushItemWidth(fontSize * 6.f);
+                ImGui::SliderInt("Cache Max Age", &m_texelCacheMaxAge, 1, 64);
+                ImGui::PopItemWidth();
+                ImGui::EndDisabled();
+                ImGui::EndDisabled();
+            }
+
             ImGui::TextUnformatted("Anti-aliasing:");
             if (ImGui::RadioButton("Off", m_aaMode == AntiAliasingMode::Off))
             {
@@ -1266,6 +2167,13 @@ public:
                 m_previousFrameValid = false;
             }
             ImGui::EndDisabled();
+            if (m_aaMode == AntiAliasingMode::DLSS)
+            {
+                ImGui::PushItemWidth(fontSize * 6.f);
+                ImGui::SliderFloat("DLSS Render Scale", &m_dlssRenderScale, c_minDlssRenderScale, 1.f, "%.2f");
+                ImGui::PopItemWidth();
+                ImGui::Text("Texture Mip Bias: %.2f", GetTextureMipBias());
+            }
 #endif
 
             if (m_ntcMode == NtcMode::InferenceOnFeedback)
@@ -1280,12 +2188,75 @@ public:
                 ImGui::Text("Tiles Allocated: %d (%.0f MB)", stats.tilesAllocated, double(uint64_t(stats.tilesAllocated) * tileSizeInBytes) / megabyte);
                 ImGui::Text("Tiles Standby: %d (%.0f MB)", stats.tilesStandby, double(uint64_t(stats.tilesStandby) * tileSizeInBytes) / megabyte);
                 double tilesHeapAllocatedMb = double(stats.heapAllocationInBytes) / megabyte;
-                ImGui::Text("Heap Allocation: %.0f MB", tilesHeapAllocatedMb);
+                ImGui::Text("Heap Allocation: %.0f MB (%d pooled heaps)", tilesHeapAllocatedMb, stats.heapsPooled);
+                if (g_options.feedbackCompaction)
+                {
+                    ImGui::Text("Feedback Readback: %.1f KB (%d changed regions)", double(stats.feedbackReadbackBytes) / 1024.0,
+                        stats.feedbackRequests);
+                }
+                else
+                {
+                    ImGui::Text("Feedback Readback: %.1f KB", double(stats.feedbackReadbackBytes) / 1024.0);
+                }
+                ImGui::Text("MinMip Texels Updated: %d", stats.minMipTexelsUpdated);
+                if (stats.memoryBudgetInBytes != 0)
+                {
+                    ImGui::Text("Resident: %.0f MB / Budget %.0f MB", double(stats.bytesResident) / megabyte,
+                        double(stats.memoryBudgetInBytes) / megabyte);
+                }
                 double ntcMemoryMb = double(m_ntcTextureMemorySize) / megabyte;
                 ImGui::Text("NTC Memory: %.0f MB", ntcMemoryMb);
                 double plusNtcMemory = tilesHeapAllocatedMb + ntcMemoryMb;
                 ImGui::Text("Net Memory Savings: %.2fx (%.0f MB)", tilesTotalMb / plusNtcMemory, tilesTotalMb - plusNtcMemory);
                 ImGui::Checkbox("Enable Stochastic Feedback", &m_enableStochasticFeedback);
+                TileSchedulerDesc schedulerDesc = m_tileScheduler.GetDesc();
+                ImGui::PushItemWidth(fontSize * 6.f);
+                if (ImGui::SliderFloat("Transcode Budget", &schedulerDesc.transcodeBudgetMs, 0.1f, 10.f, "%.1f ms"))
+                    m_tileScheduler.SetDesc(schedulerDesc);
+                ImGui::PopItemWidth();
+                ImGui::Text("Tiles Pending: %d (budget %d/frame)", int(m_tileScheduler.GetNumPendingRequests()),
+                    m_tileScheduler.GetTileBudget());
+                ImGui::BeginDisabled(!m_asyncFeedbackSupported);
+                ImGui::Checkbox("Async Tile Transcoding", &m_asyncFeedback);
+                ImGui::EndDisabled();
+            }
+
+            if (m_ntcMode == NtcMode::Hybrid && g_options.transcodeOnDemand)
+            {
+                ImGui::Separator();
+                ImGui::TextUnformatted("Streaming stats:");
+                ImGui::Text("Transcoded Materials: %d / %d", int(m_materialStreamer.GetNumResidentMaterials()),
+                    int(m_materialStreamer.GetNumMaterials()));
+                ImGui::Text("Materials Pending: %d", int(m_materialStreamer.GetNumPendingMaterials()));
+                ImGui::Text("Streamed Memory: %.0f MB", double(m_materialStreamer.GetStreamedMemorySize()) / 1048576.0);
+                MaterialStreamerDesc streamerDesc = m_materialStreamer.GetDesc();
+                ImGui::PushItemWidth(fontSize * 6.f);
+                bool streamerChanged = false;
+                streamerChanged |= ImGui::DragFloat("Load Distance", &streamerDesc.loadDistance, 0.1f, 0.f, FLT_MAX, "%.1f");
+                streamerChanged |= ImGui::DragFloat("Evict Distance", &streamerDesc.evictDistance, 0.1f,
+                    streamerDesc.loadDistance, FLT_MAX, "%.1f");
+                streamerChanged |= ImGui::SliderFloat("Transcode Budget", &streamerDesc.transcodeBudgetMpix, 0.f, 64.f, "%.1f Mpix");
+                if (streamerChanged)
+                    m_materialStreamer.SetDesc(streamerDesc);
+                ImGui::PopItemWidth();
+            }
+            else if (m_ntcMode == NtcMode::Hybrid)
+            {
+                ImGui::Separator();
+                ImGui::TextUnformatted("Hybrid stats:");
+                ImGui::Text("Transcoded Materials: %d / %d", int(m_materialModePolicy.GetNumTranscodedMaterials()),
+                    int(m_materialModePolicy.GetNumMaterials()));
+                ImGui::Text("Transcoded Memory: %.0f MB", double(m_materialModePolicy.GetTranscodedMemorySize()) / 1048576.0);
+                ImGui::Text("Pixels Using Inference on Sample: %.0f%%", m_materialModePolicy.GetSamplePixelFraction() * 100.f);
+                MaterialModePolicyDesc policyDesc = m_materialModePolicy.GetDesc();
+                ImGui::PushItemWidth(fontSize * 6.f);
+                bool policyChanged = false;
+                policyChanged |= ImGui::SliderFloat("Memory Budget", &policyDesc.transcodedMemoryBudgetMB, 0.f, 4096.f, "%.0f MB");
+                policyChanged |= ImGui::SliderFloat("Frame Time Budget", &policyDesc.frameTimeBudgetMs, 0.5f, 33.f, "%.1f ms");
+                policyChanged |= ImGui::SliderFloat("Hero Coverage", &policyDesc.heroCoverage, 0.f, 1.f, "%.2f");
+                if (policyChanged)
+                    m_materialModePolicy.SetDesc(policyDesc);
+                ImGui::PopItemWidth();
             }
 
             ImGui::Separator();
@@ -1315,6 +2286,37 @@ public:
     }
 };
 
+#if NTC_WITH_VULKAN
+// Returns true if the adapter that the device will be created on supports the sparse residency features
+// that Inference on Feedback needs. When no adapter is selected, all adapters must support them.
+static bool IsVulkanFeedbackSupported(app::DeviceManager* deviceManager, app::DeviceCreationParameters const& deviceParams)
+{
+    if (!deviceManager->CreateInstance(deviceParams))
+        return false;
+
+    std::vector<app::AdapterInfo> adapters;
+    if (!deviceManager->EnumerateAdapters(adapters) || adapters.empty())
+        return false;
+
+    for (int adapterIndex = 0; adapterIndex < int(adapters.size()); ++adapterIndex)
+    {
+        if (deviceParams.adapterIndex >= 0 && adapterIndex != deviceParams.adapterIndex)
+            continue;
+
+        if (!adapters[adapterIndex].vkPhysicalDevice)
+            return false;
+
+        vk::PhysicalDeviceFeatures const features =
+            vk::PhysicalDevice(adapters[adapterIndex].vkPhysicalDevice).getFeatures();
+        if (!features.sparseBinding || !features.sparseResidencyImage2D || !features.sparseResidencyAliased ||
+            !features.shaderResourceResidency || !features.shaderResourceMinLod)
+            return false;
+    }
+
+    return true;
+}
+#endif
+
 #ifdef WIN32
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 #else
@@ -1349,6 +2351,8 @@ int main(int __argc, const char** __argv)
     deviceParams.enableNvrhiValidationLayer = g_options.debug;
     deviceParams.enablePerMonitorDPI = true;
     deviceParams.supportExplicitDisplayScaling = true;
+    deviceParams.enableComputeQueue = g_options.inferenceOnFeedback;
+    deviceParams.enableCopyQueue = g_options.inferenceOnFeedback;
 
     SetNtcGraphicsDeviceParameters(deviceParams, graphicsApi, false, g_options.enableCoopVec, g_ApplicationName);
 #if DONUT_WITH_DLSS && NTC_WITH_VULKAN
@@ -1357,25 +2361,77 @@ int main(int __argc, const char** __argv)
         render::DLSS::GetRequiredVulkanExtensions(deviceParams.optionalVulkanInstanceExtensions, deviceParams.optionalVulkanDeviceExtensions);
     }
 #endif
+#if NTC_WITH_VULKAN
+    if (graphicsApi == nvrhi::GraphicsAPI::VULKAN && g_options.inferenceOnFeedback &&
+        !IsVulkanFeedbackSupported(deviceManager.get(), deviceParams))
+    {
+        log::warning("The Vulkan adapter doesn't support sparse residency, Inference on Feedback is disabled.");
+        g_options.inferenceOnFeedback = false;
+        deviceParams.enableComputeQueue = false;
+        deviceParams.enableCopyQueue = false;
+    }
+
+    if (graphicsApi == nvrhi::GraphicsAPI::VULKAN && g_options.inferenceOnFeedback)
+    {
+        // Tiled textures on Vulkan need sparse residency, and the feedback shaders need the residency status
+        // returned by the sampling instructions. Their support is checked above.
+        auto baseCallback = deviceParams.deviceCreateInfoCallback;
+        deviceParams.deviceCreateInfoCallback = [baseCallback](VkDeviceCreateInfo& info)
+        {
+            if (baseCallback)
+                baseCallback(info);
+
+            // The features are either in pEnabledFeatures or in a VkPhysicalDeviceFeatures2 structure in the chain
+            VkPhysicalDeviceFeatures* features = const_cast<VkPhysicalDeviceFeatures*>(info.pEnabledFeatures);
+            for (VkBaseOutStructure* pCurrent = reinterpret_cast<VkBaseOutStructure*>(const_cast<void*>(info.pNext));
+                !features && pCurrent; pCurrent = pCurrent->pNext)
+            {
+                if (pCurrent->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2)
+                    features = &reinterpret_cast<VkPhysicalDeviceFeatures2*>(pCurrent)->features;
+            }
+            if (!features)
+                return;
+
+            features->sparseBinding = true;
+            features->sparseResidencyImage2D = true;
+            features->sparseResidencyAliased = true;
+            features->shaderResourceResidency = true;
+            features->shaderResourceMinLod = true;
+        };
+    }
+#endif
 
-    if (!deviceManager->CreateWindowDeviceAndSwapChain(deviceParams, g_ApplicationName))
+    bool const deviceCreated = g_options.headless
+        ? deviceManager->CreateHeadlessDevice(deviceParams)
+        : deviceManager->CreateWindowDeviceAndSwapChain(deviceParams, g_ApplicationName);
+    if (!deviceCreated)
     {
         log::fatal("Cannot initialize a graphics device with the requested parameters");
         return 1;
     }
     
-    char windowTitle[256];
-    snprintf(windowTitle, sizeof windowTitle, "%s (%s, %s)", g_ApplicationName, 
-        nvrhi::utils::GraphicsAPIToString(graphicsApi), deviceManager->GetRendererString());
-    deviceManager->SetWindowTitle(windowTitle);
+    if (!g_options.headless)
+    {
+        char windowTitle[256];
+        snprintf(windowTitle, sizeof windowTitle, "%s (%s, %s)", g_ApplicationName, 
+            nvrhi::utils::GraphicsAPIToString(graphicsApi), deviceManager->GetRendererString());
+        deviceManager->SetWindowTitle(windowTitle);
+    }
 
     {
         NtcSceneRenderer example(deviceManager.get());
         if (example.Init())
         {
-            deviceManager->AddRenderPassToBack(&example);
-            deviceManager->RunMessageLoop();
-            deviceManager->RemoveRenderPass(&example);
+            if (g_options.headless)
+            {
+                example.RunHeadless(deviceParams.backBufferWidth, deviceParams.backBufferHeight);
+            }
+            else
+            {
+                deviceManager->AddRenderPassToBack(&example);
+                deviceManager->RunMessageLoop();
+                deviceManager->RemoveRenderPass(&example);
+            }
         }
     }
 
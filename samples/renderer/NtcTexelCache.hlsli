@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Texel-space cache of the decoded NTC channels for Inference on Sample, see NtcMaterialLoader::SetTexelCacheSize.
+// The cache is a hash table in a raw buffer per material, with NTC_TEXEL_CACHE_ENTRY_SIZE bytes per entry:
+//   uint stamp  - (frame << 1) | writing, where frame is the last frame that used the entry; 0 for empty entries
+//   uint key    - texel position and mip level, see NtcTexelCache::Create
+//   uint data[] - NTC_TEXEL_CACHE_CHANNELS channels packed as FP16 pairs
+//
+// The entries are read and written by many pixels within one frame without barriers. To stay consistent,
+// an entry that is claimed by a writer in the current frame is not read until the next frame, and an entry
+// that is used in the current frame cannot be claimed. Entries that are not used for more than maxAge frames
+// can be replaced by another texel that maps to the same slot. On a collision with a live entry, the texel
+// is decoded without caching.
+
+#ifndef NTC_TEXEL_CACHE_HLSLI
+#define NTC_TEXEL_CACHE_HLSLI
+
+#include "NtcForwardShadingPassConstants.h"
+
+RWByteAddressBuffer u_TexelCache : REGISTER_UAV(FORWARD_BINDING_NTC_TEXEL_CACHE_UAV, FORWARD_SPACE_MATERIAL);
+
+struct NtcTexelCache
+{
+    uint key;
+    uint offset;
+    uint frame;
+    uint maxAge;
+
+    // The texel coordinates must be wrapped into the mip level, which is true for the STF sample positions
+    static NtcTexelCache Create(int2 texel, int mipLevel, uint frameIndex, uint maxAge)
+    {
+        NtcTexelCache cache;
+        cache.key = (uint(mipLevel) << 28) | ((uint(texel.y) & 0x3fff) << 14) | (uint(texel.x) & 0x3fff);
+
+        uint bufferSize;
+        u_TexelCache.GetDimensions(bufferSize);
+        uint const entryCount = max(bufferSize / NTC_TEXEL_CACHE_ENTRY_SIZE, 1u);
+        cache.offset = (NtcTexelCache::Hash(cache.key) % entryCount) * NTC_TEXEL_CACHE_ENTRY_SIZE;
+
+        // Zero stamps mark empty entries, so frame numbers start at 1
+        cache.frame = frameIndex + 1;
+        cache.maxAge = maxAge;
+        return cache;
+    }
+
+    static uint Hash(uint x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352d;
+        x ^= x >> 15;
+        x *= 0x846ca68b;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Returns true and the decoded channels if the texel was stored in a previous frame
+    bool Load(out float channels[NTC_MLP_OUTPUT_CHANNELS])
+    {
+        [unroll]
+        for (int i = 0; i < NTC_MLP_OUTPUT_CHANNELS; ++i)
+            channels[i] = 0;
+
+        if (u_TexelCache.Load(offset + 4) != key)
+            return false;
+
+        // Mark the entry as used in this frame, which also prevents writers from claiming it.
+        // If a writer has claimed it first, its data may be incomplete.
+        uint originalStamp;
+        u_TexelCache.InterlockedMax(offset, frame << 1, originalStamp);
+        if (originalStamp == 0 || originalStamp == ((frame << 1) | 1))
+            return false;
+
+        uint4 const packed0 = u_TexelCache.Load4(offset + 8);
+        uint4 const packed1 = u_TexelCache.Load4(offset + 24);
+        uint const packed[8] = { packed0.x, packed0.y, packed0.z, packed0.w, packed1.x, packed1.y, packed1.z, packed1.w };
+
+        [unroll]
+        for (int i = 0; i < NTC_TEXEL_CACHE_CHANNELS / 2; ++i)
+        {
+            channels[i * 2 + 0] = f16tof32(packed[i]);
+            channels[i * 2 + 1] = f16tof32(packed[i] >> 16);
+        }
+        return true;
+    }
+
+    // Stores the decoded channels if the slot is empty or its entry has expired
+    void Store(float channels[NTC_MLP_OUTPUT_CHANNELS])
+    {
+        uint const stamp = u_TexelCache.Load(offset);
+        if (stamp != 0 && frame - (stamp >> 1) <= maxAge)
+            return;
+
+        uint originalStamp;
+        u_TexelCache.InterlockedCompareExchange(offset, stamp, (frame << 1) | 1, originalStamp);
+        if (originalStamp != stamp)
+            return;
+
+        uint packed[8];
+        [unroll]
+        for (int i = 0; i < NTC_TEXEL_CACHE_CHANNELS / 2; ++i)
+            packed[i] = f32tof16(channels[i * 2 + 0]) | (f32tof16(channels[i * 2 + 1]) << 16);
+
+        u_TexelCache.Store(offset + 4, key);
+        u_TexelCache.Store4(offset + 8, uint4(packed[0], packed[1], packed[2], packed[3]));
+        u_TexelCache.Store4(offset + 24, uint4(packed[4], packed[5], packed[6], packed[7]));
+    }
+};
+
+#endif // NTC_TEXEL_CACHE_HLSLI
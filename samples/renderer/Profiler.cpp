@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2024-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -11,89 +11,13 @@
  */
 
 #include "Profiler.h"
+#include <donut/core/log.h>
 #include <imgui.h>
 #include <implot.h>
+#include <algorithm>
+#include <cmath>
 
-void AveragingTimerQuery::beginQuery(nvrhi::ICommandList* commandList)
-{
-    nvrhi::TimerQueryHandle query;
-    if (m_idleQueries.empty())
-    {
-        query = m_device->createTimerQuery();
-    }
-    else
-    {
-        query = m_idleQueries.front();
-        m_idleQueries.pop();
-    }
-
-    commandList->beginTimerQuery(query);
-    m_openQuery = query;
-}
-
-void AveragingTimerQuery::endQuery(nvrhi::ICommandList* commandList)
-{
-    assert(m_openQuery);
-    commandList->endTimerQuery(m_openQuery);
-    m_activeQueries.push(m_openQuery);
-    m_openQuery = nullptr;
-}
-
-void AveragingTimerQuery::update()
-{
-    while (!m_activeQueries.empty())
-    {
-        nvrhi::TimerQueryHandle query = m_activeQueries.front();
-        if (m_device->pollTimerQuery(query))
-        {
-            float time = m_device->getTimerQueryTime(query);
-            m_history.push_back(time);
-            m_activeQueries.pop();
-            m_idleQueries.push(query);
-        }
-        else
-            break;
-    }
-
-    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
-    float const secondsSinceUpdate = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastUpdateTime)
-        .count() * 1e-6f;
-
-    if (secondsSinceUpdate > m_updateIntervalSeconds && !m_history.empty())
-    {
-        float sumTime = 0.f;
-        for (float time : m_history)
-            sumTime += time;
-        
-        m_averageTime = sumTime / m_history.size();
-        m_lastUpdateTime = now;
-
-        float const latestTime = m_history[m_history.size() - 1];
-        m_history.clear();
-        m_history.push_back(latestTime);
-    }
-}
-
-void AveragingTimerQuery::setUpdateInterval(float seconds)
-{
-    m_updateIntervalSeconds = seconds;
-}
-
-void AveragingTimerQuery::clearHistory()
-{
-    m_history.clear();
-    m_lastUpdateTime = std::chrono::steady_clock::now();
-}
-
-std::optional<float> AveragingTimerQuery::getLatestAvailableTime()
-{
-    return m_history.empty() ? std::optional<float>() :  m_history.back();
-}
-
-std::optional<float> AveragingTimerQuery::getAverageTime()
-{
-    return m_averageTime;
-}
+using namespace donut;
 
 void SmoothAxisLimit::Update(double newMaximum, double lastFrameTimeSeconds)
 {
@@ -125,6 +49,11 @@ void SmoothAxisLimit::Update(double newMaximum, double lastFrameTimeSeconds)
 
 ProfilerRecord& Profiler::AddRecord()
 {
+    // The previous record has been filled by now, so it can go into the capture
+    if (m_capturePendingRecord && !m_profilerHistory.empty())
+        WriteCapturedRecord(m_profilerHistory.back());
+    m_capturePendingRecord = m_capturing;
+
     auto& record = m_profilerHistory.emplace_back();
     record.timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_appStartTime).count();
     return record;
@@ -163,6 +92,179 @@ void Profiler::TrimHistory()
 
 constexpr double c_SecondsToMs = 1e3;
 
+// The record fields that are written into capture files and summarized, in output order
+struct ProfilerField
+{
+    char const* name;
+    double (*get)(ProfilerRecord const& record);
+};
+
+static const ProfilerField g_profilerFields[] = {
+    { "frameTimeMs",                 [](ProfilerRecord const& r) { return r.frameTime * c_SecondsToMs; } },
+    { "renderTimeMs",                [](ProfilerRecord const& r) { return r.renderTime * c_SecondsToMs; } },
+    { "transcodingTimeMs",           [](ProfilerRecord const& r) { return r.transcodingTime * c_SecondsToMs; } },
+    { "feedbackBeginFrameCpuTimeMs", [](ProfilerRecord const& r) { return r.feedbackBeginFrameCpuTime * c_SecondsToMs; } },
+    { "tileSchedulingCpuTimeMs",     [](ProfilerRecord const& r) { return r.tileSchedulingCpuTime * c_SecondsToMs; } },
+    { "tileMappingCpuTimeMs",        [](ProfilerRecord const& r) { return r.tileMappingCpuTime * c_SecondsToMs; } },
+    { "transcodingCpuTimeMs",        [](ProfilerRecord const& r) { return r.transcodingCpuTime * c_SecondsToMs; } },
+    { "tilesTotal",                  [](ProfilerRecord const& r) { return double(r.tilesTotal); } },
+    { "tilesAllocated",              [](ProfilerRecord const& r) { return double(r.tilesAllocated); } },
+    { "tilesStandby",                [](ProfilerRecord const& r) { return double(r.tilesStandby); } },
+    { "tilesRequested",              [](ProfilerRecord const& r) { return double(r.tilesRequested); } },
+    { "tilesMapped",                 [](ProfilerRecord const& r) { return double(r.tilesMapped); } },
+    { "tilesTranscoded",             [](ProfilerRecord const& r) { return double(r.tilesTranscoded); } },
+    { "tilesPending",                [](ProfilerRecord const& r) { return double(r.tilesPending); } },
+    { "tileBudget",                  [](ProfilerRecord const& r) { return double(r.tileBudget); } },
+    { "transcodeQueueDepth",         [](ProfilerRecord const& r) { return double(r.transcodeQueueDepth); } },
+    { "heapsAllocated",              [](ProfilerRecord const& r) { return double(r.heapsAllocated); } },
+    { "tileLatencyP50Ms",            [](ProfilerRecord const& r) { return r.tileLatencyP50Ms; } },
+    { "tileLatencyP95Ms",            [](ProfilerRecord const& r) { return r.tileLatencyP95Ms; } },
+    { "tileLatencyP99Ms",            [](ProfilerRecord const& r) { return r.tileLatencyP99Ms; } },
+    { "tileLatencyP50Frames",        [](ProfilerRecord const& r) { return double(r.tileLatencyP50Frames); } },
+    { "tileLatencyP95Frames",        [](ProfilerRecord const& r) { return double(r.tileLatencyP95Frames); } },
+    { "tileLatencyP99Frames",        [](ProfilerRecord const& r) { return double(r.tileLatencyP99Frames); } },
+};
+
+bool Profiler::BeginCapture(std::filesystem::path const& outputPath)
+{
+    EndCapture();
+
+    m_capturedRecords.clear();
+    m_capturePendingRecord = false;
+    m_captureJson = false;
+
+    if (!outputPath.empty())
+    {
+        m_captureFile = fopen(outputPath.generic_string().c_str(), "w");
+        if (!m_captureFile)
+        {
+            log::error("Cannot open file '%s' for writing.", outputPath.generic_string().c_str());
+            return false;
+        }
+
+        std::string extension = outputPath.extension().generic_string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        m_captureJson = extension == ".json";
+
+        if (m_captureJson)
+        {
+            fprintf(m_captureFile, "{\n  \"frames\": [");
+        }
+        else
+        {
+            fprintf(m_captureFile, "frame,timestamp");
+            for (ProfilerField const& field : g_profilerFields)
+                fprintf(m_captureFile, ",%s", field.name);
+            fprintf(m_captureFile, "\n");
+        }
+    }
+
+    m_capturing = true;
+    return true;
+}
+
+void Profiler::EndCapture()
+{
+    if (!m_capturing)
+        return;
+
+    if (m_capturePendingRecord && !m_profilerHistory.empty())
+        WriteCapturedRecord(m_profilerHistory.back());
+    m_capturePendingRecord = false;
+    m_capturing = false;
+
+    WriteCaptureSummary();
+
+    if (m_captureFile)
+    {
+        fclose(m_captureFile);
+        m_captureFile = nullptr;
+    }
+}
+
+void Profiler::WriteCapturedRecord(ProfilerRecord const& record)
+{
+    size_t const frame = m_capturedRecords.size();
+    m_capturedRecords.push_back(record);
+
+    if (!m_captureFile)
+        return;
+
+    if (m_captureJson)
+    {
+        fprintf(m_captureFile, "%s\n    { \"frame\": %zu, \"timestamp\": %.6f", frame == 0 ? "" : ",", frame, record.timestamp);
+        for (ProfilerField const& field : g_profilerFields)
+            fprintf(m_captureFile, ", \"%s\": %g", field.name, field.get(record));
+        fprintf(m_captureFile, " }");
+    }
+    else
+    {
+        fprintf(m_captureFile, "%zu,%.6f", frame, record.timestamp);
+        for (ProfilerField const& field : g_profilerFields)
+            fprintf(m_captureFile, ",%g", field.get(record));
+        fprintf(m_captureFile, "\n");
+    }
+
+    // Keep the file usable if the application is terminated during the capture
+    fflush(m_captureFile);
+}
+
+void Profiler::WriteCaptureSummary()
+{
+    if (m_capturedRecords.empty())
+    {
+        if (m_captureFile && m_captureJson)
+            fprintf(m_captureFile, "\n  ],\n  \"summary\": {}\n}\n");
+        return;
+    }
+
+    static const double percentiles[] = { 50.0, 90.0, 95.0, 99.0 };
+
+    if (m_captureFile && m_captureJson)
+        fprintf(m_captureFile, "\n  ],\n  \"summary\": {");
+
+    log::info("Profiler capture: %zu frames", m_capturedRecords.size());
+
+    std::vector<double> values;
+    bool firstField = true;
+    for (ProfilerField const& field : g_profilerFields)
+    {
+        values.clear();
+        double sum = 0.0;
+        for (ProfilerRecord const& record : m_capturedRecords)
+        {
+            double const value = field.get(record);
+            values.push_back(value);
+            sum += value;
+        }
+        std::sort(values.begin(), values.end());
+
+        // Nearest-rank percentiles
+        double percentileValues[std::size(percentiles)];
+        for (size_t index = 0; index < std::size(percentiles); ++index)
+        {
+            size_t const rank = size_t(std::ceil(percentiles[index] / 100.0 * double(values.size())));
+            percentileValues[index] = values[std::clamp(rank, size_t(1), values.size()) - 1];
+        }
+        double const mean = sum / double(values.size());
+
+        log::info("  %-28s mean %10.3f  p50 %10.3f  p90 %10.3f  p95 %10.3f  p99 %10.3f  max %10.3f",
+            field.name, mean, percentileValues[0], percentileValues[1], percentileValues[2], percentileValues[3],
+            values.back());
+
+        if (m_captureFile && m_captureJson)
+        {
+            fprintf(m_captureFile, "%s\n    \"%s\": { \"mean\": %g, \"p50\": %g, \"p90\": %g, \"p95\": %g, "
+                "\"p99\": %g, \"max\": %g }", firstField ? "" : ",", field.name, mean,
+                percentileValues[0], percentileValues[1], percentileValues[2], percentileValues[3], values.back());
+        }
+        firstField = false;
+    }
+
+    if (m_captureFile && m_captureJson)
+        fprintf(m_captureFile, "\n  }\n}\n");
+}
+
 // Getter functions for ImPlot
 class ProfilerGetters
 {
@@ -185,6 +287,12 @@ public:
         return ImPlotPoint(GetTimeValue(idx, profiler), profiler->m_profilerHistory[idx].transcodingTime * c_SecondsToMs);
     }
 
+    static ImPlotPoint GetTileSchedulingCpuTime(int idx, void* userData)
+    {
+        Profiler* profiler = static_cast<Profiler*>(userData);
+        return ImPlotPoint(GetTimeValue(idx, profiler), profiler->m_profilerHistory[idx].tileSchedulingCpuTime * c_SecondsToMs);
+    }
+
     static ImPlotPoint GetTilesAllocated(int idx, void* userData)
     {
         Profiler* profiler = static_cast<Profiler*>(userData);
@@ -197,6 +305,12 @@ public:
         return ImPlotPoint(GetTimeValue(idx, profiler), double(profiler->m_profilerHistory[idx].tilesStandby));
     }
 
+    static ImPlotPoint GetTilesPending(int idx, void* userData)
+    {
+        Profiler* profiler = static_cast<Profiler*>(userData);
+        return ImPlotPoint(GetTimeValue(idx, profiler), double(profiler->m_profilerHistory[idx].tilesPending));
+    }
+
 private:
     static double GetTimeValue(int idx, Profiler* profiler)
     {
@@ -239,10 +353,14 @@ void Profiler::BuildUI(bool enableFeedbackStats)
         maxTime = std::max(maxTime, record.frameTime);
         maxTime = std::max(maxTime, record.renderTime);
         if (enableFeedbackStats)
+        {
             maxTime = std::max(maxTime, record.transcodingTime);
+            maxTime = std::max(maxTime, record.tileSchedulingCpuTime);
+        }
             
         maxTiles = std::max(maxTiles, double(record.tilesAllocated));
         maxTiles = std::max(maxTiles, double(record.tilesStandby));
+        maxTiles = std::max(maxTiles, double(record.tilesPending));
     }
 
     maxTime *= secondToMs;
@@ -257,7 +375,10 @@ void Profiler::BuildUI(bool enableFeedbackStats)
         ImPlot::PlotLineG("Frame Time", &ProfilerGetters::GetFrameTime, this, historySize);
         ImPlot::PlotLineG("Render Time", &ProfilerGetters::GetRenderTime, this, historySize);
         if (enableFeedbackStats)
+        {
             ImPlot::PlotLineG("Transcoding Time", &ProfilerGetters::GetTranscodingTime, this, historySize);
+            ImPlot::PlotLineG("Tile Scheduling CPU Time", &ProfilerGetters::GetTileSchedulingCpuTime, this, historySize);
+        }
         ImPlot::EndPlot();
     }
 
@@ -269,6 +390,31 @@ void Profiler::BuildUI(bool enableFeedbackStats)
         ImPlot::SetupAxesLimits(-m_profilerHistoryDuration, 0, 0, m_tilesPlotLimit.GetMaximum(), ImGuiCond_Always);
         ImPlot::PlotLineG("Tiles Allocated", &ProfilerGetters::GetTilesAllocated, this, historySize);
         ImPlot::PlotLineG("Tiles Standby", &ProfilerGetters::GetTilesStandby, this, historySize);
+        ImPlot::PlotLineG("Tiles Pending", &ProfilerGetters::GetTilesPending, this, historySize);
         ImPlot::EndPlot();
     }
+
+    if (enableFeedbackStats && !m_tileLatencyHistogram.empty())
+    {
+        ProfilerRecord const& record = m_profilerHistory.back();
+        ImGui::Text("Tile Latency: p50 %.1f ms (%u fr), p95 %.1f ms (%u fr), p99 %.1f ms (%u fr)",
+            record.tileLatencyP50Ms, record.tileLatencyP50Frames,
+            record.tileLatencyP95Ms, record.tileLatencyP95Frames,
+            record.tileLatencyP99Ms, record.tileLatencyP99Frames);
+
+        if (ImPlot::BeginPlot("Tile Latency", ImVec2(20.f * fontSize, 10.f * fontSize),
+            ImPlotFlags_NoTitle | ImPlotFlags_NoMenus | ImPlotFlags_NoInputs | ImPlotFlags_NoLegend))
+        {
+            // The last bin also counts all longer latencies
+            ImPlot::SetupAxes("Latency (frames)", "Tiles", 0, ImPlotAxisFlags_AutoFit);
+            ImPlot::SetupAxisLimits(ImAxis_X1, -0.5, double(m_tileLatencyHistogram.size()) - 0.5, ImGuiCond_Always);
+            ImPlot::PlotBars("Tiles", m_tileLatencyHistogram.data(), int(m_tileLatencyHistogram.size()), 0.8);
+            ImPlot::EndPlot();
+        }
+    }
+}
+
+void Profiler::SetTileLatencyHistogram(uint32_t const* bins, uint32_t count)
+{
+    m_tileLatencyHistogram.assign(bins, bins + count);
 }
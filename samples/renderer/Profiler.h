@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2024-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -12,53 +12,11 @@
 
 #pragma once
 
-#include <nvrhi/nvrhi.h>
+#include <ntc-utils/AveragingTimerQuery.h>
 #include <chrono>
-#include <optional>
-#include <queue>
-
-// The AveragingTimerQuery class implements a timer query that is non-blocking using a pool of
-// regular NVRHI TimerQueries, and that accumulates the timing results over a set time interval.
-class AveragingTimerQuery
-{
-private:
-    nvrhi::DeviceHandle m_device;
-    std::queue<nvrhi::TimerQueryHandle> m_idleQueries;
-    std::queue<nvrhi::TimerQueryHandle> m_activeQueries;
-    nvrhi::TimerQueryHandle m_openQuery;
-
-    std::vector<float> m_history;
-    float m_updateIntervalSeconds = 0.5f;
-    std::chrono::steady_clock::time_point m_lastUpdateTime = std::chrono::steady_clock::now();
-    std::optional<float> m_averageTime;
-
-public:
-    AveragingTimerQuery(nvrhi::IDevice* device)
-        : m_device(device)
-    { }
-
-    // Takes an available query from the pool and calls commandList->beginQuery with it.
-    void beginQuery(nvrhi::ICommandList* commandList);
-
-    // Calls commandList->endQuery with the currently open timer query.
-    void endQuery(nvrhi::ICommandList* commandList);
-
-    // Polls the active timer queries and retrieves available results, also processes temporal averaging.
-    // Call update() on every frame.
-    void update();
-
-    // Sets the time interval between updating average time values.
-    void setUpdateInterval(float seconds);
-
-    // Clears the history, such as when changing rendering algorithms.
-    void clearHistory();
-
-    // Returns the latest directly measured time, if any.
-    std::optional<float> getLatestAvailableTime();
-
-    // Returns the latest average time, if any.
-    std::optional<float> getAverageTime();
-};
+#include <cstdio>
+#include <filesystem>
+#include <vector>
 
 struct ProfilerRecord
 {
@@ -66,11 +24,29 @@ struct ProfilerRecord
     double frameTime = 0;
     double renderTime = 0;
     double transcodingTime = 0;
+    double tileSchedulingCpuTime = 0;
+    double feedbackBeginFrameCpuTime = 0; // CPU times of the ProcessInferenceOnFeedback phases
+    double tileMappingCpuTime = 0;
+    double transcodingCpuTime = 0;
 
     uint32_t tilesTotal = 0;
     uint32_t tilesAllocated = 0;
     uint32_t tilesStandby = 0;
     uint32_t tilesTranscoded = 0;
+    uint32_t tilesPending = 0;
+    uint32_t tileBudget = 0;
+    uint32_t tilesRequested = 0; // Tiles requested by the sampler feedback on this frame
+    uint32_t tilesMapped = 0;    // Tiles selected for mapping and transcoding on this frame
+    uint32_t transcodeQueueDepth = 0; // Async transcode batches in flight
+    uint32_t heapsAllocated = 0;
+
+    // Request-to-resident latency percentiles of the recently mapped tiles, see FeedbackManagerStats
+    double tileLatencyP50Ms = 0;
+    double tileLatencyP95Ms = 0;
+    double tileLatencyP99Ms = 0;
+    uint32_t tileLatencyP50Frames = 0;
+    uint32_t tileLatencyP95Frames = 0;
+    uint32_t tileLatencyP99Frames = 0;
 };
 
 class SmoothAxisLimit
@@ -96,8 +72,33 @@ public:
     void TrimHistory();
     void BuildUI(bool enableFeedbackStats);
 
+    // Sets the tile latency histogram shown in the UI, with bins of one frame each
+    void SetTileLatencyHistogram(uint32_t const* bins, uint32_t count);
+
+    // Starts collecting all new records, independently of the plot history, to report their percentiles
+    // in EndCapture. When outputPath is not empty, the records are also streamed into that file as they complete,
+    // in JSON format if the extension is .json, or CSV otherwise.
+    bool BeginCapture(std::filesystem::path const& outputPath);
+
+    // Writes the last record and the percentile summary, and closes the output file.
+    void EndCapture();
+
+    bool IsCapturing() const { return m_capturing; }
+
 private:
     friend class ProfilerGetters;
+
+    void WriteCapturedRecord(ProfilerRecord const& record);
+    void WriteCaptureSummary();
+
+    bool m_capturing = false;
+    bool m_capturePendingRecord = false; // The last record in m_profilerHistory is part of the capture
+    bool m_captureJson = false;
+    FILE* m_captureFile = nullptr;
+    std::vector<ProfilerRecord> m_capturedRecords;
+
+    std::vector<double> m_tileLatencyHistogram;
+
     std::chrono::steady_clock::time_point m_appStartTime = std::chrono::steady_clock::now();
     std::vector<ProfilerRecord> m_profilerHistory;
     SmoothAxisLimit m_timePlotLimit;
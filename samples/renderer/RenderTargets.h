@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2024-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -25,6 +25,13 @@ struct RenderTargets
     nvrhi::TextureHandle feedback2;
     nvrhi::TextureHandle motionVectors;
 
+    // Deferred inference on sample attributes, only created when inference on sample is enabled
+    nvrhi::TextureHandle materialIds;
+    nvrhi::TextureHandle deferredTexCoords;
+    nvrhi::TextureHandle deferredTexCoordGradients;
+    nvrhi::TextureHandle deferredNormalsAndTangents;
+
     std::shared_ptr<donut::engine::FramebufferFactory> depthFramebufferFactory;
     std::shared_ptr<donut::engine::FramebufferFactory> framebufferFactory;
+    std::shared_ptr<donut::engine::FramebufferFactory> deferredFramebufferFactory;
 };
@@ -0,0 +1,130 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "TileScheduler.h"
+#include "feedbackmanager/include/FeedbackManager.h"
+#include <algorithm>
+#include <cmath>
+
+// Priority contributions, see SelectTiles(...)
+static const float c_MipLevelPriority = 10.f;
+static const float c_FallbackTilePriority = 5.f;
+static const float c_AgePriorityPerSecond = 20.f;
+
+// Smoothing factor for the per-tile cost estimate
+static const float c_CostSmoothing = 0.1f;
+
+void TileScheduler::AddRequest(nvfeedback::FeedbackTexture* texture, uint32_t tileIndex, uint32_t mipLevel,
+    double timestamp)
+{
+    if (!m_queuedTiles.insert(TileKey{ texture, tileIndex }).second)
+        return;
+
+    Request& request = m_requests.emplace_back();
+    request.tile.texture = texture;
+    request.tile.tileIndex = tileIndex;
+    request.mipLevel = mipLevel;
+    request.timestamp = timestamp;
+    request.priority = 0.f;
+}
+
+void TileScheduler::UpdateBudget(std::optional<float> transcodeTimeSeconds)
+{
+    // The timer results arrive a few frames late, so relate them to the smoothed count of tiles selected
+    // per frame rather than to the count from any specific frame.
+    if (transcodeTimeSeconds.has_value() && m_averageSelectedCount >= 1.f)
+    {
+        float const costSample = transcodeTimeSeconds.value() * 1e3f / m_averageSelectedCount;
+        m_costPerTileMs = (m_costPerTileMs > 0.f)
+            ? m_costPerTileMs + (costSample - m_costPerTileMs) * c_CostSmoothing
+            : costSample;
+    }
+
+    if (m_costPerTileMs > 0.f)
+    {
+        float const tiles = std::floor(m_desc.transcodeBudgetMs / m_costPerTileMs);
+        m_tileBudget = uint32_t(std::clamp(tiles, float(m_desc.minTilesPerFrame), float(m_desc.maxTilesPerFrame)));
+    }
+    else
+    {
+        m_tileBudget = std::clamp(m_tileBudget, m_desc.minTilesPerFrame, m_desc.maxTilesPerFrame);
+    }
+}
+
+void TileScheduler::SelectTiles(double timestamp, bool cameraCut, nvfeedback::FeedbackManager* feedbackManager,
+    std::vector<RequestedTile>& outTiles)
+{
+    // Drop the requests that have been waiting for too long, and the ones that don't need mapping anymore:
+    // their tiles may have become resident or been released while the requests were waiting in the queue.
+    auto expired = std::remove_if(m_requests.begin(), m_requests.end(),
+        [this, timestamp, feedbackManager](Request const& request)
+    {
+        return timestamp - request.timestamp > m_desc.requestTimeoutSeconds ||
+            !feedbackManager->IsTileRequestPending(request.tile.texture, request.tile.tileIndex);
+    });
+    for (auto it = expired; it != m_requests.end(); ++it)
+        m_queuedTiles.erase(TileKey{ it->tile.texture, it->tile.tileIndex });
+    m_droppedRequests += uint32_t(m_requests.end() - expired);
+    m_requests.erase(expired, m_requests.end());
+
+    if (m_requests.empty())
+    {
+        if (!cameraCut)
+            m_averageSelectedCount -= m_averageSelectedCount * c_CostSmoothing;
+        return;
+    }
+
+    // Find the coarsest requested mip for every texture: the tiles at that level are what the finer tiles
+    // of the same texture will fall back to when sampled, so they are missing the most.
+    m_coarsestPendingMip.clear();
+    for (Request const& request : m_requests)
+    {
+        auto [it, inserted] = m_coarsestPendingMip.try_emplace(request.tile.texture, request.mipLevel);
+        if (!inserted)
+            it->second = std::max(it->second, request.mipLevel);
+    }
+
+    for (Request& request : m_requests)
+    {
+        float priority = float(request.mipLevel) * c_MipLevelPriority;
+        if (m_coarsestPendingMip[request.tile.texture] == request.mipLevel)
+            priority += c_FallbackTilePriority;
+        priority += float(timestamp - request.timestamp) * c_AgePriorityPerSecond;
+        request.priority = priority;
+    }
+
+    size_t const count = std::min(m_requests.size(),
+        size_t(cameraCut ? m_desc.cameraCutTilesPerFrame : m_tileBudget));
+
+    // Move the 'count' highest priority requests to the front
+    auto byPriority = [](Request const& a, Request const& b) { return a.priority > b.priority; };
+    if (count < m_requests.size())
+        std::nth_element(m_requests.begin(), m_requests.begin() + count, m_requests.end(), byPriority);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Request const& request = m_requests[i];
+        outTiles.push_back(request.tile);
+        m_queuedTiles.erase(TileKey{ request.tile.texture, request.tile.tileIndex });
+    }
+    m_requests.erase(m_requests.begin(), m_requests.begin() + count);
+
+    // Camera cut frames are not representative of the steady state, don't use them for the cost estimate
+    if (!cameraCut)
+        m_averageSelectedCount += (float(count) - m_averageSelectedCount) * c_CostSmoothing;
+}
+
+void TileScheduler::Clear()
+{
+    m_requests.clear();
+    m_queuedTiles.clear();
+}
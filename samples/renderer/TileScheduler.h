@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace nvfeedback
+{
+    class FeedbackManager;
+    class FeedbackTexture;
+}
+
+struct RequestedTile
+{
+    nvfeedback::FeedbackTexture* texture;
+    uint32_t tileIndex;
+};
+
+struct TileSchedulerDesc
+{
+    // GPU time that tile transcoding is allowed to take per frame, in milliseconds
+    float transcodeBudgetMs = 1.0f;
+
+    // Limits for the number of tiles selected per frame in normal operation
+    uint32_t minTilesPerFrame = 4;
+    uint32_t maxTilesPerFrame = 128;
+
+    // Number of tiles selected per frame after a camera cut, ignoring the budget
+    uint32_t cameraCutTilesPerFrame = 256;
+
+    // Requests that have been waiting longer than this are dropped.
+    // Should match the tile timeout in FeedbackUpdateConfig: after that time, the tile has likely been released
+    // by the tiled texture manager, and it will be requested again through feedback if it is still needed.
+    float requestTimeoutSeconds = 1.0f;
+};
+
+// The TileScheduler class collects tile requests produced by the FeedbackManager and selects which of them
+// should be mapped and transcoded on each frame. Requests are ordered by priority (coarser mips first,
+// tiles that other requests of the same texture would fall back to, older requests), and the number of tiles
+// per frame is adjusted to keep the measured transcoding GPU time within a budget.
+class TileScheduler
+{
+public:
+    TileScheduler() = default;
+
+    void SetDesc(TileSchedulerDesc const& desc) { m_desc = desc; }
+    TileSchedulerDesc const& GetDesc() const { return m_desc; }
+
+    // Adds a request for a tile. Duplicate requests for tiles that are already queued are ignored.
+    void AddRequest(nvfeedback::FeedbackTexture* texture, uint32_t tileIndex, uint32_t mipLevel, double timestamp);
+
+    // Updates the per-frame tile budget using a newly measured transcoding time, if one was resolved this frame.
+    // Pass each timer result only once, otherwise it is counted repeatedly in the smoothed per-tile cost.
+    void UpdateBudget(std::optional<float> transcodeTimeSeconds);
+
+    // Removes the highest priority requests from the queue and appends them to outTiles.
+    // Expired requests are dropped, and so are the requests that feedbackManager no longer considers pending,
+    // because their tiles are already resident or have been released. When cameraCut is true, the budget is ignored.
+    void SelectTiles(double timestamp, bool cameraCut, nvfeedback::FeedbackManager* feedbackManager,
+        std::vector<RequestedTile>& outTiles);
+
+    // Drops all pending requests, used when the feedback mode is entered or the view changes abruptly.
+    void Clear();
+
+    size_t GetNumPendingRequests() const { return m_requests.size(); }
+    uint32_t GetTileBudget() const { return m_tileBudget; }
+    uint32_t GetNumDroppedRequests() const { return m_droppedRequests; }
+    float GetCostPerTileMs() const { return m_costPerTileMs; }
+
+private:
+    struct Request
+    {
+        RequestedTile tile;
+        uint32_t mipLevel;
+        double timestamp;
+        float priority;
+    };
+
+    struct TileKey
+    {
+        nvfeedback::FeedbackTexture* texture;
+        uint32_t tileIndex;
+
+        bool operator==(TileKey const& other) const
+        {
+            return texture == other.texture && tileIndex == other.tileIndex;
+        }
+    };
+
+    struct TileKeyHash
+    {
+        size_t operator()(TileKey const& key) const
+        {
+            return std::hash<void*>()(key.texture) ^ (std::hash<uint32_t>()(key.tileIndex) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    TileSchedulerDesc m_desc;
+    std::vector<Request> m_requests;
+    std::unordered_set<TileKey, TileKeyHash> m_queuedTiles;
+    std::unordered_map<nvfeedback::FeedbackTexture*, uint32_t> m_coarsestPendingMip;
+
+    uint32_t m_tileBudget = 32; // Initial value used until the first timer results arrive
+    float m_averageSelectedCount = 0.f;
+    float m_costPerTileMs = 0.f;
+    uint32_t m_droppedRequests = 0;
+};
@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Interface of the feedback compaction shader, see FeedbackManagerDesc::feedbackCompactionShader.
+// This file is included by both C++ and HLSL code.
+
+#ifndef FEEDBACK_COMPACTION_CONSTANTS_H
+#define FEEDBACK_COMPACTION_CONSTANTS_H
+
+#define FEEDBACK_COMPACTION_BINDING_CONSTANTS 0
+#define FEEDBACK_COMPACTION_BINDING_FEEDBACK 0  // t0: resolved feedback, one value per mip region
+#define FEEDBACK_COMPACTION_BINDING_PREVIOUS 0  // u0: last min mip values sent to the CPU, one uint per region
+#define FEEDBACK_COMPACTION_BINDING_REQUESTS 1  // u1: request buffer shared by all textures of the frame
+
+#define FEEDBACK_COMPACTION_GROUP_SIZE 256
+
+// Formats of the resolved feedback
+#define FEEDBACK_COMPACTION_SOURCE_8BIT 0   // Decoded sampler feedback, one byte per region
+#define FEEDBACK_COMPACTION_SOURCE_32BIT 1  // Feedback buffer written by the shaders, one uint per region
+
+// The request buffer starts with a uint count of the changed regions, including the ones that didn't fit,
+// padded to FEEDBACK_COMPACTION_HEADER_SIZE bytes. It is followed by requests of two uints each:
+// { textureSlot, (regionIndex << 8) | minMip }.
+#define FEEDBACK_COMPACTION_HEADER_SIZE 16
+#define FEEDBACK_COMPACTION_REQUEST_SIZE 8
+
+struct FeedbackCompactionConstants
+{
+    uint32_t sourceOffset;  // Byte offset of the first region value in the feedback buffer
+    uint32_t sourceFormat;  // One of FEEDBACK_COMPACTION_SOURCE_...
+    uint32_t numRegions;
+    uint32_t textureSlot;   // Identifies the texture in the requests
+    uint32_t maxRequests;   // Requests past this number are dropped and reported again next time
+    uint32_t padding0;
+    uint32_t padding1;
+    uint32_t padding2;
+};
+
+#endif // FEEDBACK_COMPACTION_CONSTANTS_H
@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <nvrhi/nvrhi.h>
 
 namespace nvfeedback
@@ -39,7 +40,31 @@ namespace nvfeedback
         }
     };
 
-    // A tiled texture with sampler feedback
+    struct FeedbackTextureTileInfoHash
+    {
+        size_t operator()(const FeedbackTextureTileInfo& tile) const
+        {
+            // Tiles of one texture are uniquely identified by mip and position, so size is not hashed
+            uint64_t key = (uint64_t(tile.mip) << 48) ^ (uint64_t(tile.yInTexels) << 24) ^ uint64_t(tile.xInTexels);
+            return std::hash<uint64_t>()(key);
+        }
+    };
+
+    // Layout of the start of a feedback buffer, see FeedbackTexture::GetFeedbackBuffer.
+    // The header is followed by widthInRegions * heightInRegions uint32 values in row-major order,
+    // each holding the finest mip level sampled in that region, or 0xffffffff if the region was not sampled.
+    struct FeedbackBufferHeader
+    {
+        uint32_t regionWidth;     // Size of a mip region in texels of mip 0
+        uint32_t regionHeight;
+        uint32_t widthInRegions;
+        uint32_t heightInRegions;
+    };
+
+    // A tiled texture with sampler feedback.
+    // When the device supports nvrhi::Feature::SamplerFeedback (D3D12), the feedback is written by shaders into
+    // the sampler feedback texture. Otherwise (Vulkan), shaders compute the LOD themselves and write it
+    // into the feedback buffer with atomics, and only one of the two resources exists.
     class FeedbackTexture
     {
     public:
@@ -48,6 +73,7 @@ namespace nvfeedback
 
         virtual nvrhi::TextureHandle GetReservedTexture() = 0;
         virtual nvrhi::SamplerFeedbackTextureHandle GetSamplerFeedbackTexture() = 0;
+        virtual nvrhi::BufferHandle GetFeedbackBuffer() = 0; // Raw UAV buffer starting with FeedbackBufferHeader
         virtual nvrhi::TextureHandle GetMinMipTexture() = 0;
         virtual bool IsTilePacked(uint32_t tileIndex) = 0;
         virtual void GetTileInfo(uint32_t tileIndex, std::vector<FeedbackTextureTileInfo>& tiles) = 0;
@@ -74,6 +100,10 @@ namespace nvfeedback
         virtual bool RemoveTexture(FeedbackTexture* texture) = 0;
     };
 
+    // Number of bins in FeedbackManagerStats::tileLatencyHistogram, one per frame of latency.
+    // The last bin also counts all longer latencies.
+    static const uint32_t c_tileLatencyHistogramBins = 16;
+
     struct FeedbackManagerStats
     {
         uint64_t heapAllocationInBytes; // The amount of heap space allocated in bytes
@@ -81,10 +111,29 @@ namespace nvfeedback
         uint32_t tilesTotal;            // Total number of tiles tracked in all textures
         uint32_t tilesAllocated;        // Number of tiles allocated in heaps
         uint32_t tilesStandby;          // Number of tiles in the standby queue
+        uint32_t heapsPooled;           // Number of created heaps waiting in the pool, included in heapAllocationInBytes
+        uint32_t heapsAllocated;        // Number of heaps in use, not including the pooled heaps
+        uint64_t bytesResident;         // Memory used by the allocated tiles, including standby tiles
+        uint64_t memoryBudgetInBytes;   // The budget from FeedbackUpdateConfig, 0=unlimited
 
         double cputimeBeginFrame;
         double cputimeUpdateTileMappings;
         double cputimeResolve;
+
+        uint64_t feedbackReadbackBytes; // Size of the feedback data read back by BeginFrame
+        uint32_t feedbackRequests;      // With feedback compaction, number of changed regions read back by BeginFrame
+        uint32_t minMipTexelsUpdated;   // Number of MinMip texels written during this frame, including whole uploads
+
+        // Request-to-resident latency of the recently mapped tiles: the time from a tile being returned by BeginFrame
+        // to its mapping being exposed to rendering by UpdateTileMappings or CommitTileMappings
+        uint32_t tileLatencySamples;    // Number of tiles the latency statistics are computed from
+        float tileLatencyP50Ms;
+        float tileLatencyP95Ms;
+        float tileLatencyP99Ms;
+        uint32_t tileLatencyP50Frames;
+        uint32_t tileLatencyP95Frames;
+        uint32_t tileLatencyP99Frames;
+        uint32_t tileLatencyHistogram[c_tileLatencyHistogramBins]; // Number of tiles by latency in frames
     };
 
     struct FeedbackUpdateConfig
@@ -96,6 +145,9 @@ namespace nvfeedback
         bool trimStandbyTiles; // Enables trimming of standby tiles to the target number
         bool releaseEmptyHeaps; // Release empty heaps
         uint32_t numExtraStandbyTiles; // Target number of tiles to keep in standby before being evicted
+        uint64_t memoryBudgetInBytes; // Target heap memory for tiles, 0=unlimited. When set, the standby tiles are trimmed,
+                                      // heap creation is limited and empty heaps are released to stay under the budget.
+        float defragmentThreshold; // Fraction of free tiles in the allocated heaps above which heaps are defragmented, 0=always
     };
 
     struct FeedbackTextureUpdate
@@ -113,6 +165,22 @@ namespace nvfeedback
     {
         uint32_t numFramesInFlight; // Number of frames in flight, affects the latency of readback
         uint32_t heapSizeInTiles; // The size of each heap in tiles
+        uint32_t numPooledHeaps; // Number of heaps kept created ahead of demand, 0=create heaps when needed
+        bool asyncHeapCreation; // Create heaps on a background thread, BeginFrame only uses the heaps that are ready
+        uint32_t heapReleaseDelayFrames; // Number of frames a heap has to stay empty before releaseEmptyHeaps releases it,
+                                         // and without new heap demand before the pooled heaps above the reserve are released
+
+        // Compute shader compiled from FeedbackCompaction.hlsl, which enables GPU feedback compaction when set.
+        // With compaction, ResolveFeedback compares the feedback with the values read back previously on the GPU,
+        // and only the changed regions are read back, so the readback size follows the changes in the feedback
+        // instead of the total feedback area. See FeedbackCompactionConstants.h for the shader interface.
+        nvrhi::ShaderHandle feedbackCompactionShader;
+        uint32_t maxFeedbackRequests; // Capacity of the compacted request buffer, 0=default (65536)
+
+        // Compute shader compiled from MinMipUpdate.hlsl. When set, the MinMip textures are updated by writing
+        // only the texels that changed since their previous update, instead of uploading them whole.
+        // See MinMipUpdateConstants.h for the shader interface.
+        nvrhi::ShaderHandle minMipUpdateShader;
     };
 
     // FeedbackManager interfaces between application code using NVRHI and the RTXTS library
@@ -133,6 +201,20 @@ namespace nvfeedback
         // Call for tiles which ready to have their data filled on this frame's GPU timeline
         virtual void UpdateTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesReady) = 0;
 
+        // Split version of UpdateTileMappings for pipelined tile streaming.
+        // MapTiles binds heap memory to the tiles on the given queue so that their data can be filled,
+        // but does not expose the tiles to sampling yet.
+        virtual void MapTiles(FeedbackTextureCollection* tilesToMap, nvrhi::CommandQueue queue) = 0;
+
+        // Call after the data for tiles previously passed to MapTiles has been written, possibly several frames later.
+        // Marks the tiles as resident and updates the MinMip textures using the provided command list.
+        virtual void CommitTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesResident) = 0;
+
+        // Returns true if the tile was requested by BeginFrame and is still waiting to be mapped.
+        // Returns false once the tile is resident, or when the request is stale because the tile has been released
+        // or its texture destroyed since. Applications that defer mapping can use this to skip such requests.
+        virtual bool IsTileRequestPending(FeedbackTexture* texture, uint32_t tileIndex) = 0;
+
         // After rendering, resolve the sampler feedback maps
         virtual void ResolveFeedback(nvrhi::ICommandList* commandList) = 0;
 
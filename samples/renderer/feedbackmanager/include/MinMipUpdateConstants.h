@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Interface of the MinMip update shader, see FeedbackManagerDesc::minMipUpdateShader.
+// This file is included by both C++ and HLSL code.
+
+#ifndef MINMIP_UPDATE_CONSTANTS_H
+#define MINMIP_UPDATE_CONSTANTS_H
+
+#define MINMIP_UPDATE_BINDING_CONSTANTS 0
+#define MINMIP_UPDATE_BINDING_UPDATES 0 // t0: one uint per changed texel, (texelIndex << 8) | minMip
+#define MINMIP_UPDATE_BINDING_MINMIP 0  // u0: the MinMip texture
+
+#define MINMIP_UPDATE_GROUP_SIZE 64
+
+struct MinMipUpdateConstants
+{
+    uint32_t firstUpdate;   // Index of the first update of the texture in the update buffer
+    uint32_t numUpdates;
+    uint32_t textureWidth;
+    uint32_t padding;
+};
+
+#endif // MINMIP_UPDATE_CONSTANTS_H
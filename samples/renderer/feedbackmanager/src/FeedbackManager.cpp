@@ -11,13 +11,24 @@
  */
 
 #include "../include/FeedbackManager.h"
+#include "../include/FeedbackCompactionConstants.h"
+#include "../include/MinMipUpdateConstants.h"
 #include "FeedbackManagerInternal.h"
 
 #include <map>
+#include <cmath>
 #include <assert.h>
 
 namespace nvfeedback
 {
+    // Returns the time in seconds since the first call, used to timestamp the feedback updates.
+    // Double precision keeps the tile request latencies accurate to well below a millisecond in long sessions.
+    static double GetTimestamp()
+    {
+        static const auto start = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
     FeedbackManagerImpl::FeedbackManagerImpl(nvrhi::IDevice* device, const FeedbackManagerDesc& desc) :
         m_device(device),
         m_desc(desc),
@@ -26,13 +37,99 @@ namespace nvfeedback
         m_statsLastFrame()
     {
         m_texturesToReadback.resize(m_numFramesInFlight);
-        ZeroMemory(&m_statsLastFrame, sizeof(FeedbackManagerStats));
 
-        m_heapAllocator = std::make_shared<HeapAllocator>(m_device, desc.heapSizeInTiles * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES, desc.numFramesInFlight);
+        m_heapAllocator = std::make_shared<HeapAllocator>(m_device, desc.heapSizeInTiles * c_tileSizeInBytes, desc.numFramesInFlight,
+            desc.numPooledHeaps, desc.asyncHeapCreation);
 
         rtxts::TiledTextureManagerDesc tiledTextureManagerDesc = {};
         tiledTextureManagerDesc.heapTilesCapacity = desc.heapSizeInTiles;
         m_tiledTextureManager = std::shared_ptr<rtxts::TiledTextureManager>(CreateTiledTextureManager(tiledTextureManagerDesc));
+
+        if (desc.feedbackCompactionShader && !CreateCompactionResources())
+        {
+            // Fall back to reading back the whole feedback
+            m_compactionPipeline = nullptr;
+        }
+
+        if (desc.minMipUpdateShader && !CreateMinMipUpdateResources())
+        {
+            // Fall back to uploading the MinMip textures whole
+            m_minMipUpdatePipeline = nullptr;
+        }
+    }
+
+    bool FeedbackManagerImpl::CreateMinMipUpdateResources()
+    {
+        auto bindingLayoutDesc = nvrhi::BindingLayoutDesc()
+            .setVisibility(nvrhi::ShaderType::Compute)
+            .addItem(nvrhi::BindingLayoutItem::PushConstants(MINMIP_UPDATE_BINDING_CONSTANTS, sizeof(MinMipUpdateConstants)))
+            .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(MINMIP_UPDATE_BINDING_UPDATES))
+            .addItem(nvrhi::BindingLayoutItem::Texture_UAV(MINMIP_UPDATE_BINDING_MINMIP));
+
+        m_minMipUpdateBindingLayout = m_device->createBindingLayout(bindingLayoutDesc);
+        if (!m_minMipUpdateBindingLayout)
+            return false;
+
+        auto pipelineDesc = nvrhi::ComputePipelineDesc()
+            .setComputeShader(m_desc.minMipUpdateShader)
+            .addBindingLayout(m_minMipUpdateBindingLayout);
+
+        m_minMipUpdatePipeline = m_device->createComputePipeline(pipelineDesc);
+        return m_minMipUpdatePipeline != nullptr;
+    }
+
+    bool FeedbackManagerImpl::CreateCompactionResources()
+    {
+        auto bindingLayoutDesc = nvrhi::BindingLayoutDesc()
+            .setVisibility(nvrhi::ShaderType::Compute)
+            .addItem(nvrhi::BindingLayoutItem::PushConstants(FEEDBACK_COMPACTION_BINDING_CONSTANTS, sizeof(FeedbackCompactionConstants)))
+            .addItem(nvrhi::BindingLayoutItem::RawBuffer_SRV(FEEDBACK_COMPACTION_BINDING_FEEDBACK))
+            .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(FEEDBACK_COMPACTION_BINDING_PREVIOUS))
+            .addItem(nvrhi::BindingLayoutItem::RawBuffer_UAV(FEEDBACK_COMPACTION_BINDING_REQUESTS));
+
+        m_compactionBindingLayout = m_device->createBindingLayout(bindingLayoutDesc);
+        if (!m_compactionBindingLayout)
+            return false;
+
+        auto pipelineDesc = nvrhi::ComputePipelineDesc()
+            .setComputeShader(m_desc.feedbackCompactionShader)
+            .addBindingLayout(m_compactionBindingLayout);
+
+        m_compactionPipeline = m_device->createComputePipeline(pipelineDesc);
+        if (!m_compactionPipeline)
+            return false;
+
+        m_maxFeedbackRequests = m_desc.maxFeedbackRequests ? m_desc.maxFeedbackRequests : c_defaultMaxFeedbackRequests;
+        m_compactionWindow = std::min(c_minFeedbackRequestWindow, m_maxFeedbackRequests);
+        uint64_t const requestBufferSize = FEEDBACK_COMPACTION_HEADER_SIZE +
+            uint64_t(m_maxFeedbackRequests) * FEEDBACK_COMPACTION_REQUEST_SIZE;
+
+        nvrhi::BufferDesc bufferDesc = {};
+        bufferDesc.byteSize = requestBufferSize;
+        bufferDesc.canHaveUAVs = true;
+        bufferDesc.canHaveRawViews = true;
+        bufferDesc.initialState = nvrhi::ResourceStates::UnorderedAccess;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.debugName = "Feedback Request Buffer";
+        m_compactionRequestBuffer = m_device->createBuffer(bufferDesc);
+        if (!m_compactionRequestBuffer)
+            return false;
+
+        m_compactionReadbackBuffers.resize(m_numFramesInFlight);
+        m_compactionWindowPerFrame.resize(m_numFramesInFlight, 0);
+        for (auto& readbackBuffer : m_compactionReadbackBuffers)
+        {
+            bufferDesc = {};
+            bufferDesc.byteSize = requestBufferSize;
+            bufferDesc.cpuAccess = nvrhi::CpuAccessMode::Read;
+            bufferDesc.initialState = nvrhi::ResourceStates::CopyDest;
+            bufferDesc.debugName = "Feedback Request Readback Buffer";
+            readbackBuffer = m_device->createBuffer(bufferDesc);
+            if (!readbackBuffer)
+                return false;
+        }
+
+        return true;
     }
 
     FeedbackManagerImpl::~FeedbackManagerImpl()
@@ -41,7 +138,8 @@ namespace nvfeedback
 
     bool FeedbackManagerImpl::CreateTexture(const nvrhi::TextureDesc& desc, FeedbackTexture** ppTex)
     {
-        FeedbackTextureImpl* feedbackTexture = new FeedbackTextureImpl(desc, this, m_tiledTextureManager.get(), m_device, m_numFramesInFlight);
+        FeedbackTextureImpl* feedbackTexture = new FeedbackTextureImpl(desc, this, m_tiledTextureManager.get(), m_device,
+            m_numFramesInFlight, m_compactionPipeline != nullptr, m_minMipUpdatePipeline != nullptr);
         m_textures.push_back(feedbackTexture);
         m_texturesRingbuffer.push_back(feedbackTexture);
         *ppTex = feedbackTexture;
@@ -67,16 +165,16 @@ namespace nvfeedback
         
         m_texturesRingbuffer.erase(std::remove(m_texturesRingbuffer.begin(), m_texturesRingbuffer.end(), feedbackTexture), m_texturesRingbuffer.end());
 
+        // Keep the positions of the other textures, the compacted feedback requests refer to them
         for (auto& vec : m_texturesToReadback)
-        {
-            auto it = std::find(vec.begin(), vec.end(), feedbackTexture);
-            if (it != vec.end())
-                vec.erase(it);
-        }
+            std::replace(vec.begin(), vec.end(), feedbackTexture, static_cast<FeedbackTextureImpl*>(nullptr));
 
         auto it = std::find(m_minMipDirtyTextures.begin(), m_minMipDirtyTextures.end(), feedbackTexture);
         if (it != m_minMipDirtyTextures.end())
             m_minMipDirtyTextures.erase(it);
+
+        m_tileRequests.erase(m_tileRequests.lower_bound({ feedbackTexture, 0 }),
+            m_tileRequests.upper_bound({ feedbackTexture, UINT32_MAX }));
     }
 
     void FeedbackManagerImpl::UpdateTextureRingBufferState(FeedbackTextureImpl* pTex, bool includeInRingBuffer)
@@ -97,28 +195,70 @@ namespace nvfeedback
         m_timerBeginFrame.Begin();
 
         m_frameIndex = config.frameIndex % m_numFramesInFlight;
+        ++m_frameCounter;
 
         m_updateConfigThisFrame = config;
 
+        // Derive the standby target and heap limit from the memory budget.
+        // Tiles that are used by the feedback have to stay resident, so the budget left after them goes to standby tiles.
+        uint64_t const tileSizeInBytes = c_tileSizeInBytes;
+        uint64_t const heapSizeInBytes = uint64_t(m_desc.heapSizeInTiles) * tileSizeInBytes;
+        uint32_t numExtraStandbyTiles = config.numExtraStandbyTiles;
+        uint32_t maxHeaps = UINT32_MAX;
+        bool overBudget = false;
+        if (config.memoryBudgetInBytes != 0)
+        {
+            uint64_t const budgetTiles = config.memoryBudgetInBytes / tileSizeInBytes;
+            uint64_t const activeTiles = m_statsLastFrame.tilesAllocated -
+                std::min(m_statsLastFrame.tilesStandby, m_statsLastFrame.tilesAllocated);
+            uint64_t const standbyBudget = (budgetTiles > activeTiles) ? budgetTiles - activeTiles : 0;
+            numExtraStandbyTiles = uint32_t(std::min(uint64_t(numExtraStandbyTiles), standbyBudget));
+
+            maxHeaps = uint32_t(std::max(config.memoryBudgetInBytes / heapSizeInBytes, uint64_t(1)));
+            overBudget = m_heapAllocator->GetTotalAllocatedBytes() > config.memoryBudgetInBytes;
+        }
+
         rtxts::TiledTextureManagerConfig tiledTextureManagerConfig = {};
-        tiledTextureManagerConfig.numExtraStandbyTiles = config.numExtraStandbyTiles;
+        tiledTextureManagerConfig.numExtraStandbyTiles = numExtraStandbyTiles;
         m_tiledTextureManager->SetConfig(tiledTextureManagerConfig);
 
         auto& readbackTextures = m_texturesToReadback[m_frameIndex];
+        m_feedbackReadbackBytes = 0;
+        m_feedbackRequests = 0;
+        m_minMipTexelsUpdated = 0;
         if (!readbackTextures.empty())
         {
-            float timeStamp = float(GetTickCount64()) / 1000.0f;
+            if (m_compactionPipeline)
+                ReadCompactedFeedback(readbackTextures);
+
+            float timeStamp = float(GetTimestamp());
             uint32_t texturesNum = uint32_t(readbackTextures.size());
             for (uint32_t iReadbackTexture = 0; iReadbackTexture < texturesNum; ++iReadbackTexture)
             {
                 FeedbackTextureImpl* readbackTexture = readbackTextures[iReadbackTexture];
-                uint8_t* pReadbackData = (uint8_t*)m_device->mapBuffer(readbackTexture->GetFeedbackResolveBuffer(m_frameIndex), nvrhi::CpuAccessMode::Read);
+                if (!readbackTexture)
+                    continue;
 
+                // With compaction, the texture keeps the latest feedback updated from the requests.
+                // The whole min mip map is still passed to the tiled texture manager, which refreshes
+                // the timestamps of all requested tiles.
                 rtxts::SamplerFeedbackDesc samplerFeedbackDesc = {};
-                samplerFeedbackDesc.pMinMipData = (uint8_t*)(pReadbackData);
-                m_tiledTextureManager->UpdateWithSamplerFeedback(readbackTexture->GetTiledTextureId(), samplerFeedbackDesc, timeStamp, m_updateConfigThisFrame.tileTimeoutSeconds);
+                if (m_compactionPipeline)
+                {
+                    samplerFeedbackDesc.pMinMipData = (uint8_t*)readbackTexture->GetCompactedMinMipData();
+                    m_tiledTextureManager->UpdateWithSamplerFeedback(readbackTexture->GetTiledTextureId(), samplerFeedbackDesc, timeStamp, m_updateConfigThisFrame.tileTimeoutSeconds);
+                }
+                else
+                {
+                    nvrhi::IBuffer* resolveBuffer = readbackTexture->GetFeedbackResolveBuffer(m_frameIndex);
+                    void* pReadbackData = m_device->mapBuffer(resolveBuffer, nvrhi::CpuAccessMode::Read);
 
-                m_device->unmapBuffer(readbackTexture->GetFeedbackResolveBuffer(m_frameIndex));
+                    samplerFeedbackDesc.pMinMipData = (uint8_t*)readbackTexture->GetMinMipData(pReadbackData);
+                    m_tiledTextureManager->UpdateWithSamplerFeedback(readbackTexture->GetTiledTextureId(), samplerFeedbackDesc, timeStamp, m_updateConfigThisFrame.tileTimeoutSeconds);
+
+                    m_device->unmapBuffer(resolveBuffer);
+                    m_feedbackReadbackBytes += resolveBuffer->getDesc().byteSize;
+                }
 
                 // If this is a primary texture, make followers match its state
                 if (readbackTexture->IsPrimaryTexture())
@@ -155,38 +295,73 @@ namespace nvfeedback
             {
                 if (m_updateConfigThisFrame.maxTexturesToUpdate > 0 && updatesLeft == 0)
                     break;
-                commandList->clearSamplerFeedbackTexture(feedbackTexture->GetSamplerFeedbackTexture());
+                feedbackTexture->ClearFeedback(commandList);
                 readbackTextures.push_back(feedbackTexture);
                 updatesLeft--;
             }
         }
 
-        // Trim standby tiles if requested
-        if (m_updateConfigThisFrame.trimStandbyTiles)
+        // Trim standby tiles if requested, or if there are more of them than the memory budget allows.
+        // Trimming evicts the tiles that have been in standby for the longest time first.
+        if (m_updateConfigThisFrame.trimStandbyTiles ||
+            (config.memoryBudgetInBytes != 0 && m_statsLastFrame.tilesStandby > numExtraStandbyTiles))
         {
             m_tiledTextureManager->TrimStandbyTiles();
         }
 
+        m_heapAllocator->BeginFrame(m_frameIndex);
+
         // Now check how many heaps the tiled texture manager needs
-        uint32_t numRequiredHeaps = m_tiledTextureManager->GetNumDesiredHeaps();
-        if (numRequiredHeaps > m_heapAllocator->GetNumHeaps())
+        uint32_t numRequiredHeaps = std::min(m_tiledTextureManager->GetNumDesiredHeaps(), maxHeaps);
+        uint32_t numHeaps = m_heapAllocator->GetNumHeaps();
+        m_poolIdleFrames = (numRequiredHeaps > numHeaps) ? 0 : m_poolIdleFrames + 1;
+        if (overBudget)
         {
+            // Pooled heaps count toward the budget, give them up first
+            m_heapAllocator->TrimPool(true);
+        }
+        else if (m_poolIdleFrames > m_desc.heapReleaseDelayFrames)
+        {
+            // Once the demand has settled, release the heaps that were pooled for it and are no longer needed.
+            // The reserve is released too when empty heaps are released.
+            m_heapAllocator->TrimPool(m_updateConfigThisFrame.releaseEmptyHeaps);
+        }
+        m_heapAllocator->SetPendingDemand(numRequiredHeaps > numHeaps ? numRequiredHeaps - numHeaps : 0, maxHeaps);
+        if (numRequiredHeaps > numHeaps)
+        {
+            // With async heap creation, only the heaps that are ready are added. The tiles that don't fit
+            // stay requested and get allocated on a later frame.
             while (m_heapAllocator->GetNumHeaps() < numRequiredHeaps)
             {
                 uint32_t heapId;
-                m_heapAllocator->AllocateHeap(heapId);
+                if (!m_heapAllocator->AllocateHeap(heapId))
+                    break;
                 m_tiledTextureManager->AddHeap(heapId);
             }
+            m_emptyHeapFrames.clear();
         }
-        else if (m_updateConfigThisFrame.releaseEmptyHeaps)
+        else if (m_updateConfigThisFrame.releaseEmptyHeaps || overBudget)
         {
+            // Only release the heaps that have been empty for a while, so that they are not thrashed
+            // when residency oscillates, unless the memory budget is exceeded
             std::vector<uint32_t> emptyHeaps;
             m_tiledTextureManager->GetEmptyHeaps(emptyHeaps);
+            std::map<uint32_t, uint32_t> emptyHeapFrames;
             for (auto& heapId : emptyHeaps)
             {
-                m_tiledTextureManager->RemoveHeap(heapId);
-                m_heapAllocator->ReleaseHeap(heapId, m_frameIndex);
+                auto it = m_emptyHeapFrames.find(heapId);
+                uint32_t const framesEmpty = (it != m_emptyHeapFrames.end()) ? it->second + 1 : 1;
+                if (framesEmpty > m_desc.heapReleaseDelayFrames || overBudget)
+                {
+                    m_tiledTextureManager->RemoveHeap(heapId);
+                    m_heapAllocator->ReleaseHeap(heapId, m_frameIndex);
+                }
+                else
+                {
+                    emptyHeapFrames[heapId] = framesEmpty;
+                }
             }
+            m_emptyHeapFrames.swap(emptyHeapFrames);
         }
 
         // Now let the tiled texture manager allocate
@@ -196,6 +371,7 @@ namespace nvfeedback
         // TODO: The current code does not merge unmapping and mapping tiles for the same textures. It would be more optimal.
         std::vector<uint32_t> tilesRequestedNew;
         std::vector<uint32_t> tilesToUnmap;
+        double const requestTimestamp = GetTimestamp();
         for (auto& feedbackTexture : m_textures)
         {
             // Unmap tiles
@@ -218,6 +394,9 @@ namespace nvfeedback
                 uint32_t tilesProcessedNum = 0;
                 for (auto& tileIndex : tilesToUnmap)
                 {
+                    // Tiles released before the application mapped them don't contribute to the latency
+                    m_tileRequests.erase({ feedbackTexture, tileIndex });
+
                     // Process only unpacked tiles
                     nvrhi::TiledTextureCoordinate& tiledTextureCoordinate = tiledTextureCoordinates[tilesProcessedNum];
                     tiledTextureCoordinate.mipLevel = tilesCoordinates[tileIndex].mipLevel;
@@ -246,13 +425,20 @@ namespace nvfeedback
                     assert(std::find(update.tileIndices.begin(), update.tileIndices.end(), tileIndex) == update.tileIndices.end());
 #endif
                     update.tileIndices.push_back(tileIndex);
+
+                    // Keep the time of the first request if the application has deferred mapping the tile
+                    m_tileRequests.try_emplace({ feedbackTexture, tileIndex }, TileRequest{ requestTimestamp, m_frameCounter });
                 }
                 results->textures.push_back(update);
             }
         }
 
-        // Defragmentation phase
-        if (m_updateConfigThisFrame.defragmentHeaps)
+        // Defragmentation phase, only when enough of the allocated heap space is free
+        uint64_t const heapTilesTotal = uint64_t(m_heapAllocator->GetNumHeaps()) * m_desc.heapSizeInTiles;
+        float const fragmentation = (heapTilesTotal != 0)
+            ? float(m_tiledTextureManager->GetStatistics().heapFreeTilesNum) / float(heapTilesTotal)
+            : 0.f;
+        if (m_updateConfigThisFrame.defragmentHeaps && fragmentation >= m_updateConfigThisFrame.defragmentThreshold)
         {
             // Defragment up to 16 tiles per frame
             const uint32_t numTiles = 16;
@@ -262,116 +448,368 @@ namespace nvfeedback
         m_timerBeginFrame.End();
     }
 
-    void FeedbackManagerImpl::UpdateTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesReady)
+    void FeedbackManagerImpl::MapTextureTiles(FeedbackTextureImpl* texture, std::vector<uint32_t> const& tileIndices,
+        nvrhi::CommandQueue queue)
     {
-        m_timerUpdateTileMappings.Begin();
+        uint32_t tiledTextureId = texture->GetTiledTextureId();
+        const auto& tilesCoordinates = m_tiledTextureManager->GetTileCoordinates(tiledTextureId);
+        const auto& tilesAllocations = m_tiledTextureManager->GetTileAllocations(tiledTextureId);
 
-        for (auto& texUpdate : tilesReady->textures)
+        std::map<nvrhi::HeapHandle, std::vector<uint32_t>> heapTilesMapping;
+        for (auto tileIndex : tileIndices)
         {
-            FeedbackTextureImpl* texture = dynamic_cast<FeedbackTextureImpl*>(texUpdate.texture);
-            m_minMipDirtyTextures.insert(texture);
+            nvrhi::HeapHandle heap = m_heapAllocator->GetHeapHandle(tilesAllocations[tileIndex].heapId);
+            if (heapTilesMapping.find(heap) == heapTilesMapping.end())
+                heapTilesMapping[heap] = std::vector<uint32_t>();
+            heapTilesMapping[heap].push_back(tileIndex);
+        }
 
-            uint32_t tiledTextureId = texture->GetTiledTextureId();
-            m_tiledTextureManager->UpdateTilesMapping(tiledTextureId, texUpdate.tileIndices);
+        // Now loop heaps
+        for (auto& pair : heapTilesMapping)
+        {
+            nvrhi::HeapHandle heap = pair.first;
+            auto& heapTiles = pair.second;
+            uint32_t numTiles = (uint32_t)heapTiles.size();
 
-            const auto& tilesCoordinates = m_tiledTextureManager->GetTileCoordinates(tiledTextureId);
-            const auto& tilesAllocations = m_tiledTextureManager->GetTileAllocations(tiledTextureId);
+            std::vector<nvrhi::TiledTextureCoordinate> tiledTextureCoordinates;
+            std::vector<nvrhi::TiledTextureRegion> tiledTextureRegions;
+            std::vector<uint64_t> byteOffsets;
 
-            std::map<nvrhi::HeapHandle, std::vector<uint32_t>> heapTilesMapping;
-            for (auto tileIndex : texUpdate.tileIndices)
+            for (uint32_t i = 0; i < numTiles; i++)
             {
-                nvrhi::HeapHandle heap = m_heapAllocator->GetHeapHandle(tilesAllocations[tileIndex].heapId);
-                if (heapTilesMapping.find(heap) == heapTilesMapping.end())
-                    heapTilesMapping[heap] = std::vector<uint32_t>();
-                heapTilesMapping[heap].push_back(tileIndex);
+                uint32_t tileIndex = heapTiles[i];
+
+                nvrhi::TiledTextureCoordinate tiledTextureCoordinate = {};
+                tiledTextureCoordinate.mipLevel = tilesCoordinates[tileIndex].mipLevel;
+                tiledTextureCoordinate.x = tilesCoordinates[tileIndex].x;
+                tiledTextureCoordinate.y = tilesCoordinates[tileIndex].y;
+                tiledTextureCoordinate.z = 0;
+                tiledTextureCoordinates.push_back(tiledTextureCoordinate);
+
+                nvrhi::TiledTextureRegion tiledTextureRegion = {};
+                tiledTextureRegion.tilesNum = 1;
+                tiledTextureRegions.push_back(tiledTextureRegion);
+
+                byteOffsets.push_back(tilesAllocations[tileIndex].heapTileIndex * c_tileSizeInBytes);
             }
 
-            // Now loop heaps
-            for (auto& pair : heapTilesMapping)
-            {
-                nvrhi::HeapHandle heap = pair.first;
-                auto& heapTiles = pair.second;
-                uint32_t numTiles = (uint32_t)heapTiles.size();
+            nvrhi::TextureTilesMapping textureTilesMapping = {};
+            textureTilesMapping.numTextureRegions = (uint32_t)tiledTextureCoordinates.size();
+            textureTilesMapping.tiledTextureCoordinates = tiledTextureCoordinates.data();
+            textureTilesMapping.tiledTextureRegions = tiledTextureRegions.data();
+            textureTilesMapping.byteOffsets = byteOffsets.data();
+            textureTilesMapping.heap = heap;
 
-                std::vector<nvrhi::TiledTextureCoordinate> tiledTextureCoordinates;
-                std::vector<nvrhi::TiledTextureRegion> tiledTextureRegions;
-                std::vector<uint64_t> byteOffsets;
+            m_device->updateTextureTileMappings(texture->GetReservedTexture(), &textureTilesMapping, 1, queue);
+        }
+    }
 
-                for (UINT i = 0; i < numTiles; i++)
-                {
-                    uint32_t tileIndex = heapTiles[i];
+    void FeedbackManagerImpl::WriteDirtyMinMipTextures(nvrhi::ICommandList* commandList)
+    {
+        if (m_minMipDirtyTextures.empty())
+            return;
 
-                    nvrhi::TiledTextureCoordinate tiledTextureCoordinate = {};
-                    tiledTextureCoordinate.mipLevel = tilesCoordinates[tileIndex].mipLevel;
-                    tiledTextureCoordinate.x = tilesCoordinates[tileIndex].x;
-                    tiledTextureCoordinate.y = tilesCoordinates[tileIndex].y;
-                    tiledTextureCoordinate.z = 0;
-                    tiledTextureCoordinates.push_back(tiledTextureCoordinate);
+        struct TextureUpdate
+        {
+            FeedbackTextureImpl* texture;
+            uint32_t width;
+            uint32_t firstUpdate;
+            uint32_t numUpdates;
+            std::vector<uint8_t> minMipData; // Replaces the cache once the update is recorded
+        };
+
+        // Compare the MinMip data of the dirty textures with their contents on the GPU. Textures that didn't change
+        // are skipped. With the update shader, the changed texels are collected into m_minMipUpdates, unless most
+        // of the texture changed; the other textures are uploaded whole.
+        std::vector<FeedbackTextureImpl*> fullUploads;
+        std::vector<TextureUpdate> partialUpdates;
+        std::vector<uint8_t> minMipData;
+        m_minMipUpdates.clear();
+        for (auto& texture : m_minMipDirtyTextures)
+        {
+            rtxts::TextureDesc desc = m_tiledTextureManager->GetTextureDesc(texture->GetTiledTextureId(), rtxts::TextureTypes::eMinMipTexture);
+            uint32_t const numTexels = desc.textureOrMipRegionWidth * desc.textureOrMipRegionHeight;
+            minMipData.resize(numTexels);
+            m_tiledTextureManager->WriteMinMipData(texture->GetTiledTextureId(), minMipData.data());
 
-                    nvrhi::TiledTextureRegion tiledTextureRegion = {};
-                    tiledTextureRegion.tilesNum = 1;
-                    tiledTextureRegions.push_back(tiledTextureRegion);
+            std::vector<uint8_t>& cache = texture->GetMinMipCache();
+            if (cache == minMipData)
+                continue;
 
-                    byteOffsets.push_back(tilesAllocations[tileIndex].heapTileIndex * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+            if (m_minMipUpdatePipeline && cache.size() == numTexels)
+            {
+                uint32_t const firstUpdate = uint32_t(m_minMipUpdates.size());
+                for (uint32_t texelIndex = 0; texelIndex < numTexels; ++texelIndex)
+                {
+                    if (cache[texelIndex] != minMipData[texelIndex])
+                        m_minMipUpdates.push_back((texelIndex << 8) | minMipData[texelIndex]);
                 }
 
-                nvrhi::TextureTilesMapping textureTilesMapping = {};
-                textureTilesMapping.numTextureRegions = (uint32_t)tiledTextureCoordinates.size();
-                textureTilesMapping.tiledTextureCoordinates = tiledTextureCoordinates.data();
-                textureTilesMapping.tiledTextureRegions = tiledTextureRegions.data();
-                textureTilesMapping.byteOffsets = byteOffsets.data();
-                textureTilesMapping.heap = heap;
+                uint32_t const numUpdates = uint32_t(m_minMipUpdates.size()) - firstUpdate;
+                if (numUpdates <= numTexels / 2)
+                {
+                    partialUpdates.push_back({ texture, desc.textureOrMipRegionWidth, firstUpdate, numUpdates,
+                        std::move(minMipData) });
+                    m_minMipTexelsUpdated += numUpdates;
+                    continue;
+                }
+                m_minMipUpdates.resize(firstUpdate);
+            }
+
+            fullUploads.push_back(texture);
+            cache.swap(minMipData);
+            m_minMipTexelsUpdated += numTexels;
+        }
+        m_minMipDirtyTextures.clear();
 
-                m_device->updateTextureTileMappings(texture->GetReservedTexture(), &textureTilesMapping, 1);
+        if (fullUploads.empty() && partialUpdates.empty())
+            return;
+
+        if (!m_minMipUpdates.empty())
+        {
+            uint64_t const updateBufferSize = m_minMipUpdates.size() * sizeof(uint32_t);
+            if (!m_minMipUpdateBuffer || m_minMipUpdateBuffer->getDesc().byteSize < updateBufferSize)
+            {
+                nvrhi::BufferDesc bufferDesc = {};
+                bufferDesc.byteSize = std::max(updateBufferSize, m_minMipUpdateBuffer
+                    ? m_minMipUpdateBuffer->getDesc().byteSize * 2 : uint64_t(65536));
+                bufferDesc.canHaveRawViews = true;
+                bufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+                bufferDesc.keepInitialState = true;
+                bufferDesc.debugName = "MinMip Update Buffer";
+                m_minMipUpdateBuffer = m_device->createBuffer(bufferDesc);
+
+                // The binding sets refer to the old buffer
+                for (auto& texture : m_textures)
+                    texture->GetMinMipUpdateBindingSet() = nullptr;
             }
         }
 
-        if (!m_minMipDirtyTextures.empty())
+        // Update the caches only for the textures that are actually going to be written. If a binding set
+        // can't be created, upload the texture whole instead: with the cache already updated, the next
+        // comparison would not see the texels that were never written.
+        for (auto it = partialUpdates.begin(); it != partialUpdates.end(); )
         {
-            const bool useAutomaticBarriers = false;
-            commandList->setEnableAutomaticBarriers(useAutomaticBarriers);
-            if (!useAutomaticBarriers)
+            nvrhi::BindingSetHandle& bindingSet = it->texture->GetMinMipUpdateBindingSet();
+            if (!bindingSet && m_minMipUpdateBuffer)
             {
-                for (auto& feedbackTexture : m_minMipDirtyTextures)
-                    commandList->setTextureState(feedbackTexture->GetMinMipTexture(), nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
+                auto bindingSetDesc = nvrhi::BindingSetDesc()
+                    .addItem(nvrhi::BindingSetItem::PushConstants(MINMIP_UPDATE_BINDING_CONSTANTS, sizeof(MinMipUpdateConstants)))
+                    .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(MINMIP_UPDATE_BINDING_UPDATES, m_minMipUpdateBuffer))
+                    .addItem(nvrhi::BindingSetItem::Texture_UAV(MINMIP_UPDATE_BINDING_MINMIP, it->texture->GetMinMipTexture()));
+
+                bindingSet = m_device->createBindingSet(bindingSetDesc, m_minMipUpdateBindingLayout);
             }
 
-            std::vector<uint8_t> minMipData(4096);
-            std::vector<uint8_t> uploadData(4096 * 4);
-            for (auto& texture : m_minMipDirtyTextures)
+            it->texture->GetMinMipCache().swap(it->minMipData);
+            if (bindingSet)
             {
-                m_tiledTextureManager->WriteMinMipData(texture->GetTiledTextureId(), minMipData.data());
-                rtxts::TextureDesc desc = m_tiledTextureManager->GetTextureDesc(texture->GetTiledTextureId(), rtxts::TextureTypes::eMinMipTexture);
-                uint32_t rowPitch = (desc.textureOrMipRegionWidth * sizeof(float) + 0xFF) & ~0xFF;
+                ++it;
+                continue;
+            }
 
-                uint8_t* pUploadData = uploadData.data();
-                for (uint32_t y = 0; y < desc.textureOrMipRegionHeight; ++y)
-                {
-                    float* pDataFloat = reinterpret_cast<float*>(pUploadData);
-                    for (uint32_t x = 0; x < desc.textureOrMipRegionWidth; ++x)
-                        pDataFloat[x] = minMipData[y * desc.textureOrMipRegionWidth + x];
+            fullUploads.push_back(it->texture);
+            m_minMipTexelsUpdated += uint32_t(it->texture->GetMinMipCache().size()) - it->numUpdates;
+            it = partialUpdates.erase(it);
+        }
 
-                    pUploadData += rowPitch;
-                }
+        const bool useAutomaticBarriers = false;
+        commandList->setEnableAutomaticBarriers(useAutomaticBarriers);
+        if (!useAutomaticBarriers)
+        {
+            for (auto& feedbackTexture : fullUploads)
+                commandList->setTextureState(feedbackTexture->GetMinMipTexture(), nvrhi::AllSubresources, nvrhi::ResourceStates::CopyDest);
+            for (auto& update : partialUpdates)
+                commandList->setTextureState(update.texture->GetMinMipTexture(), nvrhi::AllSubresources, nvrhi::ResourceStates::UnorderedAccess);
+            if (!partialUpdates.empty())
+                commandList->setBufferState(m_minMipUpdateBuffer, nvrhi::ResourceStates::CopyDest);
+            commandList->commitBarriers();
+        }
 
-                commandList->writeTexture(texture->GetMinMipTexture(), 0, 0, uploadData.data(), rowPitch);
+        std::vector<uint8_t> uploadData;
+        for (auto& texture : fullUploads)
+        {
+            rtxts::TextureDesc desc = m_tiledTextureManager->GetTextureDesc(texture->GetTiledTextureId(), rtxts::TextureTypes::eMinMipTexture);
+            uint32_t rowPitch = (desc.textureOrMipRegionWidth * sizeof(float) + 0xFF) & ~0xFF;
+            uploadData.resize(size_t(rowPitch) * desc.textureOrMipRegionHeight);
+            std::vector<uint8_t> const& cache = texture->GetMinMipCache();
+
+            uint8_t* pUploadData = uploadData.data();
+            for (uint32_t y = 0; y < desc.textureOrMipRegionHeight; ++y)
+            {
+                float* pDataFloat = reinterpret_cast<float*>(pUploadData);
+                for (uint32_t x = 0; x < desc.textureOrMipRegionWidth; ++x)
+                    pDataFloat[x] = cache[y * desc.textureOrMipRegionWidth + x];
+
+                pUploadData += rowPitch;
             }
 
+            commandList->writeTexture(texture->GetMinMipTexture(), 0, 0, uploadData.data(), rowPitch);
+        }
+
+        if (!partialUpdates.empty())
+        {
+            commandList->writeBuffer(m_minMipUpdateBuffer, m_minMipUpdates.data(), m_minMipUpdates.size() * sizeof(uint32_t));
             if (!useAutomaticBarriers)
             {
-                for (auto& feedbackTexture : m_minMipDirtyTextures)
-                    commandList->setTextureState(feedbackTexture->GetMinMipTexture(), nvrhi::AllSubresources, nvrhi::ResourceStates::ShaderResource);
+                commandList->setBufferState(m_minMipUpdateBuffer, nvrhi::ResourceStates::ShaderResource);
+                commandList->commitBarriers();
             }
 
-            m_minMipDirtyTextures.clear();
+            for (auto& update : partialUpdates)
+            {
+                MinMipUpdateConstants constants = {};
+                constants.firstUpdate = update.firstUpdate;
+                constants.numUpdates = update.numUpdates;
+                constants.textureWidth = update.width;
+
+                auto state = nvrhi::ComputeState()
+                    .setPipeline(m_minMipUpdatePipeline)
+                    .addBindingSet(update.texture->GetMinMipUpdateBindingSet());
+                commandList->setComputeState(state);
+                commandList->setPushConstants(&constants, sizeof(constants));
+                commandList->dispatch((update.numUpdates + MINMIP_UPDATE_GROUP_SIZE - 1) / MINMIP_UPDATE_GROUP_SIZE);
+            }
+        }
 
-            // Restore the automatic barriers mode
-            commandList->setEnableAutomaticBarriers(true);
+        if (!useAutomaticBarriers)
+        {
+            for (auto& feedbackTexture : fullUploads)
+                commandList->setTextureState(feedbackTexture->GetMinMipTexture(), nvrhi::AllSubresources, nvrhi::ResourceStates::ShaderResource);
+            for (auto& update : partialUpdates)
+                commandList->setTextureState(update.texture->GetMinMipTexture(), nvrhi::AllSubresources, nvrhi::ResourceStates::ShaderResource);
         }
 
+        // Restore the automatic barriers mode
+        commandList->setEnableAutomaticBarriers(true);
+    }
+
+    void FeedbackManagerImpl::UpdateTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesReady)
+    {
+        m_timerUpdateTileMappings.Begin();
+
+        for (auto& texUpdate : tilesReady->textures)
+        {
+            FeedbackTextureImpl* texture = dynamic_cast<FeedbackTextureImpl*>(texUpdate.texture);
+            m_minMipDirtyTextures.insert(texture);
+
+            m_tiledTextureManager->UpdateTilesMapping(texture->GetTiledTextureId(), texUpdate.tileIndices);
+
+            MapTextureTiles(texture, texUpdate.tileIndices, commandList->getDesc().queueType);
+            RecordTileLatencies(texture, texUpdate.tileIndices);
+        }
+
+        WriteDirtyMinMipTextures(commandList);
+
         m_timerUpdateTileMappings.End();
     }
 
+    void FeedbackManagerImpl::MapTiles(FeedbackTextureCollection* tilesToMap, nvrhi::CommandQueue queue)
+    {
+        m_timerUpdateTileMappings.Begin();
+
+        for (auto& texUpdate : tilesToMap->textures)
+        {
+            FeedbackTextureImpl* texture = dynamic_cast<FeedbackTextureImpl*>(texUpdate.texture);
+            MapTextureTiles(texture, texUpdate.tileIndices, queue);
+        }
+
+        m_timerUpdateTileMappings.End();
+    }
+
+    void FeedbackManagerImpl::CommitTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesResident)
+    {
+        for (auto& texUpdate : tilesResident->textures)
+        {
+            FeedbackTextureImpl* texture = dynamic_cast<FeedbackTextureImpl*>(texUpdate.texture);
+            m_minMipDirtyTextures.insert(texture);
+
+            m_tiledTextureManager->UpdateTilesMapping(texture->GetTiledTextureId(), texUpdate.tileIndices);
+            RecordTileLatencies(texture, texUpdate.tileIndices);
+        }
+
+        WriteDirtyMinMipTextures(commandList);
+    }
+
+    bool FeedbackManagerImpl::IsTileRequestPending(FeedbackTexture* texture, uint32_t tileIndex)
+    {
+        // The requests are removed when their tiles are mapped or unmapped, and when their texture is unregistered,
+        // so the texture pointer is only used as a key here and may refer to a destroyed texture
+        FeedbackTextureImpl* textureImpl = static_cast<FeedbackTextureImpl*>(texture);
+        return m_tileRequests.find({ textureImpl, tileIndex }) != m_tileRequests.end();
+    }
+
+    void FeedbackManagerImpl::RecordTileLatencies(FeedbackTextureImpl* texture, std::vector<uint32_t> const& tileIndices)
+    {
+        double const timestamp = GetTimestamp();
+        for (uint32_t tileIndex : tileIndices)
+        {
+            auto it = m_tileRequests.find({ texture, tileIndex });
+            if (it == m_tileRequests.end())
+                continue;
+
+            float const latencyMs = float((timestamp - it->second.timestamp) * 1000.0);
+            uint32_t const latencyFrames = m_frameCounter - it->second.frame;
+            m_tileRequests.erase(it);
+
+            if (m_tileLatencyMs.size() < c_tileLatencySampleCount)
+            {
+                m_tileLatencyMs.push_back(latencyMs);
+                m_tileLatencyFrames.push_back(latencyFrames);
+            }
+            else
+            {
+                m_tileLatencyMs[m_tileLatencyNext] = latencyMs;
+                m_tileLatencyFrames[m_tileLatencyNext] = latencyFrames;
+            }
+            m_tileLatencyNext = (m_tileLatencyNext + 1) % c_tileLatencySampleCount;
+            m_tileLatencyDirty = true;
+        }
+    }
+
+    void FeedbackManagerImpl::UpdateTileLatencyStats()
+    {
+        // Drop the requests that the application never mapped, they will be requested again if still needed
+        double const timestamp = GetTimestamp();
+        float const requestTimeout = std::max(m_updateConfigThisFrame.tileTimeoutSeconds, 1.f) * 2.f;
+        for (auto it = m_tileRequests.begin(); it != m_tileRequests.end(); )
+        {
+            if (timestamp - it->second.timestamp > requestTimeout)
+                it = m_tileRequests.erase(it);
+            else
+                ++it;
+        }
+
+        if (!m_tileLatencyDirty)
+            return;
+        m_tileLatencyDirty = false;
+
+        std::vector<float> sortedMs = m_tileLatencyMs;
+        std::vector<uint32_t> sortedFrames = m_tileLatencyFrames;
+        std::sort(sortedMs.begin(), sortedMs.end());
+        std::sort(sortedFrames.begin(), sortedFrames.end());
+
+        // Nearest-rank percentiles
+        size_t const count = sortedMs.size();
+        auto rank = [count](float percentile)
+        {
+            size_t const r = size_t(std::ceil(percentile * float(count)));
+            return std::clamp(r, size_t(1), count) - 1;
+        };
+
+        m_statsLastFrame.tileLatencySamples = uint32_t(count);
+        m_statsLastFrame.tileLatencyP50Ms = sortedMs[rank(0.50f)];
+        m_statsLastFrame.tileLatencyP95Ms = sortedMs[rank(0.95f)];
+        m_statsLastFrame.tileLatencyP99Ms = sortedMs[rank(0.99f)];
+        m_statsLastFrame.tileLatencyP50Frames = sortedFrames[rank(0.50f)];
+        m_statsLastFrame.tileLatencyP95Frames = sortedFrames[rank(0.95f)];
+        m_statsLastFrame.tileLatencyP99Frames = sortedFrames[rank(0.99f)];
+
+        std::fill(std::begin(m_statsLastFrame.tileLatencyHistogram), std::end(m_statsLastFrame.tileLatencyHistogram), 0);
+        for (uint32_t frames : m_tileLatencyFrames)
+            ++m_statsLastFrame.tileLatencyHistogram[std::min(frames, c_tileLatencyHistogramBins - 1)];
+    }
+
     void FeedbackManagerImpl::ResolveFeedback(nvrhi::ICommandList* commandList)
     {
         auto& readbackTextures = m_texturesToReadback[m_frameIndex];
@@ -383,25 +821,70 @@ namespace nvfeedback
 
         m_timerResolve.Begin();
 
+        if (m_compactionPipeline)
+        {
+            CompactFeedback(commandList, readbackTextures);
+            m_timerResolve.End();
+            return;
+        }
+
         const bool useAutomaticBarriers = false;
         commandList->setEnableAutomaticBarriers(useAutomaticBarriers);
 
         if (!useAutomaticBarriers)
         {
             for (auto& feedbackTexture : readbackTextures)
-                commandList->setSamplerFeedbackTextureState(feedbackTexture->GetSamplerFeedbackTexture(), nvrhi::ResourceStates::ResolveSource);
+            {
+                if (!feedbackTexture)
+                    continue;
+
+                if (feedbackTexture->GetSamplerFeedbackTexture())
+                {
+                    commandList->setSamplerFeedbackTextureState(feedbackTexture->GetSamplerFeedbackTexture(), nvrhi::ResourceStates::ResolveSource);
+                }
+                else
+                {
+                    commandList->setBufferState(feedbackTexture->GetFeedbackBuffer(), nvrhi::ResourceStates::CopySource);
+                    commandList->setBufferState(feedbackTexture->GetFeedbackResolveBuffer(m_frameIndex), nvrhi::ResourceStates::CopyDest);
+                }
+            }
+            commandList->commitBarriers();
         }
 
         {
             uint32_t textureNum = uint32_t(readbackTextures.size());
             for (uint32_t i = 0; i < textureNum; ++i)
-                commandList->decodeSamplerFeedbackTexture(readbackTextures[i]->GetFeedbackResolveBuffer(m_frameIndex), readbackTextures[i]->GetSamplerFeedbackTexture(), nvrhi::Format::R8_UINT);
+            {
+                FeedbackTextureImpl* feedbackTexture = readbackTextures[i];
+                if (!feedbackTexture)
+                    continue;
+
+                nvrhi::IBuffer* resolveBuffer = feedbackTexture->GetFeedbackResolveBuffer(m_frameIndex);
+                if (feedbackTexture->GetSamplerFeedbackTexture())
+                {
+                    commandList->decodeSamplerFeedbackTexture(resolveBuffer, feedbackTexture->GetSamplerFeedbackTexture(), nvrhi::Format::R8_UINT);
+                }
+                else
+                {
+                    // Skip the header, the resolve buffer only holds the per-region values
+                    commandList->copyBuffer(resolveBuffer, 0, feedbackTexture->GetFeedbackBuffer(), sizeof(FeedbackBufferHeader),
+                        resolveBuffer->getDesc().byteSize);
+                }
+            }
         }
 
         if (!useAutomaticBarriers)
         {
             for (auto& feedbackTexture : readbackTextures)
-                commandList->setSamplerFeedbackTextureState(feedbackTexture->GetSamplerFeedbackTexture(), nvrhi::ResourceStates::UnorderedAccess);
+            {
+                if (!feedbackTexture)
+                    continue;
+
+                if (feedbackTexture->GetSamplerFeedbackTexture())
+                    commandList->setSamplerFeedbackTextureState(feedbackTexture->GetSamplerFeedbackTexture(), nvrhi::ResourceStates::UnorderedAccess);
+                else
+                    commandList->setBufferState(feedbackTexture->GetFeedbackBuffer(), nvrhi::ResourceStates::UnorderedAccess);
+            }
         }
 
         // Restore the automatic barriers mode
@@ -410,6 +893,166 @@ namespace nvfeedback
         m_timerResolve.End();
     }
 
+    void FeedbackManagerImpl::CompactFeedback(nvrhi::ICommandList* commandList, std::vector<FeedbackTextureImpl*> const& readbackTextures)
+    {
+        commandList->setEnableAutomaticBarriers(false);
+
+        // Make the feedback readable by the compaction shader: decode the sampler feedback into buffers,
+        // and reset the request count
+        for (auto& feedbackTexture : readbackTextures)
+        {
+            if (!feedbackTexture)
+                continue;
+
+            if (feedbackTexture->GetSamplerFeedbackTexture())
+            {
+                commandList->setSamplerFeedbackTextureState(feedbackTexture->GetSamplerFeedbackTexture(), nvrhi::ResourceStates::ResolveSource);
+                commandList->setBufferState(feedbackTexture->GetFeedbackDecodeBuffer(), nvrhi::ResourceStates::ResolveDest);
+            }
+            else
+            {
+                commandList->setBufferState(feedbackTexture->GetFeedbackBuffer(), nvrhi::ResourceStates::ShaderResource);
+            }
+        }
+        commandList->setBufferState(m_compactionRequestBuffer, nvrhi::ResourceStates::CopyDest);
+        commandList->commitBarriers();
+
+        for (auto& feedbackTexture : readbackTextures)
+        {
+            if (feedbackTexture && feedbackTexture->GetSamplerFeedbackTexture())
+            {
+                commandList->decodeSamplerFeedbackTexture(feedbackTexture->GetFeedbackDecodeBuffer(),
+                    feedbackTexture->GetSamplerFeedbackTexture(), nvrhi::Format::R8_UINT);
+            }
+        }
+
+        uint32_t const requestHeader[FEEDBACK_COMPACTION_HEADER_SIZE / sizeof(uint32_t)] = {};
+        commandList->writeBuffer(m_compactionRequestBuffer, requestHeader, sizeof(requestHeader));
+
+        for (auto& feedbackTexture : readbackTextures)
+        {
+            if (!feedbackTexture)
+                continue;
+
+            if (feedbackTexture->GetSamplerFeedbackTexture())
+            {
+                commandList->setSamplerFeedbackTextureState(feedbackTexture->GetSamplerFeedbackTexture(), nvrhi::ResourceStates::UnorderedAccess);
+                commandList->setBufferState(feedbackTexture->GetFeedbackDecodeBuffer(), nvrhi::ResourceStates::ShaderResource);
+            }
+
+            // New textures start with no regions sampled, like their compacted min mip data
+            if (feedbackTexture->TakePreviousMinMipClear())
+            {
+                commandList->clearBufferUInt(feedbackTexture->GetPreviousMinMipBuffer(), 0xff);
+                commandList->setBufferState(feedbackTexture->GetPreviousMinMipBuffer(), nvrhi::ResourceStates::UnorderedAccess);
+            }
+        }
+        commandList->setBufferState(m_compactionRequestBuffer, nvrhi::ResourceStates::UnorderedAccess);
+        commandList->commitBarriers();
+
+        // Append the changed regions of all textures into the request buffer. The dispatches only share
+        // the request count, which is updated with atomics, so they don't need barriers between them.
+        uint32_t const window = m_compactionWindow;
+        for (uint32_t slot = 0; slot < uint32_t(readbackTextures.size()); ++slot)
+        {
+            FeedbackTextureImpl* feedbackTexture = readbackTextures[slot];
+            if (!feedbackTexture)
+                continue;
+
+            bool const useDecodeBuffer = feedbackTexture->GetSamplerFeedbackTexture() != nullptr;
+            nvrhi::BindingSetHandle& bindingSet = feedbackTexture->GetCompactionBindingSet();
+            if (!bindingSet)
+            {
+                auto bindingSetDesc = nvrhi::BindingSetDesc()
+                    .addItem(nvrhi::BindingSetItem::PushConstants(FEEDBACK_COMPACTION_BINDING_CONSTANTS, sizeof(FeedbackCompactionConstants)))
+                    .addItem(nvrhi::BindingSetItem::RawBuffer_SRV(FEEDBACK_COMPACTION_BINDING_FEEDBACK,
+                        useDecodeBuffer ? feedbackTexture->GetFeedbackDecodeBuffer() : feedbackTexture->GetFeedbackBuffer()))
+                    .addItem(nvrhi::BindingSetItem::RawBuffer_UAV(FEEDBACK_COMPACTION_BINDING_PREVIOUS, feedbackTexture->GetPreviousMinMipBuffer()))
+                    .addItem(nvrhi::BindingSetItem::RawBuffer_UAV(FEEDBACK_COMPACTION_BINDING_REQUESTS, m_compactionRequestBuffer));
+
+                bindingSet = m_device->createBindingSet(bindingSetDesc, m_compactionBindingLayout);
+                if (!bindingSet)
+                    continue;
+            }
+
+            FeedbackCompactionConstants constants = {};
+            constants.sourceOffset = useDecodeBuffer ? 0 : uint32_t(sizeof(FeedbackBufferHeader));
+            constants.sourceFormat = useDecodeBuffer ? FEEDBACK_COMPACTION_SOURCE_8BIT : FEEDBACK_COMPACTION_SOURCE_32BIT;
+            constants.numRegions = feedbackTexture->GetNumFeedbackRegions();
+            constants.textureSlot = slot;
+            constants.maxRequests = window;
+
+            auto state = nvrhi::ComputeState()
+                .setPipeline(m_compactionPipeline)
+                .addBindingSet(bindingSet);
+            commandList->setComputeState(state);
+            commandList->setPushConstants(&constants, sizeof(constants));
+            commandList->dispatch((constants.numRegions + FEEDBACK_COMPACTION_GROUP_SIZE - 1) / FEEDBACK_COMPACTION_GROUP_SIZE);
+        }
+
+        // Copy only the part of the request buffer that the window allows to be filled
+        nvrhi::IBuffer* readbackBuffer = m_compactionReadbackBuffers[m_frameIndex];
+        for (auto& feedbackTexture : readbackTextures)
+        {
+            if (feedbackTexture && !feedbackTexture->GetSamplerFeedbackTexture())
+                commandList->setBufferState(feedbackTexture->GetFeedbackBuffer(), nvrhi::ResourceStates::UnorderedAccess);
+        }
+        commandList->setBufferState(m_compactionRequestBuffer, nvrhi::ResourceStates::CopySource);
+        commandList->setBufferState(readbackBuffer, nvrhi::ResourceStates::CopyDest);
+        commandList->commitBarriers();
+
+        commandList->copyBuffer(readbackBuffer, 0, m_compactionRequestBuffer, 0,
+            FEEDBACK_COMPACTION_HEADER_SIZE + uint64_t(window) * FEEDBACK_COMPACTION_REQUEST_SIZE);
+        m_compactionWindowPerFrame[m_frameIndex] = window;
+
+        commandList->setEnableAutomaticBarriers(true);
+    }
+
+    void FeedbackManagerImpl::ReadCompactedFeedback(std::vector<FeedbackTextureImpl*> const& readbackTextures)
+    {
+        nvrhi::IBuffer* readbackBuffer = m_compactionReadbackBuffers[m_frameIndex];
+        uint32_t const window = m_compactionWindowPerFrame[m_frameIndex];
+        if (window == 0)
+            return; // The feedback of this frame was not resolved
+
+        uint8_t const* pReadbackData = static_cast<uint8_t const*>(m_device->mapBuffer(readbackBuffer, nvrhi::CpuAccessMode::Read));
+        if (!pReadbackData)
+            return;
+
+        uint32_t const totalRequests = *reinterpret_cast<uint32_t const*>(pReadbackData);
+        uint32_t const numRequests = std::min(totalRequests, window);
+        uint32_t const* pRequests = reinterpret_cast<uint32_t const*>(pReadbackData + FEEDBACK_COMPACTION_HEADER_SIZE);
+        for (uint32_t requestIndex = 0; requestIndex < numRequests; ++requestIndex)
+        {
+            uint32_t const textureSlot = pRequests[requestIndex * 2];
+            uint32_t const packedRegion = pRequests[requestIndex * 2 + 1];
+            if (textureSlot >= readbackTextures.size() || !readbackTextures[textureSlot])
+                continue;
+
+            readbackTextures[textureSlot]->SetCompactedMinMip(packedRegion >> 8, uint8_t(packedRegion & 0xff));
+        }
+
+        m_device->unmapBuffer(readbackBuffer);
+        m_compactionWindowPerFrame[m_frameIndex] = 0;
+
+        m_feedbackReadbackBytes = FEEDBACK_COMPACTION_HEADER_SIZE + uint64_t(window) * FEEDBACK_COMPACTION_REQUEST_SIZE;
+        m_feedbackRequests = totalRequests;
+
+        // Grow the window right away when the requests didn't fit, the dropped ones are reported again.
+        // Shrink it slowly when most of it is unused.
+        if (totalRequests > m_compactionWindow)
+        {
+            uint32_t newWindow = m_compactionWindow;
+            while (newWindow < totalRequests && newWindow < m_maxFeedbackRequests)
+                newWindow *= 2;
+            m_compactionWindow = std::min(newWindow, m_maxFeedbackRequests);
+        }
+        else if (totalRequests < m_compactionWindow / 8 && m_compactionWindow / 2 >= c_minFeedbackRequestWindow)
+        {
+            m_compactionWindow /= 2;
+        }
+    }
+
     void FeedbackManagerImpl::EndFrame()
     {
         // Cycle textures which were updated in this frame to the back of the ringbuffer
@@ -426,10 +1069,17 @@ namespace nvfeedback
 
         // Save stats
         m_statsLastFrame.heapAllocationInBytes = m_heapAllocator->GetTotalAllocatedBytes();
+        m_statsLastFrame.heapsPooled = m_heapAllocator->GetNumPooledHeaps();
+        m_statsLastFrame.heapsAllocated = m_heapAllocator->GetNumHeaps();
 
         m_statsLastFrame.cputimeBeginFrame = m_timerBeginFrame.GetTime();
         m_statsLastFrame.cputimeUpdateTileMappings = m_timerUpdateTileMappings.GetTime();
         m_statsLastFrame.cputimeResolve = m_timerResolve.GetTime();
+        m_statsLastFrame.feedbackReadbackBytes = m_feedbackReadbackBytes;
+        m_statsLastFrame.feedbackRequests = m_feedbackRequests;
+        m_statsLastFrame.minMipTexelsUpdated = m_minMipTexelsUpdated;
+
+        UpdateTileLatencyStats();
 
         {
             rtxts::Statistics statistics = m_tiledTextureManager->GetStatistics();
@@ -437,6 +1087,8 @@ namespace nvfeedback
             m_statsLastFrame.tilesTotal = statistics.totalTilesNum;
             m_statsLastFrame.heapTilesFree = statistics.heapFreeTilesNum;
             m_statsLastFrame.tilesStandby = statistics.standbyTilesNum;
+            m_statsLastFrame.bytesResident = uint64_t(statistics.allocatedTilesNum) * c_tileSizeInBytes;
+            m_statsLastFrame.memoryBudgetInBytes = m_updateConfigThisFrame.memoryBudgetInBytes;
         }
     }
 
@@ -451,63 +1103,188 @@ namespace nvfeedback
         return new FeedbackManagerImpl(device, desc);
     }
 
-    HeapAllocator::HeapAllocator(nvrhi::IDevice* device, uint64_t heapSizeInBytes, uint32_t framesInFlight)
+    HeapAllocator::HeapAllocator(nvrhi::IDevice* device, uint64_t heapSizeInBytes, uint32_t framesInFlight,
+        uint32_t numPooledHeaps, bool asyncCreation)
         : m_device(device)
         , m_framesInFlight(framesInFlight)
         , m_heapSizeInBytes(heapSizeInBytes)
-        , m_totalAllocatedBytes(0)
         , m_numHeaps(0)
+        , m_numPooledHeaps(numPooledHeaps)
+        , m_poolTarget(numPooledHeaps)
+        , m_asyncCreation(asyncCreation)
     {
+        if (m_asyncCreation)
+        {
+            m_thread = std::thread(&HeapAllocator::WorkerThread, this);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < m_numPooledHeaps; ++i)
+                m_pooledHeaps.push_back(CreateHeap());
+        }
+    }
+
+    HeapAllocator::~HeapAllocator()
+    {
+        if (m_thread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_exitThread = true;
+            }
+            m_condition.notify_all();
+            m_thread.join();
+        }
     }
 
-    void HeapAllocator::AllocateHeap(uint32_t& heapId)
+    HeapAllocator::Heap HeapAllocator::CreateHeap()
     {
         nvrhi::HeapDesc heapDesc = {};
         heapDesc.capacity = m_heapSizeInBytes;
         heapDesc.type = nvrhi::HeapType::DeviceLocal;
 
-        // TODO: Calling createHeap should ideally be called asynchronously to offload the critical path
-        nvrhi::HeapHandle heap = m_device->createHeap(heapDesc);
+        Heap result;
+        result.heap = m_device->createHeap(heapDesc);
 
         nvrhi::BufferDesc bufferDesc = {};
         bufferDesc.byteSize = m_heapSizeInBytes;
         bufferDesc.isVirtual = true;
         bufferDesc.initialState = nvrhi::ResourceStates::CopySource;
         bufferDesc.keepInitialState = true;
-        nvrhi::BufferHandle buffer = m_device->createBuffer(bufferDesc);
+        result.buffer = m_device->createBuffer(bufferDesc);
+
+        m_device->bindBufferMemory(result.buffer, result.heap, 0);
+
+        return result;
+    }
+
+    void HeapAllocator::WorkerThread()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_condition.wait(lock, [this]()
+            {
+                return m_exitThread || m_pooledHeaps.size() < m_poolTarget;
+            });
+
+            if (m_exitThread)
+                return;
 
-        m_device->bindBufferMemory(buffer, heap, 0);
+            // Create the heap without holding the lock so that the render thread can take the ready heaps.
+            // Heap and virtual buffer creation doesn't use command lists and is safe to do concurrently.
+            lock.unlock();
+            Heap heap = CreateHeap();
+            lock.lock();
+
+            m_pooledHeaps.push_back(heap);
+        }
+    }
+
+    bool HeapAllocator::AllocateHeap(uint32_t& heapId)
+    {
+        Heap heap;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_pooledHeaps.empty())
+            {
+                heap = m_pooledHeaps.back();
+                m_pooledHeaps.pop_back();
+            }
+        }
+        m_condition.notify_one();
+
+        if (!heap.heap)
+        {
+            if (m_asyncCreation)
+                return false;
+
+            heap = CreateHeap();
+        }
 
         if (m_freeHeapIds.empty())
         {
             heapId = (uint32_t)m_heaps.size();
             m_heaps.push_back(heap);
-            m_buffers.push_back(buffer);
         }
         else
         {
             heapId = m_freeHeapIds.back();
             m_freeHeapIds.pop_back();
             m_heaps[heapId] = heap;
-            m_buffers[heapId] = buffer;
         }
 
-        m_totalAllocatedBytes += m_heapSizeInBytes;
         m_numHeaps++;
+        return true;
     }
 
     void HeapAllocator::ReleaseHeap(uint32_t heapId, uint32_t frameIndex)
     {
         m_freeHeapIds.push_back(heapId);
 
+        // The frames in flight may still access the heap through its old tile mappings, and the unmapping
+        // runs on another queue. So the heap can't be mapped again until numFramesInFlight frames have passed,
+        // then BeginFrame either returns it to the pool or destroys it.
         uint32_t framesBucket = frameIndex % m_framesInFlight;
-        m_buffersToRelease[framesBucket].push_back(m_buffers[heapId]);
         m_heapsToRelease[framesBucket].push_back(m_heaps[heapId]);
 
-        m_heaps[heapId] = nullptr;
-        m_buffers[heapId] = nullptr;
-
-        m_totalAllocatedBytes -= m_heapSizeInBytes;
+        m_heaps[heapId] = Heap();
         m_numHeaps--;
     }
+
+    void HeapAllocator::TrimPool(bool releaseReserve)
+    {
+        // Pooled heaps are not referenced by any work in flight, see ReleaseHeap, so they are destroyed right away
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (releaseReserve)
+        {
+            m_reserveReleased = true;
+            m_poolTarget = 0;
+        }
+        if (m_pooledHeaps.size() > m_poolTarget)
+            m_pooledHeaps.resize(m_poolTarget);
+    }
+
+    void HeapAllocator::SetPendingDemand(uint32_t numHeaps, uint32_t maxHeaps)
+    {
+        // Don't let the pool grow beyond the total number of heaps allowed
+        uint32_t const maxPooledHeaps = (maxHeaps > m_numHeaps) ? maxHeaps - m_numHeaps : 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // The reserve comes back with the next demand after TrimPool released it
+            if (numHeaps > 0)
+                m_reserveReleased = false;
+            uint32_t const reserve = m_reserveReleased ? 0 : m_numPooledHeaps;
+            m_poolTarget = std::min(reserve + numHeaps, maxPooledHeaps);
+        }
+        m_condition.notify_one();
+    }
+
+    void HeapAllocator::BeginFrame(uint32_t frameIndex)
+    {
+        // The heaps in this bucket were released numFramesInFlight frames ago and are not used by the GPU anymore.
+        // Keep them in the pool if the pool is not full, and destroy the rest.
+        uint32_t framesBucket = frameIndex % m_framesInFlight;
+        std::vector<Heap>& retiredHeaps = m_heapsToRelease[framesBucket];
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (!retiredHeaps.empty() && m_pooledHeaps.size() < m_poolTarget)
+            {
+                m_pooledHeaps.push_back(retiredHeaps.back());
+                retiredHeaps.pop_back();
+            }
+        }
+        retiredHeaps.clear();
+    }
+
+    uint64_t HeapAllocator::GetTotalAllocatedBytes()
+    {
+        return uint64_t(m_numHeaps + GetNumPooledHeaps()) * m_heapSizeInBytes;
+    }
+
+    uint32_t HeapAllocator::GetNumPooledHeaps()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return uint32_t(m_pooledHeaps.size());
+    }
 }
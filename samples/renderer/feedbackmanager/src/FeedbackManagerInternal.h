@@ -18,95 +18,133 @@
 #include <chrono>
 #include <set>
 #include <map>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <assert.h>
 #include <functional>
 #include <algorithm>
 
-#include <wrl/client.h>
-
 #include "../include/FeedbackManager.h"
 #include "FeedbackTexture.h"
 #include "FeedbackTextureSet.h"
 
 #include "rtxts-ttm/TiledTextureManager.h"
 
-#include <d3d12.h>
 #include <nvrhi/nvrhi.h>
 
-using namespace Microsoft::WRL;
-
 namespace nvfeedback
 {
+    // Size of one tile of a reserved (tiled) resource, same on D3D12 and Vulkan
+    // (D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES, standard sparse block size for 2D images)
+    static const uint64_t c_tileSizeInBytes = 65536;
+
+    // Number of most recently mapped tiles that the latency statistics are computed from
+    static const size_t c_tileLatencySampleCount = 1024;
+
+    // Default and minimum number of requests read back per frame with feedback compaction
+    static const uint32_t c_defaultMaxFeedbackRequests = 65536;
+    static const uint32_t c_minFeedbackRequestWindow = 1024;
+
     // A really simple timer which holds just one sample
     class SimpleTimer
     {
     public:
-        SimpleTimer() :
-            m_begin(0),
-            m_end(0),
-            m_frequency(0)
-        {
-            QueryPerformanceFrequency((LARGE_INTEGER*)&m_frequency);
-        }
-
         void Clear()
         {
-            m_begin = 0;
-            m_end = 0;
+            m_begin = {};
+            m_end = {};
         }
 
         void Begin()
         {
-            QueryPerformanceCounter((LARGE_INTEGER*)&m_begin);
+            m_begin = std::chrono::high_resolution_clock::now();
         }
 
         void End()
         {
-            QueryPerformanceCounter((LARGE_INTEGER*)&m_end);
+            m_end = std::chrono::high_resolution_clock::now();
         }
 
         double GetTime()
         {
-            uint64_t delta = m_end - m_begin;
-            return double(delta) / double(m_frequency);
+            return std::chrono::duration<double>(m_end - m_begin).count();
         }
 
     private:
-        uint64_t m_begin;
-        uint64_t m_end;
-        uint64_t m_frequency;
+        std::chrono::high_resolution_clock::time_point m_begin;
+        std::chrono::high_resolution_clock::time_point m_end;
     };
 
+    // Allocates the heaps that back the tiles of the feedback textures.
+    // Heaps are taken from a pool of pre-created heaps, which is refilled on a background thread when
+    // async creation is enabled, so that createHeap calls do not stall BeginFrame.
+    // Released heaps are returned to the pool while it is below its target size, and destroyed otherwise.
     class HeapAllocator
     {
     public:
-        HeapAllocator(nvrhi::IDevice* device, uint64_t heapSizeInBytes, uint32_t framesInFlight);
-        ~HeapAllocator() {};
+        HeapAllocator(nvrhi::IDevice* device, uint64_t heapSizeInBytes, uint32_t framesInFlight,
+            uint32_t numPooledHeaps, bool asyncCreation);
+        ~HeapAllocator();
 
-        void AllocateHeap(uint32_t& heapId);
+        // Takes a heap from the pool. If the pool is empty, creates a heap synchronously when async creation
+        // is disabled, or returns false otherwise.
+        bool AllocateHeap(uint32_t& heapId);
         void ReleaseHeap(uint32_t heapId, uint32_t frameIndex);
-        nvrhi::HeapHandle GetHeapHandle(uint32_t heapId) { return m_heaps[heapId]; }
-        nvrhi::BufferHandle GetBufferHandle(uint32_t heapId) { return m_buffers[heapId]; }
 
-        uint64_t GetTotalAllocatedBytes() { return m_totalAllocatedBytes; }
+        // Destroys the pooled heaps above the pool target. With releaseReserve, destroys all pooled heaps
+        // and doesn't refill the numPooledHeaps reserve until there is new demand.
+        void TrimPool(bool releaseReserve);
+
+        // Sets the number of heaps needed in addition to the allocated ones, which the pool should provide,
+        // and the limit for allocated and pooled heaps combined
+        void SetPendingDemand(uint32_t numHeaps, uint32_t maxHeaps = UINT32_MAX);
+
+        // Returns the heaps released numFramesInFlight frames ago to the pool, or destroys them if it's full
+        void BeginFrame(uint32_t frameIndex);
+
+        nvrhi::HeapHandle GetHeapHandle(uint32_t heapId) { return m_heaps[heapId].heap; }
+        nvrhi::BufferHandle GetBufferHandle(uint32_t heapId) { return m_heaps[heapId].buffer; }
+
+        // Includes the pooled heaps
+        uint64_t GetTotalAllocatedBytes();
 
         uint32_t GetNumHeaps() { return m_numHeaps; }
+        uint32_t GetNumPooledHeaps();
 
     private:
+        struct Heap
+        {
+            nvrhi::HeapHandle heap;
+            nvrhi::BufferHandle buffer;
+        };
+
+        Heap CreateHeap();
+        void WorkerThread();
+
         uint32_t m_framesInFlight;
         nvrhi::DeviceHandle m_device;
-        std::vector<nvrhi::HeapHandle> m_heaps;
-        std::vector<nvrhi::BufferHandle> m_buffers;
+        std::vector<Heap> m_heaps;
 
         std::vector<uint32_t> m_freeHeapIds;
 
         uint64_t m_heapSizeInBytes;
 
         uint32_t m_numHeaps;
-        uint64_t m_totalAllocatedBytes;
 
-        std::map<uint32_t, std::vector<nvrhi::HeapHandle>> m_heapsToRelease;
-        std::map<uint32_t, std::vector<nvrhi::BufferHandle>> m_buffersToRelease;
+        std::map<uint32_t, std::vector<Heap>> m_heapsToRelease;
+
+        // The pool and its target size are shared with the worker thread, guarded by m_mutex
+        std::vector<Heap> m_pooledHeaps;
+        uint32_t m_numPooledHeaps;
+        uint32_t m_poolTarget;
+        bool m_reserveReleased = false;
+        bool m_asyncCreation;
+        bool m_exitThread = false;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::thread m_thread;
     };
 
     class FeedbackManagerImpl : public FeedbackManager
@@ -119,6 +157,9 @@ namespace nvfeedback
         bool CreateTextureSet(FeedbackTextureSet** ppTexSet) override;
         void BeginFrame(nvrhi::ICommandList* commandList, const FeedbackUpdateConfig& config, FeedbackTextureCollection* results) override;
         void UpdateTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesReady) override;
+        void MapTiles(FeedbackTextureCollection* tilesToMap, nvrhi::CommandQueue queue) override;
+        void CommitTileMappings(nvrhi::ICommandList* commandList, FeedbackTextureCollection* tilesResident) override;
+        bool IsTileRequestPending(FeedbackTexture* texture, uint32_t tileIndex) override;
         void ResolveFeedback(nvrhi::ICommandList* commandList) override;
         void EndFrame() override;
         FeedbackManagerStats GetStats() override;
@@ -133,6 +174,21 @@ namespace nvfeedback
         rtxts::TiledTextureManager* GetTiledTextureManager() { return m_tiledTextureManager.get(); }
 
     private:
+        void MapTextureTiles(FeedbackTextureImpl* texture, std::vector<uint32_t> const& tileIndices, nvrhi::CommandQueue queue);
+        bool CreateCompactionResources();
+        bool CreateMinMipUpdateResources();
+        void CompactFeedback(nvrhi::ICommandList* commandList, std::vector<FeedbackTextureImpl*> const& readbackTextures);
+        void ReadCompactedFeedback(std::vector<FeedbackTextureImpl*> const& readbackTextures);
+        void WriteDirtyMinMipTextures(nvrhi::ICommandList* commandList);
+        void RecordTileLatencies(FeedbackTextureImpl* texture, std::vector<uint32_t> const& tileIndices);
+        void UpdateTileLatencyStats();
+
+        struct TileRequest
+        {
+            double timestamp;
+            uint32_t frame;
+        };
+
         FeedbackManagerDesc m_desc;
         FeedbackUpdateConfig m_updateConfigThisFrame;
 
@@ -152,7 +208,38 @@ namespace nvfeedback
         SimpleTimer m_timerResolve;
 
         std::shared_ptr<HeapAllocator> m_heapAllocator;
+        std::map<uint32_t, uint32_t> m_emptyHeapFrames; // heapId -> number of consecutive frames the heap was empty
+        uint32_t m_poolIdleFrames = 0; // Number of consecutive frames that didn't need more heaps
         std::shared_ptr<rtxts::TiledTextureManager> m_tiledTextureManager;
         std::set<FeedbackTextureImpl*> m_minMipDirtyTextures;
+
+        // Feedback compaction, see FeedbackManagerDesc::feedbackCompactionShader.
+        // The requests are read back per frame in flight, and only the first m_compactionWindow of them are copied;
+        // the window follows the number of requests seen in the previous frames, up to m_maxFeedbackRequests.
+        nvrhi::BindingLayoutHandle m_compactionBindingLayout;
+        nvrhi::ComputePipelineHandle m_compactionPipeline;
+        nvrhi::BufferHandle m_compactionRequestBuffer;
+        std::vector<nvrhi::BufferHandle> m_compactionReadbackBuffers;
+        std::vector<uint32_t> m_compactionWindowPerFrame; // Window used by the readback of each frame in flight
+        uint32_t m_maxFeedbackRequests = 0;
+        uint32_t m_compactionWindow = 0;
+        uint64_t m_feedbackReadbackBytes = 0;
+        uint32_t m_feedbackRequests = 0;
+
+        // Incremental MinMip updates, see FeedbackManagerDesc::minMipUpdateShader.
+        // The changed texels of all dirty textures are uploaded into one buffer, which grows as needed.
+        nvrhi::BindingLayoutHandle m_minMipUpdateBindingLayout;
+        nvrhi::ComputePipelineHandle m_minMipUpdatePipeline;
+        nvrhi::BufferHandle m_minMipUpdateBuffer;
+        std::vector<uint32_t> m_minMipUpdates;
+        uint32_t m_minMipTexelsUpdated = 0;
+
+        // Tile latency tracking, see FeedbackManagerStats::tileLatencyP50Ms
+        uint32_t m_frameCounter = 0;
+        std::map<std::pair<FeedbackTextureImpl*, uint32_t>, TileRequest> m_tileRequests;
+        std::vector<float> m_tileLatencyMs;       // Ring buffers of the latest c_tileLatencySampleCount samples
+        std::vector<uint32_t> m_tileLatencyFrames;
+        size_t m_tileLatencyNext = 0;
+        bool m_tileLatencyDirty = false;
     };
 }
@@ -12,13 +12,15 @@
 
 #include "FeedbackTexture.h"
 #include "FeedbackManagerInternal.h"
+#if NTC_WITH_DX12
 #include <nvrhi/d3d12.h>
+#endif
 
 #include <array>
 
 namespace nvfeedback
 {
-    FeedbackTextureImpl::FeedbackTextureImpl(const nvrhi::TextureDesc& desc, FeedbackManagerImpl* pFeedbackManager, rtxts::TiledTextureManager* tiledTextureManager, nvrhi::IDevice* device, uint32_t numReadbacks) :
+    FeedbackTextureImpl::FeedbackTextureImpl(const nvrhi::TextureDesc& desc, FeedbackManagerImpl* pFeedbackManager, rtxts::TiledTextureManager* tiledTextureManager, nvrhi::IDevice* device, uint32_t numReadbacks, bool useFeedbackCompaction, bool useMinMipUpdates) :
         m_pFeedbackManager(pFeedbackManager),
         m_refCount(1)
     {
@@ -58,9 +60,14 @@ namespace nvfeedback
         }
 
         tiledTextureManager->AddTiledTexture(tiledTextureDesc, m_tiledTextureId);
-        
+
         rtxts::TextureDesc feedbackDesc = tiledTextureManager->GetTextureDesc(m_tiledTextureId, rtxts::eFeedbackTexture);
-        if (device->getGraphicsAPI() == nvrhi::GraphicsAPI::D3D12)
+        uint32_t const feedbackTilesX = (desc.width - 1) / feedbackDesc.textureOrMipRegionWidth + 1;
+        uint32_t const feedbackTilesY = (desc.height - 1) / feedbackDesc.textureOrMipRegionHeight + 1;
+        m_numFeedbackRegions = feedbackTilesX * feedbackTilesY;
+
+#if NTC_WITH_DX12
+        if (device->queryFeatureSupport(nvrhi::Feature::SamplerFeedback))
         {
             nvrhi::d3d12::IDevice* deviceD3D12 = static_cast<nvrhi::d3d12::IDevice*>(device);
             nvrhi::SamplerFeedbackTextureDesc samplerFeedbackTextureDesc = {};
@@ -72,20 +79,72 @@ namespace nvfeedback
             samplerFeedbackTextureDesc.keepInitialState = true;
             m_feedbackTexture = deviceD3D12->createSamplerFeedbackTexture(m_reservedTexture, samplerFeedbackTextureDesc);
         }
+#endif
+
+        if (!m_feedbackTexture)
+        {
+            // No hardware sampler feedback: the shaders write the min mip for each region into a buffer
+            m_feedbackBufferHeader.regionWidth = feedbackDesc.textureOrMipRegionWidth;
+            m_feedbackBufferHeader.regionHeight = feedbackDesc.textureOrMipRegionHeight;
+            m_feedbackBufferHeader.widthInRegions = feedbackTilesX;
+            m_feedbackBufferHeader.heightInRegions = feedbackTilesY;
+
+            nvrhi::BufferDesc bufferDesc = {};
+            bufferDesc.byteSize = sizeof(FeedbackBufferHeader) + feedbackTilesX * feedbackTilesY * sizeof(uint32_t);
+            bufferDesc.canHaveUAVs = true;
+            bufferDesc.canHaveRawViews = true;
+            bufferDesc.initialState = nvrhi::ResourceStates::UnorderedAccess;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = "Feedback Buffer";
+            m_feedbackBuffer = device->createBuffer(bufferDesc);
 
-        // Resolve / Readback buffer
-        uint32_t readbackBuffersNum = 1;
-        readbackBuffersNum = numReadbacks;
+            m_minMipData.resize(feedbackTilesX * feedbackTilesY);
+        }
+
+        if (useFeedbackCompaction)
+        {
+            // The feedback stays on the GPU, only the changed regions are read back by the feedback manager
+            if (m_feedbackTexture)
+            {
+                nvrhi::BufferDesc bufferDesc = {};
+                bufferDesc.byteSize = (m_numFeedbackRegions + 3) & ~3u; // Read as uints by the compaction shader
+                bufferDesc.canHaveRawViews = true;
+                bufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+                bufferDesc.debugName = "Feedback Decode Buffer";
+                m_feedbackDecodeBuffer = device->createBuffer(bufferDesc);
+            }
+
+            nvrhi::BufferDesc bufferDesc = {};
+            bufferDesc.byteSize = m_numFeedbackRegions * sizeof(uint32_t);
+            bufferDesc.canHaveUAVs = true;
+            bufferDesc.canHaveRawViews = true;
+            bufferDesc.initialState = nvrhi::ResourceStates::UnorderedAccess;
+            bufferDesc.keepInitialState = true;
+            bufferDesc.debugName = "Previous MinMip Buffer";
+            m_previousMinMipBuffer = device->createBuffer(bufferDesc);
+            m_previousMinMipNeedsClear = true;
+
+            // Matches the cleared previous min mip buffer: no region sampled
+            m_compactedMinMip.resize(m_numFeedbackRegions, 0xff);
+        }
+
+        // Resolve / Readback buffer, not needed with feedback compaction
+        uint32_t readbackBuffersNum = useFeedbackCompaction ? 0 : numReadbacks;
         m_feedbackResolveBuffers.resize(readbackBuffersNum);
         for (uint32_t i = 0; i < readbackBuffersNum; i++)
         {
-            uint32_t feedbackTilesX = (desc.width - 1) / feedbackDesc.textureOrMipRegionWidth + 1;
-            uint32_t feedbackTilesY = (desc.height - 1) / feedbackDesc.textureOrMipRegionHeight + 1;
-
             nvrhi::BufferDesc bufferDesc = {};
-            bufferDesc.byteSize = feedbackTilesX * feedbackTilesY;
             bufferDesc.cpuAccess = nvrhi::CpuAccessMode::Read;
-            bufferDesc.initialState = nvrhi::ResourceStates::ResolveDest;
+            if (m_feedbackTexture)
+            {
+                bufferDesc.byteSize = feedbackTilesX * feedbackTilesY;
+                bufferDesc.initialState = nvrhi::ResourceStates::ResolveDest;
+            }
+            else
+            {
+                bufferDesc.byteSize = feedbackTilesX * feedbackTilesY * sizeof(uint32_t);
+                bufferDesc.initialState = nvrhi::ResourceStates::CopyDest;
+            }
             bufferDesc.debugName = "Resolve Buffer";
             m_feedbackResolveBuffers[i] = device->createBuffer(bufferDesc);
         }
@@ -98,6 +157,7 @@ namespace nvfeedback
             textureDesc.width = minMipDesc.textureOrMipRegionWidth;
             textureDesc.height = minMipDesc.textureOrMipRegionHeight;
             textureDesc.format = nvrhi::Format::R32_FLOAT;
+            textureDesc.isUAV = useMinMipUpdates;
             textureDesc.initialState = nvrhi::ResourceStates::ShaderResource;
             textureDesc.keepInitialState = true;
             textureDesc.debugName = "MinMip Texture";
@@ -125,6 +185,51 @@ namespace nvfeedback
         return m_feedbackTexture;
     }
 
+    nvrhi::BufferHandle FeedbackTextureImpl::GetFeedbackBuffer()
+    {
+        return m_feedbackBuffer;
+    }
+
+    void FeedbackTextureImpl::ClearFeedback(nvrhi::ICommandList* commandList)
+    {
+        if (m_feedbackTexture)
+        {
+            commandList->clearSamplerFeedbackTexture(m_feedbackTexture);
+            return;
+        }
+
+        // The clear overwrites the header too, so write it again after
+        commandList->clearBufferUInt(m_feedbackBuffer, ~0u);
+        commandList->writeBuffer(m_feedbackBuffer, &m_feedbackBufferHeader, sizeof(m_feedbackBufferHeader));
+    }
+
+    uint8_t const* FeedbackTextureImpl::GetMinMipData(void const* pResolveData)
+    {
+        if (m_feedbackTexture)
+            return static_cast<uint8_t const*>(pResolveData);
+
+        // Convert the 32-bit values written by the shaders into the 8-bit format of resolved sampler feedback,
+        // where 0xff means that the region was not sampled
+        uint32_t const* pSource = static_cast<uint32_t const*>(pResolveData);
+        for (size_t i = 0; i < m_minMipData.size(); ++i)
+            m_minMipData[i] = uint8_t(std::min(pSource[i], 0xffu));
+
+        return m_minMipData.data();
+    }
+
+    void FeedbackTextureImpl::SetCompactedMinMip(uint32_t regionIndex, uint8_t minMip)
+    {
+        if (regionIndex < m_compactedMinMip.size())
+            m_compactedMinMip[regionIndex] = minMip;
+    }
+
+    bool FeedbackTextureImpl::TakePreviousMinMipClear()
+    {
+        bool const needsClear = m_previousMinMipNeedsClear;
+        m_previousMinMipNeedsClear = false;
+        return needsClear;
+    }
+
     nvrhi::TextureHandle FeedbackTextureImpl::GetMinMipTexture()
     {
         return m_minMipTexture;
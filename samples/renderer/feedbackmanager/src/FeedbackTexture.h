@@ -58,6 +58,7 @@ namespace nvfeedback
 
         nvrhi::TextureHandle GetReservedTexture() override;
         nvrhi::SamplerFeedbackTextureHandle GetSamplerFeedbackTexture() override;
+        nvrhi::BufferHandle GetFeedbackBuffer() override;
         nvrhi::TextureHandle GetMinMipTexture() override;
         bool IsTilePacked(uint32_t tileIndex) override;
         void GetTileInfo(uint32_t tileIndex, std::vector<FeedbackTextureTileInfo>& tiles) override;
@@ -65,11 +66,37 @@ namespace nvfeedback
         FeedbackTextureSet* GetTextureSet(uint32_t index) const override;
 
         // Internal methods
-        FeedbackTextureImpl(const nvrhi::TextureDesc& desc, FeedbackManagerImpl* pFeedbackManager, rtxts::TiledTextureManager* tiledTextureManager, nvrhi::IDevice* device, uint32_t numReadbacks);
+        FeedbackTextureImpl(const nvrhi::TextureDesc& desc, FeedbackManagerImpl* pFeedbackManager, rtxts::TiledTextureManager* tiledTextureManager, nvrhi::IDevice* device, uint32_t numReadbacks, bool useFeedbackCompaction, bool useMinMipUpdates);
         ~FeedbackTextureImpl();
 
         nvrhi::BufferHandle GetFeedbackResolveBuffer(uint32_t frameIndex) { return m_feedbackResolveBuffers[frameIndex]; }
 
+        // Clears the feedback texture or buffer before it's written by the shaders
+        void ClearFeedback(nvrhi::ICommandList* commandList);
+
+        // Returns the min mip data for the tiled texture manager, one byte per mip region.
+        // When feedback buffers are used, converts the contents of the mapped resolve buffer
+        // into an internal array, otherwise returns the mapped data as is.
+        uint8_t const* GetMinMipData(void const* pResolveData);
+
+        uint32_t GetNumFeedbackRegions() const { return m_numFeedbackRegions; }
+
+        // Resources for feedback compaction, see FeedbackManagerDesc::feedbackCompactionShader.
+        // The decode buffer receives the decoded sampler feedback, the previous min mip buffer holds the values
+        // last sent to the CPU, and the compacted min mip data is the CPU copy of them.
+        nvrhi::BufferHandle GetFeedbackDecodeBuffer() { return m_feedbackDecodeBuffer; }
+        nvrhi::BufferHandle GetPreviousMinMipBuffer() { return m_previousMinMipBuffer; }
+        nvrhi::BindingSetHandle& GetCompactionBindingSet() { return m_compactionBindingSet; }
+        uint8_t const* GetCompactedMinMipData() const { return m_compactedMinMip.data(); }
+        void SetCompactedMinMip(uint32_t regionIndex, uint8_t minMip);
+
+        // Returns true once after creation, when the previous min mip buffer has to be cleared
+        bool TakePreviousMinMipClear();
+
+        // Contents of the MinMip texture as of its last update, empty before the first one
+        std::vector<uint8_t>& GetMinMipCache() { return m_minMipCache; }
+        nvrhi::BindingSetHandle& GetMinMipUpdateBindingSet() { return m_minMipUpdateBindingSet; }
+
         uint32_t GetNumTiles() { return m_numTiles; }
         const nvrhi::TileShape& GetTileShape() const { return m_tileShape; }
         const nvrhi::PackedMipDesc& GetPackedMipInfo() const { return m_packedMipDesc; }
@@ -96,8 +123,21 @@ namespace nvfeedback
 
         nvrhi::TextureHandle m_reservedTexture;
         nvrhi::SamplerFeedbackTextureHandle m_feedbackTexture;
+        nvrhi::BufferHandle m_feedbackBuffer;
+        std::vector<uint8_t> m_minMipData;
+        FeedbackBufferHeader m_feedbackBufferHeader = {};
         std::vector<nvrhi::BufferHandle> m_feedbackResolveBuffers;
         nvrhi::TextureHandle m_minMipTexture;
+        uint32_t m_numFeedbackRegions = 0;
+
+        nvrhi::BufferHandle m_feedbackDecodeBuffer;
+        nvrhi::BufferHandle m_previousMinMipBuffer;
+        nvrhi::BindingSetHandle m_compactionBindingSet;
+        std::vector<uint8_t> m_compactedMinMip;
+        bool m_previousMinMipNeedsClear = false;
+
+        std::vector<uint8_t> m_minMipCache;
+        nvrhi::BindingSetHandle m_minMipUpdateBindingSet;
 
         uint32_t m_numTiles = 0;
         nvrhi::PackedMipDesc m_packedMipDesc;
@@ -17,8 +17,13 @@
 #include <donut/app/DeviceManager.h>
 #include <donut/engine/ShaderFactory.h>
 #include <nvrhi/utils.h>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <csignal>
+#include <future>
+#include <map>
+#include <mutex>
 #include <queue>
 #include <thread>
 #include <fstream>
@@ -43,6 +48,7 @@ struct
     const char* outputPath = nullptr;
     const char* csvOutputPath = nullptr;
     const char* loadBaselinePath = nullptr;
+    const char* adapters = nullptr;
     bool useVulkan = false;
     bool useDX12 = false;
     bool debug = false;
@@ -50,11 +56,33 @@ struct
 #if NTC_WITH_NVTT
     bool nvtt = true;
 #endif
+    bool overlap = false;
     bool acceleratedMode = false;
+    float psnrTolerance = 0.05f;
+    float speedTolerance = 5.f;
     int adapterIndex = -1;
     int threads = 0;
 } g_options;
 
+// Adapter indices to run the tests on, from --adapters or --adapter
+std::vector<int> g_adapterIndices;
+
+// Splits the comma separated string into a vector of its components.
+std::vector<std::string> SplitString(std::string const& s)
+{
+    std::vector<std::string> result;
+    size_t start = 0;
+    size_t comma = 0;
+    while ((comma = s.find(',', start)) != std::string::npos)
+    {
+        result.push_back(s.substr(start, comma - start));
+        start = comma + 1;
+    }
+    if (start < s.size())
+        result.push_back(s.substr(start, s.size() - start));
+    return result;
+}
+
 bool ProcessCommandLine(int argc, const char** argv)
 {
     struct argparse_option options[] = {
@@ -73,10 +101,14 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_BOOLEAN(0, "ntc", &g_options.ntc, "Enable BCn compression through NTC (default on, use --no-ntc)"),
 #if NTC_WITH_NVTT
         OPT_BOOLEAN(0, "nvtt", &g_options.nvtt, "Enable BCn compression through NVTT (default on, use --no-nvtt)"),
+        OPT_BOOLEAN(0, "overlap", &g_options.overlap, "Run NVTT compression concurrently with NTC compression to save time, skews the NTC and NVTT timing (default off)"),
 #endif
         OPT_BOOLEAN(0, "accelerated", &g_options.acceleratedMode, "Test NTC accelerated mode for BC7 compression"),
+        OPT_FLOAT(0, "psnrTolerance", &g_options.psnrTolerance, "PSNR drop from the baseline, in dB, that is reported as a quality regression (default 0.05)"),
+        OPT_FLOAT(0, "speedTolerance", &g_options.speedTolerance, "Throughput drop from the baseline, in percent, that is reported as a speed regression (default 5)"),
         OPT_BOOLEAN(0, "debug", &g_options.debug, "Enable debug features such as Vulkan validation layer or D3D12 debug runtime"),
         OPT_INTEGER(0, "adapter", &g_options.adapterIndex, "Index of the graphics adapter to use"),
+        OPT_STRING(0, "adapters", &g_options.adapters, "Comma separated list of graphics adapter indices to distribute the images across, overrides --adapter"),
         OPT_INTEGER(0, "threads", &g_options.threads, "Number of threads to use for preloading images"),
         OPT_END()
     };
@@ -132,6 +164,33 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false;
     }
 
+    if (g_options.adapters)
+    {
+        for (std::string const& adapter : SplitString(g_options.adapters))
+        {
+            char* end = nullptr;
+            long const adapterIndex = strtol(adapter.c_str(), &end, 10);
+            if (adapter.empty() || *end != 0 || adapterIndex < 0 ||
+                std::find(g_adapterIndices.begin(), g_adapterIndices.end(), int(adapterIndex)) != g_adapterIndices.end())
+            {
+                fprintf(stderr, "Invalid --adapters value '%s'.\n", g_options.adapters);
+                return false;
+            }
+            g_adapterIndices.push_back(int(adapterIndex));
+        }
+    }
+
+    if (g_adapterIndices.empty())
+        g_adapterIndices.push_back(g_options.adapterIndex);
+
+#if NTC_WITH_NVTT
+    if (g_options.overlap && g_options.nvtt && g_options.ntc && g_options.loadBaselinePath)
+    {
+        printf("WARNING: --overlap runs NVTT concurrently with NTC, so the speed regression checks against "
+            "the baseline are not reliable.\n");
+    }
+#endif
+
     return true;
 }
 
@@ -141,7 +200,8 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false; \
     }
 
-bool g_Terminate = false;
+// Read by the loader and worker threads, so make it atomic
+std::atomic<bool> g_Terminate = false;
 void SigintHandler(int signal)
 {
     printf("\nSIGINT received, stopping...\n\n");
@@ -192,17 +252,17 @@ BcFormatDefinition const* GetFormatDef(ntc::BlockCompressedFormat format)
     return nullptr;
 }
 
-donut::app::DeviceCreationParameters GetGraphicsDeviceParameters()
+donut::app::DeviceCreationParameters GetGraphicsDeviceParameters(int adapterIndex)
 {
     donut::app::DeviceCreationParameters deviceParams;
     deviceParams.infoLogSeverity = donut::log::Severity::None;
-    deviceParams.adapterIndex = g_options.adapterIndex;
+    deviceParams.adapterIndex = adapterIndex;
     deviceParams.enableDebugRuntime = g_options.debug;
     deviceParams.enableNvrhiValidationLayer = g_options.debug;
     return deviceParams;
 }
 
-std::unique_ptr<donut::app::DeviceManager> InitGraphicsDevice()
+std::unique_ptr<donut::app::DeviceManager> InitGraphicsDevice(int adapterIndex)
 {
     using namespace donut::app;
 
@@ -212,7 +272,7 @@ std::unique_ptr<donut::app::DeviceManager> InitGraphicsDevice()
     
     auto deviceManager = std::unique_ptr<DeviceManager>(DeviceManager::Create(graphicsApi));
 
-    DeviceCreationParameters const deviceParams = GetGraphicsDeviceParameters();
+    DeviceCreationParameters const deviceParams = GetGraphicsDeviceParameters(adapterIndex);
 
     if (!deviceManager->CreateHeadlessDevice(deviceParams))
     {
@@ -480,7 +540,8 @@ bool CompressWithNtc(
     nvrhi::ITimerQuery* timerQuery,
     float& outPsnr,
     float& outRmse,
-    float& outGPixelsPerSecond)
+    float& outGPixelsPerSecond,
+    float& outGpuTimeMs)
 {
     float const alphaThreshold = 1.f / 255.f;
 
@@ -538,6 +599,7 @@ bool CompressWithNtc(
     device->runGarbageCollection();
 
     float const timeSeconds = device->getTimerQueryTime(timerQuery);
+    outGpuTimeMs = timeSeconds * 1e3f;
     if (timeSeconds > 0.f)
         outGPixelsPerSecond = 1e-9f * float(imageData.width * imageData.height) / timeSeconds;
     else
@@ -618,18 +680,17 @@ bool MakeBC7ModeBuffer(
 }
 
 #if NTC_WITH_NVTT
-bool CompressWithNvtt(
+// NVTT is called from multiple worker threads when more than one adapter is used, serialize the encoder calls
+std::mutex g_nvttMutex;
+
+// Compresses the image with NVTT. This only uses the CPU copy of the image data, so it can run on another thread
+// while the NTC passes are executing.
+bool EncodeWithNvtt(
     ImageData const& imageData,
     BcFormatDefinition const& formatDef,
-    ntc::IContext* context,
-    GraphicsImageDifferencePass& imageDifferencePass,
-    nvrhi::IDevice* device,
-    nvrhi::ICommandList* commandList,
-    float& outPsnr,
-    float& outRmse)
+    std::vector<uint8_t>& outBlockData,
+    float& outMPixelsPerSecond)
 {
-    float const alphaThreshold = 1.f / 255.f;
-
     nvtt::RefImage image;
     image.width = imageData.width;
     image.height = imageData.height;
@@ -642,8 +703,13 @@ bool CompressWithNvtt(
         .SetUseGPU(true)
         .SetQuality(nvtt::Quality_Normal);
     
-    std::vector<uint8_t> blockData(imageData.widthInBlocks * imageData.heightInBlocks * formatDef.bytesPerBlock);
-    bool success = nvtt::nvtt_encode(inputBuff, blockData.data(), eset);
+    outBlockData.resize(imageData.widthInBlocks * imageData.heightInBlocks * formatDef.bytesPerBlock);
+
+    std::lock_guard<std::mutex> lock(g_nvttMutex);
+
+    auto const startTime = std::chrono::steady_clock::now();
+    bool success = nvtt::nvtt_encode(inputBuff, outBlockData.data(), eset);
+    auto const endTime = std::chrono::steady_clock::now();
 
     if (!success)
     {
@@ -651,6 +717,30 @@ bool CompressWithNvtt(
         return false;
     }
 
+    float const timeSeconds = std::chrono::duration<float>(endTime - startTime).count();
+    if (timeSeconds > 0.f)
+        outMPixelsPerSecond = 1e-6f * float(imageData.width * imageData.height) / timeSeconds;
+    else
+        outMPixelsPerSecond = 0.f;
+
+    return true;
+}
+
+// Measures the quality of the NVTT compressed image on the GPU and saves it, if requested.
+bool EvaluateNvtt(
+    ImageData const& imageData,
+    BcFormatDefinition const& formatDef,
+    std::vector<uint8_t> const& blockData,
+    float nvttMPixelsPerSecond,
+    ntc::IContext* context,
+    GraphicsImageDifferencePass& imageDifferencePass,
+    nvrhi::IDevice* device,
+    nvrhi::ICommandList* commandList,
+    float& outPsnr,
+    float& outRmse)
+{
+    float const alphaThreshold = 1.f / 255.f;
+
     ntc::MakeImageDifferenceComputePassParameters differenceParams;
     differenceParams.extent.width = imageData.width;
     differenceParams.extent.height = imageData.height;
@@ -684,8 +774,8 @@ bool CompressWithNvtt(
     outRmse = sqrtf(mse);
     
     // See the comment in CompressWithNtc(...) near similar printf on why the HDR dB values are fake.
-    printf("[NVTT] %s: %.2f %sdB\n", imageData.name.generic_string().c_str(),
-        outPsnr, imageData.isHDR ? "false " : "");
+    printf("[NVTT] %s: %.2f %sdB, %.1f Mpix/s\n", imageData.name.generic_string().c_str(),
+        outPsnr, imageData.isHDR ? "false " : "", nvttMPixelsPerSecond);
 
     if (g_options.outputPath)
     {
@@ -707,29 +797,33 @@ bool CompressWithNvtt(
 struct Result
 {
     fs::path name;
+    int width = 0;
+    int height = 0;
     float ntcPsnr = 0;
     float ntcRmse = 0;
     float baselineNtcPsnr = 0;
     float nvttPsnr = 0;
     float nvttRmse = 0;
     float ntcGPixelsPerSecond = 0;
+    float ntcGpuTimeMs = 0;
+    float baselineNtcGPixelsPerSecond = 0;
+    float ntcAcceleratedPsnr = 0;
+    float ntcAcceleratedGPixelsPerSecond = 0;
+    float ntcAcceleratedGpuTimeMs = 0;
+    float baselineNtcAcceleratedGPixelsPerSecond = 0;
+    float nvttMPixelsPerSecond = 0;
     bool ntcAcceleratedMatch = false;
 };
 
-// Splits the comma separated string into a vector of its components.
-std::vector<std::string> SplitString(std::string const& s)
+// Returns the resolution bucket used to group the performance results, which is the larger image dimension
+// rounded up to a power of 2, but at least 256.
+int GetResolutionBucket(int width, int height)
 {
-    std::vector<std::string> result;
-    size_t start = 0;
-    size_t comma = 0;
-    while ((comma = s.find(',', start)) != std::string::npos)
-    {
-        result.push_back(s.substr(start, comma - start));
-        start = comma + 1;
-    }
-    if (start < s.size())
-        result.push_back(s.substr(start, s.size() - start));
-    return result;
+    int const size = std::max(width, height);
+    int bucket = 256;
+    while (bucket < size)
+        bucket *= 2;
+    return bucket;
 }
 
 // Returns the index of the given string in a vector of strings.
@@ -767,6 +861,7 @@ bool LoadBaseline(char const* fileName, std::vector<Result>& outResults)
     int nvttCol = -1;
     int ntcCol = -1;
     int ntcPerfCol = -1;
+    int ntcAcceleratedPerfCol = -1;
     while (std::getline(file, line))
     {
         ++lineno;
@@ -778,6 +873,7 @@ bool LoadBaseline(char const* fileName, std::vector<Result>& outResults)
             nvttCol = FindColumn(parts, "NVTT dB");
             ntcCol = FindColumn(parts, "NTC dB");
             ntcPerfCol = FindColumn(parts, "NTC Gpix/s");
+            ntcAcceleratedPerfCol = FindColumn(parts, "NTCa Gpix/s");
             if (nameCol < 0)
             {
                 fprintf(stderr, "There is no Name column in the input CSV file '%s'", fileName);
@@ -795,6 +891,8 @@ bool LoadBaseline(char const* fileName, std::vector<Result>& outResults)
                 result.ntcPsnr = ParseFloatInf(parts[ntcCol].c_str());
             if (ntcPerfCol >= 0 && ntcPerfCol < int(parts.size()))
                 result.ntcGPixelsPerSecond = ParseFloatInf(parts[ntcPerfCol].c_str());
+            if (ntcAcceleratedPerfCol >= 0 && ntcAcceleratedPerfCol < int(parts.size()))
+                result.ntcAcceleratedGPixelsPerSecond = ParseFloatInf(parts[ntcAcceleratedPerfCol].c_str());
             outResults.push_back(std::move(result));
         }
     }
@@ -857,27 +955,158 @@ private:
     int m_count = 0;
 };
 
-bool RunTests(std::vector<fs::path> sourceFiles, std::vector<Result>& results, ntc::BlockCompressedFormat format,
-    ntc::IContext* context, nvrhi::IDevice* device)
+// Opens the CSV output file for writing and writes the table header into it.
+FILE* OpenCsvFile()
 {
-    BcFormatDefinition const* pFormatDef = GetFormatDef(format);
+    fs::path csvParent = fs::path(g_options.csvOutputPath).parent_path();
+    if (!csvParent.empty() && !fs::is_directory(csvParent))
+        fs::create_directories(csvParent);
 
-    // Pre-initialize shared graphics passes
+    FILE* csvFile = fopen(g_options.csvOutputPath, "w");
+    if (!csvFile)
+    {
+        fprintf(stderr, "Cannot open file '%s'\n", g_options.csvOutputPath);
+        return nullptr;
+    }
 
-    GraphicsBlockCompressionPass blockCompressionPass(device, true);
-    if (!blockCompressionPass.Init())
-        return false;
+    fprintf(csvFile, "Name,NTC dB,NTC RMS(L)E,NTC Gpix/s,Baseline NTC dB,NVTT dB,NVTT RMS(L)E,NTC - NVTT dB,NTC Improvement dB,NVTT Mpix/s,"
+        "Format,Width,Height,Resolution Bucket,NTC GPU ms,Baseline NTC Gpix/s,NTCa dB,NTCa GPU ms,NTCa Gpix/s,Baseline NTCa Gpix/s\n");
+    return csvFile;
+}
+
+void WriteCsvRow(FILE* csvFile, Result const& result)
+{
+    fprintf(csvFile, "%s,%.3f,%.5f,%.3f,%.3f,%.3f,%.5f,%.3f,%.3f,%.1f,%s,%d,%d,%d,%.4f,%.3f,%.3f,%.4f,%.3f,%.3f\n",
+        result.name.generic_string().c_str(),
+        result.ntcPsnr, result.ntcRmse, result.ntcGPixelsPerSecond, result.baselineNtcPsnr,
+        result.nvttPsnr, result.nvttRmse,
+        result.ntcPsnr - result.nvttPsnr, result.ntcPsnr - result.baselineNtcPsnr,
+        result.nvttMPixelsPerSecond, g_options.format, result.width, result.height,
+        GetResolutionBucket(result.width, result.height), result.ntcGpuTimeMs, result.baselineNtcGPixelsPerSecond,
+        result.ntcAcceleratedPsnr, result.ntcAcceleratedGpuTimeMs, result.ntcAcceleratedGPixelsPerSecond,
+        result.baselineNtcAcceleratedGPixelsPerSecond);
+}
+
+// Graphics device and the objects needed to run the tests on it. There is one worker per adapter,
+// and each worker has a thread that processes the images in parallel with the other workers.
+struct TestWorker
+{
+    // Declared first so that the device is destroyed after all objects that use it
+    std::unique_ptr<donut::app::DeviceManager> deviceManager;
+    ntc::ContextWrapper context;
+    std::unique_ptr<GraphicsBlockCompressionPass> blockCompressionPass;
+    std::unique_ptr<GraphicsImageDifferencePass> imageDifferencePass;
+    nvrhi::CommandListHandle commandList;
+    nvrhi::TimerQueryHandle timerQuery;
+
+    bool Init(int adapterIndex)
+    {
+        deviceManager = InitGraphicsDevice(adapterIndex);
+        if (!deviceManager)
+            return false;
+
+        nvrhi::IDevice* device = deviceManager->GetDevice();
+        if (!InitNtcContext(device, context))
+            return false;
+
+        blockCompressionPass = std::make_unique<GraphicsBlockCompressionPass>(device, true);
+        if (!blockCompressionPass->Init())
+            return false;
+
+        imageDifferencePass = std::make_unique<GraphicsImageDifferencePass>(device);
+        if (!imageDifferencePass->Init())
+            return false;
+
+        commandList = device->createCommandList();
+        timerQuery = device->createTimerQuery();
 
-    GraphicsImageDifferencePass imageDifferencePass(device);
-    if (!imageDifferencePass.Init())
+        return true;
+    }
+};
+
+// Runs all enabled encoders on one image using the worker's device.
+bool TestImage(TestWorker& worker, ImageData& imageData, BcFormatDefinition const& formatDef, Result& result)
+{
+    nvrhi::IDevice* device = worker.deviceManager->GetDevice();
+    ntc::IContext* context = worker.context;
+
+    // Create the graphics texture objects and upload data to the GPU
+    if (!imageData.InitTextures(device, worker.commandList, formatDef))
         return false;
 
-    nvrhi::CommandListHandle commandList = device->createCommandList();
-    nvrhi::TimerQueryHandle timerQuery = device->createTimerQuery();
+    result.name = imageData.name;
+    result.width = imageData.width;
+    result.height = imageData.height;
+
+#if NTC_WITH_NVTT
+    // Start the NVTT encoder on another thread, it doesn't need the GPU objects created above
+    std::vector<uint8_t> nvttBlockData;
+    std::future<bool> nvttEncodeResult;
+    if (g_options.nvtt && g_options.overlap)
+    {
+        nvttEncodeResult = std::async(std::launch::async, [&imageData, &formatDef, &nvttBlockData, &result]()
+        {
+            return EncodeWithNvtt(imageData, formatDef, nvttBlockData, result.nvttMPixelsPerSecond);
+        });
+    }
+#endif
+
+    if (g_options.ntc)
+    {
+        CompressWithNtc(imageData, formatDef, context, *worker.blockCompressionPass, *worker.imageDifferencePass,
+            device, worker.commandList, worker.timerQuery, result.ntcPsnr, result.ntcRmse,
+            result.ntcGPixelsPerSecond, result.ntcGpuTimeMs);
+
+        if (formatDef.ntcFormat == ntc::BlockCompressedFormat::BC7 && g_options.acceleratedMode)
+        {
+            MakeBC7ModeBuffer(imageData, device, worker.commandList);
+            
+            float acceleratedRmse = 0.f;
+            CompressWithNtc(imageData, formatDef, context, *worker.blockCompressionPass, *worker.imageDifferencePass,
+                device, worker.commandList, worker.timerQuery, result.ntcAcceleratedPsnr, acceleratedRmse,
+                result.ntcAcceleratedGPixelsPerSecond, result.ntcAcceleratedGpuTimeMs);
+
+            result.ntcAcceleratedMatch = result.ntcAcceleratedPsnr == result.ntcPsnr;
+        }
+    }
+
+#if NTC_WITH_NVTT
+    if (g_options.nvtt)
+    {
+        bool const encoded = nvttEncodeResult.valid()
+            ? nvttEncodeResult.get()
+            : EncodeWithNvtt(imageData, formatDef, nvttBlockData, result.nvttMPixelsPerSecond);
+
+        if (encoded)
+        {
+            EvaluateNvtt(imageData, formatDef, nvttBlockData, result.nvttMPixelsPerSecond, context,
+                *worker.imageDifferencePass, device, worker.commandList, result.nvttPsnr, result.nvttRmse);
+        }
+    }
+#endif
+
+    return true;
+}
+
+bool RunTests(std::vector<fs::path> sourceFiles, std::vector<Result>& results, ntc::BlockCompressedFormat format,
+    std::vector<std::unique_ptr<TestWorker>> const& workers)
+{
+    BcFormatDefinition const* pFormatDef = GetFormatDef(format);
+
+    // Write the results into the CSV file as they come, so that they are not lost if the test is interrupted.
+    // ProcessResults(...) overwrites the file with the sorted and collated results at the end.
+    FILE* csvFile = nullptr;
+    if (g_options.csvOutputPath)
+    {
+        csvFile = OpenCsvFile();
+        if (!csvFile)
+            return false;
+        fflush(csvFile);
+    }
 
     // The runner uses multiple threads to load source images because decoding PNG or JPG takes a long time.
     // The source image paths are placed into sourceFileQueue, and the threads pull tasks from that queue.
-    // Once loaded, ImageData objects are placed into imageQueue. The main thread pulls images from that queue.
+    // Once loaded, ImageData objects are placed into imageQueue. The worker threads pull images from that queue.
 
     std::queue<fs::path> sourceFileQueue;
     for (fs::path const& path : sourceFiles)
@@ -885,6 +1114,7 @@ bool RunTests(std::vector<fs::path> sourceFiles, std::vector<Result>& results, n
     std::queue<std::shared_ptr<ImageData>> imageQueue;
     std::mutex sourceMutex;
     std::mutex imageMutex;
+    std::mutex resultMutex;
 
     std::vector<std::shared_ptr<std::thread>> threads;
     int numThreads = g_options.threads > 0 ? g_options.threads : std::thread::hardware_concurrency();
@@ -926,72 +1156,66 @@ bool RunTests(std::vector<fs::path> sourceFiles, std::vector<Result>& results, n
         threads.push_back(thread);
     }
 
-    // Main loop that pulls images from imageQueue and runs the compression tests on them
-    while (!g_Terminate)
+    // Start the worker threads that pull images from imageQueue and run the compression tests on them
+    std::vector<std::shared_ptr<std::thread>> workerThreads;
+    for (std::unique_ptr<TestWorker> const& worker : workers)
     {
-        std::shared_ptr<ImageData> imageData;
+        TestWorker* pWorker = worker.get();
+        auto thread = std::make_shared<std::thread>([pWorker, pFormatDef, csvFile, &imageQueue, &imageMutex,
+            &liveThreads, &resultMutex, &results]()
         {
-            std::lock_guard<std::mutex> lock(imageMutex);
-            if (!imageQueue.empty())
+            while (!g_Terminate)
             {
-                imageData = imageQueue.front();
-                imageQueue.pop();
-            }
-        }
+                // Sample the counter before looking at the queue: if all loaders were done at that point,
+                // an empty queue means that there are no more images.
+                bool const loadersFinished = liveThreads <= 0;
 
-        // If we couldn't pull a task from the queue, it means either something is still decoding or we're done
-        if (!imageData)
-        {
-            // All the threads finished means there are no more tasks
-            if (liveThreads <= 0)
-                break;
+                std::shared_ptr<ImageData> imageData;
+                {
+                    std::lock_guard<std::mutex> lock(imageMutex);
+                    if (!imageQueue.empty())
+                    {
+                        imageData = imageQueue.front();
+                        imageQueue.pop();
+                    }
+                }
 
-            // There are more tasks: sleep a bit and try again
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            continue;
-        }
-        
-        // Create the graphics texture objects and upload data to the GPU
-        if (!imageData->InitTextures(device, commandList, *pFormatDef))
-            continue;
+                // If we couldn't pull a task from the queue, it means either something is still decoding or we're done
+                if (!imageData)
+                {
+                    if (loadersFinished)
+                        break;
 
-        Result result;
-        result.name = imageData->name;
+                    // There are more tasks: sleep a bit and try again
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
 
-        if (g_options.ntc)
-        {
-            CompressWithNtc(*imageData, *pFormatDef, context, blockCompressionPass, imageDifferencePass,
-                device, commandList, timerQuery, result.ntcPsnr, result.ntcRmse,
-                result.ntcGPixelsPerSecond);
+                Result result;
+                if (!TestImage(*pWorker, *imageData, *pFormatDef, result))
+                    continue;
 
-            if (format == ntc::BlockCompressedFormat::BC7 && g_options.acceleratedMode)
-            {
-                MakeBC7ModeBuffer(*imageData, device, commandList);
-                
-                float acceleratedPsnr = 0.f;
-                CompressWithNtc(*imageData, *pFormatDef, context, blockCompressionPass, imageDifferencePass,
-                    device, commandList, timerQuery, acceleratedPsnr, result.ntcRmse,
-                    result.ntcGPixelsPerSecond);
-
-                result.ntcAcceleratedMatch = acceleratedPsnr == result.ntcPsnr;
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if (csvFile)
+                {
+                    WriteCsvRow(csvFile, result);
+                    fflush(csvFile);
+                }
+                results.push_back(result);
             }
-        }
-
-#if NTC_WITH_NVTT
-        if (g_options.nvtt)
-        {
-            CompressWithNvtt(*imageData, *pFormatDef, context, imageDifferencePass,
-                device, commandList, result.nvttPsnr, result.nvttRmse);
-        }
-#endif
-
-        results.push_back(result);
+        });
+        workerThreads.push_back(thread);
     }
 
     // Wait until all threads have finished
+    for (auto& thread : workerThreads)
+        thread->join();
     for (auto& thread : threads)
         thread->join();
 
+    if (csvFile)
+        fclose(csvFile);
+
     return !g_Terminate;
 }
 
@@ -1020,7 +1244,19 @@ bool ProcessResults( ntc::BlockCompressedFormat format, std::vector<Result> cons
     Statistic ntcNvttDiff;
     std::vector<float> currentNtcGpixPerSecond;
     std::vector<float> baselineNtcGpixPerSecond;
+    std::vector<float> currentNvttMpixPerSecond;
     int matchCount = 0;
+    int qualityRegressionCount = 0;
+
+    // NTC encoding throughput samples for each resolution bucket, for both the full and accelerated modes
+    struct BucketPerf
+    {
+        std::vector<float> ntc;
+        std::vector<float> baselineNtc;
+        std::vector<float> accelerated;
+        std::vector<float> baselineAccelerated;
+    };
+    std::map<int, BucketPerf> perfByBucket;
 
     // Go over all the new results and:
     //  a) Collate them to baseline results;
@@ -1046,12 +1282,37 @@ bool ProcessResults( ntc::BlockCompressedFormat format, std::vector<Result> cons
 #endif
 
                 baselineNtcGpixPerSecond.push_back(baselineResult->ntcGPixelsPerSecond);
+
+                result.baselineNtcGPixelsPerSecond = baselineResult->ntcGPixelsPerSecond;
+                result.baselineNtcAcceleratedGPixelsPerSecond = baselineResult->ntcAcceleratedGPixelsPerSecond;
             }
         }
 
         if (result.ntcPsnr != 0.f && result.baselineNtcPsnr != 0.f)
+        {
             ntcBaselineDiff.Append(result.ntcPsnr - result.baselineNtcPsnr);
 
+            if (result.ntcPsnr < result.baselineNtcPsnr - g_options.psnrTolerance)
+            {
+                printf("NTC quality regression: %s: %.3f dB, baseline %.3f dB\n", result.name.generic_string().c_str(),
+                    result.ntcPsnr, result.baselineNtcPsnr);
+                ++qualityRegressionCount;
+            }
+        }
+
+        if (g_options.ntc && result.width > 0)
+        {
+            BucketPerf& bucket = perfByBucket[GetResolutionBucket(result.width, result.height)];
+            if (result.ntcGPixelsPerSecond > 0.f)
+                bucket.ntc.push_back(result.ntcGPixelsPerSecond);
+            if (result.baselineNtcGPixelsPerSecond > 0.f)
+                bucket.baselineNtc.push_back(result.baselineNtcGPixelsPerSecond);
+            if (result.ntcAcceleratedGPixelsPerSecond > 0.f)
+                bucket.accelerated.push_back(result.ntcAcceleratedGPixelsPerSecond);
+            if (result.baselineNtcAcceleratedGPixelsPerSecond > 0.f)
+                bucket.baselineAccelerated.push_back(result.baselineNtcAcceleratedGPixelsPerSecond);
+        }
+
 #if NTC_WITH_NVTT
         if (result.ntcPsnr != 0.f && result.nvttPsnr != 0.f)
             ntcNvttDiff.Append(result.ntcPsnr - result.nvttPsnr);
@@ -1059,6 +1320,9 @@ bool ProcessResults( ntc::BlockCompressedFormat format, std::vector<Result> cons
 
         currentNtcGpixPerSecond.push_back(result.ntcGPixelsPerSecond);
 
+        if (result.nvttMPixelsPerSecond > 0.f)
+            currentNvttMpixPerSecond.push_back(result.nvttMPixelsPerSecond);
+
         if (result.ntcAcceleratedMatch)
             ++matchCount;
         else
@@ -1078,6 +1342,12 @@ bool ProcessResults( ntc::BlockCompressedFormat format, std::vector<Result> cons
 
     if (!currentNtcGpixPerSecond.empty())
         printf("Average NTC encoding perf: %.3f Gpix/s\n", meanNtcGpixPerSecond);
+
+    if (!currentNvttMpixPerSecond.empty())
+    {
+        printf("Average NVTT encoding perf: %.1f Mpix/s\n",
+            TruncatedMean(currentNvttMpixPerSecond, discardLow, discardHigh));
+    }
     
     if (g_options.acceleratedMode)
     {
@@ -1106,34 +1376,62 @@ bool ProcessResults( ntc::BlockCompressedFormat format, std::vector<Result> cons
     }
 #endif
 
-
-    // Save the results into a CSV file, if requested by the user
-    if (g_options.csvOutputPath)
+    // Print out the NTC perf for each resolution bucket and encoder mode, and compare it to the baseline.
+    // Throughput in Gpix/s is the inverse of the GPU time per texel in ns.
+    int speedRegressionCount = 0;
+    auto printBucketPerf = [discardLow, discardHigh, &speedRegressionCount](char const* mode, int bucket,
+        std::vector<float>& current, std::vector<float>& baseline)
     {
-        fs::path csvParent = fs::path(g_options.csvOutputPath).parent_path();
-        if (!csvParent.empty() && !fs::is_directory(csvParent))
-            fs::create_directories(csvParent);
+        if (current.empty())
+            return;
 
-        FILE* csvFile = fopen(g_options.csvOutputPath, "w");
-        if (csvFile)
+        size_t const count = current.size();
+        float const meanCurrent = TruncatedMean(current, discardLow, discardHigh);
+        if (baseline.empty())
         {
-            fprintf(csvFile, "Name,NTC dB,NTC RMS(L)E,NTC Gpix/s,Baseline NTC dB,NVTT dB,NVTT RMS(L)E,NTC - NVTT dB,NTC Improvement dB\n");
-            for (Result const& result : results)
-            {
-                fprintf(csvFile, "%s,%.3f,%.5f,%.3f,%.3f,%.3f,%.5f,%.3f,%.3f\n", result.name.generic_string().c_str(),
-                    result.ntcPsnr, result.ntcRmse, result.ntcGPixelsPerSecond, result.baselineNtcPsnr,
-                    result.nvttPsnr, result.nvttRmse,
-                    result.ntcPsnr - result.nvttPsnr, result.ntcPsnr - result.baselineNtcPsnr);
-            }
-            fclose(csvFile);
+            printf("  %-5s <= %5d: %5d images, %.3f Gpix/s\n", mode, bucket, int(count), meanCurrent);
+            return;
         }
-        else
+
+        float const meanBaseline = TruncatedMean(baseline, discardLow, discardHigh);
+        float const speedup = meanBaseline > 0.f ? 100.f * (meanCurrent - meanBaseline) / meanBaseline : 0.f;
+        bool const regression = speedup < -g_options.speedTolerance;
+        printf("  %-5s <= %5d: %5d images, %.3f Gpix/s, baseline %.3f Gpix/s, speedup %.2f%%%s\n", mode, bucket,
+            int(count), meanCurrent, meanBaseline, speedup, regression ? " - SPEED REGRESSION" : "");
+        if (regression)
+            ++speedRegressionCount;
+    };
+    
+    if (!perfByBucket.empty())
+    {
+        printf("NTC %s encoding perf by resolution:\n", g_options.format);
+        for (auto& [bucket, perf] : perfByBucket)
         {
-            fprintf(stderr, "Cannot open file '%s'\n", g_options.csvOutputPath);
-            return false;
+            printBucketPerf("NTC", bucket, perf.ntc, perf.baselineNtc);
+            printBucketPerf("NTCa", bucket, perf.accelerated, perf.baselineAccelerated);
         }
     }
 
+    if (!baselineResults.empty())
+    {
+        printf("Regressions: %d quality (tolerance %.3f dB), %d speed (tolerance %.1f%%)\n",
+            qualityRegressionCount, g_options.psnrTolerance, speedRegressionCount, g_options.speedTolerance);
+    }
+
+
+    // Save the results into a CSV file, if requested by the user
+    if (g_options.csvOutputPath)
+    {
+        FILE* csvFile = OpenCsvFile();
+        if (!csvFile)
+            return false;
+
+        for (Result const& result : results)
+            WriteCsvRow(csvFile, result);
+        
+        fclose(csvFile);
+    }
+
     return true;
 }
 
@@ -1154,24 +1452,26 @@ int main(int argc, const char** argv)
         printf("Loaded %d baseline results from '%s'\n", int(baselineResults.size()), g_options.loadBaselinePath);
     }
 
-    std::unique_ptr<donut::app::DeviceManager> deviceManager = InitGraphicsDevice();
-    if (!deviceManager)
-        return 1;
-
-    ntc::ContextWrapper context;
-    if (!InitNtcContext(deviceManager->GetDevice(), context))
-        return 1;
+    std::vector<std::unique_ptr<TestWorker>> workers;
+    for (int adapterIndex : g_adapterIndices)
+    {
+        auto worker = std::make_unique<TestWorker>();
+        if (!worker->Init(adapterIndex))
+            return 1;
+        workers.push_back(std::move(worker));
+    }
 
     signal(SIGINT, SigintHandler);
 
     ntc::BlockCompressedFormat format = ParseBlockCompressedFormat(g_options.format).value_or(ntc::BlockCompressedFormat::None);
     std::vector<fs::path> sourceFiles = EnumerateSourceFiles();
     std::vector<Result> results;
-    if (!RunTests(sourceFiles, results, format, context, deviceManager->GetDevice()))
+    if (!RunTests(sourceFiles, results, format, workers) && !g_Terminate)
         return 1;
 
+    // Process the partial results when the test was interrupted, too
     if (!ProcessResults(format, baselineResults, results))
         return 1;
 
-    return 0;
+    return g_Terminate ? 1 : 0;
 }
\ No newline at end of file
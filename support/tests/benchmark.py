@@ -0,0 +1,147 @@
+# SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+#
+# NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+# property and proprietary rights in and to this material, related
+# documentation and any modifications thereto. Any use, reproduction,
+# disclosure or distribution of this material and related documentation
+# without an express license agreement from NVIDIA CORPORATION or
+# its affiliates is strictly prohibited.
+
+# Runs graphics API decompression benchmarks over a corpus of compressed texture sets, for every combination
+# of graphics API and inference weight type, and optionally compares the results with a previous run.
+# See docs/CommandLineTool.md, section "Decompression benchmarks", for usage.
+
+import os
+import sys
+import csv
+import json
+import argparse
+
+# add ../../libraries to the path to import ntc
+sdkroot = os.path.dirname(os.path.dirname(os.path.dirname(os.path.realpath(__file__))))
+sys.path.append(os.path.join(sdkroot, 'libraries'))
+
+import ntc
+
+parser = argparse.ArgumentParser()
+parser.add_argument('corpus', nargs = '*', default = [os.path.join(sdkroot, 'assets/testfiles')],
+                    help = 'Compressed texture set files or directories to search for .ntc files')
+parser.add_argument('--apis', nargs = '+', default = ['vk', 'dx12'] if os.name == 'nt' else ['vk'],
+                    choices = ['vk', 'dx12'], help = 'Graphics APIs to test')
+parser.add_argument('--weightTypes', nargs = '+', default = ['Int8', 'FP8', 'CoopVec'],
+                    help = 'Inference weight types to test, combinations not supported by the GPU are skipped')
+parser.add_argument('--iterations', type = int, default = 20, help = 'Number of decompression iterations per test')
+parser.add_argument('--adapter', type = int, help = 'Graphics adapter index')
+parser.add_argument('--allMips', action = 'store_true', help = 'Decompress all mip levels instead of just the first one')
+parser.add_argument('--saveCsv', metavar = 'FILE', help = 'Save the results into a CSV file')
+parser.add_argument('--saveJson', metavar = 'FILE', help = 'Save the results into a JSON file')
+parser.add_argument('--loadBaseline', metavar = 'FILE', help = 'Load previous results from a CSV or JSON file for comparison')
+parser.add_argument('--regressionThreshold', type = float, default = 5.0,
+                    help = 'Report a regression when a test is slower than the baseline by this many percent, default is 5')
+args = parser.parse_args()
+
+FIELDS = ['file', 'width', 'height', 'mips', 'bpp', 'api', 'weightType', 'gpu',
+          'timeMs', 'mpixPerSecond', 'readMB', 'writtenMB']
+
+def find_ntc_files(paths):
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            for root, dirs, names in os.walk(path):
+                files += [os.path.join(root, name) for name in names if name.lower().endswith('.ntc')]
+        else:
+            files.append(path)
+    return sorted(files)
+
+def result_key(row):
+    return row['file'], row['api'], row['weightType'].lower()
+
+def load_rows(fileName):
+    with open(fileName, 'r', newline = '') as f:
+        if fileName.lower().endswith('.json'):
+            rows = json.load(f)
+        else:
+            rows = list(csv.DictReader(f))
+    for row in rows:
+        row['timeMs'] = float(row['timeMs'])
+    return rows
+
+files = find_ntc_files(args.corpus)
+if not files:
+    print('No compressed texture sets found.')
+    sys.exit(1)
+
+rows = []
+for fileName in files:
+    shortName = os.path.relpath(fileName, sdkroot) if fileName.startswith(sdkroot) else fileName
+    for api in args.apis:
+        for weightType in args.weightTypes:
+            task = ntc.Arguments(
+                tool=ntc.get_default_tool_path(),
+                loadCompressed=fileName,
+                decompress=True,
+                describe=True,
+                graphicsApi=api,
+                adapter=args.adapter,
+                weightType=weightType,
+                saveMips=args.allMips,
+                benchmark=max(args.iterations, 2)
+            )
+
+            try:
+                result = ntc.run(task)
+            except ntc.RuntimeError as e:
+                message = e.stderr.strip().splitlines()
+                print(f'{shortName} {api} {weightType}: skipped ({message[-1] if message else e.returncode})')
+                continue
+
+            row = {
+                'file': shortName,
+                'width': result.dimensions[0] if result.dimensions else 0,
+                'height': result.dimensions[1] if result.dimensions else 0,
+                'mips': result.mipLevels if args.allMips else 1,
+                'bpp': result.bitsPerPixel,
+                'api': api,
+                'weightType': result.decompressionWeightType or weightType,
+                'gpu': result.gpuName,
+                'timeMs': result.decompressionTime,
+                'mpixPerSecond': result.decompressionThroughput,
+                'readMB': (result.decompressionBytesRead or 0) * 1e-6,
+                'writtenMB': (result.decompressionBytesWritten or 0) * 1e-6
+            }
+            rows.append(row)
+            print(f'{shortName} {row["width"]}x{row["height"]} {row["bpp"]:.2f} bpp {api} {row["weightType"]}: '
+                  f'{row["timeMs"]:.3f} ms, {row["mpixPerSecond"]:.1f} Mpix/s')
+
+if args.saveCsv:
+    with open(args.saveCsv, 'w', newline = '') as f:
+        writer = csv.DictWriter(f, fieldnames = FIELDS)
+        writer.writeheader()
+        writer.writerows(rows)
+
+if args.saveJson:
+    with open(args.saveJson, 'w') as f:
+        json.dump(rows, f, indent = 2)
+
+if not args.loadBaseline:
+    sys.exit(0)
+
+baseline = { result_key(row): row for row in load_rows(args.loadBaseline) }
+
+regressions = 0
+compared = 0
+for row in rows:
+    baselineRow = baseline.get(result_key(row))
+    if baselineRow is None or baselineRow['timeMs'] <= 0:
+        continue
+    compared += 1
+    change = 100.0 * (row['timeMs'] - baselineRow['timeMs']) / baselineRow['timeMs']
+    regressed = change > args.regressionThreshold
+    if regressed:
+        regressions += 1
+    print(f'{row["file"]} {row["api"]} {row["weightType"]}: {baselineRow["timeMs"]:.3f} -> {row["timeMs"]:.3f} ms '
+          f'({change:+.1f}%){" REGRESSION" if regressed else ""}')
+
+print(f'Compared {compared} test(s) with the baseline, {regressions} regression(s).')
+sys.exit(1 if regressions > 0 else 0)
@@ -16,9 +16,19 @@
 #include <donut/engine/TextureCache.h>
 #include <donut/app/DeviceManager.h>
 #include <ntc-utils/GraphicsImageDifferencePass.h>
+#include <ntc-utils/Manifest.h>
 #include <argparse.h>
+#include <json/json.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <fstream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
 #include <filesystem>
 
 namespace fs = std::filesystem;
@@ -26,13 +36,21 @@ namespace fs = std::filesystem;
 struct
 {
     std::vector<char const*> sources;
+    char const* pairsPath = nullptr;
+    char const* jsonOutputPath = nullptr;
     bool useVulkan = false;
     bool useDX12 = false;
     bool debug = false;
+    bool ignoreExtensions = false;
     int adapterIndex = -1;
     int numChannels = 0;
+    int threads = 0;
+    int batchSize = 256;
 } g_options;
 
+// The maximum number of mip levels in one texture, limited by the texture cache setting in main()
+static const int g_maxMipLevels = 15;
+
 bool ProcessCommandLine(int argc, const char** argv)
 {
     struct argparse_option options[] = {
@@ -46,17 +64,25 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_BOOLEAN(0, "debug", &g_options.debug, "Enable debug features such as Vulkan validation layer or D3D12 debug runtime"),
         OPT_INTEGER(0, "adapter", &g_options.adapterIndex, "Index of the graphics adapter to use"),
         OPT_INTEGER(0, "channels", &g_options.numChannels, "Number of channels to compare (0 = auto-detect, default)"),
+        OPT_STRING(0, "pairs", &g_options.pairsPath, "Load the image pairs to compare from a JSON file with an array of [path1, path2] arrays"),
+        OPT_BOOLEAN(0, "ignoreExtensions", &g_options.ignoreExtensions, "When comparing directories, match files by their relative paths without extensions"),
+        OPT_STRING(0, "json", &g_options.jsonOutputPath, "Save the comparison results into this JSON file"),
+        OPT_INTEGER(0, "threads", &g_options.threads, "Number of threads to use for loading images"),
+        OPT_INTEGER(0, "batch", &g_options.batchSize, "Maximum number of mip level comparisons per GPU submission (default 256)"),
         OPT_END()
     };
 
     static const char* usages[] = {
         "imagediff.exe <paths...> [options...]",
+        "imagediff.exe <directory1> <directory2> [options...]",
+        "imagediff.exe --pairs <file.json> [options...]",
         nullptr
     };
 
     struct argparse argparse {};
     argparse_init(&argparse, options, usages, 0);
-    argparse_describe(&argparse, "\nImage comparison tool.\nInput files must be provided in pairs.", nullptr);
+    argparse_describe(&argparse, "\nImage comparison tool.\nInput files must be provided in pairs. "
+        "When two directories are provided, files with matching relative paths are compared.", nullptr);
     argparse_parse(&argparse, argc, argv);
 
     if (g_options.useVulkan && g_options.useDX12)
@@ -90,12 +116,26 @@ bool ProcessCommandLine(int argc, const char** argv)
         g_options.sources.push_back(arg);
     }
 
-    if (g_options.sources.size() == 0 || (g_options.sources.size() & 1) != 0)
+    if (g_options.pairsPath)
+    {
+        if (!g_options.sources.empty())
+        {
+            fprintf(stderr, "Input paths cannot be specified together with --pairs.\n");
+            return false;
+        }
+    }
+    else if (g_options.sources.size() == 0 || (g_options.sources.size() & 1) != 0)
     {
         fprintf(stderr, "An even number of input paths must be specified.\n");
         return false;
     }
 
+    if (g_options.batchSize < g_maxMipLevels)
+    {
+        fprintf(stderr, "The --batch value must be at least %d.\n", g_maxMipLevels);
+        return false;
+    }
+
     return true;
 }
 
@@ -172,118 +212,530 @@ int GetChannelCountForFormat(nvrhi::Format format)
     return numChannels;
 }
 
-bool CompareTwoImages(nvrhi::IDevice* device, nvrhi::ICommandList* commandList,
-    donut::engine::TextureCache& textureCache,
-    ntc::IContext* ntcContext,
-    int pairIndex,
-    char const* source1, char const* source2)
+struct ImagePair
+{
+    int index = 0;
+    std::string source1;
+    std::string source2;
+
+    std::shared_ptr<donut::engine::LoadedTexture> texture1;
+    std::shared_ptr<donut::engine::LoadedTexture> texture2;
+    int mipLevels = 0;
+    int numChannels = 0;
+    uint32_t firstQuery = 0;
+
+    std::vector<float> mse;
+    std::vector<float> psnr;
+    std::string error;
+};
+
+static bool IsImageFile(fs::path const& path)
+{
+    std::string extension = path.extension().string();
+    LowercaseString(extension);
+
+    return extension == ".png" || extension == ".tga" || extension == ".jpg" || extension == ".jpeg"
+        || extension == ".bmp" || extension == ".exr" || extension == ".hdr" || extension == ".dds";
+}
+
+// Finds all image files in the directory and returns them keyed by their relative paths,
+// optionally without extensions.
+static std::map<std::string, fs::path> EnumerateImageFiles(fs::path const& directory)
+{
+    std::map<std::string, fs::path> result;
+    for (auto const& entry : fs::recursive_directory_iterator(directory))
+    {
+        if (!entry.is_regular_file() || !IsImageFile(entry.path()))
+            continue;
+
+        fs::path relativePath = fs::relative(entry.path(), directory);
+        if (g_options.ignoreExtensions)
+            relativePath.replace_extension();
+
+        auto [it, inserted] = result.try_emplace(relativePath.generic_string(), entry.path());
+        if (!inserted)
+        {
+            // Files like Color.png and Color.dds map to the same name without extensions.
+            // The directory iteration order is unspecified, so pick the same file on every run.
+            fs::path const& ignoredPath = std::max(it->second, entry.path());
+            fprintf(stderr, "Warning: '%s' and '%s' have the same name without extension, ignoring '%s'\n",
+                it->second.string().c_str(), entry.path().string().c_str(), ignoredPath.string().c_str());
+            it->second = std::min(it->second, entry.path());
+        }
+    }
+    return result;
+}
+
+// Builds the list of image pairs from the command line: either explicit file pairs, two directories, or a JSON file.
+static bool CollectImagePairs(std::vector<std::shared_ptr<ImagePair>>& outPairs)
+{
+    auto addPair = [&outPairs](std::string const& source1, std::string const& source2)
+    {
+        auto pair = std::make_shared<ImagePair>();
+        pair->index = int(outPairs.size());
+        pair->source1 = source1;
+        pair->source2 = source2;
+        outPairs.push_back(pair);
+    };
+
+    if (g_options.pairsPath)
+    {
+        std::ifstream file(g_options.pairsPath);
+        if (!file.is_open())
+        {
+            fprintf(stderr, "Cannot open file '%s'\n", g_options.pairsPath);
+            return false;
+        }
+
+        Json::CharReaderBuilder builder;
+        Json::Value root;
+        Json::String errorMessages;
+        if (!Json::parseFromStream(builder, file, &root, &errorMessages))
+        {
+            fprintf(stderr, "Failed to parse '%s': %s\n", g_options.pairsPath, errorMessages.c_str());
+            return false;
+        }
+
+        if (!root.isArray())
+        {
+            fprintf(stderr, "The root of '%s' must be an array.\n", g_options.pairsPath);
+            return false;
+        }
+
+        for (Json::Value const& node : root)
+        {
+            if (!node.isArray() || node.size() != 2 || !node[0].isString() || !node[1].isString())
+            {
+                fprintf(stderr, "Every item in '%s' must be an array of two paths.\n", g_options.pairsPath);
+                return false;
+            }
+            addPair(node[0].asString(), node[1].asString());
+        }
+        return true;
+    }
+
+    for (size_t inputIndex = 0; inputIndex < g_options.sources.size(); inputIndex += 2)
+    {
+        fs::path const source1 = g_options.sources[inputIndex];
+        fs::path const source2 = g_options.sources[inputIndex + 1];
+
+        if (!fs::is_directory(source1) && !fs::is_directory(source2))
+        {
+            addPair(source1.string(), source2.string());
+            continue;
+        }
+
+        if (!fs::is_directory(source1) || !fs::is_directory(source2))
+        {
+            fprintf(stderr, "Cannot compare a directory with a file: '%s' and '%s'\n",
+                source1.string().c_str(), source2.string().c_str());
+            return false;
+        }
+
+        std::map<std::string, fs::path> const files1 = EnumerateImageFiles(source1);
+        std::map<std::string, fs::path> const files2 = EnumerateImageFiles(source2);
+
+        for (auto const& [name, path1] : files1)
+        {
+            auto it = files2.find(name);
+            if (it == files2.end())
+            {
+                fprintf(stderr, "Warning: '%s' has no match in '%s'\n", path1.string().c_str(), source2.string().c_str());
+                continue;
+            }
+            addPair(path1.string(), it->second.string());
+        }
+
+        for (auto const& [name, path2] : files2)
+        {
+            if (files1.find(name) == files1.end())
+                fprintf(stderr, "Warning: '%s' has no match in '%s'\n", path2.string().c_str(), source1.string().c_str());
+        }
+    }
+
+    return true;
+}
+
+// Protects the command queue, which is used by the loader threads and the main thread
+static std::mutex g_submitMutex;
+
+// Loads both images of the pair and validates that they can be compared. Runs on the loader threads.
+static bool LoadImagePair(nvrhi::IDevice* device, nvrhi::ICommandList* commandList,
+    donut::engine::TextureCache& textureCache, ImagePair& pair)
 {
     commandList->open();
     
-    std::shared_ptr<donut::engine::LoadedTexture> texture1 = textureCache.LoadTextureFromFile(
-        source1, false, nullptr, commandList);
+    pair.texture1 = textureCache.LoadTextureFromFile(pair.source1, false, nullptr, commandList);
 
-    bool const sRGB = (texture1->texture && nvrhi::getFormatInfo(texture1->texture->getDesc().format).isSRGB);
+    bool const sRGB = (pair.texture1->texture && nvrhi::getFormatInfo(pair.texture1->texture->getDesc().format).isSRGB);
 
-    std::shared_ptr<donut::engine::LoadedTexture> texture2 = textureCache.LoadTextureFromFile(
-        source2, sRGB, nullptr, commandList);
+    pair.texture2 = textureCache.LoadTextureFromFile(pair.source2, sRGB, nullptr, commandList);
 
     commandList->close();
-    device->executeCommandList(commandList);
+    {
+        std::lock_guard<std::mutex> lock(g_submitMutex);
+        device->executeCommandList(commandList);
+    }
 
-    if (!texture1->texture)
+    char buf[256];
+    if (!pair.texture1->texture)
     {
-        fprintf(stderr, "Failed to load texture from %s\n", source1);
+        snprintf(buf, sizeof(buf), "Failed to load texture from %s", pair.source1.c_str());
+        pair.error = buf;
         return false;
     }
 
-    if (!texture2->texture)
+    if (!pair.texture2->texture)
     {
-        fprintf(stderr, "Failed to load texture from %s\n", source2);
+        snprintf(buf, sizeof(buf), "Failed to load texture from %s", pair.source2.c_str());
+        pair.error = buf;
         return false;
     }
 
-    nvrhi::TextureDesc const& desc1 = texture1->texture->getDesc();
-    nvrhi::TextureDesc const& desc2 = texture2->texture->getDesc();
+    nvrhi::TextureDesc const& desc1 = pair.texture1->texture->getDesc();
+    nvrhi::TextureDesc const& desc2 = pair.texture2->texture->getDesc();
 
     if (desc1.width != desc2.width || desc1.height != desc2.height)
     {
-        fprintf(stderr, "Input images have different dimensions: %ux%u and %ux%u\n",
+        snprintf(buf, sizeof(buf), "Input images have different dimensions: %ux%u and %ux%u",
             desc1.width, desc1.height, desc2.width, desc2.height);
+        pair.error = buf;
         return false;
     }
 
-    int const mipLevels = std::min(desc1.mipLevels, desc2.mipLevels);
+    pair.mipLevels = std::min(int(std::min(desc1.mipLevels, desc2.mipLevels)), g_maxMipLevels);
     if (desc1.mipLevels != desc2.mipLevels)
     {
-        fprintf(stderr, "Warning: Input images have different mip level counts: %u and %u. Using the smaller count.\n",
-            desc1.mipLevels, desc2.mipLevels);
+        fprintf(stderr, "Warning: Input images for pair %d have different mip level counts: %u and %u. "
+            "Using the smaller count.\n", pair.index, desc1.mipLevels, desc2.mipLevels);
     }
 
-    int numChannels = g_options.numChannels;
-    if (numChannels <= 0)
+    pair.numChannels = g_options.numChannels;
+    if (pair.numChannels <= 0)
     {
         int const numChannels1 = GetChannelCountForFormat(desc1.format);
         int const numChannels2 = GetChannelCountForFormat(desc2.format);
-        numChannels = std::min(numChannels1, numChannels2);
+        pair.numChannels = std::min(numChannels1, numChannels2);
         if (numChannels1 != numChannels2)
         {
-            fprintf(stderr, "Warning: Input images have different channel counts: %d and %d. Using the smaller count.\n",
-                numChannels1, numChannels2);
+            fprintf(stderr, "Warning: Input images for pair %d have different channel counts: %d and %d. "
+                "Using the smaller count.\n", pair.index, numChannels1, numChannels2);
         }
     }
 
-    GraphicsImageDifferencePass imageDifferencePass(device, mipLevels);
-    if (!imageDifferencePass.Init())
-    {
-        fprintf(stderr, "Failed to initialize the image difference pass.\n");
-        return false;
-    }
+    return true;
+}
 
-    commandList->open();
+// Records the comparison passes for all mip levels of the pair into an open command list.
+static bool RecordPairComparison(nvrhi::ICommandList* commandList, ntc::IContext* ntcContext,
+    GraphicsImageDifferencePass& imageDifferencePass, ImagePair& pair, uint32_t firstQuery)
+{
+    pair.firstQuery = firstQuery;
 
-    for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
+    nvrhi::TextureDesc const& desc = pair.texture1->texture->getDesc();
+    for (int mipLevel = 0; mipLevel < pair.mipLevels; ++mipLevel)
     {
-        uint32_t mipWidth = std::max(1u, desc1.width >> mipLevel);
-        uint32_t mipHeight = std::max(1u, desc1.height >> mipLevel);
+        uint32_t mipWidth = std::max(1u, desc.width >> mipLevel);
+        uint32_t mipHeight = std::max(1u, desc.height >> mipLevel);
+        uint32_t const queryIndex = firstQuery + uint32_t(mipLevel);
 
         ntc::MakeImageDifferenceComputePassParameters imageDifferenceParams = {};
         imageDifferenceParams.extent.width = int(mipWidth);
         imageDifferenceParams.extent.height = int(mipHeight);
-        imageDifferenceParams.outputOffset = imageDifferencePass.GetOffsetForQuery(mipLevel);
+        imageDifferenceParams.outputOffset = imageDifferencePass.GetOffsetForQuery(queryIndex);
         ntc::ComputePassDesc computePass = {};
         ntc::Status ntcStatus = ntcContext->MakeImageDifferenceComputePass(imageDifferenceParams, &computePass);
         CHECK_NTC_RESULT(MakeImageDifferenceComputePass);
 
-        imageDifferencePass.ExecuteComputePass(
+        if (!imageDifferencePass.ExecuteComputePass(
             commandList, computePass,
-            texture1->texture, mipLevel,
-            texture2->texture, mipLevel,
-            /* queryIndex = */ mipLevel);
+            pair.texture1->texture, mipLevel,
+            pair.texture2->texture, mipLevel,
+            queryIndex))
+        {
+            fprintf(stderr, "Failed to execute the image difference pass.\n");
+            return false;
+        }
     }
 
-    commandList->close();
-    device->executeCommandList(commandList);
+    return true;
+}
+
+// Waits for the results of a submitted batch and stores them in its pairs.
+static bool ReadBatchResults(nvrhi::IDevice* device, GraphicsImageDifferencePass& imageDifferencePass,
+    uint32_t batchIndex, std::vector<std::shared_ptr<ImagePair>>& batch, donut::engine::TextureCache& textureCache)
+{
+    bool ready = false;
+    while (!ready)
+    {
+        if (!imageDifferencePass.PollResults(batchIndex, ready))
+        {
+            fprintf(stderr, "Failed to read image difference results from the GPU.\n");
+            return false;
+        }
+
+        if (!ready)
+            std::this_thread::yield();
+    }
+
+    for (std::shared_ptr<ImagePair> const& pair : batch)
+    {
+        pair->mse.resize(pair->mipLevels);
+        pair->psnr.resize(pair->mipLevels);
+
+        for (int mipLevel = 0; mipLevel < pair->mipLevels; ++mipLevel)
+        {
+            if (!imageDifferencePass.GetQueryResult(pair->firstQuery + uint32_t(mipLevel), nullptr,
+                &pair->mse[mipLevel], &pair->psnr[mipLevel], pair->numChannels))
+            {
+                fprintf(stderr, "Failed to get image difference results for mip level %d.\n", mipLevel);
+                return false;
+            }
+        }
+
+        // The textures are not needed anymore, release them to keep the memory usage bounded
+        textureCache.UnloadTexture(pair->texture1);
+        textureCache.UnloadTexture(pair->texture2);
+        pair->texture1.reset();
+        pair->texture2.reset();
+    }
 
-    if (!imageDifferencePass.ReadResults())
+    batch.clear();
+
+    // Destroy the released textures and upload buffers now. There is no frame loop in this tool that
+    // would do it otherwise, and the memory usage would grow with every batch.
     {
-        fprintf(stderr, "Failed to read image difference results from the GPU.\n");
+        std::lock_guard<std::mutex> lock(g_submitMutex);
+        device->runGarbageCollection();
+    }
+
+    return true;
+}
+
+// Compares all the pairs. The images are loaded on multiple threads, and the comparisons for many pairs
+// are recorded into one command list and submitted together. The results of each batch are read back
+// after the next batch is submitted, so that the GPU work overlaps with the readback and loading.
+static bool CompareImagePairs(nvrhi::IDevice* device, donut::engine::TextureCache& textureCache,
+    ntc::IContext* ntcContext, std::vector<std::shared_ptr<ImagePair>> const& pairs)
+{
+    GraphicsImageDifferencePass imageDifferencePass(device, uint32_t(g_options.batchSize), 2);
+    if (!imageDifferencePass.Init())
+    {
+        fprintf(stderr, "Failed to initialize the image difference pass.\n");
         return false;
     }
 
-    for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
+    std::atomic<size_t> nextPairIndex = 0;
+    std::queue<std::shared_ptr<ImagePair>> loadedPairs;
+    std::mutex loadedPairsMutex;
+    
+    // Limit the number of loaded pairs waiting for comparison to keep the memory usage bounded
+    size_t const maxLoadedPairs = size_t(g_options.batchSize) * 2;
+
+    int numThreads = g_options.threads > 0 ? g_options.threads : std::thread::hardware_concurrency();
+    numThreads = std::max(std::min(int(pairs.size()), numThreads), 1);
+    std::atomic<int> liveThreads = numThreads;
+    std::atomic<bool> terminate = false;
+
+    std::vector<std::shared_ptr<std::thread>> threads;
+    for (int i = 0; i < numThreads; ++i)
     {
-        float mse = 0;
-        float psnr = 0;
-        if (!imageDifferencePass.GetQueryResult(mipLevel, nullptr, &mse, &psnr, numChannels))
+        auto thread = std::make_shared<std::thread>([device, &textureCache, &pairs, &nextPairIndex, &loadedPairs,
+            &loadedPairsMutex, maxLoadedPairs, &liveThreads, &terminate]()
         {
-            fprintf(stderr, "Failed to get image difference results for mip level %d.\n", mipLevel);
-            return 1;
+            nvrhi::CommandListHandle commandList = device->createCommandList();
+
+            while (!terminate)
+            {
+                size_t const pairIndex = nextPairIndex++;
+                if (pairIndex >= pairs.size())
+                    break;
+
+                ImagePair& pair = *pairs[pairIndex];
+                if (!LoadImagePair(device, commandList, textureCache, pair))
+                    fprintf(stderr, "Pair %d: %s\n", pair.index, pair.error.c_str());
+
+                // Wait until there is space in the queue
+                while (!terminate)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(loadedPairsMutex);
+                        if (loadedPairs.size() < maxLoadedPairs)
+                        {
+                            loadedPairs.push(pairs[pairIndex]);
+                            break;
+                        }
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            --liveThreads;
+        });
+        threads.push_back(thread);
+    }
+
+    nvrhi::CommandListHandle commandList = device->createCommandList();
+    std::vector<std::shared_ptr<ImagePair>> currentBatch;
+    std::vector<std::shared_ptr<ImagePair>> pendingBatch;
+    uint32_t pendingBatchIndex = 0;
+    uint32_t numQueries = 0;
+    bool success = true;
+
+    auto submitBatch = [&]()
+    {
+        commandList->close();
+        {
+            std::lock_guard<std::mutex> lock(g_submitMutex);
+            device->executeCommandList(commandList);
+        }
+        uint32_t const batchIndex = imageDifferencePass.EndBatch();
+        numQueries = 0;
+
+        if (!pendingBatch.empty() && !ReadBatchResults(device, imageDifferencePass, pendingBatchIndex, pendingBatch, textureCache))
+            return false;
+
+        pendingBatch.swap(currentBatch);
+        pendingBatchIndex = batchIndex;
+        return true;
+    };
+
+    while (success)
+    {
+        // Sample the counter before looking at the queue: if all loaders were done at that point,
+        // an empty queue means that there are no more pairs.
+        bool const loadersFinished = liveThreads <= 0;
+
+        std::shared_ptr<ImagePair> pair;
+        {
+            std::lock_guard<std::mutex> lock(loadedPairsMutex);
+            if (!loadedPairs.empty())
+            {
+                pair = loadedPairs.front();
+                loadedPairs.pop();
+            }
+        }
+
+        if (!pair)
+        {
+            // Don't let the GPU idle while the next images are loading
+            if (!currentBatch.empty())
+                success = submitBatch();
+            else if (loadersFinished)
+                break;
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        if (!pair->error.empty())
+        {
+            if (pair->texture1)
+                textureCache.UnloadTexture(pair->texture1);
+            if (pair->texture2)
+                textureCache.UnloadTexture(pair->texture2);
+            pair->texture1.reset();
+            pair->texture2.reset();
+            continue;
+        }
+
+        if (numQueries + uint32_t(pair->mipLevels) > uint32_t(g_options.batchSize))
+        {
+            success = submitBatch();
+            if (!success)
+                break;
+        }
+
+        if (currentBatch.empty())
+            commandList->open();
+
+        if (!RecordPairComparison(commandList, ntcContext, imageDifferencePass, *pair, numQueries))
+        {
+            commandList->close();
+            success = false;
+            break;
+        }
+
+        numQueries += uint32_t(pair->mipLevels);
+        currentBatch.push_back(pair);
+    }
+
+    if (success && !currentBatch.empty())
+        success = submitBatch();
+
+    if (success && !pendingBatch.empty())
+        success = ReadBatchResults(device, imageDifferencePass, pendingBatchIndex, pendingBatch, textureCache);
+
+    terminate = true;
+    for (auto& thread : threads)
+        thread->join();
+
+    device->waitForIdle();
+
+    return success;
+}
+
+// Prints the results in the order of the pairs. The pairs are compared in the order in which they are loaded,
+// which varies between runs, so the results are not printed as they come in.
+static void PrintResults(std::vector<std::shared_ptr<ImagePair>> const& pairs)
+{
+    for (std::shared_ptr<ImagePair> const& pair : pairs)
+    {
+        for (size_t mipLevel = 0; mipLevel < pair->mse.size(); ++mipLevel)
+        {
+            printf("PAIR %d MIP %2d: MSE = %.4f, PSNR = %.2f dB\n", pair->index, int(mipLevel),
+                pair->mse[mipLevel], pair->psnr[mipLevel]);
+        }
+    }
+}
+
+static bool SaveJsonReport(std::vector<std::shared_ptr<ImagePair>> const& pairs)
+{
+    Json::Value root(Json::objectValue);
+    Json::Value& pairsNode = root["pairs"];
+    pairsNode = Json::Value(Json::arrayValue);
+    
+    for (std::shared_ptr<ImagePair> const& pair : pairs)
+    {
+        Json::Value pairNode(Json::objectValue);
+        pairNode["index"] = pair->index;
+        pairNode["source1"] = pair->source1;
+        pairNode["source2"] = pair->source2;
+
+        if (!pair->error.empty())
+        {
+            pairNode["error"] = pair->error;
+        }
+        else
+        {
+            pairNode["channels"] = pair->numChannels;
+            Json::Value& mipsNode = pairNode["mips"];
+            mipsNode = Json::Value(Json::arrayValue);
+            for (size_t mipLevel = 0; mipLevel < pair->mse.size(); ++mipLevel)
+            {
+                Json::Value mipNode(Json::objectValue);
+                mipNode["mse"] = pair->mse[mipLevel];
+                // Identical images have infinite PSNR which can't be represented in JSON
+                mipNode["psnr"] = std::isfinite(pair->psnr[mipLevel]) ? Json::Value(pair->psnr[mipLevel]) : Json::Value();
+                mipsNode.append(mipNode);
+            }
         }
 
-        printf("PAIR %d MIP %2d: MSE = %.4f, PSNR = %.2f dB\n", pairIndex, mipLevel, mse, psnr);
+        pairsNode.append(pairNode);
+    }
+
+    std::ofstream file(g_options.jsonOutputPath);
+    if (!file.is_open())
+    {
+        fprintf(stderr, "Cannot open file '%s'\n", g_options.jsonOutputPath);
+        return false;
     }
 
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(root, &file);
+    file << std::endl;
+
     return true;
 }
 
@@ -295,12 +747,21 @@ int main(int argc, const char** argv)
     if (!ProcessCommandLine(argc, argv))
         return 1;
 
+    std::vector<std::shared_ptr<ImagePair>> pairs;
+    if (!CollectImagePairs(pairs))
+        return 1;
+
+    if (pairs.empty())
+    {
+        fprintf(stderr, "No image pairs to compare.\n");
+        return 1;
+    }
+
     std::unique_ptr<donut::app::DeviceManager> deviceManager = InitGraphicsDevice();
     if (!deviceManager)
         return 1;
 
     nvrhi::DeviceHandle device = deviceManager->GetDevice();
-    nvrhi::CommandListHandle commandList = device->createCommandList();
 
     ntc::ContextWrapper ntcContext;
     if (!InitNtcContext(device, ntcContext))
@@ -312,12 +773,20 @@ int main(int argc, const char** argv)
     textureCache->SetGenerateMipmaps(false);
     textureCache->SetMaxTextureSize(16384);
 
-    for (size_t inputIndex = 0; inputIndex < g_options.sources.size(); inputIndex += 2)
+    if (!CompareImagePairs(device, *textureCache, ntcContext, pairs))
+        return 1;
+
+    PrintResults(pairs);
+
+    if (g_options.jsonOutputPath && !SaveJsonReport(pairs))
+        return 1;
+
+    // Mismatched or unloadable pairs are reported in the output, but the comparison still fails
+    for (std::shared_ptr<ImagePair> const& pair : pairs)
     {
-        if (!CompareTwoImages(device, commandList, *textureCache, ntcContext,
-            int(inputIndex / 2), g_options.sources[inputIndex], g_options.sources[inputIndex + 1]))
+        if (!pair->error.empty())
             return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -469,6 +469,46 @@ class BlockCompressionTestCase(TestCase):
                 self.fail(f'Image mismatch for {name} at MIP {mipLevel}: MSE={mse}, PSNR={psnr} dB, Expected PSNR >= {tolerance} dB')
             #print(f'{name} MIP {mipLevel}: {psnr} dB')
 
+class ImageDiffDirectoryTestCase(TestCase):
+
+    def __str__(self):
+        return 'ImageDiff Directories'
+
+    def runTest(self):
+        referenceImageDir = os.path.join(testFilesDir, 'PavingStones070_5bpp_DDS')
+        dir1 = os.path.join(scratchDir, 'dir1')
+        dir2 = os.path.join(scratchDir, 'dir2')
+
+        # The same images on both sides, with one of them in a subdirectory to test the recursive matching
+        names = ['AmbientOcclusion', 'Color', os.path.join('sub', 'Roughness')]
+        for name in names:
+            sourceFilePath = os.path.join(referenceImageDir, os.path.basename(name) + '.dds')
+            self.assertFileExists(sourceFilePath)
+            for dir in (dir1, dir2):
+                os.makedirs(os.path.dirname(os.path.join(dir, name)), exist_ok=True)
+                shutil.copyfile(sourceFilePath, os.path.join(dir, name + '.dds'))
+
+        # Color.png matches the same name as Color.dds when extensions are ignored, and the tool should
+        # warn about it and compare Color.dds
+        Image.new('RGB', (4, 4)).save(os.path.join(dir2, 'Color.png'))
+
+        warnings = []
+        compareResults = ntc.run_imagediff(ntc.get_default_imagediff_path(), [dir1, dir2], ['--ignoreExtensions'],
+            outWarnings=warnings)
+
+        self.assertTrue(any('have the same name without extension' in line for line in warnings))
+
+        mipLevels = 12
+        self.assertEqual(len(compareResults), len(names) * mipLevels)
+
+        # The results are printed in the order of pairs and mips, no matter which pair finished loading first
+        pairsAndMips = [(pair, mipLevel) for pair, mipLevel, _, _ in compareResults]
+        self.assertEqual(pairsAndMips, sorted(pairsAndMips))
+        self.assertEqual(sorted(set(pair for pair, _ in pairsAndMips)), list(range(len(names))))
+
+        for pair, mipLevel, mse, _ in compareResults:
+            self.assertEqual(mse, 0, f'Identical images differ in pair {pair} at MIP {mipLevel}')
+
 if __name__ == '__main__':
     parser = argparse.ArgumentParser()
     parser.add_argument('--noCuda', action = 'store_true', help = 'Disable CUDA tests')
@@ -500,6 +540,8 @@ if __name__ == '__main__':
             for featureLevel in (FL_DP4A, FL_COOPVEC):
                 suite.addTest(DecompressionTestCase(api=api, featureLevel=featureLevel))
             suite.addTest(BlockCompressionTestCase(api=api))
+
+    suite.addTest(ImageDiffDirectoryTestCase())
     
     runner = unittest.TextTestRunner(verbosity=2)
     runner.run(suite)
@@ -34,6 +34,7 @@ group.add_argument('--bitsPerPixel', default = None, type = float, help = 'Compr
 group.add_argument('--targetPsnr', default = None, type = float, help = 'Target PSNR value in dB for adaptive compressoin')
 parser.add_argument('--maxBitsPerPixel', default = None, type = float, help = 'Maximum bits per pixel value for adaptive compression')
 parser.add_argument('--devices', nargs = '*', default = [0], type = int, help = 'List of CUDA devices to use, such as --devices 0 1')
+parser.add_argument('--memoryFraction', default = None, type = float, help = 'Run several materials per device at once, as long as their estimated GPU memory usage fits into this fraction of the device memory, such as 0.8')
 parser.add_argument('--keepManifests', action = 'store_true', help = 'Don\'t delete the manifest files after compression')
 parser.add_argument('--output', required = True, help = 'Path to the output directory for the material NTC files')
 parser.add_argument('--skipExisting', action = 'store_true', help = 'Skip materials where the NTC file already exists')
@@ -573,7 +574,7 @@ def task_ready(task, result, originalTaskCount, tasksCompleted):
 print()
 print('Starting compression...')
 
-terminated = ntc.process_concurrent_tasks(tasks, args.devices, task_ready)
+terminated = ntc.process_concurrent_tasks(tasks, args.devices, task_ready, memoryFraction = args.memoryFraction)
 
 if terminated:
     sys.exit(2)
\ No newline at end of file
@@ -0,0 +1,28 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+// Compute shader that decodes a block-compressed texture into an uncompressed one, see BlockDecompressionPass.cpp.
+// The decoding itself is done by the texture sampling hardware when the input texture is loaded.
+
+Texture2D<float4> t_Input : register(t0);
+RWTexture2D<float4> u_Output : register(u0);
+
+[numthreads(8, 8, 1)]
+void main(uint2 pixel : SV_DispatchThreadID)
+{
+    uint width, height;
+    u_Output.GetDimensions(width, height);
+    if (pixel.x >= width || pixel.y >= height)
+        return;
+
+    u_Output[pixel] = t_Input[pixel];
+}
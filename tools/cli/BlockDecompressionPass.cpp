@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "BlockDecompressionPass.h"
+#include <donut/engine/ShaderFactory.h>
+#include <filesystem>
+
+#if NTC_WITH_DX12
+#include "compiled_shaders/BlockDecompression.dxil.h"
+#endif
+#if NTC_WITH_VULKAN
+#include "compiled_shaders/BlockDecompression.spirv.h"
+#endif
+
+using namespace donut;
+
+static constexpr int c_groupSize = 8;
+
+BlockDecompressionPass::BlockDecompressionPass(nvrhi::IDevice* device)
+    : m_device(device)
+{
+    m_shaderFactory = std::make_shared<engine::ShaderFactory>(device, nullptr, std::filesystem::path());
+}
+
+bool BlockDecompressionPass::Init()
+{
+    nvrhi::ShaderHandle shader = m_shaderFactory->CreateStaticPlatformShader(
+        DONUT_MAKE_PLATFORM_SHADER(g_BlockDecompression), nullptr, nvrhi::ShaderType::Compute);
+    if (!shader)
+        return false;
+
+    nvrhi::VulkanBindingOffsets vulkanBindingOffsets;
+    vulkanBindingOffsets
+        .setConstantBufferOffset(0)
+        .setSamplerOffset(0)
+        .setShaderResourceOffset(0)
+        .setUnorderedAccessViewOffset(0);
+
+    auto bindingLayoutDesc = nvrhi::BindingLayoutDesc()
+        .setVisibility(nvrhi::ShaderType::Compute)
+        .setBindingOffsets(vulkanBindingOffsets)
+        .addItem(nvrhi::BindingLayoutItem::Texture_SRV(0))
+        .addItem(nvrhi::BindingLayoutItem::Texture_UAV(0));
+
+    m_bindingLayout = m_device->createBindingLayout(bindingLayoutDesc);
+    if (!m_bindingLayout)
+        return false;
+
+    auto pipelineDesc = nvrhi::ComputePipelineDesc()
+        .setComputeShader(shader)
+        .addBindingLayout(m_bindingLayout);
+
+    m_pipeline = m_device->createComputePipeline(pipelineDesc);
+    return m_pipeline != nullptr;
+}
+
+bool BlockDecompressionPass::Decode(nvrhi::ICommandList* commandList, void const* blocks, nvrhi::Format blockFormat,
+    int bytesPerBlock, int width, int height, nvrhi::ITexture* outputTexture, int outputMipLevel)
+{
+    int const widthInBlocks = (width + 3) / 4;
+    int const heightInBlocks = (height + 3) / 4;
+
+    // BC textures must have dimensions that are multiples of the block size, so the input texture
+    // covers whole blocks and the shader only writes the pixels that exist in the output
+    auto inputTextureDesc = nvrhi::TextureDesc()
+        .setWidth(widthInBlocks * 4)
+        .setHeight(heightInBlocks * 4)
+        .setFormat(blockFormat)
+        .setDebugName("BlockDecompressionInput")
+        .setInitialState(nvrhi::ResourceStates::ShaderResource)
+        .setKeepInitialState(true);
+
+    nvrhi::TextureHandle inputTexture = m_device->createTexture(inputTextureDesc);
+    if (!inputTexture)
+        return false;
+
+    commandList->writeTexture(inputTexture, 0, 0, blocks, size_t(widthInBlocks) * size_t(bytesPerBlock));
+
+    auto bindingSetDesc = nvrhi::BindingSetDesc()
+        .addItem(nvrhi::BindingSetItem::Texture_SRV(0, inputTexture))
+        .addItem(nvrhi::BindingSetItem::Texture_UAV(0, outputTexture)
+            .setSubresources(nvrhi::TextureSubresourceSet().setBaseMipLevel(outputMipLevel)));
+
+    nvrhi::BindingSetHandle bindingSet = m_device->createBindingSet(bindingSetDesc, m_bindingLayout);
+    if (!bindingSet)
+        return false;
+
+    auto state = nvrhi::ComputeState()
+        .setPipeline(m_pipeline)
+        .addBindingSet(bindingSet);
+    commandList->setComputeState(state);
+    commandList->dispatch((width + c_groupSize - 1) / c_groupSize, (height + c_groupSize - 1) / c_groupSize);
+
+    return true;
+}
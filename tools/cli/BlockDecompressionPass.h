@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <nvrhi/nvrhi.h>
+#include <memory>
+
+namespace donut::engine
+{
+    class ShaderFactory;
+}
+
+// The BlockDecompressionPass class decodes BCn data on the GPU, used to read block-compressed DDS
+// files as compression sources. Every mip level is uploaded into a temporary BC texture and copied
+// into a level of the output texture, which must have the isUAV flag set and a float or UNORM format.
+class BlockDecompressionPass
+{
+public:
+    BlockDecompressionPass(nvrhi::IDevice* device);
+
+    bool Init();
+
+    // Decodes one mip level of BCn blocks with the given format and dimensions in pixels into the output
+    // texture mip level. The blocks must be tightly packed, in the row order of a DDS file.
+    // Note: Decode expects that the commandList is open, and leaves it open.
+    bool Decode(nvrhi::ICommandList* commandList, void const* blocks, nvrhi::Format blockFormat,
+        int bytesPerBlock, int width, int height, nvrhi::ITexture* outputTexture, int outputMipLevel);
+
+private:
+    nvrhi::DeviceHandle m_device;
+    std::shared_ptr<donut::engine::ShaderFactory> m_shaderFactory;
+    nvrhi::BindingLayoutHandle m_bindingLayout;
+    nvrhi::ComputePipelineHandle m_pipeline;
+};
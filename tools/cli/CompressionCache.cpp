@@ -0,0 +1,176 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "CompressionCache.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const char* c_CacheEntryExtension = ".ntc";
+
+void CacheKeyBuilder::AddBytes(void const* data, size_t size)
+{
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        m_hash ^= bytes[i];
+        m_hash *= 0x100000001b3ull;
+    }
+}
+
+bool CacheKeyBuilder::AddFile(char const* fileName)
+{
+    FILE* file = fopen(fileName, "rb");
+    if (!file)
+        return false;
+
+    std::vector<uint8_t> buffer(1 << 20);
+    uint64_t fileSize = 0;
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+    {
+        AddBytes(buffer.data(), bytesRead);
+        fileSize += bytesRead;
+    }
+
+    bool const success = !ferror(file);
+    fclose(file);
+
+    AddValue(fileSize);
+    return success;
+}
+
+std::string CacheKeyBuilder::GetKey() const
+{
+    char key[17];
+    snprintf(key, sizeof key, "%016" PRIx64, m_hash);
+    return key;
+}
+
+CompressionCache::CompressionCache(char const* directory, uint64_t maxSizeBytes)
+    : m_directory(directory)
+    , m_maxSizeBytes(maxSizeBytes)
+{ }
+
+std::string CompressionCache::GetEntryFileName(std::string const& key) const
+{
+    return (fs::path(m_directory) / (key + c_CacheEntryExtension)).generic_string();
+}
+
+bool CompressionCache::Lookup(std::string const& key, std::string& outFileName)
+{
+    std::string const fileName = GetEntryFileName(key);
+
+    std::error_code ec;
+    if (!fs::is_regular_file(fileName, ec))
+        return false;
+
+    // The modification time is used as the last use time for eviction
+    fs::last_write_time(fileName, fs::file_time_type::clock::now(), ec);
+
+    outFileName = fileName;
+    return true;
+}
+
+bool CompressionCache::Store(std::string const& key, char const* fileName)
+{
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+    if (!fs::is_directory(m_directory, ec))
+    {
+        fprintf(stderr, "Cannot create the cache directory '%s'.\n", m_directory.c_str());
+        return false;
+    }
+
+    // Copy into a temporary file first and rename it, so that other processes using the same cache
+    // never see a partially written entry.
+    std::string const entryFileName = GetEntryFileName(key);
+    std::string const tempFileName = entryFileName + "." + std::to_string(std::random_device()()) + ".tmp";
+
+    if (!fs::copy_file(fileName, tempFileName, fs::copy_options::overwrite_existing, ec))
+    {
+        fprintf(stderr, "Cannot copy '%s' into the cache: %s\n", fileName, ec.message().c_str());
+        return false;
+    }
+
+    fs::rename(tempFileName, entryFileName, ec);
+    if (ec)
+    {
+        fprintf(stderr, "Cannot store the cache entry '%s': %s\n", entryFileName.c_str(), ec.message().c_str());
+        fs::remove(tempFileName, ec);
+        return false;
+    }
+
+    EvictOldEntries(entryFileName);
+
+    return true;
+}
+
+void CompressionCache::EvictOldEntries(std::string const& keepFileName)
+{
+    if (m_maxSizeBytes == 0)
+        return;
+
+    struct Entry
+    {
+        fs::path path;
+        fs::file_time_type lastUse;
+        uint64_t size;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+
+    std::error_code ec;
+    for (fs::directory_entry const& item : fs::directory_iterator(m_directory, ec))
+    {
+        if (!item.is_regular_file(ec) || item.path().extension() != c_CacheEntryExtension)
+            continue;
+
+        Entry entry;
+        entry.path = item.path();
+        entry.lastUse = item.last_write_time(ec);
+        entry.size = item.file_size(ec);
+        if (ec)
+            continue;
+
+        totalSize += entry.size;
+        entries.push_back(std::move(entry));
+    }
+
+    if (totalSize <= m_maxSizeBytes)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b)
+    {
+        return a.lastUse < b.lastUse;
+    });
+
+    // Entries that are in use by other processes may fail to delete, that's not an error.
+    // The entry that was just stored is kept even if it doesn't fit alone.
+    for (Entry const& entry : entries)
+    {
+        if (totalSize <= m_maxSizeBytes)
+            break;
+
+        if (entry.path.generic_string() == keepFileName)
+            continue;
+
+        if (fs::remove(entry.path, ec))
+            totalSize -= entry.size;
+    }
+}
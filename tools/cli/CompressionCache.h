@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// Incremental 64-bit FNV-1a hash used to build compression cache keys
+class CacheKeyBuilder
+{
+public:
+    void AddBytes(void const* data, size_t size);
+
+    void AddString(std::string const& s)
+    {
+        AddValue(s.size());
+        AddBytes(s.data(), s.size());
+    }
+
+    template<typename T>
+    void AddValue(T const& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "AddValue only supports plain data types");
+        AddBytes(&value, sizeof(value));
+    }
+
+    // Adds the size and contents of a file, returns false if the file cannot be read
+    bool AddFile(char const* fileName);
+
+    // Returns the key as a 16-character hexadecimal string
+    std::string GetKey() const;
+
+private:
+    uint64_t m_hash = 0xcbf29ce484222325ull;
+};
+
+// A directory with compressed texture sets stored under their cache keys.
+// When the total size of the files exceeds the limit after storing a new entry,
+// the least recently used entries are deleted.
+class CompressionCache
+{
+public:
+    CompressionCache(char const* directory, uint64_t maxSizeBytes);
+
+    // Returns true and the path to the cached file if an entry exists, and marks the entry as recently used
+    bool Lookup(std::string const& key, std::string& outFileName);
+
+    // Copies the file into the cache under the provided key, then evicts old entries if needed
+    bool Store(std::string const& key, char const* fileName);
+
+private:
+    std::string m_directory;
+    uint64_t m_maxSizeBytes;
+
+    std::string GetEntryFileName(std::string const& key) const;
+    void EvictOldEntries(std::string const& keepFileName);
+};
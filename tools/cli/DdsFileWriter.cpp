@@ -0,0 +1,347 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "DdsFileWriter.h"
+#include <libdeflate.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Parameters of the DirectStorage GDeflate stream format: the data is split into tiles of 64 KB,
+// and the stream starts with a header followed by a table of 32-bit tile offsets.
+static const size_t c_GDeflateTileSize = 65536;
+static const size_t c_GDeflateMaxTiles = 65535;
+static const uint8_t c_GDeflateCodecId = 4;
+static const int c_GDeflateCompressionLevel = 9;
+
+struct GDeflateStreamHeader
+{
+    uint8_t id;             // c_GDeflateCodecId
+    uint8_t magic;          // id ^ 0xff
+    uint16_t numTiles;
+    uint32_t tileSizeInfo;  // Bits 0-1: tile size index, 1 means 64 KB; bits 2-19: size of the last tile, 0 if full
+};
+static_assert(sizeof(GDeflateStreamHeader) == 8);
+
+void DdsWriteBudget::Acquire(size_t bytes)
+{
+    std::unique_lock lock(m_mutex);
+    m_condition.wait(lock, [this, bytes]()
+    {
+        return m_pendingBytes == 0 || m_pendingBytes + bytes <= m_maxPendingBytes;
+    });
+    m_pendingBytes += bytes;
+}
+
+void DdsWriteBudget::Release(size_t bytes)
+{
+    std::lock_guard lock(m_mutex);
+    m_pendingBytes -= bytes;
+    m_condition.notify_all();
+}
+
+DdsFileWriter::~DdsFileWriter()
+{
+    Close();
+}
+
+bool DdsFileWriter::Open(char const* fileName, int width, int height, int mipLevels,
+    BcFormatDefinition const* formatDefinition, ntc::ColorSpace colorSpace, DdsWriteBudget* writeBudget,
+    bool gdeflate)
+{
+    m_fileName = fileName;
+    m_writeBudget = writeBudget;
+    m_failed = false;
+    m_gdeflate = gdeflate;
+
+#ifdef _WIN32
+    HANDLE const file = CreateFileA(fileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "Failed to open output file '%s', error code %lu.\n", fileName, GetLastError());
+        return false;
+    }
+    m_fileHandle = file;
+#else
+    m_fileDescriptor = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (m_fileDescriptor < 0)
+    {
+        fprintf(stderr, "Failed to open output file '%s': %s.\n", fileName, strerror(errno));
+        return false;
+    }
+#endif
+
+    m_mipOffsets.resize(mipLevels + 1);
+    m_mipOffsets[0] = sizeof(DdsFileHeader);
+    for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
+    {
+        int const mipWidth = std::max(width >> mipLevel, 1);
+        int const mipHeight = std::max(height >> mipLevel, 1);
+        m_mipOffsets[mipLevel + 1] = m_mipOffsets[mipLevel]
+            + uint64_t((mipWidth + 3) / 4) * uint64_t((mipHeight + 3) / 4) * formatDefinition->bytesPerBlock;
+    }
+
+    DdsFileHeader const header = MakeDdsFileHeader(width, height, mipLevels, formatDefinition, colorSpace);
+
+    if (m_gdeflate)
+    {
+        uint64_t const fileSize = m_mipOffsets.back();
+        size_t const numTiles = size_t((fileSize + c_GDeflateTileSize - 1) / c_GDeflateTileSize);
+        if (numTiles > c_GDeflateMaxTiles)
+        {
+            fprintf(stderr, "Output file '%s' is too large for a GDeflate stream.\n", fileName);
+            m_failed = true;
+            return false;
+        }
+
+        m_fileData.resize(size_t(fileSize));
+        m_compressedTiles = std::vector<std::vector<uint8_t>>(numTiles);
+        m_tileBytesMissing.resize(numTiles);
+        for (size_t tile = 0; tile < numTiles; ++tile)
+        {
+            uint64_t const tileEnd = std::min(uint64_t(tile + 1) * c_GDeflateTileSize, fileSize);
+            m_tileBytesMissing[tile] = uint32_t(tileEnd - uint64_t(tile) * c_GDeflateTileSize);
+        }
+
+        memcpy(m_fileData.data(), &header, sizeof(header));
+        if (!FillGDeflateRange(0, sizeof(header)))
+        {
+            fprintf(stderr, "Failed to compress the data for output file '%s'.\n", fileName);
+            m_failed = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    if (!WriteAt(&header, sizeof(header), 0))
+    {
+        fprintf(stderr, "Failed to write into output file '%s'.\n", fileName);
+        m_failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+size_t DdsFileWriter::GetMipSize(int mipLevel) const
+{
+    return size_t(m_mipOffsets[mipLevel + 1] - m_mipOffsets[mipLevel]);
+}
+
+void DdsFileWriter::WriteMip(int mipLevel, std::vector<uint8_t>&& data)
+{
+    assert(data.size() == GetMipSize(mipLevel));
+
+    if (m_writeBudget)
+        m_writeBudget->Acquire(data.size());
+
+    {
+        std::lock_guard lock(m_mutex);
+        ++m_pendingWrites;
+    }
+
+    auto sharedData = std::make_shared<std::vector<uint8_t>>(std::move(data));
+    uint64_t const offset = m_mipOffsets[mipLevel];
+    StartAsyncTask([this, sharedData, offset]()
+    {
+        bool success;
+        if (m_gdeflate)
+        {
+            memcpy(m_fileData.data() + offset, sharedData->data(), sharedData->size());
+            success = FillGDeflateRange(offset, sharedData->size());
+        }
+        else
+        {
+            success = WriteAt(sharedData->data(), sharedData->size(), offset);
+        }
+
+        // Free the data before releasing the budget, so that the limit covers the actual allocations
+        size_t const size = sharedData->size();
+        sharedData->clear();
+        sharedData->shrink_to_fit();
+        if (m_writeBudget)
+            m_writeBudget->Release(size);
+
+        std::lock_guard lock(m_mutex);
+        m_failed |= !success;
+        --m_pendingWrites;
+        m_condition.notify_all();
+    });
+}
+
+bool DdsFileWriter::Close()
+{
+    {
+        std::unique_lock lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_pendingWrites == 0; });
+    }
+
+#ifdef _WIN32
+    if (!m_fileHandle)
+        return !m_failed;
+#else
+    if (m_fileDescriptor < 0)
+        return !m_failed;
+#endif
+
+    if (m_gdeflate && !m_failed)
+        m_failed = !WriteGDeflateStream();
+    m_fileData = std::vector<uint8_t>();
+    m_compressedTiles.clear();
+
+#ifdef _WIN32
+    CloseHandle(m_fileHandle);
+    m_fileHandle = nullptr;
+#else
+    m_failed |= close(m_fileDescriptor) != 0;
+    m_fileDescriptor = -1;
+#endif
+
+    if (m_failed)
+        fprintf(stderr, "Failed to write into output file '%s'.\n", m_fileName.c_str());
+
+    return !m_failed;
+}
+
+bool DdsFileWriter::WriteAt(void const* data, size_t size, uint64_t offset)
+{
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    while (size > 0)
+    {
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        overlapped.Offset = DWORD(offset);
+        overlapped.OffsetHigh = DWORD(offset >> 32);
+        DWORD const chunkSize = DWORD(std::min(size, size_t(1) << 30));
+        DWORD written = 0;
+        if (!WriteFile(m_fileHandle, bytes, chunkSize, &written, &overlapped) || written == 0)
+            return false;
+#else
+        ssize_t const written = pwrite(m_fileDescriptor, bytes, size, off_t(offset));
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+#endif
+        bytes += written;
+        size -= size_t(written);
+        offset += uint64_t(written);
+    }
+    return true;
+}
+
+bool DdsFileWriter::FillGDeflateRange(uint64_t offset, size_t size)
+{
+    // Find the tiles that have received all their data with this range
+    std::vector<size_t> completeTiles;
+    {
+        std::lock_guard lock(m_mutex);
+        uint64_t const end = offset + size;
+        for (size_t tile = size_t(offset / c_GDeflateTileSize); uint64_t(tile) * c_GDeflateTileSize < end; ++tile)
+        {
+            uint64_t const tileBegin = uint64_t(tile) * c_GDeflateTileSize;
+            uint64_t const overlap = std::min(end, tileBegin + c_GDeflateTileSize) - std::max(offset, tileBegin);
+            m_tileBytesMissing[tile] -= uint32_t(overlap);
+            if (m_tileBytesMissing[tile] == 0)
+                completeTiles.push_back(tile);
+        }
+    }
+
+    if (completeTiles.empty())
+        return true;
+
+    libdeflate_gdeflate_compressor* compressor = libdeflate_alloc_gdeflate_compressor(c_GDeflateCompressionLevel);
+    if (!compressor)
+        return false;
+
+    bool success = true;
+    for (size_t tile : completeTiles)
+    {
+        size_t const tileBegin = tile * c_GDeflateTileSize;
+        size_t const tileSize = std::min(m_fileData.size() - tileBegin, c_GDeflateTileSize);
+
+        // Every tile is compressed into a single GDeflate page
+        size_t numPages = 0;
+        size_t const bound = libdeflate_gdeflate_compress_bound(compressor, tileSize, &numPages);
+        assert(numPages == 1);
+
+        // Each tile is only written by the task that completed it, so no lock is needed here
+        std::vector<uint8_t>& compressedTile = m_compressedTiles[tile];
+        compressedTile.resize(bound);
+        libdeflate_gdeflate_out_page page = { compressedTile.data(), compressedTile.size() };
+        size_t const compressedSize = libdeflate_gdeflate_compress(compressor, m_fileData.data() + tileBegin,
+            tileSize, &page, 1);
+        if (compressedSize == 0)
+        {
+            success = false;
+            break;
+        }
+        compressedTile.resize(page.nbytes);
+    }
+
+    libdeflate_free_gdeflate_compressor(compressor);
+    return success;
+}
+
+bool DdsFileWriter::WriteGDeflateStream()
+{
+    size_t const numTiles = m_compressedTiles.size();
+    size_t const lastTileSize = m_fileData.size() % c_GDeflateTileSize;
+
+    GDeflateStreamHeader header{};
+    header.id = c_GDeflateCodecId;
+    header.magic = c_GDeflateCodecId ^ 0xff;
+    header.numTiles = uint16_t(numTiles);
+    header.tileSizeInfo = 1 | (uint32_t(lastTileSize) << 2);
+
+    // The first entry of the tile table holds the compressed size of the last tile,
+    // the others hold the offsets of the tiles from the end of the table
+    std::vector<uint32_t> tileOffsets(numTiles);
+    uint64_t dataSize = 0;
+    for (size_t tile = 0; tile < numTiles; ++tile)
+    {
+        if (m_compressedTiles[tile].empty())
+            return false;
+        if (tile > 0)
+            tileOffsets[tile] = uint32_t(dataSize);
+        dataSize += m_compressedTiles[tile].size();
+    }
+    tileOffsets[0] = uint32_t(m_compressedTiles.back().size());
+
+    uint64_t offset = 0;
+    if (!WriteAt(&header, sizeof(header), offset))
+        return false;
+    offset += sizeof(header);
+
+    if (!WriteAt(tileOffsets.data(), tileOffsets.size() * sizeof(uint32_t), offset))
+        return false;
+    offset += tileOffsets.size() * sizeof(uint32_t);
+
+    for (std::vector<uint8_t> const& compressedTile : m_compressedTiles)
+    {
+        if (!WriteAt(compressedTile.data(), compressedTile.size(), offset))
+            return false;
+        offset += compressedTile.size();
+    }
+
+    return true;
+}
@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include "Utils.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Limits the memory held by the MIP data that DdsFileWriter objects have queued but not written yet.
+// The budget can be shared by multiple writers. When queuing more data would exceed the limit, the caller
+// waits for the earlier writes to finish, but a single MIP level larger than the limit is still accepted.
+class DdsWriteBudget
+{
+public:
+    explicit DdsWriteBudget(size_t maxPendingBytes)
+        : m_maxPendingBytes(maxPendingBytes)
+    { }
+
+    void Acquire(size_t bytes);
+    void Release(size_t bytes);
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    size_t m_maxPendingBytes;
+    size_t m_pendingBytes = 0;
+};
+
+// Writes a BCn DDS file whose MIP levels become available one at a time. The offsets of all MIP levels
+// are known when the file is opened, so every level is written at its final position with a positional
+// write on the StartAsyncTask pool. Writes of different levels don't wait for each other, and the caller
+// can read back the next level from the GPU while the previous one is being written.
+//
+// In GDeflate mode, the whole DDS file is stored as one GDeflate stream in the DirectStorage format,
+// which can be loaded with a single DSTORAGE_COMPRESSION_FORMAT_GDEFLATE request. The stream consists of
+// independent 64 KB tiles, and every tile is compressed on the StartAsyncTask pool as soon as the MIP levels
+// covering it have arrived. The compressed tiles are written into the file when it is closed.
+class DdsFileWriter
+{
+public:
+    DdsFileWriter() = default;
+    ~DdsFileWriter();
+
+    DdsFileWriter(DdsFileWriter const&) = delete;
+    DdsFileWriter& operator=(DdsFileWriter const&) = delete;
+
+    // Creates the file and writes the header. Prints an error message and returns false on failure.
+    // When writeBudget is provided, WriteMip waits for it before queuing the data, and it must outlive the writer.
+    bool Open(char const* fileName, int width, int height, int mipLevels,
+        BcFormatDefinition const* formatDefinition, ntc::ColorSpace colorSpace, DdsWriteBudget* writeBudget = nullptr,
+        bool gdeflate = false);
+
+    // Returns the size of the tightly packed blocks for one MIP level.
+    size_t GetMipSize(int mipLevel) const;
+
+    // Starts writing one MIP level, which must contain GetMipSize(mipLevel) bytes. Returns immediately,
+    // unless the write budget is exceeded by the data that is already queued.
+    void WriteMip(int mipLevel, std::vector<uint8_t>&& data);
+
+    // Waits for all writes to finish and closes the file.
+    // Prints an error message and returns false if any of the writes failed.
+    bool Close();
+
+private:
+    std::string m_fileName;
+    std::vector<uint64_t> m_mipOffsets; // One more entry than MIP levels, the last one is the file size
+    DdsWriteBudget* m_writeBudget = nullptr;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    int m_pendingWrites = 0;
+    bool m_failed = false;
+
+    // GDeflate mode: the uncompressed file contents, the number of bytes that each tile is still waiting for,
+    // and the compressed tiles
+    bool m_gdeflate = false;
+    std::vector<uint8_t> m_fileData;
+    std::vector<uint32_t> m_tileBytesMissing;
+    std::vector<std::vector<uint8_t>> m_compressedTiles;
+#ifdef _WIN32
+    void* m_fileHandle = nullptr;
+#else
+    int m_fileDescriptor = -1;
+#endif
+
+    bool WriteAt(void const* data, size_t size, uint64_t offset);
+
+    // Marks the range of m_fileData as filled and compresses the tiles that are complete now.
+    // Returns false if the compression failed.
+    bool FillGDeflateRange(uint64_t offset, size_t size);
+    bool WriteGDeflateStream();
+};
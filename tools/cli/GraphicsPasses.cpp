@@ -11,6 +11,7 @@
  */
 
 #include "GraphicsPasses.h"
+#include "DdsFileWriter.h"
 #include "Utils.h"
 #include <ntc-utils/BufferLoading.h>
 #include <ntc-utils/DeviceUtils.h>
@@ -22,18 +23,128 @@
 #include <filesystem>
 #include <donut/core/log.h>
 #include <numeric>
+#include <algorithm>
 #include <memory>
 #include <mutex>
 namespace fs = std::filesystem;
 
+// Estimates the memory used by the textures described by the key, including the staging textures
+static uint64_t EstimateGraphicsResourceSize(GraphicsResourceKey const& key)
+{
+    uint64_t colorBytes = 0;
+    uint64_t bcBytes = 0;
+    BcFormatDefinition const* bcFormatDef = (key.bcFormat != ntc::BlockCompressedFormat::None)
+        ? GetBcFormatDefinition(key.bcFormat)
+        : nullptr;
+    for (int mipLevel = 0; mipLevel < key.mips; ++mipLevel)
+    {
+        uint64_t const mipWidth = std::max(key.width >> mipLevel, 1);
+        uint64_t const mipHeight = std::max(key.height >> mipLevel, 1);
+        colorBytes += mipWidth * mipHeight * nvrhi::getFormatInfo(key.colorFormat).bytesPerBlock;
+        if (bcFormatDef)
+            bcBytes += ((mipWidth + 3) / 4) * ((mipHeight + 3) / 4) * bcFormatDef->bytesPerBlock;
+    }
+
+    // Color and staging color textures, BC texture
+    uint64_t size = colorBytes * 2 + bcBytes;
+    
+    // Block and staging block textures contain only one mip level
+    if (bcFormatDef)
+        size += uint64_t((key.width + 3) / 4) * uint64_t((key.height + 3) / 4) * bcFormatDef->bytesPerBlock * 2;
+
+    return size;
+}
+
+std::optional<GraphicsResourcesForTexture> GraphicsResourcePool::Acquire(GraphicsResourceKey const& key)
+{
+    for (auto it = m_idle.begin(); it != m_idle.end(); ++it)
+    {
+        if (it->resources.key == key)
+        {
+            std::optional<GraphicsResourcesForTexture> result = std::move(it->resources);
+            m_idleBytes -= it->sizeInBytes;
+            m_idle.erase(it);
+            ++m_hits;
+            return result;
+        }
+    }
+
+    ++m_misses;
+    return std::nullopt;
+}
+
+void GraphicsResourcePool::Release(GraphicsResourcesForTexture&& resources)
+{
+    if (!resources.color)
+        return;
+
+    uint64_t const sizeInBytes = EstimateGraphicsResourceSize(resources.key);
+    m_idle.push_front(Entry{ std::move(resources), sizeInBytes });
+    m_idleBytes += sizeInBytes;
+
+    // Keep at least the object that was just released, even if it's larger than the limit
+    while (m_idleBytes > m_maxIdleBytes && m_idle.size() > 1)
+    {
+        m_idleBytes -= m_idle.back().sizeInBytes;
+        m_idle.pop_back();
+    }
+}
+
+void GraphicsResourcePool::Clear()
+{
+    m_idle.clear();
+    m_idleBytes = 0;
+}
+
+bool RegisterSharedGraphicsTexture(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    nvrhi::ITexture* texture,
+    ntc::ChannelFormat format,
+    ntc::SharedTextureWrapper& sharedTexture)
+{
+    nvrhi::TextureDesc const& textureDesc = texture->getDesc();
+
+    ntc::SharedTextureDesc sharedTextureDesc;
+    sharedTextureDesc.width = textureDesc.width;
+    sharedTextureDesc.height = textureDesc.height;
+    sharedTextureDesc.channels = 4;
+    sharedTextureDesc.mips = textureDesc.mipLevels;
+    sharedTextureDesc.format = format;
+    sharedTextureDesc.dedicatedResource = true;
+#ifdef _WIN32
+    sharedTextureDesc.handleType = device->getGraphicsAPI() == nvrhi::GraphicsAPI::VULKAN
+        ? ntc::SharedHandleType::OpaqueWin32
+        : ntc::SharedHandleType::D3D12Resource;
+#else
+    sharedTextureDesc.handleType = ntc::SharedHandleType::OpaqueFd;
+#endif
+    sharedTextureDesc.sizeInBytes = device->getTextureMemoryRequirements(texture).size;
+    sharedTextureDesc.sharedHandle = texture->getNativeObject(nvrhi::ObjectTypes::SharedHandle).integer;
+    
+    ntc::Status ntcStatus = context->RegisterSharedTexture(sharedTextureDesc, sharedTexture.ptr());
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        fprintf(stderr, "Failed to register a shared texture with NTC, code = %s: %s\n", ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return false;
+    }
+
+    return true;
+}
+
 bool CreateGraphicsResourcesFromMetadata(
     ntc::IContext* context,
     nvrhi::IDevice* device,
     ntc::ITextureSetMetadata* metadata,
     int mipLevels,
     bool enableCudaSharing,
-    GraphicsResourcesForTextureSet& resources)
+    GraphicsResourcesForTextureSet& resources,
+    GraphicsResourcePool* pool,
+    int customWidth,
+    int customHeight)
 {
+    resources.pool = pool;
+
     int const maxImageDimension = 16384;
     ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
     if (textureSetDesc.width > maxImageDimension || textureSetDesc.height > maxImageDimension)
@@ -44,6 +155,9 @@ bool CreateGraphicsResourcesFromMetadata(
         return false;
     }
 
+    int const width = customWidth > 0 ? customWidth : textureSetDesc.width;
+    int const height = customHeight > 0 ? customHeight : textureSetDesc.height;
+
     int const numTextures = metadata->GetTextureCount();
     
     for (int i = 0; i < numTextures; ++i)
@@ -81,14 +195,34 @@ bool CreateGraphicsResourcesFromMetadata(
                 break;
         }
 
+        GraphicsResourceKey key;
+        key.width = width;
+        key.height = height;
+        key.mips = mipLevels;
+        key.colorFormat = colorFormat;
+        key.bcFormat = bcFormat;
+        key.shared = enableCudaSharing;
+
+        if (pool)
+        {
+            std::optional<GraphicsResourcesForTexture> pooledResources = pool->Acquire(key);
+            if (pooledResources.has_value())
+            {
+                pooledResources->name = name;
+                resources.perTexture.push_back(std::move(*pooledResources));
+                continue;
+            }
+        }
+
         GraphicsResourcesForTexture textureResources(context);
         textureResources.name = name;
+        textureResources.key = key;
 
         auto colorTextureDesc = nvrhi::TextureDesc()
             .setDebugName(name)
             .setFormat(colorFormat)
-            .setWidth(textureSetDesc.width)
-            .setHeight(textureSetDesc.height)
+            .setWidth(width)
+            .setHeight(height)
             .setMipLevels(mipLevels)
             .setDimension(nvrhi::TextureDimension::Texture2D)
             .setIsUAV(true)
@@ -109,37 +243,17 @@ bool CreateGraphicsResourcesFromMetadata(
 
         if (enableCudaSharing)
         {
-            ntc::SharedTextureDesc sharedTextureDesc;
-            sharedTextureDesc.width = colorTextureDesc.width;
-            sharedTextureDesc.height = colorTextureDesc.height;
-            sharedTextureDesc.channels = 4;
-            sharedTextureDesc.mips = colorTextureDesc.mipLevels;
-            sharedTextureDesc.format = sharedFormat;
-            sharedTextureDesc.dedicatedResource = true;
-        #ifdef _WIN32
-            sharedTextureDesc.handleType = device->getGraphicsAPI() == nvrhi::GraphicsAPI::VULKAN
-                ? ntc::SharedHandleType::OpaqueWin32
-                : ntc::SharedHandleType::D3D12Resource;
-        #else
-            sharedTextureDesc.handleType = ntc::SharedHandleType::OpaqueFd;
-        #endif
-            sharedTextureDesc.sizeInBytes = device->getTextureMemoryRequirements(textureResources.color).size;
-            sharedTextureDesc.sharedHandle = textureResources.color->getNativeObject(nvrhi::ObjectTypes::SharedHandle).integer;
-            
-            ntc::Status ntcStatus = context->RegisterSharedTexture(sharedTextureDesc, textureResources.sharedTexture.ptr());
-            if (ntcStatus != ntc::Status::Ok)
-            {
-                fprintf(stderr, "Failed to register a shared texture with NTC, code = %s: %s\n", ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            if (!RegisterSharedGraphicsTexture(context, device, textureResources.color, sharedFormat,
+                textureResources.sharedTexture))
                 return false;
-            }
         }
         
         if (bcFormat != ntc::BlockCompressedFormat::None)
         {
             BcFormatDefinition const* bcFormatDef = GetBcFormatDefinition(bcFormat);
 
-            int const widthBlocks = (metadata->GetDesc().width + 3) / 4;
-            int const heightBlocks = (metadata->GetDesc().height + 3) / 4;
+            int const widthBlocks = (width + 3) / 4;
+            int const heightBlocks = (height + 3) / 4;
             auto blockTextureDesc = nvrhi::TextureDesc()
                 .setDebugName(name)
                 .setFormat(bcFormatDef->bytesPerBlock == 8 ? nvrhi::Format::RG32_UINT : nvrhi::Format::RGBA32_UINT)
@@ -165,8 +279,8 @@ bool CreateGraphicsResourcesFromMetadata(
                 .setDebugName(name)
                 .setFormat(bcFormatDef->nvrhiFormat)
                 .setDimension(nvrhi::TextureDimension::Texture2D)
-                .setWidth(metadata->GetDesc().width)
-                .setHeight(metadata->GetDesc().height)
+                .setWidth(width)
+                .setHeight(height)
                 .setMipLevels(mipLevels)
                 .setInitialState(nvrhi::ResourceStates::CopyDest)
                 .setKeepInitialState(true);
@@ -193,7 +307,10 @@ bool DecompressTextureSetWithGraphicsAPI(
     ntc::IStream* inputFile,
     int mipLevels,
     bool enableDithering,
-    GraphicsResourcesForTextureSet const& graphicsResources)
+    ntc::InferenceWeightType weightType,
+    GraphicsResourcesForTextureSet const& graphicsResources,
+    int firstMipLevel,
+    ntc::Rect const* region)
 {
     // In some cases, this function is called without a file - which means we reuse the previously uploaded data.
     if (inputFile)
@@ -222,13 +339,6 @@ bool DecompressTextureSetWithGraphicsAPI(
         }
     }
 
-    ntc::InferenceWeightType weightType = metadata->GetBestSupportedWeightType();
-    if (weightType == ntc::InferenceWeightType::Unknown)
-    {
-        fprintf(stderr, "The texture set does not provide any weights compatible with the current device.\n");
-        return false;
-    }
-
     commandList->open();
 
     if (!gdp.SetWeightsFromTextureSet(commandList, metadata, weightType))
@@ -240,6 +350,9 @@ bool DecompressTextureSetWithGraphicsAPI(
 
     commandList->beginTimerQuery(timerQuery);
 
+    // With a region, its pixels are written at the origin of the output textures
+    ntc::Point const regionOffset{};
+
     // Decompress each mip level in a loop
     for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
     {
@@ -273,11 +386,13 @@ bool DecompressTextureSetWithGraphicsAPI(
         // Obtain the compute pass description and constant buffer data from NTC
         ntc::MakeDecompressionComputePassParameters params;
         params.textureSetMetadata = metadata;
-        params.mipLevel = mipLevel;
+        params.mipLevel = firstMipLevel + mipLevel;
         params.firstOutputDescriptorIndex = mipLevel * numTextures;
         params.weightType = weightType;
         params.numOutputTextures = numTextures;
         params.pOutputTextures = outputs.data();
+        params.pSrcRect = region;
+        params.pDstOffset = region ? &regionOffset : nullptr;
         ntc::ComputePassDesc computePass{};
         ntc::Status ntcStatus = context->MakeDecompressionComputePass(params, &computePass);
         CHECK_NTC_RESULT("MakeDecompressionComputePass");
@@ -309,6 +424,39 @@ bool DecompressTextureSetWithGraphicsAPI(
     return true;
 }
 
+bool CopyTextureDataIntoGraphicsTexture(
+    ntc::ITextureSet* textureSet,
+    int textureIndex,
+    ntc::TextureDataPage page,
+    bool allMipLevels,
+    GraphicsResourcesForTextureSet const& graphicsResources)
+{
+    ntc::ITextureMetadata* textureMetadata = textureSet->GetTexture(textureIndex);
+    GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[textureIndex];
+
+    int mipLevels = allMipLevels ? textureResources.color->getDesc().mipLevels : 1;
+
+    for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
+    {
+        ntc::ReadChannelsIntoTextureParameters params;
+        params.page = page;
+        params.mipLevel = mipLevel;
+        params.firstChannel = textureMetadata->GetFirstChannel();
+        params.numChannels = textureMetadata->GetNumChannels();
+        params.texture = textureResources.sharedTexture;
+        params.textureMipLevel = mipLevel;
+        params.dstRgbColorSpace = textureMetadata->GetRgbColorSpace();
+        params.dstAlphaColorSpace = textureMetadata->GetAlphaColorSpace();
+        params.useDithering = true;
+
+        ntc::Status ntcStatus = textureSet->ReadChannelsIntoTexture(params);
+
+        CHECK_NTC_RESULT("ReadChannelsIntoTexture")
+    }
+
+    return true;
+}
+
 bool CopyTextureSetDataIntoGraphicsTextures(
     ntc::IContext* context,
     ntc::ITextureSet* textureSet,
@@ -324,27 +472,8 @@ bool CopyTextureSetDataIntoGraphicsTextures(
         if (onlyBlockCompressedFormats && bcFormat == ntc::BlockCompressedFormat::None)
             continue;
 
-        GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[textureIndex];
-
-        int mipLevels = allMipLevels ? textureResources.color->getDesc().mipLevels : 1;
-
-        for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
-        {
-            ntc::ReadChannelsIntoTextureParameters params;
-            params.page = page;
-            params.mipLevel = mipLevel;
-            params.firstChannel = textureMetadata->GetFirstChannel();
-            params.numChannels = textureMetadata->GetNumChannels();
-            params.texture = textureResources.sharedTexture;
-            params.textureMipLevel = mipLevel;
-            params.dstRgbColorSpace = textureMetadata->GetRgbColorSpace();
-            params.dstAlphaColorSpace = textureMetadata->GetAlphaColorSpace();
-            params.useDithering = true;
-
-            ntc::Status ntcStatus = textureSet->ReadChannelsIntoTexture(params);
-
-            CHECK_NTC_RESULT("ReadChannelsIntoTexture")
-        }
+        if (!CopyTextureDataIntoGraphicsTexture(textureSet, textureIndex, page, allMipLevels, graphicsResources))
+            return false;
     }
 
     return true;
@@ -356,7 +485,8 @@ bool SaveGraphicsStagingTextures(
     char const* savePath,
     ImageContainer const userProvidedContainer,
     bool saveMips,
-    GraphicsResourcesForTextureSet const& graphicsResources)
+    GraphicsResourcesForTextureSet const& graphicsResources,
+    bool includeBlockCompressed)
 {
     fs::path const outputPath = fs::path(savePath);
     bool mipsDirCreated = false;
@@ -369,7 +499,7 @@ bool SaveGraphicsStagingTextures(
         ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(index);
         ntc::BlockCompressedFormat bcFormat = textureMetadata->GetBlockCompressedFormat();
 
-        if (bcFormat != ntc::BlockCompressedFormat::None)
+        if (bcFormat != ntc::BlockCompressedFormat::None && !includeBlockCompressed)
             continue;
 
         if (!mipsDirCreated && saveMips && metadata->GetDesc().mips > 1)
@@ -569,6 +699,10 @@ bool ComputeBlockCompressedImageError(
     return true;
 }
 
+// Maximum size of the MIP data that is read back from the GPU and waits to be written into the DDS files.
+// Encoding waits for the writes when it gets ahead of the disk by more than that.
+static const size_t c_MaxPendingDdsWriteBytes = size_t(256) << 20;
+
 bool BlockCompressAndSaveGraphicsTextures(
     ntc::IContext* context,
     ntc::ITextureSetMetadata* metadata,
@@ -578,8 +712,10 @@ bool BlockCompressAndSaveGraphicsTextures(
     nvrhi::ITimerQuery* timerQuery,
     GDeflateFeatures* gdeflateFeatures,
     char const* savePath,
+    bool saveGDeflate,
     int benchmarkIterations,
-    GraphicsResourcesForTextureSet const& graphicsResources)
+    GraphicsResourcesForTextureSet const& graphicsResources,
+    std::function<bool(int textureIndex)> const& prepareTexture)
 {
     GraphicsBlockCompressionPass blockCompressionPass(device, 2);
     if (!blockCompressionPass.Init())
@@ -592,16 +728,33 @@ bool BlockCompressAndSaveGraphicsTextures(
     float const alphaThreshold = 1.f / 255.f;
 
     ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
-    
+
+    std::vector<int> bcTextureIndices;
     for (int index = 0; index < int(graphicsResources.perTexture.size()); ++index)
     {
+        if (metadata->GetTexture(index)->GetBlockCompressedFormat() != ntc::BlockCompressedFormat::None)
+            bcTextureIndices.push_back(index);
+    }
+
+    // When the color data is provided through prepareTexture, the data for the next texture is copied
+    // while the GPU is encoding the first mip level of the current texture. The copy writes into another
+    // texture and completes before returning, so no other synchronization is needed.
+    if (prepareTexture && !bcTextureIndices.empty() && !prepareTexture(bcTextureIndices[0]))
+        return false;
+
+    // The files are written in the background while the following MIP levels and textures are encoded,
+    // and closed when all textures are done. The budget is declared first so that it outlives the writers.
+    DdsWriteBudget writeBudget(c_MaxPendingDdsWriteBytes);
+    std::vector<std::unique_ptr<DdsFileWriter>> outputFiles;
+    
+    for (size_t position = 0; position < bcTextureIndices.size(); ++position)
+    {
+        int const index = bcTextureIndices[position];
+        int const nextIndex = (position + 1 < bcTextureIndices.size()) ? bcTextureIndices[position + 1] : -1;
         GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[index];
         ntc::ITextureMetadata* textureMetadata = metadata->GetTexture(index);
         ntc::BlockCompressedFormat bcFormat = textureMetadata->GetBlockCompressedFormat();
 
-        if (bcFormat == ntc::BlockCompressedFormat::None)
-            continue;
-
         bool const useAlphaThreshold = bcFormat == ntc::BlockCompressedFormat::BC1;
         bool const useMSLE = bcFormat == ntc::BlockCompressedFormat::BC6;
 
@@ -614,9 +767,10 @@ bool BlockCompressAndSaveGraphicsTextures(
             size_t tempBufferSize = 0;
             size_t finalBufferSize = 0;
 
-            FillBufferLoadingTasksForBC(textureSetDesc, textureMetadata, modeBufferTasks,
+            if (!FillBufferLoadingTasksForBC(textureSetDesc, textureMetadata, modeBufferTasks,
                 gdeflateFeatures && gdeflateFeatures->gpuDecompressionSupported, device->getGraphicsAPI(),
-                stagingBufferSize, tempBufferSize, finalBufferSize);
+                stagingBufferSize, tempBufferSize, finalBufferSize))
+                return false;
             
             if (!ExecuteBufferLoadingTasks(device, commandList, context, inputFile, gdeflateFeatures,
                 modeBufferTasks, modeBuffer, stagingBufferSize, tempBufferSize, finalBufferSize))
@@ -626,22 +780,13 @@ bool BlockCompressAndSaveGraphicsTextures(
         nvrhi::TextureDesc const& textureDesc = textureResources.color->getDesc();
         BcFormatDefinition const* bcFormatDef = GetBcFormatDefinition(bcFormat);
 
-        std::string outputFileName = (fs::path(savePath) / fs::path(textureResources.name)).generic_string() + ".dds";
-        ntc::FileStreamWrapper outputFile(context);
-        ntc::Status ntcStatus = context->OpenFile(outputFileName.c_str(), true, outputFile.ptr());
-        if (ntcStatus != ntc::Status::Ok)
-        {
-            fprintf(stderr, "Failed to open output file '%s', code = %s: %s\n", outputFileName.c_str(),
-                StatusToString(ntcStatus), ntc::GetLastErrorMessage());
-            return false;
-        }
-
+        std::string outputFileName = (fs::path(savePath) / fs::path(textureResources.name)).generic_string()
+            + (saveGDeflate ? ".dds.gdeflate" : ".dds");
+        DdsFileWriter& outputFile = *outputFiles.emplace_back(std::make_unique<DdsFileWriter>());
         ntc::ColorSpace const rgbColorSpace = textureMetadata->GetRgbColorSpace();
-        if (!WriteDdsHeader(outputFile, textureDesc.width, textureDesc.height, textureDesc.mipLevels, bcFormatDef, rgbColorSpace))
-        {
-            fprintf(stderr, "Failed to write into output file '%s': %s.\n", outputFileName.c_str(), strerror(errno));
+        if (!outputFile.Open(outputFileName.c_str(), textureDesc.width, textureDesc.height, textureDesc.mipLevels,
+            bcFormatDef, rgbColorSpace, &writeBudget, saveGDeflate))
             return false;
-        }
 
         float perMipCompressionTimeMs[NTC_MAX_MIPS]{};
         float perMipMSE[NTC_MAX_MIPS]{};
@@ -671,7 +816,7 @@ bool BlockCompressAndSaveGraphicsTextures(
             params.modeBufferInfo.textureSet.mipLevel = mipLevel;
 
             ntc::ComputePassDesc computePass{};
-            ntcStatus = context->MakeBlockCompressionComputePass(params, &computePass);
+            ntc::Status ntcStatus = context->MakeBlockCompressionComputePass(params, &computePass);
             CHECK_NTC_RESULT("MakeBlockCompressionComputePass");
             
             std::vector<float> iterationTimes;
@@ -701,6 +846,16 @@ bool BlockCompressAndSaveGraphicsTextures(
                 commandList->close();
 
                 device->executeCommandList(commandList);
+
+                if (prepareTexture && nextIndex >= 0 && mipLevel == 0 && iteration == 0)
+                {
+                    if (!prepareTexture(nextIndex))
+                    {
+                        device->waitForIdle();
+                        return false;
+                    }
+                }
+
                 device->waitForIdle(); 
                 device->runGarbageCollection();
 
@@ -722,27 +877,19 @@ bool BlockCompressAndSaveGraphicsTextures(
             if (!mappedData)
                 return false;
 
-            bool success = true;
+            // Pack the rows, the staging texture is reused for the next MIP level while this one is being written
+            size_t const dstRowPitch = size_t(mipWidthBlocks) * bcFormatDef->bytesPerBlock;
+            std::vector<uint8_t> mipData(outputFile.GetMipSize(mipLevel));
             for (uint32_t row = 0; row < mipHeightBlocks; ++row)
             {
-                if (!outputFile->Write(mappedData + rowPitch * row, mipWidthBlocks * bcFormatDef->bytesPerBlock))
-                {
-                    success = false;
-                    break;
-                }
+                memcpy(mipData.data() + dstRowPitch * row, mappedData + rowPitch * row, dstRowPitch);
             }
 
             device->unmapStagingTexture(textureResources.stagingBlocks);
 
-            if (!success)
-            {
-                fprintf(stderr, "Failed to write into output file '%s': %s.\n", outputFileName.c_str(), strerror(errno));
-                return false;
-            }
+            outputFile.WriteMip(mipLevel, std::move(mipData));
         }
 
-        outputFile.Close();
-
         printf("Saved image '%s': %dx%d pixels, %d mips, %s:\n",
             outputFileName.c_str(), textureDesc.width, textureDesc.height, textureDesc.mipLevels,
             ntc::BlockCompressedFormatToString(bcFormatDef->ntcFormat));
@@ -772,7 +919,11 @@ bool BlockCompressAndSaveGraphicsTextures(
         }
     }
 
-    return true;
+    bool success = true;
+    for (std::unique_ptr<DdsFileWriter>& outputFile : outputFiles)
+        success &= outputFile->Close();
+
+    return success;
 }
 
 bool OptimizeBlockCompression(
@@ -785,32 +936,35 @@ bool OptimizeBlockCompression(
 {
     assert(device);
     
-    bool anyBC7Textures = false;
-    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
-    {
-        ntc::ITextureMetadata* textureMetadata = textureSetMetadata->GetTexture(textureIndex);
-        if (textureMetadata->GetBlockCompressedFormat() == ntc::BlockCompressedFormat::BC7)
-        {
-            anyBC7Textures = true;
-            break;
-        }
-    }
-
-    if (!anyBC7Textures)
-        return true;
+    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
 
-    GraphicsBlockCompressionPass blockCompressionPass(device, 1);
-    if (!blockCompressionPass.Init())
-        return false;
+    // Every mip level of every BC7 texture is processed as one slice. All slices are compressed in one submission,
+    // so each BC7 texture gets its own block texture with a mip level for every mip of the color texture.
+    struct BlockTextures
+    {
+        nvrhi::TextureHandle blocks;
+        nvrhi::StagingTextureHandle stagingBlocks;
+    };
 
-    GraphicsImageDifferencePass compareImagesPass(device);
-    if (!compareImagesPass.Init())
-        return false;
-    
-    ntc::TextureSetDesc const& textureSetDesc = textureSetMetadata->GetDesc();
+    struct Slice
+    {
+        ntc::ITextureMetadata* textureMetadata = nullptr;
+        GraphicsResourcesForTexture const* textureResources = nullptr;
+        BlockTextures const* blockTextures = nullptr;
+        int mipLevel = 0;
+        int width = 0;
+        int height = 0;
+        int widthInBlocks = 0;
+        int heightInBlocks = 0;
+        std::vector<uint8_t> blockData; // Output of the exhaustive search, for validation of the second pass
+        size_t rowPitch = 0;
+        std::vector<uint8_t> modeBufferData; // Copy of the mode buffer stored in the texture metadata
+        nvrhi::BufferHandle modeBuffer;
+    };
 
-    nvrhi::BufferHandle modeBuffer;
-    std::vector<uint8_t> blockCompressedData;
+    std::vector<BlockTextures> blockTextures;
+    blockTextures.reserve(textureSetMetadata->GetTextureCount());
+    std::vector<Slice> slices;
 
     for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
     {
@@ -820,145 +974,211 @@ bool OptimizeBlockCompression(
 
         GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[textureIndex];
 
+        // Block counts are rounded up on every mip, which can exceed the mip chain of mip 0 block counts
+        uint32_t blockTextureWidth = 1;
+        uint32_t blockTextureHeight = 1;
         for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
         {
-            int mipWidth = std::max(textureSetDesc.width >> mipLevel, 1);
-            int mipHeight = std::max(textureSetDesc.height >> mipLevel, 1);
-            int mipWidthInBlocks = (mipWidth + 3) / 4;
-            int mipHeightInBlocks = (mipHeight + 3) / 4;
+            uint32_t const mipWidth = std::max(textureSetDesc.width >> mipLevel, 1);
+            uint32_t const mipHeight = std::max(textureSetDesc.height >> mipLevel, 1);
+            blockTextureWidth = std::max(blockTextureWidth, ((mipWidth + 3) / 4) << mipLevel);
+            blockTextureHeight = std::max(blockTextureHeight, ((mipHeight + 3) / 4) << mipLevel);
+        }
 
-            // First pass - compress without the mode buffer, doing an exhaustive mode search for each block
+        auto blockTextureDesc = nvrhi::TextureDesc()
+            .setDebugName(textureResources.name + " (BC7 optimization)")
+            .setFormat(nvrhi::Format::RGBA32_UINT)
+            .setDimension(nvrhi::TextureDimension::Texture2D)
+            .setWidth(blockTextureWidth)
+            .setHeight(blockTextureHeight)
+            .setMipLevels(textureSetDesc.mips)
+            .setIsUAV(true)
+            .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+            .setKeepInitialState(true);
+
+        BlockTextures& textures = blockTextures.emplace_back();
+        textures.blocks = device->createTexture(blockTextureDesc);
+        if (!textures.blocks)
+            return false;
 
+        blockTextureDesc
+            .setInitialState(nvrhi::ResourceStates::CopyDest);
+
+        textures.stagingBlocks = device->createStagingTexture(blockTextureDesc, nvrhi::CpuAccessMode::Read);
+        if (!textures.stagingBlocks)
+            return false;
+
+        for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+        {
+            Slice& slice = slices.emplace_back();
+            slice.textureMetadata = textureMetadata;
+            slice.textureResources = &textureResources;
+            slice.blockTextures = &textures;
+            slice.mipLevel = mipLevel;
+            slice.width = std::max(textureSetDesc.width >> mipLevel, 1);
+            slice.height = std::max(textureSetDesc.height >> mipLevel, 1);
+            slice.widthInBlocks = (slice.width + 3) / 4;
+            slice.heightInBlocks = (slice.height + 3) / 4;
+        }
+    }
+
+    if (slices.empty())
+        return true;
+
+    GraphicsBlockCompressionPass blockCompressionPass(device);
+    if (!blockCompressionPass.Init())
+        return false;
+
+    // Compresses all slices in one submission, with or without the mode buffers, and copies the blocks
+    // into the staging textures. The passes write different block texture mips, so they can overlap on the GPU.
+    auto compressAllSlices = [&](bool useModeBuffers)
+    {
+        for (Slice const& slice : slices)
+        {
             ntc::MakeBlockCompressionComputePassParameters compressionParams;
-            compressionParams.srcRect.width = mipWidth;
-            compressionParams.srcRect.height = mipHeight;
-            compressionParams.dstFormat = textureMetadata->GetBlockCompressedFormat();
+            compressionParams.srcRect.width = slice.width;
+            compressionParams.srcRect.height = slice.height;
+            compressionParams.dstFormat = ntc::BlockCompressedFormat::BC7;
+            if (useModeBuffers)
+            {
+                compressionParams.modeBufferSource = ntc::BlockCompressionModeBufferSource::TextureSet;
+                compressionParams.modeBufferInfo.textureSet.texture = slice.textureMetadata;
+                compressionParams.modeBufferInfo.textureSet.mipLevel = slice.mipLevel;
+            }
             ntc::ComputePassDesc blockCompressionComputePass;
-            ntc::Status ntcStatus = context->MakeBlockCompressionComputePass(compressionParams, &blockCompressionComputePass);
+            ntc::Status ntcStatus = context->MakeBlockCompressionComputePass(compressionParams,
+                &blockCompressionComputePass);
+            if (ntcStatus != ntc::Status::Ok)
+                blockCompressionPass.DiscardBatchedComputePasses();
             CHECK_NTC_RESULT("MakeBlockCompressionComputePass");
-            
-            commandList->open();
 
-            if (!blockCompressionPass.ExecuteComputePass(commandList, blockCompressionComputePass,
-                textureResources.color, nvrhi::Format::UNKNOWN, mipLevel,
-                /* modeBuffer = */ nullptr,
-                textureResources.blocks, /* outputMipLevel = */ 0))
-            {
-                commandList->close();
-                return false;
-            }
-            
-            commandList->copyTexture(textureResources.stagingBlocks, nvrhi::TextureSlice(),
-                textureResources.blocks, nvrhi::TextureSlice());
+            blockCompressionPass.AddBatchedComputePass(blockCompressionComputePass,
+                slice.textureResources->color, nvrhi::Format::UNKNOWN, slice.mipLevel,
+                useModeBuffers ? slice.modeBuffer.Get() : nullptr,
+                slice.blockTextures->blocks, slice.mipLevel);
+        }
 
-            commandList->close();
+        commandList->open();
 
-            device->executeCommandList(commandList);
-            device->waitForIdle();
-            device->runGarbageCollection();
-            
-            // Read the block-compressed data back into CPU memory
+        if (useModeBuffers)
+        {
+            for (Slice const& slice : slices)
+                commandList->writeBuffer(slice.modeBuffer, slice.modeBufferData.data(), slice.modeBufferData.size());
+        }
 
-            size_t rowPitch = 0;
-            size_t blockDataSize = 0;
-            {
-                void const* mappedBlockData = device->mapStagingTexture(
-                    textureResources.stagingBlocks, nvrhi::TextureSlice(), nvrhi::CpuAccessMode::Read, &rowPitch);
-                if (!mappedBlockData)
-                    return false;
+        bool const executed = blockCompressionPass.ExecuteBatchedComputePasses(commandList);
+        blockCompressionPass.DiscardBatchedComputePasses();
+        if (!executed)
+        {
+            commandList->close();
+            return false;
+        }
 
-                // Copy the block-compressed data into a CPU buffer for more efficient access
-                // and for later validation of the optimized compression pass.
-                blockDataSize = rowPitch * mipHeightInBlocks;
-                blockCompressedData.resize(blockDataSize);
-                memcpy(blockCompressedData.data(), mappedBlockData, blockDataSize);
+        for (Slice const& slice : slices)
+        {
+            auto const textureSlice = nvrhi::TextureSlice().setMipLevel(slice.mipLevel);
+            commandList->copyTexture(slice.blockTextures->stagingBlocks, textureSlice,
+                slice.blockTextures->blocks, textureSlice);
+        }
 
-                device->unmapStagingTexture(textureResources.stagingBlocks);
-            }
+        commandList->close();
 
-            // Use the block-compressed data to fill the BC7 mode buffer
+        device->executeCommandList(commandList);
+        device->waitForIdle();
+        device->runGarbageCollection();
 
-            ntcStatus = textureMetadata->MakeAndStoreBC7ModeBuffer(mipLevel, mipWidthInBlocks, mipHeightInBlocks,
-                blockCompressedData.data(), blockDataSize, rowPitch);
+        return true;
+    };
 
-            CHECK_NTC_RESULT("MakeAndStoreBC7ModeBuffer");
+    // First pass - compress without the mode buffers, doing an exhaustive mode search for each block
 
-            // Retrieve the mode buffer data we just created above
+    if (!compressAllSlices(/* useModeBuffers = */ false))
+        return false;
 
-            void const* modeBufferData = nullptr;
-            size_t modeBufferSize = 0;
-            textureMetadata->GetBC7ModeBuffer(mipLevel, &modeBufferData, &modeBufferSize);
-            
-            if (modeBufferData == nullptr || modeBufferSize == 0)
-            {
-                fprintf(stderr, "Failed to retrieve BC7 mode buffer for texture '%s' mip %d after optimization.\n",
-                    textureResources.name.c_str(), mipLevel);
+    for (Slice& slice : slices)
+    {
+        // Read the block-compressed data back into CPU memory, for more efficient access
+        // and for later validation of the optimized compression pass
+        {
+            void const* mappedBlockData = device->mapStagingTexture(slice.blockTextures->stagingBlocks,
+                nvrhi::TextureSlice().setMipLevel(slice.mipLevel), nvrhi::CpuAccessMode::Read, &slice.rowPitch);
+            if (!mappedBlockData)
                 return false;
-            }
-            
-            if (!modeBuffer)
-            {
-                nvrhi::BufferDesc modeBufferDesc = nvrhi::BufferDesc()
-                    .setDebugName("BC7 Mode Buffer")
-                    .setByteSize(modeBufferSize)
-                    .setCanHaveRawViews(true)
-                    .enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
-                
-                modeBuffer = device->createBuffer(modeBufferDesc);
-                if (!modeBuffer)
-                    return false;
-            }
 
-            // We create the mode buffer for mip 0, and reuse it for all mips in the pass.
-            // The mip 0 buffer is always larger than the others, so this is safe.
-            assert(modeBuffer->getDesc().byteSize >= modeBufferSize);
+            size_t const blockDataSize = slice.rowPitch * slice.heightInBlocks;
+            slice.blockData.resize(blockDataSize);
+            memcpy(slice.blockData.data(), mappedBlockData, blockDataSize);
+
+            device->unmapStagingTexture(slice.blockTextures->stagingBlocks);
+        }
 
-            // Second pass - compress using the mode buffer for validation
+        // Use the block-compressed data to fill the BC7 mode buffer
 
-            compressionParams.modeBufferSource = ntc::BlockCompressionModeBufferSource::TextureSet;
-            compressionParams.modeBufferInfo.textureSet.texture = textureMetadata;
-            compressionParams.modeBufferInfo.textureSet.mipLevel = mipLevel;
-            ntcStatus = context->MakeBlockCompressionComputePass(compressionParams, &blockCompressionComputePass);
-            CHECK_NTC_RESULT("MakeBlockCompressionComputePass #2");
+        ntc::Status ntcStatus = slice.textureMetadata->MakeAndStoreBC7ModeBuffer(slice.mipLevel,
+            slice.widthInBlocks, slice.heightInBlocks, slice.blockData.data(), slice.blockData.size(), slice.rowPitch);
 
-            commandList->open();
-            commandList->writeBuffer(modeBuffer, modeBufferData, modeBufferSize);
+        CHECK_NTC_RESULT("MakeAndStoreBC7ModeBuffer");
 
-            if (!blockCompressionPass.ExecuteComputePass(commandList, blockCompressionComputePass,
-                textureResources.color, nvrhi::Format::UNKNOWN, mipLevel,
-                modeBuffer,
-                textureResources.blocks, /* outputMipLevel = */ 0))
-            {
-                commandList->close();
-                return false;
-            }
+        // Retrieve the mode buffer data we just created above
 
-            commandList->copyTexture(textureResources.stagingBlocks, nvrhi::TextureSlice(),
-                textureResources.blocks, nvrhi::TextureSlice());
+        void const* modeBufferData = nullptr;
+        size_t modeBufferSize = 0;
+        slice.textureMetadata->GetBC7ModeBuffer(slice.mipLevel, &modeBufferData, &modeBufferSize);
+        
+        if (modeBufferData == nullptr || modeBufferSize == 0)
+        {
+            fprintf(stderr, "Failed to retrieve BC7 mode buffer for texture '%s' mip %d after optimization.\n",
+                slice.textureResources->name.c_str(), slice.mipLevel);
+            return false;
+        }
 
-            commandList->close();
-            device->executeCommandList(commandList);
-            device->waitForIdle();
-            device->runGarbageCollection();
+        // The metadata may reallocate its storage when the mode buffers for the other slices are stored,
+        // so keep a copy until the upload in the second pass
+        uint8_t const* modeBufferBytes = static_cast<uint8_t const*>(modeBufferData);
+        slice.modeBufferData.assign(modeBufferBytes, modeBufferBytes + modeBufferSize);
+
+        // Every slice needs its own mode buffer because all of them are used in the same submission
+        nvrhi::BufferDesc modeBufferDesc = nvrhi::BufferDesc()
+            .setDebugName("BC7 Mode Buffer")
+            .setByteSize(slice.modeBufferData.size())
+            .setCanHaveRawViews(true)
+            .enableAutomaticStateTracking(nvrhi::ResourceStates::ShaderResource);
+        
+        slice.modeBuffer = device->createBuffer(modeBufferDesc);
+        if (!slice.modeBuffer)
+            return false;
+    }
 
-            // Map the compressed data and compare against the original compression output.
-            // They should match exactly.
+    // Second pass - compress using the mode buffers for validation
 
-            {
-                void const* mappedBlockData = device->mapStagingTexture(
-                    textureResources.stagingBlocks, nvrhi::TextureSlice(), nvrhi::CpuAccessMode::Read, &rowPitch);
-                if (!mappedBlockData)
-                    return false;
+    if (!compressAllSlices(/* useModeBuffers = */ true))
+        return false;
 
-                if (memcmp(mappedBlockData, blockCompressedData.data(), blockDataSize) != 0)
-                {
-                    fprintf(stderr, "Warning: Optimized BC7 compression produced different data for texture '%s' mip %d.\n",
-                        textureResources.name.c_str(), mipLevel);
-                }
+    // Map the compressed data and compare against the original compression output.
+    // They should match exactly.
+
+    for (Slice const& slice : slices)
+    {
+        size_t rowPitch = 0;
+        uint8_t const* mappedBlockData = static_cast<uint8_t const*>(device->mapStagingTexture(
+            slice.blockTextures->stagingBlocks, nvrhi::TextureSlice().setMipLevel(slice.mipLevel),
+            nvrhi::CpuAccessMode::Read, &rowPitch));
+        if (!mappedBlockData)
+            return false;
 
-                device->unmapStagingTexture(textureResources.stagingBlocks);
+        // Compare only the blocks of this mip, the rest of the block texture mip is not written
+        size_t const rowSize = size_t(slice.widthInBlocks) * 16;
+        for (int row = 0; row < slice.heightInBlocks; ++row)
+        {
+            if (memcmp(mappedBlockData + rowPitch * row, slice.blockData.data() + slice.rowPitch * row, rowSize) != 0)
+            {
+                fprintf(stderr, "Warning: Optimized BC7 compression produced different data for texture '%s' mip %d.\n",
+                    slice.textureResources->name.c_str(), slice.mipLevel);
+                break;
             }
         }
+
+        device->unmapStagingTexture(slice.blockTextures->stagingBlocks);
     }
     
     return true;
@@ -970,15 +1190,29 @@ bool ComputePsnrForBlockCompressedTextureSet(
     nvrhi::IDevice* device,
     nvrhi::ICommandList* commandList,
     GraphicsResourcesForTextureSet const& graphicsResources,
-    float& outTargetPsnr)
+    float& outTargetPsnr,
+    float* outCombinedBitsPerPixel)
 {
     assert(device);
     
-    GraphicsBlockCompressionPass blockCompressionPass(device, 1);
+    // Compress and compare all textures in one submission, with one query per texture
+    std::vector<int> bcTextureIndices;
+    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    {
+        if (textureSetMetadata->GetTexture(textureIndex)->GetBlockCompressedFormat() != ntc::BlockCompressedFormat::None)
+            bcTextureIndices.push_back(textureIndex);
+    }
+
+    if (bcTextureIndices.empty())
+        return false;
+
+    uint32_t const numQueries = uint32_t(bcTextureIndices.size());
+
+    GraphicsBlockCompressionPass blockCompressionPass(device, int(numQueries));
     if (!blockCompressionPass.Init())
         return false;
 
-    GraphicsImageDifferencePass compareImagesPass(device);
+    GraphicsImageDifferencePass compareImagesPass(device, numQueries);
     if (!compareImagesPass.Init())
         return false;
 
@@ -987,13 +1221,14 @@ bool ComputePsnrForBlockCompressedTextureSet(
     float const alphaThreshold = 1.f / 255.f;
     float combinedBcBitsPerPixel = 0;
 
-    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    commandList->open();
+
+    for (uint32_t queryIndex = 0; queryIndex < numQueries; ++queryIndex)
     {
+        int const textureIndex = bcTextureIndices[queryIndex];
         ntc::ITextureMetadata* textureMetadata = textureSetMetadata->GetTexture(textureIndex);
         ntc::BlockCompressedFormat const bcFormat = textureMetadata->GetBlockCompressedFormat();
         int const numChannels = textureMetadata->GetNumChannels();
-        if (textureMetadata->GetBlockCompressedFormat() == ntc::BlockCompressedFormat::None)
-            continue;
         
         int const bytesPerBlock = GetBcFormatDefinition(textureMetadata->GetBlockCompressedFormat())->bytesPerBlock;
         combinedBcBitsPerPixel += float(bytesPerBlock) * 0.5f; // (* 8 bits / 16 pixels)
@@ -1012,6 +1247,8 @@ bool ComputePsnrForBlockCompressedTextureSet(
         compressParams.alphaThreshold = alphaThreshold;
         ntc::ComputePassDesc blockCompressionComputePass;
         ntc::Status ntcStatus = context->MakeBlockCompressionComputePass(compressParams, &blockCompressionComputePass);
+        if (ntcStatus != ntc::Status::Ok)
+            commandList->close();
         CHECK_NTC_RESULT("MakeBlockCompressionComputePass");
         
         // Make the image comparison pass
@@ -1022,9 +1259,9 @@ bool ComputePsnrForBlockCompressedTextureSet(
         differenceParams.alphaThreshold = alphaThreshold;
         ntc::ComputePassDesc imageDifferenceComputePass;
         ntcStatus = context->MakeImageDifferenceComputePass(differenceParams, &imageDifferenceComputePass);
+        if (ntcStatus != ntc::Status::Ok)
+            commandList->close();
         CHECK_NTC_RESULT("MakeImageDifferenceComputePass");
-
-        commandList->open();
         
         // Compress the color texture into the block texture
         if (!blockCompressionPass.ExecuteComputePass(commandList, blockCompressionComputePass,
@@ -1041,26 +1278,35 @@ bool ComputePsnrForBlockCompressedTextureSet(
         
         // Compare the BCn texture with the original color texture
         if (!compareImagesPass.ExecuteComputePass(commandList, imageDifferenceComputePass,
-            textureResources.bc, 0, textureResources.color, 0, 0))
+            textureResources.bc, 0, textureResources.color, 0, queryIndex))
         {
             commandList->close();
             return false;
         }
+    }
 
-        commandList->close();
+    commandList->close();
+
+    device->executeCommandList(commandList);
+    device->waitForIdle();
+    device->runGarbageCollection();
+    
+    // Read the per-channel MSE values and overall PSNR for all textures
+
+    if (!compareImagesPass.ReadResults())
+        return false;
+
+    for (uint32_t queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+    {
+        int const textureIndex = bcTextureIndices[queryIndex];
+        ntc::ITextureMetadata* textureMetadata = textureSetMetadata->GetTexture(textureIndex);
+        ntc::BlockCompressedFormat const bcFormat = textureMetadata->GetBlockCompressedFormat();
+        int const numChannels = textureMetadata->GetNumChannels();
+        GraphicsResourcesForTexture const& textureResources = graphicsResources.perTexture[textureIndex];
 
-        device->executeCommandList(commandList);
-        device->waitForIdle();
-        device->runGarbageCollection();
-        
-        // Read the per-channel MSE values and overall PSNR
-        
-        if (!compareImagesPass.ReadResults())
-            return false;
-            
         float mse[4];
         float psnr;
-        if (!compareImagesPass.GetQueryResult(0, mse, nullptr, &psnr, numChannels))
+        if (!compareImagesPass.GetQueryResult(queryIndex, mse, nullptr, &psnr, numChannels))
             return false;
 
         // Append the MSE values for the valid channels in this texture into the overall MSE vector
@@ -1078,6 +1324,8 @@ bool ComputePsnrForBlockCompressedTextureSet(
 
     printf("Combined BCn PSNR: %.2f dB, bit rate: %.1f bpp.\n", overallPSNR, combinedBcBitsPerPixel);
     outTargetPsnr = overallPSNR;
+    if (outCombinedBitsPerPixel)
+        *outCombinedBitsPerPixel = combinedBcBitsPerPixel;
     
     return true;
 }
@@ -15,10 +15,29 @@
 #include <nvrhi/nvrhi.h>
 #include <libntc/ntc.h>
 #include "Utils.h"
+#include <list>
+
+// Describes the textures in one GraphicsResourcesForTexture object, used to match pooled objects
+struct GraphicsResourceKey
+{
+    int width = 0;
+    int height = 0;
+    int mips = 0;
+    nvrhi::Format colorFormat = nvrhi::Format::UNKNOWN;
+    ntc::BlockCompressedFormat bcFormat = ntc::BlockCompressedFormat::None;
+    bool shared = false;
+
+    bool operator==(GraphicsResourceKey const& other) const
+    {
+        return width == other.width && height == other.height && mips == other.mips
+            && colorFormat == other.colorFormat && bcFormat == other.bcFormat && shared == other.shared;
+    }
+};
 
 struct GraphicsResourcesForTexture
 {
     std::string name;
+    GraphicsResourceKey key;
     nvrhi::TextureHandle color;
     nvrhi::StagingTextureHandle stagingColor;
     nvrhi::TextureHandle blocks;
@@ -31,21 +50,87 @@ struct GraphicsResourcesForTexture
     { }
 };
 
+// Keeps the graphics textures and shared CUDA registrations of texture sets that have been processed,
+// so that the next texture sets with matching dimensions and formats can reuse them instead of creating
+// new objects. Idle objects are released in least recently used order when their estimated size
+// exceeds the limit provided to the constructor.
+// The pool must be destroyed before the NTC context and the graphics device.
+class GraphicsResourcePool
+{
+public:
+    GraphicsResourcePool(uint64_t maxIdleBytes)
+        : m_maxIdleBytes(maxIdleBytes)
+    { }
+
+    // Returns a pooled object with the same key if there is one, otherwise returns nothing.
+    std::optional<GraphicsResourcesForTexture> Acquire(GraphicsResourceKey const& key);
+
+    // Returns an object to the pool.
+    void Release(GraphicsResourcesForTexture&& resources);
+
+    void Clear();
+
+    int GetHits() const { return m_hits; }
+    int GetMisses() const { return m_misses; }
+    float GetHitRate() const { return (m_hits + m_misses) > 0 ? float(m_hits) / float(m_hits + m_misses) : 0.f; }
+
+private:
+    struct Entry
+    {
+        GraphicsResourcesForTexture resources;
+        uint64_t sizeInBytes;
+    };
+
+    std::list<Entry> m_idle; // Most recently released first
+    uint64_t m_idleBytes = 0;
+    uint64_t m_maxIdleBytes;
+    int m_hits = 0;
+    int m_misses = 0;
+};
+
 struct GraphicsResourcesForTextureSet
 {
     std::vector<GraphicsResourcesForTexture> perTexture;
+
+    // When set, the textures are returned to this pool on destruction
+    GraphicsResourcePool* pool = nullptr;
+
+    GraphicsResourcesForTextureSet() = default;
+    GraphicsResourcesForTextureSet(GraphicsResourcesForTextureSet const&) = delete;
+    GraphicsResourcesForTextureSet& operator=(GraphicsResourcesForTextureSet const&) = delete;
+
+    ~GraphicsResourcesForTextureSet()
+    {
+        if (!pool)
+            return;
+
+        for (GraphicsResourcesForTexture& resources : perTexture)
+            pool->Release(std::move(resources));
+    }
 };
 
 class GraphicsDecompressionPass;
 struct GDeflateFeatures;
 
+// Registers a texture that was created with SharedResourceFlags::Shared with the NTC context,
+// so that the texture set can read or write it through CUDA.
+bool RegisterSharedGraphicsTexture(
+    ntc::IContext* context,
+    nvrhi::IDevice* device,
+    nvrhi::ITexture* texture,
+    ntc::ChannelFormat format,
+    ntc::SharedTextureWrapper& sharedTexture);
+
 bool CreateGraphicsResourcesFromMetadata(
     ntc::IContext* context,
     nvrhi::IDevice* device,
     ntc::ITextureSetMetadata* metadata,
     int mipLevels,
     bool enableCudaSharing,
-    GraphicsResourcesForTextureSet& resources);
+    GraphicsResourcesForTextureSet& resources,
+    GraphicsResourcePool* pool = nullptr,
+    int customWidth = 0, // Size of the created textures, 0 means the size of the texture set
+    int customHeight = 0);
 
 bool DecompressTextureSetWithGraphicsAPI(
     nvrhi::IDevice* device,
@@ -58,6 +143,16 @@ bool DecompressTextureSetWithGraphicsAPI(
     ntc::IStream* inputFile,
     int mipLevels,
     bool enableDithering,
+    ntc::InferenceWeightType weightType,
+    GraphicsResourcesForTextureSet const& graphicsResources,
+    int firstMipLevel = 0, // Mip level of the texture set that is decompressed into mip 0 of the resources
+    ntc::Rect const* region = nullptr); // Region of each mip to decompress, written at the origin of the resources
+
+bool CopyTextureDataIntoGraphicsTexture(
+    ntc::ITextureSet* textureSet,
+    int textureIndex,
+    ntc::TextureDataPage page,
+    bool allMipLevels,
     GraphicsResourcesForTextureSet const& graphicsResources);
 
 bool CopyTextureSetDataIntoGraphicsTextures(
@@ -74,7 +169,8 @@ bool SaveGraphicsStagingTextures(
     char const* savePath,
     ImageContainer const userProvidedContainer,
     bool saveMips,
-    GraphicsResourcesForTextureSet const& graphicsResources);
+    GraphicsResourcesForTextureSet const& graphicsResources,
+    bool includeBlockCompressed = false); // Save BCn textures as regular images instead of skipping them
 
 bool BlockCompressAndSaveGraphicsTextures(
     ntc::IContext* context,
@@ -85,8 +181,10 @@ bool BlockCompressAndSaveGraphicsTextures(
     nvrhi::ITimerQuery* timerQuery,
     GDeflateFeatures* gdeflateFeatures,
     char const* savePath,
+    bool saveGDeflate, // Save the DDS files as GDeflate streams for DirectStorage, see DdsFileWriter
     int benchmarkIterations,
-    GraphicsResourcesForTextureSet const& graphicsResources);
+    GraphicsResourcesForTextureSet const& graphicsResources,
+    std::function<bool(int textureIndex)> const& prepareTexture = nullptr);
 
 bool OptimizeBlockCompression(
     ntc::IContext* context,
@@ -102,4 +200,5 @@ bool ComputePsnrForBlockCompressedTextureSet(
     nvrhi::IDevice* device,
     nvrhi::ICommandList* commandList,
     GraphicsResourcesForTextureSet const& graphicsResources,
-    float& outTargetPsnr);
\ No newline at end of file
+    float& outTargetPsnr,
+    float* outCombinedBitsPerPixel = nullptr);
\ No newline at end of file
@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "JobReport.h"
+#include <json/json.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+void JobReport::ResetJobResults()
+{
+    JobReport emptyReport;
+    emptyReport.gpuName = std::move(gpuName);
+    emptyReport.graphicsApi = std::move(graphicsApi);
+    emptyReport.gpuFeatures = std::move(gpuFeatures);
+    *this = std::move(emptyReport);
+}
+
+void JobReport::BeginCompressionRun(float bitsPerPixel)
+{
+    compressionRuns.emplace_back().bitsPerPixel = bitsPerPixel;
+}
+
+void JobReport::AddTrainingStep(int steps, float millisecondsPerStep, float psnr)
+{
+    // Training without a search doesn't announce its run, so create one on the first step
+    if (compressionRuns.empty())
+        compressionRuns.emplace_back();
+
+    compressionRuns.back().learningCurve.push_back({ steps, millisecondsPerStep, psnr });
+}
+
+template<typename T>
+static void SetOptional(Json::Value& node, char const* name, std::optional<T> const& value)
+{
+    if (value.has_value())
+        node[name] = *value;
+}
+
+void WriteJobReport(FILE* stream, JobReport const& report, bool success, float elapsedTime)
+{
+    Json::Value root;
+    root["success"] = success;
+    root["elapsedTime"] = elapsedTime;
+
+    if (!report.gpuName.empty())
+        root["gpuName"] = report.gpuName;
+    if (!report.graphicsApi.empty())
+        root["graphicsApi"] = report.graphicsApi;
+    if (!report.gpuFeatures.empty() || !report.graphicsApi.empty())
+    {
+        Json::Value& features = root["gpuFeatures"] = Json::Value(Json::arrayValue);
+        for (std::string const& feature : report.gpuFeatures)
+            features.append(feature);
+    }
+
+    SetOptional(root, "overallPsnr", report.overallPsnr);
+    SetOptional(root, "overallPsnrFP8", report.overallPsnrFP8);
+    SetOptional(root, "bitsPerPixel", report.bitsPerPixel);
+    SetOptional(root, "combinedBcPsnr", report.combinedBcPsnr);
+    SetOptional(root, "combinedBcBitsPerPixel", report.combinedBcBitsPerPixel);
+    SetOptional(root, "decompressionTime", report.decompressionTime);
+    SetOptional(root, "savedFileBpp", report.savedFileBpp);
+    SetOptional(root, "cacheHit", report.cacheHit);
+    SetOptional(root, "channels", report.channels);
+    SetOptional(root, "mipLevels", report.mipLevels);
+
+    if (report.savedFileSize.has_value())
+        root["savedFileSize"] = Json::UInt64(*report.savedFileSize);
+
+    if (report.width.has_value() && report.height.has_value())
+    {
+        Json::Value& dimensions = root["dimensions"] = Json::Value(Json::arrayValue);
+        dimensions.append(*report.width);
+        dimensions.append(*report.height);
+    }
+
+    if (report.gridSizeScale.has_value() && report.numFeatures.has_value())
+    {
+        Json::Value& latentShape = root["latentShape"];
+        latentShape["gridSizeScale"] = *report.gridSizeScale;
+        latentShape["numFeatures"] = *report.numFeatures;
+    }
+
+    if (!report.perMipPsnr.empty())
+    {
+        Json::Value& perMipPsnr = root["perMipPsnr"] = Json::Value(Json::arrayValue);
+        for (float psnr : report.perMipPsnr)
+            perMipPsnr.append(psnr);
+    }
+
+    if (!report.perTexturePsnr.empty())
+    {
+        Json::Value& perTexturePsnr = root["perTexturePsnr"];
+        for (auto const& [name, psnr] : report.perTexturePsnr)
+            perTexturePsnr[name] = psnr;
+    }
+
+    // Runs without training steps come from the parallel search, which doesn't report progress
+    Json::Value compressionRuns(Json::arrayValue);
+    for (CompressionRunReport const& run : report.compressionRuns)
+    {
+        if (run.learningCurve.empty())
+            continue;
+
+        Json::Value runNode;
+        SetOptional(runNode, "bitsPerPixel", run.bitsPerPixel);
+        Json::Value& learningCurve = runNode["learningCurve"] = Json::Value(Json::arrayValue);
+        for (TrainingStepReport const& step : run.learningCurve)
+        {
+            Json::Value stepNode(Json::arrayValue);
+            stepNode.append(step.steps);
+            stepNode.append(step.millisecondsPerStep);
+            stepNode.append(step.psnr);
+            learningCurve.append(stepNode);
+        }
+        compressionRuns.append(runNode);
+    }
+    if (!compressionRuns.empty())
+        root["compressionRuns"] = compressionRuns;
+
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "";
+    std::string const line = Json::writeString(writerBuilder, root);
+
+    fprintf(stream, "%s\n", line.c_str());
+    fflush(stream);
+}
+
+FILE* SeparateResponseStreamFromStdout()
+{
+    fflush(stdout);
+#ifdef _WIN32
+    int const responseFd = _dup(_fileno(stdout));
+    if (responseFd < 0)
+        return nullptr;
+    if (_dup2(_fileno(stderr), _fileno(stdout)) != 0)
+    {
+        _close(responseFd);
+        return nullptr;
+    }
+    return _fdopen(responseFd, "w");
+#else
+    int const responseFd = dup(fileno(stdout));
+    if (responseFd < 0)
+        return nullptr;
+    if (dup2(fileno(stderr), fileno(stdout)) < 0)
+    {
+        close(responseFd);
+        return nullptr;
+    }
+    return fdopen(responseFd, "w");
+#endif
+}
@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One progress report from the training loop
+struct TrainingStepReport
+{
+    int steps = 0;
+    float millisecondsPerStep = 0.f;
+    float psnr = 0.f;
+};
+
+// One compression experiment, there are several of them when searching for a target PSNR
+struct CompressionRunReport
+{
+    std::optional<float> bitsPerPixel;
+    std::vector<TrainingStepReport> learningCurve;
+};
+
+// Results of processing one texture set, collected in the places where the tool prints them.
+// The --server mode returns them as JSON, with the same names as the fields of ntc.Result in libraries/ntc.py.
+// Values that the job didn't produce are left unset and omitted from the JSON.
+struct JobReport
+{
+    // Information about the devices, reported once per process
+    std::string gpuName;
+    std::string graphicsApi;
+    std::vector<std::string> gpuFeatures;
+
+    std::optional<float> overallPsnr;
+    std::optional<float> overallPsnrFP8;
+    std::vector<float> perMipPsnr;
+    std::vector<std::pair<std::string, float>> perTexturePsnr;
+    std::optional<float> bitsPerPixel;
+    std::optional<float> combinedBcPsnr;
+    std::optional<float> combinedBcBitsPerPixel;
+    std::vector<CompressionRunReport> compressionRuns;
+    std::optional<float> decompressionTime; // milliseconds
+    std::optional<uint64_t> savedFileSize;
+    std::optional<float> savedFileBpp;
+    std::optional<bool> cacheHit;
+    std::optional<int> width;
+    std::optional<int> height;
+    std::optional<int> channels;
+    std::optional<int> mipLevels;
+    std::optional<int> gridSizeScale;
+    std::optional<int> numFeatures;
+
+    // Keeps the device information and clears the results of the previous job
+    void ResetJobResults();
+
+    // Starts a new compression run, the following training steps are added to it
+    void BeginCompressionRun(float bitsPerPixel);
+
+    void AddTrainingStep(int steps, float millisecondsPerStep, float psnr);
+};
+
+// Writes the report as a single line of JSON followed by a newline, and flushes the stream.
+// The 'success' and 'elapsedTime' fields are added to the report's fields.
+void WriteJobReport(FILE* stream, JobReport const& report, bool success, float elapsedTime);
+
+// Makes stdout write into stderr and returns a new stream for the original stdout, or nullptr on failure.
+// Used by --server to keep the regular messages of the tool out of the response stream.
+FILE* SeparateResponseStreamFromStdout();
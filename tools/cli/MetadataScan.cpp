@@ -0,0 +1,245 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "MetadataScan.h"
+#include <json/json.h>
+#include <ntc-utils/Manifest.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+BufferCompressionStats GetLatentCompressionStats(ntc::ITextureSetMetadata* textureSet)
+{
+    BufferCompressionStats stats;
+    ntc::LatentTextureDesc const latentTextureDesc = textureSet->GetLatentTextureDesc();
+    for (int mipLevel = 0; mipLevel < latentTextureDesc.mipLevels; ++mipLevel)
+    {
+        for (int layerIndex = 0; layerIndex < latentTextureDesc.arraySize; ++layerIndex)
+        {
+            ntc::LatentTextureFootprint footprint;
+            if (textureSet->GetLatentTextureFootprint(mipLevel, layerIndex, footprint) != ntc::Status::Ok)
+                continue;
+
+            ++stats.totalBuffers;
+            if (footprint.buffer.compressionType != ntc::CompressionType::None)
+            {
+                stats.compressionType = footprint.buffer.compressionType;
+                ++stats.compressedBuffers;
+            }
+        }
+    }
+    return stats;
+}
+
+BufferCompressionStats GetBC7ModeBufferStats(ntc::ITextureMetadata* texture, int mipLevels)
+{
+    BufferCompressionStats stats;
+    for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
+    {
+        ntc::BufferFootprint const modeBufferFootprint = texture->GetBC7ModeBufferFootprint(mipLevel);
+        if (modeBufferFootprint.rangeInStream.size == 0)
+            continue;
+
+        ++stats.totalBuffers;
+        if (modeBufferFootprint.compressionType != ntc::CompressionType::None)
+        {
+            stats.compressionType = modeBufferFootprint.compressionType;
+            ++stats.compressedBuffers;
+        }
+    }
+    return stats;
+}
+
+bool FindTextureSetFiles(std::vector<char const*> const& paths, std::vector<fs::path>& outFiles,
+    std::string& outError)
+{
+    auto isTextureSetFile = [](fs::path const& path)
+    {
+        std::string extension = path.extension().string();
+        LowercaseString(extension);
+        return extension == ".ntc";
+    };
+
+    for (char const* pathString : paths)
+    {
+        fs::path const path = pathString;
+        std::error_code ec;
+        if (fs::is_directory(path, ec))
+        {
+            for (auto it = fs::recursive_directory_iterator(path, ec); !ec && it != fs::recursive_directory_iterator();
+                it.increment(ec))
+            {
+                if (it->is_regular_file(ec) && isTextureSetFile(it->path()))
+                    outFiles.push_back(it->path());
+            }
+
+            if (ec)
+            {
+                outError = "Cannot list the files in '" + path.generic_string() + "': " + ec.message();
+                return false;
+            }
+        }
+        else if (fs::is_regular_file(path, ec) && isTextureSetFile(path))
+        {
+            outFiles.push_back(path);
+        }
+        else
+        {
+            outError = "'" + path.generic_string() + "' is not a directory or an .ntc file.";
+            return false;
+        }
+    }
+
+    std::sort(outFiles.begin(), outFiles.end());
+    outFiles.erase(std::unique(outFiles.begin(), outFiles.end()), outFiles.end());
+    return true;
+}
+
+static void SetCompressionStats(Json::Value& node, BufferCompressionStats const& stats)
+{
+    node["compression"] = ntc::CompressionTypeToString(stats.compressionType);
+    node["compressedBuffers"] = stats.compressedBuffers;
+    node["totalBuffers"] = stats.totalBuffers;
+}
+
+// Parses the metadata of one file and returns its description as a line of JSON, without the newline
+static std::string DescribeTextureSetFile(ntc::IContext* context, fs::path const& file, bool& outSuccess)
+{
+    Json::Value root;
+    root["file"] = file.generic_string();
+    outSuccess = false;
+
+    ntc::FileStreamWrapper inputFile(context);
+    ntc::TextureSetMetadataWrapper metadata(context);
+    ntc::Status ntcStatus = context->OpenFile(file.string().c_str(), false, inputFile.ptr());
+    if (ntcStatus == ntc::Status::Ok)
+        ntcStatus = context->CreateTextureSetMetadataFromStream(inputFile, metadata.ptr());
+
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        root["success"] = false;
+        root["error"] = std::string(ntc::StatusToString(ntcStatus)) + ": " + ntc::GetLastErrorMessage();
+    }
+    else
+    {
+        outSuccess = true;
+        root["success"] = true;
+        root["fileSize"] = Json::UInt64(inputFile->Size());
+
+        // Same names as the fields of the --server job reports, see WriteJobReport
+        ntc::TextureSetDesc const& desc = metadata->GetDesc();
+        Json::Value& dimensions = root["dimensions"] = Json::Value(Json::arrayValue);
+        dimensions.append(desc.width);
+        dimensions.append(desc.height);
+        root["channels"] = desc.channels;
+        root["mipLevels"] = desc.mips;
+
+        ntc::LatentShape const& latentShape = metadata->GetLatentShape();
+        root["bitsPerPixel"] = ntc::GetLatentShapeBitsPerPixel(latentShape);
+        root["latentShape"]["gridSizeScale"] = latentShape.gridSizeScale;
+        root["latentShape"]["numFeatures"] = latentShape.numFeatures;
+
+        Json::Value& weightTypes = root["inferenceWeights"] = Json::Value(Json::arrayValue);
+        if (metadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericInt8))
+            weightTypes.append("Int8");
+        if (metadata->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericFP8))
+            weightTypes.append("FP8");
+
+        SetCompressionStats(root["latentCompression"], GetLatentCompressionStats(metadata));
+
+        Json::Value& textures = root["textures"] = Json::Value(Json::arrayValue);
+        for (int i = 0; i < metadata->GetTextureCount(); ++i)
+        {
+            ntc::ITextureMetadata* texture = metadata->GetTexture(i);
+            int firstChannel, numChannels;
+            texture->GetChannels(firstChannel, numChannels);
+
+            Json::Value& textureNode = textures.append(Json::Value(Json::objectValue));
+            textureNode["name"] = texture->GetName();
+            textureNode["firstChannel"] = firstChannel;
+            textureNode["numChannels"] = numChannels;
+            textureNode["channelFormat"] = ntc::ChannelFormatToString(texture->GetChannelFormat());
+            textureNode["bcFormat"] = ntc::BlockCompressedFormatToString(texture->GetBlockCompressedFormat());
+            textureNode["rgbColorSpace"] = ntc::ColorSpaceToString(texture->GetRgbColorSpace());
+            if (numChannels > 3)
+                textureNode["alphaColorSpace"] = ntc::ColorSpaceToString(texture->GetAlphaColorSpace());
+
+            if (texture->GetBlockCompressedFormat() == ntc::BlockCompressedFormat::BC7)
+                SetCompressionStats(textureNode["bc7ModeBuffers"], GetBC7ModeBufferStats(texture, desc.mips));
+        }
+    }
+
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "";
+    return Json::writeString(writerBuilder, root);
+}
+
+int DescribeTextureSetFiles(ntc::IContext* context, std::vector<fs::path> const& files, int numThreads, FILE* stream)
+{
+    if (numThreads <= 0)
+        numThreads = int(std::max(std::thread::hardware_concurrency(), 1u));
+    numThreads = std::min(numThreads, std::max(int(files.size()), 1));
+
+    // The workers take the files in order and store their lines, which this thread writes in the same order
+    // as soon as all the previous lines are written, so that the output doesn't depend on the thread timing.
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<std::string> lines(files.size());
+    std::vector<bool> linesReady(files.size(), false);
+    std::atomic<size_t> nextFile = 0;
+    std::atomic<int> failedFiles = 0;
+
+    auto worker = [&]()
+    {
+        while (true)
+        {
+            size_t const fileIndex = nextFile++;
+            if (fileIndex >= files.size())
+                return;
+
+            bool success = false;
+            std::string line = DescribeTextureSetFile(context, files[fileIndex], success);
+            if (!success)
+                ++failedFiles;
+
+            std::lock_guard lock(mutex);
+            lines[fileIndex] = std::move(line);
+            linesReady[fileIndex] = true;
+            condition.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i)
+        threads.emplace_back(worker);
+
+    for (size_t fileIndex = 0; fileIndex < files.size(); ++fileIndex)
+    {
+        std::string line;
+        {
+            std::unique_lock lock(mutex);
+            condition.wait(lock, [&]() { return bool(linesReady[fileIndex]); });
+            line = std::move(lines[fileIndex]);
+        }
+        fprintf(stream, "%s\n", line.c_str());
+    }
+    fflush(stream);
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    return failedFiles;
+}
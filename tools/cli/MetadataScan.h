@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <libntc/ntc.h>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Counts the buffers of a texture set that are stored with lossless compression, such as GDeflate
+struct BufferCompressionStats
+{
+    ntc::CompressionType compressionType = ntc::CompressionType::None; // Type of the last compressed buffer
+    int totalBuffers = 0;
+    int compressedBuffers = 0;
+};
+
+// Counts the latent texture slices of all mip levels and layers
+BufferCompressionStats GetLatentCompressionStats(ntc::ITextureSetMetadata* textureSet);
+
+// Counts the BC7 mode buffers of all mip levels of a texture, the mips without a buffer are not counted
+BufferCompressionStats GetBC7ModeBufferStats(ntc::ITextureMetadata* texture, int mipLevels);
+
+// Finds the compressed texture sets for --describeAll: the paths are .ntc files or directories
+// that are searched recursively. The files are sorted by path.
+bool FindTextureSetFiles(std::vector<char const*> const& paths, std::vector<std::filesystem::path>& outFiles,
+    std::string& outError);
+
+// Parses the metadata of the files on numThreads threads (0 means all hardware threads) using a context that
+// doesn't need CUDA or a graphics device, and writes one line of JSON per file into the stream, in the order of
+// the files. Returns the number of files that could not be parsed, which are reported with "success": false.
+int DescribeTextureSetFiles(ntc::IContext* context, std::vector<std::filesystem::path> const& files,
+    int numThreads, FILE* stream);
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -11,42 +11,68 @@
  */
 
 #include <argparse.h>
+#include <chrono>
 #include <cinttypes>
 #include <cmath>
+#include <condition_variable>
 #include <cuda_runtime_api.h>
+#include <deque>
 #include <donut/app/DeviceManager.h>
 #include <filesystem>
+#include <future>
+#include <iostream>
 #include <libntc/ntc.h>
+#include <mutex>
 #include <ntc-utils/DeviceUtils.h>
 #include <ntc-utils/GraphicsDecompressionPass.h>
+#include <ntc-utils/ImageProbe.h>
+#include <ntc-utils/MappedFile.h>
 #include <ntc-utils/Manifest.h>
 #include <ntc-utils/Misc.h>
+#include <ntc-utils/NtcPackage.h>
+#include <ntc-utils/PoolAllocator.h>
 #include <ntc-utils/Semantics.h>
+#include <ntc-utils/WeightTypeSelection.h>
 #include <nvrhi/utils.h>
 #include <stb_image.h>
 #include <tinyexr.h>
+#include "BlockDecompressionPass.h"
+#include "CompressionCache.h"
 #include "GraphicsPasses.h"
+#include "JobReport.h"
+#include "MetadataScan.h"
 #include "Utils.h"
 
 namespace fs = std::filesystem;
 
-struct
+struct ToolOptions
 {
+    const char* batchFileName = nullptr;
+    const char* cacheDirectory = nullptr;
+    const char* generateManifestsPath = nullptr;
+    const char* manifestDirectory = nullptr;
+    const char* saveBatchFileName = nullptr;
+    const char* savePackageFileName = nullptr;
     const char* loadImagesPath = nullptr;
     const char* loadManifestFileName = nullptr;
     const char* saveImagesPath = nullptr;
     const char* loadCompressedFileName = nullptr;
     const char* saveCompressedFileName = nullptr;
     const char* saveManifestFileName = nullptr;
+    const char* warmStartFileName = nullptr;
     ToolInputType inputType = ToolInputType::None;
     std::vector<char const*> loadImagesList;
+    std::vector<char const*> describePaths; // Files and directories for --describeAll
     std::optional<ntc::BlockCompressedFormat> bcFormat;
     ImageContainer imageFormat = ImageContainer::Auto;
+    ntc::InferenceWeightType weightType = ntc::InferenceWeightType::Unknown; // Unknown means auto
+    const char* weightTypeCacheFileName = nullptr; // nullptr means ntc-weight-types.json next to the executable
     bool compress = false;
     bool decompress = false;
     bool readManifestFromStdin = false;
     bool loadMips = false;
     bool saveMips = false;
+    bool saveGDeflate = false;
     bool generateMips = false;
     bool optimizeBC = false;
     bool useVulkan = false;
@@ -55,21 +81,34 @@ struct
     bool listAdapters = false;
     bool listCudaDevices = false;
     bool describe = false;
+    bool describeAll = false;
     bool discardMaskedOutPixels = false;
     bool enableCoopVec = true;
     bool enableGpuDeflate = false;
     bool printVersion = false;
     bool enableDithering = true;
     bool keepFileNames = false;
+    bool printAllocatorStats = false;
+    bool server = false;
     int gridSizeScale = 2;
     int numFeatures = NTC_MLP_FEATURES;
     int adapterIndex = -1;
     int cudaDevice = 0;
     int benchmarkIterations = 1;
+    bool benchmarkWeightTypes = false;
+    int cacheMaxSize = 4096;
+    int imageMemoryLimit = 0;
+    int imageThreads = 0;
+    int convergenceWindow = 0;
+    int warmStartSteps = 0;
+    float convergenceThreshold = 0.05f;
+    float convergenceTargetMargin = 0.5f;
     float experimentalKnob = 0.f;
     float bitsPerPixel = NAN; // Use an "undefined" value to tell if something came from the command line
     float targetPsnr = NAN;
     float maxBitsPerPixel = NAN;
+    std::vector<int> searchDevices;
+    std::vector<int> seedSearchDevices;
     bool matchBcPsnr = false;
     float minBcPsnr = 0.f;
     float maxBcPsnr = INFINITY;
@@ -77,33 +116,76 @@ struct
     float bcPsnrThreshold = 0.2f;
     std::optional<int> customWidth;
     std::optional<int> customHeight;
+    std::optional<ntc::Rect> decompressionRect;
+    int decompressionMip = -1; // -1 means not specified
     ntc::CompressionSettings compressionSettings;
     ntc::LosslessCompressionSettings losslessCompression;
 } g_options;
 
+// Allocator for the library, the processing functions attribute its allocations to phases for --allocatorStats
+static PoolAllocator g_allocator;
+
+// Results of the current texture set, returned to the client in --server mode
+static JobReport g_jobReport;
+
+// Parses a comma-separated list of CUDA device indices for --searchDevices or --seedSearchDevices
+static bool ParseDeviceList(char const* string, char const* optionName, std::vector<int>& outDevices)
+{
+    char const* item = string;
+    while (*item)
+    {
+        char* end = nullptr;
+        long const device = strtol(item, &end, 10);
+        if (end == item || device < 0 || *end != ',' && *end != 0)
+        {
+            fprintf(stderr, "Invalid value '%s' for %s, must be a comma-separated list "
+                "of CUDA device indices.\n", string, optionName);
+            return false;
+        }
+
+        outDevices.push_back(int(device));
+        item = (*end == ',') ? end + 1 : end;
+    }
+    return true;
+}
+
 bool ProcessCommandLine(int argc, const char** argv)
 {
     const char* bcFormatString = nullptr;
     const char* imageFormatString = nullptr;
     const char* dimensionsString = nullptr;
+    const char* rectString = nullptr;
     const char* gdeflateString = nullptr;
+    const char* searchDevicesString = nullptr;
+    const char* seedSearchDevicesString = nullptr;
+    const char* weightTypeString = nullptr;
 
     struct argparse_option options[] = {
         OPT_GROUP("Actions:"),
+        OPT_STRING (0,   "batch", &g_options.batchFileName, "Process all texture sets listed in the specified JSON file with one CUDA context and graphics device"),
         OPT_BOOLEAN('c', "compress", &g_options.compress, "Perform NTC compression"),
         OPT_BOOLEAN('D', "decompress", &g_options.decompress, "Perform NTC decompression (implied when needed)"),
         OPT_BOOLEAN('d', "describe", &g_options.describe, "Describe the contents of a compressed texture set"),
+        OPT_BOOLEAN(0,   "describeAll", &g_options.describeAll, "Describe all compressed texture sets listed as positional arguments or found in the listed directories, "
+            "as JSON lines, in parallel and without a GPU"),
+        OPT_STRING (0,   "generateManifests", &g_options.generateManifestsPath, "Recursively generate a manifest for every folder with images under the specified folder, "
+            "see --manifestDir and --saveBatch"),
         OPT_BOOLEAN('g', "generateMips", &g_options.generateMips, "Generate MIP level images before compression"),
         OPT_STRING (0,   "loadCompressed", &g_options.loadCompressedFileName, "Load compressed texture set from the specified file"),
         OPT_STRING (0,   "loadImages", &g_options.loadImagesPath, "Load channel images from the specified folder"),
         OPT_STRING (0,   "loadManifest", &g_options.loadManifestFileName, "Load channel images and their parameters using the specified JSON manifest file"),
+        OPT_STRING (0,   "manifestDir", &g_options.manifestDirectory, "Output folder for --generateManifests, mirroring the input folder structure"),
         OPT_BOOLEAN(0,   "loadMips", &g_options.loadMips, "Load MIP level images from <loadImages>/mips/<texture>.<mip>.<ext> before compression"),
         OPT_BOOLEAN(0,   "optimizeBC", &g_options.optimizeBC, "Run slow BC compression and store acceleration info in the NTC package"),
         OPT_BOOLEAN(0,   "readManifestFromStdin", &g_options.readManifestFromStdin, "Load channel images using a JSON manifest passed through standard input (stdin)"),
         OPT_STRING ('o', "saveCompressed", &g_options.saveCompressedFileName, "Save compressed texture set into the specified file"),
         OPT_STRING ('i', "saveImages", &g_options.saveImagesPath, "Save channel images into the specified folder"),
+        OPT_STRING (0,   "saveBatch", &g_options.saveBatchFileName, "With --generateManifests, save a batch file with one compression job per manifest"),
+        OPT_STRING (0,   "savePackage", &g_options.savePackageFileName, "With --batch, pack the compressed texture sets of all jobs into the specified .ntcpak file"),
         OPT_STRING (0,   "saveManifest", &g_options.saveManifestFileName, "Save a manifest JSON file (only for image inputs)"),
         OPT_BOOLEAN(0,   "saveMips", &g_options.saveMips, "Save MIP level images into <saveImages>/mips/ after decompression"),
+        OPT_BOOLEAN(0,   "server", &g_options.server, "Process jobs received as JSON lines through stdin with one CUDA context and graphics device, "
+            "and write their results to stdout as JSON lines"),
         OPT_BOOLEAN(0,   "version", &g_options.printVersion, "Print version information and exit"),
         OPT_HELP(),
         
@@ -111,6 +193,8 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_FLOAT  ('b', "bitsPerPixel", &g_options.bitsPerPixel, "Request an optimal compression configuration for the provided BPP value"),
         OPT_FLOAT  (0,   "maxBitsPerPixel", &g_options.maxBitsPerPixel, "Maximum BPP value to use in the compression parameter search"),
         OPT_FLOAT  ('p', "targetPsnr", &g_options.targetPsnr, "Perform compression parameter search to reach at least the provided PSNR value"),
+        OPT_STRING (0,   "searchDevices", &searchDevicesString, "Comma-separated list of CUDA devices to evaluate multiple latent shapes at once during the parameter search, "
+            "a device can be listed more than once"),
         
         OPT_GROUP("Custom latent shape selection:"),
         OPT_INTEGER(0, "gridSizeScale", &g_options.gridSizeScale, "Ratio of source image size to high-resolution feature grid size"),
@@ -118,22 +202,35 @@ bool ProcessCommandLine(int argc, const char** argv)
         
         OPT_GROUP("Training process controls:"),
         OPT_FLOAT  (0,   "gridLearningRate", &g_options.compressionSettings.gridLearningRate, "Maximum learning rate for the feature grid"),
+        OPT_INTEGER(0,   "convergenceWindow", &g_options.convergenceWindow, "Stop training early when PSNR improves by less than --convergenceThreshold over this many steps, 0 disables (default)"),
+        OPT_FLOAT  (0,   "convergenceThreshold", &g_options.convergenceThreshold, "Minimum PSNR improvement in dB over the convergence window to continue training, default is 0.05"),
+        OPT_FLOAT  (0,   "convergenceTargetMargin", &g_options.convergenceTargetMargin, "Intermediate PSNR in dB above the target at which training stops early, to cover the weight quantization loss, default is 0.5"),
         OPT_INTEGER(0,   "kPixelsPerBatch", &g_options.compressionSettings.kPixelsPerBatch, "Number of kilopixels from the image to process in one training step"),
         OPT_FLOAT  (0,   "networkLearningRate", &g_options.compressionSettings.networkLearningRate, "Maximum learning rate for the MLP weights"),
         OPT_INTEGER(0,   "randomSeed", &g_options.compressionSettings.randomSeed, "Random seed, set to a nonzero value to get more stable compression results"),
+        OPT_STRING (0,   "seedSearchDevices", &seedSearchDevicesString, "Comma-separated list of CUDA devices for a best-of-N seed search: every device trains the same "
+            "latent shape with a different seed and the run with the highest PSNR is kept, this doesn't make training faster"),
         OPT_BOOLEAN(0,   "stableTraining", &g_options.compressionSettings.stableTraining, "Use a more expensive but more numerically stable training algorithm for reproducible results"),
         OPT_INTEGER(0,   "stepsPerIteration", &g_options.compressionSettings.stepsPerIteration, "Training steps between progress reports"),
         OPT_INTEGER('S', "trainingSteps", &g_options.compressionSettings.trainingSteps, "Total training step count"),
+        OPT_STRING (0,   "warmStart", &g_options.warmStartFileName, "Start compression from the latents and weights stored in an existing compressed file with the same dimensions"),
+        OPT_INTEGER(0,   "warmStartSteps", &g_options.warmStartSteps, "Training step count when using --warmStart, default is 1/10 of --trainingSteps"),
         
         OPT_GROUP("Output settings:"),
         OPT_STRING ('B', "bcFormat", &bcFormatString, "Set or override the BCn encoding format, BC1-BC7"),
         OPT_STRING ('F', "imageFormat", &imageFormatString, "Set the output file format for color images: Auto (default), BMP, JPG, TGA, PNG, PNG16, EXR"),
+        OPT_BOOLEAN(0,   "ddsGDeflate", &g_options.saveGDeflate, "Save the BCn DDS files compressed with GDeflate for DirectStorage, as .dds.gdeflate files"),
         OPT_STRING (0,   "dimensions", &dimensionsString, "Set the dimensions of the NTC texture set before compression, in the 'WxH' format"),
         OPT_BOOLEAN(0,   "dithering", &g_options.enableDithering, "Enable dithering for 8-bit output textures when decompressing with graphics APIs (default on, use --no-dithering)"),
+        OPT_STRING (0,   "rect", &rectString, "Decompress only a region of the texture set with graphics APIs, in the 'X,Y,W,H' format, in pixels of the decompressed mip level"),
+        OPT_INTEGER(0,   "mip", &g_options.decompressionMip, "Decompress only one mip level of the texture set with graphics APIs"),
         
         OPT_GROUP("Advanced settings:"),
+        OPT_BOOLEAN(0,   "allocatorStats", &g_options.printAllocatorStats, "Print the library memory allocation statistics for the load, compress, decompress and save phases before exiting"),
         OPT_FLOAT  (0,   "bcPsnrThreshold", &g_options.bcPsnrThreshold, "PSNR loss threshold for BC7 optimization, in dB, default value is 0.2"),
         OPT_INTEGER(0,   "benchmark", &g_options.benchmarkIterations, "Number of iterations to run over compute passes for benchmarking"),
+        OPT_STRING (0,   "cacheDir", &g_options.cacheDirectory, "Reuse compression results stored in this directory when the inputs and settings match, and store new results there"),
+        OPT_INTEGER(0,   "cacheMaxSize", &g_options.cacheMaxSize, "Maximum total size of the compression cache in megabytes, 0 means unlimited, default is 4096"),
         OPT_BOOLEAN(0,   "discardMaskedOutPixels", &g_options.discardMaskedOutPixels, "Ignore contents of pixels where alpha mask is 0.0 (requires the AlphaMask semantic)"),
         OPT_FLOAT  (0,   "experimentalKnob", &g_options.experimentalKnob, "A parameter for NTC development, normally has no effect"),
         OPT_BOOLEAN(0,   "matchBcPsnr", &g_options.matchBcPsnr, "Perform compression parameter search to reach the PSNR value that BCn encoding provides"),
@@ -145,6 +242,8 @@ bool ProcessCommandLine(int argc, const char** argv)
             "Don't use GDeflate compression if sizeof(compressedData) >= sizeof(uncompressedData) * X, default is 0.95"),
         OPT_INTEGER(0,   "gdeflateLevel", &g_options.losslessCompression.compressionLevel, "GDeflate compression level, 0-12, default is 9"),
         OPT_INTEGER(0,   "gdeflateThreads", &g_options.losslessCompression.compressionThreads, "Number of GDeflate compression threads, 0 means auto, -1 means disable"),
+        OPT_INTEGER(0,   "imageMemoryLimit", &g_options.imageMemoryLimit, "Limit the memory used by decoded input and output images, in megabytes, and decode inputs while uploading them; 0 means unlimited (default)"),
+        OPT_INTEGER(0,   "imageThreads", &g_options.imageThreads, "Maximum number of images decoded or encoded at the same time, 0 means no limit (default)"),
         OPT_BOOLEAN(0,   "keepFileNames", &g_options.keepFileNames, "Use original image file names as texture names, not their distinct components"),
 
         OPT_GROUP("GPU and Graphics API settings:"),
@@ -161,6 +260,9 @@ bool ProcessCommandLine(int argc, const char** argv)
 #if NTC_WITH_VULKAN
         OPT_BOOLEAN(0, "vk", &g_options.useVulkan, "Use Vulkan API for graphics operations"),
 #endif
+        OPT_STRING (0, "weightType", &weightTypeString, "Inference weight type for graphics API decompression: Auto (default), Int8, FP8, CoopVec"),
+        OPT_BOOLEAN(0, "benchmarkWeightTypes", &g_options.benchmarkWeightTypes, "With --weightType Auto, use the fastest weight type measured on this adapter and driver, running a benchmark when it's not cached yet"),
+        OPT_STRING (0, "weightTypeCache", &g_options.weightTypeCacheFileName, "File with the weight type benchmark results per adapter and driver, default is ntc-weight-types.json next to the executable"),
         OPT_END()
     };
 
@@ -192,6 +294,54 @@ bool ProcessCommandLine(int argc, const char** argv)
     if (g_options.listCudaDevices || g_options.printVersion)
         return true;
 
+    if (g_options.generateManifestsPath)
+    {
+        if (!fs::is_directory(g_options.generateManifestsPath))
+        {
+            fprintf(stderr, "Input directory '%s' does not exist.\n", g_options.generateManifestsPath);
+            return false;
+        }
+
+        if (!g_options.manifestDirectory)
+        {
+            fprintf(stderr, "Option --generateManifests requires --manifestDir.\n");
+            return false;
+        }
+
+        if (g_options.imageThreads < 0)
+        {
+            fprintf(stderr, "The --imageThreads value must be 0 or more.\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    if (g_options.describeAll)
+    {
+        if (g_options.loadCompressedFileName)
+            g_options.describePaths.push_back(g_options.loadCompressedFileName);
+        for (int i = 0; argparse.out[i]; ++i)
+        {
+            if (argparse.out[i][0])
+                g_options.describePaths.push_back(argparse.out[i]);
+        }
+
+        if (g_options.describePaths.empty())
+        {
+            fprintf(stderr, "Option --describeAll requires .ntc files or directories as positional arguments.\n");
+            return false;
+        }
+
+        if (g_options.imageThreads < 0)
+        {
+            fprintf(stderr, "The --imageThreads value must be 0 or more.\n");
+            return false;
+        }
+
+        return true;
+    }
+
     if (!useGapi && g_options.listAdapters)
     {
         fprintf(stderr, "--listAdapters requires either --dx12 or --vk.\n");
@@ -204,6 +354,34 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false;
     }
 
+    if (g_options.batchFileName && g_options.server)
+    {
+        fprintf(stderr, "Options --batch and --server cannot be used at the same time.\n");
+        return false;
+    }
+
+    // With --batch or --server, the inputs come from the jobs. The remaining arguments are validated
+    // together with the arguments of each job, see RunBatch(...) and RunServer(...)
+    if (g_options.server)
+        return true;
+
+    if (g_options.batchFileName)
+    {
+        if (!fs::exists(g_options.batchFileName))
+        {
+            fprintf(stderr, "Batch file '%s' does not exist.\n", g_options.batchFileName);
+            return false;
+        }
+
+        return true;
+    }
+
+    if (g_options.savePackageFileName)
+    {
+        fprintf(stderr, "Option --savePackage requires --batch.\n");
+        return false;
+    }
+
     if (g_options.loadManifestFileName && g_options.readManifestFromStdin)
     {
         fprintf(stderr, "Options --loadManifest and --readManifestFromStdin cannot be used at the same time.\n");
@@ -277,7 +455,7 @@ bool ProcessCommandLine(int argc, const char** argv)
                 UpdateToolInputType(g_options.inputType, ToolInputType::CompressedTextureSet);
                 g_options.loadCompressedFileName = arg;
             }
-            else if (IsSupportedImageFileExtension(extension))
+            else if (IsSupportedImageFileExtension(extension) || IsDDSFileExtension(extension))
             {
                 UpdateToolInputType(g_options.inputType, ToolInputType::Images);
                 g_options.loadImagesList.push_back(arg);
@@ -359,6 +537,73 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false;
     }
 
+    if (rectString || g_options.decompressionMip >= 0)
+    {
+        if (g_options.inputType != ToolInputType::CompressedTextureSet || !useGapi || !g_options.decompress)
+        {
+            fprintf(stderr, "Options --rect and --mip require --loadCompressed, --decompress or --saveImages, "
+                "and either --vk or --dx12.\n");
+            return false;
+        }
+
+        if (g_options.optimizeBC || g_options.saveCompressedFileName || g_options.saveMips)
+        {
+            fprintf(stderr, "Options --rect and --mip cannot be used with --optimizeBC, --saveCompressed or --saveMips.\n");
+            return false;
+        }
+    }
+
+    if (rectString)
+    {
+        ntc::Rect rect;
+        if (sscanf(rectString, "%d,%d,%d,%d", &rect.left, &rect.top, &rect.width, &rect.height) != 4)
+        {
+            fprintf(stderr, "Invalid format for --rect '%s', must be 'X,Y,W,H' where X, Y, W and H are integers.\n",
+                rectString);
+            return false;
+        }
+
+        if (rect.left < 0 || rect.top < 0 || rect.width <= 0 || rect.height <= 0)
+        {
+            fprintf(stderr, "Invalid values specified in --rect (%d,%d,%d,%d), the offset must be 0 or more "
+                "and the size must be 1x1 or more.\n", rect.left, rect.top, rect.width, rect.height);
+            return false;
+        }
+
+        g_options.decompressionRect = rect;
+    }
+
+    if (g_options.cacheDirectory && (!g_options.compress || !g_options.saveCompressedFileName))
+    {
+        fprintf(stderr, "The --cacheDir option requires --compress and --saveCompressed.\n");
+        return false;
+    }
+
+    if (g_options.imageMemoryLimit < 0 || g_options.imageThreads < 0)
+    {
+        fprintf(stderr, "The --imageMemoryLimit and --imageThreads values must be 0 or more.\n");
+        return false;
+    }
+
+    if (g_options.cacheMaxSize < 0)
+    {
+        fprintf(stderr, "The --cacheMaxSize value (%d) must be 0 or more.\n", g_options.cacheMaxSize);
+        return false;
+    }
+
+    if (g_options.convergenceWindow < 0)
+    {
+        fprintf(stderr, "The --convergenceWindow value (%d) must be 0 or more.\n", g_options.convergenceWindow);
+        return false;
+    }
+
+    if (g_options.convergenceTargetMargin < 0.f)
+    {
+        fprintf(stderr, "The --convergenceTargetMargin value (%f) must be 0 or more.\n",
+            g_options.convergenceTargetMargin);
+        return false;
+    }
+
     if (g_options.bcPsnrThreshold < 0.f || g_options.bcPsnrThreshold > 10.f)
     {
         fprintf(stderr, "The --bcPsnrThreshold value (%f) must be between 0 and 10.\n", g_options.bcPsnrThreshold);
@@ -377,6 +622,53 @@ bool ProcessCommandLine(int argc, const char** argv)
         return false;
     }
 
+    // Validate the BPP value here, before any images are read, instead of failing in PickLatentShape(...)
+    // after the whole texture set has been loaded
+    if (g_options.compress && !std::isnan(g_options.bitsPerPixel) &&
+        !g_options.matchBcPsnr && std::isnan(g_options.targetPsnr))
+    {
+        float selectedBpp = 0.f;
+        ntc::LatentShape latentShape;
+        if (ntc::PickLatentShape(g_options.bitsPerPixel, selectedBpp, latentShape) != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Cannot select a latent shape for %.3f bpp.\n", g_options.bitsPerPixel);
+            return false;
+        }
+    }
+
+    if (g_options.warmStartFileName)
+    {
+        if (!g_options.compress)
+        {
+            fprintf(stderr, "The --warmStart option requires --compress.\n");
+            return false;
+        }
+
+        if (g_options.matchBcPsnr || !std::isnan(g_options.targetPsnr))
+        {
+            fprintf(stderr, "The --warmStart option cannot be used with --targetPsnr or --matchBcPsnr "
+                "because the latent shape is taken from the warm start file.\n");
+            return false;
+        }
+
+        if (!fs::exists(g_options.warmStartFileName))
+        {
+            fprintf(stderr, "Warm start file '%s' does not exist.\n", g_options.warmStartFileName);
+            return false;
+        }
+
+        if (g_options.warmStartSteps < 0)
+        {
+            fprintf(stderr, "The --warmStartSteps value (%d) must be 0 or more.\n", g_options.warmStartSteps);
+            return false;
+        }
+
+        // Fine-tuning from a previous result needs a fraction of the full training schedule
+        g_options.compressionSettings.trainingSteps = (g_options.warmStartSteps > 0)
+            ? g_options.warmStartSteps
+            : std::max(g_options.compressionSettings.trainingSteps / 10, 1);
+    }
+
     if (g_options.matchBcPsnr && !useGapi)
     {
         fprintf(stderr, "The --matchBcPsnr option requires either --vk or --dx12 (where available).");
@@ -407,6 +699,32 @@ bool ProcessCommandLine(int argc, const char** argv)
         }
     }
 
+    if (weightTypeString)
+    {
+        auto parsedWeightType = ParseInferenceWeightType(weightTypeString);
+        if (parsedWeightType.has_value())
+        {
+            g_options.weightType = parsedWeightType.value();
+        }
+        else
+        {
+            fprintf(stderr, "Invalid --weightType value '%s'.\n", weightTypeString);
+            return false;
+        }
+    }
+
+    if (g_options.benchmarkWeightTypes && g_options.weightType != ntc::InferenceWeightType::Unknown)
+    {
+        fprintf(stderr, "The --benchmarkWeightTypes option requires --weightType Auto.\n");
+        return false;
+    }
+
+    if (g_options.weightTypeCacheFileName && !g_options.benchmarkWeightTypes)
+    {
+        fprintf(stderr, "The --weightTypeCache option requires --benchmarkWeightTypes.\n");
+        return false;
+    }
+
     if (dimensionsString)
     {
         int width = 0, height = 0;
@@ -477,6 +795,37 @@ bool ProcessCommandLine(int argc, const char** argv)
         }
     }
 
+    if (searchDevicesString)
+    {
+        if (!g_options.matchBcPsnr && std::isnan(g_options.targetPsnr))
+        {
+            fprintf(stderr, "The --searchDevices option requires --targetPsnr or --matchBcPsnr.\n");
+            return false;
+        }
+
+        if (!ParseDeviceList(searchDevicesString, "--searchDevices", g_options.searchDevices))
+            return false;
+    }
+
+    if (seedSearchDevicesString)
+    {
+        if (!g_options.compress)
+        {
+            fprintf(stderr, "The --seedSearchDevices option requires --compress.\n");
+            return false;
+        }
+
+        if (g_options.matchBcPsnr || !std::isnan(g_options.targetPsnr))
+        {
+            fprintf(stderr, "The --seedSearchDevices option cannot be used with --targetPsnr or --matchBcPsnr, "
+                "use --searchDevices to run the parameter search on multiple devices.\n");
+            return false;
+        }
+
+        if (!ParseDeviceList(seedSearchDevicesString, "--seedSearchDevices", g_options.seedSearchDevices))
+            return false;
+    }
+
     return true;
 }
 
@@ -489,8 +838,14 @@ bool SaveImagesFromTextureSet(ntc::IContext* context, ntc::ITextureSet* textureS
     int numTextures = textureSet->GetTextureCount();
     
     std::mutex mutex;
+    std::condition_variable saveFinished;
     bool anyErrors = false;
 
+    // Images that have been read back but not yet written, limited by --imageMemoryLimit and --imageThreads
+    size_t const memoryLimit = size_t(g_options.imageMemoryLimit) << 20;
+    size_t pendingBytes = 0;
+    int pendingSaves = 0;
+
     const int mips = g_options.saveMips ? textureSetDesc.mips : 1;
 
     for (int textureIndex = 0; textureIndex < numTextures; ++textureIndex)
@@ -551,6 +906,20 @@ bool SaveImagesFromTextureSet(ntc::IContext* context, ntc::ITextureSet* textureS
             int mipHeight = std::max(1, textureSetDesc.height >> mip);
 
             size_t const mipDataSize = size_t(mipWidth) * size_t(mipHeight) * size_t(numChannels) * bytesPerComponent;
+
+            // Wait for the previous images to be written if this one doesn't fit into the limits
+            {
+                std::unique_lock lock(mutex);
+                saveFinished.wait(lock, [&]()
+                {
+                    bool const fitsMemory = memoryLimit == 0 || pendingBytes + mipDataSize <= memoryLimit;
+                    bool const fitsTasks = g_options.imageThreads <= 0 || pendingSaves < g_options.imageThreads;
+                    return pendingSaves == 0 || fitsMemory && fitsTasks;
+                });
+                pendingBytes += mipDataSize;
+                ++pendingSaves;
+            }
+
             uint8_t* data = (uint8_t*)malloc(mipDataSize);
 
             ntc::ReadChannelsParameters params;
@@ -575,6 +944,9 @@ bool SaveImagesFromTextureSet(ntc::IContext* context, ntc::ITextureSet* textureS
                 fprintf(stderr, "Failed to read texture data for texture %d (%s) MIP %d, code = %s: %s\n",
                     textureIndex, textureName, mip, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
                 free(data);
+
+                // The save tasks that are still running reference the local variables here
+                WaitForAllTasks();
                 return false;
             }
 
@@ -594,7 +966,8 @@ bool SaveImagesFromTextureSet(ntc::IContext* context, ntc::ITextureSet* textureS
             
             outputFileName += GetContainerExtension(container);
 
-            StartAsyncTask([&mutex, container, outputFileName, mipWidth, mipHeight, numChannels, channelFormat, data, &anyErrors]()
+            StartAsyncTask([&mutex, &saveFinished, &pendingBytes, &pendingSaves, container, outputFileName, mipWidth,
+                mipHeight, numChannels, channelFormat, data, mipDataSize, &anyErrors]()
             {
                 bool success = SaveImageToContainer(container, data, mipWidth, mipHeight, numChannels, outputFileName.c_str());
                 
@@ -613,6 +986,10 @@ bool SaveImagesFromTextureSet(ntc::IContext* context, ntc::ITextureSet* textureS
                 }
 
                 free(data);
+
+                pendingBytes -= mipDataSize;
+                --pendingSaves;
+                saveFinished.notify_all();
             });
         }
     }
@@ -698,15 +1075,128 @@ void OverrideTextureBcFormat(ntc::ITextureMetadata* texture, ManifestEntry* mani
     }
 }
 
-ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool manifestIsGenerated)
+// One source image with its MIP levels
+struct SourceImageData
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int storedChannels = 0;
+    int alphaMaskChannel = -1;
+    int firstChannel = -1;
+    int manifestIndex = 0;
+    bool verticalFlip = false;
+    std::string channelSwizzle;
+    std::array<stbi_uc*, NTC_MAX_MIPS> data {};
+    std::array<std::string, NTC_MAX_MIPS> fileNames; // Used to decode the MIPs that were not loaded in advance
+    std::string name;
+    ntc::ChannelFormat channelFormat = ntc::ChannelFormat::UNORM8;
+    ntc::BlockCompressedFormat bcFormat = ntc::BlockCompressedFormat::None;
+    bool isSRGB = false;
+    std::vector<float> lossFunctionScales;
+
+    // Set when the image is a DDS file with BCn blocks, which is decoded on the GPU, see DecodeDDSImage(...)
+    ntc::BlockCompressedFormat sourceBcFormat = ntc::BlockCompressedFormat::None;
+    size_t ddsDataOffset = 0;
+    std::optional<bool> ddsIsSRGB; // See ImageFileInfo::isSRGB
+
+    SourceImageData()
+    { }
+
+    SourceImageData(SourceImageData& other) = delete;
+    SourceImageData(SourceImageData&& other) = delete;
+
+    ~SourceImageData()
+    {
+        for (auto mipLevel : data)
+        {
+            if (mipLevel)
+                stbi_image_free((void*)mipLevel);
+        }
+        data.fill(nullptr);
+    }
+};
+
+// Images loaded from files for one texture set, before the texture set is created
+struct SourceImages
+{
+    std::vector<std::shared_ptr<SourceImageData>> images;
+    int width = 0;
+    int height = 0;
+    int mips = 1;
+};
+
+// The manifest and images for one texture set, as specified by the input options
+struct InputImages
+{
+    Manifest manifest;
+    bool manifestIsGenerated = false;
+    SourceImages sourceImages;
+};
+
+// Reads an image file into an RGBA buffer with 8-bit, 16-bit or 32-bit float components, which must be released
+// with stbi_image_free. When 'headerOnly' is true, only the dimensions and format are read with ProbeImageFile(...)
+// and 'outData' stays null.
+static bool ReadImageFile(std::string const& fileName, bool headerOnly, stbi_uc*& outData,
+    int& outWidth, int& outHeight, int& outChannels, ntc::ChannelFormat& outFormat)
+{
+    outData = nullptr;
+
+    if (headerOnly)
+    {
+        ImageFileInfo info;
+        if (!ProbeImageFile(fileName, info))
+            return false;
+
+        outWidth = info.width;
+        outHeight = info.height;
+        outChannels = info.channels;
+        outFormat = info.format;
+        return true;
+    }
+
+    std::string extension = fs::path(fileName).extension().generic_string();
+    LowercaseString(extension);
+
+    if (extension == ".exr")
+    {
+        outChannels = 4;
+        outFormat = ntc::ChannelFormat::FLOAT32;
+
+        LoadEXR((float**)&outData, &outWidth, &outHeight, fileName.c_str(), nullptr);
+        return outData != nullptr;
+    }
+
+    FILE* imageFile = fopen(fileName.c_str(), "rb");
+    if (!imageFile)
+        return false;
+
+    bool const is16bit = stbi_is_16_bit_from_file(imageFile);
+    fseek(imageFile, 0, SEEK_SET);
+    outFormat = is16bit ? ntc::ChannelFormat::UNORM16 : ntc::ChannelFormat::UNORM8;
+
+    if (is16bit)
+        outData = (stbi_uc*)stbi_load_from_file_16(imageFile, &outWidth, &outHeight, &outChannels, STBI_rgb_alpha);
+    else
+        outData = stbi_load_from_file(imageFile, &outWidth, &outHeight, &outChannels, STBI_rgb_alpha);
+
+    fclose(imageFile);
+    return outData != nullptr;
+}
+
+// Loads the images listed in the manifest. Doesn't use the NTC context or g_options, so it can run
+// on a separate thread while another texture set is being processed, see RunBatch(...)
+// The headers of all images are read first, and the manifest is validated against them before any pixels
+// are decoded, so that a broken texture set is rejected without spending time and memory on decoding it.
+// When 'headersOnly' is true, the pixels are decoded later while uploading them into the texture set,
+// see CreateTextureSetFromImages(...) - BCn DDS images are always decoded there. When 'loadMips' is true,
+// the MIP levels stored in DDS files are used.
+static bool ReadSourceImages(Manifest& manifest, bool manifestIsGenerated, char const* loadImagesPath,
+    bool headersOnly, bool loadMips, SourceImages& outImages)
 {
     ntc::TextureSetDesc textureSetDesc{};
     textureSetDesc.mips = 1;
 
-    ntc::LatentShape latentShape;
-    if (!PickLatentShape(latentShape))
-        return nullptr;
-
     // Count the number of MIP 0 images in the manifest
     int numMipZeroImages = 0;
     for (auto const& entry : manifest.textures)
@@ -717,7 +1207,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
 
     if (numMipZeroImages > NTC_MAX_CHANNELS)
     {
-        if (g_options.loadImagesPath)
+        if (loadImagesPath)
         {
             fprintf(stderr, "Too many images (%d) found in the input folder. At most %d channels are supported.\n"
                 "Note: when loading images from a folder, a single material with all images is created. "
@@ -730,44 +1220,9 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
             fprintf(stderr, "Too many images (%d) specified in the manifest. At most %d channels are supported.\n",
                 int(manifest.textures.size()), NTC_MAX_CHANNELS);
         }
-        return nullptr;
+        return false;
     }
 
-    struct SourceImageData
-    {
-        int width = 0;
-        int height = 0;
-        int channels = 0;
-        int storedChannels = 0;
-        int alphaMaskChannel = -1;
-        int firstChannel = -1;
-        int manifestIndex = 0;
-        bool verticalFlip = false;
-        std::string channelSwizzle;
-        std::array<stbi_uc*, NTC_MAX_MIPS> data {};
-        std::string name;
-        ntc::ChannelFormat channelFormat = ntc::ChannelFormat::UNORM8;
-        ntc::BlockCompressedFormat bcFormat = ntc::BlockCompressedFormat::None;
-        bool isSRGB = false;
-        std::vector<float> lossFunctionScales;
-
-        SourceImageData()
-        { }
-
-        SourceImageData(SourceImageData& other) = delete;
-        SourceImageData(SourceImageData&& other) = delete;
-
-        ~SourceImageData()
-        {
-            for (auto mipLevel : data)
-            {
-                if (mipLevel)
-                    stbi_image_free((void*)mipLevel);
-            }
-            data.fill(nullptr);
-        }
-    };
-
     std::vector<std::shared_ptr<SourceImageData>> images;
     
     std::mutex mutex;
@@ -782,47 +1237,24 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
         if (entry.mipLevel > 0)
             continue;
 
-        StartAsyncTask([&mutex, &images, entry, entryIndex, &textureSetDesc, &anyErrors]()
+        StartAsyncTask([&mutex, &images, entry, entryIndex, loadMips, &textureSetDesc, &anyErrors]()
         {
             std::shared_ptr<SourceImageData> image = std::make_shared<SourceImageData>();
 
             fs::path const fileName = entry.fileName;
-            std::string extension = fileName.extension().generic_string();
-            LowercaseString(extension);
-
-            if (extension == ".exr")
-            {
-                LoadEXR((float**)&image->data[0], &image->width, &image->height, entry.fileName.c_str(), nullptr);
-                image->channels = 4;
-                image->channelFormat = ntc::ChannelFormat::FLOAT32;
-            }
-            else
-            {
-                FILE* imageFile = fopen(entry.fileName.c_str(), "rb");
-                if (imageFile)
-                {
-                    bool is16bit = stbi_is_16_bit_from_file(imageFile);
-                    fseek(imageFile, 0, SEEK_SET);
-
-                    if (is16bit)
-                    {
-                        image->data[0] = (stbi_uc*)stbi_load_from_file_16(imageFile, &image->width, &image->height, &image->channels, STBI_rgb_alpha);
-                        image->channelFormat = ntc::ChannelFormat::UNORM16;
-                    }
-                    else
-                    {
-                        image->data[0] = stbi_load_from_file(imageFile, &image->width, &image->height, &image->channels, STBI_rgb_alpha);
-                        image->channelFormat = ntc::ChannelFormat::UNORM8;
-                    }
+            image->fileNames[0] = entry.fileName;
 
-                    fclose(imageFile);
-                }
-            }
+            ImageFileInfo info;
+            bool const success = ProbeImageFile(entry.fileName, info);
+            image->width = info.width;
+            image->height = info.height;
+            image->channels = info.channels;
+            image->channelFormat = info.format;
 
             // The rest of this function is interlocked with other threads
             std::lock_guard lockGuard(mutex);
 
-            if (!image->data[0])
+            if (!success)
             {
                 fprintf(stderr, "Failed to read image '%s'.\n", entry.fileName.c_str());
                 anyErrors = true;
@@ -856,8 +1288,26 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
                 return;
             }
             
-            printf("Loaded image '%s': %dx%d pixels, %d channels.\n", fileName.filename().generic_string().c_str(),
-                image->width, image->height, image->channels);
+            if (info.bcFormat != ntc::BlockCompressedFormat::None)
+            {
+                image->sourceBcFormat = info.bcFormat;
+                image->ddsDataOffset = info.dataOffset;
+                image->ddsIsSRGB = info.isSRGB;
+
+                int const mips = loadMips ? std::min(info.mips, NTC_MAX_MIPS) : 1;
+                for (int mipLevel = 1; mipLevel < mips; ++mipLevel)
+                    image->fileNames[mipLevel] = entry.fileName;
+                textureSetDesc.mips = std::max(textureSetDesc.mips, mips);
+
+                printf("Found image '%s': %dx%d pixels, %d channels, %s with %d MIP levels.\n",
+                    fileName.filename().generic_string().c_str(), image->width, image->height, image->channels,
+                    ntc::BlockCompressedFormatToString(info.bcFormat), info.mips);
+            }
+            else
+            {
+                printf("Found image '%s': %dx%d pixels, %d channels.\n", fileName.filename().generic_string().c_str(),
+                    image->width, image->height, image->channels);
+            }
 
             image->channelSwizzle = entry.channelSwizzle;
             if (image->channelSwizzle.empty())
@@ -888,7 +1338,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
     if (images.empty())
     {
         fprintf(stderr, "No images loaded, exiting.\n");
-        return nullptr;
+        return false;
     }
 
     // Validate the names of images if there are multiple channels.
@@ -912,7 +1362,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
 
     if (anyErrors)
     {
-        return nullptr;
+        return false;
     }
     
     // Auto-generate the semantics and sRGB flags after loading the images: this needs per-image channel counts
@@ -927,6 +1377,10 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
 
             GuessImageSemantics(image->name, image->channels, image->channelFormat, image->manifestIndex,
                 image->isSRGB, semantics);
+
+            // The DDS format is more reliable than the guess
+            if (image->ddsIsSRGB.has_value())
+                image->isSRGB = *image->ddsIsSRGB;
             
             // Copy the generated semantics into the manifest in case the user requested to save the manifest
             ManifestEntry& manifestEntry = manifest.textures[image->manifestIndex];
@@ -961,54 +1415,47 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
 
         std::shared_ptr<SourceImageData> const& image = *found;
 
+        if (image->sourceBcFormat != ntc::BlockCompressedFormat::None)
+        {
+            std::lock_guard lockGuard(mutex);
+            fprintf(stderr, "Image '%s' cannot be used as MIP level %d of '%s' because that is a DDS file. "
+                "Use --loadMips to load the MIP levels stored in the DDS file instead.\n",
+                entry.fileName.c_str(), entry.mipLevel, image->fileNames[0].c_str());
+            anyErrors = true;
+            continue;
+        }
+
         textureSetDesc.mips = std::max(textureSetDesc.mips, entry.mipLevel + 1);
 
         StartAsyncTask([&mutex, &image, entry, &anyErrors]()
         {
             const fs::path fileName = entry.fileName;
-            std::string extension = fileName.extension().generic_string();
-            LowercaseString(extension);
+            image->fileNames[entry.mipLevel] = entry.fileName;
 
-            int width = 0, height = 0;
-            ntc::ChannelFormat format = ntc::ChannelFormat::UNORM8;
-            if (extension == ".exr")
-            {
-                LoadEXR((float**)&image->data[entry.mipLevel], &width, &height, fileName.generic_string().c_str(), nullptr);
-                format = ntc::ChannelFormat::FLOAT32;
-            }
-            else
-            {
-                FILE* imageFile = fopen(entry.fileName.c_str(), "rb");
-                if (imageFile)
-                {
-                    bool is16bit = stbi_is_16_bit_from_file(imageFile);
-                    fseek(imageFile, 0, SEEK_SET);
-
-                    if (is16bit)
-                    {
-                        image->data[entry.mipLevel] = (stbi_uc*)stbi_load_from_file_16(imageFile, &width, &height, nullptr, STBI_rgb_alpha);
-                        format = ntc::ChannelFormat::UNORM16;
-                    }
-                    else
-                    {
-                        image->data[entry.mipLevel] = stbi_load_from_file(imageFile, &width, &height, nullptr, STBI_rgb_alpha);
-                        format = ntc::ChannelFormat::UNORM8;
-                    }
-
-                    fclose(imageFile);
-                }
-            }
+            ImageFileInfo info;
+            bool const success = ProbeImageFile(entry.fileName, info);
+            int const width = info.width;
+            int const height = info.height;
+            ntc::ChannelFormat const format = info.format;
 
             // The rest of this function is interlocked with other threads
             std::lock_guard lockGuard(mutex);
 
-            if (!image->data[entry.mipLevel])
+            if (!success)
             {
                 fprintf(stderr, "Failed to read image '%s'.\n", fileName.generic_string().c_str());
                 anyErrors = true;
                 return;
             }
 
+            if (info.bcFormat != ntc::BlockCompressedFormat::None)
+            {
+                fprintf(stderr, "Image '%s' is a DDS file, which can only be used as MIP level 0.\n",
+                    fileName.generic_string().c_str());
+                anyErrors = true;
+                return;
+            }
+
             if (format != image->channelFormat)
             {
                 fprintf(stderr, "Image '%s' has pixel format (%s) that differs from the base MIP's pixel format (%s).\n",
@@ -1027,7 +1474,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
                 return;
             }
 
-            printf("Loaded image '%s': %dx%d pixels.\n", fileName.filename().generic_string().c_str(),
+            printf("Found image '%s': %dx%d pixels.\n", fileName.filename().generic_string().c_str(),
                 width, height);
         });
     }
@@ -1036,9 +1483,433 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
 
     if (anyErrors)
     {
-        return nullptr;
+        return false;
+    }
+
+    // All checks that only need the headers have passed, estimate the memory needed for the decoded pixels
+    size_t decodedSize = 0;
+    for (auto const& image : images)
+    {
+        for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+        {
+            if (image->fileNames[mipLevel].empty())
+                continue;
+
+            ImageFileInfo info;
+            info.width = std::max(1, image->width >> mipLevel);
+            info.height = std::max(1, image->height >> mipLevel);
+            info.format = image->channelFormat;
+            decodedSize += info.GetDecodedSize();
+        }
+    }
+
+    if (headersOnly)
+        printf("Source images will be decoded while creating the texture set, %.1f MB in total.\n",
+            double(decodedSize) / 1048576.0);
+    else
+        printf("Decoding source images, %.1f MB in total.\n", double(decodedSize) / 1048576.0);
+
+    if (!headersOnly)
+    {
+        for (auto const& image : images)
+        {
+            // DDS images are decoded on the GPU when the texture set is created
+            if (image->sourceBcFormat != ntc::BlockCompressedFormat::None)
+                continue;
+
+            for (int mipLevel = 0; mipLevel < textureSetDesc.mips; ++mipLevel)
+            {
+                if (image->fileNames[mipLevel].empty())
+                    continue;
+
+                StartAsyncTask([&mutex, image, mipLevel, &anyErrors]()
+                {
+                    std::string const& fileName = image->fileNames[mipLevel];
+                    int width = 0, height = 0, channels = 0;
+                    ntc::ChannelFormat format = ntc::ChannelFormat::UNORM8;
+                    bool const success = ReadImageFile(fileName, /* headerOnly = */ false, image->data[mipLevel],
+                        width, height, channels, format);
+
+                    // The rest of this function is interlocked with other threads
+                    std::lock_guard lockGuard(mutex);
+
+                    if (!success)
+                    {
+                        fprintf(stderr, "Failed to read image '%s'.\n", fileName.c_str());
+                        anyErrors = true;
+                        return;
+                    }
+
+                    // The file could have changed since its header was read, or the decoder could disagree
+                    // with its own header parser - the strides used later depend on these values being right
+                    int const expectedWidth = std::max(1, image->width >> mipLevel);
+                    int const expectedHeight = std::max(1, image->height >> mipLevel);
+                    if (width != expectedWidth || height != expectedHeight || format != image->channelFormat)
+                    {
+                        fprintf(stderr, "Image '%s' decoded as %dx%d %s pixels, but its header specifies %dx%d %s.\n",
+                            fileName.c_str(), width, height, ntc::ChannelFormatToString(format),
+                            expectedWidth, expectedHeight, ntc::ChannelFormatToString(image->channelFormat));
+                        anyErrors = true;
+                        return;
+                    }
+
+                    printf("Loaded image '%s': %dx%d pixels.\n",
+                        fs::path(fileName).filename().generic_string().c_str(), width, height);
+                });
+            }
+        }
+
+        WaitForAllTasks();
+
+        if (anyErrors)
+        {
+            return false;
+        }
+    }
+
+    outImages.images = std::move(images);
+    outImages.width = textureSetDesc.width;
+    outImages.height = textureSetDesc.height;
+    outImages.mips = textureSetDesc.mips;
+
+    return true;
+}
+
+// Decodes the source image MIP levels that were not loaded by ReadSourceImages(...) when creating a texture set.
+// The MIP levels are consumed in the order they were added, and decoding runs ahead of the consumer
+// on the thread pool, limited by the size of decoded data that hasn't been released yet and by the task count.
+class StreamingImageDecoder
+{
+public:
+    StreamingImageDecoder(size_t memoryLimit, int maxTasks)
+        : m_memoryLimit(memoryLimit)
+        , m_maxTasks(maxTasks)
+    { }
+
+    ~StreamingImageDecoder()
+    {
+        std::unique_lock lock(m_mutex);
+        m_stopping = true;
+        m_condition.wait(lock, [this]() { return m_tasksInFlight == 0; });
+
+        for (Item& item : m_items)
+        {
+            if (item.data)
+                stbi_image_free(item.data);
+        }
+    }
+
+    // Adds a MIP level to decode, must be called before the first Acquire(...)
+    void Add(SourceImageData const* image, int mipLevel)
+    {
+        size_t const bytesPerComponent = ntc::GetBytesPerPixelComponent(image->channelFormat);
+
+        Item& item = m_items.emplace_back();
+        item.image = image;
+        item.mipLevel = mipLevel;
+        item.size = size_t(std::max(1, image->width >> mipLevel)) * size_t(std::max(1, image->height >> mipLevel))
+            * 4 * bytesPerComponent;
+    }
+
+    // Waits until the item with the provided index is decoded, returns its data or nullptr if decoding failed
+    stbi_uc* Acquire(size_t index)
+    {
+        std::unique_lock lock(m_mutex);
+        StartTasks();
+        m_condition.wait(lock, [this, index]() { return m_items[index].ready; });
+        return m_items[index].data;
+    }
+
+    // Frees the data of an item after it has been uploaded, which allows more items to be decoded
+    void Release(size_t index)
+    {
+        std::lock_guard lock(m_mutex);
+        Item& item = m_items[index];
+        if (item.data)
+        {
+            stbi_image_free(item.data);
+            item.data = nullptr;
+        }
+        m_bytesInFlight -= item.size;
+        StartTasks();
+    }
+
+private:
+    struct Item
+    {
+        SourceImageData const* image = nullptr;
+        int mipLevel = 0;
+        size_t size = 0;
+        stbi_uc* data = nullptr;
+        bool ready = false;
+    };
+
+    std::vector<Item> m_items;
+    size_t m_nextItem = 0;
+    size_t m_bytesInFlight = 0;
+    int m_tasksInFlight = 0;
+    size_t m_memoryLimit;
+    int m_maxTasks;
+    bool m_stopping = false;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+
+    // Starts decoding the next items that fit into the limits, must be called with m_mutex locked.
+    // One item is always allowed when nothing else is in flight, even if it's larger than the memory limit.
+    void StartTasks()
+    {
+        while (!m_stopping && m_nextItem < m_items.size())
+        {
+            Item& item = m_items[m_nextItem];
+            bool const fitsMemory = m_bytesInFlight == 0 || m_bytesInFlight + item.size <= m_memoryLimit;
+            bool const fitsTasks = m_maxTasks <= 0 || m_tasksInFlight < m_maxTasks;
+            if (!fitsMemory || !fitsTasks)
+                break;
+
+            m_bytesInFlight += item.size;
+            ++m_tasksInFlight;
+            ++m_nextItem;
+
+            StartAsyncTask([this, &item]()
+            {
+                stbi_uc* data = nullptr;
+                int width = 0, height = 0, channels = 0;
+                ntc::ChannelFormat format = ntc::ChannelFormat::UNORM8;
+                std::string const& fileName = item.image->fileNames[item.mipLevel];
+                bool success = ReadImageFile(fileName, /* headerOnly = */ false, data, width, height, channels, format);
+
+                // The file might have been modified after its header was read
+                if (success && (width != std::max(1, item.image->width >> item.mipLevel) ||
+                    height != std::max(1, item.image->height >> item.mipLevel) ||
+                    format != item.image->channelFormat))
+                {
+                    fprintf(stderr, "Image '%s' has changed while loading.\n", fileName.c_str());
+                    success = false;
+                }
+                else if (!success)
+                {
+                    fprintf(stderr, "Failed to read image '%s'.\n", fileName.c_str());
+                }
+
+                if (!success && data)
+                {
+                    stbi_image_free(data);
+                    data = nullptr;
+                }
+
+                std::lock_guard lock(m_mutex);
+                item.data = data;
+                item.ready = true;
+                --m_tasksInFlight;
+                StartTasks();
+                m_condition.notify_all();
+            });
+        }
+    }
+};
+
+// Graphics objects shared by all texture sets processed in one run
+struct GraphicsContext
+{
+    nvrhi::IDevice* device = nullptr;
+    nvrhi::ICommandList* commandList = nullptr;
+    nvrhi::ITimerQuery* timerQuery = nullptr;
+    GDeflateFeatures* gdeflateFeatures = nullptr;
+    GraphicsResourcePool* resourcePool = nullptr;
+    BlockDecompressionPass* blockDecompressionPass = nullptr;
+};
+
+// Decodes a DDS source image with BCn blocks on the GPU. When the image has no swizzle or vertical flip,
+// the decoded MIP levels are written into the texture set from a shared texture and 'outWritten' is set.
+// Otherwise the pixels are read back into 'image.data', and the caller uploads them like regular images.
+// Pixels that were read back stay in memory, so the parallel search workers can use them without a device.
+static bool DecodeDDSImage(ntc::IContext* context, GraphicsContext const* graphics, ntc::ITextureSet* textureSet,
+    SourceImageData& image, int mips, ntc::ColorSpace const srcColorSpaces[4], ntc::ColorSpace const dstColorSpaces[4],
+    bool& outWritten)
+{
+    outWritten = false;
+
+    int numMips = 0;
+    while (numMips < mips && !image.fileNames[numMips].empty())
+        ++numMips;
+
+    bool alreadyDecoded = true;
+    for (int mip = 0; mip < numMips; ++mip)
+        alreadyDecoded = alreadyDecoded && image.data[mip];
+    if (alreadyDecoded)
+        return true;
+
+    if (!graphics || !graphics->blockDecompressionPass)
+    {
+        fprintf(stderr, "Image '%s' is a block-compressed DDS file, which can only be decoded with the graphics API. "
+            "Please use --vk or --dx12 (where available).\n", image.fileNames[0].c_str());
+        return false;
+    }
+
+    nvrhi::IDevice* device = graphics->device;
+    nvrhi::ICommandList* commandList = graphics->commandList;
+
+    MappedFile file;
+    if (!file.Open(image.fileNames[0].c_str()))
+    {
+        fprintf(stderr, "Failed to read image '%s'.\n", image.fileNames[0].c_str());
+        return false;
+    }
+
+    // The parallel search and seed search workers create their texture sets from the pixels in memory
+    bool const writeFromTexture = image.channelSwizzle.empty() && !image.verticalFlip
+        && g_options.searchDevices.empty() && g_options.seedSearchDevices.empty();
+
+    BcFormatDefinition const* bcFormatDef = GetBcFormatDefinition(image.sourceBcFormat);
+    bool const isFloat = image.channelFormat == ntc::ChannelFormat::FLOAT32;
+
+    auto textureDesc = nvrhi::TextureDesc()
+        .setDebugName(image.name)
+        .setFormat(isFloat ? nvrhi::Format::RGBA32_FLOAT : nvrhi::Format::RGBA8_UNORM)
+        .setWidth(image.width)
+        .setHeight(image.height)
+        .setMipLevels(numMips)
+        .setDimension(nvrhi::TextureDimension::Texture2D)
+        .setIsUAV(true)
+        .setSharedResourceFlags(writeFromTexture ? nvrhi::SharedResourceFlags::Shared : nvrhi::SharedResourceFlags::None)
+        .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+        .setKeepInitialState(true);
+
+    nvrhi::TextureHandle texture = device->createTexture(textureDesc);
+    if (!texture)
+        return false;
+
+    nvrhi::StagingTextureHandle stagingTexture;
+    if (!writeFromTexture)
+    {
+        textureDesc
+            .setSharedResourceFlags(nvrhi::SharedResourceFlags::None)
+            .setInitialState(nvrhi::ResourceStates::CopyDest);
+
+        stagingTexture = device->createStagingTexture(textureDesc, nvrhi::CpuAccessMode::Read);
+        if (!stagingTexture)
+            return false;
+    }
+
+    commandList->open();
+    size_t offset = image.ddsDataOffset;
+    for (int mip = 0; mip < numMips; ++mip)
+    {
+        int const mipWidth = std::max(1, image.width >> mip);
+        int const mipHeight = std::max(1, image.height >> mip);
+        size_t const mipSize = GetBlockCompressedMipSize(image.sourceBcFormat, mipWidth, mipHeight);
+
+        // The file could have changed since its header was read
+        if (offset + mipSize > file.GetSize())
+        {
+            fprintf(stderr, "Image '%s' has changed while loading.\n", image.fileNames[0].c_str());
+            commandList->close();
+            return false;
+        }
+
+        if (!graphics->blockDecompressionPass->Decode(commandList, file.GetData() + offset, bcFormatDef->nvrhiFormat,
+            bcFormatDef->bytesPerBlock, mipWidth, mipHeight, texture, mip))
+        {
+            fprintf(stderr, "Failed to decode image '%s' MIP level %d.\n", image.fileNames[0].c_str(), mip);
+            commandList->close();
+            return false;
+        }
+
+        if (stagingTexture)
+        {
+            auto const slice = nvrhi::TextureSlice().setMipLevel(mip);
+            commandList->copyTexture(stagingTexture, slice, texture, slice);
+        }
+
+        offset += mipSize;
+    }
+    commandList->close();
+    device->executeCommandList(commandList);
+    device->waitForIdle();
+
+    if (writeFromTexture)
+    {
+        ntc::SharedTextureWrapper sharedTexture(context);
+        if (!RegisterSharedGraphicsTexture(context, device, texture,
+            isFloat ? ntc::ChannelFormat::FLOAT32 : ntc::ChannelFormat::UNORM8, sharedTexture))
+            return false;
+
+        for (int mip = 0; mip < numMips; ++mip)
+        {
+            ntc::WriteChannelsFromTextureParameters params;
+            params.mipLevel = mip;
+            params.firstChannel = image.firstChannel;
+            params.numChannels = image.channels;
+            params.texture = sharedTexture;
+            params.textureMipLevel = mip;
+            params.srcRgbColorSpace = srcColorSpaces[0];
+            params.srcAlphaColorSpace = srcColorSpaces[3];
+            params.dstRgbColorSpace = dstColorSpaces[0];
+            params.dstAlphaColorSpace = dstColorSpaces[3];
+
+            ntc::Status const ntcStatus = textureSet->WriteChannelsFromTexture(params);
+            if (ntcStatus != ntc::Status::Ok)
+            {
+                fprintf(stderr, "Failed to upload texture data for image '%s' MIP %d, code = %s\n%s\n",
+                    image.name.c_str(), mip, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+                return false;
+            }
+        }
+
+        outWritten = true;
+        return true;
+    }
+
+    size_t const bytesPerPixel = nvrhi::getFormatInfo(textureDesc.format).bytesPerBlock;
+    for (int mip = 0; mip < numMips; ++mip)
+    {
+        auto const slice = nvrhi::TextureSlice().setMipLevel(mip);
+        size_t rowPitch = 0;
+        uint8_t const* mappedTexture = static_cast<uint8_t const*>(device->mapStagingTexture(stagingTexture,
+            slice, nvrhi::CpuAccessMode::Read, &rowPitch));
+        if (!mappedTexture)
+        {
+            fprintf(stderr, "Failed to map the decoded image '%s' MIP level %d.\n", image.name.c_str(), mip);
+            return false;
+        }
+
+        size_t const mipWidth = std::max(1, image.width >> mip);
+        size_t const mipHeight = std::max(1, image.height >> mip);
+        size_t const dstRowPitch = bytesPerPixel * mipWidth;
+
+        // Allocated with malloc to be released with stbi_image_free, like the images decoded on the CPU
+        stbi_uc* data = static_cast<stbi_uc*>(malloc(dstRowPitch * mipHeight));
+        for (size_t row = 0; row < mipHeight; ++row)
+            memcpy(data + dstRowPitch * row, mappedTexture + rowPitch * row, dstRowPitch);
+
+        device->unmapStagingTexture(stagingTexture);
+
+        if (image.data[mip])
+            stbi_image_free(image.data[mip]);
+        image.data[mip] = data;
     }
 
+    return true;
+}
+
+// Creates a texture set from the loaded images, using the settings from g_options.
+// 'graphics' is only used to decode DDS images and can be null when there are none.
+ntc::ITextureSet* CreateTextureSetFromImages(ntc::IContext* context, GraphicsContext const* graphics,
+    Manifest& manifest, SourceImages& sourceImages)
+{
+    ntc::LatentShape latentShape;
+    if (!PickLatentShape(latentShape))
+        return nullptr;
+
+    std::vector<std::shared_ptr<SourceImageData>>& images = sourceImages.images;
+
+    ntc::TextureSetDesc textureSetDesc{};
+    textureSetDesc.width = sourceImages.width;
+    textureSetDesc.height = sourceImages.height;
+    textureSetDesc.mips = sourceImages.mips;
+
+    bool anyErrors = false;
+
     // Remember the max size of the input textures to create a staging buffer of sufficient size.
 
     ntc::TextureSetFeatures textureSetFeatures;
@@ -1077,7 +1948,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
         {
             for (int mip = 0; mip < textureSetDesc.mips; ++mip)
             {
-                if (!image->data[mip])
+                if (!image->data[mip] && image->fileNames[mip].empty())
                 {
                     fprintf(stderr, "Channel '%s' doesn't have an image for MIP level %d.\n",
                         image->name.c_str(), mip);
@@ -1202,8 +2073,23 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
         return nullptr;
     }
     
-    // Upload the image data into the texture set
+    // Upload the image data into the texture set.
+    // The MIP levels that were not loaded in advance are decoded here, and their data is released after upload.
+
+    StreamingImageDecoder decoder(size_t(g_options.imageMemoryLimit) << 20, g_options.imageThreads);
+    for (std::shared_ptr<SourceImageData> const& image : images)
+    {
+        if (image->sourceBcFormat != ntc::BlockCompressedFormat::None)
+            continue;
+
+        for (int mip = 0; mip < textureSetDesc.mips; ++mip)
+        {
+            if (!image->data[mip] && !image->fileNames[mip].empty())
+                decoder.Add(image.get(), mip);
+        }
+    }
 
+    size_t decoderIndex = 0;
     int alphaMaskChannel = -1;
     for (std::shared_ptr<SourceImageData> const& image : images)
     {
@@ -1216,9 +2102,31 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
         ntc::ColorSpace const srcColorSpaces[4] = { srcRgbColorSpace, srcRgbColorSpace, srcRgbColorSpace, srcAlphaColorSpace };
         ntc::ColorSpace const dstColorSpaces[4] = { dstRgbColorSpace, dstRgbColorSpace, dstRgbColorSpace, dstAlphaColorSpace };
 
+        bool const isDDS = image->sourceBcFormat != ntc::BlockCompressedFormat::None;
+        if (isDDS)
+        {
+            bool written = false;
+            if (!DecodeDDSImage(context, graphics, textureSet, *image, textureSetDesc.mips,
+                srcColorSpaces, dstColorSpaces, written))
+                return nullptr;
+
+            if (written && image->alphaMaskChannel >= 0)
+                alphaMaskChannel = image->alphaMaskChannel + image->firstChannel;
+        }
+
         for (int mip = 0; mip < textureSetDesc.mips; ++mip)
         {
-            if (!image->data[mip])
+            stbi_uc* mipData = image->data[mip];
+            std::optional<size_t> decodedItem;
+            if (!mipData && !image->fileNames[mip].empty() && !isDDS)
+            {
+                decodedItem = decoderIndex++;
+                mipData = decoder.Acquire(*decodedItem);
+                if (!mipData)
+                    return nullptr;
+            }
+
+            if (!mipData)
                 continue;
 
             int mipWidth = std::max(1, image->width >> mip);
@@ -1239,7 +2147,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
                 // No swizzle - write all channels at once
                 params.firstChannel = image->firstChannel;
                 params.numChannels = image->channels;
-                params.pData = image->data[mip];
+                params.pData = mipData;
                 params.srcColorSpaces = srcColorSpaces;
                 params.dstColorSpaces = dstColorSpaces;
 
@@ -1278,7 +2186,7 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
                     // Write one channel
                     params.firstChannel = image->firstChannel + dstChannelOffset;
                     params.numChannels = 1;
-                    params.pData = image->data[mip] + srcChannelOffset * bytesPerComponent;
+                    params.pData = mipData + srcChannelOffset * bytesPerComponent;
                     params.srcColorSpaces = srcColorSpaces + srcChannelOffset;
                     params.dstColorSpaces = dstColorSpaces + dstChannelOffset;
                     
@@ -1303,6 +2211,9 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
                     ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
                 return nullptr;
             }
+
+            if (decodedItem.has_value())
+                decoder.Release(*decodedItem);
         }
         
         ntc::ITextureMetadata* texture = textureSet->AddTexture();
@@ -1352,108 +2263,248 @@ ntc::ITextureSet* LoadImages(ntc::IContext* context, Manifest& manifest, bool ma
     return rawTextureSet;
 }
 
-bool CompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, float* outFinalPsnr)
+// Data from the --warmStart file, see LoadWarmStartData(...)
+struct WarmStartData
 {
-    ntc::Status ntcStatus = textureSet->BeginCompression(g_options.compressionSettings);
-    CHECK_NTC_RESULT(BeginCompression);
+    std::vector<uint8_t> compressedData;
 
-    ntc::CompressionStats stats;
-    do
-    {
-        ntcStatus = textureSet->RunCompressionSteps(&stats);
-        if (ntcStatus == ntc::Status::Incomplete || ntcStatus == ntc::Status::Ok)
-        {
-            printf("Training: %d steps, %.4f ms/step, intermediate PSNR: %.2f dB\r", stats.currentStep,
-                stats.millisecondsPerStep, ntc::LossToPSNR(stats.loss));
-            fflush(stdout);
-        }
-    } while (ntcStatus == ntc::Status::Incomplete);
-    CHECK_NTC_RESULT(RunCompressionSteps);
-    printf("\n");
+    // PSNR of the warm start data measured against the current source images
+    float psnr = 0.f;
+};
 
-    ntcStatus = textureSet->FinalizeCompression();
-    CHECK_NTC_RESULT(FinalizeCompression);
+// Largest drop of the intermediate PSNR after the first training iteration, relative to the warm start PSNR,
+// that is still considered a successful warm start. Training from a random initialization stays far below that.
+static const float c_WarmStartMaxPsnrDrop = 3.f;
 
-    if (outFinalPsnr)
-        *outFinalPsnr = ntc::LossToPSNR(stats.loss);
+// Optional controls for CompressTextureSet(...)
+struct TrainingControls
+{
+    bool printProgress = true;
 
-    return true;
-}
+    // When convergence detection is enabled with --convergenceWindow and the target PSNR is provided,
+    // training also stops when the intermediate PSNR reaches the target plus --convergenceTargetMargin,
+    // or when the current rate of improvement projects that the target won't be reached by the end
+    // of the step budget. If a run stopped at the target still misses it after weight quantization,
+    // it is trained again without stopping at the target.
+    float targetPsnr = NAN;
 
-struct AdaptiveSearchResult
-{
-    std::vector<uint8_t> compressedData;
-    ntc::LatentShape latentShape;
-    float bitsPerPixel = 0.f;
-    float psnr = 0.f;
+    // If provided and returns true between training iterations, the compression is aborted.
+    std::function<bool()> shouldAbort;
+
+    // If provided, replaces the random seed from g_options.compressionSettings.
+    std::optional<int> randomSeed;
+
+    // If provided, the latents and weights are loaded from this data after BeginCompression initializes them.
+    WarmStartData const* warmStart = nullptr;
 };
 
-bool CompressTextureSetWithTargetPSNR(ntc::IContext* context, ntc::ITextureSet* textureSet)
+// Tracks the intermediate PSNR over the last --convergenceWindow training steps
+// to decide when continuing the training is not useful anymore.
+class ConvergenceMonitor
 {
-    ntc::Status ntcStatus;
+public:
+    ConvergenceMonitor(int windowSteps, float threshold, float targetPsnr, float targetMargin, int totalSteps)
+        : m_windowSteps(windowSteps)
+        , m_threshold(threshold)
+        , m_targetPsnr(targetPsnr)
+        , m_targetMargin(targetMargin)
+        , m_totalSteps(totalSteps)
+    { }
+
+    // Adds a sample and returns the reason to stop training, or nullptr to continue.
+    char const* Update(int step, float psnr)
+    {
+        if (m_windowSteps <= 0)
+            return nullptr;
 
-    ntc::AdaptiveCompressionSessionWrapper session(context);
-    ntcStatus = context->CreateAdaptiveCompressionSession(session.ptr());
-    CHECK_NTC_RESULT("CreateAdaptiveCompressionSession")
+        // The intermediate PSNR is measured before the weights are quantized, so stop a bit above the target
+        if (!std::isnan(m_targetPsnr) && psnr >= m_targetPsnr + m_targetMargin)
+        {
+            m_reachedTarget = true;
+            return "reached the target PSNR";
+        }
 
-    float const targetPsnr = g_options.targetPsnr;
-    float const maxBitsPerPixel = std::isnan(g_options.maxBitsPerPixel) ? 0.f : g_options.maxBitsPerPixel;
-    ntcStatus = session->Reset(targetPsnr, maxBitsPerPixel);
-    CHECK_NTC_RESULT("Reset")
-    
-    printf("Starting search for optimal BPP to achieve %.2f dB PSNR.\n", g_options.targetPsnr);
-    
-    int experimentCount = 0;
-    std::vector<AdaptiveSearchResult> results;
+        m_samples.push_back({ step, psnr });
 
-    while (!session->Finished())
-    {
-        float bitsPerPixel;
-        ntc::LatentShape latentShape;
-        session->GetCurrentPreset(&bitsPerPixel, &latentShape);
+        // Keep the oldest sample that is at least one window old, drop the ones before it
+        while (m_samples.size() > 2 && m_samples[1].step <= step - m_windowSteps)
+            m_samples.pop_front();
 
-        printf("Experiment %d: %.2f bpp...\n", experimentCount + 1, bitsPerPixel);
+        Sample const& oldest = m_samples.front();
+        if (oldest.step > step - m_windowSteps)
+            return nullptr;
 
-        ntcStatus = textureSet->SetLatentShape(latentShape);
-        CHECK_NTC_RESULT(SetLatentShape)
+        float const gain = psnr - oldest.psnr;
+        if (gain < m_threshold)
+            return "PSNR has converged";
 
-        float psnr = NAN;
-        if (!CompressTextureSet(context, textureSet, &psnr))
-            return false;
+        if (!std::isnan(m_targetPsnr))
+        {
+            // The improvement usually slows down over time, so the linear projection is optimistic
+            float const gainPerStep = gain / float(step - oldest.step);
+            float const projectedPsnr = psnr + gainPerStep * float(std::max(m_totalSteps - step, 0));
+            if (projectedPsnr < m_targetPsnr)
+                return "the target PSNR is out of reach";
+        }
 
-        // Store the compression result
-        AdaptiveSearchResult result;
-        result.bitsPerPixel = bitsPerPixel;
-        result.latentShape = latentShape;
-        result.psnr = psnr;
+        return nullptr;
+    }
 
-        // Save the compressed data to an in-memory vector
-        size_t bufferSize = textureSet->GetOutputStreamSize();
-        result.compressedData.resize(bufferSize);
-        ntcStatus = textureSet->SaveToMemory(result.compressedData.data(), &bufferSize);
-        CHECK_NTC_RESULT(SaveToMemory)
+    // Returns true if Update has stopped the training because the intermediate PSNR reached the target.
+    bool ReachedTarget() const { return m_reachedTarget; }
 
-        // Trim the buffer to the actual size of the saved data
-        result.compressedData.resize(bufferSize);
+private:
+    struct Sample
+    {
+        int step;
+        float psnr;
+    };
 
-        results.push_back(std::move(result));
-        
-        session->Next(psnr);
-        ++experimentCount;
+    int m_windowSteps;
+    float m_threshold;
+    float m_targetPsnr;
+    float m_targetMargin;
+    int m_totalSteps;
+    bool m_reachedTarget = false;
+    std::deque<Sample> m_samples;
+};
+
+// Runs the training process on a texture set with its current latent shape.
+// 'outFinalPsnr' receives the PSNR of the finalized texture set measured through decompression.
+// If the compression is aborted through 'controls.shouldAbort', the function returns true
+// with NAN written into 'outFinalPsnr'.
+bool CompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, float* outFinalPsnr,
+    TrainingControls const& controls = TrainingControls())
+{
+    ntc::CompressionSettings settings = g_options.compressionSettings;
+    if (controls.randomSeed.has_value())
+        settings.randomSeed = *controls.randomSeed;
+
+    ntc::Status ntcStatus = textureSet->BeginCompression(settings);
+    CHECK_NTC_RESULT(BeginCompression);
+
+    if (controls.warmStart)
+    {
+        // BeginCompression initializes the latents and weights, so the warm start data goes over them
+        ntcStatus = textureSet->LoadFromMemory(controls.warmStart->compressedData.data(),
+            controls.warmStart->compressedData.size());
+        if (ntcStatus != ntc::Status::Ok)
+            textureSet->AbortCompression();
+        CHECK_NTC_RESULT(LoadFromMemory)
     }
+    bool warmStartChecked = !controls.warmStart;
 
-    // Get and validate the index of the final result
-    int finalIndex = session->GetIndexOfFinalRun();
-    if (finalIndex < 0 || finalIndex >= int(results.size()))
+    ConvergenceMonitor convergence(g_options.convergenceWindow, g_options.convergenceThreshold,
+        controls.targetPsnr, g_options.convergenceTargetMargin, g_options.compressionSettings.trainingSteps);
+    char const* stopReason = nullptr;
+
+    ntc::CompressionStats stats;
+    do
     {
-        fprintf(stderr, "Internal error: GetIndexOfFinalRun() returned %d, which is not a valid index!\n", finalIndex);
-        return false;
+        ntcStatus = textureSet->RunCompressionSteps(&stats);
+        if (controls.printProgress && (ntcStatus == ntc::Status::Incomplete || ntcStatus == ntc::Status::Ok))
+        {
+            printf("Training: %d steps, %.4f ms/step, intermediate PSNR: %.2f dB\r", stats.currentStep,
+                stats.millisecondsPerStep, ntc::LossToPSNR(stats.loss));
+            fflush(stdout);
+            g_jobReport.AddTrainingStep(stats.currentStep, stats.millisecondsPerStep, ntc::LossToPSNR(stats.loss));
+        }
+
+        if (!warmStartChecked && (ntcStatus == ntc::Status::Incomplete || ntcStatus == ntc::Status::Ok))
+        {
+            // Make sure that training continues from the warm start data instead of a fresh initialization
+            warmStartChecked = true;
+            float const psnr = ntc::LossToPSNR(stats.loss);
+            if (psnr < controls.warmStart->psnr - c_WarmStartMaxPsnrDrop)
+            {
+                if (ntcStatus == ntc::Status::Incomplete)
+                    textureSet->AbortCompression();
+                fprintf(stderr, "The warm start data was not carried over into training: the intermediate PSNR "
+                    "after %d steps is %.2f dB, while the warm start file gives %.2f dB.\n", stats.currentStep,
+                    psnr, controls.warmStart->psnr);
+                return false;
+            }
+        }
+
+        if (ntcStatus == ntc::Status::Incomplete && controls.shouldAbort && controls.shouldAbort())
+        {
+            textureSet->AbortCompression();
+            if (outFinalPsnr)
+                *outFinalPsnr = NAN;
+            return true;
+        }
+
+        if (ntcStatus == ntc::Status::Incomplete)
+            stopReason = convergence.Update(stats.currentStep, ntc::LossToPSNR(stats.loss));
+    } while (ntcStatus == ntc::Status::Incomplete && !stopReason);
+    if (ntcStatus != ntc::Status::Incomplete)
+    {
+        CHECK_NTC_RESULT(RunCompressionSteps);
+    }
+    if (controls.printProgress)
+        printf("\n");
+
+    if (stopReason)
+    {
+        printf("Training stopped after %d of %d steps: %s.\n", stats.currentStep,
+            g_options.compressionSettings.trainingSteps, stopReason);
+    }
+
+    ntcStatus = textureSet->FinalizeCompression();
+    CHECK_NTC_RESULT(FinalizeCompression);
+
+    if (outFinalPsnr)
+    {
+        // The intermediate PSNR doesn't include the weight quantization done by FinalizeCompression,
+        // so measure the final result the same way as DecompressTextureSet does
+        ntc::DecompressionStats decompressionStats;
+        ntcStatus = textureSet->Decompress(&decompressionStats, /* useInt8Weights = */ true);
+        CHECK_NTC_RESULT(Decompress);
+        *outFinalPsnr = ntc::LossToPSNR(decompressionStats.overallLoss);
+
+        // The run was cut short because it looked good enough, but the quantization took it below the target.
+        // Don't reject this configuration based on an incomplete run, train it again without stopping at the target.
+        if (convergence.ReachedTarget() && *outFinalPsnr < controls.targetPsnr)
+        {
+            printf("The final PSNR of %.2f dB is below the target after stopping early, "
+                "training again without stopping at the target.\n", *outFinalPsnr);
+
+            TrainingControls fullControls = controls;
+            fullControls.targetPsnr = NAN;
+            return CompressTextureSet(context, textureSet, outFinalPsnr, fullControls);
+        }
     }
 
-    // Find the final compresison result
-    auto const& result = results[finalIndex];
+    return true;
+}
+
+struct AdaptiveSearchResult
+{
+    std::vector<uint8_t> compressedData;
+    ntc::LatentShape latentShape;
+    float bitsPerPixel = 0.f;
+    float psnr = 0.f;
+};
+
+static bool SaveSearchResult(ntc::ITextureSet* textureSet, AdaptiveSearchResult& result)
+{
+    // Save the compressed data to an in-memory vector
+    size_t bufferSize = textureSet->GetOutputStreamSize();
+    result.compressedData.resize(bufferSize);
+    ntc::Status ntcStatus = textureSet->SaveToMemory(result.compressedData.data(), &bufferSize);
+    CHECK_NTC_RESULT(SaveToMemory)
+
+    // Trim the buffer to the actual size of the saved data
+    result.compressedData.resize(bufferSize);
 
+    return true;
+}
+
+static bool ApplySearchResult(ntc::ITextureSet* textureSet, AdaptiveSearchResult const& result, float targetPsnr)
+{
     printf("Selected compression rate: %.2f bpp, %.2f dB PSNR.\n", result.bitsPerPixel, result.psnr);
+    g_jobReport.bitsPerPixel = result.bitsPerPixel;
+    g_jobReport.overallPsnr = result.psnr;
     if (result.psnr < targetPsnr)
         printf("WARNING: Target PSNR of %.2f dB was not reached!\n", targetPsnr);
 
@@ -1462,12 +2513,303 @@ bool CompressTextureSetWithTargetPSNR(ntc::IContext* context, ntc::ITextureSet*
         return true;
 
     // Otherwise, restore the final compression result into the texture set.
-    ntcStatus = textureSet->LoadFromMemory(result.compressedData.data(), result.compressedData.size());
+    ntc::Status ntcStatus = textureSet->LoadFromMemory(result.compressedData.data(), result.compressedData.size());
     CHECK_NTC_RESULT(LoadFromMemory)
 
     return true;
 }
 
+// Bounds and round limit for the parallel search, see CompressTextureSetWithParallelSearch(...)
+static const float c_ParallelSearchMinBpp = 0.5f;
+static const float c_ParallelSearchMaxBpp = 20.f;
+static const int c_ParallelSearchMaxRounds = 4;
+
+// A separate NTC context and texture set used to evaluate search candidates or run training on one CUDA device
+struct DeviceWorker
+{
+    int cudaDevice = 0;
+    ntc::ContextWrapper context;
+    std::unique_ptr<ntc::TextureSetWrapper> textureSet;
+};
+
+// Creates a context and a copy of the texture set for every listed device. The copies are created from the same
+// source images that were used for the main texture set.
+static bool CreateDeviceWorkers(std::vector<int> const& devices, InputImages& input,
+    std::vector<DeviceWorker>& outWorkers)
+{
+    outWorkers = std::vector<DeviceWorker>(devices.size());
+    bool workersCreated = true;
+    for (size_t workerIndex = 0; workerIndex < devices.size() && workersCreated; ++workerIndex)
+    {
+        DeviceWorker& worker = outWorkers[workerIndex];
+        worker.cudaDevice = devices[workerIndex];
+
+        ntc::ContextParameters contextParams;
+        contextParams.cudaDevice = worker.cudaDevice;
+        ntc::Status ntcStatus = ntc::CreateContext(worker.context.ptr(), contextParams);
+        if (ntcStatus != ntc::Status::Ok)
+        {
+            fprintf(stderr, "Failed to create an NTC context for CUDA device %d, code = %s\n%s\n",
+                worker.cudaDevice, ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+            workersCreated = false;
+            break;
+        }
+
+        cudaSetDevice(worker.cudaDevice);
+        worker.textureSet = std::make_unique<ntc::TextureSetWrapper>(worker.context);
+        *worker.textureSet->ptr() = CreateTextureSetFromImages(worker.context, nullptr,
+            input.manifest, input.sourceImages);
+        workersCreated = !!*worker.textureSet;
+    }
+    cudaSetDevice(g_options.cudaDevice);
+
+    return workersCreated;
+}
+
+// Picks up to 'count' latent shapes with bpp values spread over the [minBpp, maxBpp] range on a log scale.
+// When 'includeEndpoints' is false, only the shapes strictly inside the range are picked.
+// Shapes that have already been evaluated are skipped.
+static void PickSearchCandidates(float minBpp, float maxBpp, bool includeEndpoints, int count,
+    std::vector<AdaptiveSearchResult> const& results, std::vector<AdaptiveSearchResult>& outCandidates)
+{
+    outCandidates.clear();
+
+    float const logMin = std::log2(minBpp);
+    float const logMax = std::log2(maxBpp);
+    int const intervals = includeEndpoints ? count - 1 : count + 1;
+
+    auto isKnownShape = [](std::vector<AdaptiveSearchResult> const& list, ntc::LatentShape const& shape)
+    {
+        return std::any_of(list.begin(), list.end(),
+            [&shape](AdaptiveSearchResult const& item) { return item.latentShape == shape; });
+    };
+
+    for (int index = 0; index < count; ++index)
+    {
+        float const t = includeEndpoints
+            ? (intervals > 0 ? float(index) / float(intervals) : 1.f)
+            : float(index + 1) / float(intervals);
+        float const requestedBpp = std::exp2(logMin + (logMax - logMin) * t);
+
+        AdaptiveSearchResult candidate;
+        if (ntc::PickLatentShape(requestedBpp, candidate.bitsPerPixel, candidate.latentShape) != ntc::Status::Ok)
+            continue;
+
+        if (!includeEndpoints && (candidate.bitsPerPixel <= minBpp || candidate.bitsPerPixel >= maxBpp))
+            continue;
+
+        if (isKnownShape(results, candidate.latentShape) || isKnownShape(outCandidates, candidate.latentShape))
+            continue;
+
+        outCandidates.push_back(std::move(candidate));
+    }
+}
+
+// Performs the search for the lowest bpp that reaches the target PSNR by compressing several latent shapes
+// at once, one per entry in g_options.searchDevices. Every search round evaluates candidates spread across
+// the range between the highest failing and the lowest passing bpp values found so far. Candidates that can
+// no longer win because a lower bpp candidate has already reached the target are aborted early.
+static bool CompressTextureSetWithParallelSearch(ntc::ITextureSet* textureSet, InputImages& input)
+{
+    float const targetPsnr = g_options.targetPsnr;
+    int const numWorkers = int(g_options.searchDevices.size());
+
+    std::vector<DeviceWorker> workers;
+    if (!CreateDeviceWorkers(g_options.searchDevices, input, workers))
+        return false;
+
+    printf("Starting search for optimal BPP to achieve %.2f dB PSNR on %d CUDA devices.\n", targetPsnr, numWorkers);
+
+    // Lowest bpp that has reached the target so far, used to abort the candidates that can't win
+    std::mutex mutex;
+    float bestPassingBpp = INFINITY;
+
+    float minBpp = c_ParallelSearchMinBpp;
+    float maxBpp = std::isnan(g_options.maxBitsPerPixel) ? c_ParallelSearchMaxBpp : g_options.maxBitsPerPixel;
+    int experimentCount = 0;
+    int bestIndex = -1;
+    std::vector<AdaptiveSearchResult> results;
+    std::vector<AdaptiveSearchResult> candidates;
+
+    for (int round = 0; round < c_ParallelSearchMaxRounds; ++round)
+    {
+        // The first round includes both ends of the range to find out if the target is reachable at all
+        PickSearchCandidates(minBpp, maxBpp, round == 0, numWorkers, results, candidates);
+        if (candidates.empty())
+            break;
+
+        for (AdaptiveSearchResult const& candidate : candidates)
+        {
+            printf("Experiment %d: %.2f bpp...\n", ++experimentCount, candidate.bitsPerPixel);
+            g_jobReport.BeginCompressionRun(candidate.bitsPerPixel);
+        }
+
+        std::vector<std::future<bool>> futures;
+        for (size_t candidateIndex = 0; candidateIndex < candidates.size(); ++candidateIndex)
+        {
+            futures.push_back(std::async(std::launch::async, [&, candidateIndex]()
+            {
+                DeviceWorker& worker = workers[candidateIndex];
+                AdaptiveSearchResult& candidate = candidates[candidateIndex];
+                ntc::ITextureSet* workerTextureSet = *worker.textureSet;
+
+                cudaSetDevice(worker.cudaDevice);
+
+                ntc::Status ntcStatus = workerTextureSet->SetLatentShape(candidate.latentShape);
+                CHECK_NTC_RESULT(SetLatentShape)
+
+                auto cannotWin = [&mutex, &bestPassingBpp, &candidate]()
+                {
+                    std::lock_guard lock(mutex);
+                    return bestPassingBpp < candidate.bitsPerPixel;
+                };
+
+                TrainingControls controls;
+                controls.printProgress = false;
+                controls.targetPsnr = targetPsnr;
+                controls.shouldAbort = cannotWin;
+
+                if (!CompressTextureSet(worker.context, workerTextureSet, &candidate.psnr, controls))
+                    return false;
+
+                if (std::isnan(candidate.psnr))
+                {
+                    printf("Experiment at %.2f bpp stopped: a lower rate has reached the target.\n",
+                        candidate.bitsPerPixel);
+                    return true;
+                }
+
+                printf("Experiment at %.2f bpp finished: %.2f dB PSNR.\n", candidate.bitsPerPixel, candidate.psnr);
+
+                if (candidate.psnr >= targetPsnr)
+                {
+                    std::lock_guard lock(mutex);
+                    bestPassingBpp = std::min(bestPassingBpp, candidate.bitsPerPixel);
+                }
+
+                return SaveSearchResult(workerTextureSet, candidate);
+            }));
+        }
+
+        bool anyErrors = false;
+        for (std::future<bool>& future : futures)
+            anyErrors |= !future.get();
+        cudaSetDevice(g_options.cudaDevice);
+
+        if (anyErrors)
+            return false;
+
+        for (AdaptiveSearchResult& candidate : candidates)
+        {
+            if (!std::isnan(candidate.psnr))
+                results.push_back(std::move(candidate));
+        }
+
+        // Narrow the range down to the interval between the highest failing and the lowest passing results
+        bestIndex = -1;
+        for (int index = 0; index < int(results.size()); ++index)
+        {
+            if (results[index].psnr >= targetPsnr &&
+                (bestIndex < 0 || results[index].bitsPerPixel < results[bestIndex].bitsPerPixel))
+                bestIndex = index;
+        }
+
+        // Even the highest allowed rate doesn't reach the target, no point in searching further
+        if (bestIndex < 0)
+            break;
+
+        maxBpp = results[bestIndex].bitsPerPixel;
+        for (AdaptiveSearchResult const& result : results)
+        {
+            if (result.psnr < targetPsnr && result.bitsPerPixel < maxBpp)
+                minBpp = std::max(minBpp, result.bitsPerPixel);
+        }
+    }
+
+    if (results.empty())
+    {
+        fprintf(stderr, "The parameter search didn't produce any results.\n");
+        return false;
+    }
+
+    // If the target was not reached, use the result with the highest PSNR
+    if (bestIndex < 0)
+    {
+        bestIndex = int(std::max_element(results.begin(), results.end(),
+            [](AdaptiveSearchResult const& a, AdaptiveSearchResult const& b) { return a.psnr < b.psnr; })
+            - results.begin());
+    }
+
+    return ApplySearchResult(textureSet, results[bestIndex], targetPsnr);
+}
+
+bool CompressTextureSetWithTargetPSNR(ntc::IContext* context, ntc::ITextureSet* textureSet, InputImages* input)
+{
+    // The parallel search needs the source images to create copies of the texture set
+    if (!g_options.searchDevices.empty() && input)
+        return CompressTextureSetWithParallelSearch(textureSet, *input);
+
+    ntc::Status ntcStatus;
+
+    ntc::AdaptiveCompressionSessionWrapper session(context);
+    ntcStatus = context->CreateAdaptiveCompressionSession(session.ptr());
+    CHECK_NTC_RESULT("CreateAdaptiveCompressionSession")
+
+    float const targetPsnr = g_options.targetPsnr;
+    float const maxBitsPerPixel = std::isnan(g_options.maxBitsPerPixel) ? 0.f : g_options.maxBitsPerPixel;
+    ntcStatus = session->Reset(targetPsnr, maxBitsPerPixel);
+    CHECK_NTC_RESULT("Reset")
+    
+    printf("Starting search for optimal BPP to achieve %.2f dB PSNR.\n", g_options.targetPsnr);
+    
+    int experimentCount = 0;
+    std::vector<AdaptiveSearchResult> results;
+
+    while (!session->Finished())
+    {
+        float bitsPerPixel;
+        ntc::LatentShape latentShape;
+        session->GetCurrentPreset(&bitsPerPixel, &latentShape);
+
+        printf("Experiment %d: %.2f bpp...\n", experimentCount + 1, bitsPerPixel);
+        g_jobReport.BeginCompressionRun(bitsPerPixel);
+
+        ntcStatus = textureSet->SetLatentShape(latentShape);
+        CHECK_NTC_RESULT(SetLatentShape)
+
+        TrainingControls controls;
+        controls.targetPsnr = targetPsnr;
+
+        float psnr = NAN;
+        if (!CompressTextureSet(context, textureSet, &psnr, controls))
+            return false;
+
+        // Store the compression result
+        AdaptiveSearchResult result;
+        result.bitsPerPixel = bitsPerPixel;
+        result.latentShape = latentShape;
+        result.psnr = psnr;
+
+        if (!SaveSearchResult(textureSet, result))
+            return false;
+
+        results.push_back(std::move(result));
+        
+        session->Next(psnr);
+        ++experimentCount;
+    }
+
+    // Get and validate the index of the final result
+    int finalIndex = session->GetIndexOfFinalRun();
+    if (finalIndex < 0 || finalIndex >= int(results.size()))
+    {
+        fprintf(stderr, "Internal error: GetIndexOfFinalRun() returned %d, which is not a valid index!\n", finalIndex);
+        return false;
+    }
+
+    return ApplySearchResult(textureSet, results[finalIndex], targetPsnr);
+}
+
 bool DecompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, bool useInt8Weights)
 {
     ntc::DecompressionStats stats;
@@ -1475,6 +2817,7 @@ bool DecompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet,
     CHECK_NTC_RESULT(Decompress);
 
     printf("CUDA decompression time: %.3f ms\n", stats.gpuTimeMilliseconds);
+    g_jobReport.decompressionTime = stats.gpuTimeMilliseconds;
 
     if (g_options.inputType == ToolInputType::Directory ||
         g_options.inputType == ToolInputType::ManifestFile ||
@@ -1482,6 +2825,7 @@ bool DecompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet,
         g_options.inputType == ToolInputType::Images)
     {
         printf("Overall PSNR (%s weights): %.2f dB\n", useInt8Weights ? "INT8" : "FP8", ntc::LossToPSNR(stats.overallLoss));
+        (useInt8Weights ? g_jobReport.overallPsnr : g_jobReport.overallPsnrFP8) = ntc::LossToPSNR(stats.overallLoss);
         
         if (!useInt8Weights)
         {
@@ -1506,6 +2850,7 @@ bool DecompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet,
                 textureMSE /= float(numChannels);
 
                 printf("  %-*s : %.2f dB [ ", int(maxNameLength), texture->GetName(), ntc::LossToPSNR(textureMSE));
+                g_jobReport.perTexturePsnr.emplace_back(texture->GetName(), ntc::LossToPSNR(textureMSE));
                 for (int ch = firstChannel; ch < firstChannel + numChannels; ++ch)
                 {
                     printf("%.2f ", ntc::LossToPSNR(stats.perChannelLoss[ch]));
@@ -1519,6 +2864,7 @@ bool DecompressTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet,
             for (int mip = 0; mip < textureSet->GetDesc().mips; ++mip)
             {
                 printf("MIP %2d  PSNR: %.2f dB\n", mip, ntc::LossToPSNR(stats.perMipLoss[mip]));
+                g_jobReport.perMipPsnr.push_back(ntc::LossToPSNR(stats.perMipLoss[mip]));
             }
         }
     }
@@ -1569,6 +2915,8 @@ bool SaveCompressedTextureSet(ntc::IContext* context, ntc::ITextureSet* textureS
 
     printf("Saved '%s'\n", g_options.saveCompressedFileName);
     printf("File size: %" PRIu64 " bytes, %.2f bits per pixel.\n", fileSize, bpp);
+    g_jobReport.savedFileSize = fileSize;
+    g_jobReport.savedFileBpp = bpp;
     if (g_options.losslessCompression.compressBCModeBuffers || g_options.losslessCompression.compressLatents)
     {
         double const compressedBufferRatioPercents = (losslessStats.originalSizeOfCompressedBuffers == 0) ? 0.0 :
@@ -1625,41 +2973,27 @@ void DescribeTextureSet(ntc::ITextureSetMetadata* textureSet)
 {
     ntc::TextureSetDesc const& desc = textureSet->GetDesc();
     printf("Dimensions: %dx%d, %d channels, %d mip level(s)\n", desc.width, desc.height, desc.channels, desc.mips);
+    g_jobReport.width = desc.width;
+    g_jobReport.height = desc.height;
+    g_jobReport.channels = desc.channels;
+    g_jobReport.mipLevels = desc.mips;
     
     ntc::LatentShape const& latentShape = textureSet->GetLatentShape();
     printf("Base compression rate: --bitsPerPixel %.3f\n", ntc::GetLatentShapeBitsPerPixel(latentShape));
+    g_jobReport.bitsPerPixel = ntc::GetLatentShapeBitsPerPixel(latentShape);
+    g_jobReport.gridSizeScale = latentShape.gridSizeScale;
+    g_jobReport.numFeatures = latentShape.numFeatures;
     printf("Latent shape: --gridSizeScale %d --numFeatures %d\n",
         latentShape.gridSizeScale, latentShape.numFeatures);
     printf("Inference weights: Int8 [%c], FP8 [%c]\n",
         textureSet->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericInt8) ? 'Y' : 'N',
         textureSet->IsInferenceWeightTypeSupported(ntc::InferenceWeightType::GenericFP8) ? 'Y' : 'N');
     
-    ntc::CompressionType latentCompression = ntc::CompressionType::None;
-    ntc::LatentTextureDesc const latentTextureDesc = textureSet->GetLatentTextureDesc();
-    int totalLatentBuffers = 0;
-    int compressedLatentBuffers = 0;
-    for (int mipLevel = 0; mipLevel < latentTextureDesc.mipLevels; ++mipLevel)
-    {
-        for (int layerIndex = 0; layerIndex < latentTextureDesc.arraySize; ++layerIndex)
-        {
-            ntc::LatentTextureFootprint footprint;
-            ntc::Status ntcStatus = textureSet->GetLatentTextureFootprint(mipLevel, layerIndex, footprint);
-
-            if (ntcStatus == ntc::Status::Ok)
-            {
-                ++totalLatentBuffers;
-                if (footprint.buffer.compressionType != ntc::CompressionType::None)
-                {
-                    latentCompression = footprint.buffer.compressionType;
-                    ++compressedLatentBuffers;
-                }
-            }
-        }
-    }
-    printf("Latent compression: %s", ntc::CompressionTypeToString(latentCompression));
-    if (latentCompression != ntc::CompressionType::None)
+    BufferCompressionStats const latentStats = GetLatentCompressionStats(textureSet);
+    printf("Latent compression: %s", ntc::CompressionTypeToString(latentStats.compressionType));
+    if (latentStats.compressionType != ntc::CompressionType::None)
     {
-        printf(" (%d/%d slices)", compressedLatentBuffers, totalLatentBuffers);
+        printf(" (%d/%d slices)", latentStats.compressedBuffers, latentStats.totalBuffers);
     }
     printf("\n");
         
@@ -1701,126 +3035,1130 @@ void DescribeTextureSet(ntc::ITextureSetMetadata* textureSet)
 
         if (texture->GetBlockCompressedFormat() == ntc::BlockCompressedFormat::BC7)
         {
-            ntc::CompressionType compression = ntc::CompressionType::None;
-            int totalModeBuffers = 0;
-            int compressedModeBuffers = 0;
-
-            for (int mipLevel = 0; mipLevel < desc.mips; ++mipLevel)
-            {
-                ntc::BufferFootprint modeBufferFootprint = texture->GetBC7ModeBufferFootprint(mipLevel);
+            BufferCompressionStats const modeBufferStats = GetBC7ModeBufferStats(texture, desc.mips);
+            int const totalModeBuffers = modeBufferStats.totalBuffers;
+            ntc::CompressionType const compression = modeBufferStats.compressionType;
 
-                if (modeBufferFootprint.rangeInStream.size != 0)
-                {
-                    ++totalModeBuffers;
+            char const* modeBufferInfo = (totalModeBuffers == 0) ? "None"
+                : (totalModeBuffers == desc.mips) ? "All MIPs"
+                : "Partial";
 
-                    if (modeBufferFootprint.compressionType != ntc::CompressionType::None)
-                    {
-                        compression = modeBufferFootprint.compressionType;
-                        ++compressedModeBuffers;
-                    }
-                }
+            printf("   BC7 acceleration data: %s", modeBufferInfo);
+            if (totalModeBuffers > 0)
+            {
+                printf(", Compression: %s", ntc::CompressionTypeToString(compression));
+                if (compression != ntc::CompressionType::None)
+                    printf(" (%d/%d buffers)", modeBufferStats.compressedBuffers, totalModeBuffers);
             }
+            printf("\n");
+        }
+    }
+}
+
+static bool ListCudaDevices()
+{
+    int count = 0;
+    cudaError_t err = cudaGetDeviceCount(&count);
+    if (err != cudaSuccess)
+    {
+        fprintf(stderr, "Call to cudaGetDeviceCount failed, error code = %s.\n", cudaGetErrorName(err));
+        return false;
+    }
+
+    if (count == 0)
+    {
+        printf("No CUDA devices available.\n");
+        return true;
+    }
+
+    for (int device = 0; device < count; ++device)
+    {
+        cudaDeviceProp prop{};
+        err = cudaGetDeviceProperties(&prop, device);
+        if (err != cudaSuccess)
+        {
+            fprintf(stderr, "Call to cudaGetDeviceProperties(%d) failed, error code = %s.\n",
+                device, cudaGetErrorName(err));
+            return false;
+        }
+
+        printf("Device %d: %s (compute capability %d.%d, %zu MB VRAM)\n", device, prop.name,
+            prop.major, prop.minor, prop.totalGlobalMem / (1024 * 1024));
+    }
+
+    return true;
+}
+
+void OverrideBcFormats(ntc::ITextureSetMetadata* textureSetMetadata)
+{
+    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    {
+        OverrideTextureBcFormat(textureSetMetadata->GetTexture(textureIndex), nullptr);
+    }
+}
+
+bool AnyBlockCompressedTextures(ntc::ITextureSetMetadata* textureSetMetadata)
+{
+    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    {
+        ntc::ITextureMetadata* textureMetadata = textureSetMetadata->GetTexture(textureIndex);
+        if (textureMetadata->GetBlockCompressedFormat() != ntc::BlockCompressedFormat::None)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Maximum estimated size of the idle textures kept in the graphics resource pool during batch processing
+static const uint64_t c_GraphicsResourcePoolMaxIdleBytes = uint64_t(2048) << 20;
+
+// Reads the manifest and loads the images for image-based inputs; does nothing for compressed texture sets.
+// Only uses the provided options, not g_options, see ReadSourceImages(...)
+static bool ReadInputImages(ToolOptions const& options, InputImages& input)
+{
+    switch (options.inputType)
+    {
+        case ToolInputType::Directory:
+            assert(options.loadImagesPath);
+            GenerateManifestFromDirectory(options.loadImagesPath, options.loadMips, options.keepFileNames,
+                /* includeDDS = */ true, input.manifest);
+            input.manifestIsGenerated = true;
+            break;
+
+        case ToolInputType::Images:
+            assert(!options.loadImagesList.empty());
+            GenerateManifestFromFileList(options.loadImagesList, options.keepFileNames, input.manifest);
+            input.manifestIsGenerated = true;
+            break;
+
+        case ToolInputType::ManifestFile: {
+            assert(options.loadManifestFileName);
+            std::string manifestError;
+            if (!ReadManifestFromFile(options.loadManifestFileName, input.manifest, manifestError))
+            {
+                fprintf(stderr, "%s\n", manifestError.c_str());
+                return false;
+            }
+            break;
+        }
+
+        case ToolInputType::ManifestStdin: {
+            std::string manifestError;
+            if (!ReadManifestFromStdin(input.manifest, manifestError))
+            {
+                fprintf(stderr, "%s\n", manifestError.c_str());
+                return false;
+            }
+            break;
+        }
+
+        case ToolInputType::CompressedTextureSet:
+            return true;
+
+        default:
+            assert(!"Unsupported input type!");
+            return false;
+    }
+
+    return ReadSourceImages(input.manifest, input.manifestIsGenerated, options.loadImagesPath,
+        /* headersOnly = */ options.imageMemoryLimit > 0, options.loadMips,
+        input.sourceImages);
+}
+
+static bool LoadTextureSet(ntc::IContext* context, GraphicsContext const* graphics, InputImages& input,
+    ntc::TextureSetWrapper& textureSet)
+{
+    PoolAllocatorPhase allocatorPhase(&g_allocator, "Load");
+
+    if (g_options.inputType == ToolInputType::CompressedTextureSet)
+    {
+        assert(g_options.loadCompressedFileName);
+
+        *textureSet.ptr() = LoadCompressedTextureSet(context);
+        
+        if (textureSet)
+        {
+            // CreateTextureSetFromImages already applies overrides to the texture set and the manifest,
+            // so process the overrides here for the case of loading a compressed texture set.
+            OverrideBcFormats(textureSet);
+        }
+    }
+    else
+    {
+        *textureSet.ptr() = CreateTextureSetFromImages(context, graphics, input.manifest, input.sourceImages);
+    }
+
+    return !!textureSet;
+}
+
+// Loads the latents and network weights from the --warmStart file into a texture set created from images
+// and measures their PSNR against the images. CompressTextureSet(...) loads 'outData' again after BeginCompression,
+// so that training fine-tunes that data instead of starting from a random initialization.
+static bool LoadWarmStartData(ntc::IContext* context, ntc::ITextureSet* textureSet, WarmStartData& outData)
+{
+    char const* fileName = g_options.warmStartFileName;
+
+    ntc::FileStreamWrapper inputFile(context);
+    ntc::Status ntcStatus = context->OpenFile(fileName, false, inputFile.ptr());
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        fprintf(stderr, "Failed to open warm start file '%s', code = %s\n%s\n", fileName,
+            ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return false;
+    }
+
+    // Validate the file before loading it, LoadFromStream would replace the texture set's layout
+    ntc::TextureSetMetadataWrapper metadata(context);
+    ntcStatus = context->CreateTextureSetMetadataFromStream(inputFile, metadata.ptr());
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        fprintf(stderr, "Failed to load warm start file '%s', code = %s\n%s\n", fileName,
+            ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return false;
+    }
+
+    ntc::TextureSetDesc const& fileDesc = metadata->GetDesc();
+    ntc::TextureSetDesc const& desc = textureSet->GetDesc();
+    if (fileDesc != desc)
+    {
+        fprintf(stderr, "Warm start file '%s' doesn't match the texture set: it is %dx%d with %d channels and "
+            "%d mip level(s), while the texture set is %dx%d with %d channels and %d mip level(s).\n", fileName,
+            fileDesc.width, fileDesc.height, fileDesc.channels, fileDesc.mips,
+            desc.width, desc.height, desc.channels, desc.mips);
+        return false;
+    }
+
+    ntc::LatentShape const latentShape = metadata->GetLatentShape();
+    if (!(latentShape == textureSet->GetLatentShape()))
+    {
+        printf("Using the latent shape from warm start file: --gridSizeScale %d --numFeatures %d\n",
+            latentShape.gridSizeScale, latentShape.numFeatures);
+    }
+
+    // The metadata has consumed a part of the stream, so open the file again to load the data
+    ntc::FileStreamWrapper dataFile(context);
+    ntcStatus = context->OpenFile(fileName, false, dataFile.ptr());
+    CHECK_NTC_RESULT(OpenFile)
+
+    ntcStatus = textureSet->LoadFromStream(dataFile);
+    CHECK_NTC_RESULT(LoadFromStream)
+
+    ntc::DecompressionStats stats;
+    ntcStatus = textureSet->Decompress(&stats, /* useInt8Weights = */ false);
+    CHECK_NTC_RESULT(Decompress)
+    outData.psnr = ntc::LossToPSNR(stats.overallLoss);
+
+    // Keep the loaded data in memory, which is also what the texture set accepts during compression
+    size_t bufferSize = textureSet->GetOutputStreamSize();
+    outData.compressedData.resize(bufferSize);
+    ntcStatus = textureSet->SaveToMemory(outData.compressedData.data(), &bufferSize);
+    CHECK_NTC_RESULT(SaveToMemory)
+    outData.compressedData.resize(bufferSize);
+
+    printf("Loaded warm start data from '%s' with %.2f dB PSNR, fine-tuning for %d steps.\n", fileName,
+        outData.psnr, g_options.compressionSettings.trainingSteps);
+
+    return true;
+}
+
+// Incremented when the set of inputs that go into the cache key changes
+static const int c_CompressionCacheKeyVersion = 1;
+
+// Builds the compression cache key from the source files, manifest and all options that affect
+// the contents of the compressed file
+static bool ComputeCompressionCacheKey(InputImages const& input, std::string& outKey)
+{
+    CacheKeyBuilder key;
+    key.AddValue(c_CompressionCacheKeyVersion);
+
+    ntc::VersionInfo const libVersion = ntc::GetLibraryVersion();
+    key.AddValue(libVersion.major);
+    key.AddValue(libVersion.minor);
+    key.AddValue(libVersion.point);
+    key.AddString(libVersion.commitHash);
+
+    for (ManifestEntry const& entry : input.manifest.textures)
+    {
+        if (!key.AddFile(entry.fileName.c_str()))
+        {
+            fprintf(stderr, "Failed to read image '%s'.\n", entry.fileName.c_str());
+            return false;
+        }
+
+        key.AddString(entry.entryName);
+        key.AddString(entry.channelSwizzle);
+        key.AddValue(entry.semantics.size());
+        for (ImageSemanticBinding const& binding : entry.semantics)
+        {
+            key.AddValue(binding.label);
+            key.AddValue(binding.firstChannel);
+        }
+        key.AddValue(entry.mipLevel);
+        key.AddValue(entry.firstChannel);
+        key.AddValue(entry.isSRGB);
+        key.AddValue(entry.verticalFlip);
+        key.AddValue(entry.bcFormat);
+        key.AddValue(entry.lossFunctionScales.size());
+        for (float scale : entry.lossFunctionScales)
+            key.AddValue(scale);
+    }
+    key.AddValue(input.manifest.width.value_or(0));
+    key.AddValue(input.manifest.height.value_or(0));
+
+    if (g_options.warmStartFileName && !key.AddFile(g_options.warmStartFileName))
+    {
+        fprintf(stderr, "Failed to read warm start file '%s'.\n", g_options.warmStartFileName);
+        return false;
+    }
+
+    key.AddValue(g_options.customWidth.value_or(0));
+    key.AddValue(g_options.customHeight.value_or(0));
+    key.AddValue(g_options.bcFormat.value_or(ntc::BlockCompressedFormat::None));
+    key.AddValue(g_options.bcFormat.has_value());
+    key.AddValue(g_options.generateMips);
+    key.AddValue(g_options.loadMips); // Selects the MIP levels stored in DDS files
+    key.AddValue(g_options.discardMaskedOutPixels);
+    key.AddValue(g_options.optimizeBC);
+    key.AddValue(g_options.bcPsnrThreshold);
+    key.AddValue(g_options.experimentalKnob);
+    key.AddValue(g_options.bitsPerPixel);
+    key.AddValue(g_options.gridSizeScale);
+    key.AddValue(g_options.numFeatures);
+    key.AddValue(g_options.targetPsnr);
+    key.AddValue(g_options.maxBitsPerPixel);
+    key.AddValue(g_options.searchDevices.size());
+    key.AddValue(g_options.seedSearchDevices.size());
+    key.AddValue(g_options.matchBcPsnr);
+    key.AddValue(g_options.minBcPsnr);
+    key.AddValue(g_options.maxBcPsnr);
+    key.AddValue(g_options.bcPsnrOffset);
+    key.AddValue(g_options.convergenceWindow);
+    key.AddValue(g_options.convergenceThreshold);
+    key.AddValue(g_options.convergenceTargetMargin);
+
+    ntc::CompressionSettings const& settings = g_options.compressionSettings;
+    key.AddValue(settings.trainingSteps);
+    key.AddValue(settings.stepsPerIteration);
+    key.AddValue(settings.kPixelsPerBatch);
+    key.AddValue(settings.gridLearningRate);
+    key.AddValue(settings.networkLearningRate);
+    key.AddValue(settings.randomSeed);
+    key.AddValue(settings.stableTraining);
+
+    ntc::LosslessCompressionSettings const& lossless = g_options.losslessCompression;
+    key.AddValue(lossless.compressBCModeBuffers);
+    key.AddValue(lossless.compressLatents);
+    key.AddValue(lossless.compressionRatioThreshold);
+    key.AddValue(lossless.compressionLevel);
+
+    outKey = key.GetKey();
+    return true;
+}
+
+// Replaces the contents of the texture set with a compression result from the cache
+static bool LoadCachedTextureSet(ntc::IContext* context, ntc::ITextureSet* textureSet, char const* fileName)
+{
+    ntc::FileStreamWrapper inputFile(context);
+    ntc::Status ntcStatus = context->OpenFile(fileName, false, inputFile.ptr());
+    if (ntcStatus != ntc::Status::Ok)
+    {
+        fprintf(stderr, "Failed to open cached file '%s', code = %s\n%s\n", fileName,
+            ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return false;
+    }
+
+    ntcStatus = textureSet->LoadFromStream(inputFile);
+    CHECK_NTC_RESULT(LoadFromStream)
+
+    return true;
+}
+
+// Copies the cached file to the --saveCompressed location instead of encoding the texture set again
+static bool SaveCachedTextureSet(ntc::ITextureSet* textureSet, char const* cachedFileName)
+{
+    std::error_code ec;
+    fs::copy_file(cachedFileName, g_options.saveCompressedFileName, fs::copy_options::overwrite_existing, ec);
+    if (ec)
+    {
+        fprintf(stderr, "Failed to copy cached file '%s' to '%s': %s\n", cachedFileName,
+            g_options.saveCompressedFileName, ec.message().c_str());
+        return false;
+    }
+
+    uint64_t const fileSize = fs::file_size(g_options.saveCompressedFileName, ec);
+    size_t const texturePixels = GetTextureSetPixelCount(textureSet);
+    float const bpp = 8.f * float(fileSize) / float(texturePixels);
+
+    printf("Saved '%s'\n", g_options.saveCompressedFileName);
+    printf("File size: %" PRIu64 " bytes, %.2f bits per pixel.\n", fileSize, bpp);
+    g_jobReport.savedFileSize = fileSize;
+    g_jobReport.savedFileBpp = bpp;
+
+    return true;
+}
+
+// Performs a best-of-N seed search: runs one training run per entry in g_options.seedSearchDevices at once,
+// each with its own context, texture set copy and random seed, and loads the result with the highest PSNR
+// into 'textureSet'. This is not data-parallel training: every run trains the whole texture set on one device,
+// so the search takes as long as a single run and only improves the quality of the result.
+static bool CompressTextureSetWithSeedSearch(ntc::ITextureSet* textureSet, InputImages& input)
+{
+    std::vector<DeviceWorker> workers;
+    if (!CreateDeviceWorkers(g_options.seedSearchDevices, input, workers))
+        return false;
+
+    int const numWorkers = int(workers.size());
+    printf("Starting a seed search with %d training runs on CUDA devices", numWorkers);
+    for (DeviceWorker const& worker : workers)
+        printf(" %d", worker.cudaDevice);
+    printf(".\n");
+
+    // A zero seed lets the library pick a random one for every run, a nonzero seed makes all runs reproducible
+    int const baseSeed = g_options.compressionSettings.randomSeed;
+
+    std::vector<AdaptiveSearchResult> results(numWorkers);
+    std::vector<std::future<bool>> futures;
+    for (int workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
+    {
+        futures.push_back(std::async(std::launch::async, [&, workerIndex]()
+        {
+            DeviceWorker& worker = workers[workerIndex];
+            AdaptiveSearchResult& result = results[workerIndex];
+            ntc::ITextureSet* workerTextureSet = *worker.textureSet;
+
+            cudaSetDevice(worker.cudaDevice);
+
+            WarmStartData warmStart;
+            if (g_options.warmStartFileName)
+            {
+                if (!LoadWarmStartData(worker.context, workerTextureSet, warmStart))
+                    return false;
+            }
+            else
+            {
+                ntc::Status ntcStatus = workerTextureSet->SetLatentShape(textureSet->GetLatentShape());
+                CHECK_NTC_RESULT(SetLatentShape)
+            }
+
+            // Only the first run reports its progress, the lines of concurrent runs would overwrite each other
+            TrainingControls controls;
+            controls.printProgress = workerIndex == 0;
+            if (baseSeed != 0)
+                controls.randomSeed = baseSeed + workerIndex;
+            if (g_options.warmStartFileName)
+                controls.warmStart = &warmStart;
+
+            if (!CompressTextureSet(worker.context, workerTextureSet, &result.psnr, controls))
+                return false;
+
+            printf("Training run %d on CUDA device %d finished: %.2f dB PSNR.\n", workerIndex + 1,
+                worker.cudaDevice, result.psnr);
+
+            return SaveSearchResult(workerTextureSet, result);
+        }));
+    }
+
+    bool anyErrors = false;
+    for (std::future<bool>& future : futures)
+        anyErrors |= !future.get();
+    cudaSetDevice(g_options.cudaDevice);
+
+    if (anyErrors)
+        return false;
+
+    int const bestIndex = int(std::max_element(results.begin(), results.end(),
+        [](AdaptiveSearchResult const& a, AdaptiveSearchResult const& b) { return a.psnr < b.psnr; })
+        - results.begin());
+
+    printf("Selected training run %d: %.2f dB PSNR.\n", bestIndex + 1, results[bestIndex].psnr);
+
+    AdaptiveSearchResult const& best = results[bestIndex];
+    ntc::Status ntcStatus = textureSet->LoadFromMemory(best.compressedData.data(), best.compressedData.size());
+    CHECK_NTC_RESULT(LoadFromMemory)
+
+    return true;
+}
+
+// Performs all requested actions on a loaded texture set
+static bool ProcessTextureSet(ntc::IContext* context, GraphicsContext const& graphics,
+    ntc::ITextureSet* textureSet, InputImages& input)
+{
+    nvrhi::IDevice* const device = graphics.device;
+    nvrhi::ICommandList* const commandList = graphics.commandList;
+    nvrhi::ITimerQuery* const timerQuery = graphics.timerQuery;
+    GDeflateFeatures* const gdeflateFeatures = graphics.gdeflateFeatures;
+
+    if (g_options.describe)
+    {
+        DescribeTextureSet(textureSet);
+    }
+
+    if (g_options.saveManifestFileName)
+    {
+        std::string manifestError;
+        if (!WriteManifestToFile(g_options.saveManifestFileName, input.manifest, manifestError))
+        {
+            fprintf(stderr, "%s\n", manifestError.c_str());
+            return false;
+        }
+        else
+        {
+            printf("Saved manifest to '%s'\n", g_options.saveManifestFileName);
+        }
+    }
+
+    textureSet->SetExperimentalKnob(g_options.experimentalKnob);
+
+    bool const anyBCTextures = AnyBlockCompressedTextures(textureSet);
+
+    if (g_options.matchBcPsnr && !anyBCTextures)
+    {
+        fprintf(stderr, "--matchBcPsnr requires that at least one texture in the set is compressed to a BCn format.\n");
+        return false;
+    }
+
+    // Look up the compression result in the cache before doing any expensive work
+    std::optional<CompressionCache> cache;
+    std::string cacheKey;
+    std::string cachedFileName;
+    if (g_options.compress && g_options.cacheDirectory)
+    {
+        if (!ComputeCompressionCacheKey(input, cacheKey))
+            return false;
+
+        cache.emplace(g_options.cacheDirectory, uint64_t(g_options.cacheMaxSize) << 20);
+        if (cache->Lookup(cacheKey, cachedFileName))
+        {
+            printf("Compression cache hit: %s\n", cacheKey.c_str());
+            g_jobReport.cacheHit = true;
+            if (!LoadCachedTextureSet(context, textureSet, cachedFileName.c_str()))
+                return false;
+        }
+        else
+        {
+            printf("Compression cache miss: %s\n", cacheKey.c_str());
+            g_jobReport.cacheHit = false;
+        }
+    }
+    bool const cacheHit = !cachedFileName.empty();
+
+    GraphicsResourcesForTextureSet graphicsResources;
+    if (g_options.matchBcPsnr || g_options.optimizeBC || g_options.saveImagesPath && anyBCTextures)
+    {
+        // Verify that we have a graphics device - cannot do that in ProcessCommandLine
+        // because we don't know if there are any BCn textures at that point...
+        if (!device)
+        {
+            fprintf(stderr, "BCn encoding requires either --vk or --dx12 (where available).\n"
+                "To save images in a non-BC format, use --bcFormat none.\n");
+            return false;
+        }
+
+        int const mipLevels = textureSet->GetDesc().mips;
+
+        if (!CreateGraphicsResourcesFromMetadata(context, device, textureSet,
+            mipLevels, /* enableCudaSharing = */ true, graphicsResources, graphics.resourcePool))
+            return false;
+    }
+
+    if (g_options.matchBcPsnr && !cacheHit)
+    {
+        if (!CopyTextureSetDataIntoGraphicsTextures(context, textureSet, ntc::TextureDataPage::Reference,
+            /* allMipLevels = */ false, /* onlyBlockCompressedFormats = */ true, graphicsResources))
+            return false;
+
+        float combinedBcBitsPerPixel = 0.f;
+        if (!ComputePsnrForBlockCompressedTextureSet(context, textureSet, device,
+            commandList, graphicsResources, g_options.targetPsnr, &combinedBcBitsPerPixel))
+            return false;
+        g_jobReport.combinedBcPsnr = g_options.targetPsnr;
+        g_jobReport.combinedBcBitsPerPixel = combinedBcBitsPerPixel;
+
+        // Apply the user-specified offset and limits
+        g_options.targetPsnr = std::min(g_options.maxBcPsnr, std::max(g_options.minBcPsnr,
+            g_options.targetPsnr + g_options.bcPsnrOffset));
+
+        printf("Selected target PSNR: %.2f dB.\n", g_options.targetPsnr);
+    }
+    
+    if (g_options.compress && !cacheHit)
+    {
+        PoolAllocatorPhase allocatorPhase(&g_allocator, "Compress");
+
+        if (std::isnan(g_options.targetPsnr) && !g_options.seedSearchDevices.empty())
+        {
+            if (!CompressTextureSetWithSeedSearch(textureSet, input))
+                return false;
+        }
+        else if (std::isnan(g_options.targetPsnr))
+        {
+            WarmStartData warmStart;
+            TrainingControls controls;
+            if (g_options.warmStartFileName)
+            {
+                if (!LoadWarmStartData(context, textureSet, warmStart))
+                    return false;
+                controls.warmStart = &warmStart;
+            }
+
+            if (!CompressTextureSet(context, textureSet, nullptr, controls))
+                return false;
+        }
+        else
+        {
+            bool const haveSourceImages = g_options.inputType != ToolInputType::CompressedTextureSet;
+            if (!CompressTextureSetWithTargetPSNR(context, textureSet, haveSourceImages ? &input : nullptr))
+                return false;
+        }
+    }
+
+    if (g_options.decompress)
+    {
+        PoolAllocatorPhase allocatorPhase(&g_allocator, "Decompress");
+
+        if (g_options.compress)
+        {
+            if (!DecompressTextureSet(context, textureSet, /* useInt8Weights = */ true))
+                return false;
+        }
+
+        if (!DecompressTextureSet(context, textureSet, /* useInt8Weights = */ false))
+            return false;
+    }
+
+    ntc::TextureDataPage const sourcePage = g_options.decompress
+        ? ntc::TextureDataPage::Output
+        : ntc::TextureDataPage::Reference;
+
+    // Without --optimizeBC, the textures are copied one at a time while the previous texture is being encoded,
+    // see BlockCompressAndSaveGraphicsTextures(...)
+    if (g_options.optimizeBC)
+    {
+        if (!CopyTextureSetDataIntoGraphicsTextures(context, textureSet, sourcePage,
+            /* allMipLevels = */ true, /* onlyBlockCompressedFormats = */ true, graphicsResources))
+            return false;
+    }
+
+    if (g_options.optimizeBC)
+    {
+        if (!OptimizeBlockCompression(context, textureSet, device,
+            commandList, g_options.bcPsnrThreshold, graphicsResources))
+            return false;
+    }
+
+    if (g_options.saveImagesPath)
+    {
+        if (anyBCTextures)
+        {
+            // After OptimizeBlockCompression, the graphics textures already contain the color data
+            std::function<bool(int)> copyTextureData;
+            if (!g_options.optimizeBC)
+            {
+                copyTextureData = [textureSet, sourcePage, &graphicsResources](int textureIndex)
+                {
+                    return CopyTextureDataIntoGraphicsTexture(textureSet, textureIndex, sourcePage,
+                        /* allMipLevels = */ true, graphicsResources);
+                };
+            }
+
+            if (!BlockCompressAndSaveGraphicsTextures(context, textureSet, nullptr,
+                device, commandList, timerQuery, gdeflateFeatures,
+                g_options.saveImagesPath, g_options.saveGDeflate, g_options.benchmarkIterations, graphicsResources,
+                copyTextureData))
+                return false;
+        }
+            
+        if (!SaveImagesFromTextureSet(context, textureSet))
+            return false;
+    }
+
+    if (g_options.saveCompressedFileName && cacheHit)
+    {
+        if (!SaveCachedTextureSet(textureSet, cachedFileName.c_str()))
+            return false;
+    }
+    else if (g_options.saveCompressedFileName)
+    {
+        PoolAllocatorPhase allocatorPhase(&g_allocator, "Save");
+
+        if (!SaveCompressedTextureSet(context, textureSet))
+            return false;
+
+        // A failure to store the result in the cache doesn't affect the output, so it's not an error
+        if (cache.has_value())
+            cache->Store(cacheKey, g_options.saveCompressedFileName);
+    }
+    else if (g_options.compress)
+    {
+        size_t estimatedSize;
+        if (ntc::EstimateCompressedTextureSetSize(textureSet->GetDesc(), textureSet->GetLatentShape(),
+            estimatedSize) == ntc::Status::Ok)
+        {
+            size_t const texturePixels = GetTextureSetPixelCount(textureSet);
+            float const bpp = 8.f * float(estimatedSize) / float(texturePixels);
+            printf("Estimated file size: %zu bytes, %.2f bits per pixel.\n", estimatedSize, bpp);
+            g_jobReport.savedFileSize = estimatedSize;
+            g_jobReport.savedFileBpp = bpp;
+        }
+    }
+
+    return true;
+}
+
+// Implements --generateManifests: scans the input folder tree on --imageThreads threads and writes the manifest
+// for each folder with images into the same relative location under --manifestDir, as <folder>.json.
+// With --saveBatch, also writes a batch file that compresses every manifest into <folder>.ntc next to it.
+static bool GenerateManifestsForDirectoryTree()
+{
+    auto readHeader = [](std::string const& fileName, ImageFileInfo& outInfo)
+    {
+        return ProbeImageFile(fileName, outInfo);
+    };
+
+    auto const startTime = std::chrono::steady_clock::now();
+
+    std::vector<DirectoryManifest> manifests;
+    std::string error;
+    if (!GenerateManifestsFromDirectoryTree(g_options.generateManifestsPath, g_options.loadMips,
+        g_options.keepFileNames, /* includeDDS = */ true, g_options.imageThreads, readHeader, manifests, error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+
+    fs::path const outputRoot = g_options.manifestDirectory;
+    std::vector<BatchJob> jobs;
+    for (DirectoryManifest const& directoryManifest : manifests)
+    {
+        fs::path const manifestFileName = (directoryManifest.relativePath == ".")
+            ? outputRoot / "manifest.json"
+            : outputRoot / (directoryManifest.relativePath + ".json");
+
+        std::error_code ec;
+        fs::create_directories(manifestFileName.parent_path(), ec);
+        if (!WriteManifestToFile(manifestFileName.generic_string().c_str(), directoryManifest.manifest, error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return false;
+        }
+
+        BatchJob& job = jobs.emplace_back();
+        job.args = { "--loadManifest", manifestFileName.generic_string(),
+            "--saveCompressed", fs::path(manifestFileName).replace_extension(".ntc").generic_string() };
+    }
+
+    if (g_options.saveBatchFileName && !jobs.empty())
+    {
+        if (!WriteBatchFile(g_options.saveBatchFileName, jobs, error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return false;
+        }
+    }
+
+    auto const endTime = std::chrono::steady_clock::now();
+    float const seconds = std::chrono::duration_cast<std::chrono::duration<float>>(endTime - startTime).count();
+    printf("Generated %zu manifests in %.1f s.\n", manifests.size(), seconds);
+    
+    return true;
+}
+
+// Describes the texture sets for --describeAll. Only the file headers and descriptors are parsed,
+// so the context is created without CUDA or a graphics device.
+static bool DescribeAllTextureSets()
+{
+    auto const startTime = std::chrono::steady_clock::now();
+
+    std::vector<fs::path> files;
+    std::string error;
+    if (!FindTextureSetFiles(g_options.describePaths, files, error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+
+    ntc::ContextParameters contextParams;
+    contextParams.pAllocator = &g_allocator;
+    contextParams.cudaDevice = ntc::DisableCudaDevice;
+
+    ntc::ContextWrapper context;
+    ntc::Status ntcStatus = ntc::CreateContext(context.ptr(), contextParams);
+    if (ntcStatus != ntc::Status::Ok && ntcStatus != ntc::Status::CudaUnavailable)
+    {
+        fprintf(stderr, "Failed to create an NTC context, code = %s: %s\n",
+            ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+        return false;
+    }
+
+    int const failedFiles = DescribeTextureSetFiles(context, files, g_options.imageThreads, stdout);
+
+    auto const endTime = std::chrono::steady_clock::now();
+    float const seconds = std::chrono::duration_cast<std::chrono::duration<float>>(endTime - startTime).count();
+    fprintf(stderr, "Described %zu texture sets in %.1f s, %d failed.\n", files.size(), seconds, failedFiles);
+
+    return failedFiles == 0;
+}
+
+// Number of timed decompression runs per weight type for --benchmarkWeightTypes
+static const int c_WeightTypeBenchmarkIterations = 5;
+
+// Picks the fastest weight type for graphics decompression with --benchmarkWeightTypes, using the timings
+// stored in the weight type cache for this adapter and driver, or running the benchmark on this texture set
+// when some of its weight types have not been measured yet. Returns Unknown if the benchmark fails.
+static ntc::InferenceWeightType SelectBenchmarkedWeightType(nvrhi::IDevice* device, nvrhi::ICommandList* commandList,
+    GDeflateFeatures* gdeflateFeatures, ntc::IContext* context, GraphicsDecompressionPass& gdp,
+    ntc::ITextureSetMetadata* metadata, ntc::IStream* inputFile)
+{
+    std::vector<ntc::InferenceWeightType> const candidates = {
+        ntc::InferenceWeightType::GenericInt8,
+        ntc::InferenceWeightType::GenericFP8,
+        ntc::InferenceWeightType::CoopVecFP8
+    };
+
+    fs::path const cachePath = g_options.weightTypeCacheFileName
+        ? fs::path(g_options.weightTypeCacheFileName)
+        : GetDefaultWeightTypeCachePath();
+
+    // Without the adapter identity, the results can't be cached but the benchmark still works
+    AdapterIdentity identity;
+    bool const identityKnown = GetAdapterIdentity(device, identity);
+    if (!identityKnown)
+        fprintf(stderr, "Cannot query the adapter and driver version, the weight type benchmark will not be cached.\n");
+
+    WeightTypeCache cache;
+    std::string error;
+    if (!cache.Load(cachePath, error))
+        fprintf(stderr, "%s\n", error.c_str());
+
+    WeightTypeTimings timings{};
+    bool const cached = identityKnown && cache.Find(identity, timings)
+        && HasTimingsForWeightTypes(timings, metadata, candidates);
+
+    if (!cached)
+    {
+        if (!gdp.SetLatentDataFromTextureSet(commandList, context, gdeflateFeatures, inputFile, metadata))
+        {
+            fprintf(stderr, "GraphicsDecompressionPass::SetLatentDataFromTextureSet failed.\n");
+            return ntc::InferenceWeightType::Unknown;
+        }
+
+        if (!BenchmarkWeightTypes(device, context, gdp, metadata, /* mipLevel = */ 0,
+            /* firstLatentMipInTexture = */ 0, candidates, c_WeightTypeBenchmarkIterations, timings))
+        {
+            fprintf(stderr, "The weight type benchmark failed.\n");
+            return ntc::InferenceWeightType::Unknown;
+        }
+
+        if (identityKnown)
+        {
+            cache.Store(identity, timings);
+            if (!cache.Save(cachePath, error))
+                fprintf(stderr, "%s\n", error.c_str());
+        }
+    }
+
+    printf("Weight type timings on %s%s:\n", identityKnown ? identity.adapterName.c_str() : "this device",
+        cached ? " (cached)" : "");
+    for (ntc::InferenceWeightType weightType : candidates)
+    {
+        if (timings[size_t(weightType)] > 0.f && metadata->IsInferenceWeightTypeSupported(weightType))
+            printf("  %s: %.3f ms\n", GetInferenceWeightTypeName(weightType), timings[size_t(weightType)] * 1e3f);
+    }
+
+    return SelectFastestWeightType(timings, metadata, candidates);
+}
+
+// Returns true if the job options select the same CUDA and graphics devices as the batch options
+static bool BatchJobUsesSameDevices(ToolOptions const& job, ToolOptions const& batch)
+{
+    return job.useVulkan == batch.useVulkan
+        && job.useDX12 == batch.useDX12
+        && job.debug == batch.debug
+        && job.adapterIndex == batch.adapterIndex
+        && job.cudaDevice == batch.cudaDevice
+        && job.enableCoopVec == batch.enableCoopVec
+        && job.enableGpuDeflate == batch.enableGpuDeflate;
+}
+
+// Returns the command line arguments that apply to every job of a --batch or --server run,
+// which are all arguments except the ones that select the mode and its outputs
+static std::vector<const char*> GetCommonJobArguments(int argc, const char** argv)
+{
+    std::vector<const char*> commonArgs;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--batch") == 0 || strcmp(argv[i], "--savePackage") == 0)
+        {
+            ++i; // Skip the file name, too
+            continue;
+        }
+        if (strncmp(argv[i], "--batch=", 8) == 0 || strncmp(argv[i], "--savePackage=", 14) == 0
+            || strcmp(argv[i], "--server") == 0)
+            continue;
+        commonArgs.push_back(argv[i]);
+    }
+    return commonArgs;
+}
+
+// Parses the options of one job into g_options: the common arguments followed by the job's arguments.
+// The options point at the strings in 'jobArgs', which must stay alive while they are used.
+// Returns false and prints an error if the options are invalid for a job.
+static bool ParseJobOptions(std::vector<const char*> const& commonArgs, std::vector<std::string> const& jobArgs,
+    ToolOptions const& processOptions)
+{
+    std::vector<const char*> args = commonArgs;
+    for (std::string const& arg : jobArgs)
+        args.push_back(arg.c_str());
+    args.push_back(nullptr); // argparse expects argv[argc] to be valid
+
+    g_options = ToolOptions();
+    if (!ProcessCommandLine(int(args.size()) - 1, args.data()))
+        return false;
+
+    if (!BatchJobUsesSameDevices(g_options, processOptions))
+    {
+        fprintf(stderr, "Device and graphics API options (--vk, --dx12, --adapter, --cudaDevice...) "
+            "cannot be specified per job, only on the command line.\n");
+        return false;
+    }
+
+    // ProcessCommandLine returns early for the options that don't need inputs, like --version or --batch
+    if (g_options.inputType == ToolInputType::None)
+    {
+        fprintf(stderr, "Jobs must specify an input.\n");
+        return false;
+    }
+
+    if (g_options.inputType == ToolInputType::ManifestStdin)
+    {
+        fprintf(stderr, "Jobs cannot read manifests from stdin.\n");
+        return false;
+    }
+
+    if (g_options.decompressionRect.has_value() || g_options.decompressionMip >= 0)
+    {
+        fprintf(stderr, "Jobs cannot use --rect or --mip, region decompression is only supported for single texture sets.\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Processes the jobs from the --batch file with the context and devices that are already created.
+// Each job's options are the batch command line (without --batch) followed by the job's arguments.
+// The images for the next job are loaded on a separate thread while the current job is processed.
+static bool RunBatch(ntc::IContext* context, GraphicsContext const& graphics, int argc, const char** argv)
+{
+    std::vector<BatchJob> jobs;
+    std::string batchError;
+    if (!ReadBatchFile(g_options.batchFileName, jobs, batchError))
+    {
+        fprintf(stderr, "%s\n", batchError.c_str());
+        return false;
+    }
+
+    ToolOptions const batchOptions = g_options;
+    std::vector<const char*> const commonArgs = GetCommonJobArguments(argc, argv);
+
+    // Parse all jobs first: the images for a job are loaded before the previous job completes,
+    // so its options must be known by then. Options point at the strings in 'jobs', which stay alive.
+    std::vector<std::optional<ToolOptions>> jobOptions(jobs.size());
+    int failedJobs = 0;
+    for (size_t jobIndex = 0; jobIndex < jobs.size(); ++jobIndex)
+    {
+        bool valid = ParseJobOptions(commonArgs, jobs[jobIndex].args, batchOptions);
+
+        if (valid && batchOptions.savePackageFileName && !g_options.saveCompressedFileName)
+        {
+            fprintf(stderr, "With --savePackage, batch jobs must save a compressed texture set (--saveCompressed).\n");
+            valid = false;
+        }
+
+        if (valid)
+        {
+            jobOptions[jobIndex] = g_options;
+        }
+        else
+        {
+            fprintf(stderr, "Skipping batch job %zu because of invalid arguments.\n", jobIndex + 1);
+            ++failedJobs;
+        }
+    }
+
+    auto findValidJob = [&jobOptions](size_t jobIndex)
+    {
+        while (jobIndex < jobOptions.size() && !jobOptions[jobIndex].has_value())
+            ++jobIndex;
+        return jobIndex;
+    };
+
+    // ReadSourceImages waits for the StartAsyncTask pool, so it can't run as one of that pool's tasks.
+    auto startReadingInput = [](ToolOptions const& options)
+    {
+        return std::async(std::launch::async, [options]()
+        {
+            std::shared_ptr<InputImages> input = std::make_shared<InputImages>();
+            if (!ReadInputImages(options, *input))
+                input.reset();
+            return input;
+        });
+    };
+
+    auto const startTime = std::chrono::steady_clock::now();
+    int completedJobs = 0;
+    std::vector<NtcPackageInput> packageInputs;
+
+    size_t jobIndex = findValidJob(0);
+    std::future<std::shared_ptr<InputImages>> nextInput;
+    if (jobIndex < jobs.size())
+        nextInput = startReadingInput(*jobOptions[jobIndex]);
+
+    while (jobIndex < jobs.size())
+    {
+        std::shared_ptr<InputImages> input = nextInput.get();
+
+        size_t const nextJobIndex = findValidJob(jobIndex + 1);
+        if (nextJobIndex < jobs.size())
+            nextInput = startReadingInput(*jobOptions[nextJobIndex]);
+
+        printf("Batch job %zu/%zu...\n", jobIndex + 1, jobs.size());
+
+        g_options = *jobOptions[jobIndex];
+
+        bool success = !!input;
+        if (success)
+        {
+            ntc::TextureSetWrapper textureSet(context);
+            success = LoadTextureSet(context, &graphics, *input, textureSet)
+                && ProcessTextureSet(context, graphics, textureSet, *input);
+        }
 
-            char const* modeBufferInfo = (totalModeBuffers == 0) ? "None"
-                : (totalModeBuffers == desc.mips) ? "All MIPs"
-                : "Partial";
+        if (graphics.device)
+        {
+            graphics.device->waitForIdle();
+            graphics.device->runGarbageCollection();
+        }
 
-            printf("   BC7 acceleration data: %s", modeBufferInfo);
-            if (totalModeBuffers > 0)
+        if (success)
+        {
+            ++completedJobs;
+            if (batchOptions.savePackageFileName)
             {
-                printf(", Compression: %s", ntc::CompressionTypeToString(compression));
-                if (compression != ntc::CompressionType::None)
-                    printf(" (%d/%d buffers)", compressedModeBuffers, totalModeBuffers);
+                NtcPackageInput& packageInput = packageInputs.emplace_back();
+                packageInput.fileName = g_options.saveCompressedFileName;
             }
-            printf("\n");
         }
-    }
-}
+        else
+        {
+            fprintf(stderr, "Batch job %zu failed.\n", jobIndex + 1);
+            ++failedJobs;
+        }
 
-static bool ListCudaDevices()
-{
-    int count = 0;
-    cudaError_t err = cudaGetDeviceCount(&count);
-    if (err != cudaSuccess)
-    {
-        fprintf(stderr, "Call to cudaGetDeviceCount failed, error code = %s.\n", cudaGetErrorName(err));
-        return false;
+        jobIndex = nextJobIndex;
     }
 
-    if (count == 0)
-    {
-        printf("No CUDA devices available.\n");
-        return true;
-    }
+    g_options = batchOptions;
 
-    for (int device = 0; device < count; ++device)
+    auto const endTime = std::chrono::steady_clock::now();
+    float const batchTimeSeconds = std::chrono::duration_cast<std::chrono::duration<float>>(endTime - startTime).count();
+    printf("Batch completed in %.1f s: %d jobs succeeded, %d failed.\n", batchTimeSeconds, completedJobs, failedJobs);
+
+    if (g_options.savePackageFileName)
     {
-        cudaDeviceProp prop{};
-        err = cudaGetDeviceProperties(&prop, device);
-        if (err != cudaSuccess)
+        // Entries are named by their paths relative to the package, which is how the renderer finds them
+        fs::path const packageDir = fs::absolute(g_options.savePackageFileName).parent_path();
+        for (NtcPackageInput& packageInput : packageInputs)
         {
-            fprintf(stderr, "Call to cudaGetDeviceProperties(%d) failed, error code = %s.\n",
-                device, cudaGetErrorName(err));
+            packageInput.name = fs::absolute(packageInput.fileName).lexically_relative(packageDir).generic_string();
+        }
+
+        std::string packageError;
+        if (!WriteNtcPackage(context, g_options.savePackageFileName, packageInputs, packageError))
+        {
+            fprintf(stderr, "%s\n", packageError.c_str());
             return false;
         }
 
-        printf("Device %d: %s (compute capability %d.%d, %zu MB VRAM)\n", device, prop.name,
-            prop.major, prop.minor, prop.totalGlobalMem / (1024 * 1024));
+        printf("Saved '%s' with %zu texture sets.\n", g_options.savePackageFileName, packageInputs.size());
     }
 
-    return true;
+    GraphicsResourcePool const* pool = graphics.resourcePool;
+    if (pool && pool->GetHits() + pool->GetMisses() > 0)
+    {
+        printf("Graphics resource pool: %d of %d textures reused, hit rate %.1f%%.\n", pool->GetHits(),
+            pool->GetHits() + pool->GetMisses(), pool->GetHitRate() * 100.f);
+    }
+
+    return failedJobs == 0;
 }
 
-void OverrideBcFormats(ntc::ITextureSetMetadata* textureSetMetadata)
+// Implements --server: processes the jobs received through stdin with the context and devices that are already created.
+// Each job is one line of JSON in the format of the batch file jobs, {"args": [...]}, and its options are
+// the server command line (without --server) followed by the job's arguments, like in RunBatch(...).
+// For each job, one line of JSON with its results is written to stdout, see WriteJobReport(...).
+// The first line is written before any jobs and only contains the device information.
+// All other messages of the tool go to stderr. The server exits when stdin is closed.
+static bool RunServer(ntc::IContext* context, GraphicsContext const& graphics, int argc, const char** argv)
 {
-    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    FILE* responseStream = SeparateResponseStreamFromStdout();
+    if (!responseStream)
     {
-        OverrideTextureBcFormat(textureSetMetadata->GetTexture(textureIndex), nullptr);
+        fprintf(stderr, "Cannot create the response stream for --server.\n");
+        return false;
     }
-}
 
-bool AnyBlockCompressedTextures(ntc::ITextureSetMetadata* textureSetMetadata)
-{
-    for (int textureIndex = 0; textureIndex < textureSetMetadata->GetTextureCount(); ++textureIndex)
+    ToolOptions const serverOptions = g_options;
+    std::vector<const char*> const commonArgs = GetCommonJobArguments(argc, argv);
+
+    WriteJobReport(responseStream, g_jobReport, true, 0.f);
+
+    std::string line;
+    while (std::getline(std::cin, line))
     {
-        ntc::ITextureMetadata* textureMetadata = textureSetMetadata->GetTexture(textureIndex);
-        if (textureMetadata->GetBlockCompressedFormat() != ntc::BlockCompressedFormat::None)
+        if (line.empty())
+            continue;
+
+        auto const startTime = std::chrono::steady_clock::now();
+        g_jobReport.ResetJobResults();
+
+        BatchJob job;
+        std::string jobError;
+        bool success = ParseBatchJob(line, job, jobError);
+        if (!success)
+            fprintf(stderr, "%s\n", jobError.c_str());
+
+        success = success && ParseJobOptions(commonArgs, job.args, serverOptions);
+
+        if (success)
         {
-            return true;
+            InputImages input;
+            ntc::TextureSetWrapper textureSet(context);
+            success = ReadInputImages(g_options, input)
+                && LoadTextureSet(context, &graphics, input, textureSet)
+                && ProcessTextureSet(context, graphics, textureSet, input);
         }
-    }
-    return false;
-}
 
-class CustomAllocator : public ntc::IAllocator
-{
-public:
-    void* Allocate(size_t size) override
-    {
-        void* ptr = malloc(size);
-        // printf("Allocating %zu bytes at %p.\n", size, ptr);
-        m_bytesAllocated += size;
-        return ptr;
-    }
+        if (graphics.device)
+        {
+            graphics.device->waitForIdle();
+            graphics.device->runGarbageCollection();
+        }
 
-    void Deallocate(void* ptr, size_t size) override
-    {
-        if (!ptr)
-            return;
-        // printf("Deallocating %zu bytes at %p.\n", size, ptr);
-        m_bytesAllocated -= size;
-        free(ptr);
-    }
+        g_options = serverOptions;
 
-    int64_t GetBytesAllocated() const
-    {
-        return m_bytesAllocated;
-    }
+        auto const endTime = std::chrono::steady_clock::now();
+        float const jobTimeSeconds = std::chrono::duration_cast<std::chrono::duration<float>>(endTime - startTime).count();
 
-private:
-    int64_t m_bytesAllocated = 0;
-};
+        // Make sure that the messages of the job reach the client before its result
+        fflush(stdout);
+        fflush(stderr);
+        WriteJobReport(responseStream, g_jobReport, success, jobTimeSeconds);
+    }
 
+    fclose(responseStream);
+    return true;
+}
 
 int main(int argc, const char** argv)
 {
@@ -1842,6 +4180,11 @@ int main(int argc, const char** argv)
         return 0;
     }
 
+    if (g_options.generateManifestsPath)
+        return GenerateManifestsForDirectoryTree() ? 0 : 1;
+
+    if (g_options.describeAll)
+        return DescribeAllTextureSets() ? 0 : 1;
 
     if (g_options.listCudaDevices)
     {
@@ -1877,8 +4220,6 @@ int main(int argc, const char** argv)
         }
     }
 
-    CustomAllocator customAllocator;
-
     typedef std::unique_ptr<donut::app::DeviceManager, void(*)(donut::app::DeviceManager*)> DeviceManagerPtr;
     DeviceManagerPtr deviceManager = DeviceManagerPtr(nullptr, nullptr);
     nvrhi::DeviceHandle device;
@@ -1972,7 +4313,7 @@ int main(int argc, const char** argv)
 
     // Initialize the NTC context with or without the graphics device
     ntc::ContextParameters contextParams;
-    contextParams.pAllocator = &customAllocator;
+    contextParams.pAllocator = &g_allocator;
     contextParams.cudaDevice = useCuda ? g_options.cudaDevice : ntc::DisableCudaDevice;
     
     if (deviceManager)
@@ -2020,6 +4361,39 @@ int main(int argc, const char** argv)
             nvrhi::utils::GraphicsAPIToString(deviceManager->GetGraphicsAPI()),
             context->IsCooperativeVectorSupported() ? 'Y' : 'N',
             gdeflateFeatures && gdeflateFeatures->gpuDecompressionSupported ? 'Y' : 'N');
+
+        g_jobReport.gpuName = deviceManager->GetRendererString();
+        g_jobReport.graphicsApi = nvrhi::utils::GraphicsAPIToString(deviceManager->GetGraphicsAPI());
+        if (context->IsCooperativeVectorSupported())
+            g_jobReport.gpuFeatures.push_back("CoopVec");
+        if (gdeflateFeatures && gdeflateFeatures->gpuDecompressionSupported)
+            g_jobReport.gpuFeatures.push_back("GDeflate");
+    }
+
+    // Texture sets processed in a batch reuse the graphics resources of earlier texture sets.
+    // The pool is reset before the context is released, because the pooled shared textures belong to it.
+    std::optional<GraphicsResourcePool> resourcePool;
+    if (device && (g_options.batchFileName || g_options.server))
+        resourcePool.emplace(c_GraphicsResourcePoolMaxIdleBytes);
+
+    GraphicsContext graphics;
+    graphics.device = device;
+    graphics.commandList = commandList;
+    graphics.timerQuery = timerQuery;
+    graphics.gdeflateFeatures = gdeflateFeatures.get();
+    graphics.resourcePool = resourcePool.has_value() ? &*resourcePool : nullptr;
+
+    // DDS source images are decoded with the graphics API, see DecodeDDSImage(...)
+    std::optional<BlockDecompressionPass> blockDecompressionPass;
+    if (device)
+    {
+        blockDecompressionPass.emplace(device);
+        if (!blockDecompressionPass->Init())
+        {
+            fprintf(stderr, "BlockDecompressionPass::Init failed.\n");
+            return 1;
+        }
+        graphics.blockDecompressionPass = &*blockDecompressionPass;
     }
 
     if (graphicsDecompressMode || describeMode)
@@ -2054,10 +4428,48 @@ int main(int argc, const char** argv)
         if (describeMode)
             return 0;
 
-        int const mipLevels = g_options.saveMips ? metadata->GetDesc().mips : 1;
+        // With --rect or --mip, decompress one region of one mip level into textures of the region's size
+        ntc::TextureSetDesc const& textureSetDesc = metadata->GetDesc();
+        bool const regionMode = g_options.decompressionRect.has_value() || g_options.decompressionMip >= 0;
+        int const firstMipLevel = std::max(g_options.decompressionMip, 0);
+        int const mipLevels = g_options.saveMips ? textureSetDesc.mips : 1;
+        ntc::Rect region;
+
+        if (regionMode)
+        {
+            if (firstMipLevel >= textureSetDesc.mips)
+            {
+                fprintf(stderr, "The --mip value (%d) must be less than the texture set mip count (%d).\n",
+                    firstMipLevel, textureSetDesc.mips);
+                return 1;
+            }
+
+            int const mipWidth = std::max(textureSetDesc.width >> firstMipLevel, 1);
+            int const mipHeight = std::max(textureSetDesc.height >> firstMipLevel, 1);
+            if (g_options.decompressionRect.has_value())
+            {
+                region = *g_options.decompressionRect;
+            }
+            else
+            {
+                region.width = mipWidth;
+                region.height = mipHeight;
+            }
+            
+            if (region.left + region.width > mipWidth || region.top + region.height > mipHeight)
+            {
+                fprintf(stderr, "The --rect region (%d,%d,%d,%d) does not fit into mip level %d (%dx%d).\n",
+                    region.left, region.top, region.width, region.height, firstMipLevel, mipWidth, mipHeight);
+                return 1;
+            }
+
+            printf("Decompressing region %d,%d,%d,%d of mip level %d.\n",
+                region.left, region.top, region.width, region.height, firstMipLevel);
+        }
 
         GraphicsResourcesForTextureSet graphicsResources;
-        if (!CreateGraphicsResourcesFromMetadata(context, device, metadata, mipLevels, false, graphicsResources))
+        if (!CreateGraphicsResourcesFromMetadata(context, device, metadata, mipLevels, false, graphicsResources,
+            nullptr, regionMode ? region.width : 0, regionMode ? region.height : 0))
             return 1;
 
         GraphicsDecompressionPass gdp(device, NTC_MAX_CHANNELS * NTC_MAX_MIPS);
@@ -2067,7 +4479,30 @@ int main(int argc, const char** argv)
             fprintf(stderr, "GraphicsDecompressionPass::Init failed.\n");
             return 1;
         }
-        
+
+        ntc::InferenceWeightType weightType = g_options.weightType;
+        if (weightType == ntc::InferenceWeightType::Unknown && g_options.benchmarkWeightTypes)
+        {
+            weightType = SelectBenchmarkedWeightType(device, commandList, gdeflateFeatures.get(), context, gdp,
+                metadata, inputFile.Get());
+        }
+        if (weightType == ntc::InferenceWeightType::Unknown)
+        {
+            weightType = metadata->GetBestSupportedWeightType();
+            if (weightType == ntc::InferenceWeightType::Unknown)
+            {
+                fprintf(stderr, "The texture set does not provide any weights compatible with the current device.\n");
+                return 1;
+            }
+        }
+        else if (!metadata->IsInferenceWeightTypeSupported(weightType))
+        {
+            fprintf(stderr, "The texture set does not provide %s weights compatible with the current device.\n",
+                GetInferenceWeightTypeName(weightType));
+            return 1;
+        }
+        printf("Decompression weight type: %s\n", GetInferenceWeightTypeName(weightType));
+
         std::vector<float> iterationTimes;
         iterationTimes.resize(g_options.benchmarkIterations);
 
@@ -2076,7 +4511,7 @@ int main(int argc, const char** argv)
             bool const decompressSucceeded = DecompressTextureSetWithGraphicsAPI(device, commandList,
                 timerQuery, gdp, gdeflateFeatures.get(),
                 context, metadata, iteration == 0 ? inputFile.Get() : nullptr, mipLevels, g_options.enableDithering,
-                graphicsResources);
+                weightType, graphicsResources, firstMipLevel, regionMode ? &region : nullptr);
 
             if (!decompressSucceeded)
                 return 1;
@@ -2093,237 +4528,89 @@ int main(int argc, const char** argv)
             float const medianDecompressionTime = Median(iterationTimes);
             printf("Median decompression time over %d iterations: %.3f ms\n", g_options.benchmarkIterations,
                 medianDecompressionTime * 1e3f);
+
+            // Throughput is computed over all decoded mip levels. The memory traffic estimate covers
+            // the latents and weights read from the file and the uncompressed color data written out,
+            // not the intermediate cache traffic inside the decompression shader.
+            uint64_t decodedPixels = 0;
+            if (regionMode)
+            {
+                decodedPixels = uint64_t(region.width) * uint64_t(region.height);
+            }
+            else
+            {
+                for (int mipLevel = 0; mipLevel < mipLevels; ++mipLevel)
+                {
+                    decodedPixels += uint64_t(std::max(textureSetDesc.width >> mipLevel, 1))
+                        * uint64_t(std::max(textureSetDesc.height >> mipLevel, 1));
+                }
+            }
+            uint64_t writtenBytes = 0;
+            for (GraphicsResourcesForTexture const& resources : graphicsResources.perTexture)
+            {
+                nvrhi::FormatInfo const& formatInfo = nvrhi::getFormatInfo(resources.color->getDesc().format);
+                writtenBytes += decodedPixels * formatInfo.bytesPerBlock;
+            }
+            uint64_t const readBytes = inputFile->Size();
+            double const seconds = std::max(double(medianDecompressionTime), 1e-9);
+            printf("Decompression throughput: %.1f Mpix/s, memory traffic: %.1f MB read, %.1f MB written, %.1f GB/s\n",
+                double(decodedPixels) * 1e-6 / seconds, double(readBytes) * 1e-6, double(writtenBytes) * 1e-6,
+                double(readBytes + writtenBytes) * 1e-9 / seconds);
         }
 
         bool const anyBCTextures = AnyBlockCompressedTextures(metadata);
 
         if (g_options.saveImagesPath)
         {
-            if (anyBCTextures)
+            // Block compression works on whole mip chains, so regions save the BCn textures as regular images
+            if (anyBCTextures && !regionMode)
             {
                 if (!BlockCompressAndSaveGraphicsTextures(context, metadata, inputFile.Get(),
                     device, commandList, timerQuery, gdeflateFeatures.get(),
-                    g_options.saveImagesPath, g_options.benchmarkIterations, graphicsResources))
+                    g_options.saveImagesPath, g_options.saveGDeflate, g_options.benchmarkIterations, graphicsResources))
                     return 1;
             }
 
             if (!SaveGraphicsStagingTextures(metadata, device, g_options.saveImagesPath, g_options.imageFormat,
-                g_options.saveMips, graphicsResources))
+                g_options.saveMips, graphicsResources, regionMode))
                 return 1;
         }
     }
+    else if (g_options.batchFileName)
+    {
+        if (!RunBatch(context, graphics, argc, argv))
+            return 1;
+    }
+    else if (g_options.server)
+    {
+        if (!RunServer(context, graphics, argc, argv))
+            return 1;
+    }
     else
     {
-        ntc::TextureSetWrapper textureSet(context);
-
-        Manifest manifest;
-        switch (g_options.inputType)
-        {
-            case ToolInputType::Directory: {
-                assert(g_options.loadImagesPath);
-
-                GenerateManifestFromDirectory(g_options.loadImagesPath, g_options.loadMips, g_options.keepFileNames, manifest);
-                *textureSet.ptr() = LoadImages(context, manifest, true);
-                break;
-            }
-            case ToolInputType::Images: {
-                assert(!g_options.loadImagesList.empty());
-
-                GenerateManifestFromFileList(g_options.loadImagesList, g_options.keepFileNames, manifest);
-                *textureSet.ptr() = LoadImages(context, manifest, true);
-                break;
-            }
-            case ToolInputType::ManifestFile: {
-                assert(g_options.loadManifestFileName);
-
-                std::string manifestError;
-                if (!ReadManifestFromFile(g_options.loadManifestFileName, manifest, manifestError))
-                {
-                    fprintf(stderr, "%s\n", manifestError.c_str());
-                    return 1;
-                }
-
-                *textureSet.ptr() = LoadImages(context, manifest, false);
-                break;
-            }
-            case ToolInputType::ManifestStdin: {
-                std::string manifestError;
-                if (!ReadManifestFromStdin(manifest, manifestError))
-                {
-                    fprintf(stderr, "%s\n", manifestError.c_str());
-                    return 1;
-                }
-
-                *textureSet.ptr() = LoadImages(context, manifest, false);
-                break;
-            }
-            case ToolInputType::CompressedTextureSet: {
-                assert(g_options.loadCompressedFileName);
-
-                *textureSet.ptr() = LoadCompressedTextureSet(context);
-                
-                if (textureSet)
-                {
-                    // LoadImages already applies overrides to the texture set and the manifest,
-                    // so process the overrides here for the case of loading a compressed texture set.
-                    OverrideBcFormats(textureSet);
-                }
-
-                break;
-            }
-            default:
-                assert(!"Unsupported input type!");
-                return 1;
-        }
-
-        if (!textureSet)
+        InputImages input;
+        if (!ReadInputImages(g_options, input))
             return 1;
 
-        if (g_options.describe)
-        {
-            DescribeTextureSet(textureSet);
-        }
-
-        if (g_options.saveManifestFileName)
-        {
-            std::string manifestError;
-            if (!WriteManifestToFile(g_options.saveManifestFileName, manifest, manifestError))
-            {
-                fprintf(stderr, "%s\n", manifestError.c_str());
-                return 1;
-            }
-            else
-            {
-                printf("Saved manifest to '%s'\n", g_options.saveManifestFileName);
-            }
-        }
-
-        textureSet->SetExperimentalKnob(g_options.experimentalKnob);
-
-        bool const anyBCTextures = AnyBlockCompressedTextures(textureSet);
-
-        if (g_options.matchBcPsnr && !anyBCTextures)
-        {
-            fprintf(stderr, "--matchBcPsnr requires that at least one texture in the set is compressed to a BCn format.\n");
+        ntc::TextureSetWrapper textureSet(context);
+        if (!LoadTextureSet(context, &graphics, input, textureSet))
             return 1;
-        }
-
-        GraphicsResourcesForTextureSet graphicsResources;
-        if (g_options.matchBcPsnr || g_options.optimizeBC || g_options.saveImagesPath && anyBCTextures)
-        {
-            // Verify that we have a graphics device - cannot do that in ProcessCommandLine
-            // because we don't know if there are any BCn textures at that point...
-            if (!device)
-            {
-                fprintf(stderr, "BCn encoding requires either --vk or --dx12 (where available).\n"
-                    "To save images in a non-BC format, use --bcFormat none.\n");
-                return 1;
-            }
-
-            int const mipLevels = textureSet->GetDesc().mips;
-
-            if (!CreateGraphicsResourcesFromMetadata(context, device, textureSet,
-                mipLevels, /* enableCudaSharing = */ true, graphicsResources))
-                return 1;
-        }
-
-        if (g_options.matchBcPsnr)
-        {
-            if (!CopyTextureSetDataIntoGraphicsTextures(context, textureSet, ntc::TextureDataPage::Reference,
-                /* allMipLevels = */ false, /* onlyBlockCompressedFormats = */ true, graphicsResources))
-                return 1;
-
-            if (!ComputePsnrForBlockCompressedTextureSet(context, textureSet, device,
-                commandList, graphicsResources, g_options.targetPsnr))
-                return 1;
-
-            // Apply the user-specified offset and limits
-            g_options.targetPsnr = std::min(g_options.maxBcPsnr, std::max(g_options.minBcPsnr,
-                g_options.targetPsnr + g_options.bcPsnrOffset));
-
-            printf("Selected target PSNR: %.2f dB.\n", g_options.targetPsnr);
-        }
-        
-        if (g_options.compress)
-        {
-            if (std::isnan(g_options.targetPsnr))
-            {
-                if (!CompressTextureSet(context, textureSet, nullptr))
-                    return 1;
-            }
-            else
-            {
-                if (!CompressTextureSetWithTargetPSNR(context, textureSet))
-                    return 1;
-            }
-        }
-
-        if (g_options.decompress)
-        {
-            if (g_options.compress)
-            {
-                if (!DecompressTextureSet(context, textureSet, /* useInt8Weights = */ true))
-                    return 1;
-            }
 
-            if (!DecompressTextureSet(context, textureSet, /* useInt8Weights = */ false))
-                return 1;
-        }
-
-        if (g_options.optimizeBC || g_options.saveImagesPath && anyBCTextures)
-        {
-            ntc::TextureDataPage const sourcePage = g_options.decompress
-                ? ntc::TextureDataPage::Output
-                : ntc::TextureDataPage::Reference;
-                
-            if (!CopyTextureSetDataIntoGraphicsTextures(context, textureSet, sourcePage,
-                /* allMipLevels = */ true, /* onlyBlockCompressedFormats = */ true, graphicsResources))
-                return 1;
-        }
-
-        if (g_options.optimizeBC)
-        {
-            if (!OptimizeBlockCompression(context, textureSet, device,
-                commandList, g_options.bcPsnrThreshold, graphicsResources))
-                return 1;
-        }
-
-        if (g_options.saveImagesPath)
-        {
-            if (anyBCTextures)
-            {
-                if (!BlockCompressAndSaveGraphicsTextures(context, textureSet, nullptr,
-                    device, commandList, timerQuery, gdeflateFeatures.get(),
-                    g_options.saveImagesPath, g_options.benchmarkIterations, graphicsResources))
-                    return 1;
-            }
-                
-            if (!SaveImagesFromTextureSet(context, textureSet))
-                return 1;
-        }
-
-        if (g_options.saveCompressedFileName)
-        {
-            if (!SaveCompressedTextureSet(context, textureSet))
-                return 1;
-        }
-        else if (g_options.compress)
-        {
-            size_t estimatedSize;
-            if (ntc::EstimateCompressedTextureSetSize(textureSet->GetDesc(), textureSet->GetLatentShape(),
-                estimatedSize) == ntc::Status::Ok)
-            {
-                size_t const texturePixels = GetTextureSetPixelCount(textureSet);
-                float const bpp = 8.f * float(estimatedSize) / float(texturePixels);
-                printf("Estimated file size: %zu bytes, %.2f bits per pixel.\n", estimatedSize, bpp);
-            }
-        }
+        if (!ProcessTextureSet(context, graphics, textureSet, input))
+            return 1;
     }
 
+    // Release the pooled resources while the context and the device that own them are still alive
+    graphics.resourcePool = nullptr;
+    resourcePool.reset();
+
     context.Release();
 
-    if (customAllocator.GetBytesAllocated() != 0)
-        fprintf(stderr, "Library leaked %" PRIi64 " bytes!\n", customAllocator.GetBytesAllocated());
+    if (g_options.printAllocatorStats)
+        g_allocator.PrintPhaseStats();
+
+    if (g_allocator.GetBytesAllocated() != 0)
+        fprintf(stderr, "Library leaked %" PRIi64 " bytes!\n", g_allocator.GetBytesAllocated());
 
     return 0;
 }
\ No newline at end of file
@@ -51,11 +51,13 @@ float Median(std::vector<float>& items)
     return items[middleIndex];
 }
 
-bool WriteDdsHeader(ntc::IStream* ddsFile, int width, int height, int mipLevels, BcFormatDefinition const* outputFormatDefinition, ntc::ColorSpace colorSpace)
+DdsFileHeader MakeDdsFileHeader(int width, int height, int mipLevels, BcFormatDefinition const* outputFormatDefinition, ntc::ColorSpace colorSpace)
 {
     using namespace donut::engine::dds;
-    DDS_HEADER ddsHeader{};
-    DDS_HEADER_DXT10 dx10header = {};
+    DdsFileHeader file{};
+    file.magic = DDS_MAGIC;
+
+    DDS_HEADER& ddsHeader = file.header;
     ddsHeader.size = sizeof(DDS_HEADER);
     ddsHeader.flags = DDS_HEADER_FLAGS_TEXTURE;
     ddsHeader.width = width;
@@ -65,16 +67,13 @@ bool WriteDdsHeader(ntc::IStream* ddsFile, int width, int height, int mipLevels,
     ddsHeader.ddspf.size = sizeof(DDS_PIXELFORMAT);
     ddsHeader.ddspf.flags = DDS_FOURCC;
     ddsHeader.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+    DDS_HEADER_DXT10& dx10header = file.dx10Header;
     dx10header.resourceDimension = DDS_DIMENSION_TEXTURE2D;
     dx10header.arraySize = 1;
     dx10header.dxgiFormat = colorSpace == ntc::ColorSpace::sRGB ? outputFormatDefinition->dxgiFormatSrgb : outputFormatDefinition->dxgiFormat;
 
-    uint32_t ddsMagic = DDS_MAGIC;
-    bool success;
-    success = ddsFile->Write(&ddsMagic, sizeof(ddsMagic));
-    success &= ddsFile->Write(&ddsHeader, sizeof(ddsHeader));
-    success &= ddsFile->Write(&dx10header, sizeof(dx10header));
-    return success;
+    return file;
 }
 
 bool SavePNG(uint8_t* data, int mipWidth, int mipHeight, int numChannels, bool is16Bit, char const* fileName)
@@ -235,3 +234,38 @@ bool SaveImageToContainer(ImageContainer container, void const* data, int width,
             fileName, /* err = */ nullptr) == TINYEXR_SUCCESS;
     }
 }
+
+std::optional<ntc::InferenceWeightType> ParseInferenceWeightType(char const* weightType)
+{
+    if (!weightType || !weightType[0])
+        return ntc::InferenceWeightType::Unknown;
+
+    std::string uppercaseWeightType = weightType;
+    UppercaseString(uppercaseWeightType);
+
+    if (uppercaseWeightType == "AUTO")
+        return ntc::InferenceWeightType::Unknown;
+    if (uppercaseWeightType == "INT8")
+        return ntc::InferenceWeightType::GenericInt8;
+    if (uppercaseWeightType == "FP8")
+        return ntc::InferenceWeightType::GenericFP8;
+    if (uppercaseWeightType == "COOPVEC" || uppercaseWeightType == "COOPVECFP8")
+        return ntc::InferenceWeightType::CoopVecFP8;
+
+    return std::optional<ntc::InferenceWeightType>();
+}
+
+char const* GetInferenceWeightTypeName(ntc::InferenceWeightType weightType)
+{
+    switch(weightType)
+    {
+    case ntc::InferenceWeightType::GenericInt8:
+        return "Int8";
+    case ntc::InferenceWeightType::GenericFP8:
+        return "FP8";
+    case ntc::InferenceWeightType::CoopVecFP8:
+        return "CoopVec";
+    default:
+        return "Unknown";
+    }
+}
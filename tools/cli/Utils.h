@@ -42,7 +42,15 @@ BcFormatDefinition const* GetBcFormatDefinition(ntc::BlockCompressedFormat forma
 
 float Median(std::vector<float>& items);
 
-bool WriteDdsHeader(ntc::IStream* ddsFile, int width, int height, int mipLevels,
+// The DDS magic number followed by the legacy and DX10 headers, which is what a BCn DDS file starts with
+struct DdsFileHeader
+{
+    uint32_t magic;
+    donut::engine::dds::DDS_HEADER header;
+    donut::engine::dds::DDS_HEADER_DXT10 dx10Header;
+};
+
+DdsFileHeader MakeDdsFileHeader(int width, int height, int mipLevels,
     BcFormatDefinition const* outputFormatDefinition, ntc::ColorSpace colorSpace);
 
 bool SavePNG(uint8_t* data, int mipWidth, int mipHeight, int numChannels, bool is16Bit, char const* fileName);
@@ -66,3 +74,8 @@ std::optional<ImageContainer> ParseImageContainer(char const* s);
 ntc::ChannelFormat GetContainerChannelFormat(ImageContainer container);
 char const* GetContainerExtension(ImageContainer container);
 bool SaveImageToContainer(ImageContainer container, void const* data, int width, int height, int channels, char const* fileName);
+
+// Parses the inference weight type names accepted on the command line: Auto, Int8, FP8, CoopVec.
+// Auto is returned as InferenceWeightType::Unknown, which means "pick the best supported type".
+std::optional<ntc::InferenceWeightType> ParseInferenceWeightType(char const* s);
+char const* GetInferenceWeightTypeName(ntc::InferenceWeightType weightType);
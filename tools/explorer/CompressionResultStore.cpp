@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#include "CompressionResultStore.h"
+#include <donut/core/log.h>
+#include <chrono>
+#include <fstream>
+
+namespace fs = std::filesystem;
+using namespace donut;
+
+CompressionResultStore::~CompressionResultStore()
+{
+    DeleteSpilledFiles();
+}
+
+void CompressionResultStore::Add(int ordinal, std::shared_ptr<std::vector<uint8_t>> data)
+{
+    if (!data)
+        return;
+
+    std::lock_guard lock(m_mutex);
+
+    Entry& entry = m_entries[ordinal];
+    if (entry.data)
+    {
+        m_memoryUsage -= entry.size;
+        m_lruOrdinals.erase(entry.lruPosition);
+    }
+
+    entry.data = std::move(data);
+    entry.size = entry.data->size();
+    entry.fileName.clear();
+    m_lruOrdinals.push_front(ordinal);
+    entry.lruPosition = m_lruOrdinals.begin();
+    m_memoryUsage += entry.size;
+
+    EvictOverLimit();
+}
+
+std::shared_ptr<std::vector<uint8_t>> CompressionResultStore::Get(int ordinal)
+{
+    std::lock_guard lock(m_mutex);
+
+    auto it = m_entries.find(ordinal);
+    if (it == m_entries.end())
+        return nullptr;
+
+    Entry& entry = it->second;
+    if (entry.data)
+    {
+        Touch(entry);
+        return entry.data;
+    }
+
+    std::ifstream file(entry.fileName, std::ios::binary);
+    auto data = std::make_shared<std::vector<uint8_t>>(entry.size);
+    if (!file.is_open() || !file.read(reinterpret_cast<char*>(data->data()), std::streamsize(entry.size)))
+    {
+        log::error("Failed to read the compressed data for result #%d from '%s'.",
+            ordinal, entry.fileName.generic_string().c_str());
+        return nullptr;
+    }
+
+    entry.data = data;
+    m_lruOrdinals.push_front(ordinal);
+    entry.lruPosition = m_lruOrdinals.begin();
+    m_memoryUsage += entry.size;
+
+    EvictOverLimit();
+
+    return data;
+}
+
+void CompressionResultStore::Clear()
+{
+    std::lock_guard lock(m_mutex);
+
+    DeleteSpilledFiles();
+    m_entries.clear();
+    m_lruOrdinals.clear();
+    m_memoryUsage = 0;
+}
+
+size_t CompressionResultStore::GetMemoryUsage() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_memoryUsage;
+}
+
+size_t CompressionResultStore::GetDiskUsage() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_diskUsage;
+}
+
+void CompressionResultStore::Touch(Entry& entry)
+{
+    m_lruOrdinals.splice(m_lruOrdinals.begin(), m_lruOrdinals, entry.lruPosition);
+}
+
+void CompressionResultStore::EvictOverLimit()
+{
+    // Always keep the most recently used entry in memory, even if it's over the limit alone
+    while (m_memoryUsage > m_memoryLimit && m_lruOrdinals.size() > 1)
+    {
+        int const ordinal = m_lruOrdinals.back();
+        Entry& entry = m_entries[ordinal];
+
+        // Results that can't be written to disk stay in memory
+        if (entry.fileName.empty() && !Spill(ordinal, entry))
+            break;
+
+        m_lruOrdinals.pop_back();
+        entry.data.reset();
+        m_memoryUsage -= entry.size;
+    }
+}
+
+bool CompressionResultStore::Spill(int ordinal, Entry& entry)
+{
+    if (m_spillDirectory.empty())
+    {
+        // Use a unique directory name so that multiple Explorer instances don't conflict
+        auto const timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+        std::error_code ec;
+        m_spillDirectory = fs::temp_directory_path(ec) / ("ntc-explorer-" + std::to_string(timestamp));
+        if (ec || !fs::create_directories(m_spillDirectory, ec))
+        {
+            log::warning("Failed to create the directory for compression results '%s', "
+                "keeping the results in memory.", m_spillDirectory.generic_string().c_str());
+            m_spillDirectory.clear();
+            return false;
+        }
+    }
+
+    fs::path const fileName = m_spillDirectory / ("result-" + std::to_string(ordinal) + ".ntc");
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file.is_open() || !file.write(reinterpret_cast<char const*>(entry.data->data()), std::streamsize(entry.size)))
+    {
+        log::warning("Failed to write the compressed data for result #%d into '%s'.",
+            ordinal, fileName.generic_string().c_str());
+        return false;
+    }
+
+    entry.fileName = fileName;
+    m_diskUsage += entry.size;
+    return true;
+}
+
+void CompressionResultStore::DeleteSpilledFiles()
+{
+    if (m_spillDirectory.empty())
+        return;
+
+    std::error_code ec;
+    fs::remove_all(m_spillDirectory, ec);
+    m_spillDirectory.clear();
+    m_diskUsage = 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
+ *
+ * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
+ * property and proprietary rights in and to this material, related
+ * documentation and any modifications thereto. Any use, reproduction,
+ * disclosure or distribution of this material and related documentation
+ * without an express license agreement from NVIDIA CORPORATION or
+ * its affiliates is strictly prohibited.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// The CompressionResultStore class keeps the compressed data for the Explorer compression results.
+// The most recently used data is kept in memory up to a size limit, and the rest is spilled into files
+// in a temporary directory. Results that were loaded from a file are spilled too, because the file may be
+// overwritten with other data while the result is in the list, for example by saving another result into it.
+// All functions are thread-safe.
+class CompressionResultStore
+{
+public:
+    explicit CompressionResultStore(size_t memoryLimit)
+        : m_memoryLimit(memoryLimit)
+    { }
+
+    ~CompressionResultStore();
+
+    CompressionResultStore(CompressionResultStore const&) = delete;
+    CompressionResultStore& operator=(CompressionResultStore const&) = delete;
+
+    // Adds the data for a result.
+    void Add(int ordinal, std::shared_ptr<std::vector<uint8_t>> data);
+
+    // Returns the data for a result, reading it from disk if necessary, or nullptr if that fails.
+    std::shared_ptr<std::vector<uint8_t>> Get(int ordinal);
+
+    // Removes all results and deletes the spilled files.
+    void Clear();
+
+    size_t GetMemoryUsage() const;
+    size_t GetDiskUsage() const;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<std::vector<uint8_t>> data; // nullptr when not in memory
+        size_t size = 0;
+        std::filesystem::path fileName; // Spilled file, empty if the data has not been written to disk yet
+        std::list<int>::iterator lruPosition;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<int, Entry> m_entries;
+    std::list<int> m_lruOrdinals; // Ordinals of the entries in memory, most recently used first
+    std::filesystem::path m_spillDirectory;
+    size_t m_memoryLimit = 0;
+    size_t m_memoryUsage = 0;
+    size_t m_diskUsage = 0;
+
+    void Touch(Entry& entry);
+    void EvictOverLimit();
+    bool Spill(int ordinal, Entry& entry);
+    void DeleteSpilledFiles();
+};
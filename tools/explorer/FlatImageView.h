@@ -49,6 +49,8 @@ public:
     void BuildControlDialog();
     bool IsRequestingRestore(int& outRunOrdinal, bool& outRightTexture);
 
+    int GetMipLevel() const { return m_mipLevel; }
+
 private:
     std::shared_ptr<donut::engine::BindingCache> m_bindingCache;
     std::shared_ptr<donut::engine::CommonRenderPasses> m_commonPasses;
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: Copyright (c) 2023-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-FileCopyrightText: Copyright (c) 2023-2025 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
  * SPDX-License-Identifier: LicenseRef-NvidiaProprietary
  *
  * NVIDIA CORPORATION, its affiliates and licensors retain all intellectual
@@ -23,7 +23,10 @@
 #include <donut/core/math/math.h>
 #include <donut/core/string_utils.h>
 #include <nvrhi/utils.h>
+#include <ntc-utils/AveragingTimerQuery.h>
+#include <ntc-utils/GraphicsBlockCompressionPass.h>
 #include <ntc-utils/GraphicsDecompressionPass.h>
+#include <ntc-utils/ImageProbe.h>
 #include <ntc-utils/Manifest.h>
 #include <ntc-utils/DeviceUtils.h>
 #include <ntc-utils/Misc.h>
@@ -33,12 +36,18 @@
 #include <stb_image.h>
 #include <sstream>
 #include <tinyexr.h>
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <map>
 #include <unordered_set>
 #include <libntc/ntc.h>
 #include <imgui_internal.h>
+#include <implot.h>
 #include <cuda_runtime_api.h>
 
 
+#include "CompressionResultStore.h"
 #include "FlatImageView.h"
 #include "ModelView.h"
 #include "ImGuiExtensions.h"
@@ -64,10 +73,17 @@ struct
     bool enableCoopVec = true;
     int adapterIndex = -1;
     int cudaDevice = 0;
+    int historyMemoryMB = 256;
+    int previewCacheSize = 4;
+    int decompressionMip = -1; // -1 means all mip levels
+    bool useDecompressionRect = false;
+    ntc::Rect decompressionRect;
 } g_options;
 
 bool ProcessCommandLine(int argc, const char** argv)
 {
+    const char* rectString = nullptr;
+
     struct argparse_option options[] = {
         OPT_HELP(),
         OPT_BOOLEAN(0, "debug", &g_options.debug, "Enable graphics debug runtime"),
@@ -78,6 +94,10 @@ bool ProcessCommandLine(int argc, const char** argv)
         OPT_BOOLEAN(0, "captureMode", &g_options.captureMode, "Trace capture mode - run Graphics decompression in a loop"),
         OPT_BOOLEAN(0, "compare", &g_options.compare, "Use Explorer to compare two images specified on the command line"),
         OPT_BOOLEAN(0, "hdr", &g_options.hdr, "Use an HDR (FP16) swap chain"),
+        OPT_INTEGER(0, "historyMemory", &g_options.historyMemoryMB, "Memory limit for the compressed data of the compression results in MB, older results are kept on disk (default 256)"),
+        OPT_INTEGER(0, "previewCache", &g_options.previewCacheSize, "Number of restored compression results to keep decompressed on the GPU for instant switching (default 4)"),
+        OPT_STRING (0, "rect", &rectString, "Restore only a region of each decompressed mip level with GAPI decompression, in the 'X,Y,W,H' format"),
+        OPT_INTEGER(0, "mip", &g_options.decompressionMip, "Restore only one mip level with GAPI decompression"),
 #if NTC_WITH_VULKAN
         OPT_BOOLEAN(0, "vk", &g_options.useVulkan, "Use Vulkan API"),
 #endif
@@ -195,6 +215,19 @@ bool ProcessCommandLine(int argc, const char** argv)
         }
     }
 
+    if (rectString)
+    {
+        ntc::Rect& rect = g_options.decompressionRect;
+        if (sscanf(rectString, "%d,%d,%d,%d", &rect.left, &rect.top, &rect.width, &rect.height) != 4 ||
+            rect.left < 0 || rect.top < 0 || rect.width <= 0 || rect.height <= 0)
+        {
+            log::error("Invalid value for --rect '%s', must be 'X,Y,W,H' with a non-negative offset and a positive size.",
+                rectString);
+            return false;
+        }
+        g_options.useDecompressionRect = true;
+    }
+
     return true;
 }
 
@@ -203,6 +236,14 @@ static int GetNumMipLevels(int width, int height)
     return int(floorf(std::log2f(float(std::max(width, height)))) + 1);
 }
 
+static uint64_t GetMipChainPixels(int width, int height, int mipLevels)
+{
+    uint64_t pixels = 0;
+    for (int mip = 0; mip < mipLevels; ++mip)
+        pixels += uint64_t(std::max(1, width >> mip)) * uint64_t(std::max(1, height >> mip));
+    return pixels;
+}
+
 struct MaterialImage
 {
     int width = 0;
@@ -372,8 +413,30 @@ struct CompressionResult
     int ordinal = 0;
     float timeSeconds = 0.f;
     float experimentalKnob = 0.f;
-    std::shared_ptr<std::vector<uint8_t>> compressedData;
+    size_t compressedSize = 0; // The data itself is in CompressionResultStore
     fs::path sourceFileName;
+    int sweepIndex = 0; // Non-zero if the result was produced by a parameter sweep
+};
+
+// Bitrates offered for parameter sweeps, same as the default experiments in compression_study.py
+static const float g_sweepBitsPerPixel[] = { 1.11f, 1.67f, 2.50f, 3.75f, 5.00f, 6.67f, 10.0f, 15.0f, 20.0f };
+static const int g_numSweepPresets = int(std::size(g_sweepBitsPerPixel));
+
+// GPU copies of the decompressed textures for one compression result, see Application::StorePreview
+struct PreviewCacheEntry
+{
+    int ordinal = 0;
+    bool gapiDecompression = false;
+    bool int8Decompression = false;
+    std::vector<nvrhi::TextureHandle> textures; // One texture per item in m_images
+};
+
+// Image and mip level shown in the flat view, which the progress previews during compression are limited to.
+// Written by the UI thread and read by the compression thread as one value, see Application::m_previewTarget.
+struct PreviewTarget
+{
+    int image = -1; // -1 when the model view shows all images
+    int mip = -1; // -1 for all mip levels
 };
 
 class Application : public app::ImGui_Renderer
@@ -400,6 +463,12 @@ private:
     bool m_loading = false;
     bool m_compressing = false;
     bool m_cancel = false;
+    bool m_sweepPresetEnabled[g_numSweepPresets] = { };
+    int m_sweepCounter = 0;
+    // The sweep state is updated by the compression task and read by the UI thread
+    std::atomic<int> m_activeSweep = 0; // Index of the sweep being run, 0 when running a single compression
+    std::atomic<int> m_sweepRunsDone = 0;
+    std::atomic<int> m_sweepRunsTotal = 0;
     bool m_loadedManifestFile = false;
     bool m_sharedTexturesAvailable = false;
     bool m_compareMode = false;
@@ -424,8 +493,13 @@ private:
     bool m_useRightDecompressedImage = false;
     bool m_compressedTextureSetAvailable = false;
     bool m_showCompressionProgress = true;
+    std::atomic<float> m_compressionPreviewInterval = 0.5f; // Seconds between the progress previews during compression
+    std::atomic<PreviewTarget> m_previewTarget { PreviewTarget() };
     int m_compressionCounter = 0;
     std::vector<CompressionResult> m_compressionResults;
+    CompressionResultStore m_resultStore { size_t(std::max(g_options.historyMemoryMB, 0)) * 1048576 };
+    std::list<PreviewCacheEntry> m_previewCache; // Most recently used first
+    std::mutex m_previewCacheMutex; // Separate from m_mutex because restores happen while the UI holds m_mutex
     CompressionResult m_selectedCompressionResult;
     bool m_selectedCompressionResultValid = false;
     int m_alphaMaskChannelIndex = -1;
@@ -441,8 +515,18 @@ private:
     bool m_useGapiDecompression = false;
     bool m_useGapiDecompressionRect = false;
     ntc::Rect m_gapiDecompressionRect;
+    int m_gapiDecompressionMip = -1; // -1 means all mip levels
     GraphicsDecompressionPass m_decompressionPass;
-    nvrhi::TimerQueryHandle m_timerQuery;
+    AveragingTimerQuery m_gapiDecompressionTimer;
+    float m_gapiDecompressionPixels = 0.f;
+    float m_cudaDecompressionTimeMs = 0.f;
+    float m_cudaDecompressionPixels = 0.f;
+    GraphicsBlockCompressionPass m_blockCompressionPass;
+    bool m_blockCompressionPassInitialized = false;
+    bool m_measureBlockCompression = false;
+    bool m_showRuntimeCost = false;
+    std::vector<AveragingTimerQuery> m_blockCompressionTimers; // One timer per item in m_images
+    std::vector<nvrhi::TextureHandle> m_blockCompressionOutputs; // Same, only for the images with a BCn format
     std::optional<Manifest> m_manifest;
 
 
@@ -450,7 +534,11 @@ public:
     Application(app::DeviceManager* deviceManager)
         : ImGui_Renderer(deviceManager)
         , m_decompressionPass(GetDevice(), NTC_MAX_CHANNELS * NTC_MAX_MIPS)
+        , m_gapiDecompressionTimer(GetDevice())
+        , m_blockCompressionPass(GetDevice(), NTC_MAX_CHANNELS * NTC_MAX_MIPS)
     {
+        ImPlot::CreateContext();
+
         m_shaderFactory = std::make_shared<engine::ShaderFactory>(GetDevice(), nullptr, fs::path());
 
         m_commonPasses = std::make_shared<engine::CommonRenderPasses>(GetDevice(), m_shaderFactory);
@@ -466,8 +554,6 @@ public:
         m_commandList = GetDevice()->createCommandList(commandListParams);
         m_uploadCommandList = GetDevice()->createCommandList(commandListParams);
 
-        m_timerQuery = GetDevice()->createTimerQuery();
-
         ImGui::GetIO().IniFilename = nullptr;
     }
 
@@ -482,6 +568,8 @@ public:
 
         if (m_textureSet)
             m_ntcContext->DestroyTextureSet(m_textureSet);
+
+        ImPlot::DestroyContext();
     }
     
     bool Init()
@@ -526,6 +614,15 @@ public:
 
         m_compareMode = g_options.compare;
 
+        // The region options only apply to GAPI decompression, so they select it
+        if (g_options.useDecompressionRect || g_options.decompressionMip >= 0)
+        {
+            m_useGapiDecompression = true;
+            m_useGapiDecompressionRect = g_options.useDecompressionRect;
+            m_gapiDecompressionRect = g_options.decompressionRect;
+            m_gapiDecompressionMip = g_options.decompressionMip;
+        }
+
         // Begin loading the inputs specified on the command line.
         // The type of inputs and their consistency is validated in ProcessCommandLine.
         switch (g_options.inputType)
@@ -688,9 +785,10 @@ public:
 
         uint64_t const fileSize = inputFile->Size();
         CompressionResult result;
-        result.compressedData = std::make_shared<std::vector<uint8_t>>(fileSize);
+        auto compressedData = std::make_shared<std::vector<uint8_t>>(fileSize);
         inputFile->Seek(0);
-        inputFile->Read(result.compressedData->data(), fileSize);
+        inputFile->Read(compressedData->data(), fileSize);
+        result.compressedSize = compressedData->size();
         result.compressMipChain = desc.mips > 1;
         result.bitsPerPixel = float(fileSize) / float(desc.width * desc.height);
         if (result.compressMipChain)
@@ -698,6 +796,7 @@ public:
         result.latentShape = metadata->GetLatentShape();
         result.ordinal = ++m_compressionCounter;
         result.sourceFileName = fileName;
+        m_resultStore.Add(result.ordinal, compressedData);
         m_compressionResults.push_back(result);
         return &m_compressionResults.back();
     }
@@ -705,7 +804,7 @@ public:
     bool BeginLoadingImagesFromDirectory(const char* path)
     {
         Manifest manifest;
-        GenerateManifestFromDirectory(path, false, false, manifest);
+        GenerateManifestFromDirectory(path, false, false, /* includeDDS = */ false, manifest);
         if (manifest.textures.empty())
         {
             log::error("The folder '%s' contains no compatible image files.", path);
@@ -722,8 +821,7 @@ public:
         }
 
         m_loadedManifestFile = false;
-        BeginLoadingImages(manifest);
-        return true;
+        return BeginLoadingImages(manifest);
     }
 
     bool BeginLoadingImagesFromFileList(std::vector<char const*> const& files)
@@ -739,8 +837,7 @@ public:
         }
 
         m_loadedManifestFile = false;
-        BeginLoadingImages(manifest);
-        return true;
+        return BeginLoadingImages(manifest);
     }
 
     bool BeginLoadingImagesFromManifest(const char* manifestFileName)
@@ -761,8 +858,7 @@ public:
         }
 
         m_loadedManifestFile = true;
-        BeginLoadingImages(manifest);
-        return true;
+        return BeginLoadingImages(manifest);
     }
 
     bool ProcessChannelSwizzle(MaterialImage& image, std::string const& channelSwizzle)
@@ -900,8 +996,50 @@ public:
         image.data = newData;
     }
 
-    void BeginLoadingImages(Manifest const& manifest)
+    // Reads the headers of all images in the manifest and checks that they fit into one texture set.
+    // This is done before starting the decoding tasks, and before clearing the current images,
+    // so that a material that can't be loaded is rejected quickly and without losing the current one.
+    bool ProbeManifestImages(Manifest const& manifest)
     {
+        int totalChannels = 0;
+        size_t decodedSize = 0;
+        for (ManifestEntry const& entry : manifest.textures)
+        {
+            ImageFileInfo info;
+            if (!ProbeImageFile(entry.fileName, info))
+            {
+                log::error("Failed to read image '%s'.", entry.fileName.c_str());
+                return false;
+            }
+
+            if (info.bcFormat != ntc::BlockCompressedFormat::None)
+            {
+                log::error("Image '%s' is a block-compressed DDS file, which is only supported as a compression "
+                    "source by ntc-cli.", entry.fileName.c_str());
+                return false;
+            }
+
+            totalChannels += entry.channelSwizzle.empty() ? info.channels : int(entry.channelSwizzle.size());
+            decodedSize += info.GetDecodedSize();
+        }
+
+        if (totalChannels > NTC_MAX_CHANNELS)
+        {
+            log::error("The images have %d channels in total. At most %d channels are supported.",
+                totalChannels, NTC_MAX_CHANNELS);
+            return false;
+        }
+
+        log::info("Loading %d images, %.1f MB when decoded.", int(manifest.textures.size()),
+            double(decodedSize) / 1048576.0);
+        return true;
+    }
+
+    bool BeginLoadingImages(Manifest const& manifest)
+    {
+        if (!ProbeManifestImages(manifest))
+            return false;
+
         m_loading = true;
         ClearImages();
         bool isFirstFile = true;
@@ -1007,6 +1145,8 @@ public:
 
             ++manifestIndex;
         }
+
+        return true;
     }
 
     bool IsModelViewActive() const
@@ -1205,6 +1345,8 @@ public:
     {
         m_semanticBindings.clear();
         m_compressionResults.clear();
+        m_resultStore.Clear();
+        ClearPreviewCache();
         m_bindingCache->Clear();
         m_useLeftDecompressedImage = false;
         m_useRightDecompressedImage = false;
@@ -1214,6 +1356,12 @@ public:
         m_editingImage = -1;
         m_compressionCounter = 0;
         m_manifest = std::nullopt;
+        m_gapiDecompressionTimer.clearHistory();
+        m_gapiDecompressionPixels = 0.f;
+        m_cudaDecompressionPixels = 0.f;
+        m_blockCompressionTimers.clear();
+        m_blockCompressionOutputs.clear();
+        m_blockCompressionPass.ClearBindingSetCache();
         
         for (auto& image : m_images)
         {
@@ -1411,11 +1559,14 @@ public:
 
         // Begin the decompression region
         m_commandList->beginMarker("Decompress");
-        m_commandList->beginTimerQuery(m_timerQuery);
+        m_gapiDecompressionTimer.beginQuery(m_commandList);
         
         // Decompress each mip level in a loop
         for (int mipLevel = 0; mipLevel < metadata->GetDesc().mips; ++mipLevel)
         {
+            if (m_gapiDecompressionMip >= 0 && mipLevel != m_gapiDecompressionMip)
+                continue;
+
             // Obtain the compute pass description and constant buffer data from NTC
             ntc::ComputePassDesc computePass{};
             ntc::MakeDecompressionComputePassParameters params;
@@ -1429,7 +1580,7 @@ public:
             // On failure, close/abandon the command list and return
             if (ntcStatus != ntc::Status::Ok)
             {
-                m_commandList->endTimerQuery(m_timerQuery);
+                m_gapiDecompressionTimer.endQuery(m_commandList);
                 m_commandList->close();
                 return ntcStatus;
             }
@@ -1448,7 +1599,7 @@ public:
 
             if (!m_decompressionPass.ExecuteComputePass(m_commandList, computePass))
             {
-                m_commandList->endTimerQuery(m_timerQuery);
+                m_gapiDecompressionTimer.endQuery(m_commandList);
                 m_commandList->close();
                 return ntc::Status::InternalError;
             }
@@ -1458,14 +1609,22 @@ public:
         }
 
         // End the timer query, close and execute the CL
-        m_commandList->endTimerQuery(m_timerQuery);
+        m_gapiDecompressionTimer.endQuery(m_commandList);
         m_commandList->endMarker();
         m_commandList->close();
         GetDevice()->executeCommandList(m_commandList);
         GetDevice()->waitForIdle();
 
-        float seconds = GetDevice()->getTimerQueryTime(m_timerQuery);
-        log::info("Decompression time: %.2f ms", seconds * 1e3f);
+        m_gapiDecompressionTimer.update();
+        if (std::optional<float> seconds = m_gapiDecompressionTimer.getLatestAvailableTime())
+            log::info("Decompression time: %.2f ms", *seconds * 1e3f);
+        if (m_useGapiDecompressionRect)
+            m_gapiDecompressionPixels = float(m_gapiDecompressionRect.width * m_gapiDecompressionRect.height);
+        else if (m_gapiDecompressionMip >= 0)
+            m_gapiDecompressionPixels = float(std::max(textureSetDesc.width >> m_gapiDecompressionMip, 1)
+                * std::max(textureSetDesc.height >> m_gapiDecompressionMip, 1));
+        else
+            m_gapiDecompressionPixels = float(GetMipChainPixels(textureSetDesc.width, textureSetDesc.height, textureSetDesc.mips));
 
         if (useRightTextures)
             m_useRightDecompressedImage = true;
@@ -1484,7 +1643,10 @@ public:
         return params;
     }
 
-    bool DecompressIntoTextures(bool recordResults, bool useRightTextures, bool enableInt8, time_point<steady_clock> beginTime)
+    // With previewOnly, only the image and mip level that are currently visible are copied into the textures,
+    // which avoids most of the readback and upload work for the progress previews during compression.
+    bool DecompressIntoTextures(bool recordResults, bool useRightTextures, bool enableInt8, time_point<steady_clock> beginTime,
+        bool previewOnly = false)
     {
         if (!m_cudaAvailable)
             return false;
@@ -1496,6 +1658,9 @@ public:
         CHECK_NTC_RESULT(Decompress);
         CHECK_CANCEL(false);
 
+        m_cudaDecompressionTimeMs = stats.gpuTimeMilliseconds;
+        m_cudaDecompressionPixels = float(GetMipChainPixels(m_textureSetDesc.width, m_textureSetDesc.height, m_textureSetDesc.mips));
+
         if (recordResults)
         {
             const auto& textureSetDesc = m_textureSet->GetDesc();
@@ -1510,25 +1675,28 @@ public:
             for (int channel = 0; channel < textureSetDesc.channels; ++channel)
                 result.perChannelMSE[channel] = stats.perChannelLoss[channel];
             result.experimentalKnob = m_experimentalKnob;
+            result.sweepIndex = m_activeSweep;
             result.ordinal = ++m_compressionCounter;
             
             time_point endTime = steady_clock::now();
             result.timeSeconds = float(duration_cast<microseconds>(endTime - beginTime).count()) * 1e-6f;
 
             size_t bufferSize = m_textureSet->GetOutputStreamSize();
-            result.compressedData = std::make_shared<std::vector<uint8_t>>(bufferSize);
+            auto compressedData = std::make_shared<std::vector<uint8_t>>(bufferSize);
 
             result.useGDeflate = m_enableGDeflate;
 
             ntcStatus = m_textureSet->ConfigureLosslessCompression(GetLosslessCompressionParams());
             CHECK_NTC_RESULT(ConfigureLosslessCompression);
 
-            ntcStatus = m_textureSet->SaveToMemory(result.compressedData->data(), &bufferSize);
+            ntcStatus = m_textureSet->SaveToMemory(compressedData->data(), &bufferSize);
             CHECK_NTC_RESULT(SaveToMemory);
 
             // Trim the buffer to the actual size of the saved data
-            result.compressedData->resize(bufferSize);
+            compressedData->resize(bufferSize);
+            result.compressedSize = bufferSize;
             result.bitsPerPixel = float(double(bufferSize) * 8.0 / double(m_totalPixels));
+            m_resultStore.Add(result.ordinal, compressedData);
             
             // The rest of this function is interlocked with other threads
             std::lock_guard lock(m_mutex);
@@ -1540,8 +1708,16 @@ public:
         int const texturesInSet = m_textureSet->GetTextureCount();
         assert(texturesInSet == m_images.size()); // Validated when loading the file, or equal by definition if the texture was just compressed
 
-        for (auto& image : m_images)
+        PreviewTarget const previewTarget = previewOnly ? m_previewTarget.load() : PreviewTarget();
+        int const previewImage = previewTarget.image;
+        int const previewMip = previewTarget.mip;
+
+        for (int imageIndex = 0; imageIndex < int(m_images.size()); ++imageIndex)
         {
+            if (previewImage >= 0 && imageIndex != previewImage)
+                continue;
+
+            MaterialImage& image = m_images[imageIndex];
             size_t const bytesPerComponent = ntc::GetBytesPerPixelComponent(image.format);
             size_t const pixelStride = 4 * bytesPerComponent;
 
@@ -1570,6 +1746,8 @@ public:
 
             nvrhi::TextureDesc const& textureDesc = decompressedTexture->getDesc();
             int const effectiveMips = std::min(m_textureSetDesc.mips, int(textureDesc.mipLevels));
+            int const firstMip = (previewMip >= 0) ? std::min(previewMip, effectiveMips - 1) : 0;
+            int const lastMip = (previewMip >= 0) ? firstMip : effectiveMips - 1;
             
             ntc::ColorSpace const rgbColorSpace = image.isSRGB ? ntc::ColorSpace::sRGB : ntc::ColorSpace::Linear;
             ntc::ColorSpace const alphaColorSpace = ntc::ColorSpace::Linear;
@@ -1577,7 +1755,7 @@ public:
 
             if (useSharedTextures && decompressedTextureSharedRef)
             {
-                for (int mip = 0; mip < effectiveMips; ++mip)
+                for (int mip = firstMip; mip <= lastMip; ++mip)
                 {
                     ntc::ReadChannelsIntoTextureParameters params;
                     params.page = ntc::TextureDataPage::Output;
@@ -1602,7 +1780,7 @@ public:
 
                 m_uploadCommandList->open();
 
-                for (int mip = 0; mip < effectiveMips; ++mip)
+                for (int mip = firstMip; mip <= lastMip; ++mip)
                 {
                     int const mipWidth = std::max(int(textureDesc.width) >> mip, 1);
                     int const mipHeight = std::max(int(textureDesc.height) >> mip, 1);
@@ -1782,11 +1960,146 @@ public:
             m_leftImageName = textureName;
     }
 
-    bool RestoreCompressedTextureSet(const CompressionResult& result, bool useRightTextures)
+    static bool PreviewTextureMatches(nvrhi::ITexture* cached, nvrhi::ITexture* decompressed)
+    {
+        nvrhi::TextureDesc const& cachedDesc = cached->getDesc();
+        nvrhi::TextureDesc const& decompressedDesc = decompressed->getDesc();
+        return cachedDesc.width == decompressedDesc.width &&
+            cachedDesc.height == decompressedDesc.height &&
+            cachedDesc.mipLevels == decompressedDesc.mipLevels &&
+            cachedDesc.format == decompressedDesc.format;
+    }
+
+    // Copies the decompressed textures for a compression result into the preview cache, so that the result
+    // can be shown again without decompressing it. Must be called from the thread that owns m_uploadCommandList.
+    void StorePreview(int ordinal, bool useRightTextures, bool gapiDecompression, bool int8Decompression)
+    {
+        if (g_options.previewCacheSize <= 0 || m_images.empty())
+            return;
+
+        std::lock_guard guard(m_previewCacheMutex);
+
+        // Take the entry for the same result, or reuse the least recently used one when the cache is full
+        auto entry = std::find_if(m_previewCache.begin(), m_previewCache.end(),
+            [ordinal](PreviewCacheEntry const& e) { return e.ordinal == ordinal; });
+        if (entry == m_previewCache.end() && m_previewCache.size() >= size_t(g_options.previewCacheSize))
+            entry = std::prev(m_previewCache.end());
+        if (entry == m_previewCache.end())
+            entry = m_previewCache.emplace(m_previewCache.begin());
+        else
+            m_previewCache.splice(m_previewCache.begin(), m_previewCache, entry);
+
+        entry->ordinal = ordinal;
+        entry->gapiDecompression = gapiDecompression;
+        entry->int8Decompression = int8Decompression;
+        entry->textures.resize(m_images.size());
+
+        m_uploadCommandList->open();
+        for (size_t index = 0; index < m_images.size(); ++index)
+        {
+            MaterialImage const& image = m_images[index];
+            nvrhi::TextureHandle const& decompressedTexture = useRightTextures
+                ? image.decompressedTextureRight
+                : image.decompressedTextureLeft;
+            nvrhi::TextureHandle& cachedTexture = entry->textures[index];
+
+            if (!cachedTexture || !PreviewTextureMatches(cachedTexture, decompressedTexture))
+            {
+                nvrhi::TextureDesc desc = decompressedTexture->getDesc();
+                desc.debugName = image.name + " (Preview)";
+                desc.sharedResourceFlags = nvrhi::SharedResourceFlags::None;
+                desc.isRenderTarget = false;
+                desc.isUAV = false;
+                desc.initialState = nvrhi::ResourceStates::CopyDest;
+                desc.keepInitialState = true;
+                cachedTexture = GetDevice()->createTexture(desc);
+            }
+
+            for (uint32_t mip = 0; mip < cachedTexture->getDesc().mipLevels; ++mip)
+            {
+                nvrhi::TextureSlice const slice = nvrhi::TextureSlice().setMipLevel(mip);
+                m_uploadCommandList->copyTexture(cachedTexture, slice, decompressedTexture, slice);
+            }
+        }
+        m_uploadCommandList->close();
+        GetDevice()->executeCommandList(m_uploadCommandList);
+    }
+
+    // Copies the cached textures for a compression result into the decompressed textures.
+    // Returns false if the result is not in the preview cache.
+    bool RestorePreview(int ordinal, bool useRightTextures)
     {
+        if (m_useGapiDecompressionRect || m_gapiDecompressionMip >= 0)
+            return false;
+
+        std::lock_guard guard(m_previewCacheMutex);
+
+        auto entry = std::find_if(m_previewCache.begin(), m_previewCache.end(),
+            [this, ordinal](PreviewCacheEntry const& e)
+            {
+                return e.ordinal == ordinal && e.gapiDecompression == m_useGapiDecompression &&
+                    e.int8Decompression == (m_useInt8Decompression && !m_useGapiDecompression);
+            });
+        if (entry == m_previewCache.end() || entry->textures.size() != m_images.size())
+            return false;
+
+        for (size_t index = 0; index < m_images.size(); ++index)
+        {
+            nvrhi::TextureHandle const& decompressedTexture = useRightTextures
+                ? m_images[index].decompressedTextureRight
+                : m_images[index].decompressedTextureLeft;
+            if (!PreviewTextureMatches(entry->textures[index], decompressedTexture))
+                return false;
+        }
+
+        m_previewCache.splice(m_previewCache.begin(), m_previewCache, entry);
+
+        m_uploadCommandList->open();
+        for (size_t index = 0; index < m_images.size(); ++index)
+        {
+            nvrhi::TextureHandle const& decompressedTexture = useRightTextures
+                ? m_images[index].decompressedTextureRight
+                : m_images[index].decompressedTextureLeft;
+            nvrhi::ITexture* cachedTexture = entry->textures[index];
+            for (uint32_t mip = 0; mip < cachedTexture->getDesc().mipLevels; ++mip)
+            {
+                nvrhi::TextureSlice const slice = nvrhi::TextureSlice().setMipLevel(mip);
+                m_uploadCommandList->copyTexture(decompressedTexture, slice, cachedTexture, slice);
+            }
+        }
+        m_uploadCommandList->close();
+        GetDevice()->executeCommandList(m_uploadCommandList);
+
+        return true;
+    }
+
+    void ClearPreviewCache()
+    {
+        std::lock_guard guard(m_previewCacheMutex);
+        m_previewCache.clear();
+    }
+
+    // When allowPreviewCache is true, the result may be restored from the preview cache, which only updates
+    // the decompressed textures and keeps the current texture set - use that for viewing only.
+    bool RestoreCompressedTextureSet(const CompressionResult& result, bool useRightTextures, bool allowPreviewCache = false)
+    {
+        if (allowPreviewCache && RestorePreview(result.ordinal, useRightTextures))
+        {
+            SetRestoredRunName(result, useRightTextures);
+            return true;
+        }
+
+        std::shared_ptr<std::vector<uint8_t>> compressedData = m_resultStore.Get(result.ordinal);
+        if (!compressedData)
+            return false;
+
+        bool const gapiDecompression = m_useGapiDecompression;
+        bool const int8Decompression = m_useInt8Decompression && !gapiDecompression;
+        bool const storePreview = !(gapiDecompression && (m_useGapiDecompressionRect || m_gapiDecompressionMip >= 0));
+
         ntc::MemoryStreamWrapper inputStream(m_ntcContext);
-        ntc::Status ntcStatus = m_ntcContext->OpenReadOnlyMemory(result.compressedData->data(),
-            result.compressedData->size(), inputStream.ptr());
+        ntc::Status ntcStatus = m_ntcContext->OpenReadOnlyMemory(compressedData->data(),
+            compressedData->size(), inputStream.ptr());
         CHECK_NTC_RESULT(OpenReadOnlyMemory);
 
         auto reportError = [this, &result, &ntcStatus]()
@@ -1797,7 +2110,7 @@ public:
 
         if (m_useGapiDecompression)
         {
-            ntcStatus = DecompressWithGapi(inputStream, result.compressedData->size(), useRightTextures);
+            ntcStatus = DecompressWithGapi(inputStream, compressedData->size(), useRightTextures);
 
             if (ntcStatus != ntc::Status::Ok)
             {
@@ -1805,6 +2118,8 @@ public:
                 return false;
             }
 
+            if (storePreview)
+                StorePreview(result.ordinal, useRightTextures, gapiDecompression, int8Decompression);
             SetRestoredRunName(result, useRightTextures);
 
             return true;
@@ -1858,12 +2173,13 @@ public:
         if (!DecompressIntoTextures(false, useRightTextures, true, steady_clock::now()))
             return false;
 
+        StorePreview(result.ordinal, useRightTextures, gapiDecompression, int8Decompression);
         SetRestoredRunName(result, useRightTextures);
 
         return true;
     }
 
-    bool CompressionThreadProc()
+    bool CompressionThreadProc(ntc::LatentShape const& latentShape)
     {
         ntc::Status ntcStatus;
 
@@ -1883,7 +2199,7 @@ public:
         m_textureSet->SetMaskChannelIndex(m_alphaMaskChannelIndex, m_discardMaskedOutPixels);
         m_textureSet->SetExperimentalKnob(m_experimentalKnob);
 
-        ntcStatus = m_textureSet->SetLatentShape(m_latentShape);
+        ntcStatus = m_textureSet->SetLatentShape(latentShape);
         CHECK_NTC_RESULT(SetLatentShape);
         
         // Apply the per-image loss function scales to the appropriate channels
@@ -1903,6 +2219,7 @@ public:
 
         ntc::CompressionStats stats;
         char textureName[32];
+        time_point<steady_clock> lastPreviewTime;
 
         do
         {
@@ -1910,9 +2227,16 @@ public:
             CHECK_CANCEL(true);
             if (ntcStatus == ntc::Status::Incomplete || ntcStatus == ntc::Status::Ok)
             {
-                if (m_showCompressionProgress && ntcStatus == ntc::Status::Incomplete)
+                // The previews are limited by time rather than by steps, so that they don't slow down
+                // the compression of small texture sets, where the steps are fast
+                time_point const now = steady_clock::now();
+                bool const previewDue = duration_cast<duration<float>>(now - lastPreviewTime).count()
+                    >= m_compressionPreviewInterval.load();
+
+                if (m_showCompressionProgress && previewDue && ntcStatus == ntc::Status::Incomplete)
                 {
-                    if (!DecompressIntoTextures(false, true, false, beginTime))
+                    lastPreviewTime = now;
+                    if (!DecompressIntoTextures(false, true, false, beginTime, /* previewOnly = */ true))
                     {
                         // If the user clicks Cancel while decompression is running, DecompressIntoTextures(...)
                         // doesn't call AbortCompression() - do that here to avoid leaving the texture set
@@ -1944,7 +2268,10 @@ public:
         bool success = DecompressIntoTextures(true, true, false, beginTime);
         if (success)
         {
-            snprintf(textureName, sizeof textureName, "Run #%d", m_compressionResults[m_compressionResults.size() - 1].ordinal);
+            int const ordinal = m_compressionResults[m_compressionResults.size() - 1].ordinal;
+            StorePreview(ordinal, /* useRightTextures = */ true, /* gapiDecompression = */ false, /* int8Decompression = */ false);
+
+            snprintf(textureName, sizeof textureName, "Run #%d", ordinal);
 
             std::lock_guard guard(m_mutex);
             m_rightImageName = textureName;
@@ -1957,11 +2284,13 @@ public:
 #undef CHECK_NTC_RESULT
 #undef CHECK_CANCEL
 
-    void BeginCompression()
+    // Runs compression with each of the provided latent shapes, one after another, on the thread pool.
+    // When isSweep is true, the results are grouped into a new sweep for the PSNR vs. BPP plot.
+    void BeginCompression(std::vector<ntc::LatentShape> const& latentShapes, bool isSweep)
     {
         assert(m_ntcContext);
 
-        if (!m_cudaAvailable)
+        if (!m_cudaAvailable || latentShapes.empty())
             return;
         
         if (m_textureSet && m_textureSet->GetDesc() != m_textureSetDesc)
@@ -1985,8 +2314,19 @@ public:
                 }
         }
 
-        m_threadPool.AddTask([this](){
-            CompressionThreadProc();
+        m_activeSweep = isSweep ? ++m_sweepCounter : 0;
+        m_sweepRunsDone = 0;
+        m_sweepRunsTotal = int(latentShapes.size());
+
+        m_threadPool.AddTask([this, latentShapes](){
+            for (ntc::LatentShape const& latentShape : latentShapes)
+            {
+                m_compressionStats = ntc::CompressionStats();
+                if (!CompressionThreadProc(latentShape) || m_cancel)
+                    break;
+                ++m_sweepRunsDone;
+            }
+            m_activeSweep = 0;
             m_compressing = false;
             m_cancel = false;
         });
@@ -2126,6 +2466,8 @@ public:
                     ++imageIndex;
                 }
 
+                m_previewTarget = PreviewTarget();
+
                 m_modelView->SetNumTextureMips(m_textureSetDesc.mips);
 
                 m_modelView->SetSemanticBindings(m_semanticBindings.data(), m_semanticBindings.size());
@@ -2138,6 +2480,8 @@ public:
             }
             else
             {
+                m_previewTarget = PreviewTarget { m_selectedImage, m_flatImageView->GetMipLevel() };
+
                 const MaterialImage& selectedImage = m_images[m_selectedImage];
                 m_flatImageView->SetTextures(
                     m_useLeftDecompressedImage ? selectedImage.decompressedTextureLeft : selectedImage.referenceTexture ? selectedImage.referenceTexture : selectedImage.decompressedTextureRight,
@@ -2149,17 +2493,293 @@ public:
                 m_flatImageView->Render(m_commandList, framebuffer);
                 m_commandList->endMarker();
             }
+
+            if (m_measureBlockCompression)
+                RecordBlockCompressionPasses(m_commandList);
         }
 
         m_commandList->close();
         GetDevice()->executeCommandList(m_commandList);
 
+        m_gapiDecompressionTimer.update();
+        for (AveragingTimerQuery& timer : m_blockCompressionTimers)
+            timer.update();
+
         ImGui_Renderer::Render(framebuffer);
 
         if (!m_loading && m_selectedImage >= 0)
             m_flatImageView->ReadPixel();
     }
 
+    // Returns the textures that are shown in the right image slot, or the left slot if the right one has the reference.
+    nvrhi::ITexture* GetMeasuredTexture(MaterialImage const& image) const
+    {
+        if (m_useRightDecompressedImage)
+            return image.decompressedTextureRight;
+        if (m_useLeftDecompressedImage)
+            return image.decompressedTextureLeft;
+        return image.referenceTexture;
+    }
+
+    // Encodes the displayed version of every image that has a BCn format, with all mip levels, into a scratch texture.
+    // This is only done to measure the GPU time of BCn encoding, the outputs are not used.
+    void RecordBlockCompressionPasses(nvrhi::ICommandList* commandList)
+    {
+        if (!m_blockCompressionPassInitialized)
+        {
+            if (!m_blockCompressionPass.Init())
+            {
+                log::warning("Failed to initialize the block compression pass, BCn timing is disabled.");
+                m_measureBlockCompression = false;
+                return;
+            }
+            m_blockCompressionPassInitialized = true;
+        }
+
+        while (m_blockCompressionTimers.size() < m_images.size())
+            m_blockCompressionTimers.emplace_back(GetDevice());
+        m_blockCompressionOutputs.resize(m_images.size());
+
+        commandList->beginMarker("BCn Timing");
+        for (size_t index = 0; index < m_images.size(); ++index)
+        {
+            MaterialImage const& image = m_images[index];
+            nvrhi::ITexture* inputTexture = GetMeasuredTexture(image);
+            if (image.bcFormat == ntc::BlockCompressedFormat::None || !inputTexture)
+                continue;
+
+            nvrhi::TextureDesc const& inputDesc = inputTexture->getDesc();
+            uint32_t const widthBlocks = (inputDesc.width + 3) / 4;
+            uint32_t const heightBlocks = (inputDesc.height + 3) / 4;
+            bool const smallBlocks = image.bcFormat == ntc::BlockCompressedFormat::BC1 ||
+                image.bcFormat == ntc::BlockCompressedFormat::BC4;
+
+            nvrhi::TextureHandle& outputTexture = m_blockCompressionOutputs[index];
+            if (!outputTexture || outputTexture->getDesc().width != widthBlocks || outputTexture->getDesc().height != heightBlocks)
+            {
+                auto outputDesc = nvrhi::TextureDesc()
+                    .setDebugName(image.name + " (BCn Timing)")
+                    .setFormat(smallBlocks ? nvrhi::Format::RG32_UINT : nvrhi::Format::RGBA32_UINT)
+                    .setDimension(nvrhi::TextureDimension::Texture2D)
+                    .setWidth(widthBlocks)
+                    .setHeight(heightBlocks)
+                    .setIsUAV(true)
+                    .setInitialState(nvrhi::ResourceStates::UnorderedAccess)
+                    .setKeepInitialState(true);
+                outputTexture = GetDevice()->createTexture(outputDesc);
+            }
+
+            // All mips are encoded into the top-left corner of the same output, so they're serialized by UAV barriers
+            m_blockCompressionTimers[index].beginQuery(commandList);
+            for (uint32_t mipLevel = 0; mipLevel < inputDesc.mipLevels; ++mipLevel)
+            {
+                ntc::MakeBlockCompressionComputePassParameters params;
+                params.srcRect.width = int(std::max(inputDesc.width >> mipLevel, 1u));
+                params.srcRect.height = int(std::max(inputDesc.height >> mipLevel, 1u));
+                params.dstFormat = image.bcFormat;
+                params.alphaThreshold = 1.f / 255.f;
+
+                ntc::ComputePassDesc computePass{};
+                ntc::Status ntcStatus = m_ntcContext->MakeBlockCompressionComputePass(params, &computePass);
+                if (ntcStatus != ntc::Status::Ok)
+                {
+                    log::warning("Call to MakeBlockCompressionComputePass failed, code = %s: %s",
+                        ntc::StatusToString(ntcStatus), ntc::GetLastErrorMessage());
+                    m_measureBlockCompression = false;
+                    break;
+                }
+
+                if (!m_blockCompressionPass.ExecuteComputePass(commandList, computePass, inputTexture,
+                    nvrhi::Format::UNKNOWN, int(mipLevel), nullptr, outputTexture, 0))
+                {
+                    m_measureBlockCompression = false;
+                    break;
+                }
+            }
+            m_blockCompressionTimers[index].endQuery(commandList);
+
+            if (!m_measureBlockCompression)
+                break;
+        }
+        commandList->endMarker();
+    }
+
+    static void RuntimeCostText(std::optional<float> seconds, float pixels)
+    {
+        if (seconds.has_value() && *seconds > 0.f)
+            ImGui::Text("%.3f ms, %.1f Mpix/s", *seconds * 1e3f, pixels * 1e-6f / *seconds);
+        else
+            ImGui::TextUnformatted("-");
+    }
+
+    void BuildRuntimeCostWindow()
+    {
+        if (!m_showRuntimeCost)
+            return;
+
+        if (!ImGui::Begin("Runtime Cost", &m_showRuntimeCost, ImGuiWindowFlags_AlwaysAutoResize))
+        {
+            ImGui::End();
+            return;
+        }
+
+        ImGui::TextUnformatted("Texture set decompression (GPU time):");
+        ImGui::TooltipMarker("Decompression produces all textures of the set at once, so its cost is reported "
+            "for the whole set.\nMpix/s counts the texture set pixels in all decompressed mip levels.\n"
+            "Graphics decompression is measured when a result is restored with 'Restore with GAPI Decompression' "
+            "enabled in the Developer UI.");
+        ImGui::Indent();
+        ImGui::TextUnformatted("Graphics API:");
+        ImGui::SameLine();
+        std::optional<float> gapiTime = m_gapiDecompressionTimer.getAverageTime();
+        if (!gapiTime.has_value())
+            gapiTime = m_gapiDecompressionTimer.getLatestAvailableTime();
+        RuntimeCostText(gapiTime, m_gapiDecompressionPixels);
+        ImGui::TextUnformatted("CUDA:");
+        ImGui::SameLine();
+        RuntimeCostText(m_cudaDecompressionPixels > 0.f
+            ? std::optional<float>(m_cudaDecompressionTimeMs * 1e-3f)
+            : std::optional<float>(), m_cudaDecompressionPixels);
+        ImGui::Unindent();
+
+        ImGui::Separator();
+        ImGui::Checkbox("Measure BCn encoding", &m_measureBlockCompression);
+        ImGui::TooltipMarker("Encodes the textures shown in the image slots into their BCn formats on every frame, "
+            "with all mip levels,\nand reports the average GPU time per texture. This slows down the UI.");
+
+        if (ImGui::BeginTable("BCnCost", 3, ImGuiTableFlags_SizingFixedFit))
+        {
+            ImGui::TableSetupColumn("Texture");
+            ImGui::TableSetupColumn("Format");
+            ImGui::TableSetupColumn("BCn encoding");
+            ImGui::TableHeadersRow();
+
+            for (size_t index = 0; index < m_images.size(); ++index)
+            {
+                MaterialImage const& image = m_images[index];
+                if (image.bcFormat == ntc::BlockCompressedFormat::None)
+                    continue;
+
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(image.name.c_str());
+                ImGui::TableSetColumnIndex(1);
+                ImGui::TextUnformatted(ntc::BlockCompressedFormatToString(image.bcFormat));
+                ImGui::TableSetColumnIndex(2);
+
+                nvrhi::ITexture* texture = GetMeasuredTexture(image);
+                if (m_measureBlockCompression && texture && index < m_blockCompressionTimers.size())
+                {
+                    nvrhi::TextureDesc const& desc = texture->getDesc();
+                    RuntimeCostText(m_blockCompressionTimers[index].getAverageTime(),
+                        float(GetMipChainPixels(int(desc.width), int(desc.height), int(desc.mipLevels))));
+                }
+                else
+                    ImGui::TextUnformatted("-");
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::End();
+    }
+
+    void BuildSweepControls()
+    {
+        ImGui::Separator();
+        ImGui::TextUnformatted("Parameter Sweep:");
+        ImGui::TooltipMarker("Compresses the texture set at each of the selected bitrates, one after another, "
+            "using the current compression settings.\nThe results are added to the list below and to the PSNR vs. BPP plot.");
+
+        ImGui::BeginDisabled(m_compressing);
+        for (int preset = 0; preset < g_numSweepPresets; ++preset)
+        {
+            char label[16];
+            snprintf(label, sizeof label, "%.2f##sweep", g_sweepBitsPerPixel[preset]);
+            if (preset % 3 != 0)
+                ImGui::SameLine();
+            ImGui::Checkbox(label, &m_sweepPresetEnabled[preset]);
+        }
+
+        // Several presets can map to the same latent shape, don't compress those twice
+        std::vector<ntc::LatentShape> latentShapes;
+        for (int preset = 0; preset < g_numSweepPresets; ++preset)
+        {
+            if (!m_sweepPresetEnabled[preset])
+                continue;
+
+            ntc::LatentShape latentShape;
+            float selectedBpp = 0.f;
+            if (ntc::PickLatentShape(g_sweepBitsPerPixel[preset], selectedBpp, latentShape) != ntc::Status::Ok)
+                continue;
+
+            bool const duplicate = std::any_of(latentShapes.begin(), latentShapes.end(),
+                [&latentShape](ntc::LatentShape const& other)
+                {
+                    return other.gridSizeScale == latentShape.gridSizeScale &&
+                        other.numFeatures == latentShape.numFeatures;
+                });
+            if (!duplicate)
+                latentShapes.push_back(latentShape);
+        }
+
+        ImGui::BeginDisabled(latentShapes.empty());
+        char buttonLabel[32];
+        snprintf(buttonLabel, sizeof buttonLabel, "Run Sweep (%d runs)", int(latentShapes.size()));
+        if (ImGui::Button(buttonLabel))
+            BeginCompression(latentShapes, /* isSweep = */ true);
+        ImGui::EndDisabled();
+        ImGui::EndDisabled();
+    }
+
+    // Plots the PSNR of all compression results against their bitrate: one line per sweep,
+    // and the individual runs as scatter points. Must be called with m_mutex locked.
+    void BuildResultsPlot()
+    {
+        if (m_compressionResults.size() < 2)
+            return;
+
+        float const fontSize = ImGui::GetFontSize();
+        if (!ImPlot::BeginPlot("PSNR vs. BPP", ImVec2(20.f * fontSize, 12.f * fontSize)))
+            return;
+
+        ImPlot::SetupAxes("Bits per pixel", "PSNR (dB)", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+
+        std::map<int, std::vector<CompressionResult const*>> resultsBySweep;
+        for (CompressionResult const& result : m_compressionResults)
+            resultsBySweep[result.sweepIndex].push_back(&result);
+
+        std::vector<float> bitsPerPixel;
+        std::vector<float> psnr;
+        for (auto& [sweepIndex, results] : resultsBySweep)
+        {
+            std::sort(results.begin(), results.end(), [](CompressionResult const* a, CompressionResult const* b)
+                { return a->bitsPerPixel < b->bitsPerPixel; });
+
+            bitsPerPixel.clear();
+            psnr.clear();
+            for (CompressionResult const* result : results)
+            {
+                bitsPerPixel.push_back(result->bitsPerPixel);
+                psnr.push_back(result->overallPSNR);
+            }
+
+            if (sweepIndex == 0)
+            {
+                ImPlot::PlotScatter("Single runs", bitsPerPixel.data(), psnr.data(), int(results.size()));
+            }
+            else
+            {
+                char label[32];
+                snprintf(label, sizeof label, "Sweep #%d", sweepIndex);
+                ImPlot::SetNextMarkerStyle(ImPlotMarker_Circle);
+                ImPlot::PlotLine(label, bitsPerPixel.data(), psnr.data(), int(results.size()));
+            }
+        }
+
+        ImPlot::EndPlot();
+    }
+
     void BuildSettingsDialog(float fontSize, bool& openImageSettings)
     {
         ImGui::SetNextWindowPos(ImVec2(fontSize * 0.6f, fontSize * 2.f), 0);
@@ -2415,6 +3035,8 @@ public:
                     {
                         ImGui::DragInt4("Decompression rect", &m_gapiDecompressionRect.left, 1.f, 0, std::max(m_textureSetDesc.width, m_textureSetDesc.height));
                     }
+                    ImGui::SliderInt("Decompression mip", &m_gapiDecompressionMip, -1, std::max(m_textureSetDesc.mips - 1, 0));
+                    ImGui::TooltipMarker("Restore only this mip level with GAPI decompression, -1 means all mip levels.");
                     ImGui::DragFloat("Experimental Knob", &m_experimentalKnob, 0.01f);
                 }
 
@@ -2422,10 +3044,17 @@ public:
                 if (!m_compressing)
                 {
                     if (ImGui::Button("Compress!"))
-                        BeginCompression();
+                        BeginCompression({ m_latentShape }, /* isSweep = */ false);
                 }
                 else
                 {
+                    int const activeSweep = m_activeSweep;
+                    if (activeSweep != 0)
+                    {
+                        ImGui::Text("Sweep #%d: run %d / %d", activeSweep, m_sweepRunsDone.load() + 1,
+                            m_sweepRunsTotal.load());
+                    }
+
                     char buf[32];
                     float progress = float(m_compressionStats.currentStep) / float(m_compressionSettings.trainingSteps);
                     snprintf(buf, sizeof buf, "%d / %d", m_compressionStats.currentStep, m_compressionSettings.trainingSteps);
@@ -2439,6 +3068,8 @@ public:
                     ImGui::Text("Compression performance: %.2f ms/step", m_compressionStats.millisecondsPerStep);
                 }
 
+                BuildSweepControls();
+
                 if (!m_sharedTexturesAvailable)
                 {
                     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.f, 1.f, 0.f, 1.f));
@@ -2503,6 +3134,8 @@ public:
                 if (ImGui::Button("Clear Results"))
                 {
                     m_compressionResults.clear();
+                    m_resultStore.Clear();
+                    ClearPreviewCache();
                     RestoreReferenceTextureView(false);
                 }
                 ImGui::SameLine();
@@ -2519,6 +3152,8 @@ public:
                 }
                 ImGui::TooltipMarker("Drag the Restore Reference button onto either of the channel slots " 
                     "in the bottom dialog to put the reference images into that channel.");
+
+                BuildResultsPlot();
             }
             
             ImGui::PopItemWidth();
@@ -2644,7 +3279,15 @@ public:
             if (ImGui::BeginMenu("Options"))
             {
                 ImGui::MenuItem("Show Compression Progress", nullptr, &m_showCompressionProgress);
+                if (m_showCompressionProgress)
+                {
+                    // The interval is read by the compression thread, so edit a copy and store it atomically
+                    float previewInterval = m_compressionPreviewInterval;
+                    if (ImGui::SliderFloat("Progress Interval", &previewInterval, 0.f, 5.f, "%.1f s"))
+                        m_compressionPreviewInterval = previewInterval;
+                }
                 ImGui::MenuItem("Developer UI", nullptr, &m_developerUI);
+                ImGui::MenuItem("Runtime Cost", nullptr, &m_showRuntimeCost);
                 ImGui::EndMenu();
             }
 
@@ -2734,6 +3377,7 @@ public:
         if (!m_compareMode)
         {
             BuildSettingsDialog(fontSize, openImageSettings);
+            BuildRuntimeCostWindow();
         }
 
         if (openImageSettings)
@@ -2814,7 +3458,7 @@ public:
                 {
                     if (result.ordinal == restoreRunOrdinal)
                     {
-                        RestoreCompressedTextureSet(result, restoreRightTexture);
+                        RestoreCompressedTextureSet(result, restoreRightTexture, /* allowPreviewCache = */ true);
                         break;
                     }
                 }
@@ -2845,7 +3489,7 @@ public:
             ImGui::Separator();
 
             setupRow("Bits per pixel");             ImGui::Text("%.2f", m_selectedCompressionResult.bitsPerPixel);
-            setupRow("Stored texture size");        ImGui::Text("%.2f MB", float(m_selectedCompressionResult.compressedData->size()) / 1'048'576.f);
+            setupRow("Stored texture size");        ImGui::Text("%.2f MB", float(m_selectedCompressionResult.compressedSize) / 1'048'576.f);
             setupRow("Compress MIP chain");         ImGui::Text("%s", m_selectedCompressionResult.compressMipChain ? "YES" : "NO");
             setupRow("GDeflate");                   ImGui::Text("%s", m_selectedCompressionResult.useGDeflate.has_value() 
                                                                         ? (m_selectedCompressionResult.useGDeflate.value() ? "YES" : "NO")